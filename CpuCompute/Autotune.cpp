@@ -0,0 +1,171 @@
+﻿#include "Autotune.h"
+#include<algorithm>
+#include<cassert>
+#include<cstdio>
+#include<cstdlib>
+#include<fstream>
+#include<sstream>
+#include"Benchmarks.h"
+
+using namespace std;
+
+namespace {
+	//warmup回空回ししてからrepeat回測る
+	TuneMeasurement Measure(const TuneConfig& config, const function<void(const TuneConfig&)>& run, int warmup, int repeat) {
+		for (int i = 0; i < warmup; ++i) {
+			run(config);
+		}
+		vector<double> times(max(repeat, 1));
+		for (auto& t : times) {
+			Stopwatch sw;
+			run(config);
+			t = sw.ElapsedMilliseconds();
+		}
+		sort(times.begin(), times.end());
+		TuneMeasurement m;
+		m.config = config;
+		m.medianMs = times[times.size() / 2];
+		m.minMs = times.front();
+		auto iqr = times[times.size() * 3 / 4] - times[times.size() / 4];
+		m.spread = m.medianMs > 0.0 ? iqr / m.medianMs : 0.0;
+		return m;
+	}
+
+	//文字列全体が数値のときだけtrue
+	bool ParseUInt(const string& s, unsigned int& value) {
+		char* end = nullptr;
+		auto v = strtoul(s.c_str(), &end, 10);
+		value = static_cast<unsigned int>(v);
+		return !s.empty() && *end == '\0';
+	}
+	bool ParseDouble(const string& s, double& value) {
+		char* end = nullptr;
+		value = strtod(s.c_str(), &end);
+		return !s.empty() && *end == '\0';
+	}
+
+	bool ByMedian(const TuneMeasurement& a, const TuneMeasurement& b) {
+		return a.medianMs < b.medianMs;
+	}
+
+	constexpr const char* defaultTuneFile = "cpucompute_tune.txt";
+}
+
+TuneMeasurement
+Autotune(const vector<TuneConfig>& candidates, const function<void(const TuneConfig&)>& run,
+	int warmup, int repeat, vector<TuneMeasurement>* results) {
+	assert(!candidates.empty());
+	vector<TuneMeasurement> measured;
+	measured.reserve(candidates.size());
+	for (auto& c : candidates) {
+		measured.push_back(Measure(c, run, warmup, repeat));
+	}
+	//上位は差が小さいことが多いので、測り直してから決める
+	sort(measured.begin(), measured.end(), ByMedian);
+	constexpr size_t finalistNum = 3;
+	for (size_t i = 0; i < min(finalistNum, measured.size()); ++i) {
+		measured[i] = Measure(measured[i].config, run, warmup, repeat * 2);
+	}
+	sort(measured.begin(), measured.end(), ByMedian);
+	if (results != nullptr) {
+		*results = measured;
+	}
+	return measured.front();
+}
+
+TuneTable::TuneTable() {
+	path_ = GetEnvironmentString("CPUCOMPUTE_TUNE_FILE");
+	if (path_.empty()) {
+		path_ = defaultTuneFile;
+	}
+	//まだ調整していなければファイルはないので、読めなくても何もしない
+	Load(path_);
+}
+
+TuneTable&
+TuneTable::Instance() {
+	static TuneTable instance;
+	return instance;
+}
+
+const string&
+TuneTable::Path()const {
+	return path_;
+}
+
+bool
+TuneTable::Load(const string& path) {
+	ifstream ifs(path);
+	if (!ifs) {
+		return false;
+	}
+	string line;
+	int lineNo = 0;
+	while (getline(ifs, line)) {
+		++lineNo;
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		//CPUの名前には空白が入るのでタブで区切る
+		vector<string> fields;
+		stringstream ss(line);
+		string field;
+		while (getline(ss, field, '\t')) {
+			fields.push_back(field);
+		}
+		Entry entry;
+		unsigned int width = 0, height = 0;
+		bool ok = fields.size() == 9
+			&& ParseUInt(fields[1], width) && ParseUInt(fields[2], height)
+			&& ParseCpuIsa(fields[3], entry.config.isa)
+			&& ParseUInt(fields[4], entry.config.groupSize.x) && ParseUInt(fields[5], entry.config.groupSize.y)
+			&& ParseUInt(fields[6], entry.config.groupsPerTask)
+			&& ParseDouble(fields[7], entry.ms);
+		if (ok && entry.config.groupSize.x > 0 && entry.config.groupSize.y > 0 && entry.config.groupsPerTask > 0) {
+			entries_[Key(fields[0], width, height, fields[8])] = entry;
+		}
+		else {
+			fprintf(stderr, "%s(%d): invalid tune entry\n", path.c_str(), lineNo);
+		}
+	}
+	return true;
+}
+
+bool
+TuneTable::Save(const string& path)const {
+	ofstream ofs(path);
+	if (!ofs) {
+		return false;
+	}
+	ofs << "#kernel\twidth\theight\tisa\tgroupW\tgroupH\tgroupsPerTask\tms\tcpu\n";
+	for (auto& e : entries_) {
+		auto& c = e.second.config;
+		ofs << get<0>(e.first) << '\t' << get<1>(e.first) << '\t' << get<2>(e.first) << '\t'
+			<< CpuIsaName(c.isa) << '\t' << c.groupSize.x << '\t' << c.groupSize.y << '\t' << c.groupsPerTask << '\t'
+			<< e.second.ms << '\t' << get<3>(e.first) << '\n';
+	}
+	return static_cast<bool>(ofs);
+}
+
+bool
+TuneTable::Find(const string& kernel, unsigned int width, unsigned int height, TuneConfig& config)const {
+	auto it = entries_.find(Key(kernel, width, height, CpuModelName()));
+	if (it == entries_.end()) {
+		return false;
+	}
+	config = it->second.config;
+	return true;
+}
+
+void
+TuneTable::Store(const string& kernel, unsigned int width, unsigned int height, const TuneConfig& config, double ms) {
+	entries_[Key(kernel, width, height, CpuModelName())] = { config,ms };
+}
+
+void
+TuneTable::Clear() {
+	entries_.clear();
+}
@@ -0,0 +1,83 @@
+﻿#pragma once
+#include<string>
+#include<vector>
+#include<map>
+#include<tuple>
+#include<functional>
+#include"CpuFeatures.h"
+#include"HlslTypes.h"
+
+///CPUでカーネルを実行するときの設定
+///GPUの[numthreads]とDispatchに相当するものをCPU向けに選べるようにしたもの
+struct TuneConfig {
+	CpuIsa isa = CpuIsa::Scalar;//SIMD幅(命令セット)
+	hlsl::uint2 groupSize = { 1,1 };//1グループが受け持つ画素の範囲(幅,高さ)
+	unsigned int groupsPerTask = 1;//ワーカーが一度に取っていくグループ数(タイルの大きさ)
+};
+
+///設定1つぶんの計測結果
+struct TuneMeasurement {
+	TuneConfig config;
+	double medianMs = 0.0;//中央値
+	double minMs = 0.0;//最小値
+	double spread = 0.0;//四分位範囲/中央値(ばらつきの目安)
+};
+
+///候補の設定を全部計測して一番速いものを返す
+///全候補をwarmup回空回ししてからrepeat回測り、中央値の速い上位3つを
+///さらに倍の回数測り直して決める(1回の揺らぎで選ばないように)
+///@param candidates 候補の設定(空であってはならない)
+///@param run 設定を受け取って1回ぶんの処理をする関数
+///@param warmup 空回し回数
+///@param repeat 計測回数
+///@param results 全候補の計測結果(不要ならnullptr。測り直したものは測り直した結果になる)
+///@return 一番速かった設定とその計測結果
+TuneMeasurement Autotune(const std::vector<TuneConfig>& candidates, const std::function<void(const TuneConfig&)>& run,
+	int warmup, int repeat, std::vector<TuneMeasurement>* results = nullptr);
+
+///自動調整の結果表(カーネル名・解像度・CPUの名前ごとに1つの設定)
+///起動後の最初のInstance()で、環境変数CPUCOMPUTE_TUNE_FILE(なければcpucompute_tune.txt)を読み込む
+///ファイルは1行1件のタブ区切りテキストで、別のCPUで取った結果も残しておける
+///  kernel  width  height  isa  groupW  groupH  groupsPerTask  ms  cpu
+///@remarks Storeは計測時に呼ぶ想定なので、Findと並行して呼ばないこと
+class TuneTable
+{
+	using Key = std::tuple<std::string, unsigned int, unsigned int, std::string>;//kernel,width,height,cpu
+	struct Entry {
+		TuneConfig config;
+		double ms;
+	};
+	std::map<Key, Entry> entries_;
+	std::string path_;
+
+	TuneTable();
+	TuneTable(const TuneTable&) = delete;
+	void operator=(const TuneTable&) = delete;
+public:
+	static TuneTable& Instance();
+
+	///読み書きするファイルのパス
+	const std::string& Path()const;
+
+	///ファイルを読み込んで、今の表に追加(同じキーは上書き)する
+	///@retval false ファイルが読めなかった
+	///@remarks 読めない行は警告して読み飛ばす
+	bool Load(const std::string& path);
+
+	///表をファイルに書き出す
+	///@retval false ファイルが書けなかった
+	bool Save(const std::string& path)const;
+
+	///このCPUでの結果を探す
+	///@param kernel カーネル名
+	///@param width,height 解像度
+	///@param config 見つかった設定(戻り値用)
+	///@return 見つかればtrue
+	bool Find(const std::string& kernel, unsigned int width, unsigned int height, TuneConfig& config)const;
+
+	///このCPUでの結果を登録する(同じキーは上書き)
+	void Store(const std::string& kernel, unsigned int width, unsigned int height, const TuneConfig& config, double ms);
+
+	///全部消す
+	void Clear();
+};
@@ -0,0 +1,2612 @@
+﻿#include "Benchmarks.h"
+#include<cstdio>
+#include<cmath>
+#include<vector>
+#include<algorithm>
+#include<thread>
+#include<cstring>
+#include<numeric>
+#include"ComputeExecutor.h"
+#include"Wave.h"
+#include"MonoFilter.h"
+#include"KernelRegistry.h"
+#include"Autotune.h"
+#include"ComputeJob.h"
+#include"SoaBuffer.h"
+#include"Reduction.h"
+#include"Scan.h"
+#include"RadixSort.h"
+#include"GaussianBlur.h"
+#include"MedianFilter.h"
+#include"BoxFilter.h"
+#include"Resample.h"
+#include"ColorLut.h"
+#include"FilterGraphRunner.h"
+#include"Bloom.h"
+#include"ToneMap.h"
+#include"Outline.h"
+#include"JointUpsample.h"
+#include"IncrementalFilter.h"
+#include"ImageArray.h"
+#include"FirstStepKernel.h"
+
+using namespace std;
+
+double
+MeasureMedianMs(int warmup, int repeat, const function<void()>& func) {
+	for (int i = 0; i < warmup; ++i) {
+		func();
+	}
+	vector<double> times(max(repeat, 1));
+	for (auto& t : times) {
+		Stopwatch sw;
+		func();
+		t = sw.ElapsedMilliseconds();
+	}
+	sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+void
+BenchmarkDispatchScaling() {
+	//4096x4096スレッド、numthreads(8,8,1)
+	constexpr unsigned int width = 4096;
+	constexpr unsigned int height = 4096;
+	const hlsl::uint3 numThreads = { 8,8,1 };
+	vector<float> out(static_cast<size_t>(width) * height);
+
+	//メモリ律速にならないよう適度に計算をさせる
+	auto kernel = [&](const ComputeThreadId& id) {
+		auto x = static_cast<float>(id.dispatchThreadId.x) / width;
+		auto y = static_cast<float>(id.dispatchThreadId.y) / height;
+		float v = 0.0f;
+		for (int i = 0; i < 16; ++i) {
+			v = v * 0.5f + sinf(x * i + y);
+		}
+		out[static_cast<size_t>(id.dispatchThreadId.y) * width + id.dispatchThreadId.x] = v;
+	};
+
+	auto hwThreads = max(thread::hardware_concurrency(), 1u);
+	printf("Dispatch(%u,%u,1) numthreads(8,8,1)\n", width / numThreads.x, height / numThreads.y);
+	double baseMs = 0.0;
+	for (unsigned int t = 1; ; t *= 2) {
+		t = min(t, hwThreads);
+		ComputeExecutor executor(t);
+		auto ms = MeasureMedianMs(1, 5, [&]() {
+			executor.Dispatch(numThreads, width / numThreads.x, height / numThreads.y, 1, kernel);
+		});
+		if (t == 1) {
+			baseMs = ms;
+		}
+		printf("threads=%2u : %8.2f ms  speedup x%.2f\n", t, ms, baseMs / ms);
+		if (t == hwThreads) {
+			break;
+		}
+	}
+}
+
+void
+BenchmarkGroupShared() {
+	//横方向の9タップボックスブラー(4096x1024)
+	constexpr unsigned int width = 4096;
+	constexpr unsigned int height = 1024;
+	constexpr int radius = 4;
+	constexpr unsigned int groupSize = 64;
+	vector<float> src(static_cast<size_t>(width) * height);
+	vector<float> dstDirect(src.size()), dstShared(src.size());
+	for (size_t i = 0; i < src.size(); ++i) {
+		src[i] = static_cast<float>(i % 251) / 251.0f;
+	}
+	auto load = [&](int x, unsigned int y) {
+		x = min(max(x, 0), static_cast<int>(width) - 1);
+		return src[static_cast<size_t>(y) * width + x];
+	};
+	auto& executor = ComputeExecutor::Instance();
+	const hlsl::uint3 numThreads = { groupSize,1,1 };
+
+	//バリアなし:各スレッドが直接9回読む
+	auto directMs = MeasureMedianMs(1, 9, [&]() {
+		executor.Dispatch(numThreads, width / groupSize, height, 1, [&](const ComputeThreadId& id) {
+			auto& dtid = id.dispatchThreadId;
+			float sum = 0.0f;
+			for (int i = -radius; i <= radius; ++i) {
+				sum += load(static_cast<int>(dtid.x) + i, dtid.y);
+			}
+			dstDirect[static_cast<size_t>(dtid.y) * width + dtid.x] = sum / (radius * 2 + 1);
+		});
+	});
+
+	//groupsharedにタイル+のりしろを読み込んでからバリアを挟んで計算
+	struct Tile {
+		float v[groupSize + radius * 2];
+	};
+	auto sharedMs = MeasureMedianMs(1, 9, [&]() {
+		executor.DispatchGroupShared<Tile>(numThreads, width / groupSize, height, 1,
+			[&](const ComputeThreadId& id, Tile& tile, NoThreadLocal&) {
+				int baseX = static_cast<int>(id.groupId.x * groupSize) - radius;
+				tile.v[id.groupIndex] = load(baseX + static_cast<int>(id.groupIndex), id.dispatchThreadId.y);
+				if (id.groupIndex < radius * 2) {
+					tile.v[groupSize + id.groupIndex] = load(baseX + static_cast<int>(groupSize + id.groupIndex), id.dispatchThreadId.y);
+				}
+			},
+			//GroupMemoryBarrierWithGroupSync();
+			[&](const ComputeThreadId& id, Tile& tile, NoThreadLocal&) {
+				float sum = 0.0f;
+				for (int i = 0; i <= radius * 2; ++i) {
+					sum += tile.v[id.groupIndex + i];
+				}
+				dstShared[static_cast<size_t>(id.dispatchThreadId.y) * width + id.dispatchThreadId.x] = sum / (radius * 2 + 1);
+			});
+	});
+
+	bool same = dstDirect == dstShared;
+	printf("box blur r=%d %ux%u\n", radius, width, height);
+	printf("barrier-free : %8.2f ms\n", directMs);
+	printf("groupshared  : %8.2f ms (x%.2f of barrier-free) result %s\n", sharedMs, sharedMs / directMs, same ? "match" : "MISMATCH");
+}
+
+namespace {
+	struct WavePixel {
+		float r, g, b, a;
+	};
+	///輝度のウェーブカーネルの引数
+	struct LuminanceWaveArgs {
+		const WavePixel* src;
+		float* dst;
+		unsigned int width, height;
+		unsigned int* count;//輝度が0.5を超えた画素数
+	};
+	template<int W>
+	struct LuminanceWaveKernel {
+		const LuminanceWaveArgs& args;
+
+		WAVE_INLINE void operator()(const WaveThreadId<W>& id, const hlsl::LaneMask<W>& active)const {
+			using namespace hlsl;
+			auto& dtid = id.dispatchThreadId;
+			//if (dtid.x < width && dtid.y < height)
+			auto mask = active & (dtid.x < args.width) & (dtid.y < args.height);
+			if (mask.None()) {
+				return;
+			}
+			auto idx = dtid.y * args.width + dtid.x;
+			auto r = Gather(args.src, idx, &WavePixel::r, mask);
+			auto g = Gather(args.src, idx, &WavePixel::g, mask);
+			auto b = Gather(args.src, idx, &WavePixel::b, mask);
+			auto lum = saturate(r * 0.299f + g * 0.587f + b * 0.114f);
+			Scatter(args.dst, idx, lum, mask);
+			//しきい値を超えたレーンの数をウェーブでまとめて1回だけ加算
+			auto bright = mask & (lum > 0.5f);
+			InterlockedAdd(*args.count, Varying<unsigned int, W>(1u), bright);
+		}
+	};
+	template<int W>
+	WAVE_INLINE void LuminanceWaveGroups(const LuminanceWaveArgs& args, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, size_t begin, size_t end) {
+		LuminanceWaveKernel<W> kernel = { args };
+		RunWaveGroups<W>(numThreads, x, y, begin, end, kernel);
+	}
+
+	//ウェーブ幅はレジスタ1本の32bitレーン数(スカラーは1レーン)
+	void LuminanceWaveScalar(const LuminanceWaveArgs& args, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, size_t begin, size_t end) {
+		LuminanceWaveGroups<1>(args, numThreads, x, y, begin, end);
+	}
+#if defined(CPU_ARCH_X86)
+	CPU_TARGET_SSE41 void LuminanceWaveSSE41(const LuminanceWaveArgs& args, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, size_t begin, size_t end) {
+		LuminanceWaveGroups<4>(args, numThreads, x, y, begin, end);
+	}
+	CPU_TARGET_AVX2 void LuminanceWaveAVX2(const LuminanceWaveArgs& args, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, size_t begin, size_t end) {
+		LuminanceWaveGroups<8>(args, numThreads, x, y, begin, end);
+	}
+	CPU_TARGET_AVX512 void LuminanceWaveAVX512(const LuminanceWaveArgs& args, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, size_t begin, size_t end) {
+		LuminanceWaveGroups<16>(args, numThreads, x, y, begin, end);
+	}
+#elif defined(CPU_ARCH_ARM64)
+	void LuminanceWaveNEON(const LuminanceWaveArgs& args, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, size_t begin, size_t end) {
+		LuminanceWaveGroups<4>(args, numThreads, x, y, begin, end);
+	}
+#endif
+
+	Kernel<WaveGroupsFunc<LuminanceWaveArgs>> luminanceWave("wavelum", {
+		{ CpuIsa::Scalar, LuminanceWaveScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, LuminanceWaveSSE41 },
+		{ CpuIsa::AVX2, LuminanceWaveAVX2 },
+		{ CpuIsa::AVX512, LuminanceWaveAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, LuminanceWaveNEON },
+#endif
+	});
+
+	int WaveWidthOf(CpuIsa isa) {
+		switch (isa) {
+		case CpuIsa::SSE41:
+		case CpuIsa::NEON:
+			return 4;
+		case CpuIsa::AVX2:
+			return 8;
+		case CpuIsa::AVX512:
+			return 16;
+		default:
+			return 1;
+		}
+	}
+}
+
+void
+BenchmarkWave() {
+	constexpr unsigned int width = 1280;
+	constexpr unsigned int height = 720;
+	vector<WavePixel> src(static_cast<size_t>(width) * height);
+	for (size_t i = 0; i < src.size(); ++i) {
+		src[i] = { (i % 255) / 255.0f, (i % 253) / 253.0f, (i % 127) / 127.0f, 1.0f };
+	}
+	vector<float> dstScalar(src.size()), dstWave(src.size());
+	unsigned int countScalar = 0, countWave = 0;
+	//幅がnumthreadsで割り切れない場合も境界チェックで弾けることを見るため切り上げておく
+	const hlsl::uint3 numThreads = { 16,16,1 };
+	const unsigned int groupX = (width + numThreads.x - 1) / numThreads.x;
+	const unsigned int groupY = (height + numThreads.y - 1) / numThreads.y;
+	auto& executor = ComputeExecutor::Instance();
+
+	auto scalarMs = MeasureMedianMs(1, 9, [&]() {
+		countScalar = 0;
+		executor.Dispatch(numThreads, groupX, groupY, 1, [&](const ComputeThreadId& id) {
+			auto& dtid = id.dispatchThreadId;
+			if (dtid.x < width && dtid.y < height) {
+				auto idx = dtid.y * width + dtid.x;
+				auto& p = src[idx];
+				float b = p.r * 0.299f + p.g * 0.587f + p.b * 0.114f;
+				b = min(max(b, 0.0f), 1.0f);
+				dstScalar[idx] = b;
+				if (b > 0.5f) {
+					hlsl::InterlockedAdd(countScalar, 1u);
+				}
+			}
+		});
+	});
+	printf("luminance %ux%u numthreads(16,16,1) selected=%s (wave width=%d)\n",
+		width, height, CpuIsaName(luminanceWave.SelectedIsa()), WaveWidthOf(luminanceWave.SelectedIsa()));
+	printf("scalar dispatch : %8.3f ms count=%u\n", scalarMs, countScalar);
+
+	//このCPUで使える実装(ウェーブ幅)を全部比べる
+	const LuminanceWaveArgs args = { src.data(), dstWave.data(), width, height, &countWave };
+	for (auto isa : luminanceWave.Isas()) {
+		auto groups = luminanceWave.Get(isa);
+		if (!groups) {
+			continue;
+		}
+		fill(dstWave.begin(), dstWave.end(), -1.0f);
+		auto waveMs = MeasureMedianMs(1, 9, [&]() {
+			countWave = 0;
+			DispatchWaveGroups(executor, numThreads, groupX, groupY, 1, groups, args);
+		});
+		//FMAの使われ方で最下位ビットがずれることがあるので誤差を許す
+		float maxDiff = 0.0f;
+		for (size_t i = 0; i < dstScalar.size(); ++i) {
+			maxDiff = std::max(maxDiff, fabsf(dstScalar[i] - dstWave[i]));
+		}
+		printf("wave %-6s W=%-2d: %8.3f ms count=%u (x%.2f) max diff=%g%s\n", CpuIsaName(isa), WaveWidthOf(isa),
+			waveMs, countWave, scalarMs / waveMs, maxDiff, countWave == countScalar ? "" : " MISMATCH");
+	}
+}
+
+void
+BenchmarkMonoFilter() {
+	auto& kernel = *KernelRegistry::Instance().Find("mono");
+	printf("MonoFilter selected=%s\n", MonoFilterVariantName());
+	auto makeImage = [](unsigned int w, unsigned int h) {
+		ImageRGBA8 img(w, h);
+		uint32_t seed = 12345;
+		for (auto& p : img.pixels) {
+			seed = seed * 1664525u + 1013904223u;
+			p = seed | 0xff000000;
+		}
+		return img;
+	};
+	//全RGBの組み合わせ(4096x4096=2^24)
+	ImageRGBA8 all(4096, 4096);
+	for (uint32_t i = 0; i < all.pixels.size(); ++i) {
+		all.pixels[i] = i | 0xff000000;
+	}
+	ImageRGBA8 ref, scalar;
+	MonoFilterReference(all, ref);
+	auto src720 = makeImage(1280, 720);
+	{
+		ImageRGBA8 dst;
+		auto refMs = MeasureMedianMs(1, 5, [&]() {MonoFilterReference(src720, dst); });
+		printf("1280x720 reference %7.3f ms\n", refMs);
+	}
+	//このCPUで使える実装を全部切り替えて、基準実装との差(とスカラー実装との一致)と720pの時間を見る
+	for (auto isa : kernel.Isas()) {
+		if (!IsCpuIsaSupported(isa)) {
+			continue;
+		}
+		auto config = MonoFilterDefaultConfig(all.width, all.height);
+		config.isa = isa;
+		ImageRGBA8 fast;
+		MonoFilter(all, fast, config, &ComputeExecutor::Instance());
+		int maxDiff = 0;
+		size_t diffCount = 0;
+		for (size_t i = 0; i < ref.pixels.size(); ++i) {
+			int d = abs(static_cast<int>(ref.pixels[i] & 0xff) - static_cast<int>(fast.pixels[i] & 0xff));
+			maxDiff = max(maxDiff, d);
+			diffCount += d != 0;
+		}
+		if (isa == CpuIsa::Scalar) {
+			scalar = fast;
+		}
+		bool sameAsScalar = fast.pixels == scalar.pixels;
+		ImageRGBA8 dst;
+		auto fastMs = MeasureMedianMs(3, 21, [&]() {MonoFilter(src720, dst, config, nullptr); });
+		printf("%-7s all 2^24 colors: max diff=%d LSB (%zu px)%s, 1280x720 1 thread %7.3f ms\n",
+			CpuIsaName(isa), maxDiff, diffCount, sameAsScalar ? "" : " MISMATCH vs scalar", fastMs);
+	}
+	{
+		auto src = makeImage(3840, 2160);
+		ImageRGBA8 dst;
+		auto& executor = ComputeExecutor::Instance();
+		auto config = MonoFilterConfigFor(src.width, src.height);
+		auto singleMs = MeasureMedianMs(1, 9, [&]() {MonoFilter(src, dst); });
+		auto multiMs = MeasureMedianMs(1, 9, [&]() {MonoFilter(src, dst, &executor); });
+		printf("3840x2160 %s group %ux%u x%u: 1 thread %7.3f ms, %u threads %7.3f ms\n", CpuIsaName(config.isa),
+			config.groupSize.x, config.groupSize.y, config.groupsPerTask, singleMs, executor.ThreadCount(), multiMs);
+	}
+}
+
+void
+AutotuneMonoFilter() {
+	auto& executor = ComputeExecutor::Instance();
+	auto& table = TuneTable::Instance();
+	printf("cpu: %s, %u threads\n", CpuModelName().c_str(), executor.ThreadCount());
+	//TextureFilterの画像、RenderTargetFilterの画面、4K
+	const unsigned int sizes[][2] = { { 200,200 },{ 1280,720 },{ 3840,2160 } };
+	for (auto& size : sizes) {
+		ImageRGBA8 src(size[0], size[1]);
+		uint32_t seed = 12345;
+		for (auto& p : src.pixels) {
+			seed = seed * 1664525u + 1013904223u;
+			p = seed | 0xff000000;
+		}
+		ImageRGBA8 dst;
+		auto run = [&](const TuneConfig& config) {MonoFilter(src, dst, config, &executor); };
+		//小さい画像は1回が短いので回数を増やす
+		const int repeat = size[0] * size[1] < 256 * 256 ? 51 : 15;
+		auto defaultMs = MeasureMedianMs(3, repeat, [&]() {run(MonoFilterDefaultConfig(src.width, src.height)); });
+		vector<TuneMeasurement> results;
+		auto best = Autotune(MonoFilterTuneCandidates(src.width, src.height), run, 3, repeat, &results);
+		printf("%ux%u: %zu configs, default %7.3f ms\n", size[0], size[1], results.size(), defaultMs);
+		for (size_t i = 0; i < min<size_t>(results.size(), 5); ++i) {
+			auto& r = results[i];
+			printf("  %-7s group %4ux%-4u x%u  median %7.3f ms  min %7.3f ms  spread %4.1f%%\n", CpuIsaName(r.config.isa),
+				r.config.groupSize.x, r.config.groupSize.y, r.config.groupsPerTask, r.medianMs, r.minMs, r.spread * 100.0);
+		}
+		table.Store("mono", src.width, src.height, best.config, best.medianMs);
+	}
+	if (table.Save(table.Path())) {
+		printf("saved to %s\n", table.Path().c_str());
+	}
+	else {
+		printf("failed to save %s\n", table.Path().c_str());
+	}
+}
+
+void
+BenchmarkComputeJob() {
+	auto& executor = ComputeExecutor::Instance();
+	//FirstStepと同じ入力64個、出力512個、[numthreads(4,4,4)]でDispatch(2,2,2)
+	constexpr size_t inCount = 64;
+	constexpr size_t outCount = 2 * 2 * 2 * 4 * 4 * 4;
+	//入力は読まない(FirstStepのカーネルと同じくID書き込みだけを測る)
+	auto kernel = [](const ComputeThreadId& id, StructuredBufferView<SimpleBuffer_t>, RWStructuredBufferView<IDs> outBuff) {
+		auto& dtid = id.dispatchThreadId;
+		auto idx = dtid.x * 8 * 8 + dtid.y * 8 + dtid.z;
+		outBuff[idx].dsptThrdId = static_cast<float>(idx);
+	};
+	auto job = MakeCpuComputeJob<SimpleBuffer_t, IDs>(executor, { 4,4,4 }, kernel);
+	job->Resize(inCount, outCount);
+	auto fillInput = [](SimpleBuffer_t* in, size_t count, int seed) {
+		for (size_t i = 0; i < count; ++i) {
+			in[i].i = static_cast<int>(i) + seed;
+			in[i].f = static_cast<float>(i) * 0.5f;
+		}
+	};
+	fillInput(job->Input(), job->InputCount(), 0);
+	job->Run(2, 2, 2);
+	std::vector<IDs> expected(outCount);
+	FirstStepIds(expected, 2, 2, 2, executor);
+	bool same = true;
+	for (size_t i = 0; i < outCount; ++i) {
+		same = same && job->Output()[i].dsptThrdId == expected[i].dsptThrdId;
+	}
+	//同じか小さい大きさなら確保し直さない
+	auto outPtr = job->Output();
+	job->Resize(inCount / 2, outCount);
+	bool reused = job->Output() == outPtr;
+	job->Resize(inCount, outCount);
+	printf("ComputeJob<SimpleBuffer_t,IDs>: %s, buffers %s\n", same ? "matches FirstStepIds" : "MISMATCH vs FirstStepIds", reused ? "reused" : "REALLOCATED");
+
+	//入力を書いてRunして出力を読む、を繰り返す
+	constexpr int jobNum = 20000;
+	float sink = 0.0f;
+	Stopwatch sw;
+	for (int n = 0; n < jobNum; ++n) {
+		fillInput(job->Input(), job->InputCount(), n);
+		job->Run(2, 2, 2);
+		sink += job->Output()[n % outCount].dsptThrdId;
+	}
+	auto ms = sw.ElapsedMilliseconds();
+	printf("%d jobs: %8.0f jobs/s (%6.2f us/job) [%g]\n", jobNum, jobNum / (ms / 1000.0), ms * 1000.0 / jobNum, sink > 0.0f ? 1.0 : 0.0);
+}
+
+void
+BenchmarkSoa() {
+	using IdsSoa = SoaBuffer<IDs, &IDs::grpId, &IDs::grpThrdId, &IDs::dsptThrdId, &IDs::grpIdx>;
+	using SimpleSoa = SoaBuffer<SimpleBuffer_t, &SimpleBuffer_t::i, &SimpleBuffer_t::f>;
+	auto& registry = KernelRegistry::Instance();
+	auto& aosToSoa = *registry.Find("aos2soa");
+	auto& soaToAos = *registry.Find("soa2aos");
+
+	//端数が出る要素数で、実装ごとに往復して元に戻るか
+	constexpr size_t checkCount = 1003;
+	vector<IDs> ids(checkCount);
+	vector<SimpleBuffer_t> simples(checkCount);
+	for (size_t i = 0; i < checkCount; ++i) {
+		ids[i] = { static_cast<float>(i),static_cast<float>(i) + 0.25f,static_cast<float>(i) + 0.5f,static_cast<unsigned int>(i * 7) };
+		simples[i] = { static_cast<int>(i) - 500,static_cast<float>(i) * 0.125f };
+	}
+	for (auto isa : aosToSoa.Isas()) {
+		if (!aosToSoa.SelectExact(isa) || !soaToAos.SelectExact(isa)) {
+			continue;
+		}
+		IdsSoa idsSoa;
+		idsSoa.Resize(checkCount);
+		idsSoa.FromAos(ids.data());
+		bool ok = true;
+		for (size_t i = 0; i < checkCount; ++i) {
+			ok = ok && idsSoa[i][&IDs::grpId] == ids[i].grpId && idsSoa[i][&IDs::grpThrdId] == ids[i].grpThrdId
+				&& idsSoa.Column<&IDs::dsptThrdId>()[i] == ids[i].dsptThrdId && idsSoa[i][&IDs::grpIdx] == ids[i].grpIdx;
+		}
+		vector<IDs> idsBack(checkCount);
+		idsSoa.ToAos(idsBack.data());
+		ok = ok && memcmp(idsBack.data(), ids.data(), checkCount * sizeof(IDs)) == 0;
+
+		SimpleSoa simpleSoa;
+		simpleSoa.Resize(checkCount);
+		simpleSoa.FromAos(simples.data());
+		for (size_t i = 0; i < checkCount; ++i) {
+			ok = ok && simpleSoa[i][&SimpleBuffer_t::i] == simples[i].i && simpleSoa[i][&SimpleBuffer_t::f] == simples[i].f;
+		}
+		vector<SimpleBuffer_t> simplesBack(checkCount);
+		simpleSoa.ToAos(simplesBack.data());
+		ok = ok && memcmp(simplesBack.data(), simples.data(), checkCount * sizeof(SimpleBuffer_t)) == 0;
+		printf("%-7s AoS<->SoA round trip (4 and 2 fields): %s\n", CpuIsaName(isa), ok ? "ok" : "MISMATCH");
+	}
+	registry.Reset();
+
+	//FirstStepと同じくdsptThrdIdだけを書くカーネルを、AoSとSoAで大きなバッファに対して実行する
+	auto& executor = ComputeExecutor::Instance();
+	constexpr unsigned int count = 4 * 1024 * 1024;
+	const hlsl::uint3 numThreads = { 256,1,1 };
+	const unsigned int groups = count / numThreads.x;
+	vector<IDs> aos(count);
+	IdsSoa soa;
+	soa.Resize(count);
+	RWStructuredBufferView<IDs> aosView = { aos.data(),aos.size() };
+	auto aosMs = MeasureMedianMs(2, 11, [&]() {
+		executor.Dispatch(numThreads, groups, 1, 1, [&](const ComputeThreadId& id) {
+			auto idx = id.dispatchThreadId.x;
+			aosView[idx].dsptThrdId = static_cast<float>(idx);
+		});
+	});
+	auto soaMs = MeasureMedianMs(2, 11, [&]() {
+		executor.Dispatch(numThreads, groups, 1, 1, [&](const ComputeThreadId& id) {
+			auto idx = id.dispatchThreadId.x;
+			soa[idx][&IDs::dsptThrdId] = static_cast<float>(idx);
+		});
+	});
+	bool same = true;
+	for (unsigned int i = 0; i < count; i += 4097) {
+		same = same && aos[i].dsptThrdId == soa.Column<&IDs::dsptThrdId>()[i];
+	}
+	auto gbps = [](size_t bytes, double ms) {return bytes / (ms * 1e6); };
+	printf("%u IDs, write dsptThrdId only: AoS %7.3f ms (%zu MB touched), SoA %7.3f ms (%zu MB touched) x%.2f%s\n", count,
+		aosMs, count * sizeof(IDs) >> 20, soaMs, count * sizeof(float) >> 20, aosMs / soaMs, same ? "" : " MISMATCH");
+
+	//アップロード/リードバックでの並べ替えの速さ
+	for (auto isa : aosToSoa.Isas()) {
+		if (!aosToSoa.SelectExact(isa) || !soaToAos.SelectExact(isa)) {
+			continue;
+		}
+		auto toSoaMs = MeasureMedianMs(1, 7, [&]() {soa.FromAos(aos.data()); });
+		auto toAosMs = MeasureMedianMs(1, 7, [&]() {soa.ToAos(aos.data()); });
+		printf("%-7s AoS->SoA %7.3f ms (%5.1f GB/s), SoA->AoS %7.3f ms (%5.1f GB/s)\n", CpuIsaName(isa),
+			toSoaMs, gbps(2 * count * sizeof(IDs), toSoaMs), toAosMs, gbps(2 * count * sizeof(IDs), toAosMs));
+	}
+	registry.Reset();
+}
+
+void
+BenchmarkReduction() {
+	auto& registry = KernelRegistry::Instance();
+	auto& luma8 = *registry.Find("luma8");
+	auto& lumaF = *registry.Find("lumaf");
+	auto& executor = ComputeExecutor::Instance();
+	auto makeImage8 = [](unsigned int w, unsigned int h) {
+		ImageRGBA8 img(w, h);
+		uint32_t seed = 12345;
+		for (auto& p : img.pixels) {
+			seed = seed * 1664525u + 1013904223u;
+			p = seed | 0xff000000;
+		}
+		return img;
+	};
+	auto makeImageF = [](const ImageRGBA8& src) {
+		ImageRGBA32F img(src.width, src.height);
+		for (size_t i = 0; i < src.pixels.size(); ++i) {
+			img.pixels[i] = UnpackUnorm4x8(src.pixels[i]);
+		}
+		return img;
+	};
+	auto sameHistogram = [](const LumaHistogram& a, const LumaHistogram& b) {
+		return equal(begin(a.bins), end(a.bins), begin(b.bins));
+	};
+
+	//端数が出る大きさで、実装ごとに基準実装と比べる
+	{
+		auto src8 = makeImage8(1283, 719);
+		auto srcF = makeImageF(src8);
+		//黒と白の画素で最小/最大が端になるようにする
+		src8.pixels[17] = 0xff000000;
+		src8.pixels[src8.pixels.size() - 3] = 0xffffffff;
+		srcF.pixels[17] = hlsl::float4(0.0f, 0.0f, 0.0f, 1.0f);
+		srcF.pixels[srcF.pixels.size() - 3] = hlsl::float4(4.0f, 4.0f, 4.0f, 1.0f);
+		const auto rangeF = MakeLumaHistogramRange(0.0f, 2.0f);
+		LumaStats ref8, refF;
+		LumaHistogram refHist8, refHistF;
+		ReduceLumaReference(src8, ref8, refHist8);
+		ReduceLumaReference(srcF, rangeF, refF, refHistF);
+		for (auto isa : luma8.Isas()) {
+			if (!luma8.SelectExact(isa)) {
+				continue;
+			}
+			LumaStats stats;
+			LumaHistogram hist;
+			ReduceLuma(src8, stats, &hist, &executor);
+			bool ok = stats.sum == ref8.sum && stats.minimum == ref8.minimum && stats.maximum == ref8.maximum
+				&& stats.count == ref8.count && sameHistogram(hist, refHist8);
+			printf("%-7s R8G8B8A8 1283x719: avg %.6f min %.4f max %.4f: %s\n", CpuIsaName(isa),
+				stats.Average(), stats.minimum, stats.maximum, ok ? "ok" : "MISMATCH");
+		}
+		for (auto isa : lumaF.Isas()) {
+			if (!lumaF.SelectExact(isa)) {
+				continue;
+			}
+			LumaStats stats;
+			LumaHistogram hist;
+			ReduceLuma(srcF, rangeF, stats, &hist, &executor);
+			//積和の順序(FMAになるか)で階級の境目の画素がずれることがあるので、ヒストグラムは数画素の違いまで許す
+			uint64_t histDiff = 0;
+			for (int b = 0; b < 256; ++b) {
+				histDiff += abs(static_cast<long long>(hist.bins[b]) - static_cast<long long>(refHistF.bins[b]));
+			}
+			bool ok = fabs(stats.sum - refF.sum) <= refF.sum * 1e-6 && fabs(stats.minimum - refF.minimum) <= 1e-6f
+				&& fabs(stats.maximum - refF.maximum) <= 1e-6f && hist.Total() == refHistF.Total() && histDiff <= 8;
+			printf("%-7s float    1283x719: avg %.6f (ref %.6f) min %.4f max %.4f, histogram diff %llu px: %s\n", CpuIsaName(isa),
+				stats.Average(), refF.Average(), stats.minimum, stats.maximum, static_cast<unsigned long long>(histDiff), ok ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+	}
+
+	//RenderTargetFilterのオフスクリーンと同じ720pと4Kで、読むだけのループと比べる
+	auto gbps = [](size_t bytes, double ms) {return bytes / (ms * 1e6); };
+	const unsigned int sizes[][2] = { { 1280,720 },{ 3840,2160 } };
+	for (auto& size : sizes) {
+		auto src8 = makeImage8(size[0], size[1]);
+		auto srcF = makeImageF(src8);
+		const int repeat = size[0] * size[1] > 1920 * 1080 ? 9 : 21;
+		//同じ量を読んで64bitで足すだけ(メモリ帯域の目安)
+		auto readMs = [&](const void* data, size_t bytes) {
+			auto words = static_cast<const uint64_t*>(data);
+			const size_t wordNum = bytes / sizeof(uint64_t);
+			const size_t chunk = 64 * 1024;
+			vector<uint64_t> partial((wordNum + chunk - 1) / chunk);
+			return MeasureMedianMs(2, repeat, [&]() {
+				executor.ParallelFor(partial.size(), 1, [&](size_t begin, size_t end) {
+					for (auto c = begin; c < end; ++c) {
+						uint64_t s = 0;
+						const auto last = min(wordNum, (c + 1) * chunk);
+						for (auto i = c * chunk; i < last; ++i) {
+							s += words[i];
+						}
+						partial[c] = s;
+					}
+				});
+			});
+		};
+		const size_t bytes8 = src8.pixels.size() * sizeof(uint32_t);
+		const size_t bytesF = srcF.pixels.size() * sizeof(hlsl::float4);
+		auto read8Ms = readMs(src8.pixels.data(), bytes8);
+		auto readFMs = readMs(srcF.pixels.data(), bytesF);
+		printf("%ux%u %u threads: read only R8G8B8A8 %7.3f ms (%5.1f GB/s), float %7.3f ms (%5.1f GB/s)\n", size[0], size[1],
+			executor.ThreadCount(), read8Ms, gbps(bytes8, read8Ms), readFMs, gbps(bytesF, readFMs));
+		LumaStats stats;
+		LumaHistogram hist;
+		for (auto isa : luma8.Isas()) {
+			if (!luma8.SelectExact(isa)) {
+				continue;
+			}
+			auto statsMs = MeasureMedianMs(2, repeat, [&]() {ReduceLuma(src8, stats, nullptr, &executor); });
+			auto histMs = MeasureMedianMs(2, repeat, [&]() {ReduceLuma(src8, stats, &hist, &executor); });
+			printf("  %-7s R8G8B8A8 sum/min/max %7.3f ms (%5.1f GB/s), +histogram %7.3f ms (%5.1f GB/s)\n", CpuIsaName(isa),
+				statsMs, gbps(bytes8, statsMs), histMs, gbps(bytes8, histMs));
+		}
+		const auto rangeF = MakeLumaHistogramRange(0.0f, 1.0f);
+		for (auto isa : lumaF.Isas()) {
+			if (!lumaF.SelectExact(isa)) {
+				continue;
+			}
+			auto statsMs = MeasureMedianMs(2, repeat, [&]() {ReduceLuma(srcF, rangeF, stats, nullptr, &executor); });
+			auto histMs = MeasureMedianMs(2, repeat, [&]() {ReduceLuma(srcF, rangeF, stats, &hist, &executor); });
+			printf("  %-7s float    sum/min/max %7.3f ms (%5.1f GB/s), +histogram %7.3f ms (%5.1f GB/s)\n", CpuIsaName(isa),
+				statsMs, gbps(bytesF, statsMs), histMs, gbps(bytesF, histMs));
+		}
+		registry.Reset();
+	}
+}
+
+void
+BenchmarkScan() {
+	auto& registry = KernelRegistry::Instance();
+	auto& scan = *registry.Find("scan");
+	auto& compact = *registry.Find("compact");
+	auto& executor = ComputeExecutor::Instance();
+	auto fill = [](vector<uint32_t>& values, vector<float>& floats) {
+		uint32_t seed = 12345;
+		for (size_t i = 0; i < values.size(); ++i) {
+			seed = seed * 1664525u + 1013904223u;
+			values[i] = seed >> 24;
+			floats[i] = (seed >> 8) / 16777216.0f;
+		}
+	};
+
+	//端数の出る要素数で、実装ごとに逐次計算と比べる(1スレッドと全スレッド、ブロックが複数になる大きさ)
+	{
+		constexpr size_t count = 1000003;
+		vector<uint32_t> src(count);
+		vector<float> values(count);
+		fill(src, values);
+		vector<uint32_t> refExclusive(count), refInclusive(count);
+		partial_sum(src.begin(), src.end(), refInclusive.begin());
+		refExclusive[0] = 0;
+		copy(refInclusive.begin(), refInclusive.end() - 1, refExclusive.begin() + 1);
+		vector<uint32_t> refIndices;
+		for (size_t i = 0; i < count; ++i) {
+			if (values[i] > 0.7f) {
+				refIndices.push_back(static_cast<uint32_t>(i));
+			}
+		}
+		ComputeExecutor multi(4);
+		for (auto isa : scan.Isas()) {
+			if (!scan.SelectExact(isa) || !compact.SelectExact(isa)) {
+				continue;
+			}
+			bool ok = true;
+			for (auto exec : { static_cast<ComputeExecutor*>(nullptr),&multi }) {
+				vector<uint32_t> dst(count);
+				ok = ok && ExclusiveScan(src.data(), dst.data(), count, exec) == refInclusive.back() && dst == refExclusive;
+				ok = ok && InclusiveScan(src.data(), dst.data(), count, exec) == refInclusive.back() && dst == refInclusive;
+				//その場でのスキャン
+				dst = src;
+				ExclusiveScan(dst.data(), dst.data(), count, exec);
+				ok = ok && dst == refExclusive;
+				vector<uint32_t> indices(count);
+				indices.resize(CompactIndicesGreater(values.data(), count, 0.7f, indices.data(), exec));
+				ok = ok && indices == refIndices;
+			}
+			printf("%-7s scan/compaction %zu elements: %s\n", CpuIsaName(isa), count, ok ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+		//型つきのコンパクション(FirstStepの入力でfがしきい値より大きいものだけ残す)
+		vector<SimpleBuffer_t> elements(count);
+		for (size_t i = 0; i < count; ++i) {
+			elements[i] = { static_cast<int>(i),values[i] };
+		}
+		auto pred = [](const SimpleBuffer_t& e) {return e.f > 0.7f; };
+		vector<SimpleBuffer_t> compacted(count);
+		compacted.resize(Compact(elements.data(), count, compacted.data(), pred, &multi));
+		bool ok = compacted.size() == refIndices.size();
+		for (size_t i = 0; ok && i < compacted.size(); ++i) {
+			ok = compacted[i].i == static_cast<int>(refIndices[i]);
+		}
+		printf("Compact<SimpleBuffer_t> f > 0.7: %zu of %zu: %s\n", compacted.size(), count, ok ? "ok" : "MISMATCH");
+	}
+
+	//100万～1億要素(1億要素のuint32_tは400MB)
+	auto gbps = [](size_t bytes, double ms) {return bytes / (ms * 1e6); };
+	printf("%u threads\n", executor.ThreadCount());
+	for (size_t count : { size_t(1000000),size_t(10000000),size_t(100000000) }) {
+		const int repeat = count >= 100000000 ? 3 : 9;
+		{
+			vector<uint32_t> src(count), dst(count);
+			vector<float> values(count);
+			fill(src, values);
+			auto refMs = MeasureMedianMs(1, repeat, [&]() {partial_sum(src.begin(), src.end(), dst.begin()); });
+			printf("%9zu elements: std::partial_sum %8.3f ms (%5.1f GB/s)\n", count, refMs, gbps(count * 8, refMs));
+			for (auto isa : scan.Isas()) {
+				if (!scan.SelectExact(isa) || !compact.SelectExact(isa)) {
+					continue;
+				}
+				auto scanMs = MeasureMedianMs(1, repeat, [&]() {ExclusiveScan(src.data(), dst.data(), count, &executor); });
+				//約30%を残す
+				size_t kept = 0;
+				auto compactMs = MeasureMedianMs(1, repeat, [&]() {kept = CompactIndicesGreater(values.data(), count, 0.7f, dst.data(), &executor); });
+				printf("  %-7s exclusive scan %8.3f ms (%5.1f GB/s), compact indices f > 0.7 %8.3f ms (%5.1f Gelem/s, kept %zu)\n", CpuIsaName(isa),
+					scanMs, gbps(count * 8, scanMs), compactMs, count / (compactMs * 1e6), kept);
+			}
+			registry.Reset();
+		}
+		{
+			vector<SimpleBuffer_t> elements(count), compacted(count);
+			uint32_t seed = 12345;
+			for (size_t i = 0; i < count; ++i) {
+				seed = seed * 1664525u + 1013904223u;
+				elements[i] = { static_cast<int>(i),(seed >> 8) / 16777216.0f };
+			}
+			size_t kept = 0;
+			auto ms = MeasureMedianMs(1, repeat, [&]() {
+				kept = Compact(elements.data(), count, compacted.data(), [](const SimpleBuffer_t& e) {return e.f > 0.7f; }, &executor);
+			});
+			printf("  Compact<SimpleBuffer_t> f > 0.7 %8.3f ms (%5.1f Gelem/s, kept %zu)\n", ms, count / (ms * 1e6), kept);
+		}
+	}
+}
+
+void
+BenchmarkRadixSort() {
+	auto& executor = ComputeExecutor::Instance();
+	auto makeRecords = [](size_t count) {
+		//iは重複の多い符号つきの値、fは負も含む値(安定性がわかるよう同じ値を多くする)
+		vector<SimpleBuffer_t> records(count);
+		uint32_t seed = 12345;
+		for (size_t i = 0; i < count; ++i) {
+			seed = seed * 1664525u + 1013904223u;
+			records[i] = { static_cast<int>(seed) >> 12,static_cast<float>(static_cast<int>(seed >> 16) - 32768) / 64.0f };
+		}
+		return records;
+	};
+
+	//端数の出る要素数で、std::stable_sortと比べる(1スレッドと4スレッド)
+	{
+		constexpr size_t count = 1000003;
+		auto records = makeRecords(count);
+		vector<uint32_t> keys(count), values(count);
+		for (size_t i = 0; i < count; ++i) {
+			keys[i] = static_cast<uint32_t>(records[i].i) * 2654435761u;
+			values[i] = static_cast<uint32_t>(i);
+		}
+		vector<pair<uint32_t, uint32_t>> refPairs(count);
+		for (size_t i = 0; i < count; ++i) {
+			refPairs[i] = { keys[i],values[i] };
+		}
+		stable_sort(refPairs.begin(), refPairs.end(), [](const pair<uint32_t, uint32_t>& a, const pair<uint32_t, uint32_t>& b) {return a.first < b.first; });
+		auto refByI = records;
+		stable_sort(refByI.begin(), refByI.end(), [](const SimpleBuffer_t& a, const SimpleBuffer_t& b) {return a.i < b.i; });
+		auto refByF = records;
+		stable_sort(refByF.begin(), refByF.end(), [](const SimpleBuffer_t& a, const SimpleBuffer_t& b) {return a.f < b.f; });
+		auto sameRecords = [](const vector<SimpleBuffer_t>& a, const vector<SimpleBuffer_t>& b) {
+			return equal(a.begin(), a.end(), b.begin(), [](const SimpleBuffer_t& x, const SimpleBuffer_t& y) {return x.i == y.i && x.f == y.f; });
+		};
+
+		ComputeExecutor multi(4);
+		RadixSorter sorter;
+		for (auto exec : { static_cast<ComputeExecutor*>(nullptr),&multi }) {
+			auto k = keys;
+			sorter.SortKeys(k.data(), count, exec);
+			bool ok = is_sorted(k.begin(), k.end());
+			auto v = values;
+			k = keys;
+			sorter.SortPairs(k.data(), v.data(), count, exec);
+			for (size_t i = 0; ok && i < count; ++i) {
+				ok = k[i] == refPairs[i].first && v[i] == refPairs[i].second;
+			}
+			auto byI = records;
+			sorter.SortRecords(byI.data(), count, &SimpleBuffer_t::i, exec);
+			ok = ok && sameRecords(byI, refByI);
+			auto byF = records;
+			sorter.SortRecords(byF.data(), count, &SimpleBuffer_t::f, exec);
+			ok = ok && sameRecords(byF, refByF);
+			printf("radix sort %zu keys/pairs/records (%s): %s\n", count, exec == nullptr ? "serial" : "4 threads", ok ? "ok" : "MISMATCH");
+		}
+
+		//floatのキーの変換(-0,無限大,非正規化数を含む)
+		vector<float> floats = { 1.0f,-1.0f,0.0f,-0.0f,1e-40f,-1e-40f,3.0e38f,-3.0e38f,HUGE_VALF,-HUGE_VALF,0.5f,-0.5f,2.0f };
+		vector<uint32_t> floatKeys(floats.size());
+		ToSortableKeys(floats.data(), floatKeys.data(), floats.size());
+		sorter.SortKeys(floatKeys.data(), floatKeys.size(), nullptr);
+		vector<float> sortedFloats(floats.size());
+		FromSortableKeys(floatKeys.data(), sortedFloats.data(), floats.size());
+		auto refFloats = floats;
+		sort(refFloats.begin(), refFloats.end());
+		bool ok = sortedFloats == refFloats && signbit(sortedFloats[5]) && !signbit(sortedFloats[6]);
+		printf("float keys (-0 before +0, infinities, denormals): %s\n", ok ? "ok" : "MISMATCH");
+	}
+
+	//1000万要素をstd::sortと比べる(毎回並べる前の状態に戻すので、その時間はどちらにも入っている)
+	constexpr size_t count = 10000000;
+	printf("%u threads, %zu elements\n", executor.ThreadCount(), count);
+	const auto records = makeRecords(count);
+	vector<uint32_t> keys(count), values(count);
+	for (size_t i = 0; i < count; ++i) {
+		keys[i] = static_cast<uint32_t>(records[i].i) * 2654435761u;
+		values[i] = static_cast<uint32_t>(i);
+	}
+	RadixSorter sorter;
+	{
+		vector<pair<uint32_t, uint32_t>> src(count), work(count);
+		for (size_t i = 0; i < count; ++i) {
+			src[i] = { keys[i],values[i] };
+		}
+		auto refMs = MeasureMedianMs(1, 3, [&]() {
+			work = src;
+			sort(work.begin(), work.end(), [](const pair<uint32_t, uint32_t>& a, const pair<uint32_t, uint32_t>& b) {return a.first < b.first; });
+		});
+		vector<uint32_t> k(count), v(count);
+		auto ms = MeasureMedianMs(1, 5, [&]() {
+			k = keys;
+			v = values;
+			sorter.SortPairs(k.data(), v.data(), count, &executor);
+		});
+		printf("  key-value pairs: std::sort %8.2f ms, radix %8.2f ms (x%.1f)\n", refMs, ms, refMs / ms);
+		auto keyRefMs = MeasureMedianMs(1, 3, [&]() {
+			k = keys;
+			sort(k.begin(), k.end());
+		});
+		auto keyMs = MeasureMedianMs(1, 5, [&]() {
+			k = keys;
+			sorter.SortKeys(k.data(), count, &executor);
+		});
+		printf("  keys only:       std::sort %8.2f ms, radix %8.2f ms (x%.1f)\n", keyRefMs, keyMs, keyRefMs / keyMs);
+	}
+	{
+		vector<SimpleBuffer_t> work(count);
+		auto refMs = MeasureMedianMs(1, 3, [&]() {
+			work = records;
+			sort(work.begin(), work.end(), [](const SimpleBuffer_t& a, const SimpleBuffer_t& b) {return a.f < b.f; });
+		});
+		auto ms = MeasureMedianMs(1, 5, [&]() {
+			work = records;
+			sorter.SortRecords(work.data(), count, &SimpleBuffer_t::f, &executor);
+		});
+		printf("  SimpleBuffer_t by f: std::sort %8.2f ms, radix %8.2f ms (x%.1f)\n", refMs, ms, refMs / ms);
+		refMs = MeasureMedianMs(1, 3, [&]() {
+			work = records;
+			sort(work.begin(), work.end(), [](const SimpleBuffer_t& a, const SimpleBuffer_t& b) {return a.i < b.i; });
+		});
+		ms = MeasureMedianMs(1, 5, [&]() {
+			work = records;
+			sorter.SortRecords(work.data(), count, &SimpleBuffer_t::i, &executor);
+		});
+		printf("  SimpleBuffer_t by i: std::sort %8.2f ms, radix %8.2f ms (x%.1f)\n", refMs, ms, refMs / ms);
+	}
+}
+
+void
+BenchmarkGaussianBlur() {
+	auto& registry = KernelRegistry::Instance();
+	auto& blur = *registry.Find("blur");
+	auto& executor = ComputeExecutor::Instance();
+	//なめらかな模様に細かい雑音を乗せたもの
+	auto makeImage = [](unsigned int w, unsigned int h) {
+		ImageRGBA8 img(w, h);
+		uint32_t seed = 12345;
+		for (unsigned int y = 0; y < h; ++y) {
+			for (unsigned int x = 0; x < w; ++x) {
+				seed = seed * 1664525u + 1013904223u;
+				auto noise = (seed >> 24) & 0x3f;
+				img.At(x, y) = ((x * 255 / w + noise) & 0xff) | (((y * 255 / h + noise) & 0xff) << 8) | ((((x + y) & 0xff) ^ noise) << 16) | 0xff000000;
+			}
+		}
+		return img;
+	};
+	auto toFloat = [](const ImageRGBA8& src) {
+		ImageRGBA32F img(src.width, src.height);
+		for (size_t i = 0; i < src.pixels.size(); ++i) {
+			img.pixels[i] = UnpackUnorm4x8(src.pixels[i]);
+		}
+		return img;
+	};
+
+	//R8G8B8A8の行の変換がUnpackUnorm4x8/PackUnorm4x8と同じ値になるか(範囲外の値とNaNを含む)
+	{
+		auto& unpack = *registry.Find("unpack8");
+		auto& pack = *registry.Find("pack8");
+		vector<uint32_t> pixels(64 * 64 + 3);
+		for (size_t i = 0; i < pixels.size(); ++i) {
+			pixels[i] = static_cast<uint32_t>(i * 0x01020304u + (i >> 6) * 0x40302010u);
+		}
+		vector<float> floats(pixels.size() * 4);
+		for (size_t i = 0; i < floats.size(); ++i) {
+			floats[i] = static_cast<float>(i % 1031) / 1000.0f - 0.01f;
+		}
+		floats[5] = NAN;
+		floats[6] = -INFINITY;
+		floats[7] = INFINITY;
+		for (auto isa : unpack.Isas()) {
+			if (!unpack.SelectExact(isa) || !pack.SelectExact(isa)) {
+				continue;
+			}
+			vector<float> unpacked(floats.size());
+			UnpackUnorm4x8Row(pixels.data(), unpacked.data(), pixels.size());
+			vector<uint32_t> packed(pixels.size());
+			PackUnorm4x8Row(floats.data(), packed.data(), pixels.size());
+			bool ok = true;
+			for (size_t i = 0; i < pixels.size(); ++i) {
+				auto ref = UnpackUnorm4x8(pixels[i]);
+				for (int c = 0; c < 4; ++c) {
+					ok = ok && unpacked[i * 4 + c] == ref[c];
+				}
+				ok = ok && packed[i] == PackUnorm4x8(hlsl::float4(floats[i * 4], floats[i * 4 + 1], floats[i * 4 + 2], floats[i * 4 + 3]));
+			}
+			printf("%-7s unorm8 row unpack/pack: %s\n", CpuIsaName(isa), ok ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+	}
+
+	//端数の出る大きさで、実装ごとに基準実装と比べる(floatは誤差、R8G8B8A8は丸めた値の差)
+	{
+		const auto src8 = makeImage(333, 201);
+		const auto srcF = toFloat(src8);
+		ComputeExecutor multi(4);
+		for (auto isa : blur.Isas()) {
+			if (!blur.SelectExact(isa)) {
+				continue;
+			}
+			float maxError = 0.0f;
+			int maxDiff = 0;
+			bool same = true;
+			for (unsigned int radius : { 1u,3u,17u,64u }) {
+				const auto sigma = GaussianSigmaForRadius(radius);
+				ImageRGBA32F ref, outF, outMulti;
+				GaussianBlurReference(srcF, ref, radius, sigma);
+				GaussianBlur(srcF, outF, radius, sigma, nullptr);
+				GaussianBlur(srcF, outMulti, radius, sigma, &multi);
+				ImageRGBA8 out8;
+				GaussianBlur(src8, out8, radius, sigma, &multi);
+				for (size_t i = 0; i < ref.pixels.size(); ++i) {
+					for (int c = 0; c < 4; ++c) {
+						maxError = max(maxError, fabs(outF.pixels[i][c] - ref.pixels[i][c]));
+						same = same && outF.pixels[i][c] == outMulti.pixels[i][c];
+					}
+					auto refPx = PackUnorm4x8(ref.pixels[i]);
+					for (int c = 0; c < 32; c += 8) {
+						maxDiff = max(maxDiff, abs(static_cast<int>((out8.pixels[i] >> c) & 0xff) - static_cast<int>((refPx >> c) & 0xff)));
+					}
+				}
+			}
+			bool ok = maxError < 1e-5f && maxDiff <= 1 && same;
+			printf("%-7s gaussian blur radius 1/3/17/64: max float error %.2g, max unorm8 diff %d, serial==4 threads %s: %s\n",
+				CpuIsaName(isa), maxError, maxDiff, same ? "yes" : "no", ok ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+	}
+
+	//オフスクリーンと同じ1280x720のR8G8B8A8で半径1～64
+	const auto src = makeImage(1280, 720);
+	const auto srcF = toFloat(src);
+	printf("1280x720, %u threads\n", executor.ThreadCount());
+	for (unsigned int radius : { 1u,2u,4u,8u,16u,32u,64u }) {
+		const auto sigma = GaussianSigmaForRadius(radius);
+		ImageRGBA32F ref;
+		auto refMs = MeasureMedianMs(0, 1, [&]() {GaussianBlurReference(srcF, ref, radius, sigma); });
+		printf("radius %2u: reference (float, 2 full passes) %8.2f ms\n", radius, refMs);
+		ImageRGBA8 dst;
+		ImageRGBA32F dstF;
+		for (auto isa : blur.Isas()) {
+			if (!blur.SelectExact(isa)) {
+				continue;
+			}
+			auto ms = MeasureMedianMs(1, 5, [&]() {GaussianBlur(src, dst, radius, sigma, &executor); });
+			auto msF = MeasureMedianMs(1, 5, [&]() {GaussianBlur(srcF, dstF, radius, sigma, &executor); });
+			printf("  %-7s R8G8B8A8 %8.2f ms (%6.1f Mpixel/s), float4 %8.2f ms\n", CpuIsaName(isa), ms, src.pixels.size() / (ms * 1000.0), msF);
+		}
+		registry.Reset();
+	}
+}
+
+void
+BenchmarkMedianFilter() {
+	auto& registry = KernelRegistry::Instance();
+	auto& median = *registry.Find("median");
+	auto& executor = ComputeExecutor::Instance();
+	//なめらかな模様に細かい雑音と、ごま塩状の雑音(取り除きたいもの)を乗せたもの
+	auto makeImage = [](unsigned int w, unsigned int h) {
+		ImageRGBA8 img(w, h);
+		uint32_t seed = 12345;
+		for (unsigned int y = 0; y < h; ++y) {
+			for (unsigned int x = 0; x < w; ++x) {
+				seed = seed * 1664525u + 1013904223u;
+				auto noise = (seed >> 24) & 0x1f;
+				uint32_t px = ((x * 255 / w + noise) & 0xff) | (((y * 255 / h + noise) & 0xff) << 8) | ((((x + y) & 0xff) ^ noise) << 16) | ((noise * 8) << 24);
+				if ((seed & 0xf0) == 0) {
+					px = (seed & 0x100) ? 0xffffffffu : 0u;
+				}
+				img.At(x, y) = px;
+			}
+		}
+		return img;
+	};
+
+	//ネットワーク(半径1/2):端数の出る大きさとベクトル幅より狭い画像で、実装ごとに基準実装と比べる
+	{
+		ComputeExecutor multi(4);
+		for (auto isa : median.Isas()) {
+			if (!median.SelectExact(isa)) {
+				continue;
+			}
+			bool ok = true;
+			for (auto size : { make_pair(333u, 201u), make_pair(5u, 3u), make_pair(17u, 1u) }) {
+				const auto src = makeImage(size.first, size.second);
+				for (unsigned int radius : { 1u,2u }) {
+					ImageRGBA8 ref, out, outMulti;
+					RankFilterReference(src, ref, radius, MedianRank(radius));
+					MedianFilter(src, out, radius, nullptr);
+					MedianFilter(src, outMulti, radius, &multi);
+					ok = ok && out.pixels == ref.pixels && outMulti.pixels == ref.pixels;
+				}
+			}
+			printf("%-7s median 3x3/5x5 network (333x201, 5x3, 17x1, serial/4 threads): %s\n", CpuIsaName(isa), ok ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+	}
+
+	//ヒストグラム:最小・中央・最大と途中の順位を、短冊・帯に分かれる大きさで比べる
+	{
+		ComputeExecutor multi(4);
+		bool ok = true;
+		const auto src = makeImage(333, 201);
+		for (unsigned int radius : { 1u,3u,9u }) {
+			const unsigned int n = (2 * radius + 1) * (2 * radius + 1);
+			for (unsigned int rank : { 0u, n / 5, MedianRank(radius), n - 1 }) {
+				ImageRGBA8 ref, out, outMulti;
+				RankFilterReference(src, ref, radius, rank);
+				RankFilter(src, out, radius, rank, nullptr);
+				RankFilter(src, outMulti, radius, rank, &multi);
+				ok = ok && out.pixels == ref.pixels && outMulti.pixels == ref.pixels;
+			}
+		}
+		//窓が画像より大きい場合
+		const auto small = makeImage(97, 61);
+		for (unsigned int radius : { 40u,maxMedianRadius }) {
+			ImageRGBA8 ref, out;
+			RankFilterReference(small, ref, radius, MedianRank(radius));
+			MedianFilter(small, out, radius, &multi);
+			ok = ok && out.pixels == ref.pixels;
+		}
+		printf("histogram rank filter radius 1/3/9 (rank min/20%%/median/max), 40/127 on 97x61: %s\n", ok ? "ok" : "MISMATCH");
+	}
+
+	const auto src = makeImage(1280, 720);
+	printf("1280x720, %u threads\n", executor.ThreadCount());
+	ImageRGBA8 dst;
+	for (unsigned int radius : { 1u,2u }) {
+		ImageRGBA8 ref;
+		auto refMs = MeasureMedianMs(0, 1, [&]() {RankFilterReference(src, ref, radius, MedianRank(radius)); });
+		printf("%ux%u median: reference (nth_element per pixel) %8.2f ms\n", 2 * radius + 1, 2 * radius + 1, refMs);
+		for (auto isa : median.Isas()) {
+			if (!median.SelectExact(isa)) {
+				continue;
+			}
+			auto ms = MeasureMedianMs(1, 5, [&]() {MedianFilter(src, dst, radius, &executor); });
+			printf("  %-7s network   %8.2f ms (%7.1f Mpixel/s)\n", CpuIsaName(isa), ms, src.pixels.size() / (ms * 1000.0));
+		}
+		registry.Reset();
+		auto ms = MeasureMedianMs(1, 5, [&]() {RankFilter(src, dst, radius, MedianRank(radius), &executor); });
+		printf("  histogram %8.2f ms (%7.1f Mpixel/s)\n", ms, src.pixels.size() / (ms * 1000.0));
+	}
+	for (unsigned int radius : { 4u,8u,16u,32u,64u,maxMedianRadius }) {
+		auto ms = MeasureMedianMs(1, 3, [&]() {MedianFilter(src, dst, radius, &executor); });
+		printf("radius %3u median: histogram %8.2f ms (%7.1f Mpixel/s)\n", radius, ms, src.pixels.size() / (ms * 1000.0));
+	}
+}
+
+void
+BenchmarkBoxFilter() {
+	auto& registry = KernelRegistry::Instance();
+	auto& satRow = *registry.Find("satrow8");
+	auto& boxMean = *registry.Find("boxmean8");
+	auto& boxColumns = *registry.Find("boxcols8");
+	auto& executor = ComputeExecutor::Instance();
+	//なめらかな模様に細かい雑音を乗せたもの
+	auto makeImage = [](unsigned int w, unsigned int h) {
+		ImageRGBA8 img(w, h);
+		uint32_t seed = 12345;
+		for (unsigned int y = 0; y < h; ++y) {
+			for (unsigned int x = 0; x < w; ++x) {
+				seed = seed * 1664525u + 1013904223u;
+				auto noise = (seed >> 24) & 0x3f;
+				img.At(x, y) = ((x * 255 / w + noise) & 0xff) | (((y * 255 / h + noise) & 0xff) << 8) | ((((x + y) & 0xff) ^ noise) << 16) | ((noise * 4) << 24);
+			}
+		}
+		return img;
+	};
+	//floatは0から離れた値にして、桁落ちしないことも確かめる
+	auto toFloat = [](const ImageRGBA8& src, float bias) {
+		ImageRGBA32F img(src.width, src.height);
+		for (size_t i = 0; i < src.pixels.size(); ++i) {
+			img.pixels[i] = UnpackUnorm4x8(src.pixels[i]) + bias;
+		}
+		return img;
+	};
+	auto maxError = [](const ImageRGBA32F& a, const ImageRGBA32F& b, float bias) {
+		float e = 0.0f;
+		for (size_t i = 0; i < a.pixels.size(); ++i) {
+			for (int c = 0; c < 4; ++c) {
+				e = max(e, fabs((a.pixels[i][c] - bias) - (b.pixels[i][c] - bias)));
+			}
+		}
+		return e;
+	};
+
+	//floatの画像はfloat4の==が成分ごとの比較になるので、中身を比べる
+	auto samePixels = [](const ImageRGBA32F& a, const ImageRGBA32F& b) {
+		return a.pixels.size() == b.pixels.size() && memcmp(a.pixels.data(), b.pixels.data(), a.pixels.size() * sizeof(hlsl::float4)) == 0;
+	};
+
+	//実装ごとに、端数の出る大きさ・ベクトル幅より狭い画像・窓が画像より大きい半径で基準実装と比べる
+	//R8G8B8A8の平均は丸めた値の差、平均と分散は誤差。テーブル版と列の和の版、1スレッドと4スレッドは同じ値になるはず
+	{
+		ComputeExecutor multi(4);
+		for (auto isa : satRow.Isas()) {
+			if (!satRow.SelectExact(isa) || !boxMean.SelectExact(isa) || !boxColumns.SelectExact(isa)) {
+				continue;
+			}
+			int maxDiff = 0;
+			float maxMeanError = 0.0f;
+			float maxVarianceError = 0.0f;
+			bool same = true;
+			for (auto size : { make_pair(333u, 201u), make_pair(5u, 3u), make_pair(17u, 1u) }) {
+				const auto src = makeImage(size.first, size.second);
+				const auto srcF = toFloat(src, 0.0f);
+				for (unsigned int radius : { 0u,1u,3u,17u,200u }) {
+					ImageRGBA32F refMean, refVariance;
+					BoxMeanVarianceReference(srcF, refMean, refVariance, radius);
+					SummedAreaTable8 table;
+					BuildSummedAreaTable(src, table, true, &multi);
+					SummedAreaTable8 serialTable;
+					BuildSummedAreaTable(src, serialTable, true, nullptr);
+					same = same && table.sums == serialTable.sums && table.squares == serialTable.squares;
+					ImageRGBA8 out, outColumns, outColumnsSerial;
+					BoxFilter(table, out, radius, &multi);
+					BoxFilter(src, outColumns, radius, &multi);
+					BoxFilter(src, outColumnsSerial, radius, nullptr);
+					same = same && out.pixels == outColumns.pixels && out.pixels == outColumnsSerial.pixels;
+					for (size_t i = 0; i < out.pixels.size(); ++i) {
+						auto refPx = PackUnorm4x8(refMean.pixels[i]);
+						for (int c = 0; c < 32; c += 8) {
+							maxDiff = max(maxDiff, abs(static_cast<int>((out.pixels[i] >> c) & 0xff) - static_cast<int>((refPx >> c) & 0xff)));
+						}
+					}
+					if (radius <= maxBoxVarianceRadius) {
+						ImageRGBA32F mean, variance, meanColumns, varianceColumns;
+						BoxMeanVariance(table, mean, variance, radius, &multi);
+						BoxMeanVariance(src, meanColumns, varianceColumns, radius, &multi);
+						same = same && samePixels(mean, meanColumns) && samePixels(variance, varianceColumns);
+						maxMeanError = max(maxMeanError, maxError(mean, refMean, 0.0f));
+						maxVarianceError = max(maxVarianceError, maxError(variance, refVariance, 0.0f));
+					}
+				}
+			}
+			bool ok = maxDiff <= 1 && maxMeanError < 1e-5f && maxVarianceError < 1e-5f && same;
+			printf("%-7s box R8G8B8A8 radius 0/1/3/17/200: max mean diff %d, mean/variance error %.2g/%.2g, table==columns==serial %s: %s\n",
+				CpuIsaName(isa), maxDiff, maxMeanError, maxVarianceError, same ? "yes" : "no", ok ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+
+		//floatは1000だけずらした値で(ずらさずに足すと、分散がfloatの精度では求まらない)
+		const float bias = 1000.0f;
+		float maxMeanError = 0.0f;
+		float maxVarianceError = 0.0f;
+		bool same = true;
+		for (auto size : { make_pair(333u, 201u), make_pair(17u, 1u) }) {
+			const auto srcF = toFloat(makeImage(size.first, size.second), bias);
+			for (unsigned int radius : { 0u,1u,3u,17u,200u }) {
+				ImageRGBA32F refMean, refVariance;
+				BoxMeanVarianceReference(srcF, refMean, refVariance, radius);
+				SummedAreaTableF table;
+				BuildSummedAreaTable(srcF, table, true, &multi);
+				ImageRGBA32F out, outColumns, mean, variance, meanColumns, varianceColumns;
+				BoxFilter(table, out, radius, &multi);
+				BoxFilter(srcF, outColumns, radius, nullptr);
+				BoxMeanVariance(table, mean, variance, radius, nullptr);
+				BoxMeanVariance(srcF, meanColumns, varianceColumns, radius, &multi);
+				same = same && samePixels(out, mean) && samePixels(outColumns, meanColumns);
+				for (auto* m : { &out, &outColumns, &mean, &meanColumns }) {
+					maxMeanError = max(maxMeanError, maxError(*m, refMean, bias));
+				}
+				for (auto* v : { &variance, &varianceColumns }) {
+					maxVarianceError = max(maxVarianceError, maxError(*v, refVariance, 0.0f));
+				}
+			}
+		}
+		//平均は1000前後のfloatなので、1ulp(6e-5)程度の差は出る
+		bool ok = maxMeanError < 2e-4f && maxVarianceError < 1e-5f && same;
+		printf("box float (+%.0f) radius 0/1/3/17/200: mean/variance error %.2g/%.2g: %s\n", bias, maxMeanError, maxVarianceError, ok ? "ok" : "MISMATCH");
+	}
+
+	//オフスクリーンと同じ1280x720で半径1～127。画素ごとの手間は半径によらないので、写すだけの時間と比べる
+	const auto src = makeImage(1280, 720);
+	const auto srcF = toFloat(src, 0.0f);
+	printf("1280x720, %u threads\n", executor.ThreadCount());
+	ImageRGBA8 copy(src.width, src.height);
+	auto copyMs = MeasureMedianMs(1, 9, [&]() {memcpy(copy.pixels.data(), src.pixels.data(), src.pixels.size() * sizeof(uint32_t)); });
+	printf("R8G8B8A8 copy (memcpy) %8.3f ms\n", copyMs);
+	ImageRGBA8 dst;
+	ImageRGBA32F dstF, mean, variance;
+	SummedAreaTable8 table;
+	for (unsigned int radius : { 1u,4u,16u,64u,maxBoxVarianceRadius }) {
+		printf("radius %3u:\n", radius);
+		for (auto isa : satRow.Isas()) {
+			if (!satRow.SelectExact(isa) || !boxMean.SelectExact(isa) || !boxColumns.SelectExact(isa)) {
+				continue;
+			}
+			auto buildMs = MeasureMedianMs(1, 5, [&]() {BuildSummedAreaTable(src, table, false, &executor); });
+			auto queryMs = MeasureMedianMs(1, 5, [&]() {BoxFilter(table, dst, radius, &executor); });
+			auto ringMs = MeasureMedianMs(1, 5, [&]() {BoxFilter(src, dst, radius, &executor); });
+			printf("  %-7s table build %7.3f ms + box %7.3f ms, column-sum box %7.3f ms (x%.1f of copy)\n",
+				CpuIsaName(isa), buildMs, queryMs, ringMs, ringMs / copyMs);
+		}
+		registry.Reset();
+		auto varianceMs = MeasureMedianMs(1, 3, [&]() {BoxMeanVariance(src, mean, variance, radius, &executor); });
+		auto floatMs = MeasureMedianMs(1, 3, [&]() {BoxFilter(srcF, dstF, radius, &executor); });
+		printf("  R8G8B8A8 mean+variance %7.3f ms, float4 box %7.3f ms\n", varianceMs, floatMs);
+	}
+}
+
+void
+BenchmarkResample() {
+	auto& registry = KernelRegistry::Instance();
+	KernelBase* kernels[] = { registry.Find("resample8in"), registry.Find("resampleh"), registry.Find("resamplev"), registry.Find("resample8out") };
+	auto selectExact = [&](CpuIsa isa) {
+		bool ok = true;
+		for (auto k : kernels) {
+			ok = k->SelectExact(isa) && ok;
+		}
+		return ok;
+	};
+	auto& executor = ComputeExecutor::Instance();
+	const ResampleFilter filters[] = { ResampleFilter::Bilinear, ResampleFilter::Bicubic, ResampleFilter::Lanczos3 };
+	const char* filterNames[] = { "bilinear", "bicubic", "lanczos3" };
+	//細かい模様(縮小で折り返しやすい)と、アルファが0～255で変わるもの。premultipliedなら色にアルファを掛けておく
+	auto makeImage = [](unsigned int w, unsigned int h, AlphaMode alpha) {
+		ImageRGBA8 img(w, h);
+		uint32_t seed = 12345;
+		for (unsigned int y = 0; y < h; ++y) {
+			for (unsigned int x = 0; x < w; ++x) {
+				seed = seed * 1664525u + 1013904223u;
+				uint32_t a = (x * 7 + y * 3) % 256 < 32 ? 0 : ((x + y * 2) * 255 / (w + h * 2) + (seed >> 28)) & 0xff;
+				uint32_t c[3] = { ((x ^ y) * 16) & 0xff, (seed >> 24) & 0xff, (x * 255 / w) & 0xff };
+				uint32_t px = a << 24;
+				for (int i = 0; i < 3; ++i) {
+					px |= (alpha == AlphaMode::Premultiplied ? (c[i] * a + 127) / 255 : c[i]) << (i * 8);
+				}
+				img.At(x, y) = px;
+			}
+		}
+		return img;
+	};
+	auto toFloat = [](const ImageRGBA8& src) {
+		ImageRGBA32F img(src.width, src.height);
+		for (size_t i = 0; i < src.pixels.size(); ++i) {
+			img.pixels[i] = UnpackUnorm4x8(src.pixels[i]);
+		}
+		return img;
+	};
+	//アルファが乗っていない色はアルファが小さいほど誤差が大きく見えるので、色はアルファが1/4以上の画素で比べる
+	auto colorCounts = [](AlphaMode alpha, float refAlpha) {
+		return alpha == AlphaMode::Premultiplied || refAlpha >= 0.25f;
+	};
+	//R8G8B8A8の乗算済みの出力は色をアルファ以下にする(Lanczosなどの行き過ぎで色がアルファを超えることがある)
+	auto expected8 = [](AlphaMode alpha, hlsl::float4 ref) {
+		if (alpha == AlphaMode::Premultiplied) {
+			for (int c = 0; c < 3; ++c) {
+				ref[c] = min(ref[c], hlsl::saturate(ref.w));
+			}
+		}
+		return PackUnorm4x8(ref);
+	};
+
+	//実装ごとに、縮小・拡大・等倍・1画素の画像で基準実装と比べる(R8G8B8A8は丸めた値の差)。実装の間では同じ値になるはず
+	{
+		const pair<unsigned int, unsigned int> sizes[][2] = {
+			{ { 333, 201 }, { 100, 67 } }, { { 333, 201 }, { 1000, 500 } }, { { 333, 201 }, { 333, 201 } },
+			{ { 333, 201 }, { 41, 199 } }, { { 7, 1 }, { 3, 5 } }, { { 1, 1 }, { 4, 4 } }, { { 5, 3 }, { 17, 1 } },
+		};
+		ComputeExecutor multi(4);
+		vector<ImageRGBA8> scalarOut;
+		for (auto isa : kernels[1]->Isas()) {
+			if (!selectExact(isa)) {
+				continue;
+			}
+			int maxDiff = 0;
+			bool same = true;
+			size_t index = 0;
+			for (auto alpha : { AlphaMode::Straight, AlphaMode::Premultiplied }) {
+				for (auto& size : sizes) {
+					const auto src = makeImage(size[0].first, size[0].second, alpha);
+					const auto srcF = toFloat(src);
+					for (auto filter : filters) {
+						ImageRGBA32F ref;
+						ResampleReference(srcF, ref, size[1].first, size[1].second, filter, alpha);
+						ImageRGBA8 out, outMulti;
+						Resample(src, out, size[1].first, size[1].second, filter, alpha, nullptr);
+						Resample(src, outMulti, size[1].first, size[1].second, filter, alpha, &multi);
+						same = same && out.pixels == outMulti.pixels;
+						if (isa == CpuIsa::Scalar) {
+							scalarOut.push_back(out);
+						}
+						else {
+							same = same && out.pixels == scalarOut[index].pixels;
+						}
+						++index;
+						for (size_t i = 0; i < ref.pixels.size(); ++i) {
+							auto refPx = expected8(alpha, ref.pixels[i]);
+							for (int c = colorCounts(alpha, ref.pixels[i].w) ? 0 : 24; c < 32; c += 8) {
+								maxDiff = max(maxDiff, abs(static_cast<int>((out.pixels[i] >> c) & 0xff) - static_cast<int>((refPx >> c) & 0xff)));
+							}
+						}
+					}
+				}
+			}
+			bool ok = maxDiff <= 1 && same;
+			printf("%-7s resample R8G8B8A8 (down/up/same/odd sizes, 3 filters, straight/premultiplied): max diff %d, same as scalar/4 threads %s: %s\n",
+				CpuIsaName(isa), maxDiff, same ? "yes" : "no", ok ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+
+		float maxError = 0.0f;
+		for (auto alpha : { AlphaMode::Straight, AlphaMode::Premultiplied }) {
+			for (auto& size : sizes) {
+				const auto srcF = toFloat(makeImage(size[0].first, size[0].second, alpha));
+				for (auto filter : filters) {
+					ImageRGBA32F ref, out;
+					ResampleReference(srcF, ref, size[1].first, size[1].second, filter, alpha);
+					Resample(srcF, out, size[1].first, size[1].second, filter, alpha, &multi);
+					for (size_t i = 0; i < ref.pixels.size(); ++i) {
+						for (int c = colorCounts(alpha, ref.pixels[i].w) ? 0 : 3; c < 4; ++c) {
+							maxError = max(maxError, fabs(out.pixels[i][c] - ref.pixels[i][c]));
+						}
+					}
+				}
+			}
+		}
+		printf("resample float: max error %.2g: %s\n", maxError, maxError < 1e-5f ? "ok" : "MISMATCH");
+	}
+
+	//4K(3840x2160)→720p。比べるのは出力の画素ごとに窓の全画素を読む素朴なループ(基準実装)
+	const auto src = makeImage(3840, 2160, AlphaMode::Straight);
+	const auto srcF = toFloat(src);
+	printf("3840x2160 -> 1280x720, straight alpha, %u threads\n", executor.ThreadCount());
+	ImageRGBA8 dst;
+	ImageRGBA32F dstF;
+	for (size_t f = 0; f < 3; ++f) {
+		ImageRGBA32F ref;
+		auto refMs = MeasureMedianMs(0, 1, [&]() {ResampleReference(srcF, ref, 1280, 720, filters[f], AlphaMode::Straight); });
+		printf("%-8s (%2u taps): per-pixel loop (reference) %8.1f ms\n", filterNames[f], MakeResampleAxis(3840, 1280, filters[f]).taps, refMs);
+		for (auto isa : kernels[1]->Isas()) {
+			if (!selectExact(isa)) {
+				continue;
+			}
+			auto ms = MeasureMedianMs(1, 5, [&]() {Resample(src, dst, 1280, 720, filters[f], AlphaMode::Straight, &executor); });
+			printf("  %-7s R8G8B8A8 %7.2f ms (x%.0f)\n", CpuIsaName(isa), ms, refMs / ms);
+		}
+		registry.Reset();
+		auto msF = MeasureMedianMs(1, 3, [&]() {Resample(srcF, dstF, 1280, 720, filters[f], AlphaMode::Straight, &executor); });
+		printf("  float4   %7.2f ms (x%.0f)\n", msF, refMs / msF);
+	}
+	//720p→1080p(拡大)
+	const auto small = makeImage(1280, 720, AlphaMode::Straight);
+	printf("1280x720 -> 1920x1080\n");
+	for (size_t f = 0; f < 3; ++f) {
+		auto ms = MeasureMedianMs(1, 5, [&]() {Resample(small, dst, 1920, 1080, filters[f], AlphaMode::Straight, &executor); });
+		printf("  %-8s R8G8B8A8 %7.2f ms\n", filterNames[f], ms);
+	}
+}
+
+void
+BenchmarkColorLut() {
+	auto& registry = KernelRegistry::Instance();
+	KernelBase* kernel = registry.Find("lut3d8");
+	auto& executor = ComputeExecutor::Instance();
+	//よくある色調整の並び(暗部を持ち上げるガンマ→コントラスト→暖色→S字のトーンカーブ)と、灰色化してセピアにする並び
+	const vector<hlsl::float2> sCurve = { { 0.0f, 0.0f }, { 0.25f, 0.18f }, { 0.5f, 0.5f }, { 0.75f, 0.84f }, { 1.0f, 1.0f } };
+	ColorTransform grade;
+	grade.Gamma(2.2f).Contrast(1.2f).Tint(hlsl::float3(1.08f, 1.0f, 0.86f)).Curve(sCurve);
+	ColorTransform sepia;
+	sepia.Grayscale().Gamma(0.8f).Tint(hlsl::float3(1.07f, 0.74f, 0.43f)).Curve(sCurve);
+	const pair<const char*, const ColorTransform*> chains[] = { { "grade", &grade }, { "sepia", &sepia } };
+	const LutShaper shapers[] = { LutShaper::Linear, LutShaper::Sqrt };
+	const char* shaperNames[] = { "linear", "sqrt" };
+	auto maxDiff8 = [](const ImageRGBA8& a, const ImageRGBA8& b) {
+		int diff = 0;
+		for (size_t i = 0; i < a.pixels.size(); ++i) {
+			for (int c = 0; c < 32; c += 8) {
+				diff = max(diff, abs(static_cast<int>((a.pixels[i] >> c) & 0xff) - static_cast<int>((b.pixels[i] >> c) & 0xff)));
+			}
+		}
+		return diff;
+	};
+
+	//R8G8B8A8の全2^24色(4096x4096、アルファはいろいろ)で、変換を直接計算したものと比べる。実装の間では同じ値になるはず
+	{
+		ImageRGBA8 all(4096, 4096);
+		for (uint32_t i = 0; i < all.pixels.size(); ++i) {
+			all.pixels[i] = i | ((i * 2654435761u) & 0xff000000);
+		}
+		ComputeExecutor multi(4);
+		for (auto& chain : chains) {
+			ImageRGBA8 direct;
+			ApplyColorTransform(*chain.second, all, direct, &executor);
+			for (unsigned int size : { 17u, 33u, 65u }) {
+				for (size_t s = 0; s < 2; ++s) {
+					const auto lut = BakeColorLut(*chain.second, size, shapers[s], &executor);
+					ImageRGBA8 scalarOut;
+					bool same = true;
+					for (auto isa : kernel->Isas()) {
+						if (!kernel->SelectExact(isa)) {
+							continue;
+						}
+						ImageRGBA8 out;
+						ApplyColorLut(lut, all, out, &multi);
+						if (isa == CpuIsa::Scalar) {
+							scalarOut = move(out);
+						}
+						else {
+							same = same && out.pixels == scalarOut.pixels;
+						}
+					}
+					registry.Reset();
+					const int diff = maxDiff8(scalarOut, direct);
+					const bool ok = same && diff <= ColorLutErrorBound8(size);
+					printf("%s %2u^3 %-6s: max diff %d LSB (bound %d) over all 2^24 colors, ISAs agree %s: %s\n",
+						chain.first, size, shaperNames[s], diff, ColorLutErrorBound8(size), same ? "yes" : "no", ok ? "ok" : "MISMATCH");
+				}
+			}
+		}
+	}
+
+	//floatは格子の間の誤差だけ(33^3、sqrt)
+	{
+		ImageRGBA32F img(1024, 1024);
+		uint32_t seed = 12345;
+		for (auto& px : img.pixels) {
+			seed = seed * 1664525u + 1013904223u;
+			px = hlsl::float4((seed >> 8 & 0xff) / 255.0f, (seed >> 16 & 0xff) / 255.0f, (seed >> 24) / 255.0f, 0.5f) * 1.1f - 0.05f;
+		}
+		ImageRGBA32F direct, out;
+		ApplyColorTransform(grade, img, direct, &executor);
+		ApplyColorLut(BakeColorLut(grade, 33, LutShaper::Sqrt, &executor), img, out, &executor);
+		float maxError = 0.0f;
+		for (size_t i = 0; i < img.pixels.size(); ++i) {
+			for (int c = 0; c < 4; ++c) {
+				maxError = max(maxError, fabs(out.pixels[i][c] - direct.pixels[i][c]));
+			}
+		}
+		printf("grade 33^3 sqrt float: max error %.4f (%.2f LSB): %s\n", maxError, maxError * 255.0f, maxError * 255.0f <= 2.0f ? "ok" : "MISMATCH");
+	}
+
+	//1280x720で、変換ごとに画像全体を読み書きする場合・画素ごとに並び全体を計算する場合・LUTを比べる
+	ImageRGBA8 src(1280, 720);
+	uint32_t seed = 1;
+	for (auto& px : src.pixels) {
+		seed = seed * 1664525u + 1013904223u;
+		px = seed;
+	}
+	printf("1280x720 R8G8B8A8, grade (%zu ops), %u threads\n", grade.Size(), executor.ThreadCount());
+	vector<ColorTransform> passes(grade.Size());
+	for (size_t k = 0; k < passes.size(); ++k) {
+		passes[k].Custom([&grade, k](const hlsl::float3& c) {return grade.EvaluateOp(k, c); });
+	}
+	ImageRGBA8 dst;
+	auto passMs = MeasureMedianMs(1, 3, [&]() {
+		ApplyColorTransform(passes[0], src, dst, &executor);
+		for (size_t k = 1; k < passes.size(); ++k) {
+			ApplyColorTransform(passes[k], dst, dst, &executor);
+		}
+	});
+	printf("  one pass per op       %7.2f ms\n", passMs);
+	auto directMs = MeasureMedianMs(1, 3, [&]() {ApplyColorTransform(grade, src, dst, &executor); });
+	printf("  whole chain per pixel %7.2f ms (x%.1f)\n", directMs, passMs / directMs);
+	for (unsigned int size : { 17u, 33u, 65u }) {
+		ColorLut lut;
+		auto bakeMs = MeasureMedianMs(1, 3, [&]() {lut = BakeColorLut(grade, size, LutShaper::Sqrt, &executor); });
+		printf("  %2u^3 lut: bake %6.2f ms\n", size, bakeMs);
+		for (auto isa : kernel->Isas()) {
+			if (!kernel->SelectExact(isa)) {
+				continue;
+			}
+			auto ms = MeasureMedianMs(2, 9, [&]() {ApplyColorLut(lut, src, dst, &executor); });
+			printf("    %-7s apply %6.2f ms (x%.0f)\n", CpuIsaName(isa), ms, passMs / ms);
+		}
+		registry.Reset();
+	}
+}
+
+void
+BenchmarkFilterGraph() {
+	auto& executor = ComputeExecutor::Instance();
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	ImageRGBA8 src(width, height);
+	uint32_t seed = 7;
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			seed = seed * 1664525u + 1013904223u;
+			//なめらかな模様に少しノイズを乗せる
+			const uint32_t noise = seed >> 29;
+			src.At(x, y) = (min(255u, (x * 255 / width) + noise)) | (min(255u, (y * 255 / height) + noise) << 8) | ((((x ^ y) >> 3) & 0x7f) << 16) | 0xff000000u;
+		}
+	}
+	ImageRGBA32F srcF;
+	srcF.width = width;
+	srcF.height = height;
+	for (auto px : src.pixels) {
+		srcF.pixels.push_back(UnpackUnorm4x8(px));
+	}
+
+	//コントラスト→色味のあと、ぼかしたものと半分の大きさでぼかしたものを足してガンマをかける
+	//(使われないノードも1つ入れておく)
+	const hlsl::float3 tint(1.05f, 1.0f, 0.9f);
+	FilterGraph graph(width, height);
+	auto graded = graph.Tint(graph.Contrast(graph.Source(), 1.15f), tint);
+	graph.BoxMean(graph.Source(), 3);
+	auto glow = graph.GaussianBlur(graded, 8, 4.0f);
+	auto half = graph.BoxMean(graph.Resample(graded, width / 2, height / 2, ResampleFilter::Bilinear), 4);
+	auto halfUp = graph.Resample(half, width, height, ResampleFilter::Bilinear);
+	auto out = graph.Gamma(graph.Add(graph.Add(graded, glow, 0.5f), halfUp, 0.25f), 1.2f);
+	graph.SetOutput(graph.Median(out, 1));
+
+	//基準:ノードごとに既存の関数を画像全体にかける
+	ImageRGBA32F expected;
+	{
+		ColorTransform grade;
+		grade.Contrast(1.15f).Tint(tint);
+		ImageRGBA32F gradedImg, glowImg, halfImg, halfBox, halfUpImg, sum, gamma;
+		ApplyColorTransform(grade, srcF, gradedImg, nullptr);
+		GaussianBlur(gradedImg, glowImg, 8, 4.0f, nullptr);
+		Resample(gradedImg, halfImg, width / 2, height / 2, ResampleFilter::Bilinear, AlphaMode::Premultiplied, nullptr);
+		BoxFilter(halfImg, halfBox, 4, nullptr);
+		Resample(halfBox, halfUpImg, width, height, ResampleFilter::Bilinear, AlphaMode::Premultiplied, nullptr);
+		sum = gradedImg;
+		for (size_t i = 0; i < sum.pixels.size(); ++i) {
+			auto& c = sum.pixels[i];
+			c.rgb = c.rgb + glowImg.pixels[i].rgb * hlsl::float3(0.5f);
+			c.rgb = c.rgb + halfUpImg.pixels[i].rgb * hlsl::float3(0.25f);
+		}
+		ColorTransform gammaOnly;
+		gammaOnly.Gamma(1.2f);
+		ApplyColorTransform(gammaOnly, sum, gamma, nullptr);
+		ImageRGBA8 gamma8, median8;
+		gamma8.width = width;
+		gamma8.height = height;
+		for (auto& px : gamma.pixels) {
+			gamma8.pixels.push_back(PackUnorm4x8(px));
+		}
+		MedianFilter(gamma8, median8, 1, nullptr);
+		expected.width = width;
+		expected.height = height;
+		for (auto px : median8.pixels) {
+			expected.pixels.push_back(UnpackUnorm4x8(px));
+		}
+	}
+	auto samePixels = [](const ImageRGBA32F& a, const ImageRGBA32F& b) {
+		return a.pixels.size() == b.pixels.size() && memcmp(a.pixels.data(), b.pixels.data(), a.pixels.size() * sizeof(hlsl::float4)) == 0;
+	};
+	ImageRGBA8 expected8;
+	expected8.width = width;
+	expected8.height = height;
+	for (auto& px : expected.pixels) {
+		expected8.pixels.push_back(PackUnorm4x8(px));
+	}
+
+	//まとめる・使い回すの組み合わせ、floatとR8G8B8A8、1スレッドと4スレッドで同じ結果になるはず
+	{
+		ComputeExecutor multi(4);
+		const FilterCompileOptions optionList[] = { { true, true }, { false, true }, { true, false }, { false, false } };
+		for (auto& options : optionList) {
+			CpuFilterGraphRunner runner(graph, options);
+			ImageRGBA32F outF, outMulti;
+			ImageRGBA8 out8;
+			runner.Run(srcF, outF, nullptr);
+			runner.Run(srcF, outMulti, &multi);
+			runner.Run(src, out8, &multi);
+			const bool ok = samePixels(outF, expected) && samePixels(outMulti, expected) && out8.pixels == expected8.pixels;
+			const auto& plan = runner.Plan();
+			printf("fuse %-3s pool %-3s: %u live nodes -> %zu passes, %zu targets (%u without pooling, %.1f MB): %s\n",
+				options.fusePointwise ? "on" : "off", options.poolTargets ? "on" : "off", plan.liveNodes, plan.passes.size(),
+				plan.targets.size(), plan.unpooledTargets, runner.TargetBytes() / 1048576.0, ok ? "ok" : "MISMATCH");
+		}
+	}
+
+	//点ごとの処理だけの連鎖(まとめれば1回の読み書きで済む)と、上のグラフの処理時間
+	FilterGraph pointwise(width, height);
+	{
+		auto c = pointwise.Contrast(pointwise.Source(), 1.1f);
+		c = pointwise.Tint(c, tint);
+		c = pointwise.Add(c, pointwise.Source(), 0.1f);
+		c = pointwise.Contrast(c, 0.95f);
+		c = pointwise.Tint(c, hlsl::float3(0.98f, 1.0f, 1.02f));
+		pointwise.Mono(c);
+	}
+	printf("1280x720 R8G8B8A8, %u threads\n", executor.ThreadCount());
+	const pair<const char*, const FilterGraph*> graphs[] = { { "6 pointwise ops", &pointwise }, { "grade+glow+half-res box+median", &graph } };
+	for (auto& g : graphs) {
+		CpuFilterGraphRunner fused(*g.second);
+		CpuFilterGraphRunner unfused(*g.second, { false, false });
+		ImageRGBA8 dst;
+		auto unfusedMs = MeasureMedianMs(1, 5, [&]() {unfused.Run(src, dst, &executor); });
+		auto fusedMs = MeasureMedianMs(1, 5, [&]() {fused.Run(src, dst, &executor); });
+		printf("  %-30s: one pass per node %7.2f ms (%zu passes, %4.1f MB targets), fused+pooled %7.2f ms (%zu passes, %4.1f MB targets) x%.2f\n",
+			g.first, unfusedMs, unfused.Plan().passes.size(), unfused.TargetBytes() / 1048576.0,
+			fusedMs, fused.Plan().passes.size(), fused.TargetBytes() / 1048576.0, unfusedMs / fusedMs);
+	}
+}
+
+void
+BenchmarkBloom() {
+	auto& executor = ComputeExecutor::Instance();
+	//HDRの画像:暗めのなめらかな模様に、しきい値を大きく超える明るい点を散らしたもの
+	auto makeImage = [](unsigned int w, unsigned int h) {
+		ImageRGBA32F img(w, h);
+		uint32_t seed = 99;
+		for (unsigned int y = 0; y < h; ++y) {
+			for (unsigned int x = 0; x < w; ++x) {
+				seed = seed * 1664525u + 1013904223u;
+				const float noise = (seed >> 24) / 2048.0f;
+				hlsl::float4 c(0.6f * x / w + noise, 0.5f * y / h + noise, 0.3f + noise, 1.0f);
+				if ((seed >> 8) % 509 == 0) {
+					c = hlsl::float4(8.0f, 6.0f, 4.0f, 1.0f);
+				}
+				img.At(x, y) = c;
+			}
+		}
+		return img;
+	};
+	auto maxError = [](const ImageRGBA32F& a, const ImageRGBA32F& b) {
+		float e = 0.0f;
+		for (size_t i = 0; i < a.pixels.size(); ++i) {
+			for (int c = 0; c < 4; ++c) {
+				e = max(e, fabs(a.pixels[i][c] - b.pixels[i][c]) / max(1.0f, fabs(b.pixels[i][c])));
+			}
+		}
+		return e;
+	};
+
+	//段ごとに分けた実装と、13か所・3x3か所を双線形で読む基準実装が合うこと(大きさが奇数のときも)
+	{
+		ComputeExecutor multi(4);
+		const unsigned int sizes[][2] = { { 256, 160 }, { 197, 123 }, { 64, 9 } };
+		for (auto& size : sizes) {
+			const auto src = makeImage(size[0], size[1]);
+			BloomSettings settings;
+			settings.threshold = 0.8f;
+			settings.knee = 0.4f;
+			settings.intensity = 0.7f;
+			ImageRGBA32F expected, single, parallel;
+			BloomReference(src, expected, settings);
+			BloomFilter bloom(size[0], size[1], settings.levels);
+			bloom.Apply(src, single, settings, nullptr);
+			bloom.Apply(src, parallel, settings, &multi);
+			const float e = maxError(single, expected);
+			const bool same = single.pixels.size() == parallel.pixels.size() && memcmp(single.pixels.data(), parallel.pixels.data(), single.pixels.size() * sizeof(hlsl::float4)) == 0;
+			printf("%ux%u, %u levels: max relative error %.2e vs bilinear reference, 4 threads identical %s: %s\n",
+				size[0], size[1], bloom.LevelCount(), e, same ? "yes" : "no", e < 1e-5f && same ? "ok" : "MISMATCH");
+		}
+	}
+	//フィルタグラフのノードとしても同じ結果になること
+	{
+		const auto src = makeImage(320, 180);
+		BloomSettings settings;
+		FilterGraph graph(320, 180);
+		graph.Bloom(graph.Source(), settings);
+		CpuFilterGraphRunner runner(graph);
+		ImageRGBA32F viaGraph, direct;
+		runner.Run(src, viaGraph, nullptr);
+		BloomFilter bloom(320, 180, settings.levels);
+		bloom.Apply(src, direct, settings, nullptr);
+		const bool same = memcmp(viaGraph.pixels.data(), direct.pixels.data(), direct.pixels.size() * sizeof(hlsl::float4)) == 0;
+		printf("filter graph Bloom node: %s\n", same ? "ok" : "MISMATCH");
+	}
+
+	//1280x720での段ごとの時間と、モノクロ化(MonoCSのCPU版)・全画面の大きな半径のぼかしとの比較
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	const auto src = makeImage(width, height);
+	BloomSettings settings;
+	BloomFilter bloom(width, height, settings.levels);
+	ImageRGBA32F dst;
+	bloom.Apply(src, dst, settings, &executor);
+	printf("1280x720 RGBA32F, %u levels (%.1f MB of level images, allocated once), %u threads\n",
+		bloom.LevelCount(), bloom.LevelBytes() / 1048576.0, executor.ThreadCount());
+	struct Stage {
+		string name;
+		unsigned int width, height;
+		double ms;
+	};
+	vector<Stage> stages;
+	auto measure = [&](const string& name, unsigned int w, unsigned int h, const function<void()>& func) {
+		stages.push_back({ name, w, h, MeasureMedianMs(2, 9, func) });
+	};
+	measure("prefilter -> level 0", bloom.Level(0).width, bloom.Level(0).height, [&]() {bloom.Prefilter(src, settings.threshold, settings.knee, &executor); });
+	for (unsigned int l = 1; l < bloom.LevelCount(); ++l) {
+		measure("downsample -> level " + to_string(l), bloom.Level(l).width, bloom.Level(l).height, [&]() {bloom.Downsample(l, &executor); });
+	}
+	for (auto l = bloom.LevelCount() - 1; l-- > 0;) {
+		measure("upsample -> level " + to_string(l), bloom.Level(l).width, bloom.Level(l).height, [&]() {bloom.Upsample(l, &executor); });
+	}
+	measure("composite", width, height, [&]() {bloom.Composite(src, dst, settings.intensity, &executor); });
+	double total = 0.0;
+	for (auto& s : stages) {
+		total += s.ms;
+	}
+	for (auto& s : stages) {
+		printf("  %-22s %4ux%-4u %7.3f ms (%4.1f%%)\n", s.name.c_str(), s.width, s.height, s.ms, 100.0 * s.ms / total);
+	}
+	auto applyMs = MeasureMedianMs(1, 7, [&]() {bloom.Apply(src, dst, settings, &executor); });
+	ImageRGBA8 src8(width, height), mono8;
+	for (size_t i = 0; i < src.pixels.size(); ++i) {
+		src8.pixels[i] = PackUnorm4x8(src.pixels[i]);
+	}
+	auto monoMs = MeasureMedianMs(3, 21, [&]() {MonoFilter(src8, mono8, &executor); });
+	//いちばん小さい段の1画素は入力の2^levels画素にあたるので、同じくらい広がるぼかし(半径64)と比べる
+	ImageRGBA32F blurred;
+	auto blurMs = MeasureMedianMs(0, 3, [&]() {GaussianBlur(src, blurred, maxGaussianRadius, GaussianSigmaForRadius(maxGaussianRadius), &executor); });
+	printf("  sum of stages %.2f ms, Apply %.2f ms = %.1fx the mono filter (%.2f ms, R8G8B8A8); full-res radius %u blur %.2f ms (x%.1f)\n",
+		total, applyMs, applyMs / monoMs, monoMs, maxGaussianRadius, blurMs, blurMs / applyMs);
+}
+
+void
+BenchmarkToneMap() {
+	auto& registry = KernelRegistry::Instance();
+	auto& lumaF = *registry.Find("lumaf");
+	auto& executor = ComputeExecutor::Instance();
+	//HDRの画像:空(0.5～40)・影(0.01～0.1)・人物くらいの明るさ(0.1～1)に、とても明るい点と黒・NaNの画素を混ぜたもの
+	auto makeImage = [](unsigned int w, unsigned int h, float scale) {
+		ImageRGBA32F img(w, h);
+		uint32_t seed = 777;
+		for (unsigned int y = 0; y < h; ++y) {
+			for (unsigned int x = 0; x < w; ++x) {
+				seed = seed * 1664525u + 1013904223u;
+				const float noise = 1.0f + (seed >> 24) / 512.0f;
+				float v;
+				if (y < h / 3) {
+					v = 0.5f * exp2(6.3f * x / w);
+				}
+				else if (x < w / 4) {
+					v = 0.01f * exp2(3.3f * y / h);
+				}
+				else {
+					v = 0.1f + 0.9f * (x + y) / (w + h);
+				}
+				v *= noise * scale;
+				hlsl::float4 c(v, 0.9f * v, 0.7f * v, 1.0f);
+				if ((seed >> 8) % 997 == 0) {
+					c = hlsl::float4(200.0f, 180.0f, 150.0f, 1.0f) * scale;
+				}
+				else if ((seed >> 8) % 997 == 1) {
+					c = hlsl::float4(0.0f, 0.0f, 0.0f, 1.0f);
+				}
+				img.At(x, y) = c;
+			}
+		}
+		img.pixels[5] = hlsl::float4(NAN, 0.0f, 0.0f, 1.0f);
+		return img;
+	};
+	ToneMapSettings settings;
+	const auto range = ToneMapHistogramRange(settings);
+	const float binWidth = (settings.maxLog2 - settings.minLog2) / 256.0f;
+
+	//ヒストグラム:log2の階級でも実装ごとに基準実装と同じ階級に数えること
+	{
+		const auto src = makeImage(1283, 719, 1.0f);
+		LumaStats refStats;
+		LumaHistogram refHist;
+		ReduceLumaReference(src, range, refStats, refHist);
+		for (auto isa : lumaF.Isas()) {
+			if (!lumaF.SelectExact(isa)) {
+				continue;
+			}
+			LumaStats stats;
+			LumaHistogram hist;
+			ReduceLuma(src, range, stats, &hist, &executor);
+			//輝度の積和の順序で階級の境目の画素がずれることがあるので、数画素の違いまで許す
+			uint64_t histDiff = 0;
+			for (int b = 0; b < 256; ++b) {
+				histDiff += abs(static_cast<long long>(hist.bins[b]) - static_cast<long long>(refHist.bins[b]));
+			}
+			printf("%-7s log2 histogram 1283x719: bin 0 %u px, bin 255 %u px, diff %llu px: %s\n", CpuIsaName(isa),
+				hist.bins[0], hist.bins[255], static_cast<unsigned long long>(histDiff), hist.Total() == refHist.Total() && histDiff <= 8 ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+
+		//露出の目標:正しいlog2で並べ替えて求めた平均との差は、階級の幅の半分とApproxLog2の誤差(0.086)まで
+		auto target = ExposureTargetLog2(refHist, settings);
+		auto exact = ExposureTargetLog2Reference(src, settings);
+		const double bound = binWidth * 0.5 + 0.0861;
+		printf("exposure target %.4f EV (sorted exact log2 %.4f EV, diff %.4f <= %.4f): %s\n",
+			target, exact, fabs(target - exact), bound, fabs(target - exact) <= bound ? "ok" : "MISMATCH");
+	}
+
+	//なじませ方:4EV明るくして、目標まで0.1EV以内になるまでのフレーム数(行き過ぎないこと)と、戻したとき
+	{
+		const auto dark = makeImage(320, 180, 1.0f);
+		const auto bright = makeImage(320, 180, 16.0f);
+		AutoExposure exposure;
+		ImageRGBA32F out;
+		exposure.Apply(dark, out, settings, nullptr);
+		const float darkLog2 = exposure.AdaptedLog2();
+		auto framesToSettle = [&](const ImageRGBA32F& img, bool& monotonic) {
+			monotonic = true;
+			float previous = exposure.AdaptedLog2();
+			for (int frame = 1; frame <= 1000; ++frame) {
+				exposure.Apply(img, out, settings, nullptr);
+				const float target = ExposureTargetLog2(exposure.Histogram(), settings);
+				const float now = exposure.AdaptedLog2();
+				//目標の側に進むだけで、越えない
+				if ((now - previous) * (target - previous) < 0.0f || fabs(target - now) > fabs(target - previous)) {
+					monotonic = false;
+				}
+				previous = now;
+				if (fabs(target - now) < 0.1f) {
+					return frame;
+				}
+			}
+			return -1;
+		};
+		bool upMonotonic, downMonotonic;
+		const int up = framesToSettle(bright, upMonotonic);
+		const float brightLog2 = exposure.AdaptedLog2();
+		const int down = framesToSettle(dark, downMonotonic);
+		printf("adaptation %.2f -> %.2f EV: %d frames (%.2f s at 60 fps), back: %d frames (%.2f s), no overshoot: %s\n",
+			darkLog2, brightLog2, up, up / 60.0, down, down / 60.0, up > 0 && down > up && upMonotonic && downMonotonic ? "ok" : "MISMATCH");
+	}
+
+	//トーンマップ:カーブの表で引いたものとシェーダと同じ式との差(8bitにしたときに変わる画素の数)、
+	//並列でも同じになること、明るさの順が変わらないこと、白の点が1になること
+	const ToneMapCurve curve(settings.whitePoint);
+	{
+		ComputeExecutor multi(4);
+		//暗いところから白の点より明るいところまで、2^-20～2^5を細かく並べる
+		ImageRGBA32F ramp(4096, 64), expected, single, parallel;
+		for (unsigned int i = 0; i < ramp.pixels.size(); ++i) {
+			ramp.pixels[i] = hlsl::float4(exp2(-20.0f + 25.0f * i / ramp.pixels.size()));
+		}
+		ramp.pixels[0] = hlsl::float4(0.0f);
+		ramp.pixels[1] = hlsl::float4(-1.0f);
+		ramp.pixels[2] = hlsl::float4(NAN);
+		ToneMapReference(ramp, expected, 1.0f, settings.whitePoint);
+		ToneMap(ramp, single, 1.0f, curve, nullptr);
+		ToneMap(ramp, parallel, 1.0f, curve, &multi);
+		float maxError = 0.0f;
+		size_t changed8 = 0;
+		bool monotonic = true;
+		for (size_t i = 0; i < ramp.pixels.size(); ++i) {
+			maxError = max(maxError, fabs(single.pixels[i].x - expected.pixels[i].x));
+			changed8 += PackUnorm4x8(single.pixels[i]) != PackUnorm4x8(expected.pixels[i]);
+			monotonic = monotonic && (i < 4 || single.pixels[i].x >= single.pixels[i - 1].x);
+		}
+		const bool same = memcmp(single.pixels.data(), parallel.pixels.data(), single.pixels.size() * sizeof(hlsl::float4)) == 0;
+		ImageRGBA32F white(1, 1), whiteOut;
+		white.pixels[0] = hlsl::float4(settings.whitePoint);
+		ToneMap(white, whiteOut, 1.0f, curve, nullptr);
+		printf("tone map curve (%u ramp values): max error %.2e vs exact, %zu differ in 8 bits, 4 threads identical %s, monotonic %s, white point -> %.6f: %s\n",
+			static_cast<unsigned int>(ramp.pixels.size()), maxError, changed8, same ? "yes" : "no", monotonic ? "yes" : "no", whiteOut.pixels[0].x,
+			maxError < 1e-4f && same && monotonic && fabs(whiteOut.pixels[0].x - 1.0f) < 1e-5f && single.pixels[2].x == 0.0f ? "ok" : "MISMATCH");
+	}
+	//フィルタグラフのノードとしても、フレームをまたいで同じ結果になること
+	{
+		const auto src = makeImage(320, 180, 1.0f);
+		const auto bright = makeImage(320, 180, 8.0f);
+		FilterGraph graph(320, 180);
+		graph.ToneMap(graph.Source(), settings);
+		CpuFilterGraphRunner runner(graph);
+		AutoExposure direct;
+		ImageRGBA32F viaGraph, expected;
+		bool same = true;
+		for (int frame = 0; frame < 4; ++frame) {
+			const auto& img = frame < 2 ? src : bright;
+			runner.Run(img, viaGraph, nullptr);
+			direct.Apply(img, expected, settings, nullptr);
+			same = same && memcmp(viaGraph.pixels.data(), expected.pixels.data(), expected.pixels.size() * sizeof(hlsl::float4)) == 0;
+		}
+		printf("filter graph ToneMap node (4 frames): %s\n", same ? "ok" : "MISMATCH");
+	}
+
+	//1280x720での段ごとの時間(1フレームの予算16.7msに対する割合)と、モノクロ化(MonoCSのCPU版)との比較
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	const auto src = makeImage(width, height, 1.0f);
+	AutoExposure exposure;
+	ImageRGBA32F dst;
+	exposure.Apply(src, dst, settings, &executor);
+	const double frameMs = 1000.0 / 60.0;
+	auto histogramMs = MeasureMedianMs(2, 11, [&]() {exposure.Measure(src, settings, &executor); });
+	auto adaptMs = MeasureMedianMs(2, 11, [&]() {exposure.Adapt(settings); });
+	auto toneMapMs = MeasureMedianMs(2, 11, [&]() {ToneMap(src, dst, exposure.Exposure(), curve, &executor); });
+	auto exactMs = MeasureMedianMs(1, 5, [&]() {ToneMapReference(src, dst, exposure.Exposure(), settings.whitePoint); });
+	auto applyMs = MeasureMedianMs(1, 7, [&]() {exposure.Apply(src, dst, settings, &executor); });
+	printf("1280x720 RGBA32F, %u threads, exposure %.3f (average %.2f EV)\n", executor.ThreadCount(), exposure.Exposure(), exposure.AdaptedLog2());
+	printf("  log2 histogram   %7.3f ms (%4.1f%% of a 60 fps frame)\n", histogramMs, 100.0 * histogramMs / frameMs);
+	printf("  exposure adapt   %7.4f ms (%4.1f%%)\n", adaptMs, 100.0 * adaptMs / frameMs);
+	printf("  tone map         %7.3f ms (%4.1f%%), with pow per channel like the shader %.2f ms (x%.1f)\n",
+		toneMapMs, 100.0 * toneMapMs / frameMs, exactMs, exactMs / toneMapMs);
+	ImageRGBA8 src8(width, height), mono8;
+	for (size_t i = 0; i < src.pixels.size(); ++i) {
+		src8.pixels[i] = PackUnorm4x8(src.pixels[i]);
+	}
+	auto monoMs = MeasureMedianMs(3, 21, [&]() {MonoFilter(src8, mono8, &executor); });
+	printf("  Apply %.2f ms (%4.1f%% of a frame) = %.1fx the mono filter (%.2f ms, R8G8B8A8)\n", applyMs, 100.0 * applyMs / frameMs, applyMs / monoMs, monoMs);
+}
+
+void
+BenchmarkOutline() {
+	using hlsl::float3;
+	using hlsl::float4;
+	//ビュー空間(カメラは原点で+zを向く)の球を、CPUの簡単なラスタライザで描いて色とジオメトリ画像を作る
+	struct Mesh {
+		vector<float3> positions;
+		vector<float3> normals;
+		vector<uint32_t> indices;
+		float3 color;
+		float edgeFlag;
+	};
+	auto makeSphere = [](const float3& center, float radius, unsigned int segments, const float3& color, float edgeFlag) {
+		Mesh mesh;
+		mesh.color = color;
+		mesh.edgeFlag = edgeFlag;
+		const unsigned int rings = segments / 2;
+		const float pi = 3.14159265f;
+		for (unsigned int r = 0; r <= rings; ++r) {
+			const float theta = pi * r / rings;
+			for (unsigned int s = 0; s <= segments; ++s) {
+				const float phi = 2.0f * pi * s / segments;
+				const float3 n(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+				mesh.normals.push_back(n);
+				mesh.positions.push_back(center + n * radius);
+			}
+		}
+		for (unsigned int r = 0; r < rings; ++r) {
+			for (unsigned int s = 0; s < segments; ++s) {
+				const uint32_t a = r * (segments + 1) + s;
+				const uint32_t b = a + segments + 1;
+				const uint32_t tris[2][3] = { { a, b, a + 1 }, { a + 1, b, b + 1 } };
+				for (auto& t : tris) {
+					//外向きが表になるように並べる
+					const float3 faceN = cross(mesh.positions[t[1]] - mesh.positions[t[0]], mesh.positions[t[2]] - mesh.positions[t[0]]);
+					const bool outward = dot(faceN, mesh.positions[t[0]] - center) >= 0.0f;
+					mesh.indices.insert(mesh.indices.end(), { t[0], outward ? t[1] : t[2], outward ? t[2] : t[1] });
+				}
+			}
+		}
+		return mesh;
+	};
+	struct RasterTarget {
+		ImageRGBA32F color;
+		ImageRGBA32F geometry;
+		vector<float> depth;
+	};
+	auto clearTarget = [](RasterTarget& t, unsigned int w, unsigned int h) {
+		t.color = ImageRGBA32F(w, h);
+		t.geometry = ImageRGBA32F(w, h);
+		fill(t.color.pixels.begin(), t.color.pixels.end(), float4(1.0f));//BeginDrawと同じ白
+		fill(t.geometry.pixels.begin(), t.geometry.pixels.end(), float4(0.0f, 0.0f, outlineBackgroundDepth, 0.0f));
+		t.depth.assign(static_cast<size_t>(w) * h, outlineBackgroundDepth);
+	};
+	const float4 lineColor(0.0f, 0.0f, 0.0f, 1.0f);
+	//hullがfalseならカメラを向いた面を陰影をつけて描き、ジオメトリ画像も書く
+	//hullがtrueなら法線の方向にthicknessだけ膨らませて、裏の面だけを線の色で描く(ジオメトリで輪郭線を描くやり方)
+	auto rasterize = [&](const Mesh& mesh, RasterTarget& t, bool hull, float thickness) {
+		const unsigned int w = t.color.width;
+		const unsigned int h = t.color.height;
+		const float focal = static_cast<float>(h);
+		const float3 light = normalize(float3(1.0f, -1.0f, 1.0f));
+		vector<float3> view(mesh.positions.size());
+		vector<float3> screen(mesh.positions.size());//x,y,ビュー空間のz
+		for (size_t i = 0; i < view.size(); ++i) {
+			view[i] = hull ? mesh.positions[i] + mesh.normals[i] * thickness : mesh.positions[i];
+			screen[i] = float3(w * 0.5f + focal * view[i].x / view[i].z, h * 0.5f - focal * view[i].y / view[i].z, view[i].z);
+		}
+		auto edge = [](const float3& a, const float3& b, float px, float py) {
+			return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+		};
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			const uint32_t i0 = mesh.indices[i], i1 = mesh.indices[i + 1], i2 = mesh.indices[i + 2];
+			const bool front = dot(cross(view[i1] - view[i0], view[i2] - view[i0]), view[i0]) < 0.0f;
+			if (front == hull) {
+				continue;
+			}
+			const float3 s0 = screen[i0], s1 = screen[i1], s2 = screen[i2];
+			const float area = edge(s0, s1, s2.x, s2.y);
+			if (area == 0.0f) {
+				continue;
+			}
+			const int x0 = max(0, static_cast<int>(floor(min(s0.x, min(s1.x, s2.x)))));
+			const int x1 = min(static_cast<int>(w) - 1, static_cast<int>(ceil(max(s0.x, max(s1.x, s2.x)))));
+			const int y0 = max(0, static_cast<int>(floor(min(s0.y, min(s1.y, s2.y)))));
+			const int y1 = min(static_cast<int>(h) - 1, static_cast<int>(ceil(max(s0.y, max(s1.y, s2.y)))));
+			const float invArea = 1.0f / area;
+			for (int y = y0; y <= y1; ++y) {
+				const float py = y + 0.5f;
+				for (int x = x0; x <= x1; ++x) {
+					const float px = x + 0.5f;
+					const float b0 = edge(s1, s2, px, py) * invArea;
+					const float b1 = edge(s2, s0, px, py) * invArea;
+					const float b2 = 1.0f - b0 - b1;
+					if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f) {
+						continue;
+					}
+					const float z = 1.0f / (b0 / s0.z + b1 / s1.z + b2 / s2.z);
+					const size_t idx = static_cast<size_t>(y) * w + x;
+					if (z >= t.depth[idx]) {
+						continue;
+					}
+					t.depth[idx] = z;
+					if (hull) {
+						t.color.pixels[idx] = lineColor;
+						continue;
+					}
+					const float3 n = normalize(mesh.normals[i0] * b0 + mesh.normals[i1] * b1 + mesh.normals[i2] * b2);
+					const float lit = 0.25f + 0.75f * hlsl::saturate(dot(n, -light));
+					t.color.pixels[idx] = float4(mesh.color.x * lit, mesh.color.y * lit, mesh.color.z * lit, 1.0f);
+					t.geometry.pixels[idx] = float4(n.x, n.y, z, mesh.edgeFlag);
+				}
+			}
+		}
+	};
+	//左右に2つの球(右の球のedgeFlag)。線の太さは球の中心の深度で約1.5画素
+	const float sphereZ = 4.0f;
+	auto makeScene = [&](unsigned int segments, float rightEdgeFlag) {
+		vector<Mesh> meshes;
+		meshes.push_back(makeSphere(float3(-0.9f, 0.0f, sphereZ), 0.8f, segments, float3(0.9f, 0.6f, 0.5f), 1.0f));
+		meshes.push_back(makeSphere(float3(0.9f, 0.1f, sphereZ), 0.8f, segments, float3(0.4f, 0.6f, 0.9f), rightEdgeFlag));
+		return meshes;
+	};
+	auto drawScene = [&](const vector<Mesh>& meshes, RasterTarget& t, unsigned int w, unsigned int h) {
+		clearTarget(t, w, h);
+		for (auto& m : meshes) {
+			rasterize(m, t, false, 0.0f);
+		}
+	};
+	auto drawHulls = [&](const vector<Mesh>& meshes, RasterTarget& t) {
+		const float thickness = 1.5f * sphereZ / t.color.height;
+		for (auto& m : meshes) {
+			if (m.edgeFlag != 0.0f) {
+				rasterize(m, t, true, thickness);
+			}
+		}
+	};
+	OutlineSettings settings;
+	settings.color = lineColor;
+	auto changed = [](const float4& a, const float4& b) {
+		return fabs(a.x - b.x) > 0.25f || fabs(a.y - b.y) > 0.25f || fabs(a.z - b.z) > 0.25f;
+	};
+
+	//基準実装と同じ結果になること(端数のある大きさ、1スレッドと4スレッド)
+	{
+		ComputeExecutor multi(4);
+		RasterTarget t;
+		drawScene(makeScene(64, 0.0f), t, 333, 197);
+		ImageRGBA32F expected, single, parallel;
+		OutlineReference(t.color, t.geometry, expected, settings);
+		Outline(t.color, t.geometry, single, settings, nullptr);
+		Outline(t.color, t.geometry, parallel, settings, &multi);
+		float maxError = 0.0f;
+		for (size_t i = 0; i < expected.pixels.size(); ++i) {
+			for (int c = 0; c < 4; ++c) {
+				maxError = max(maxError, fabs(single.pixels[i][c] - expected.pixels[i][c]));
+			}
+		}
+		const bool same = memcmp(single.pixels.data(), parallel.pixels.data(), single.pixels.size() * sizeof(float4)) == 0;
+		printf("outline 333x197: max error %.2e vs reference, 4 threads identical %s: %s\n", maxError, same ? "yes" : "no",
+			maxError <= 1e-6f && same ? "ok" : "MISMATCH");
+
+		FilterGraph graph(333, 197);
+		graph.Outline(graph.Source(), settings);
+		CpuFilterGraphRunner runner(graph);
+		runner.SetGeometry(&t.geometry);
+		ImageRGBA32F viaGraph;
+		runner.Run(t.color, viaGraph, nullptr);
+		const bool graphSame = memcmp(viaGraph.pixels.data(), single.pixels.data(), single.pixels.size() * sizeof(float4)) == 0;
+		printf("filter graph Outline node: %s\n", graphSame ? "ok" : "MISMATCH");
+	}
+
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	//edgeFlagが0の球には描かないこと、ジオメトリでのやり方と同じところに線が出ること
+	{
+		const auto meshes = makeScene(100, 0.0f);
+		RasterTarget scene;
+		drawScene(meshes, scene, width, height);
+		ImageRGBA32F outlined;
+		Outline(scene.color, scene.geometry, outlined, settings, nullptr);
+		RasterTarget hull = scene;
+		drawHulls(meshes, hull);
+		size_t rightChanged = 0, screenPixels = 0, hullPixels = 0, covered = 0;
+		for (unsigned int y = 0; y < height; ++y) {
+			for (unsigned int x = 0; x < width; ++x) {
+				const bool screenEdge = changed(outlined.At(x, y), scene.color.At(x, y));
+				screenPixels += screenEdge;
+				rightChanged += screenEdge && x >= width / 2;
+				if (!changed(hull.color.At(x, y), scene.color.At(x, y))) {
+					continue;
+				}
+				++hullPixels;
+				bool near = false;
+				for (unsigned int sy = (y > 0 ? y - 1 : 0); sy <= min(y + 1, height - 1) && !near; ++sy) {
+					for (unsigned int sx = (x > 0 ? x - 1 : 0); sx <= min(x + 1, width - 1) && !near; ++sx) {
+						near = changed(outlined.At(sx, sy), scene.color.At(sx, sy));
+					}
+				}
+				covered += near;
+			}
+		}
+		const double recall = hullPixels > 0 ? static_cast<double>(covered) / hullPixels : 0.0;
+		printf("edge flag: %zu px outlined on the unflagged sphere: %s\n", rightChanged, rightChanged == 0 ? "ok" : "MISMATCH");
+		printf("silhouette: %zu inverted hull px, %.1f%% within 1 px of the %zu screen-space px: %s\n",
+			hullPixels, 100.0 * recall, screenPixels, hullPixels > 0 && recall >= 0.95 ? "ok" : "MISMATCH");
+	}
+
+	//ポリゴン数を増やしたときの、輪郭線のための追加の時間(どちらも1スレッド)
+	//  ジオメトリ : 膨らませたモデルをもう一度変換・ラスタライズする(ポリゴン数に比例して増える)
+	//  スクリーンスペース : 画素ごとに近傍を見るだけ(ポリゴン数によらない)
+	printf("%ux%u, single thread, both spheres with edge flag\n", width, height);
+	unsigned int crossover = 0;
+	double worstMs = 0.0;
+	for (unsigned int segments : { 32u, 100u, 316u, 1000u }) {
+		const auto meshes = makeScene(segments, 1.0f);
+		size_t triangles = 0;
+		for (auto& m : meshes) {
+			triangles += m.indices.size() / 3;
+		}
+		RasterTarget scene, work;
+		const int repeat = segments >= 1000 ? 3 : 7;
+		auto sceneMs = MeasureMedianMs(1, repeat, [&]() {drawScene(meshes, scene, width, height); });
+		auto copyMs = MeasureMedianMs(1, repeat, [&]() {work = scene; });
+		auto hullMs = MeasureMedianMs(1, repeat, [&]() {work = scene; drawHulls(meshes, work); }) - copyMs;
+		ImageRGBA32F outlined;
+		auto screenMs = MeasureMedianMs(1, repeat, [&]() {Outline(scene.color, scene.geometry, outlined, settings, nullptr); });
+		printf("  %8zu triangles: scene %8.2f ms, inverted hull +%8.2f ms (+%4.0f%%), screen-space +%6.2f ms (+%4.0f%%)\n",
+			triangles, sceneMs, hullMs, 100.0 * hullMs / sceneMs, screenMs, 100.0 * screenMs / sceneMs);
+		if (crossover == 0 && hullMs > screenMs) {
+			crossover = static_cast<unsigned int>(triangles);
+		}
+		if (segments == 1000u) {
+			//モデルが画面を埋めたときの上限(全画素がedgeFlagのマテリアル)
+			for (auto& g : scene.geometry.pixels) {
+				g.w = 1.0f;
+			}
+			worstMs = MeasureMedianMs(1, repeat, [&]() {Outline(scene.color, scene.geometry, outlined, settings, nullptr); });
+		}
+	}
+	printf("  screen-space with every pixel flagged (upper bound): %.2f ms\n", worstMs);
+	if (crossover != 0) {
+		printf("  the screen-space pass is cheaper from %u triangles on\n", crossover);
+	}
+	else {
+		printf("  the inverted hull stayed cheaper up to the largest mesh\n");
+	}
+}
+
+void
+BenchmarkReducedResolution() {
+	using hlsl::float4;
+	//絵:なめらかな背景(遠い)の前に、色と深度の違う円と四角を置き、細かいノイズを乗せたもの
+	auto makeScene = [](unsigned int w, unsigned int h, ImageRGBA32F& color, ImageRGBA32F& geometry) {
+		color = ImageRGBA32F(w, h);
+		geometry = ImageRGBA32F(w, h);
+		struct Shape {
+			float cx, cy, size;
+			bool disc;
+			float4 color;
+			float depth;
+		};
+		const Shape shapes[] = {
+			{ 0.25f, 0.40f, 0.18f, true, float4(0.85f, 0.30f, 0.25f, 1.0f), 8.0f },
+			{ 0.55f, 0.55f, 0.22f, false, float4(0.20f, 0.45f, 0.80f, 1.0f), 12.0f },
+			{ 0.70f, 0.35f, 0.12f, true, float4(0.95f, 0.85f, 0.30f, 1.0f), 6.0f },
+			{ 0.40f, 0.75f, 0.10f, false, float4(0.15f, 0.15f, 0.15f, 1.0f), 10.0f },
+			{ 0.85f, 0.75f, 0.08f, true, float4(0.90f, 0.90f, 0.95f, 1.0f), 5.0f },
+		};
+		uint32_t seed = 4242;
+		for (unsigned int y = 0; y < h; ++y) {
+			for (unsigned int x = 0; x < w; ++x) {
+				const float fx = (x + 0.5f) / w;
+				const float fy = (y + 0.5f) / h;
+				float4 c(0.35f + 0.3f * fy, 0.55f + 0.2f * fx, 0.75f, 1.0f);
+				float depth = 50.0f;
+				for (auto& s : shapes) {
+					const float dx = (fx - s.cx) * w / h;
+					const float dy = fy - s.cy;
+					const bool inside = s.disc ? dx * dx + dy * dy < s.size * s.size : fabs(dx) < s.size && fabs(dy) < s.size * 0.6f;
+					if (inside && s.depth < depth) {
+						c = s.color;
+						depth = s.depth;
+					}
+				}
+				seed = seed * 1664525u + 1013904223u;
+				const float noise = ((seed >> 16) & 0xff) / 255.0f * 0.08f - 0.04f;
+				color.At(x, y) = float4(hlsl::saturate(c.x + noise), hlsl::saturate(c.y + noise), hlsl::saturate(c.z + noise), 1.0f);
+				geometry.At(x, y) = float4(0.0f, 0.0f, depth, 1.0f);
+			}
+		}
+	};
+	//RGBのPSNR(dB)。maskがあればそこだけ
+	auto psnr = [](const ImageRGBA32F& a, const ImageRGBA32F& b, const vector<bool>* mask) {
+		double sum = 0.0;
+		size_t count = 0;
+		for (size_t i = 0; i < a.pixels.size(); ++i) {
+			if (mask != nullptr && !(*mask)[i]) {
+				continue;
+			}
+			for (int c = 0; c < 3; ++c) {
+				const double d = static_cast<double>(a.pixels[i][c]) - b.pixels[i][c];
+				sum += d * d;
+			}
+			count += 3;
+		}
+		const double mse = count > 0 ? sum / count : 0.0;
+		return mse > 0.0 ? 10.0 * log10(1.0 / mse) : 99.0;
+	};
+
+	//実装ごとに、基準実装と同じ結果になること(端数のある大きさと縮小率、近傍の半径、深度あり・なし、1スレッドと4スレッド)
+	auto& registry = KernelRegistry::Instance();
+	auto& jointUp = *registry.Find("jointup");
+	{
+		ComputeExecutor multi(4);
+		ImageRGBA32F guide, geometry;
+		makeScene(331, 197, guide, geometry);
+		for (auto isa : jointUp.Isas()) {
+			if (!jointUp.SelectExact(isa)) {
+				continue;
+			}
+			bool allSame = true;
+			float maxError = 0.0f;
+			for (unsigned int scale : { 2u, 4u }) {
+				ImageRGBA32F lowGuide, low;
+				Resample(guide, lowGuide, (guide.width + scale - 1) / scale, (guide.height + scale - 1) / scale, ResampleFilter::Bilinear, AlphaMode::Premultiplied, nullptr);
+				BoxFilter(lowGuide, low, 2, nullptr);
+				for (unsigned int radius = 1; radius <= maxJointUpsampleRadius; ++radius) {
+					for (float depthSigma : { 0.0f, 0.05f }) {
+						JointUpsampleSettings settings;
+						settings.radius = radius;
+						settings.depthSigma = depthSigma;
+						ImageRGBA32F expected, single, parallel;
+						JointUpsampleReference(low, lowGuide, guide, &geometry, expected, settings);
+						JointUpsample(low, lowGuide, guide, &geometry, single, settings, nullptr);
+						JointUpsample(low, lowGuide, guide, &geometry, parallel, settings, &multi);
+						for (size_t i = 0; i < expected.pixels.size(); ++i) {
+							for (int c = 0; c < 4; ++c) {
+								maxError = max(maxError, fabs(single.pixels[i][c] - expected.pixels[i][c]));
+							}
+						}
+						allSame = allSame && memcmp(single.pixels.data(), parallel.pixels.data(), single.pixels.size() * sizeof(float4)) == 0;
+					}
+				}
+			}
+			printf("%-7s joint upsample 331x197 (1/2 and 1/4, radius 1-2, with and without depth): max error %.2e vs reference, 4 threads identical %s: %s\n",
+				CpuIsaName(isa), maxError, allSame ? "yes" : "no", maxError <= 1e-6f && allSame ? "ok" : "MISMATCH");
+		}
+		registry.Reset();
+
+		//グラフのReducedは、縮小→処理→JointUpsampleを並べたものと同じ
+		JointUpsampleSettings settings;
+		settings.depthSigma = 0.05f;
+		FilterGraph graph(331, 197);
+		graph.Reduced(graph.Source(), 2, [](FilterGraph& g, FilterHandle low) {return g.BoxMean(low, 2); }, settings);
+		CpuFilterGraphRunner runner(graph);
+		runner.SetGeometry(&geometry);
+		ImageRGBA32F viaGraph, lowGuide, low, expected;
+		runner.Run(guide, viaGraph, nullptr);
+		Resample(guide, lowGuide, 166, 99, ResampleFilter::Bilinear, AlphaMode::Premultiplied, nullptr);
+		BoxFilter(lowGuide, low, 2, nullptr);
+		JointUpsample(low, lowGuide, guide, &geometry, expected, settings, nullptr);
+		const bool same = memcmp(viaGraph.pixels.data(), expected.pixels.data(), expected.pixels.size() * sizeof(float4)) == 0;
+		printf("filter graph Reduced (1/2 box mean + JointUpsample node, %zu passes): %s\n", runner.Plan().passes.size(), same ? "ok" : "MISMATCH");
+	}
+
+	//1280x720で、重いフィルタを元の大きさでかけたものと、1/2・1/4でかけて戻したものの時間とPSNR
+	//  bilinear : 双線形で戻す(Resample)。輪郭の向こうの色がにじむ
+	//  joint    : 輝度を手がかりに戻す(2x2)
+	//  joint+z  : 輝度と深度を手がかりに、4x4で戻す(品質を上げた設定)
+	//輪郭のまわり(手がかりの輝度が2画素以内で0.1以上変わるところ)のPSNRも別に出す(にじみ・ハローが出るとここが下がる)
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	ImageRGBA32F src, geometry;
+	makeScene(width, height, src, geometry);
+	vector<bool> edgeBand(src.pixels.size(), false);
+	{
+		vector<float> luma(src.pixels.size());
+		for (size_t i = 0; i < luma.size(); ++i) {
+			luma[i] = src.pixels[i].x * 0.299f + src.pixels[i].y * 0.587f + src.pixels[i].z * 0.114f;
+		}
+		for (unsigned int y = 0; y < height; ++y) {
+			for (unsigned int x = 0; x < width; ++x) {
+				float lo = 1e9f, hi = -1e9f;
+				for (unsigned int sy = (y >= 2 ? y - 2 : 0); sy <= min(y + 2, height - 1); ++sy) {
+					for (unsigned int sx = (x >= 2 ? x - 2 : 0); sx <= min(x + 2, width - 1); ++sx) {
+						lo = min(lo, luma[static_cast<size_t>(sy) * width + sx]);
+						hi = max(hi, luma[static_cast<size_t>(sy) * width + sx]);
+					}
+				}
+				edgeBand[static_cast<size_t>(y) * width + x] = hi - lo > 0.1f;
+			}
+		}
+	}
+	struct HeavyFilter {
+		const char* name;
+		function<FilterHandle(FilterGraph&, FilterHandle, unsigned int)> apply;//最後の引数は縮小率(半径などを割る)
+	};
+	const HeavyFilter filters[] = {
+		{ "median r4", [](FilterGraph& g, FilterHandle in, unsigned int scale) {return g.Median(in, 4 / scale); } },
+		{ "gaussian r24", [](FilterGraph& g, FilterHandle in, unsigned int scale) {return g.GaussianBlur(in, 24 / scale, 8.0f / scale); } },
+		{ "box mean r16", [](FilterGraph& g, FilterHandle in, unsigned int scale) {return g.BoxMean(in, 16 / scale); } },
+	};
+	JointUpsampleSettings joint;
+	JointUpsampleSettings jointDepth;
+	jointDepth.depthSigma = 0.05f;
+	jointDepth.radius = 2;
+	auto& executor = ComputeExecutor::Instance();
+	//1/2から1280x720に戻すところだけの時間(実装ごと)。双線形のResampleと比べる
+	{
+		ImageRGBA32F lowGuide, up;
+		Resample(src, lowGuide, width / 2, height / 2, ResampleFilter::Bilinear, AlphaMode::Premultiplied, &executor);
+		auto bilinearMs = MeasureMedianMs(1, 5, [&]() {Resample(lowGuide, up, width, height, ResampleFilter::Bilinear, AlphaMode::Premultiplied, &executor); });
+		printf("1/2 -> 1280x720 upsample, %u threads: bilinear resample %6.2f ms\n", executor.ThreadCount(), bilinearMs);
+		for (auto isa : jointUp.Isas()) {
+			if (!jointUp.SelectExact(isa)) {
+				continue;
+			}
+			auto jointMs = MeasureMedianMs(1, 5, [&]() {JointUpsample(lowGuide, lowGuide, src, &geometry, up, joint, &executor); });
+			auto depthMs = MeasureMedianMs(1, 5, [&]() {JointUpsample(lowGuide, lowGuide, src, &geometry, up, jointDepth, &executor); });
+			printf("  %-7s joint %6.2f ms, joint+z %6.2f ms\n", CpuIsaName(isa), jointMs, depthMs);
+		}
+		registry.Reset();
+	}
+	printf("1280x720 RGBA32F, %u threads. speedup and PSNR against the full resolution result (all pixels / around edges)\n", executor.ThreadCount());
+	for (auto& filter : filters) {
+		FilterGraph fullGraph(width, height);
+		filter.apply(fullGraph, fullGraph.Source(), 1);
+		CpuFilterGraphRunner fullRunner(fullGraph);
+		ImageRGBA32F full;
+		auto fullMs = MeasureMedianMs(1, 5, [&]() {fullRunner.Run(src, full, &executor); });
+		printf("  %-13s full      %7.2f ms\n", filter.name, fullMs);
+		for (unsigned int scale : { 2u, 4u }) {
+			const unsigned int lw = (width + scale - 1) / scale;
+			const unsigned int lh = (height + scale - 1) / scale;
+			auto body = [&](FilterGraph& g, FilterHandle low) {return filter.apply(g, low, scale); };
+			FilterGraph bilinear(width, height);
+			bilinear.Resample(body(bilinear, bilinear.Resample(bilinear.Source(), lw, lh, ResampleFilter::Bilinear)), width, height, ResampleFilter::Bilinear);
+			FilterGraph luma(width, height);
+			luma.Reduced(luma.Source(), scale, body, joint);
+			FilterGraph depth(width, height);
+			depth.Reduced(depth.Source(), scale, body, jointDepth);
+			const pair<const char*, const FilterGraph*> variants[] = { { "bilinear", &bilinear }, { "joint", &luma }, { "joint+z", &depth } };
+			for (auto& v : variants) {
+				CpuFilterGraphRunner runner(*v.second);
+				runner.SetGeometry(&geometry);
+				ImageRGBA32F out;
+				auto ms = MeasureMedianMs(1, 5, [&]() {runner.Run(src, out, &executor); });
+				printf("    1/%u %-9s %7.2f ms (x%4.1f)  PSNR %5.2f dB / edges %5.2f dB\n", scale, v.first, ms, fullMs / ms,
+					psnr(out, full, nullptr), psnr(out, full, &edgeBand));
+			}
+		}
+	}
+}
+
+void
+BenchmarkIncrementalFilter() {
+	using hlsl::float4;
+	//止まった背景(細かい模様)の前を、陰影をつけた球(の絵)がまわるフレームを作る。ジオメトリ画像は球のところだけedgeFlgが1
+	auto makeBackground = [](unsigned int w, unsigned int h) {
+		ImageRGBA32F background(w, h);
+		for (unsigned int y = 0; y < h; ++y) {
+			for (unsigned int x = 0; x < w; ++x) {
+				const float checker = ((x / 24) ^ (y / 24)) & 1 ? 0.1f : 0.0f;
+				background.At(x, y) = float4(0.45f + checker + 0.2f * y / h, 0.55f + 0.1f * x / w, 0.7f - checker, 1.0f);
+			}
+		}
+		return background;
+	};
+	//球の半径と軌道は背景の高さに合わせる(720なら半径90)
+	auto drawFrame = [](const ImageRGBA32F& background, unsigned int frame, ImageRGBA32F& color, ImageRGBA32F& geometry) {
+		const unsigned int width = background.width;
+		const unsigned int height = background.height;
+		color = background;
+		geometry = ImageRGBA32F(width, height);
+		fill(geometry.pixels.begin(), geometry.pixels.end(), float4(0.0f, 0.0f, outlineBackgroundDepth, 0.0f));
+		const float radius = height / 8.0f;
+		const float angle = 0.2f * frame;
+		const float cx = width * 0.5f + height * 0.3f * cos(angle);
+		const float cy = height * 0.5f + height * 0.17f * sin(angle);
+		const int x0 = max(0, static_cast<int>(cx - radius) - 1);
+		const int x1 = min(static_cast<int>(width) - 1, static_cast<int>(cx + radius) + 1);
+		const int y0 = max(0, static_cast<int>(cy - radius) - 1);
+		const int y1 = min(static_cast<int>(height) - 1, static_cast<int>(cy + radius) + 1);
+		for (int y = y0; y <= y1; ++y) {
+			for (int x = x0; x <= x1; ++x) {
+				const float nx = (x + 0.5f - cx) / radius;
+				const float ny = (y + 0.5f - cy) / radius;
+				const float rr = nx * nx + ny * ny;
+				if (rr >= 1.0f) {
+					continue;
+				}
+				const float nz = sqrt(1.0f - rr);
+				const float shade = max(0.2f, 0.6f * nz + 0.4f * (-nx - ny) * 0.7f);
+				color.At(x, y) = float4(0.95f * shade, 0.75f * shade, 0.6f * shade, 1.0f);
+				geometry.At(x, y) = float4(nx, -ny, 10.0f - nz, 1.0f);
+			}
+		}
+	};
+
+	struct Chain {
+		const char* name;
+		function<void(FilterGraph&)> build;
+	};
+	const Chain chains[] = {
+		{ "outline+mono", [](FilterGraph& g) {g.Mono(g.Outline(g.Source(), OutlineSettings())); } },
+		{ "median3+blur6", [](FilterGraph& g) {g.Contrast(g.GaussianBlur(g.Median(g.Source(), 3), 6, 2.5f), 1.2f); } },
+		{ "tonemap", [](FilterGraph& g) {g.ToneMap(g.Source(), ToneMapSettings()); } },
+	};
+	constexpr unsigned int frames = 12;
+	auto& executor = ComputeExecutor::Instance();
+
+	//画像全体で実行したものと同じになること(端に近いタイル・読む範囲がタイルをまたぐもの・モデルが止まったフレーム)
+	{
+		bool allSame = true;
+		for (auto& chain : chains) {
+			FilterGraph graph(331, 197);
+			chain.build(graph);
+			CpuFilterGraphRunner full(graph);
+			IncrementalFilterRunner incremental(graph, 16);
+			const auto background = makeBackground(331, 197);
+			ImageRGBA32F color, geometry, expected;
+			for (unsigned int f = 0; f < 6; ++f) {
+				drawFrame(background, f < 4 ? f : 3, color, geometry);
+				full.SetGeometry(&geometry);
+				incremental.SetGeometry(&geometry);
+				full.Run(color, expected, nullptr);
+				const auto& out = incremental.Run(color, (f & 1) ? &executor : nullptr);
+				allSame = allSame && memcmp(out.pixels.data(), expected.pixels.data(), expected.pixels.size() * sizeof(float4)) == 0;
+			}
+		}
+		printf("incremental filter 331x197 tile 16 (3 chains, 6 frames, last 2 unchanged): same as full frame %s\n", allSame ? "ok" : "MISMATCH");
+	}
+
+	//1280x720で、球がまわる12フレーム(最初のフレームは全体を処理するので数えない)
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	const auto background = makeBackground(width, height);
+	vector<ImageRGBA32F> colors(frames + 1), geometries(frames + 1);
+	for (unsigned int f = 0; f <= frames; ++f) {
+		drawFrame(background, f, colors[f], geometries[f]);
+	}
+	printf("1280x720 RGBA32F, %u threads, rotating model over a static background (%u frames). time per frame\n", executor.ThreadCount(), frames);
+	for (auto& chain : chains) {
+		FilterGraph graph(width, height);
+		chain.build(graph);
+		CpuFilterGraphRunner full(graph);
+		ImageRGBA32F out;
+		double fullMs = 0.0;
+		for (unsigned int f = 1; f <= frames; ++f) {
+			full.SetGeometry(&geometries[f]);
+			Stopwatch sw;
+			full.Run(colors[f], out, &executor);
+			fullMs += sw.ElapsedMilliseconds();
+		}
+		fullMs /= frames;
+		printf("  %-14s full frame  %7.2f ms\n", chain.name, fullMs);
+		for (unsigned int tileSize : { 32u, 64u, 128u }) {
+			IncrementalFilterRunner incremental(graph, tileSize);
+			incremental.SetGeometry(&geometries[0]);
+			incremental.Run(colors[0], &executor);
+			incremental.ResetStats();
+			double ms = 0.0;
+			for (unsigned int f = 1; f <= frames; ++f) {
+				incremental.SetGeometry(&geometries[f]);
+				Stopwatch sw;
+				incremental.Run(colors[f], &executor);
+				ms += sw.ElapsedMilliseconds();
+			}
+			ms /= frames;
+			//何も変わらないフレーム(ハッシュを取るだけ)
+			auto staticMs = MeasureMedianMs(1, 5, [&]() {incremental.Run(colors[frames], &executor); });
+			const auto& stats = incremental.Stats();
+			printf("    tile %3u (halo %2u) %7.2f ms (x%5.1f)  recomputed %5.1f%% of tiles (changed %5.1f%%), %4.1f regions/frame, unchanged frame %6.2f ms\n",
+				tileSize, incremental.Halo(), ms, fullMs / ms, stats.RecomputedFraction() * 100.0, 100.0 * stats.changedTiles / max<uint64_t>(stats.tiles, 1),
+				static_cast<double>(stats.regions) / max<uint64_t>(stats.frames, 1), staticMs);
+			if (!incremental.IsLocal()) {
+				break;//局所でないグラフは毎フレーム全体なのでタイルの大きさによらない
+			}
+		}
+	}
+}
+
+void
+BenchmarkImageBatch() {
+	auto makeImages = [](size_t count, unsigned int minSize, unsigned int maxSize, uint32_t seed) {
+		vector<ImageRGBA8> images(count);
+		for (auto& image : images) {
+			seed = seed * 1664525u + 1013904223u;
+			const unsigned int w = minSize + (seed >> 8) % (maxSize - minSize + 1);
+			seed = seed * 1664525u + 1013904223u;
+			const unsigned int h = minSize + (seed >> 8) % (maxSize - minSize + 1);
+			image = ImageRGBA8(w, h);
+			for (auto& px : image.pixels) {
+				seed = seed * 1664525u + 1013904223u;
+				px = seed;
+			}
+		}
+		return images;
+	};
+	auto pointers = [](const vector<ImageRGBA8>& images) {
+		vector<const ImageRGBA8*> result;
+		for (auto& image : images) {
+			result.push_back(&image);
+		}
+		return result;
+	};
+	auto& executor = ComputeExecutor::Instance();
+
+	//1枚ずつかけたものと同じになること(大きさのばらばらな画像、1スレッドとエグゼキュータ)
+	{
+		const auto images = makeImages(300, 1, 90, 77);
+		ImageArrayRGBA8 packed, filtered;
+		PackImageArray(pointers(images), packed, &executor);
+		bool same = true;
+		auto check = [&](const vector<ImageRGBA8>& results) {
+			for (size_t i = 0; i < images.size(); ++i) {
+				ImageRGBA8 expected;
+				MonoFilter(images[i], expected, nullptr);
+				same = same && results[i].width == expected.width && results[i].height == expected.height && results[i].pixels == expected.pixels;
+			}
+		};
+		for (auto* exec : { static_cast<ComputeExecutor*>(nullptr), &executor }) {
+			vector<ImageRGBA8> results;
+			MonoFilter(pointers(images), results, exec);
+			check(results);
+			MonoFilter(packed, filtered, exec);
+			UnpackImageArray(filtered, results, exec);
+			check(results);
+		}
+		printf("image batch (300 images 1x1-90x90, array %ux%u): same as one by one %s\n", packed.width, packed.height, same ? "ok" : "MISMATCH");
+	}
+
+	//同じ大きさの画像をたくさん(合わせて16M画素くらい)。1枚ずつと、まとめて1回のParallelForで
+	//arrayはテクスチャ配列に詰めるGPUと同じ形(詰める・戻すコピーを含む。kernelはフィルタだけ)
+	printf("MonoCS on many small images, %u threads (%s). images per second\n", executor.ThreadCount(), MonoFilterVariantName());
+	for (unsigned int size : { 64u, 200u, 512u }) {
+		const size_t count = max<size_t>(16, 16u * 1024 * 1024 / (static_cast<size_t>(size) * size));
+		const auto images = makeImages(count, size, size, size);
+		const auto sources = pointers(images);
+		vector<ImageRGBA8> results(count);
+		auto perImageMs = MeasureMedianMs(1, 5, [&]() {
+			for (size_t i = 0; i < count; ++i) {
+				MonoFilter(images[i], results[i], &executor);
+			}
+		});
+		auto perImageSingleMs = MeasureMedianMs(1, 5, [&]() {
+			for (size_t i = 0; i < count; ++i) {
+				MonoFilter(images[i], results[i], nullptr);
+			}
+		});
+		auto batchMs = MeasureMedianMs(1, 5, [&]() {MonoFilter(sources, results, &executor); });
+		ImageArrayRGBA8 packed, filtered;
+		auto arrayMs = MeasureMedianMs(1, 5, [&]() {
+			PackImageArray(sources, packed, &executor);
+			MonoFilter(packed, filtered, &executor);
+			UnpackImageArray(filtered, results, &executor);
+		});
+		auto kernelMs = MeasureMedianMs(1, 5, [&]() {MonoFilter(packed, filtered, &executor); });
+		auto rate = [&](double ms) {return count / (ms / 1000.0); };
+		printf("  %3ux%-3u x%5zu  per image %9.0f/s  per image (1 thread) %9.0f/s  batch %9.0f/s (x%4.1f)  array %9.0f/s (kernel %9.0f/s)\n",
+			size, size, count, rate(perImageMs), rate(perImageSingleMs), rate(batchMs), perImageMs / batchMs, rate(arrayMs), rate(kernelMs));
+	}
+}
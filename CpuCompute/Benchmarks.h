@@ -0,0 +1,91 @@
+﻿#pragma once
+#include<chrono>
+#include<functional>
+
+///簡易ストップウォッチ
+class Stopwatch
+{
+	std::chrono::steady_clock::time_point start_;
+public:
+	Stopwatch() :start_(std::chrono::steady_clock::now()) {}
+	void Reset() { start_ = std::chrono::steady_clock::now(); }
+	///経過時間(ミリ秒)
+	double ElapsedMilliseconds()const {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+	}
+};
+
+///warmup回空回ししてからrepeat回計測し、中央値を返す
+///@param warmup 空回し回数
+///@param repeat 計測回数
+///@param func 計測対象
+///@return 1回あたりの時間の中央値(ミリ秒)
+double MeasureMedianMs(int warmup, int repeat, const std::function<void()>& func);
+
+///大きなグリッドでのDispatchのスレッド数スケーリング
+void BenchmarkDispatchScaling();
+
+///groupshared+バリアを使うカーネルとバリアなしカーネルの速度比較
+void BenchmarkGroupShared();
+
+///スカラー実行とウェーブ(SIMD)実行の比較(輝度計算+しきい値以上の画素数のInterlockedAdd)
+void BenchmarkWave();
+
+///MonoCSのCPU版:実装(命令セット)ごとに全RGBの組み合わせでの誤差確認と720pの処理時間、4Kのスレッド数比較
+void BenchmarkMonoFilter();
+
+///MonoFilterの命令セット・グループの形・タスクあたりのグループ数を200x200/720p/4Kで自動調整し、結果をTuneTableに保存する
+void AutotuneMonoFilter();
+
+///FirstStepと同じジョブをComputeJob(CPU)で繰り返し実行して、結果の一致とバッファの使いまわし、1秒あたりのジョブ数を見る
+void BenchmarkComputeJob();
+
+///SoaBufferの確認:実装ごとのAoS<->SoAの往復、1フィールドだけ書くカーネルのAoS/SoA比較、並べ替えの速さ
+void BenchmarkSoa();
+
+///輝度の集計(合計・最小・最大・ヒストグラム)の確認:実装ごとの基準実装との一致と、720p/4KのR8G8B8A8/floatでの処理時間と帯域(読むだけのループとの比較)
+void BenchmarkReduction();
+
+///スキャンとコンパクションの確認:実装ごとの逐次計算との一致と、100万/1000万/1億要素での処理時間
+void BenchmarkScan();
+
+///基数ソートの確認:キー/キーと値/SimpleBuffer_tのiとfでの並べ替えのstd::stable_sortとの一致と、1000万要素でのstd::sortとの比較
+void BenchmarkRadixSort();
+
+///ガウシアンぼかしの確認:実装ごとの基準実装との誤差と、1280x720での半径1～64の処理時間
+void BenchmarkGaussianBlur();
+
+///中央値・順位フィルタの確認:実装ごとの基準実装との一致と、1280x720での3x3/5x5のネットワークとヒストグラム、半径4～127の処理時間
+void BenchmarkMedianFilter();
+
+///箱型フィルタの確認:実装ごとの基準実装との一致と、1280x720での半径1～127の総和テーブル版・列の和の版の処理時間(写すだけの時間と比べる)
+void BenchmarkBoxFilter();
+
+///拡大縮小の確認:実装ごとの基準実装との一致と、4K→720pの縮小を素朴なループと比べた処理時間、720p→1080pの拡大の処理時間
+void BenchmarkResample();
+
+
+///3D LUTの確認:全2^24色での変換を直接計算したものとの差(格子の大きさ・シェーパーごと)と実装の間の一致、1280x720での変換ごとのパス・直接計算・LUTの処理時間
+void BenchmarkColorLut();
+
+
+///フィルタグラフの確認:まとめる・使い回すの有無とfloat/R8G8B8A8/スレッド数によらずノードごとに既存の関数をかけたものと一致するか、1280x720で点ごとのパスをまとめた場合とまとめない場合の処理時間
+void BenchmarkFilterGraph();
+
+///ブルームの確認:段ごとの実装と双線形で読む基準実装の差(奇数の大きさ・スレッド数)とフィルタグラフのノードとの一致、1280x720での段ごとの処理時間の内訳とモノクロ化・全画面のぼかしとの比較
+void BenchmarkBloom();
+
+///自動露出とトーンマップの確認:log2の階級のヒストグラムの実装ごとの一致、露出の目標と正しいlog2で求めた平均の差、なじませるフレーム数、トーンマップの基準実装との一致とフィルタグラフのノード、1280x720での段ごとの処理時間
+void BenchmarkToneMap();
+
+///輪郭線の確認:基準実装との一致(端数のある大きさ・スレッド数)とフィルタグラフのノード、edgeFlagのない球に描かないこと、ジオメトリ(裏返して膨らませたモデル)で描いた線との重なり、ポリゴン数ごとの追加の時間の比較
+void BenchmarkOutline();
+
+///縮小して処理するフィルタの確認:ジョイントバイラテラル拡大の基準実装との一致とグラフのReduced、1280x720での重いフィルタの1/2・1/4での時間と元の大きさの結果に対するPSNR(拡大のしかたごと、輪郭のまわりも)
+void BenchmarkReducedResolution();
+
+///変わったタイルだけを処理し直すフィルタグラフの確認:画像全体で実行したものとの一致、まわるモデルのフレームでのタイルの大きさごとの時間と処理し直したタイルの割合、何も変わらないフレームの時間
+void BenchmarkIncrementalFilter();
+
+///小さい画像をまとめて処理するMonoCSの確認:大きさのばらばらな画像で1枚ずつと同じになること、64x64・200x200・512x512での1枚ずつとまとめたときの1秒あたりの枚数
+void BenchmarkImageBatch();
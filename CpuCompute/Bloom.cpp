@@ -0,0 +1,279 @@
+﻿#include "Bloom.h"
+#include<algorithm>
+#include<cassert>
+#include<cmath>
+#include"ComputeExecutor.h"
+
+//シェーダと同じしきい値と重み
+namespace hlsl {
+	namespace {
+#include"Bloom.hlsli"
+	}
+}
+
+using namespace std;
+using hlsl::float3;
+using hlsl::float4;
+
+namespace {
+	//並列化するときの帯の最小の行数(帯の境目では縮小・拡大の横のパスを数行ずつ余分にする)
+	constexpr unsigned int minBandRows = 16;
+
+	//出力の行を帯に分けてfunc(y0, y1)を呼ぶ
+	template<typename Func>
+	void ForEachBand(unsigned int height, ComputeExecutor* executor, const Func& func) {
+		unsigned int bandNum = 1;
+		if (executor != nullptr && executor->ThreadCount() > 1) {
+			bandNum = max(1u, min(height / minBandRows, executor->ThreadCount() * 2));
+		}
+		auto runBand = [&](size_t band) {
+			func(static_cast<unsigned int>(static_cast<uint64_t>(height) * band / bandNum),
+				static_cast<unsigned int>(static_cast<uint64_t>(height) * (band + 1) / bandNum));
+		};
+		if (bandNum > 1) {
+			executor->ParallelFor(bandNum, 1, [&](size_t begin, size_t end) {
+				for (auto band = begin; band < end; ++band) {
+					runBand(band);
+				}
+			});
+		}
+		else {
+			runBand(0);
+		}
+	}
+
+	//リングバッファの行(iは負でもよい)
+	inline unsigned int RingSlot(int i, int size) {
+		return static_cast<unsigned int>((i % size + size) % size);
+	}
+
+	//13タップの縮小(prefilterならしきい値もかける)
+	//入力の行を横に縮小した外側と内側の結果を6行のリングバッファに置き、縦に重みをかけて足す
+	//出力の1行ごとに入力は2行進むので、入力の1行の横のパスは3回使われる
+	void DownsampleImage(const ImageRGBA32F& src, ImageRGBA32F& dst, bool prefilter, float threshold, float knee, ComputeExecutor* executor) {
+		const int srcWidth = static_cast<int>(src.width);
+		const int srcHeight = static_cast<int>(src.height);
+		const unsigned int width = dst.width;
+		//出力の列xが読む入力の列(端は繰り返す)
+		vector<unsigned int> columns(static_cast<size_t>(width) * BLOOM_DOWN_TAPS);
+		for (unsigned int x = 0; x < width; ++x) {
+			for (int k = 0; k < BLOOM_DOWN_TAPS; ++k) {
+				columns[x * BLOOM_DOWN_TAPS + k] = static_cast<unsigned int>(clamp(2 * static_cast<int>(x) - 2 + k, 0, srcWidth - 1));
+			}
+		}
+		ForEachBand(dst.height, executor, [&](unsigned int y0, unsigned int y1) {
+			vector<float4> outer(static_cast<size_t>(width) * BLOOM_DOWN_TAPS);
+			vector<float4> inner(static_cast<size_t>(width) * BLOOM_DOWN_TAPS);
+			int next = 2 * static_cast<int>(y0) - 2;
+			for (auto y = y0; y < y1; ++y) {
+				const int top = 2 * static_cast<int>(y) - 2;
+				for (; next < top + BLOOM_DOWN_TAPS; ++next) {
+					const float4* row = src.Row(static_cast<unsigned int>(clamp(next, 0, srcHeight - 1)));
+					float4* o = outer.data() + static_cast<size_t>(RingSlot(next, BLOOM_DOWN_TAPS)) * width;
+					float4* in = inner.data() + static_cast<size_t>(RingSlot(next, BLOOM_DOWN_TAPS)) * width;
+					for (unsigned int x = 0; x < width; ++x) {
+						const unsigned int* c = &columns[x * BLOOM_DOWN_TAPS];
+						const float4 p1 = row[c[1]], p2 = row[c[2]], p3 = row[c[3]], p4 = row[c[4]];
+						in[x] = (p1 + p2 + p3 + p4) * hlsl::bloomInnerWeights[1];
+						o[x] = (row[c[0]] + p1 + p4 + row[c[5]]) * hlsl::bloomOuterWeights[0] + (p2 + p3) * hlsl::bloomOuterWeights[2];
+					}
+				}
+				const float4* o[BLOOM_DOWN_TAPS];
+				const float4* in[BLOOM_DOWN_TAPS];
+				for (int j = 0; j < BLOOM_DOWN_TAPS; ++j) {
+					o[j] = outer.data() + static_cast<size_t>(RingSlot(top + j, BLOOM_DOWN_TAPS)) * width;
+					in[j] = inner.data() + static_cast<size_t>(RingSlot(top + j, BLOOM_DOWN_TAPS)) * width;
+				}
+				float4* out = dst.Row(y);
+				for (unsigned int x = 0; x < width; ++x) {
+					const float4 outerSum = (o[0][x] + o[1][x] + o[4][x] + o[5][x]) * hlsl::bloomOuterWeights[0] + (o[2][x] + o[3][x]) * hlsl::bloomOuterWeights[2];
+					const float4 innerSum = (in[1][x] + in[2][x] + in[3][x] + in[4][x]) * hlsl::bloomInnerWeights[1];
+					float4 c = (outerSum + innerSum) * 0.5f;
+					if (prefilter) {
+						c = float4(hlsl::BloomThreshold(c.rgb, threshold, knee), c.a);
+					}
+					out[x] = c;
+				}
+			}
+		});
+	}
+
+	//テントで拡大して足す(dst = base + scale * 拡大したsmall。アルファはbaseのまま。dstとbaseは同じでもよい)
+	//小さい画像の行を横に拡大した結果を4行のリングバッファに置き、縦に重みをかけて足す
+	//大きい画像の2行ごとに小さい画像は1行進むので、横のパスは4回使われる
+	void UpsampleImage(const ImageRGBA32F& small, const ImageRGBA32F& base, ImageRGBA32F& dst, float scale, ComputeExecutor* executor) {
+		const int smallWidth = static_cast<int>(small.width);
+		const int smallHeight = static_cast<int>(small.height);
+		const unsigned int width = dst.width;
+		vector<unsigned int> columns(static_cast<size_t>(width) * BLOOM_UP_TAPS);
+		for (unsigned int x = 0; x < width; ++x) {
+			for (int k = 0; k < BLOOM_UP_TAPS; ++k) {
+				columns[x * BLOOM_UP_TAPS + k] = static_cast<unsigned int>(clamp(hlsl::BloomUpStart(static_cast<int>(x)) + k, 0, smallWidth - 1));
+			}
+		}
+		const float3 scale3(scale);
+		ForEachBand(dst.height, executor, [&](unsigned int y0, unsigned int y1) {
+			vector<float4> ring(static_cast<size_t>(width) * BLOOM_UP_TAPS);
+			int next = hlsl::BloomUpStart(static_cast<int>(y0));
+			for (auto y = y0; y < y1; ++y) {
+				const int top = hlsl::BloomUpStart(static_cast<int>(y));
+				for (; next < top + BLOOM_UP_TAPS; ++next) {
+					const float4* row = small.Row(static_cast<unsigned int>(clamp(next, 0, smallHeight - 1)));
+					float4* h = ring.data() + static_cast<size_t>(RingSlot(next, BLOOM_UP_TAPS)) * width;
+					for (unsigned int x = 0; x < width; ++x) {
+						const unsigned int* c = &columns[x * BLOOM_UP_TAPS];
+						const float* w = hlsl::bloomUpWeights[x & 1];
+						h[x] = row[c[0]] * w[0] + row[c[1]] * w[1] + row[c[2]] * w[2] + row[c[3]] * w[3];
+					}
+				}
+				const float* w = hlsl::bloomUpWeights[y & 1];
+				const float4* h[BLOOM_UP_TAPS];
+				for (int j = 0; j < BLOOM_UP_TAPS; ++j) {
+					h[j] = ring.data() + static_cast<size_t>(RingSlot(top + j, BLOOM_UP_TAPS)) * width;
+				}
+				const float4* b = base.Row(y);
+				float4* out = dst.Row(y);
+				for (unsigned int x = 0; x < width; ++x) {
+					const float4 t = h[0][x] * w[0] + h[1][x] * w[1] + h[2][x] * w[2] + h[3][x] * w[3];
+					out[x] = float4(b[x].rgb + t.rgb * scale3, b[x].a);
+				}
+			}
+		});
+	}
+}
+
+BloomFilter::BloomFilter(unsigned int width, unsigned int height, unsigned int levels) :width_(width), height_(height) {
+	assert(width > 0 && height > 0 && levels > 0);
+	levels_.resize(BloomLevelCount(width, height, levels));
+	for (unsigned int l = 0; l < levels_.size(); ++l) {
+		unsigned int w, h;
+		BloomLevelSize(width, height, l, w, h);
+		levels_[l] = ImageRGBA32F(w, h);
+	}
+}
+
+size_t
+BloomFilter::LevelBytes()const {
+	size_t bytes = 0;
+	for (auto& level : levels_) {
+		bytes += level.pixels.size() * sizeof(float4);
+	}
+	return bytes;
+}
+
+void
+BloomFilter::Apply(const ImageRGBA32F& src, ImageRGBA32F& dst, const BloomSettings& settings, ComputeExecutor* executor) {
+	Prefilter(src, settings.threshold, settings.knee, executor);
+	for (unsigned int l = 1; l < LevelCount(); ++l) {
+		Downsample(l, executor);
+	}
+	for (auto l = LevelCount() - 1; l-- > 0;) {
+		Upsample(l, executor);
+	}
+	Composite(src, dst, settings.intensity, executor);
+}
+
+void
+BloomFilter::Prefilter(const ImageRGBA32F& src, float threshold, float knee, ComputeExecutor* executor) {
+	assert(src.width == width_ && src.height == height_);
+	DownsampleImage(src, levels_[0], true, threshold, knee, executor);
+}
+
+void
+BloomFilter::Downsample(unsigned int level, ComputeExecutor* executor) {
+	assert(level >= 1 && level < LevelCount());
+	DownsampleImage(levels_[level - 1], levels_[level], false, 0.0f, 0.0f, executor);
+}
+
+void
+BloomFilter::Upsample(unsigned int level, ComputeExecutor* executor) {
+	assert(level + 1 < LevelCount());
+	UpsampleImage(levels_[level + 1], levels_[level], levels_[level], 1.0f, executor);
+}
+
+void
+BloomFilter::Composite(const ImageRGBA32F& src, ImageRGBA32F& dst, float intensity, ComputeExecutor* executor) {
+	assert(src.width == width_ && src.height == height_);
+	if (&dst != &src) {
+		dst.width = width_;
+		dst.height = height_;
+		dst.pixels.resize(src.pixels.size());
+	}
+	UpsampleImage(levels_[0], src, dst, intensity, executor);
+}
+
+void
+BloomReference(const ImageRGBA32F& src, ImageRGBA32F& dst, const BloomSettings& settings) {
+	//双線形(texel中心が整数の座標。画像の外は端の画素を繰り返す)
+	auto sample = [](const ImageRGBA32F& img, float u, float v) {
+		const float fu = floor(u);
+		const float fv = floor(v);
+		const float tx = u - fu;
+		const float ty = v - fv;
+		auto at = [&](int x, int y) {
+			return img.At(static_cast<unsigned int>(clamp(x, 0, static_cast<int>(img.width) - 1)), static_cast<unsigned int>(clamp(y, 0, static_cast<int>(img.height) - 1)));
+		};
+		const int x = static_cast<int>(fu);
+		const int y = static_cast<int>(fv);
+		return (at(x, y) * (1.0f - tx) + at(x + 1, y) * tx) * (1.0f - ty) + (at(x, y + 1) * (1.0f - tx) + at(x + 1, y + 1) * tx) * ty;
+	};
+	//出力の画素の中心から±1、±2画素の13か所(内側の4か所で1/2、外側の2x2か所ずつの4組で1/8ずつ)
+	auto downsample = [&](const ImageRGBA32F& in, ImageRGBA32F& out) {
+		for (unsigned int y = 0; y < out.height; ++y) {
+			for (unsigned int x = 0; x < out.width; ++x) {
+				const float u = 2.0f * x + 0.5f;
+				const float v = 2.0f * y + 0.5f;
+				auto tap = [&](float dx, float dy) {return sample(in, u + dx, v + dy); };
+				const float4 innerSum = tap(-1, -1) + tap(1, -1) + tap(-1, 1) + tap(1, 1);
+				const float4 topLeft = tap(-2, -2) + tap(0, -2) + tap(-2, 0) + tap(0, 0);
+				const float4 topRight = tap(0, -2) + tap(2, -2) + tap(0, 0) + tap(2, 0);
+				const float4 bottomLeft = tap(-2, 0) + tap(0, 0) + tap(-2, 2) + tap(0, 2);
+				const float4 bottomRight = tap(0, 0) + tap(2, 0) + tap(0, 2) + tap(2, 2);
+				out.At(x, y) = innerSum * (0.5f / 4.0f) + (topLeft + topRight + bottomLeft + bottomRight) * (0.125f / 4.0f);
+			}
+		}
+	};
+	//小さい画像を、大きい画像の画素の中心から±1画素(小さい画像の)の3x3か所で読む(1:2:1)
+	auto tent = [&](const ImageRGBA32F& small, unsigned int x, unsigned int y) {
+		const float u = (x + 0.5f) * 0.5f - 0.5f;
+		const float v = (y + 0.5f) * 0.5f - 0.5f;
+		const float weights[3] = { 1.0f, 2.0f, 1.0f };
+		float4 sum(0.0f);
+		for (int dy = -1; dy <= 1; ++dy) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				sum += sample(small, u + dx, v + dy) * (weights[dx + 1] * weights[dy + 1] / 16.0f);
+			}
+		}
+		return sum;
+	};
+
+	const auto levelCount = BloomLevelCount(src.width, src.height, settings.levels);
+	vector<ImageRGBA32F> levels(levelCount);
+	for (unsigned int l = 0; l < levelCount; ++l) {
+		unsigned int w, h;
+		BloomLevelSize(src.width, src.height, l, w, h);
+		levels[l] = ImageRGBA32F(w, h);
+		downsample(l == 0 ? src : levels[l - 1], levels[l]);
+		if (l == 0) {
+			for (auto& c : levels[l].pixels) {
+				c = float4(hlsl::BloomThreshold(c.rgb, settings.threshold, settings.knee), c.a);
+			}
+		}
+	}
+	for (auto l = levelCount - 1; l-- > 0;) {
+		for (unsigned int y = 0; y < levels[l].height; ++y) {
+			for (unsigned int x = 0; x < levels[l].width; ++x) {
+				auto& c = levels[l].At(x, y);
+				c = float4(c.rgb + tent(levels[l + 1], x, y).rgb, c.a);
+			}
+		}
+	}
+	ImageRGBA32F out(src.width, src.height);
+	for (unsigned int y = 0; y < src.height; ++y) {
+		for (unsigned int x = 0; x < src.width; ++x) {
+			const auto& c = src.At(x, y);
+			out.At(x, y) = float4(c.rgb + tent(levels[0], x, y).rgb * float3(settings.intensity), c.a);
+		}
+	}
+	dst = move(out);
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+#include<vector>
+#include"Image.h"
+
+class ComputeExecutor;
+
+//ブルーム(しきい値を超えた明るいところを大きくにじませて足す)
+//RenderTargetFilter/BloomCS.hlslのCPU版。しきい値と重みはBloom.hlsliをシェーダと共有する
+//大きな半径でぼかす代わりに、半分ずつ小さくした画像の連鎖でにじませる
+//  縮小 : 入力→1/2(13タップ+しきい値)→1/4→…と縮小する(段ごとに13タップ)
+//  拡大 : いちばん小さい段からテントで1段大きくしては、その段の縮小結果に足していく
+//  合成 : 1/2の段をテントで入力の大きさにして、intensity倍して入力に足す
+//画素ごとの手間は段の数によらずほぼ一定(段ごとに画素が1/4になるので、全部の段で1/2の段の4/3倍)
+
+///縮小の段の数の上限
+constexpr unsigned int maxBloomLevels = 8;
+
+///ブルームの設定
+struct BloomSettings {
+	float threshold = 1.0f;//これより明るい(成分の最大値)ところだけをにじませる
+	float knee = 0.5f;//しきい値の前後をなめらかにつなぐ幅
+	float intensity = 0.5f;//にじみを足すときの倍率
+	unsigned int levels = 6;//縮小の段の数(1～maxBloomLevels。小さい画像では減る)
+};
+
+///実際の段の数(いちばん小さい段の短い辺が2画素以上になるところまで。最低1段)
+inline unsigned int BloomLevelCount(unsigned int width, unsigned int height, unsigned int levels) {
+	unsigned int count = 1;
+	unsigned int shorter = ((width < height ? width : height) + 1) / 2;
+	while (count < levels && count < maxBloomLevels && shorter >= 4) {
+		shorter = (shorter + 1) / 2;
+		++count;
+	}
+	return count;
+}
+
+///段の大きさ(levelは0が1/2。端数は切り上げ)
+inline void BloomLevelSize(unsigned int width, unsigned int height, unsigned int level, unsigned int& levelWidth, unsigned int& levelHeight) {
+	levelWidth = width;
+	levelHeight = height;
+	for (unsigned int i = 0; i <= level; ++i) {
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+}
+
+///ブルーム
+///段の画像は作るときに確保しておき、Applyのたびに使い回す
+class BloomFilter {
+public:
+	///@param width,height 入力画像の大きさ
+	///@param levels 縮小の段の数(BloomLevelCountで減ることがある)
+	BloomFilter(unsigned int width, unsigned int height, unsigned int levels);
+
+	unsigned int LevelCount()const { return static_cast<unsigned int>(levels_.size()); }
+	///段の画像(0が1/2。Applyの後は拡大して足した結果)
+	const ImageRGBA32F& Level(unsigned int level)const { return levels_[level]; }
+	///段の画像の合計のバイト数
+	size_t LevelBytes()const;
+
+	///ブルームをかける(Prefilter→Downsample(1～)→Upsample(～0)→Compositeの順に呼ぶ)
+	///@param src 入力画像(作るときに渡した大きさ)
+	///@param dst 出力画像(srcと同じ大きさにされる。srcと同じでもよい)
+	///@param settings 設定(levelsは使わない)
+	///@param executor nullptrなら呼び出しスレッドだけで処理する
+	void Apply(const ImageRGBA32F& src, ImageRGBA32F& dst, const BloomSettings& settings, ComputeExecutor* executor);
+
+	//ここから段ごとの処理(時間を段ごとに測るため)
+	///入力→0段目(13タップで縮小してしきい値をかける)
+	void Prefilter(const ImageRGBA32F& src, float threshold, float knee, ComputeExecutor* executor);
+	///level-1段目→level段目(13タップで縮小。1～LevelCount()-1)
+	void Downsample(unsigned int level, ComputeExecutor* executor);
+	///level段目 += テントで拡大したlevel+1段目(0～LevelCount()-2)
+	void Upsample(unsigned int level, ComputeExecutor* executor);
+	///dst = src + intensity * テントで拡大した0段目(アルファはsrcのまま)
+	void Composite(const ImageRGBA32F& src, ImageRGBA32F& dst, float intensity, ComputeExecutor* executor);
+
+private:
+	unsigned int width_;
+	unsigned int height_;
+	std::vector<ImageRGBA32F> levels_;
+};
+
+///BloomFilterの基準実装(縮小は13か所を双線形で読み、拡大は3x3か所を双線形で読む。1画素ずつ)
+void BloomReference(const ImageRGBA32F& src, ImageRGBA32F& dst, const BloomSettings& settings);
@@ -0,0 +1,38 @@
+//u[(邢Ƃ̂ɂ)̂lƏkEg̏d
+//BloomCS.hlslCPU(CpuCompute/Bloom.cpp)ŋLĂ܂
+//k(13^bv)́AkỎ摜2x2f̕ς13ďd݂tđB
+//ǂ̃^bv2x2f̂傤ǐ^񒆂ɗ̂ŁAo͂̉fxɑ΂͂2x-2`2x+36x6f
+//̈ʒuŏd݂̂ƓɂȂB̏d݂͊O9(1:2:1)Ɠ4
+//2̕\ȏd(ꂼŜ1/2)̘aɂȂ
+//g(eg)͏摜3x3^bv(1:2:1)œǂތ`ŁA傫摜̉fpɑ΂
+//摜4x4f̕\ȏd݂ɂȂ(p̋ŏd݂E΂ɂȂ)
+//摜̊O͒[̉fJԂ
+
+#define BLOOM_DOWN_TAPS 6
+#define BLOOM_UP_TAPS 4
+
+//k1̏d(͂2x-2珇)BOƓ̌ʂ𔼕
+static const float bloomOuterWeights[BLOOM_DOWN_TAPS] = { 0.125f, 0.125f, 0.25f, 0.25f, 0.125f, 0.125f };
+static const float bloomInnerWeights[BLOOM_DOWN_TAPS] = { 0.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.0f };
+
+//g1̏d([p&1]B摜BloomUpStart(p)珇)
+static const float bloomUpWeights[2][BLOOM_UP_TAPS] = {
+    { 0.0625f, 0.3125f, 0.4375f, 0.1875f },
+    { 0.1875f, 0.4375f, 0.3125f, 0.0625f },
+};
+
+//傫摜̉fpg傷ƂɓǂށA摜̍ŏ̉f
+int BloomUpStart(int p)
+{
+    return (p >> 1) - 2 + (p & 1);
+}
+
+//l𒴂c(kneełȂ߂炩ɂȂBknee=0Ȃ܂)
+//邳͐̍őlőAF͕ςɖ邳𗎂Ƃ
+float3 BloomThreshold(float3 c, float threshold, float knee)
+{
+    float brightness = max(c.r, max(c.g, c.b));
+    float soft = clamp(brightness - threshold + knee, 0.0f, 2.0f * knee);
+    soft = soft * soft / (4.0f * knee + 1e-5f);
+    return c * (max(soft, brightness - threshold) / max(brightness, 1e-5f));
+}
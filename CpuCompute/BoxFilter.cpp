@@ -0,0 +1,895 @@
+﻿#include "BoxFilter.h"
+#include<algorithm>
+#include<cassert>
+#include<functional>
+#include<vector>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+//シェーダと同じ平均・分散の式
+namespace hlsl {
+	namespace {
+#include"BoxFilter.hlsli"
+	}
+}
+
+using namespace std;
+
+namespace {
+	//並列化するときの帯の最小の行数(列の和の版は帯ごとに窓の縦の和を2*radius行まで余分に足すので、radiusの4倍以上にする)
+	constexpr unsigned int minBandRows = 16;
+	//テーブル全体から読むときに1タスクが受け持つ行数
+	constexpr size_t queryGrainRows = 16;
+
+	//ここからR8G8B8A8のテーブルの1行
+	//row[(x+1)*4+c] = prev[(x+1)*4+c] + Σ(0～x) src[x]のc成分(squareなら2乗)。row[0～3]は0
+	//uint32_tの加算は2^32を法として回る(SIMDも同じ)
+
+	void SatRow8Scalar(const uint32_t* src, const uint32_t* prev, uint32_t* row, size_t width, bool square) {
+		uint32_t acc[4] = {};
+		for (int c = 0; c < 4; ++c) {
+			row[c] = 0;
+		}
+		for (size_t x = 0; x < width; ++x) {
+			for (int c = 0; c < 4; ++c) {
+				const uint32_t v = (src[x] >> (c * 8)) & 0xff;
+				acc[c] += square ? v * v : v;
+				row[(x + 1) * 4 + c] = prev[(x + 1) * 4 + c] + acc[c];
+			}
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+	//1画素の4成分をuint32_tにする(squareなら2乗。256未満なので16bitの積和で求まる)
+	CPU_TARGET_SSE41 inline __m128i SatPixelSSE41(uint32_t px, bool square) {
+		auto v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(px)));
+		return square ? _mm_madd_epi16(v, v) : v;
+	}
+
+	CPU_TARGET_SSE41 void SatRow8SSE41(const uint32_t* src, const uint32_t* prev, uint32_t* row, size_t width, bool square) {
+		auto acc = _mm_setzero_si128();
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row), acc);
+		for (size_t x = 0; x < width; ++x) {
+			acc = _mm_add_epi32(acc, SatPixelSSE41(src[x], square));
+			auto p = reinterpret_cast<const __m128i*>(prev + (x + 1) * 4);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + (x + 1) * 4), _mm_add_epi32(_mm_loadu_si128(p), acc));
+		}
+	}
+
+	//2画素ずつ。[p0, p1]を[p0, p0+p1]にしてから前までの和を足す
+	CPU_TARGET_AVX2 void SatRow8AVX2(const uint32_t* src, const uint32_t* prev, uint32_t* row, size_t width, bool square) {
+		auto acc = _mm256_setzero_si256();
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm_setzero_si128());
+		size_t x = 0;
+		for (; x + 2 <= width; x += 2) {
+			auto v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x)));
+			if (square) {
+				v = _mm256_madd_epi16(v, v);
+			}
+			v = _mm256_add_epi32(v, _mm256_permute2x128_si256(v, v, 0x08));
+			v = _mm256_add_epi32(v, acc);
+			auto p = reinterpret_cast<const __m256i*>(prev + (x + 1) * 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(row + (x + 1) * 4), _mm256_add_epi32(_mm256_loadu_si256(p), v));
+			acc = _mm256_permute2x128_si256(v, v, 0x11);
+		}
+		if (x < width) {
+			auto last = _mm_add_epi32(_mm256_castsi256_si128(acc), SatPixelSSE41(src[x], square));
+			auto p = reinterpret_cast<const __m128i*>(prev + (x + 1) * 4);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + (x + 1) * 4), _mm_add_epi32(_mm_loadu_si128(p), last));
+		}
+	}
+
+	//4画素ずつ。128bitのレーンを1つ・2つずらして足すと4画素ぶんの累積になる
+	CPU_TARGET_AVX512 void SatRow8AVX512(const uint32_t* src, const uint32_t* prev, uint32_t* row, size_t width, bool square) {
+		auto acc = _mm512_setzero_si512();
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm_setzero_si128());
+		for (size_t x = 0; x < width; x += 4) {
+			const auto n = static_cast<unsigned int>(min<size_t>(4, width - x));
+			const auto lanes = static_cast<__mmask16>((1u << (n * 4)) - 1);
+			auto v = _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(lanes, src + x));
+			if (square) {
+				v = _mm512_madd_epi16(v, v);
+			}
+			v = _mm512_add_epi32(v, _mm512_maskz_shuffle_i32x4(0xfff0, v, v, _MM_SHUFFLE(2, 1, 0, 0)));
+			v = _mm512_add_epi32(v, _mm512_maskz_shuffle_i32x4(0xff00, v, v, _MM_SHUFFLE(1, 0, 0, 0)));
+			v = _mm512_add_epi32(v, acc);
+			auto p = _mm512_maskz_loadu_epi32(lanes, prev + (x + 1) * 4);
+			_mm512_mask_storeu_epi32(row + (x + 1) * 4, lanes, _mm512_add_epi32(p, v));
+			acc = _mm512_shuffle_i32x4(v, v, 0xff);
+		}
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	void SatRow8NEON(const uint32_t* src, const uint32_t* prev, uint32_t* row, size_t width, bool square) {
+		auto acc = vdupq_n_u32(0);
+		vst1q_u32(row, acc);
+		for (size_t x = 0; x < width; ++x) {
+			auto v = vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(src[x])))));
+			acc = vaddq_u32(acc, square ? vmulq_u32(v, v) : v);
+			vst1q_u32(row + (x + 1) * 4, vaddq_u32(vld1q_u32(prev + (x + 1) * 4), acc));
+		}
+	}
+#endif
+
+	using SatRow8Func = void(*)(const uint32_t* src, const uint32_t* prev, uint32_t* row, size_t width, bool square);
+	Kernel<SatRow8Func> satRow8("satrow8", {
+		{ CpuIsa::Scalar, SatRow8Scalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, SatRow8SSE41 },
+		{ CpuIsa::AVX2, SatRow8AVX2 },
+		{ CpuIsa::AVX512, SatRow8AVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, SatRow8NEON },
+#endif
+	});
+
+	//ここからR8G8B8A8の窓の平均
+	//画素iの窓の和 = bottom[i*4+span] - bottom[i*4] - top[i*4+span] + top[i*4](成分ごと)
+	//top/bottomは窓の上端・下端+1のテーブルの行の、窓の左端の列。spanは窓の幅*4
+	//平均は和×scale(1/画素数)+0.5を切り捨てる(和は2^24未満なのでfloatで正確に表せる)
+	//scalesがnullptrでなければ、画素iはscaleの代わりにscales[i]を使う(窓が左右で切り詰められる端の画素)
+
+	void BoxMean8Scalar(const uint32_t* top, const uint32_t* bottom, size_t span, float scale, const float* scales, uint32_t* dst, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			const float s = scales != nullptr ? scales[i] : scale;
+			uint32_t px = 0;
+			for (int c = 0; c < 4; ++c) {
+				const auto k = i * 4 + c;
+				const uint32_t sum = bottom[k + span] - bottom[k] - top[k + span] + top[k];
+				px |= static_cast<uint32_t>(static_cast<float>(sum) * s + 0.5f) << (c * 8);
+			}
+			dst[i] = px;
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+	CPU_TARGET_SSE41 inline __m128i BoxMeanPixelSSE41(const uint32_t* top, const uint32_t* bottom, size_t span, __m128 scale) {
+		auto a = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + span)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(top)));
+		auto b = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + span)));
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(a, b)), scale), _mm_set1_ps(0.5f)));
+	}
+
+	//画素iの4成分にかける値
+	CPU_TARGET_SSE41 inline __m128 BoxMeanScaleSSE41(const float* scales, size_t i, __m128 scale) {
+		return scales != nullptr ? _mm_set1_ps(scales[i]) : scale;
+	}
+
+	CPU_TARGET_SSE41 void BoxMean8SSE41(const uint32_t* top, const uint32_t* bottom, size_t span, float scale, const float* scales, uint32_t* dst, size_t count) {
+		const auto s = _mm_set1_ps(scale);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto m0 = BoxMeanPixelSSE41(top + i * 4, bottom + i * 4, span, BoxMeanScaleSSE41(scales, i, s));
+			auto m1 = BoxMeanPixelSSE41(top + i * 4 + 4, bottom + i * 4 + 4, span, BoxMeanScaleSSE41(scales, i + 1, s));
+			auto m2 = BoxMeanPixelSSE41(top + i * 4 + 8, bottom + i * 4 + 8, span, BoxMeanScaleSSE41(scales, i + 2, s));
+			auto m3 = BoxMeanPixelSSE41(top + i * 4 + 12, bottom + i * 4 + 12, span, BoxMeanScaleSSE41(scales, i + 3, s));
+			auto packed = _mm_packus_epi16(_mm_packus_epi32(m0, m1), _mm_packus_epi32(m2, m3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+		}
+		BoxMean8Scalar(top + i * 4, bottom + i * 4, span, scale, scales != nullptr ? scales + i : nullptr, dst + i, count - i);
+	}
+
+	CPU_TARGET_AVX2 inline __m256i BoxMeanPixelsAVX2(const uint32_t* top, const uint32_t* bottom, size_t span, __m256 scale) {
+		auto a = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + span)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top)));
+		auto b = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + span)));
+		return _mm256_cvttps_epi32(_mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(a, b)), scale, _mm256_set1_ps(0.5f)));
+	}
+
+	//画素i、i+1の4成分ずつにかける値
+	CPU_TARGET_AVX2 inline __m256 BoxMeanScalesAVX2(const float* scales, size_t i, __m256 scale) {
+		return scales != nullptr ? _mm256_set_m128(_mm_set1_ps(scales[i + 1]), _mm_set1_ps(scales[i])) : scale;
+	}
+
+	//8画素ずつ。packusはレーンごとなので、最後に画素の順に並べ直す
+	CPU_TARGET_AVX2 void BoxMean8AVX2(const uint32_t* top, const uint32_t* bottom, size_t span, float scale, const float* scales, uint32_t* dst, size_t count) {
+		const auto s = _mm256_set1_ps(scale);
+		const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			auto m0 = BoxMeanPixelsAVX2(top + i * 4, bottom + i * 4, span, BoxMeanScalesAVX2(scales, i, s));
+			auto m1 = BoxMeanPixelsAVX2(top + i * 4 + 8, bottom + i * 4 + 8, span, BoxMeanScalesAVX2(scales, i + 2, s));
+			auto m2 = BoxMeanPixelsAVX2(top + i * 4 + 16, bottom + i * 4 + 16, span, BoxMeanScalesAVX2(scales, i + 4, s));
+			auto m3 = BoxMeanPixelsAVX2(top + i * 4 + 24, bottom + i * 4 + 24, span, BoxMeanScalesAVX2(scales, i + 6, s));
+			auto packed = _mm256_packus_epi16(_mm256_packus_epi32(m0, m1), _mm256_packus_epi32(m2, m3));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permutevar8x32_epi32(packed, order));
+		}
+		//端数もVEXの命令で(SSEの命令で書いたBoxMean8Scalarに移ると、AVXとの切り替えで遅くなる)
+		const auto s1 = _mm_set1_ps(scale);
+		for (; i < count; ++i) {
+			auto a = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + i * 4 + span)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + i * 4)));
+			auto b = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + i * 4)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + i * 4 + span)));
+			auto m = _mm_cvttps_epi32(_mm_fmadd_ps(_mm_cvtepi32_ps(_mm_sub_epi32(a, b)), scales != nullptr ? _mm_set1_ps(scales[i]) : s1, _mm_set1_ps(0.5f)));
+			m = _mm_packus_epi16(_mm_packus_epi32(m, m), m);
+			dst[i] = static_cast<uint32_t>(_mm_cvtsi128_si32(m));
+		}
+	}
+
+	CPU_TARGET_AVX512 void BoxMean8AVX512(const uint32_t* top, const uint32_t* bottom, size_t span, float scale, const float* scales, uint32_t* dst, size_t count) {
+		const auto s = _mm512_set1_ps(scale);
+		const auto half = _mm512_set1_ps(0.5f);
+		//4画素ぶんのscalesを画素ごとに4成分へ広げる
+		const auto spread = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto a = _mm512_add_epi32(_mm512_loadu_si512(bottom + i * 4 + span), _mm512_loadu_si512(top + i * 4));
+			auto b = _mm512_add_epi32(_mm512_loadu_si512(bottom + i * 4), _mm512_loadu_si512(top + i * 4 + span));
+			auto scale4 = scales != nullptr ? _mm512_permutexvar_ps(spread, _mm512_castps128_ps512(_mm_loadu_ps(scales + i))) : s;
+			auto m = _mm512_cvttps_epi32(_mm512_fmadd_ps(_mm512_cvtepi32_ps(_mm512_sub_epi32(a, b)), scale4, half));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm512_cvtusepi32_epi8(m));
+		}
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		BoxMean8Scalar(top + i * 4, bottom + i * 4, span, scale, scales != nullptr ? scales + i : nullptr, dst + i, count - i);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	inline uint32x4_t BoxMeanPixelNEON(const uint32_t* top, const uint32_t* bottom, size_t span, float32x4_t scale) {
+		auto sum = vsubq_u32(vaddq_u32(vld1q_u32(bottom + span), vld1q_u32(top)), vaddq_u32(vld1q_u32(bottom), vld1q_u32(top + span)));
+		return vcvtq_u32_f32(vfmaq_f32(vdupq_n_f32(0.5f), vcvtq_f32_u32(sum), scale));
+	}
+
+	inline float32x4_t BoxMeanScaleNEON(const float* scales, size_t i, float32x4_t scale) {
+		return scales != nullptr ? vdupq_n_f32(scales[i]) : scale;
+	}
+
+	void BoxMean8NEON(const uint32_t* top, const uint32_t* bottom, size_t span, float scale, const float* scales, uint32_t* dst, size_t count) {
+		const auto s = vdupq_n_f32(scale);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto m01 = vcombine_u16(vmovn_u32(BoxMeanPixelNEON(top + i * 4, bottom + i * 4, span, BoxMeanScaleNEON(scales, i, s))),
+				vmovn_u32(BoxMeanPixelNEON(top + i * 4 + 4, bottom + i * 4 + 4, span, BoxMeanScaleNEON(scales, i + 1, s))));
+			auto m23 = vcombine_u16(vmovn_u32(BoxMeanPixelNEON(top + i * 4 + 8, bottom + i * 4 + 8, span, BoxMeanScaleNEON(scales, i + 2, s))),
+				vmovn_u32(BoxMeanPixelNEON(top + i * 4 + 12, bottom + i * 4 + 12, span, BoxMeanScaleNEON(scales, i + 3, s))));
+			vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), vcombine_u8(vmovn_u16(m01), vmovn_u16(m23)));
+		}
+		BoxMean8Scalar(top + i * 4, bottom + i * 4, span, scale, scales != nullptr ? scales + i : nullptr, dst + i, count - i);
+	}
+#endif
+
+	using BoxMean8Func = void(*)(const uint32_t* top, const uint32_t* bottom, size_t span, float scale, const float* scales, uint32_t* dst, size_t count);
+	Kernel<BoxMean8Func> boxMean8("boxmean8", {
+		{ CpuIsa::Scalar, BoxMean8Scalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, BoxMean8SSE41 },
+		{ CpuIsa::AVX2, BoxMean8AVX2 },
+		{ CpuIsa::AVX512, BoxMean8AVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, BoxMean8NEON },
+#endif
+	});
+
+	//ここから列ごとの縦の和を1行ずつずらす(テーブルを全体には作らない版)
+	//columns[x*4+c] += add[x]のc成分 - sub[x]のc成分(squareなら2乗)。add・subはnullptrなら足さない・引かない
+	//row[(x+1)*4+c] = Σ(0～x) columns[x*4+c]。row[0～3]は0(窓の上端の行を0とみなしたテーブルの下端+1の行になる)
+
+	void BoxColumns8Scalar(const uint32_t* add, const uint32_t* sub, uint32_t* columns, uint32_t* row, size_t width, bool square) {
+		uint32_t acc[4] = {};
+		for (int c = 0; c < 4; ++c) {
+			row[c] = 0;
+		}
+		for (size_t x = 0; x < width; ++x) {
+			for (int c = 0; c < 4; ++c) {
+				auto& column = columns[x * 4 + c];
+				if (add != nullptr) {
+					const uint32_t v = (add[x] >> (c * 8)) & 0xff;
+					column += square ? v * v : v;
+				}
+				if (sub != nullptr) {
+					const uint32_t v = (sub[x] >> (c * 8)) & 0xff;
+					column -= square ? v * v : v;
+				}
+				acc[c] += column;
+				row[(x + 1) * 4 + c] = acc[c];
+			}
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+	CPU_TARGET_SSE41 void BoxColumns8SSE41(const uint32_t* add, const uint32_t* sub, uint32_t* columns, uint32_t* row, size_t width, bool square) {
+		auto acc = _mm_setzero_si128();
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row), acc);
+		for (size_t x = 0; x < width; ++x) {
+			auto p = reinterpret_cast<__m128i*>(columns + x * 4);
+			auto column = _mm_loadu_si128(p);
+			if (add != nullptr) {
+				column = _mm_add_epi32(column, SatPixelSSE41(add[x], square));
+			}
+			if (sub != nullptr) {
+				column = _mm_sub_epi32(column, SatPixelSSE41(sub[x], square));
+			}
+			_mm_storeu_si128(p, column);
+			acc = _mm_add_epi32(acc, column);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + (x + 1) * 4), acc);
+		}
+	}
+
+	CPU_TARGET_AVX2 inline __m256i BoxColumnPixelsAVX2(const uint32_t* src, bool square) {
+		auto v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+		return square ? _mm256_madd_epi16(v, v) : v;
+	}
+
+	//2画素ずつ。横の累積はSatRow8AVX2と同じ
+	CPU_TARGET_AVX2 void BoxColumns8AVX2(const uint32_t* add, const uint32_t* sub, uint32_t* columns, uint32_t* row, size_t width, bool square) {
+		auto acc = _mm256_setzero_si256();
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm_setzero_si128());
+		size_t x = 0;
+		for (; x + 2 <= width; x += 2) {
+			auto p = reinterpret_cast<__m256i*>(columns + x * 4);
+			auto column = _mm256_loadu_si256(p);
+			if (add != nullptr) {
+				column = _mm256_add_epi32(column, BoxColumnPixelsAVX2(add + x, square));
+			}
+			if (sub != nullptr) {
+				column = _mm256_sub_epi32(column, BoxColumnPixelsAVX2(sub + x, square));
+			}
+			_mm256_storeu_si256(p, column);
+			auto v = _mm256_add_epi32(column, _mm256_permute2x128_si256(column, column, 0x08));
+			v = _mm256_add_epi32(v, acc);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(row + (x + 1) * 4), v);
+			acc = _mm256_permute2x128_si256(v, v, 0x11);
+		}
+		if (x < width) {
+			auto p = reinterpret_cast<__m128i*>(columns + x * 4);
+			auto column = _mm_loadu_si128(p);
+			if (add != nullptr) {
+				column = _mm_add_epi32(column, SatPixelSSE41(add[x], square));
+			}
+			if (sub != nullptr) {
+				column = _mm_sub_epi32(column, SatPixelSSE41(sub[x], square));
+			}
+			_mm_storeu_si128(p, column);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + (x + 1) * 4), _mm_add_epi32(_mm256_castsi256_si128(acc), column));
+		}
+	}
+
+	CPU_TARGET_AVX512 inline __m512i BoxColumnPixelsAVX512(const uint32_t* src, __mmask16 lanes, bool square) {
+		auto v = _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(lanes, src));
+		return square ? _mm512_madd_epi16(v, v) : v;
+	}
+
+	//4画素ずつ。横の累積はSatRow8AVX512と同じ
+	CPU_TARGET_AVX512 void BoxColumns8AVX512(const uint32_t* add, const uint32_t* sub, uint32_t* columns, uint32_t* row, size_t width, bool square) {
+		auto acc = _mm512_setzero_si512();
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm_setzero_si128());
+		for (size_t x = 0; x < width; x += 4) {
+			const auto n = static_cast<unsigned int>(min<size_t>(4, width - x));
+			const auto lanes = static_cast<__mmask16>((1u << (n * 4)) - 1);
+			auto column = _mm512_maskz_loadu_epi32(lanes, columns + x * 4);
+			if (add != nullptr) {
+				column = _mm512_add_epi32(column, BoxColumnPixelsAVX512(add + x, lanes, square));
+			}
+			if (sub != nullptr) {
+				column = _mm512_sub_epi32(column, BoxColumnPixelsAVX512(sub + x, lanes, square));
+			}
+			_mm512_mask_storeu_epi32(columns + x * 4, lanes, column);
+			auto v = _mm512_add_epi32(column, _mm512_maskz_shuffle_i32x4(0xfff0, column, column, _MM_SHUFFLE(2, 1, 0, 0)));
+			v = _mm512_add_epi32(v, _mm512_maskz_shuffle_i32x4(0xff00, v, v, _MM_SHUFFLE(1, 0, 0, 0)));
+			v = _mm512_add_epi32(v, acc);
+			_mm512_mask_storeu_epi32(row + (x + 1) * 4, lanes, v);
+			acc = _mm512_shuffle_i32x4(v, v, 0xff);
+		}
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	inline uint32x4_t BoxColumnPixelNEON(uint32_t px, bool square) {
+		auto v = vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(px)))));
+		return square ? vmulq_u32(v, v) : v;
+	}
+
+	void BoxColumns8NEON(const uint32_t* add, const uint32_t* sub, uint32_t* columns, uint32_t* row, size_t width, bool square) {
+		auto acc = vdupq_n_u32(0);
+		vst1q_u32(row, acc);
+		for (size_t x = 0; x < width; ++x) {
+			auto column = vld1q_u32(columns + x * 4);
+			if (add != nullptr) {
+				column = vaddq_u32(column, BoxColumnPixelNEON(add[x], square));
+			}
+			if (sub != nullptr) {
+				column = vsubq_u32(column, BoxColumnPixelNEON(sub[x], square));
+			}
+			vst1q_u32(columns + x * 4, column);
+			acc = vaddq_u32(acc, column);
+			vst1q_u32(row + (x + 1) * 4, acc);
+		}
+	}
+#endif
+
+	using BoxColumns8Func = void(*)(const uint32_t* add, const uint32_t* sub, uint32_t* columns, uint32_t* row, size_t width, bool square);
+	Kernel<BoxColumns8Func> boxColumns8("boxcols8", {
+		{ CpuIsa::Scalar, BoxColumns8Scalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, BoxColumns8SSE41 },
+		{ CpuIsa::AVX2, BoxColumns8AVX2 },
+		{ CpuIsa::AVX512, BoxColumns8AVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, BoxColumns8NEON },
+#endif
+	});
+
+	//ここからテーブルの行を作る(型ごと)
+	//floatは画素からoffsetを引いてdoubleで足す
+
+	void BuildRow(const uint32_t* src, const uint32_t* prevSums, uint32_t* sums, const uint32_t* prevSquares, uint32_t* squares, unsigned int width, const hlsl::float4&) {
+		auto satRow = satRow8.Get();
+		satRow(src, prevSums, sums, width, false);
+		if (squares != nullptr) {
+			satRow(src, prevSquares, squares, width, true);
+		}
+	}
+
+	void BuildRow(const hlsl::float4* src, const double* prevSums, double* sums, const double* prevSquares, double* squares, unsigned int width, const hlsl::float4& offset) {
+		double acc[4] = {};
+		double accSquare[4] = {};
+		for (int c = 0; c < 4; ++c) {
+			sums[c] = 0.0;
+			if (squares != nullptr) {
+				squares[c] = 0.0;
+			}
+		}
+		for (size_t x = 0; x < width; ++x) {
+			for (int c = 0; c < 4; ++c) {
+				const double v = static_cast<double>(src[x][c]) - offset[c];
+				acc[c] += v;
+				sums[(x + 1) * 4 + c] = prevSums[(x + 1) * 4 + c] + acc[c];
+				if (squares != nullptr) {
+					accSquare[c] += v * v;
+					squares[(x + 1) * 4 + c] = prevSquares[(x + 1) * 4 + c] + accSquare[c];
+				}
+			}
+		}
+	}
+
+	//列ごとの縦の和に1行を足す(帯の先頭行を求める1回目の読み込み)
+	void AddColumns(const uint32_t* src, uint32_t* sums, uint32_t* squares, unsigned int width, const hlsl::float4&) {
+		for (size_t x = 0; x < width; ++x) {
+			for (int c = 0; c < 4; ++c) {
+				const uint32_t v = (src[x] >> (c * 8)) & 0xff;
+				sums[x * 4 + c] += v;
+				if (squares != nullptr) {
+					squares[x * 4 + c] += v * v;
+				}
+			}
+		}
+	}
+
+	void AddColumns(const hlsl::float4* src, double* sums, double* squares, unsigned int width, const hlsl::float4& offset) {
+		for (size_t x = 0; x < width; ++x) {
+			for (int c = 0; c < 4; ++c) {
+				const double v = static_cast<double>(src[x][c]) - offset[c];
+				sums[x * 4 + c] += v;
+				if (squares != nullptr) {
+					squares[x * 4 + c] += v * v;
+				}
+			}
+		}
+	}
+
+	//列ごとの縦の和をaddの行を足してsubの行を引いた窓にずらし、横に累積した行を作る(型ごと)
+	//add・subはnullptrなら足さない・引かない
+
+	void ShiftColumns(const uint32_t* add, const uint32_t* sub, uint32_t* columns, uint32_t* row, uint32_t* columnSquares, uint32_t* squares, unsigned int width, const hlsl::float4&) {
+		auto boxColumns = boxColumns8.Get();
+		boxColumns(add, sub, columns, row, width, false);
+		if (squares != nullptr) {
+			boxColumns(add, sub, columnSquares, squares, width, true);
+		}
+	}
+
+	void ShiftColumns(const hlsl::float4* add, const hlsl::float4* sub, double* columns, double* row, double* columnSquares, double* squares, unsigned int width, const hlsl::float4& offset) {
+		double acc[4] = {};
+		double accSquare[4] = {};
+		for (int c = 0; c < 4; ++c) {
+			row[c] = 0.0;
+			if (squares != nullptr) {
+				squares[c] = 0.0;
+			}
+		}
+		for (size_t x = 0; x < width; ++x) {
+			for (int c = 0; c < 4; ++c) {
+				const double a = add != nullptr ? static_cast<double>(add[x][c]) - offset[c] : 0.0;
+				const double s = sub != nullptr ? static_cast<double>(sub[x][c]) - offset[c] : 0.0;
+				columns[x * 4 + c] += a - s;
+				acc[c] += columns[x * 4 + c];
+				row[(x + 1) * 4 + c] = acc[c];
+				if (squares != nullptr) {
+					columnSquares[x * 4 + c] += a * a - s * s;
+					accSquare[c] += columnSquares[x * 4 + c];
+					squares[(x + 1) * 4 + c] = accSquare[c];
+				}
+			}
+		}
+	}
+
+	//出力の1行に使うテーブルの2行(窓の上端の行と下端+1の行)
+	template<typename T>
+	struct RowPair {
+		const T* topSums;
+		const T* bottomSums;
+		const T* topSquares;
+		const T* bottomSquares;
+		unsigned int rows;//窓の縦の画素数(切り詰めたあと)
+		unsigned int pad;//Sumsの行の左右に足した列の数(左は0列目、右はwidth列目と同じ値)
+	};
+
+	//ここから出力の1行(横の窓は画像の中に切り詰める)
+
+	void MeanRow(const RowPair<uint32_t>& pair, unsigned int width, unsigned int radius, const hlsl::float4&, uint32_t* dst) {
+		auto boxMean = boxMean8.Get();
+		const int w = static_cast<int>(width);
+		const int r = static_cast<int>(radius);
+		//窓が切り詰められない画素はまとめて
+		const int inBegin = min(r, w);
+		const int inEnd = max(inBegin, w - r);
+		if (inEnd > inBegin) {
+			boxMean(pair.topSums + (inBegin - r) * 4, pair.bottomSums + (inBegin - r) * 4, (2 * r + 1) * 4,
+				1.0f / static_cast<float>((2 * r + 1) * pair.rows), nullptr, dst + inBegin, inEnd - inBegin);
+		}
+		//端の画素は、行の左右にradius列以上足してあれば同じ窓の幅で和が求まるので、画素ごとの1/画素数を添えてまとめて
+		//(足していなければ1画素ずつ)
+		auto edges = [&](int begin, int end) {
+			if (pair.pad >= radius) {
+				float scales[64];
+				for (int x = begin; x < end; x += 64) {
+					const int n = min(end - x, 64);
+					for (int i = 0; i < n; ++i) {
+						const int x0 = max(x + i - r, 0);
+						const int x1 = min(x + i + r, w - 1) + 1;
+						scales[i] = 1.0f / static_cast<float>((x1 - x0) * pair.rows);
+					}
+					boxMean(pair.topSums + (x - r) * 4, pair.bottomSums + (x - r) * 4, (2 * r + 1) * 4, 0.0f, scales, dst + x, n);
+				}
+				return;
+			}
+			for (int x = begin; x < end; ++x) {
+				const int x0 = max(x - r, 0);
+				const int x1 = min(x + r, w - 1) + 1;
+				boxMean(pair.topSums + x0 * 4, pair.bottomSums + x0 * 4, (x1 - x0) * 4, 1.0f / static_cast<float>((x1 - x0) * pair.rows), nullptr, dst + x, 1);
+			}
+		};
+		edges(0, inBegin);
+		edges(inEnd, w);
+	}
+
+	void MeanRow(const RowPair<double>& pair, unsigned int width, unsigned int radius, const hlsl::float4& offset, hlsl::float4* dst) {
+		const int w = static_cast<int>(width);
+		const int r = static_cast<int>(radius);
+		for (int x = 0; x < w; ++x) {
+			const int x0 = max(x - r, 0) * 4;
+			const int x1 = (min(x + r, w - 1) + 1) * 4;
+			const double count = static_cast<double>((x1 - x0) / 4 * pair.rows);
+			for (int c = 0; c < 4; ++c) {
+				const double sum = pair.bottomSums[x1 + c] - pair.bottomSums[x0 + c] - pair.topSums[x1 + c] + pair.topSums[x0 + c];
+				dst[x][c] = static_cast<float>(sum / count + offset[c]);
+			}
+		}
+	}
+
+	void MeanVarianceRow(const RowPair<uint32_t>& pair, unsigned int width, unsigned int radius, const hlsl::float4&, hlsl::float4* mean, hlsl::float4* variance) {
+		const int w = static_cast<int>(width);
+		const int r = static_cast<int>(radius);
+		for (int x = 0; x < w; ++x) {
+			const int x0 = max(x - r, 0) * 4;
+			const int x1 = (min(x + r, w - 1) + 1) * 4;
+			const auto count = static_cast<hlsl::uint>((x1 - x0) / 4 * pair.rows);
+			hlsl::uint4 sum, squares;
+			for (int c = 0; c < 4; ++c) {
+				sum[c] = pair.bottomSums[x1 + c] - pair.bottomSums[x0 + c] - pair.topSums[x1 + c] + pair.topSums[x0 + c];
+				squares[c] = pair.bottomSquares[x1 + c] - pair.bottomSquares[x0 + c] - pair.topSquares[x1 + c] + pair.topSquares[x0 + c];
+			}
+			mean[x] = hlsl::BoxMean8(sum, count);
+			variance[x] = hlsl::BoxVariance8(sum, squares, count);
+		}
+	}
+
+	//分散は値をずらしても変わらないので、ずらした値のままE[x^2] - E[x]^2で求める
+	void MeanVarianceRow(const RowPair<double>& pair, unsigned int width, unsigned int radius, const hlsl::float4& offset, hlsl::float4* mean, hlsl::float4* variance) {
+		const int w = static_cast<int>(width);
+		const int r = static_cast<int>(radius);
+		for (int x = 0; x < w; ++x) {
+			const int x0 = max(x - r, 0) * 4;
+			const int x1 = (min(x + r, w - 1) + 1) * 4;
+			const double count = static_cast<double>((x1 - x0) / 4 * pair.rows);
+			for (int c = 0; c < 4; ++c) {
+				const double m = (pair.bottomSums[x1 + c] - pair.bottomSums[x0 + c] - pair.topSums[x1 + c] + pair.topSums[x0 + c]) / count;
+				const double m2 = (pair.bottomSquares[x1 + c] - pair.bottomSquares[x0 + c] - pair.topSquares[x1 + c] + pair.topSquares[x0 + c]) / count;
+				mean[x][c] = static_cast<float>(m + offset[c]);
+				variance[x][c] = static_cast<float>(max(m2 - m * m, 0.0));
+			}
+		}
+	}
+
+	//窓の上端の行と、下端+1の行
+	inline void WindowRows(int y, int radius, int height, int& top, int& bottom) {
+		top = max(y - radius, 0);
+		bottom = min(y + radius, height - 1) + 1;
+	}
+
+	//帯の数(並列化しないなら1つ)
+	unsigned int BandCount(unsigned int height, unsigned int minRows, ComputeExecutor* executor) {
+		if (executor == nullptr || executor->ThreadCount() <= 1) {
+			return 1;
+		}
+		return max(1u, min(height / max(minRows, 1u), executor->ThreadCount() * 2));
+	}
+
+	void RunTasks(size_t taskNum, size_t grain, ComputeExecutor* executor, const function<void(size_t, size_t)>& func) {
+		if (taskNum > 1 && executor != nullptr) {
+			executor->ParallelFor(taskNum, grain, func);
+		}
+		else {
+			func(0, taskNum);
+		}
+	}
+
+	template<typename Pixel, typename T>
+	void BuildTable(const Image<Pixel>& src, SummedAreaTable<T>& table, bool withSquares, const hlsl::float4& offset, ComputeExecutor* executor) {
+		const unsigned int width = src.width;
+		const unsigned int height = src.height;
+		table.width = width;
+		table.height = height;
+		table.offset = offset;
+		const size_t stride = table.Stride();
+		table.sums.resize(stride * (height + 1));
+		table.squares.resize(withSquares ? stride * (height + 1) : 0);
+		auto sumRow = [&](unsigned int y) { return table.sums.data() + y * stride; };
+		auto squareRow = [&](unsigned int y) { return withSquares ? table.squares.data() + y * stride : nullptr; };
+		fill(sumRow(0), sumRow(0) + stride, T(0));
+		if (withSquares) {
+			fill(squareRow(0), squareRow(0) + stride, T(0));
+		}
+
+		const unsigned int bandNum = BandCount(height, minBandRows, executor);
+		auto bandBegin = [&](unsigned int band) {
+			return static_cast<unsigned int>(static_cast<uint64_t>(height) * band / bandNum);
+		};
+		if (bandNum > 1) {
+			//1回目:帯ごとの列の縦の和
+			vector<T> columns(static_cast<size_t>(bandNum) * width * 4, T(0));
+			vector<T> columnSquares(withSquares ? columns.size() : 0, T(0));
+			RunTasks(bandNum - 1, 1, executor, [&](size_t begin, size_t end) {
+				for (auto b = begin; b < end; ++b) {
+					auto band = static_cast<unsigned int>(b);
+					for (auto y = bandBegin(band); y < bandBegin(band + 1); ++y) {
+						AddColumns(src.Row(y), columns.data() + b * width * 4, withSquares ? columnSquares.data() + b * width * 4 : nullptr, width, offset);
+					}
+				}
+			});
+			//帯の先頭行 = 前の帯の先頭行 + 前の帯の列の和を横に累積したもの
+			auto addPrefix = [&](const T* prevRow, const T* column, T* row) {
+				T acc[4] = {};
+				for (int c = 0; c < 4; ++c) {
+					row[c] = T(0);
+				}
+				for (size_t x = 0; x < width; ++x) {
+					for (int c = 0; c < 4; ++c) {
+						acc[c] += column[x * 4 + c];
+						row[(x + 1) * 4 + c] = prevRow[(x + 1) * 4 + c] + acc[c];
+					}
+				}
+			};
+			for (unsigned int band = 1; band < bandNum; ++band) {
+				addPrefix(sumRow(bandBegin(band - 1)), columns.data() + (band - 1) * width * 4, sumRow(bandBegin(band)));
+				if (withSquares) {
+					addPrefix(squareRow(bandBegin(band - 1)), columnSquares.data() + (band - 1) * width * 4, squareRow(bandBegin(band)));
+				}
+			}
+		}
+		//2回目:帯ごとに先頭行から積み上げる
+		RunTasks(bandNum, 1, executor, [&](size_t begin, size_t end) {
+			for (auto b = begin; b < end; ++b) {
+				auto band = static_cast<unsigned int>(b);
+				for (auto y = bandBegin(band); y < bandBegin(band + 1); ++y) {
+					BuildRow(src.Row(y), sumRow(y), sumRow(y + 1), squareRow(y), squareRow(y + 1), width, offset);
+				}
+			}
+		});
+	}
+
+	//テーブル全体から、出力の行ごとにquery(y, RowPair)を呼ぶ
+	template<typename T, typename Query>
+	void QueryTable(const SummedAreaTable<T>& table, unsigned int radius, ComputeExecutor* executor, Query query) {
+		const bool withSquares = !table.squares.empty();
+		RunTasks(table.height, queryGrainRows, executor, [&](size_t begin, size_t end) {
+			for (auto y = begin; y < end; ++y) {
+				int top, bottom;
+				WindowRows(static_cast<int>(y), static_cast<int>(radius), static_cast<int>(table.height), top, bottom);
+				RowPair<T> pair = { table.SumRow(top), table.SumRow(bottom),
+					withSquares ? table.SquareRow(top) : nullptr, withSquares ? table.SquareRow(bottom) : nullptr, static_cast<unsigned int>(bottom - top), 0 };
+				query(static_cast<unsigned int>(y), pair);
+			}
+		});
+	}
+
+	//テーブルを全体には作らずに、出力の行ごとにquery(y, RowPair)を呼ぶ
+	//帯ごとに、列ごとの窓の縦の和を1行だけ持ち、出力の行が下がるたびに窓の下に入る行を足して上から出る行を引く
+	//それを横に累積した行は、窓の上端の行を0とみなしたテーブルの下端+1の行なので、上端の行を0の行にしたRowPairで読める
+	//作業用の行は数行なので、大きい半径でもキャッシュから出ない
+	//和の行は左右にradius列ずつ足して、MeanRowが端の画素も窓の幅をそろえてまとめて読めるようにする
+	template<typename T, typename Pixel, typename Query>
+	void QueryColumns(const Image<Pixel>& src, unsigned int radius, bool withSquares, const hlsl::float4& offset, ComputeExecutor* executor, Query query) {
+		const int height = static_cast<int>(src.height);
+		const int r = static_cast<int>(radius);
+		const size_t stride = (static_cast<size_t>(src.width) + 1) * 4;
+		const unsigned int bandNum = BandCount(src.height, max(minBandRows, 4 * radius), executor);
+		RunTasks(bandNum, 1, executor, [&](size_t begin, size_t end) {
+			//和の行の0列目はpadded[r*4]
+			vector<T> zeros(stride + static_cast<size_t>(r) * 8, T(0));
+			vector<T> columns(stride), padded(zeros.size(), T(0));
+			T* row = padded.data() + r * 4;
+			vector<T> columnSquares(withSquares ? stride : 0), squares(withSquares ? stride : 0);
+			for (auto b = begin; b < end; ++b) {
+				const int y0 = static_cast<int>(static_cast<uint64_t>(height) * b / bandNum);
+				const int y1 = static_cast<int>(static_cast<uint64_t>(height) * (b + 1) / bandNum);
+				fill(columns.begin(), columns.end(), T(0));
+				fill(columnSquares.begin(), columnSquares.end(), T(0));
+				//columnsは[removed, added)の行の和
+				int added = max(y0 - r, 0);
+				int removed = added;
+				for (int y = y0; y < y1; ++y) {
+					int top, bottom;
+					WindowRows(y, r, height, top, bottom);
+					//帯の最初の行は窓の下端の手前まで足しておく
+					for (; added + 1 < bottom; ++added) {
+						ShiftColumns(src.Row(static_cast<unsigned int>(added)), nullptr, columns.data(), row,
+							columnSquares.data(), withSquares ? squares.data() : nullptr, src.width, offset);
+					}
+					//窓は1行に1行までしか動かない
+					const Pixel* add = added < bottom ? src.Row(static_cast<unsigned int>(added++)) : nullptr;
+					const Pixel* sub = removed < top ? src.Row(static_cast<unsigned int>(removed++)) : nullptr;
+					assert(added == bottom && removed == top);
+					ShiftColumns(add, sub, columns.data(), row, columnSquares.data(), withSquares ? squares.data() : nullptr, src.width, offset);
+					//右に足した列はwidth列目と同じ値(左は0のまま)
+					for (size_t k = stride; k < stride + r * 4; k += 4) {
+						copy(row + stride - 4, row + stride, row + k);
+					}
+					RowPair<T> pair = { zeros.data() + r * 4, row, withSquares ? zeros.data() : nullptr, withSquares ? squares.data() : nullptr,
+						static_cast<unsigned int>(bottom - top), radius };
+					query(static_cast<unsigned int>(y), pair);
+				}
+			}
+		});
+	}
+
+	//floatのテーブルで画素から引く値(左上の画素。分散の桁落ちを抑える)
+	hlsl::float4 TableOffset(const ImageRGBA32F& src) {
+		return src.pixels.empty() ? hlsl::float4(0.0f) : src.pixels[0];
+	}
+
+	template<typename Pixel>
+	void Resize(Image<Pixel>& img, unsigned int width, unsigned int height) {
+		img.width = width;
+		img.height = height;
+		img.pixels.resize(static_cast<size_t>(width) * height);
+	}
+}
+
+void
+BuildSummedAreaTable(const ImageRGBA8& src, SummedAreaTable8& table, bool withSquares, ComputeExecutor* executor) {
+	BuildTable(src, table, withSquares, hlsl::float4(0.0f), executor);
+}
+
+void
+BuildSummedAreaTable(const ImageRGBA32F& src, SummedAreaTableF& table, bool withSquares, ComputeExecutor* executor) {
+	BuildTable(src, table, withSquares, TableOffset(src), executor);
+}
+
+void
+BoxFilter(const SummedAreaTable8& table, ImageRGBA8& dst, unsigned int radius, ComputeExecutor* executor) {
+	Resize(dst, table.width, table.height);
+	QueryTable(table, radius, executor, [&](unsigned int y, const RowPair<uint32_t>& pair) {
+		MeanRow(pair, table.width, radius, table.offset, dst.Row(y));
+	});
+}
+
+void
+BoxFilter(const SummedAreaTableF& table, ImageRGBA32F& dst, unsigned int radius, ComputeExecutor* executor) {
+	Resize(dst, table.width, table.height);
+	QueryTable(table, radius, executor, [&](unsigned int y, const RowPair<double>& pair) {
+		MeanRow(pair, table.width, radius, table.offset, dst.Row(y));
+	});
+}
+
+void
+BoxMeanVariance(const SummedAreaTable8& table, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius, ComputeExecutor* executor) {
+	assert(!table.squares.empty() && radius <= maxBoxVarianceRadius);
+	Resize(mean, table.width, table.height);
+	Resize(variance, table.width, table.height);
+	QueryTable(table, radius, executor, [&](unsigned int y, const RowPair<uint32_t>& pair) {
+		MeanVarianceRow(pair, table.width, radius, table.offset, mean.Row(y), variance.Row(y));
+	});
+}
+
+void
+BoxMeanVariance(const SummedAreaTableF& table, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius, ComputeExecutor* executor) {
+	assert(!table.squares.empty());
+	Resize(mean, table.width, table.height);
+	Resize(variance, table.width, table.height);
+	QueryTable(table, radius, executor, [&](unsigned int y, const RowPair<double>& pair) {
+		MeanVarianceRow(pair, table.width, radius, table.offset, mean.Row(y), variance.Row(y));
+	});
+}
+
+void
+BoxFilter(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, ComputeExecutor* executor) {
+	assert(&src != &dst);
+	Resize(dst, src.width, src.height);
+	const hlsl::float4 offset(0.0f);
+	QueryColumns<uint32_t>(src, radius, false, offset, executor, [&](unsigned int y, const RowPair<uint32_t>& pair) {
+		MeanRow(pair, src.width, radius, offset, dst.Row(y));
+	});
+}
+
+void
+BoxFilter(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int radius, ComputeExecutor* executor) {
+	assert(&src != &dst);
+	Resize(dst, src.width, src.height);
+	const auto offset = TableOffset(src);
+	QueryColumns<double>(src, radius, false, offset, executor, [&](unsigned int y, const RowPair<double>& pair) {
+		MeanRow(pair, src.width, radius, offset, dst.Row(y));
+	});
+}
+
+void
+BoxMeanVariance(const ImageRGBA8& src, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius, ComputeExecutor* executor) {
+	assert(radius <= maxBoxVarianceRadius);
+	Resize(mean, src.width, src.height);
+	Resize(variance, src.width, src.height);
+	const hlsl::float4 offset(0.0f);
+	QueryColumns<uint32_t>(src, radius, true, offset, executor, [&](unsigned int y, const RowPair<uint32_t>& pair) {
+		MeanVarianceRow(pair, src.width, radius, offset, mean.Row(y), variance.Row(y));
+	});
+}
+
+void
+BoxMeanVariance(const ImageRGBA32F& src, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius, ComputeExecutor* executor) {
+	Resize(mean, src.width, src.height);
+	Resize(variance, src.width, src.height);
+	const auto offset = TableOffset(src);
+	QueryColumns<double>(src, radius, true, offset, executor, [&](unsigned int y, const RowPair<double>& pair) {
+		MeanVarianceRow(pair, src.width, radius, offset, mean.Row(y), variance.Row(y));
+	});
+}
+
+void
+BoxMeanVarianceReference(const ImageRGBA32F& src, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius) {
+	const int r = static_cast<int>(radius);
+	const int w = static_cast<int>(src.width);
+	const int h = static_cast<int>(src.height);
+	mean = ImageRGBA32F(src.width, src.height);
+	variance = ImageRGBA32F(src.width, src.height);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			double sum[4] = {};
+			double count = 0.0;
+			for (int yy = max(y - r, 0); yy <= min(y + r, h - 1); ++yy) {
+				for (int xx = max(x - r, 0); xx <= min(x + r, w - 1); ++xx) {
+					for (int c = 0; c < 4; ++c) {
+						sum[c] += src.At(xx, yy)[c];
+					}
+					count += 1.0;
+				}
+			}
+			//分散は平均からの差の2乗で(桁落ちしない2回読み)
+			double squares[4] = {};
+			for (int yy = max(y - r, 0); yy <= min(y + r, h - 1); ++yy) {
+				for (int xx = max(x - r, 0); xx <= min(x + r, w - 1); ++xx) {
+					for (int c = 0; c < 4; ++c) {
+						const double d = src.At(xx, yy)[c] - sum[c] / count;
+						squares[c] += d * d;
+					}
+				}
+			}
+			for (int c = 0; c < 4; ++c) {
+				mean.At(x, y)[c] = static_cast<float>(sum[c] / count);
+				variance.At(x, y)[c] = static_cast<float>(squares[c] / count);
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+﻿#pragma once
+#include<vector>
+#include<cstdint>
+#include<cstddef>
+#include"Image.h"
+
+class ComputeExecutor;
+
+//総和テーブル(summed-area table)による箱型フィルタ・窓の平均と分散
+//RenderTargetFilter/BoxFilterCS.hlslのCPU版。窓の和はテーブルの4隅の差なので、画素ごとの手間は半径によらない
+//窓は画像の中に切り詰め、平均は窓に入った画素数で割る
+//  R8G8B8A8 : 0～255の整数をuint32_tで2^32を法として足す(シェーダと同じ)。窓の本当の和が2^32未満なら差は正確
+//             (和は半径2047まで、平方和は半径127まで)
+//  float    : doubleで足す。分散の桁落ちを抑えるため、左上の画素の値を引いてから足す
+//テーブルを作ってから読む関数と、テーブルを全体には作らない関数(行の帯ごとに、列ごとの窓の縦の和を1行だけ持つ)がある
+
+///平方和も使うときの半径の上限(R8G8B8A8)
+constexpr unsigned int maxBoxVarianceRadius = 127;
+
+///総和テーブル
+///1行は(width+1)*4要素(画素ごとにRGBA)で、行y+1・列x+1が(0,0)～(x,y)の画素の和。0行目と0列目は0
+template<typename T>
+struct SummedAreaTable {
+	unsigned int width = 0;
+	unsigned int height = 0;
+	hlsl::float4 offset = 0.0f;//floatのときに各画素から引いた値
+	std::vector<T> sums;
+	std::vector<T> squares;//平方和(作らなければ空)
+
+	size_t Stride()const { return (static_cast<size_t>(width) + 1) * 4; }
+	const T* SumRow(unsigned int y)const { return sums.data() + y * Stride(); }
+	const T* SquareRow(unsigned int y)const { return squares.data() + y * Stride(); }
+};
+using SummedAreaTable8 = SummedAreaTable<uint32_t>;
+using SummedAreaTableF = SummedAreaTable<double>;
+
+///総和テーブルを作る(行の帯ごとの縦の和→帯の先頭行→帯ごとに積み上げ、の2回読みで並列化する)
+///@param src 入力画像
+///@param table 出力
+///@param withSquares 平方和も作るならtrue(BoxMeanVarianceに使う)
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+///@remarks R8G8B8A8の行はKernelRegistryの"satrow8"で選ばれる
+void BuildSummedAreaTable(const ImageRGBA8& src, SummedAreaTable8& table, bool withSquares, ComputeExecutor* executor);
+void BuildSummedAreaTable(const ImageRGBA32F& src, SummedAreaTableF& table, bool withSquares, ComputeExecutor* executor);
+
+///総和テーブルから(2*radius+1)四方の窓の平均を求める
+///@param dst 出力画像(テーブルと同じサイズにされる)
+///@remarks R8G8B8A8は窓の和×(1/画素数)を丸める(KernelRegistryの"boxmean8")。正確な丸めとの差は1LSB以内
+void BoxFilter(const SummedAreaTable8& table, ImageRGBA8& dst, unsigned int radius, ComputeExecutor* executor);
+void BoxFilter(const SummedAreaTableF& table, ImageRGBA32F& dst, unsigned int radius, ComputeExecutor* executor);
+
+///総和テーブル(平方和つき)から窓の平均と分散を求める(R8G8B8A8は0～1の値として。radiusはmaxBoxVarianceRadiusまで)
+void BoxMeanVariance(const SummedAreaTable8& table, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius, ComputeExecutor* executor);
+void BoxMeanVariance(const SummedAreaTableF& table, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius, ComputeExecutor* executor);
+
+///テーブルを全体には作らない箱型フィルタ
+///行の帯ごとに列ごとの窓の縦の和を1行だけ持ち、出力の行ごとに入る行を足して出る行を引いてから横に累積する
+///(作業用の行は半径によらず数行。R8G8B8A8はKernelRegistryの"boxcols8"と"boxmean8")
+///@param dst 出力画像(srcと同じサイズにされる)
+///@remarks R8G8B8A8の手間は半径によらないが、写すだけの速さにはならない。1280x720・1スレッドで半径1～127のとき
+///AVX2/AVX-512はmemcpyの約7～10倍、SSE4.1は約11～15倍、スカラーは約60～70倍(BenchmarkBoxFilter)。
+///画素ごとに列の和の更新・横の累積・平均をそれぞれ32bitの4成分で行うので、読み書きがmemcpyの数倍ある
+///(平均のfloatへの変換を整数の掛け算に変えても、SIMDでは命令数が減らない)
+void BoxFilter(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, ComputeExecutor* executor);
+void BoxFilter(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int radius, ComputeExecutor* executor);
+
+///テーブルを全体には作らない窓の平均と分散
+void BoxMeanVariance(const ImageRGBA8& src, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius, ComputeExecutor* executor);
+void BoxMeanVariance(const ImageRGBA32F& src, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius, ComputeExecutor* executor);
+
+///基準実装(画素ごとに窓の値をdoubleで足す)
+void BoxMeanVarianceReference(const ImageRGBA32F& src, ImageRGBA32F& mean, ImageRGBA32F& variance, unsigned int radius);
@@ -0,0 +1,17 @@
+//ae[u(summed-area table)̘̑a畽ςƕU߂
+//BoxFilterCS.hlslCPU(CpuCompute/BoxFilter.cpp)ŋLĂ܂
+//R8G8B8A8̒l0`255̐̂܂ܑa(sum)ƕa(squares)A0`1̒lƂĕԂ
+
+//̕
+float4 BoxMean8(uint4 sum, uint count)
+{
+    return (float4)sum / (255.0f * (float)count);
+}
+
+//̕U(E[x^2] - E[x]^2Bۂ߂ŕɂȂȂ悤0Ŏ~߂)
+float4 BoxVariance8(uint4 sum, uint4 squares, uint count)
+{
+    float4 mean = (float4)sum / (float)count;
+    float4 meanSquare = (float4)squares / (float)count;
+    return max(meanSquare - mean * mean, 0.0f) / (255.0f * 255.0f);
+}
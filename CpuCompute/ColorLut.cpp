@@ -0,0 +1,438 @@
+﻿#include "ColorLut.h"
+#include<algorithm>
+#include<cassert>
+#include<cmath>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#endif
+
+//シェーダと同じ変換と四面体の選び方
+namespace hlsl {
+	namespace {
+#include"ColorLut.hlsli"
+	}
+}
+
+using namespace std;
+using hlsl::float3;
+using hlsl::float4;
+
+namespace {
+	//並列化するときの帯の最小の行数
+	constexpr unsigned int minBandRows = 16;
+	//packed8の成分の最大値(8bitの値の4倍。重みの合計256を掛けて1024で割ると8bitに戻る)
+	constexpr int lutValueMax = 1020;
+	constexpr int lutFracOne = 256;
+
+	//ここからR8G8B8A8のLUT引き
+	//画素ごとに、成分の値からcoords8で格子の番号と立方体の中の位置(0～256)を引き、
+	//位置の大小で四面体を選んで4頂点の値(10bit)に重み(合計256)を掛けて足す
+	//  頂点000 : base、頂点111 : base+1+size+size^2
+	//  corner1 : 一番大きい成分の軸の隣(1/size/size^2)
+	//  corner2 : 一番小さい成分の軸以外の2つの隣(1+size+size^2から一番小さい成分の軸の分を引く)
+
+	void Lut3d8Scalar(const uint32_t* src, uint32_t* dst, size_t count, const ColorLut& lut) {
+		const uint32_t* coords = lut.coords8.data();
+		const uint32_t* entries = lut.packed8.data();
+		const uint32_t sg = lut.size;
+		const uint32_t sb = lut.size * lut.size;
+		for (size_t i = 0; i < count; ++i) {
+			const uint32_t px = src[i];
+			const uint32_t cr = coords[px & 0xff];
+			const uint32_t cg = coords[(px >> 8) & 0xff];
+			const uint32_t cb = coords[(px >> 16) & 0xff];
+			const uint32_t base = (cb >> 16) * sb + (cg >> 16) * sg + (cr >> 16);
+			const int fr = cr & 0xffff;
+			const int fg = cg & 0xffff;
+			const int fb = cb & 0xffff;
+			const int f1 = max(fr, max(fg, fb));
+			const int f3 = min(fr, min(fg, fb));
+			const int f2 = max(min(fr, fg), min(max(fr, fg), fb));
+			const uint32_t off1 = fr == f1 ? 1 : (fg == f1 ? sg : sb);
+			const uint32_t off2 = fb == f3 ? 1 + sg : (fg == f3 ? 1 + sb : sg + sb);
+			const uint32_t c0 = entries[base];
+			const uint32_t c1 = entries[base + off1];
+			const uint32_t c2 = entries[base + off2];
+			const uint32_t c3 = entries[base + 1 + sg + sb];
+			uint32_t out = px & 0xff000000;
+			for (int c = 0; c < 3; ++c) {
+				const int shift = c * 10;
+				const int v = (lutFracOne - f1) * static_cast<int>((c0 >> shift) & 0x3ff) + (f1 - f2) * static_cast<int>((c1 >> shift) & 0x3ff)
+					+ (f2 - f3) * static_cast<int>((c2 >> shift) & 0x3ff) + f3 * static_cast<int>((c3 >> shift) & 0x3ff);
+				out |= static_cast<uint32_t>((v + 512) >> 10) << (c * 8);
+			}
+			dst[i] = out;
+		}
+	}
+
+	//SSE4.1とNEONはgatherがなく、1画素ずつ表を引くスカラーと変わらないので実装しない
+#if defined(CPU_ARCH_X86)
+	//10bitの成分(下位から)に重みを掛ける。重みの上位16bitは0なので、madd_epi16で32bitのまま掛けられる
+	CPU_TARGET_AVX2 inline __m256i LutWeightedAVX2(__m256i c0, __m256i c1, __m256i c2, __m256i c3, __m256i w0, __m256i w1, __m256i w2, __m256i w3, int shift) {
+		const __m256i mask = _mm256_set1_epi32(0x3ff);
+		__m256i v = _mm256_madd_epi16(_mm256_and_si256(_mm256_srli_epi32(c0, shift), mask), w0);
+		v = _mm256_add_epi32(v, _mm256_madd_epi16(_mm256_and_si256(_mm256_srli_epi32(c1, shift), mask), w1));
+		v = _mm256_add_epi32(v, _mm256_madd_epi16(_mm256_and_si256(_mm256_srli_epi32(c2, shift), mask), w2));
+		v = _mm256_add_epi32(v, _mm256_madd_epi16(_mm256_and_si256(_mm256_srli_epi32(c3, shift), mask), w3));
+		return _mm256_srli_epi32(_mm256_add_epi32(v, _mm256_set1_epi32(512)), 10);
+	}
+
+	CPU_TARGET_AVX2 void Lut3d8AVX2(const uint32_t* src, uint32_t* dst, size_t count, const ColorLut& lut) {
+		const auto coords = reinterpret_cast<const int*>(lut.coords8.data());
+		const auto entries = reinterpret_cast<const int*>(lut.packed8.data());
+		const int sg = static_cast<int>(lut.size);
+		const int sb = sg * sg;
+		const __m256i byteMask = _mm256_set1_epi32(0xff);
+		const __m256i fracMask = _mm256_set1_epi32(0xffff);
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i vsg = _mm256_set1_epi32(sg);
+		const __m256i vsb = _mm256_set1_epi32(sb);
+		const __m256i off2rg = _mm256_set1_epi32(1 + sg);
+		const __m256i off2rb = _mm256_set1_epi32(1 + sb);
+		const __m256i off2gb = _mm256_set1_epi32(sg + sb);
+		const __m256i off3 = _mm256_set1_epi32(1 + sg + sb);
+		const __m256i fracOne = _mm256_set1_epi32(lutFracOne);
+		const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xff000000));
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			const __m256i cr = _mm256_i32gather_epi32(coords, _mm256_and_si256(px, byteMask), 4);
+			const __m256i cg = _mm256_i32gather_epi32(coords, _mm256_and_si256(_mm256_srli_epi32(px, 8), byteMask), 4);
+			const __m256i cb = _mm256_i32gather_epi32(coords, _mm256_and_si256(_mm256_srli_epi32(px, 16), byteMask), 4);
+			__m256i base = _mm256_mullo_epi32(_mm256_srli_epi32(cb, 16), vsb);
+			base = _mm256_add_epi32(base, _mm256_mullo_epi32(_mm256_srli_epi32(cg, 16), vsg));
+			base = _mm256_add_epi32(base, _mm256_srli_epi32(cr, 16));
+			const __m256i fr = _mm256_and_si256(cr, fracMask);
+			const __m256i fg = _mm256_and_si256(cg, fracMask);
+			const __m256i fb = _mm256_and_si256(cb, fracMask);
+			const __m256i f1 = _mm256_max_epi32(fr, _mm256_max_epi32(fg, fb));
+			const __m256i f3 = _mm256_min_epi32(fr, _mm256_min_epi32(fg, fb));
+			const __m256i f2 = _mm256_max_epi32(_mm256_min_epi32(fr, fg), _mm256_min_epi32(_mm256_max_epi32(fr, fg), fb));
+			const __m256i off1 = _mm256_blendv_epi8(_mm256_blendv_epi8(vsb, vsg, _mm256_cmpeq_epi32(fg, f1)), one, _mm256_cmpeq_epi32(fr, f1));
+			const __m256i off2 = _mm256_blendv_epi8(_mm256_blendv_epi8(off2gb, off2rb, _mm256_cmpeq_epi32(fg, f3)), off2rg, _mm256_cmpeq_epi32(fb, f3));
+			const __m256i c0 = _mm256_i32gather_epi32(entries, base, 4);
+			const __m256i c1 = _mm256_i32gather_epi32(entries, _mm256_add_epi32(base, off1), 4);
+			const __m256i c2 = _mm256_i32gather_epi32(entries, _mm256_add_epi32(base, off2), 4);
+			const __m256i c3 = _mm256_i32gather_epi32(entries, _mm256_add_epi32(base, off3), 4);
+			const __m256i w0 = _mm256_sub_epi32(fracOne, f1);
+			const __m256i w1 = _mm256_sub_epi32(f1, f2);
+			const __m256i w2 = _mm256_sub_epi32(f2, f3);
+			__m256i out = _mm256_and_si256(px, alphaMask);
+			out = _mm256_or_si256(out, LutWeightedAVX2(c0, c1, c2, c3, w0, w1, w2, f3, 0));
+			out = _mm256_or_si256(out, _mm256_slli_epi32(LutWeightedAVX2(c0, c1, c2, c3, w0, w1, w2, f3, 10), 8));
+			out = _mm256_or_si256(out, _mm256_slli_epi32(LutWeightedAVX2(c0, c1, c2, c3, w0, w1, w2, f3, 20), 16));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out);
+		}
+		//端数は1行に1回なので、スカラーに任せても切り替えのコストは目立たない
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		Lut3d8Scalar(src + i, dst + i, count - i, lut);
+	}
+
+	CPU_TARGET_AVX512 inline __m512i LutWeightedAVX512(__m512i c0, __m512i c1, __m512i c2, __m512i c3, __m512i w0, __m512i w1, __m512i w2, __m512i w3, int shift) {
+		const __m512i mask = _mm512_set1_epi32(0x3ff);
+		__m512i v = _mm512_madd_epi16(_mm512_and_si512(_mm512_srli_epi32(c0, shift), mask), w0);
+		v = _mm512_add_epi32(v, _mm512_madd_epi16(_mm512_and_si512(_mm512_srli_epi32(c1, shift), mask), w1));
+		v = _mm512_add_epi32(v, _mm512_madd_epi16(_mm512_and_si512(_mm512_srli_epi32(c2, shift), mask), w2));
+		v = _mm512_add_epi32(v, _mm512_madd_epi16(_mm512_and_si512(_mm512_srli_epi32(c3, shift), mask), w3));
+		return _mm512_srli_epi32(_mm512_add_epi32(v, _mm512_set1_epi32(512)), 10);
+	}
+
+	CPU_TARGET_AVX512 void Lut3d8AVX512(const uint32_t* src, uint32_t* dst, size_t count, const ColorLut& lut) {
+		const auto coords = lut.coords8.data();
+		const auto entries = lut.packed8.data();
+		const int sg = static_cast<int>(lut.size);
+		const int sb = sg * sg;
+		const __m512i byteMask = _mm512_set1_epi32(0xff);
+		const __m512i fracMask = _mm512_set1_epi32(0xffff);
+		const __m512i one = _mm512_set1_epi32(1);
+		const __m512i vsg = _mm512_set1_epi32(sg);
+		const __m512i vsb = _mm512_set1_epi32(sb);
+		const __m512i off2rg = _mm512_set1_epi32(1 + sg);
+		const __m512i off2rb = _mm512_set1_epi32(1 + sb);
+		const __m512i off2gb = _mm512_set1_epi32(sg + sb);
+		const __m512i off3 = _mm512_set1_epi32(1 + sg + sb);
+		const __m512i fracOne = _mm512_set1_epi32(lutFracOne);
+		const __m512i alphaMask = _mm512_set1_epi32(static_cast<int>(0xff000000));
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			const __m512i px = _mm512_loadu_si512(src + i);
+			const __m512i cr = _mm512_i32gather_epi32(_mm512_and_si512(px, byteMask), coords, 4);
+			const __m512i cg = _mm512_i32gather_epi32(_mm512_and_si512(_mm512_srli_epi32(px, 8), byteMask), coords, 4);
+			const __m512i cb = _mm512_i32gather_epi32(_mm512_and_si512(_mm512_srli_epi32(px, 16), byteMask), coords, 4);
+			__m512i base = _mm512_mullo_epi32(_mm512_srli_epi32(cb, 16), vsb);
+			base = _mm512_add_epi32(base, _mm512_mullo_epi32(_mm512_srli_epi32(cg, 16), vsg));
+			base = _mm512_add_epi32(base, _mm512_srli_epi32(cr, 16));
+			const __m512i fr = _mm512_and_si512(cr, fracMask);
+			const __m512i fg = _mm512_and_si512(cg, fracMask);
+			const __m512i fb = _mm512_and_si512(cb, fracMask);
+			const __m512i f1 = _mm512_max_epi32(fr, _mm512_max_epi32(fg, fb));
+			const __m512i f3 = _mm512_min_epi32(fr, _mm512_min_epi32(fg, fb));
+			const __m512i f2 = _mm512_max_epi32(_mm512_min_epi32(fr, fg), _mm512_min_epi32(_mm512_max_epi32(fr, fg), fb));
+			const __m512i off1 = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(fr, f1), _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(fg, f1), vsb, vsg), one);
+			const __m512i off2 = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(fb, f3), _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(fg, f3), off2gb, off2rb), off2rg);
+			const __m512i c0 = _mm512_i32gather_epi32(base, entries, 4);
+			const __m512i c1 = _mm512_i32gather_epi32(_mm512_add_epi32(base, off1), entries, 4);
+			const __m512i c2 = _mm512_i32gather_epi32(_mm512_add_epi32(base, off2), entries, 4);
+			const __m512i c3 = _mm512_i32gather_epi32(_mm512_add_epi32(base, off3), entries, 4);
+			const __m512i w0 = _mm512_sub_epi32(fracOne, f1);
+			const __m512i w1 = _mm512_sub_epi32(f1, f2);
+			const __m512i w2 = _mm512_sub_epi32(f2, f3);
+			__m512i out = _mm512_and_si512(px, alphaMask);
+			out = _mm512_or_si512(out, LutWeightedAVX512(c0, c1, c2, c3, w0, w1, w2, f3, 0));
+			out = _mm512_or_si512(out, _mm512_slli_epi32(LutWeightedAVX512(c0, c1, c2, c3, w0, w1, w2, f3, 10), 8));
+			out = _mm512_or_si512(out, _mm512_slli_epi32(LutWeightedAVX512(c0, c1, c2, c3, w0, w1, w2, f3, 20), 16));
+			_mm512_storeu_si512(dst + i, out);
+		}
+		_mm256_zeroupper();
+		Lut3d8Scalar(src + i, dst + i, count - i, lut);
+	}
+#endif
+
+	using Lut3d8Func = void(*)(const uint32_t* src, uint32_t* dst, size_t count, const ColorLut& lut);
+
+	Kernel<Lut3d8Func> lut3d8("lut3d8", {
+		{ CpuIsa::Scalar, Lut3d8Scalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::AVX2, Lut3d8AVX2 },
+		{ CpuIsa::AVX512, Lut3d8AVX512 },
+#endif
+	});
+
+	//floatのLUT引き(ColorLutCS.hlslと同じ計算)
+	float3 LutSample(const ColorLut& lut, const float3& c) {
+		const auto shaper = static_cast<hlsl::uint>(lut.shaper);
+		const float scale = static_cast<float>(lut.size - 1);
+		const float3 u = float3(hlsl::LutShape(c.x, shaper), hlsl::LutShape(c.y, shaper), hlsl::LutShape(c.z, shaper)) * scale;
+		unsigned int idx[3];
+		float3 f;
+		for (int k = 0; k < 3; ++k) {
+			idx[k] = min(static_cast<unsigned int>(u[k]), lut.size - 2);
+			f[k] = u[k] - static_cast<float>(idx[k]);
+		}
+		const auto t = hlsl::LutSelectTetrahedron(f);
+		auto at = [&](const hlsl::uint3& corner) -> float3 {
+			return lut.values[(static_cast<size_t>(idx[2] + corner.z) * lut.size + idx[1] + corner.y) * lut.size + idx[0] + corner.x].xyz;
+		};
+		return t.weights.x * at(hlsl::uint3(0, 0, 0)) + t.weights.y * at(t.corner1) + t.weights.z * at(t.corner2) + t.weights.w * at(hlsl::uint3(1, 1, 1));
+	}
+
+	//行の帯に分けてfunc(y)を呼ぶ
+	template<typename Func>
+	void ForEachRow(unsigned int height, ComputeExecutor* executor, Func func) {
+		unsigned int bandNum = 1;
+		if (executor != nullptr && executor->ThreadCount() > 1) {
+			bandNum = max(1u, min(height / minBandRows, executor->ThreadCount() * 2));
+		}
+		auto runBands = [&](size_t begin, size_t end) {
+			const auto y0 = static_cast<unsigned int>(static_cast<uint64_t>(height) * begin / bandNum);
+			const auto y1 = static_cast<unsigned int>(static_cast<uint64_t>(height) * end / bandNum);
+			for (auto y = y0; y < y1; ++y) {
+				func(y);
+			}
+		};
+		if (bandNum > 1) {
+			executor->ParallelFor(bandNum, 1, runBands);
+		}
+		else {
+			runBands(0, 1);
+		}
+	}
+
+	template<typename Pixel>
+	void ResizeLike(const Image<Pixel>& src, Image<Pixel>& dst) {
+		if (&src != &dst) {
+			dst.width = src.width;
+			dst.height = src.height;
+			dst.pixels.resize(src.pixels.size());
+		}
+	}
+
+	//Fritsch-Carlsonの単調な3次補間
+	struct MonotoneCurve {
+		vector<float> xs;
+		vector<float> ys;
+		vector<float> slopes;
+
+		explicit MonotoneCurve(const vector<hlsl::float2>& points) {
+			assert(points.size() >= 2);
+			for (auto& p : points) {
+				xs.push_back(p.x);
+				ys.push_back(p.y);
+			}
+			const size_t n = points.size();
+			vector<float> secants(n - 1);
+			for (size_t i = 0; i + 1 < n; ++i) {
+				assert(xs[i] < xs[i + 1]);
+				secants[i] = (ys[i + 1] - ys[i]) / (xs[i + 1] - xs[i]);
+			}
+			slopes.resize(n);
+			slopes[0] = secants[0];
+			slopes[n - 1] = secants[n - 2];
+			for (size_t i = 1; i + 1 < n; ++i) {
+				slopes[i] = secants[i - 1] * secants[i] <= 0.0f ? 0.0f : (secants[i - 1] + secants[i]) * 0.5f;
+			}
+			//傾きが割線の3倍を超えると単調でなくなるので抑える
+			for (size_t i = 0; i + 1 < n; ++i) {
+				if (secants[i] == 0.0f) {
+					slopes[i] = slopes[i + 1] = 0.0f;
+					continue;
+				}
+				const float a = slopes[i] / secants[i];
+				const float b = slopes[i + 1] / secants[i];
+				const float r = a * a + b * b;
+				if (r > 9.0f) {
+					const float t = 3.0f / sqrt(r);
+					slopes[i] = t * a * secants[i];
+					slopes[i + 1] = t * b * secants[i];
+				}
+			}
+		}
+
+		float operator()(float x)const {
+			if (x <= xs.front()) {
+				return ys.front();
+			}
+			if (x >= xs.back()) {
+				return ys.back();
+			}
+			const size_t i = static_cast<size_t>(upper_bound(xs.begin(), xs.end(), x) - xs.begin()) - 1;
+			const float h = xs[i + 1] - xs[i];
+			const float t = (x - xs[i]) / h;
+			const float t2 = t * t;
+			const float t3 = t2 * t;
+			return (2 * t3 - 3 * t2 + 1) * ys[i] + (t3 - 2 * t2 + t) * h * slopes[i]
+				+ (-2 * t3 + 3 * t2) * ys[i + 1] + (t3 - t2) * h * slopes[i + 1];
+		}
+	};
+}
+
+ColorTransform&
+ColorTransform::Grayscale() {
+	return Custom([](const float3& c) {return hlsl::ColorGrayscale(c); });
+}
+
+ColorTransform&
+ColorTransform::Gamma(float gamma) {
+	assert(gamma > 0.0f);
+	return Custom([gamma](const float3& c) {return hlsl::ColorGamma(c, gamma); });
+}
+
+ColorTransform&
+ColorTransform::Contrast(float amount) {
+	return Custom([amount](const float3& c) {return hlsl::ColorContrast(c, amount); });
+}
+
+ColorTransform&
+ColorTransform::Tint(const float3& tint) {
+	return Custom([tint](const float3& c) {return hlsl::ColorTint(c, tint); });
+}
+
+ColorTransform&
+ColorTransform::Curve(const vector<hlsl::float2>& points) {
+	MonotoneCurve curve(points);
+	return Custom([curve](const float3& c) {return float3(curve(c.x), curve(c.y), curve(c.z)); });
+}
+
+ColorTransform&
+ColorTransform::Custom(Op op) {
+	ops_.push_back(move(op));
+	return *this;
+}
+
+float3
+ColorTransform::Evaluate(float3 c)const {
+	for (auto& op : ops_) {
+		c = op(c);
+	}
+	return c;
+}
+
+ColorLut
+BakeColorLut(const ColorTransform& transform, unsigned int size, LutShaper shaper, ComputeExecutor* executor) {
+	assert(size >= 2 && size <= 256);
+	ColorLut lut;
+	lut.size = size;
+	lut.shaper = shaper;
+	const size_t count = static_cast<size_t>(size) * size * size;
+	lut.values.resize(count);
+	lut.packed8.resize(count);
+	const auto shaperId = static_cast<hlsl::uint>(shaper);
+	vector<float> grid(size);
+	for (unsigned int i = 0; i < size; ++i) {
+		grid[i] = hlsl::LutUnshape(static_cast<float>(i) / (size - 1), shaperId);
+	}
+	//bの面ごとに焼く
+	ForEachRow(size, executor, [&](unsigned int b) {
+		for (unsigned int g = 0; g < size; ++g) {
+			for (unsigned int r = 0; r < size; ++r) {
+				const size_t index = (static_cast<size_t>(b) * size + g) * size + r;
+				const float3 v = transform.Evaluate(float3(grid[r], grid[g], grid[b]));
+				lut.values[index] = float4(v, 1.0f);
+				uint32_t packed = 0;
+				for (int c = 0; c < 3; ++c) {
+					packed |= static_cast<uint32_t>(hlsl::saturate(v[c]) * lutValueMax + 0.5f) << (c * 10);
+				}
+				lut.packed8[index] = packed;
+			}
+		}
+	});
+	lut.coords8.resize(256);
+	for (unsigned int v = 0; v < 256; ++v) {
+		const float u = hlsl::LutShape(v / 255.0f, shaperId) * (size - 1);
+		const unsigned int idx = min(static_cast<unsigned int>(u), size - 2);
+		const auto frac = static_cast<uint32_t>(lround((u - idx) * lutFracOne));
+		lut.coords8[v] = (idx << 16) | min(frac, static_cast<uint32_t>(lutFracOne));
+	}
+	return lut;
+}
+
+void
+ApplyColorLut(const ColorLut& lut, const ImageRGBA8& src, ImageRGBA8& dst, ComputeExecutor* executor) {
+	assert(lut.size >= 2 && lut.coords8.size() == 256);
+	ResizeLike(src, dst);
+	const auto func = lut3d8.Get();
+	ForEachRow(src.height, executor, [&](unsigned int y) {
+		func(src.Row(y), dst.Row(y), src.width, lut);
+	});
+}
+
+void
+ApplyColorLut(const ColorLut& lut, const ImageRGBA32F& src, ImageRGBA32F& dst, ComputeExecutor* executor) {
+	assert(lut.size >= 2);
+	ResizeLike(src, dst);
+	ForEachRow(src.height, executor, [&](unsigned int y) {
+		const float4* s = src.Row(y);
+		float4* d = dst.Row(y);
+		for (unsigned int x = 0; x < src.width; ++x) {
+			d[x] = float4(LutSample(lut, s[x].xyz), s[x].w);
+		}
+	});
+}
+
+void
+ApplyColorTransform(const ColorTransform& transform, const ImageRGBA8& src, ImageRGBA8& dst, ComputeExecutor* executor) {
+	ResizeLike(src, dst);
+	ForEachRow(src.height, executor, [&](unsigned int y) {
+		const uint32_t* s = src.Row(y);
+		uint32_t* d = dst.Row(y);
+		for (unsigned int x = 0; x < src.width; ++x) {
+			const float3 c = transform.Evaluate(UnpackUnorm4x8(s[x]).xyz);
+			d[x] = (PackUnorm4x8(float4(c, 0.0f)) & 0x00ffffff) | (s[x] & 0xff000000);
+		}
+	});
+}
+
+void
+ApplyColorTransform(const ColorTransform& transform, const ImageRGBA32F& src, ImageRGBA32F& dst, ComputeExecutor* executor) {
+	ResizeLike(src, dst);
+	ForEachRow(src.height, executor, [&](unsigned int y) {
+		const float4* s = src.Row(y);
+		float4* d = dst.Row(y);
+		for (unsigned int x = 0; x < src.width; ++x) {
+			d[x] = float4(transform.Evaluate(s[x].xyz), s[x].w);
+		}
+	});
+}
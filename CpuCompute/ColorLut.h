@@ -0,0 +1,86 @@
+﻿#pragma once
+#include<vector>
+#include<cstdint>
+#include<functional>
+#include"Image.h"
+
+class ComputeExecutor;
+
+//点ごとの色の変換(RGB→RGB)の並びと、それを焼いた3D LUT
+//RenderTargetFilter/ColorLutCS.hlslのCPU版。変換・シェーパー・四面体の選び方はColorLut.hlsliをシェーダと共有する
+//変換を画像全体に1つずつかけると変換の数だけ画像を読み書きするが、LUTなら何個並べても1回で済む
+//(1画素あたり、格子の立方体の4頂点を読んで重みを掛けて足す四面体補間)
+//LUTと変換を直接計算した結果(R8G8B8A8)の差は、成分ごとに
+//  ・格子の点の上では0～1LSB(格子点の値を10bitで持つため)
+//  ・格子の間では変換の2階微分で決まる(滑らかなら格子の間隔の2乗に比例)。
+//    コントラストの切り詰めの折れ目や、ガンマの0の近くの急な立ち上がりが格子の間にあると大きくなる
+//"lut"コマンドで全2^24色の差を測り、17^3は6LSB以内、33^3と65^3は4LSB以内であることを確かめている
+//(ガンマ→コントラスト→色味→トーンカーブ、灰色化→ガンマ→色味→トーンカーブの2つの並び、シェーパーは両方)
+
+///格子の座標の曲げ方(ColorLut.hlsliのLUT_SHAPER_～と同じ値)
+enum class LutShaper : unsigned int {
+	Linear = 0,
+	Sqrt = 1,//暗部の格子を細かくする(ガンマのように0の近くで変化が急な変換に向く)
+};
+
+///点ごとの色の変換の並び(前から順にかける。値は0～1のRGB)
+class ColorTransform {
+public:
+	using Op = std::function<hlsl::float3(const hlsl::float3&)>;
+
+	///BT.601の輝度で灰色にする
+	ColorTransform& Grayscale();
+	///pow(c, 1/gamma)
+	ColorTransform& Gamma(float gamma);
+	///0.5を中心にamount倍して0～1に切り詰める
+	ColorTransform& Contrast(float amount);
+	///成分ごとに掛ける
+	ColorTransform& Tint(const hlsl::float3& tint);
+	///トーンカーブ(全成分に同じ曲線)
+	///@param points (入力,出力)の点。入力の昇順で2つ以上。点の間は単調な3次(Fritsch-Carlson)で結び、外側は端の点の値
+	ColorTransform& Curve(const std::vector<hlsl::float2>& points);
+	///任意の変換
+	ColorTransform& Custom(Op op);
+
+	size_t Size()const { return ops_.size(); }
+	///並べた変換を順にかける
+	hlsl::float3 Evaluate(hlsl::float3 c)const;
+	///index番目の変換だけをかける
+	hlsl::float3 EvaluateOp(size_t index, const hlsl::float3& c)const { return ops_[index](c); }
+
+private:
+	std::vector<Op> ops_;
+};
+
+///3D LUT
+struct ColorLut {
+	unsigned int size = 0;//格子の1辺の点の数(2以上。17/33/65など)
+	LutShaper shaper = LutShaper::Linear;
+	///格子点(r,g,b)の値は[(b*size+g)*size+r](Texture3Dのx,y,zと同じ並び。ColorLutCS.hlslにはこのまま渡せる)。wは1
+	std::vector<hlsl::float4> values;
+	///R8G8B8A8用の格子点の値(各成分を0～1に切り詰めて0～1020の10bitにし、R|G<<10|B<<20)
+	std::vector<uint32_t> packed8;
+	///R8G8B8A8の成分の値(0～255)→格子の番号(上位16bit)と、立方体の中の位置(下位16bit、0～256)
+	std::vector<uint32_t> coords8;
+};
+
+///変換の並びをLUTに焼く
+///@param transform 変換の並び
+///@param size 格子の1辺の点の数(2以上)
+///@param shaper 格子の座標の曲げ方
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+ColorLut BakeColorLut(const ColorTransform& transform, unsigned int size, LutShaper shaper, ComputeExecutor* executor);
+
+///LUTをかける(アルファはそのまま)
+///@param dst 出力画像(srcと同じサイズにされる。srcと同じでもよい)
+///@param executor nullptrなら呼び出しスレッドだけで処理する。指定すれば行の帯ごとに並列化する
+///@remarks R8G8B8A8はKernelRegistryの"lut3d8"で選ばれる。floatは入力を0～1に切り詰めてから引く
+void ApplyColorLut(const ColorLut& lut, const ImageRGBA8& src, ImageRGBA8& dst, ComputeExecutor* executor);
+void ApplyColorLut(const ColorLut& lut, const ImageRGBA32F& src, ImageRGBA32F& dst, ComputeExecutor* executor);
+
+///LUTと直接計算の差(R8G8B8A8の成分ごと)の上限(LSB)。上の説明の値で、"lut"コマンドとRenderTargetFilterのColorLutCSの確認が使う
+inline int ColorLutErrorBound8(unsigned int size) { return size >= 33 ? 4 : 6; }
+
+///基準実装:変換の並びを画素ごとに直接計算する(アルファはそのまま)
+void ApplyColorTransform(const ColorTransform& transform, const ImageRGBA8& src, ImageRGBA8& dst, ComputeExecutor* executor);
+void ApplyColorTransform(const ColorTransform& transform, const ImageRGBA32F& src, ImageRGBA32F& dst, ComputeExecutor* executor);
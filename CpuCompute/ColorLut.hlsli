@@ -0,0 +1,48 @@
+//_Ƃ̐F̕ϊ3D LUT(F̗̂̊iqɕϊʂĂ\)̎lʑ̕
+//ColorLutCS.hlslCPU(CpuCompute/ColorLut.cpp)ŋLĂ܂
+//l0`1RGBBLUT̊iq̓VF[p[ŋȂWɓԊuɒu(Õ̕ω}ȕϊł덷Ȃ)
+
+#define LUT_SHAPER_LINEAR 0//̂܂
+#define LUT_SHAPER_SQRT 1//iq̍Wu = sqrt(x)(Õ̊iqׂȂ)
+
+//_Ƃ̕ϊ(LUTĂƂɎg)
+#include"ColorOps.hlsli"
+
+//LUT
+
+//liq̍W(0`1)
+float LutShape(float x, uint shaper)
+{
+    x = saturate(x);
+    return shaper == LUT_SHAPER_SQRT ? sqrt(x) : x;
+}
+
+//iq̍Wl(LutShape̋tBLUTĂƂɎg)
+float LutUnshape(float u, uint shaper)
+{
+    return shaper == LUT_SHAPER_SQRT ? u * u : u;
+}
+
+//lʑ̕ԂɎgiq̗̂4_Əd
+//_000Ecorner1Ecorner2E111̏ŁAweights͂̏̏d
+struct LutTetrahedron
+{
+    uint3 corner1;
+    uint3 corner2;
+    float4 weights;
+};
+
+//f : ̂̒̈ʒu(0`1)
+//傫f1f2f3ƂāA000(f1̎)(f1f2̎)111̕ӂǂlʑ̂I
+//(l̂Ƃ͂ǂ̎IłÅԂ̏d݂0ɂȂ̂Ōʂ͓)
+LutTetrahedron LutSelectTetrahedron(float3 f)
+{
+    float f1 = max(f.x, max(f.y, f.z));
+    float f3 = min(f.x, min(f.y, f.z));
+    float f2 = max(min(f.x, f.y), min(max(f.x, f.y), f.z));//̒l
+    LutTetrahedron t;
+    t.corner1 = f.x == f1 ? uint3(1, 0, 0) : (f.y == f1 ? uint3(0, 1, 0) : uint3(0, 0, 1));
+    t.corner2 = f.z == f3 ? uint3(1, 1, 0) : (f.y == f3 ? uint3(1, 0, 1) : uint3(0, 1, 1));
+    t.weights = float4(1.0f - f1, f1 - f2, f2 - f3, f3);
+    return t;
+}
@@ -0,0 +1,27 @@
+//_Ƃ̐F̕ϊ(l0`1RGB)
+//PostEffectCS.hlslEColorLutCS.hlsl(ColorLut.hlsli)CPU(CpuCompute/FilterGraphRunner.cppAColorLut.cpp)ŋLĂ܂
+//ColorLut.hlsli͂includeĂ̂ŁALUTgȂƂ͂炾include
+//BT.601̋PxŊDFɂ(MonoPixelƓW)
+float3 ColorGrayscale(float3 c)
+{
+    float y = dot(c, float3(0.299f, 0.587f, 0.114f));
+    return float3(y, y, y);
+}
+
+//K}(pow(c, 1/gamma)BMonoPixel2.2)
+float3 ColorGamma(float3 c, float gamma)
+{
+    return pow(saturate(c), 1.0f / gamma);
+}
+
+//RgXg(0.5𒆐Samount{0`1ɐ؂l߂)
+float3 ColorContrast(float3 c, float amount)
+{
+    return saturate((c - 0.5f) * amount + 0.5f);
+}
+
+//F(ƂɊ|)
+float3 ColorTint(float3 c, float3 tint)
+{
+    return c * tint;
+}
@@ -0,0 +1,125 @@
+﻿#include "ComputeExecutor.h"
+#include<cassert>
+#include<algorithm>
+
+using namespace std;
+
+namespace {
+	//スレッドごとのワーカー番号(呼び出し元は0)
+	thread_local unsigned int currentWorkerIndex = 0;
+	//ワーカースレッド内で実行中かどうか(入れ子のParallelFor対策)
+	thread_local bool insideJob = false;
+}
+
+ComputeExecutor::ComputeExecutor(unsigned int threadCount) :nextIndex_(0) {
+	if (threadCount == 0) {
+		threadCount = max(thread::hardware_concurrency(), 1u);
+	}
+	//呼び出し元スレッドも働くのでワーカーは1つ少なく作る
+	workers_.reserve(threadCount - 1);
+	for (unsigned int i = 1; i < threadCount; ++i) {
+		workers_.emplace_back(&ComputeExecutor::WorkerLoop, this, i);
+	}
+}
+
+ComputeExecutor::~ComputeExecutor()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		quit_ = true;
+	}
+	wakeCondition_.notify_all();
+	for (auto& w : workers_) {
+		w.join();
+	}
+}
+
+ComputeExecutor&
+ComputeExecutor::Instance() {
+	static ComputeExecutor instance;
+	return instance;
+}
+
+unsigned int
+ComputeExecutor::ThreadCount()const {
+	return static_cast<unsigned int>(workers_.size()) + 1;
+}
+
+unsigned int
+ComputeExecutor::WorkerIndex() {
+	return currentWorkerIndex;
+}
+
+void
+ComputeExecutor::RunChunks() {
+	const auto& func = *job_;
+	for (;;) {
+		auto begin = nextIndex_.fetch_add(jobGrain_, memory_order_relaxed);
+		if (begin >= jobCount_) {
+			break;
+		}
+		auto end = min(begin + jobGrain_, jobCount_);
+		func(begin, end);
+	}
+}
+
+void
+ComputeExecutor::WorkerLoop(unsigned int workerIndex) {
+	currentWorkerIndex = workerIndex;
+	insideJob = true;
+	size_t seenGeneration = 0;
+	for (;;) {
+		{
+			unique_lock<mutex> lock(mutex_);
+			wakeCondition_.wait(lock, [&]() {return quit_ || generation_ != seenGeneration; });
+			if (quit_) {
+				return;
+			}
+			seenGeneration = generation_;
+		}
+		RunChunks();
+		{
+			lock_guard<mutex> lock(mutex_);
+			++finishedWorkers_;
+		}
+		doneCondition_.notify_one();
+	}
+}
+
+void
+ComputeExecutor::ParallelFor(size_t count, size_t grain, const function<void(size_t, size_t)>& func) {
+	if (count == 0) {
+		return;
+	}
+	if (grain == 0) {
+		grain = 1;
+	}
+	//ワーカーが1つもない、要素が1チャンク分しかない、
+	//すでにジョブの中にいる場合はその場で逐次実行
+	if (workers_.empty() || count <= grain || insideJob) {
+		func(0, count);
+		return;
+	}
+
+	lock_guard<mutex> submitLock(submitMutex_);
+	{
+		lock_guard<mutex> lock(mutex_);
+		job_ = &func;
+		jobCount_ = count;
+		jobGrain_ = grain;
+		nextIndex_.store(0, memory_order_relaxed);
+		finishedWorkers_ = 0;
+		++generation_;
+	}
+	wakeCondition_.notify_all();
+
+	//呼び出し元スレッドも参加する
+	insideJob = true;
+	RunChunks();
+	insideJob = false;
+
+	//全ワーカーが抜けるまで待つ(jobはこの関数の引数なので先に戻れない)
+	unique_lock<mutex> lock(mutex_);
+	doneCondition_.wait(lock, [&]() {return finishedWorkers_ == workers_.size(); });
+	job_ = nullptr;
+}
@@ -0,0 +1,167 @@
+﻿#pragma once
+#include<vector>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<atomic>
+#include<functional>
+#include<memory>
+#include"HlslTypes.h"
+
+///カーネルに渡すシステム値(HLSLのSV_～と同じ意味)
+struct ComputeThreadId {
+	hlsl::uint3 groupId;//SV_GroupID
+	hlsl::uint3 groupThreadId;//SV_GroupThreadID
+	hlsl::uint3 dispatchThreadId;//SV_DispatchThreadID
+	unsigned int groupIndex;//SV_GroupIndex
+};
+
+///バリアをまたぐローカル変数がないカーネル用
+struct NoThreadLocal {};
+
+///コンピュートシェーダのDispatchをCPUで実行するクラス
+///スレッドグループ単位で全コアに振り分ける
+class ComputeExecutor
+{
+	std::vector<std::thread> workers_;//ワーカースレッド(呼び出し元スレッドも実行に参加する)
+
+	//実行中のジョブ
+	const std::function<void(size_t, size_t)>* job_ = nullptr;
+	size_t jobCount_ = 0;//要素数
+	size_t jobGrain_ = 1;//一度に取っていく要素数
+	std::atomic<size_t> nextIndex_;//次に取る要素
+	size_t generation_ = 0;//ジョブの世代(ワーカーの起床判定用)
+	unsigned int finishedWorkers_ = 0;//今の世代を終えたワーカー数
+	bool quit_ = false;
+
+	std::mutex mutex_;
+	std::condition_variable wakeCondition_;//ワーカー起床用
+	std::condition_variable doneCondition_;//完了通知用
+	std::mutex submitMutex_;//複数スレッドからのジョブ投入を直列化する
+
+	void WorkerLoop(unsigned int workerIndex);
+	//ジョブの要素を取れるだけ取って実行する
+	void RunChunks();
+
+	ComputeExecutor(const ComputeExecutor&) = delete;
+	void operator=(const ComputeExecutor&) = delete;
+public:
+	///@param threadCount 実行スレッド数(0ならハードウェアスレッド数)
+	explicit ComputeExecutor(unsigned int threadCount = 0);
+	~ComputeExecutor();
+
+	///プロセス共通のエグゼキュータを得る
+	static ComputeExecutor& Instance();
+
+	///実行に使うスレッド数(呼び出し元スレッドを含む)
+	unsigned int ThreadCount()const;
+
+	///現在のスレッドのワーカー番号を返す
+	///@return 呼び出し元スレッドは0、ワーカーは1～ThreadCount()-1
+	///@remarks スレッドごとの作業領域を引くのに使う
+	static unsigned int WorkerIndex();
+
+	///[0,count)を grain 個ずつに分けて全スレッドで実行する
+	///@param count 要素数
+	///@param grain 一度に処理する要素数
+	///@param func func(begin,end)の形で呼ばれる
+	///@remarks ワーカーの中から呼ばれた場合はその場で逐次実行する
+	void ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& func);
+
+	///Dispatch(x,y,z)をCPUで実行する
+	///@param numThreads [numthreads(x,y,z)]に相当
+	///@param x,y,z グループ数
+	///@param kernel kernel(const ComputeThreadId&)の形で1スレッド分ずつ呼ばれる
+	template<typename Kernel>
+	void Dispatch(const hlsl::uint3& numThreads, unsigned int x, unsigned int y, unsigned int z, Kernel&& kernel);
+
+	///groupshared変数とGroupMemoryBarrierWithGroupSyncを使うカーネルをCPUで実行する
+	///@param numThreads [numthreads(x,y,z)]に相当
+	///@param x,y,z グループ数
+	///@param phases バリアで区切られた処理(phase(id, groupShared, threadLocal)の形で呼ばれる)
+	///@remarks OSスレッドやファイバーでグループ内スレッドを再現するのではなく
+	///バリアの位置でループを分割(ループ分裂)して、フェーズごとにグループ内の全スレッドを回す。
+	///バリアをまたいで持ち越したいローカル変数はThreadLocalに入れておくこと。
+	///GroupSharedはチャンクごとに確保してグループ間で使いまわすので、HLSL同様に初期値は不定とみなすこと
+	template<typename GroupShared, typename ThreadLocal = NoThreadLocal, typename... Phases>
+	void DispatchGroupShared(const hlsl::uint3& numThreads, unsigned int x, unsigned int y, unsigned int z, Phases&&... phases);
+};
+
+namespace ComputeExecutorDetail {
+	///グループ数からParallelForの粒度を決める
+	inline size_t GroupGrain(size_t groupNum, unsigned int threadCount) {
+		//ワーカー1つあたり8回くらいは取りに来られる粒度にしておく
+		size_t grain = groupNum / (static_cast<size_t>(threadCount) * 8);
+		return grain == 0 ? 1 : grain;
+	}
+
+	///線形のグループ番号からSV_GroupIDを求める
+	inline hlsl::uint3 GroupIdFromIndex(size_t g, unsigned int x, unsigned int y) {
+		return {
+			static_cast<unsigned int>(g % x),
+			static_cast<unsigned int>((g / x) % y),
+			static_cast<unsigned int>(g / (static_cast<size_t>(x) * y)) };
+	}
+
+	///グループ内の全スレッドについてfunc(id)を呼ぶ
+	///SV_GroupIndex = z*nx*ny + y*nx + x になるようにxを一番内側で回す
+	template<typename Func>
+	inline void ForEachThreadInGroup(const hlsl::uint3& numThreads, const hlsl::uint3& groupId, Func&& func) {
+		ComputeThreadId id = {};
+		id.groupId = groupId;
+		unsigned int groupIndex = 0;
+		for (unsigned int tz = 0; tz < numThreads.z; ++tz) {
+			for (unsigned int ty = 0; ty < numThreads.y; ++ty) {
+				for (unsigned int tx = 0; tx < numThreads.x; ++tx) {
+					id.groupThreadId = { tx, ty, tz };
+					id.dispatchThreadId.x = groupId.x * numThreads.x + tx;
+					id.dispatchThreadId.y = groupId.y * numThreads.y + ty;
+					id.dispatchThreadId.z = groupId.z * numThreads.z + tz;
+					id.groupIndex = groupIndex++;
+					func(id);
+				}
+			}
+		}
+	}
+}
+
+template<typename Kernel>
+void
+ComputeExecutor::Dispatch(const hlsl::uint3& numThreads, unsigned int x, unsigned int y, unsigned int z, Kernel&& kernel) {
+	const size_t groupNum = static_cast<size_t>(x) * y * z;
+	if (groupNum == 0) {
+		return;
+	}
+	using namespace ComputeExecutorDetail;
+	ParallelFor(groupNum, GroupGrain(groupNum, ThreadCount()), [&](size_t begin, size_t end) {
+		for (auto g = begin; g < end; ++g) {
+			ForEachThreadInGroup(numThreads, GroupIdFromIndex(g, x, y), kernel);
+		}
+	});
+}
+
+template<typename GroupShared, typename ThreadLocal, typename... Phases>
+void
+ComputeExecutor::DispatchGroupShared(const hlsl::uint3& numThreads, unsigned int x, unsigned int y, unsigned int z, Phases&&... phases) {
+	const size_t groupNum = static_cast<size_t>(x) * y * z;
+	if (groupNum == 0) {
+		return;
+	}
+	using namespace ComputeExecutorDetail;
+	const size_t threadsPerGroup = static_cast<size_t>(numThreads.x) * numThreads.y * numThreads.z;
+	ParallelFor(groupNum, GroupGrain(groupNum, ThreadCount()), [&](size_t begin, size_t end) {
+		//groupshared領域とスレッドローカル領域はチャンク内のグループで使いまわす
+		std::unique_ptr<GroupShared> groupShared(new GroupShared());
+		std::vector<ThreadLocal> threadLocals(threadsPerGroup);
+		for (auto g = begin; g < end; ++g) {
+			auto groupId = GroupIdFromIndex(g, x, y);
+			//フェーズの切れ目がGroupMemoryBarrierWithGroupSyncに相当する
+			auto runPhase = [&](auto& phase) {
+				ForEachThreadInGroup(numThreads, groupId, [&](const ComputeThreadId& id) {
+					phase(id, *groupShared, threadLocals[id.groupIndex]);
+				});
+			};
+			(runPhase(phases), ...);
+		}
+	});
+}
@@ -0,0 +1,112 @@
+﻿#pragma once
+#include<vector>
+#include<memory>
+#include<cassert>
+#include"HlslLayout.h"
+#include"ComputeExecutor.h"
+
+///カーネルから見た入力バッファ(StructuredBuffer<T>に相当)
+template<typename T>
+struct StructuredBufferView {
+	const T* data;
+	size_t count;
+	const T& operator[](size_t i)const {
+		assert(i < count);
+		return data[i];
+	}
+};
+
+///カーネルから見た出力バッファ(RWStructuredBuffer<T>に相当)
+template<typename T>
+struct RWStructuredBufferView {
+	T* data;
+	size_t count;
+	T& operator[](size_t i)const {
+		assert(i < count);
+		return data[i];
+	}
+};
+
+///入力1本(t0)、出力1本(u0)のコンピュートジョブ
+///FirstStepの「アップロード→Dispatch→リードバック」をまとめたもので、
+///バッファは大きくなるときだけ作り直し、呼び出しをまたいで使いまわす
+///@param In 入力の要素型(StructuredBuffer<In>)
+///@param Out 出力の要素型(RWStructuredBuffer<Out>)
+///@remarks 出力は前回の内容を残したまま(クリアしない)なのはGPUのUAVと同じ
+template<typename In, typename Out>
+class ComputeJob
+{
+	static_assert(IsHlslStructuredElement<In>::value, "In must have the same layout as an HLSL StructuredBuffer element");
+	static_assert(IsHlslStructuredElement<Out>::value, "Out must have the same layout as an HLSL StructuredBuffer element");
+public:
+	virtual ~ComputeJob() = default;
+
+	///入力と出力の要素数を決める
+	///@remarks 今の容量に収まるなら確保し直さない
+	virtual void Resize(size_t inCount, size_t outCount) = 0;
+
+	///入力の書き込み先(InputCount()個)
+	///@remarks Runの間は書き換えないこと
+	virtual In* Input() = 0;
+	virtual size_t InputCount()const = 0;
+
+	///Dispatch(x,y,z)を実行して、出力が読めるようになるまで待つ
+	virtual void Run(unsigned int x, unsigned int y, unsigned int z) = 0;
+
+	///最後のRunの出力(OutputCount()個)
+	virtual const Out* Output()const = 0;
+	virtual size_t OutputCount()const = 0;
+};
+
+///ComputeExecutorで実行するComputeJob
+///@param Kernel kernel(const ComputeThreadId&, StructuredBufferView<In>, RWStructuredBufferView<Out>)の形で1スレッド分ずつ呼ばれる
+template<typename In, typename Out, typename Kernel>
+class CpuComputeJob : public ComputeJob<In, Out>
+{
+	ComputeExecutor& executor_;
+	hlsl::uint3 numThreads_;
+	Kernel kernel_;
+	std::vector<In> input_;
+	std::vector<Out> output_;
+	size_t inCount_ = 0;
+	size_t outCount_ = 0;
+public:
+	///@param executor 実行するエグゼキュータ
+	///@param numThreads [numthreads(x,y,z)]に相当
+	///@param kernel カーネル
+	CpuComputeJob(ComputeExecutor& executor, const hlsl::uint3& numThreads, Kernel kernel) :
+		executor_(executor), numThreads_(numThreads), kernel_(kernel) {}
+
+	void Resize(size_t inCount, size_t outCount)override {
+		//vectorは縮めても容量を保つので、大きくなるときだけ確保される
+		input_.resize(inCount);
+		output_.resize(outCount);
+		inCount_ = inCount;
+		outCount_ = outCount;
+	}
+	In* Input()override {
+		return input_.data();
+	}
+	size_t InputCount()const override {
+		return inCount_;
+	}
+	void Run(unsigned int x, unsigned int y, unsigned int z)override {
+		StructuredBufferView<In> in = { input_.data(),inCount_ };
+		RWStructuredBufferView<Out> out = { output_.data(),outCount_ };
+		executor_.Dispatch(numThreads_, x, y, z, [&](const ComputeThreadId& id) {
+			kernel_(id, in, out);
+		});
+	}
+	const Out* Output()const override {
+		return output_.data();
+	}
+	size_t OutputCount()const override {
+		return outCount_;
+	}
+};
+
+///CpuComputeJobを作る(カーネルの型を推論させるため)
+template<typename In, typename Out, typename Kernel>
+std::unique_ptr<ComputeJob<In, Out>> MakeCpuComputeJob(ComputeExecutor& executor, const hlsl::uint3& numThreads, Kernel kernel) {
+	return std::unique_ptr<ComputeJob<In, Out>>(new CpuComputeJob<In, Out, Kernel>(executor, numThreads, kernel));
+}
@@ -0,0 +1,171 @@
+﻿#include "CpuFeatures.h"
+#include<algorithm>
+#include<cctype>
+#include<cstring>
+#include<cstdint>
+#include<cstdlib>
+#if defined(CPU_ARCH_X86)
+#if defined(_MSC_VER)
+#include<intrin.h>
+#else
+#include<cpuid.h>
+#endif
+#endif
+#if defined(CPU_ARCH_ARM64) && defined(__linux__)
+#include<sys/auxv.h>
+#include<asm/hwcap.h>
+#endif
+
+using namespace std;
+
+namespace {
+	const char* isaNames[] = { "scalar","sse41","avx2","avx512","neon" };
+	static_assert(sizeof(isaNames) / sizeof(isaNames[0]) == static_cast<size_t>(CpuIsa::Count), "isaNames");
+
+#if defined(CPU_ARCH_X86)
+	void CpuId(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+		int r[4];
+		__cpuidex(r, leaf, subleaf);
+		for (int i = 0; i < 4; ++i) {
+			regs[i] = static_cast<unsigned int>(r[i]);
+		}
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	//OSが保存してくれるレジスタ(XCR0)
+	uint64_t GetXcr0() {
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int lo, hi;
+		__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+	}
+#endif
+
+	///CPUの対応状況(初回に一度だけ調べる)
+	struct CpuFeatures {
+		bool supported[static_cast<size_t>(CpuIsa::Count)] = {};
+		string model;
+
+		CpuFeatures() {
+			supported[static_cast<size_t>(CpuIsa::Scalar)] = true;
+#if defined(CPU_ARCH_X86)
+			unsigned int regs[4];
+			CpuId(0, 0, regs);
+			auto maxLeaf = regs[0];
+			CpuId(1, 0, regs);
+			auto ecx1 = regs[2];
+			unsigned int ebx7 = 0;
+			if (maxLeaf >= 7) {
+				CpuId(7, 0, regs);
+				ebx7 = regs[1];
+			}
+			//AVX以降はOSがYMM/ZMMを保存していることも確認する
+			uint64_t xcr0 = (ecx1 & (1u << 27)) ? GetXcr0() : 0;//OSXSAVE
+			bool ymm = (xcr0 & 0x6) == 0x6;
+			bool zmm = ymm && (xcr0 & 0xe0) == 0xe0;
+			bool sse41 = (ecx1 & (1u << 19)) != 0;
+			bool avx = (ecx1 & (1u << 28)) != 0;
+			bool fma = (ecx1 & (1u << 12)) != 0;
+			bool avx2 = (ebx7 & (1u << 5)) != 0;
+			const unsigned int avx512Bits = (1u << 16) | (1u << 17) | (1u << 30) | (1u << 31);//F,DQ,BW,VL
+			supported[static_cast<size_t>(CpuIsa::SSE41)] = sse41;
+			supported[static_cast<size_t>(CpuIsa::AVX2)] = sse41 && ymm && avx && avx2 && fma;
+			supported[static_cast<size_t>(CpuIsa::AVX512)] = supported[static_cast<size_t>(CpuIsa::AVX2)] && zmm && (ebx7 & avx512Bits) == avx512Bits;
+
+			CpuId(0x80000000, 0, regs);
+			if (regs[0] >= 0x80000004) {
+				char brand[49] = {};
+				for (unsigned int i = 0; i < 3; ++i) {
+					CpuId(0x80000002 + i, 0, regs);
+					memcpy(brand + i * 16, regs, 16);
+				}
+				model = brand;
+			}
+#elif defined(CPU_ARCH_ARM64)
+#if defined(__linux__)
+			supported[static_cast<size_t>(CpuIsa::NEON)] = (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+			//ARM64のWindows/macOSではNEONは必ずある
+			supported[static_cast<size_t>(CpuIsa::NEON)] = true;
+#endif
+			model = "arm64";
+#endif
+			//前後の空白を取る
+			auto notSpace = [](char c) {return !isspace(static_cast<unsigned char>(c)); };
+			model.erase(model.begin(), find_if(model.begin(), model.end(), notSpace));
+			model.erase(find_if(model.rbegin(), model.rend(), notSpace).base(), model.end());
+			if (model.empty()) {
+				model = "unknown";
+			}
+		}
+	};
+
+	const CpuFeatures& GetCpuFeatures() {
+		static CpuFeatures features;
+		return features;
+	}
+}
+
+const char*
+CpuIsaName(CpuIsa isa) {
+	auto idx = static_cast<size_t>(isa);
+	return idx < static_cast<size_t>(CpuIsa::Count) ? isaNames[idx] : "unknown";
+}
+
+bool
+ParseCpuIsa(const string& name, CpuIsa& isa) {
+	string lower(name);
+	transform(lower.begin(), lower.end(), lower.begin(), [](char c) {return static_cast<char>(tolower(static_cast<unsigned char>(c))); });
+	for (size_t i = 0; i < static_cast<size_t>(CpuIsa::Count); ++i) {
+		if (lower == isaNames[i]) {
+			isa = static_cast<CpuIsa>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+IsCpuIsaSupported(CpuIsa isa) {
+	auto idx = static_cast<size_t>(isa);
+	return idx < static_cast<size_t>(CpuIsa::Count) && GetCpuFeatures().supported[idx];
+}
+
+bool
+CpuIsaIncludes(CpuIsa upper, CpuIsa isa) {
+	if (isa == CpuIsa::Scalar || upper == isa) {
+		return true;
+	}
+	if (upper == CpuIsa::NEON || isa == CpuIsa::NEON) {
+		return false;
+	}
+	return static_cast<int>(isa) <= static_cast<int>(upper);
+}
+
+const string&
+CpuModelName() {
+	return GetCpuFeatures().model;
+}
+
+string
+GetEnvironmentString(const char* name) {
+#if defined(_MSC_VER)
+	char* value = nullptr;
+	size_t len = 0;
+	if (_dupenv_s(&value, &len, name) != 0 || value == nullptr) {
+		return "";
+	}
+	string result(value);
+	free(value);
+	return result;
+#else
+	auto value = getenv(name);
+	return value ? value : "";
+#endif
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+#include<string>
+
+//CPUの命令セット判定と、命令セット別の関数を1つの翻訳単位に書くためのマクロ
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define CPU_ARCH_X86 1
+#endif
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define CPU_ARCH_ARM64 1
+#endif
+
+//命令セット別の関数に付ける属性
+//MSVCは/archなしでも組み込み関数を使えるので何も付けない
+//GCC/clangは関数ごとにtarget属性を付ける(ファイルごとのコンパイルオプションは不要)
+#if defined(CPU_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CPU_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define CPU_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma")))
+#else
+#define CPU_TARGET_SSE41
+#define CPU_TARGET_AVX2
+#define CPU_TARGET_AVX512
+#endif
+
+///カーネルの実装が使う命令セット
+///@remarks 後ろほど優先度が高い(同時に使えるものの中から一番後ろを選ぶ)
+enum class CpuIsa {
+	Scalar,
+	SSE41,
+	AVX2,//AVX2+FMA
+	AVX512,//AVX-512 F/BW/DQ/VL
+	NEON,
+	Count
+};
+
+///命令セットの名前("scalar","sse41","avx2","avx512","neon")
+const char* CpuIsaName(CpuIsa isa);
+
+///名前から命令セットを得る(大文字小文字は区別しない)
+///@retval true 名前が正しかった
+bool ParseCpuIsa(const std::string& name, CpuIsa& isa);
+
+///このCPU(とOS)でisaが使えるかどうか
+///@remarks CPUID/XGETBV(x86)、hwcap(ARM)で初回に一度だけ調べる
+bool IsCpuIsaSupported(CpuIsa isa);
+
+///upperを指定したとき、isaの実装を選んでよいかどうか
+///(AVX512⊃AVX2⊃SSE41⊃Scalar、NEON⊃Scalar)
+bool CpuIsaIncludes(CpuIsa upper, CpuIsa isa);
+
+///CPUの名前(x86はCPUIDのブランド文字列)
+const std::string& CpuModelName();
+
+///環境変数を読む(なければ空文字列)
+std::string GetEnvironmentString(const char* name);
@@ -0,0 +1,160 @@
+﻿#pragma once
+#include<d3d12.h>
+#include<d3dx12.h>
+#include<wrl.h>
+#include<cassert>
+#include<algorithm>
+#include"ComputeJob.h"
+
+///D3D12のコンピュートキューで実行するComputeJob
+///UPLOADの入力、DEFAULTのUAV、READBACKのコピー先を持ち、入力と出力は確保したときに
+///Mapしたままにしておく(Runは完了を待つので、Runの外ではCPUから読み書きしてよい)
+///@remarks ルートシグネチャは0番にディスクリプタテーブル(u0,t0の順)を持つこと(FirstStepと同じ)
+template<typename In, typename Out>
+class D3D12ComputeJob : public ComputeJob<In, Out>
+{
+	template<typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	ComPtr<ID3D12Device> dev_;
+	ComPtr<ID3D12CommandQueue> cmdQue_;
+	ComPtr<ID3D12PipelineState> pipeline_;
+	ComPtr<ID3D12RootSignature> rootSignature_;
+	ComPtr<ID3D12CommandAllocator> cmdAlloc_;
+	ComPtr<ID3D12GraphicsCommandList> cmdList_;
+	ComPtr<ID3D12Fence> fence_;
+	UINT64 fenceValue_ = 0;
+	HANDLE fenceEvent_ = nullptr;
+	ComPtr<ID3D12DescriptorHeap> descriptorHeap_;//UAV,SRV
+
+	ComPtr<ID3D12Resource> inBuffer_;//UPLOAD
+	ComPtr<ID3D12Resource> outBuffer_;//DEFAULT(UAV)
+	ComPtr<ID3D12Resource> readbackBuffer_;//READBACK
+	In* mappedIn_ = nullptr;
+	Out* mappedOut_ = nullptr;
+	size_t inCount_ = 0;
+	size_t outCount_ = 0;
+	size_t inCapacity_ = 0;
+	size_t outCapacity_ = 0;
+
+	HRESULT CreateBuffer(D3D12_HEAP_TYPE heapType, size_t size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state, ComPtr<ID3D12Resource>& res) {
+		CD3DX12_HEAP_PROPERTIES heapProp(heapType);
+		auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(size, flags);
+		return dev_->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, state, nullptr, IID_PPV_ARGS(res.ReleaseAndGetAddressOf()));
+	}
+
+	//要素数に合わせてビューを作り直す(ディスクリプタを書き換えるだけで確保はしない)
+	void CreateViews() {
+		D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+		uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.NumElements = static_cast<UINT>(outCount_);
+		uavDesc.Buffer.StructureByteStride = sizeof(Out);
+		auto handle = descriptorHeap_->GetCPUDescriptorHandleForHeapStart();
+		dev_->CreateUnorderedAccessView(outBuffer_.Get(), nullptr, &uavDesc, handle);
+
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.NumElements = static_cast<UINT>(inCount_);
+		srvDesc.Buffer.StructureByteStride = sizeof(In);
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		handle.ptr += dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		dev_->CreateShaderResourceView(inBuffer_.Get(), &srvDesc, handle);
+	}
+
+	D3D12ComputeJob(const D3D12ComputeJob&) = delete;
+	void operator=(const D3D12ComputeJob&) = delete;
+public:
+	///@param dev デバイス
+	///@param cmdQue 実行するキュー(D3D12_COMMAND_LIST_TYPE_COMPUTE)
+	///@param pipeline コンピュートパイプライン
+	///@param rootSignature pipelineのルートシグネチャ
+	D3D12ComputeJob(ID3D12Device* dev, ID3D12CommandQueue* cmdQue, ID3D12PipelineState* pipeline, ID3D12RootSignature* rootSignature) :
+		dev_(dev), cmdQue_(cmdQue), pipeline_(pipeline), rootSignature_(rootSignature) {
+		auto result = dev_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&cmdAlloc_));
+		assert(SUCCEEDED(result));
+		result = dev_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, cmdAlloc_.Get(), pipeline_.Get(), IID_PPV_ARGS(&cmdList_));
+		assert(SUCCEEDED(result));
+		cmdList_->Close();
+		result = dev_->CreateFence(fenceValue_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+		assert(SUCCEEDED(result));
+		fenceEvent_ = CreateEvent(nullptr, false, false, nullptr);
+
+		D3D12_DESCRIPTOR_HEAP_DESC descHeapDesc = {};
+		descHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+		descHeapDesc.NumDescriptors = 2;//UAV,SRV
+		descHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		result = dev_->CreateDescriptorHeap(&descHeapDesc, IID_PPV_ARGS(&descriptorHeap_));
+		assert(SUCCEEDED(result));
+	}
+	~D3D12ComputeJob() {
+		CloseHandle(fenceEvent_);
+	}
+
+	void Resize(size_t inCount, size_t outCount)override {
+		HRESULT result = S_OK;
+		//0要素のバッファは作れないので最低1要素ぶん確保する
+		if (inBuffer_ == nullptr || inCount > inCapacity_) {
+			inCapacity_ = std::max<size_t>(inCount, 1);
+			result = CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, inCapacity_ * sizeof(In), D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, inBuffer_);
+			assert(SUCCEEDED(result));
+			D3D12_RANGE noRead = { 0,0 };//CPUからは読まない
+			result = inBuffer_->Map(0, &noRead, reinterpret_cast<void**>(&mappedIn_));
+			assert(SUCCEEDED(result));
+		}
+		if (outBuffer_ == nullptr || outCount > outCapacity_) {
+			outCapacity_ = std::max<size_t>(outCount, 1);
+			result = CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, outCapacity_ * sizeof(Out), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, outBuffer_);
+			assert(SUCCEEDED(result));
+			result = CreateBuffer(D3D12_HEAP_TYPE_READBACK, outCapacity_ * sizeof(Out), D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COPY_DEST, readbackBuffer_);
+			assert(SUCCEEDED(result));
+			//読み出す範囲はOut型の要素数ぶん(floatで計算すると足りない)
+			D3D12_RANGE readRange = { 0,outCapacity_ * sizeof(Out) };
+			result = readbackBuffer_->Map(0, &readRange, reinterpret_cast<void**>(&mappedOut_));
+			assert(SUCCEEDED(result));
+		}
+		inCount_ = inCount;
+		outCount_ = outCount;
+		CreateViews();
+	}
+	In* Input()override {
+		return mappedIn_;
+	}
+	size_t InputCount()const override {
+		return inCount_;
+	}
+	void Run(unsigned int x, unsigned int y, unsigned int z)override {
+		cmdAlloc_->Reset();
+		cmdList_->Reset(cmdAlloc_.Get(), pipeline_.Get());
+		cmdList_->SetComputeRootSignature(rootSignature_.Get());
+		ID3D12DescriptorHeap* descHeaps[] = { descriptorHeap_.Get() };
+		cmdList_->SetDescriptorHeaps(1, descHeaps);
+		cmdList_->SetComputeRootDescriptorTable(0, descriptorHeap_->GetGPUDescriptorHandleForHeapStart());
+		cmdList_->Dispatch(x, y, z);
+
+		//UAVをリードバック用バッファにコピーして、次のRunのためにUAVに戻す
+		auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(outBuffer_.Get(),
+			D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		cmdList_->ResourceBarrier(1, &barrier);
+		cmdList_->CopyBufferRegion(readbackBuffer_.Get(), 0, outBuffer_.Get(), 0, outCount_ * sizeof(Out));
+		barrier = CD3DX12_RESOURCE_BARRIER::Transition(outBuffer_.Get(),
+			D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		cmdList_->ResourceBarrier(1, &barrier);
+		cmdList_->Close();
+
+		ID3D12CommandList* cmdLists[] = { cmdList_.Get() };
+		cmdQue_->ExecuteCommandLists(1, cmdLists);
+		cmdQue_->Signal(fence_.Get(), ++fenceValue_);
+		if (fence_->GetCompletedValue() < fenceValue_) {
+			fence_->SetEventOnCompletion(fenceValue_, fenceEvent_);
+			WaitForSingleObject(fenceEvent_, INFINITE);
+		}
+	}
+	const Out* Output()const override {
+		return mappedOut_;
+	}
+	size_t OutputCount()const override {
+		return outCount_;
+	}
+};
@@ -0,0 +1,67 @@
+﻿#pragma once
+#include<string>
+#include<regex>
+#include<fstream>
+#include<sstream>
+#include"HlslTypes.h"
+
+///Dispatchに渡すグループ数と、カーネルに渡す実際の処理範囲
+struct DispatchPlan {
+	hlsl::uint3 numThreads;//[numthreads(x,y,z)]
+	hlsl::uint3 groups;//Dispatch(x,y,z)に渡すグループ数
+	hlsl::uint3 size;//処理範囲(これを超えるスレッドはカーネル側で弾く)
+};
+
+///リソースの大きさを覆うのに必要なグループ数を返す(端数は切り上げ)
+///@param numThreads [numthreads(x,y,z)]
+///@param width,height,depth 処理範囲
+///@remarks 端数の分だけ範囲外のスレッドが走るので、カーネルは処理範囲で判定すること
+inline hlsl::uint3 GroupCountFor(const hlsl::uint3& numThreads, unsigned int width, unsigned int height, unsigned int depth = 1) {
+	auto divUp = [](unsigned int n, unsigned int d) {
+		return d == 0 ? 0 : (n + d - 1) / d;
+	};
+	return { divUp(width,numThreads.x),divUp(height,numThreads.y),divUp(depth,numThreads.z) };
+}
+
+///[numthreads]と処理範囲からDispatchの計画を立てる
+inline DispatchPlan PlanDispatch(const hlsl::uint3& numThreads, unsigned int width, unsigned int height, unsigned int depth = 1) {
+	return { numThreads,GroupCountFor(numThreads,width,height,depth),{width,height,depth} };
+}
+
+///HLSLのソースからエントリポイントの[numthreads(x,y,z)]を読む
+///@param source HLSLのソース文字列
+///@param entryPoint エントリポイント名("MonoCS"など)
+///@param numThreads 読めた値(戻り値用)
+///@return 見つかればtrue
+///@remarks マクロで書かれた値は読めない。D3D12側ではコンパイル済みのBlobを
+///ID3D12ShaderReflection::GetThreadGroupSizeで調べるほうが確実
+inline bool ReadNumThreads(const std::string& source, const std::string& entryPoint, hlsl::uint3& numThreads) {
+	//コメントアウトされた宣言を拾わないように先に消しておく
+	static const std::regex comment(R"(//[^\n]*|/\*[\s\S]*?\*/)");
+	auto code = std::regex_replace(source, comment, " ");
+	static const std::regex attribute(R"(\[\s*numthreads\s*\(\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*\)\s*\]\s*void\s+(\w+)\s*\()");
+	for (std::sregex_iterator it(code.begin(), code.end(), attribute), end; it != end; ++it) {
+		if ((*it)[4] == entryPoint) {
+			numThreads = { static_cast<unsigned int>(std::stoul((*it)[1])),
+				static_cast<unsigned int>(std::stoul((*it)[2])),
+				static_cast<unsigned int>(std::stoul((*it)[3])) };
+			return true;
+		}
+	}
+	return false;
+}
+
+///HLSLファイルからエントリポイントの[numthreads(x,y,z)]を読む
+///@param path HLSLファイルのパス
+///@param entryPoint エントリポイント名
+///@param numThreads 読めた値(戻り値用)
+///@return ファイルが読めて、エントリポイントが見つかればtrue
+inline bool ReadNumThreadsFromFile(const std::string& path, const std::string& entryPoint, hlsl::uint3& numThreads) {
+	std::ifstream ifs(path, std::ios::binary);
+	if (!ifs) {
+		return false;
+	}
+	std::stringstream ss;
+	ss << ifs.rdbuf();
+	return ReadNumThreads(ss.str(), entryPoint, numThreads);
+}
@@ -0,0 +1,130 @@
+﻿#include "DispatchPlanCheck.h"
+#include<cstdio>
+#include<cstdint>
+#include<vector>
+#include"DispatchPlan.h"
+#include"ComputeExecutor.h"
+#include"MonoFilter.h"
+
+//シェーダと共有している関数
+namespace hlsl {
+	namespace {
+#include"MonoPixel.hlsli"
+	}
+}
+
+using namespace std;
+using hlsl::uint3;
+
+namespace {
+	int passCount = 0;
+	int failCount = 0;
+
+	void Check(const char* name, bool ok) {
+		if (ok) {
+			++passCount;
+		}
+		else {
+			++failCount;
+			printf("FAIL: %s\n", name);
+		}
+	}
+
+	void CheckGroupCount() {
+		Check("1280x720 / 8x8", all(GroupCountFor({ 8,8,1 }, 1280, 720) == uint3(160, 90, 1)));
+		Check("200x200 / 4x4", all(GroupCountFor({ 4,4,1 }, 200, 200) == uint3(50, 50, 1)));
+		//端数は切り上げ
+		Check("203x101 / 4x4", all(GroupCountFor({ 4,4,1 }, 203, 101) == uint3(51, 26, 1)));
+		Check("1x1 / 8x8", all(GroupCountFor({ 8,8,1 }, 1, 1) == uint3(1, 1, 1)));
+		Check("0x0 dispatches nothing", all(GroupCountFor({ 8,8,1 }, 0, 0) == uint3(0, 0, 1)));
+		Check("3D", all(GroupCountFor({ 4,4,4 }, 8, 8, 9) == uint3(2, 2, 3)));
+		auto plan = PlanDispatch({ 16,16,1 }, 1920, 1081);
+		Check("plan keeps real size", all(plan.size == uint3(1920, 1081, 1)) && all(plan.groups == uint3(120, 68, 1)));
+	}
+
+	void CheckReadNumThreads() {
+		const char* source =
+			"//[numthreads(1,1,1)]\n"
+			"//void MonoCS(uint3 dtid : SV_DispatchThreadID)\n"
+			"/* [numthreads(2,2,2)] void MonoCS() */\n"
+			"[numthreads(16, 8, 1)]\n"
+			"void BlurCS(uint3 dtid : SV_DispatchThreadID) {}\n"
+			"[ numthreads( 8 ,8,1 ) ]\n"
+			"void MonoCS( uint3 dtid : SV_DispatchThreadID) {}\n";
+		uint3 nt;
+		Check("read entry point", ReadNumThreads(source, "MonoCS", nt) && all(nt == uint3(8, 8, 1)));
+		Check("read other entry point", ReadNumThreads(source, "BlurCS", nt) && all(nt == uint3(16, 8, 1)));
+		Check("missing entry point", !ReadNumThreads(source, "main", nt));
+		Check("missing file", !ReadNumThreadsFromFile("not_found.hlsl", "main", nt));
+	}
+
+	///MonoCSと同じ判定(all(dtid.xy < imageSize))でDispatchして、全画素を1回ずつ処理するか
+	void CheckCoverage(const uint3& numThreads, unsigned int width, unsigned int height, ComputeExecutor& executor) {
+		ImageRGBA8 src(width, height);
+		for (size_t i = 0; i < src.pixels.size(); ++i) {
+			src.pixels[i] = static_cast<uint32_t>(i * 2654435761u);
+		}
+		ImageRGBA8 dst(width, height);
+		vector<uint8_t> hitCount(src.pixels.size());
+		auto plan = PlanDispatch(numThreads, width, height);
+		executor.Dispatch(plan.numThreads, plan.groups.x, plan.groups.y, plan.groups.z, [&](const ComputeThreadId& id) {
+			auto dtid = id.dispatchThreadId;
+			if (all(dtid.xy < plan.size.xy)) {
+				++hitCount[static_cast<size_t>(dtid.y) * width + dtid.x];
+				dst.At(dtid.x, dtid.y) = PackUnorm4x8(hlsl::MonoPixel(UnpackUnorm4x8(src.At(dtid.x, dtid.y))));
+			}
+		});
+		bool once = true;
+		for (auto c : hitCount) {
+			once = once && c == 1;
+		}
+		ImageRGBA8 reference;
+		MonoFilterReference(src, reference);
+		char name[64];
+		snprintf(name, sizeof(name), "%ux%u covered once", width, height);
+		Check(name, once);
+		snprintf(name, sizeof(name), "%ux%u matches MonoFilterReference", width, height);
+		Check(name, dst.pixels == reference.pixels);
+	}
+}
+
+bool
+CheckDispatchPlan() {
+	passCount = failCount = 0;
+	CheckGroupCount();
+	CheckReadNumThreads();
+
+	//各サンプルのシェーダの[numthreads]
+	struct ShaderEntry {
+		const char* path;
+		const char* entryPoint;
+	};
+	const ShaderEntry shaders[] = {
+		{ "../RenderTargetFilter/FilterCS.hlsl","MonoCS" },
+		{ "../TextureFilter/FilterCS.hlsl","MonoCS" },
+		{ "../FirstStep/ComputeShader.hlsl","main" },
+	};
+	vector<uint3> filterNumThreads;
+	for (auto& shader : shaders) {
+		uint3 nt;
+		bool ok = ReadNumThreadsFromFile(shader.path, shader.entryPoint, nt);
+		Check(shader.path, ok);
+		if (ok) {
+			printf("%s %s: numthreads(%u,%u,%u)\n", shader.path, shader.entryPoint, nt.x, nt.y, nt.z);
+			if (nt.z == 1) {
+				filterNumThreads.push_back(nt);
+			}
+		}
+	}
+
+	//割り切れないサイズも含めて、シェーダと同じ[numthreads]で確認する
+	auto& executor = ComputeExecutor::Instance();
+	const unsigned int sizes[][2] = { { 1,1 },{ 7,3 },{ 203,101 },{ 200,200 },{ 1280,720 } };
+	for (auto& nt : filterNumThreads) {
+		for (auto& size : sizes) {
+			CheckCoverage(nt, size[0], size[1], executor);
+		}
+	}
+	printf("dispatch plan: %d passed, %d failed\n", passCount, failCount);
+	return failCount == 0;
+}
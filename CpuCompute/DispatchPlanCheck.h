@@ -0,0 +1,8 @@
+﻿#pragma once
+
+///DispatchPlan.hのグループ数計算と[numthreads]の読み取りを確認する
+///各サンプルのシェーダから[numthreads]を読み、割り切れないサイズの画像でも
+///全画素がちょうど1回ずつ処理されることをCPUのエグゼキュータで確かめる
+///@return 全部一致したらtrue
+///@remarks シェーダは作業ディレクトリ(CpuCompute)からの相対パスで読む
+bool CheckDispatchPlan();
@@ -0,0 +1,329 @@
+﻿#include "FilterGraph.h"
+#include<algorithm>
+#include<cassert>
+
+using namespace std;
+using hlsl::float3;
+using hlsl::float4;
+
+FilterGraph::FilterGraph(unsigned int width, unsigned int height) {
+	assert(width > 0 && height > 0);
+	FilterNode source;
+	source.width = width;
+	source.height = height;
+	nodes_.push_back(source);
+}
+
+FilterHandle
+FilterGraph::AddNode(FilterKind kind, vector<FilterHandle> inputs, const float4& params, unsigned int width, unsigned int height) {
+	for (auto in : inputs) {
+		assert(in < nodes_.size());
+	}
+	assert(width > 0 && height > 0);
+	FilterNode node;
+	node.kind = kind;
+	node.inputs = move(inputs);
+	node.params = params;
+	node.width = width;
+	node.height = height;
+	nodes_.push_back(node);
+	return static_cast<FilterHandle>(nodes_.size() - 1);
+}
+
+FilterHandle
+FilterGraph::AddNode(FilterKind kind, FilterHandle in, const float4& params) {
+	assert(in < nodes_.size());
+	return AddNode(kind, { in }, params, nodes_[in].width, nodes_[in].height);
+}
+
+FilterHandle
+FilterGraph::Mono(FilterHandle in) {
+	return AddNode(FilterKind::Mono, in, float4(0.0f));
+}
+
+FilterHandle
+FilterGraph::Grayscale(FilterHandle in) {
+	return AddNode(FilterKind::Grayscale, in, float4(0.0f));
+}
+
+FilterHandle
+FilterGraph::Gamma(FilterHandle in, float gamma) {
+	assert(gamma > 0.0f);
+	return AddNode(FilterKind::Gamma, in, float4(gamma, 0.0f, 0.0f, 0.0f));
+}
+
+FilterHandle
+FilterGraph::Contrast(FilterHandle in, float amount) {
+	return AddNode(FilterKind::Contrast, in, float4(amount, 0.0f, 0.0f, 0.0f));
+}
+
+FilterHandle
+FilterGraph::Tint(FilterHandle in, const float3& tint) {
+	return AddNode(FilterKind::Tint, in, float4(tint, 1.0f));
+}
+
+FilterHandle
+FilterGraph::Add(FilterHandle in, FilterHandle other, float weight) {
+	assert(in < nodes_.size() && other < nodes_.size());
+	//点ごとの処理なので同じ大きさでなければならない
+	assert(nodes_[in].width == nodes_[other].width && nodes_[in].height == nodes_[other].height);
+	return AddNode(FilterKind::Add, { in, other }, float4(weight, weight, weight, 0.0f), nodes_[in].width, nodes_[in].height);
+}
+
+FilterHandle
+FilterGraph::GaussianBlur(FilterHandle in, unsigned int radius, float sigma) {
+	assert(sigma > 0.0f);
+	return AddNode(FilterKind::GaussianBlur, in, float4(static_cast<float>(radius), sigma, 0.0f, 0.0f));
+}
+
+FilterHandle
+FilterGraph::BoxMean(FilterHandle in, unsigned int radius) {
+	return AddNode(FilterKind::BoxMean, in, float4(static_cast<float>(radius), 0.0f, 0.0f, 0.0f));
+}
+
+FilterHandle
+FilterGraph::Median(FilterHandle in, unsigned int radius) {
+	return AddNode(FilterKind::Median, in, float4(static_cast<float>(radius), 0.0f, 0.0f, 0.0f));
+}
+
+FilterHandle
+FilterGraph::Resample(FilterHandle in, unsigned int width, unsigned int height, ResampleFilter filter) {
+	return AddNode(FilterKind::Resample, { in }, float4(static_cast<float>(filter), 0.0f, 0.0f, 0.0f), width, height);
+}
+
+FilterHandle
+FilterGraph::Bloom(FilterHandle in, const BloomSettings& settings) {
+	assert(settings.levels >= 1 && settings.levels <= maxBloomLevels);
+	return AddNode(FilterKind::Bloom, in, float4(settings.threshold, settings.knee, settings.intensity, static_cast<float>(settings.levels)));
+}
+
+FilterHandle
+FilterGraph::ToneMap(FilterHandle in, const ToneMapSettings& settings) {
+	assert(settings.maxLog2 > settings.minLog2);
+	assert(settings.lowPercent >= 0.0f && settings.lowPercent <= settings.highPercent && settings.highPercent <= 1.0f);
+	assert(settings.adaptUp > 0.0f && settings.adaptUp <= 1.0f && settings.adaptDown > 0.0f && settings.adaptDown <= 1.0f);
+	auto out = AddNode(FilterKind::ToneMap, in, float4(settings.minLog2, settings.maxLog2, settings.lowPercent, settings.highPercent));
+	nodes_[out].params2 = float4(settings.exposureBias, settings.adaptUp, settings.adaptDown, settings.whitePoint);
+	return out;
+}
+
+FilterHandle
+FilterGraph::Outline(FilterHandle in, const OutlineSettings& settings) {
+	assert(in < nodes_.size() && nodes_[in].width == nodes_[filterSource].width && nodes_[in].height == nodes_[filterSource].height);
+	assert(settings.colorThreshold > 0.0f && settings.depthThreshold > 0.0f && settings.normalThreshold > 0.0f);
+	auto out = AddNode(FilterKind::Outline, in, float4(settings.colorThreshold, settings.depthThreshold, settings.normalThreshold, 0.0f));
+	nodes_[out].params2 = settings.color;
+	return out;
+}
+
+FilterHandle
+FilterGraph::JointUpsample(FilterHandle low, FilterHandle lowGuide, FilterHandle guide, const JointUpsampleSettings& settings) {
+	assert(low < nodes_.size() && lowGuide < nodes_.size() && guide < nodes_.size());
+	assert(nodes_[low].width == nodes_[lowGuide].width && nodes_[low].height == nodes_[lowGuide].height);
+	assert(settings.radius >= 1 && settings.radius <= maxJointUpsampleRadius && settings.lumaSigma > 0.0f && settings.depthSigma >= 0.0f);
+	assert(settings.depthSigma == 0.0f || (nodes_[guide].width == nodes_[filterSource].width && nodes_[guide].height == nodes_[filterSource].height));
+	return AddNode(FilterKind::JointUpsample, { low, lowGuide, guide }, float4(settings.lumaSigma, settings.depthSigma, static_cast<float>(settings.radius), 0.0f),
+		nodes_[guide].width, nodes_[guide].height);
+}
+
+FilterHandle
+FilterGraph::Reduced(FilterHandle in, unsigned int scale, const function<FilterHandle(FilterGraph&, FilterHandle)>& body, const JointUpsampleSettings& settings) {
+	assert(in < nodes_.size() && scale >= 1);
+	if (scale == 1) {
+		return body(*this, in);
+	}
+	const auto& node = nodes_[in];
+	auto low = Resample(in, (node.width + scale - 1) / scale, (node.height + scale - 1) / scale, ResampleFilter::Bilinear);
+	auto processed = body(*this, low);
+	return JointUpsample(processed, low, in, settings);
+}
+
+void
+FilterGraph::SetOutput(FilterHandle out) {
+	assert(out < nodes_.size());
+	output_ = out;
+	hasOutput_ = true;
+}
+
+FilterHandle
+FilterGraph::Output()const {
+	return hasOutput_ ? output_ : static_cast<FilterHandle>(nodes_.size() - 1);
+}
+
+bool
+FilterGraph::Reach(unsigned int& radius)const {
+	//ノードは入力より後に並んでいるので、前から順に入力の半径の最大に自分の半径を足していく
+	vector<unsigned int> reach(nodes_.size(), 0);
+	vector<bool> local(nodes_.size(), true);
+	for (size_t i = 1; i < nodes_.size(); ++i) {
+		const auto& node = nodes_[i];
+		for (auto in : node.inputs) {
+			reach[i] = max(reach[i], reach[in]);
+			local[i] = local[i] && local[in];
+		}
+		switch (node.kind) {
+		case FilterKind::GaussianBlur:
+		case FilterKind::BoxMean:
+		case FilterKind::Median:
+			reach[i] += static_cast<unsigned int>(node.params.x);
+			break;
+		case FilterKind::Outline:
+			reach[i] += 1;//3x3
+			break;
+		case FilterKind::Resample:
+		case FilterKind::Bloom:
+		case FilterKind::ToneMap:
+		case FilterKind::JointUpsample:
+			local[i] = false;
+			break;
+		default:
+			assert(IsPointwise(node.kind));
+			break;
+		}
+	}
+	radius = reach[Output()];
+	return local[Output()];
+}
+
+FilterGraph
+FilterGraph::Resized(unsigned int width, unsigned int height)const {
+	assert(width > 0 && height > 0);
+	FilterGraph graph(*this);
+	for (auto& node : graph.nodes_) {
+		assert(node.width == nodes_[filterSource].width && node.height == nodes_[filterSource].height);
+		node.width = width;
+		node.height = height;
+	}
+	return graph;
+}
+
+FilterPlan
+FilterGraph::Compile(const FilterCompileOptions& options)const {
+	const FilterHandle output = Output();
+	const size_t count = nodes_.size();
+	FilterPlan plan;
+	plan.width = nodes_[output].width;
+	plan.height = nodes_[output].height;
+
+	//出力から逆にたどって、実行するノードと、それぞれを読むノードの数を数える(グラフの出力も1つと数える)
+	vector<bool> live(count, false);
+	vector<unsigned int> uses(count, 0);
+	live[output] = true;
+	uses[output] = 1;
+	for (size_t i = count; i-- > 1;) {
+		if (!live[i]) {
+			continue;
+		}
+		++plan.liveNodes;
+		for (auto in : nodes_[i].inputs) {
+			live[in] = true;
+			++uses[in];
+		}
+	}
+
+	//点ごとのノードを、1つ前の点ごとのノード(inputs[0])を読むのが自分だけならそのパスにまとめる
+	//まとめたノードの出力はターゲットに置かないので、まとめられるのはほかから読まれないものだけ。
+	//追加の入力はパスより前にできているので、パスはまとめた最後のノードの位置で実行すればよい
+	vector<int> passOf(count, -1);
+	vector<FilterPass> passes;
+	vector<FilterHandle> passLast;
+	for (FilterHandle i = 1; i < count; ++i) {
+		if (!live[i]) {
+			continue;
+		}
+		const auto& node = nodes_[i];
+		const FilterHandle in = node.inputs[0];
+		int target = -1;
+		if (options.fusePointwise && IsPointwise(node.kind) && in != filterSource && IsPointwise(nodes_[in].kind) && uses[in] == 1) {
+			auto& pass = passes[passOf[in]];
+			unsigned int extraCount = static_cast<unsigned int>(pass.inputs.size()) - 1;
+			if (node.kind == FilterKind::Add && find(pass.inputs.begin() + 1, pass.inputs.end(), static_cast<int>(node.inputs[1])) == pass.inputs.end()) {
+				++extraCount;
+			}
+			if (pass.nodes.size() < filterMaxFusedOps && extraCount <= filterMaxExtraInputs) {
+				target = passOf[in];
+			}
+		}
+		if (target < 0) {
+			FilterPass pass;
+			pass.inputs.push_back(static_cast<int>(in));
+			if (!IsPointwise(node.kind)) {
+				for (size_t k = 1; k < node.inputs.size(); ++k) {
+					pass.inputs.push_back(static_cast<int>(node.inputs[k]));
+				}
+			}
+			pass.width = node.width;
+			pass.height = node.height;
+			target = static_cast<int>(passes.size());
+			passes.push_back(pass);
+			passLast.push_back(i);
+		}
+		auto& pass = passes[target];
+		pass.nodes.push_back(i);
+		unsigned int extra = 0;
+		if (IsPointwise(node.kind) && node.kind == FilterKind::Add) {
+			auto it = find(pass.inputs.begin() + 1, pass.inputs.end(), static_cast<int>(node.inputs[1]));
+			extra = static_cast<unsigned int>(it - pass.inputs.begin()) - 1;
+			if (it == pass.inputs.end()) {
+				pass.inputs.push_back(static_cast<int>(node.inputs[1]));
+			}
+		}
+		pass.extraIndex.push_back(extra);
+		passOf[i] = target;
+		passLast[target] = i;
+	}
+
+	//まとめた最後のノードの順に並べる(ここまでinputsはノードの番号)
+	vector<size_t> order(passes.size());
+	for (size_t p = 0; p < order.size(); ++p) {
+		order[p] = p;
+	}
+	sort(order.begin(), order.end(), [&](size_t a, size_t b) {return passLast[a] < passLast[b]; });
+	for (auto p : order) {
+		plan.passes.push_back(passes[p]);
+	}
+
+	//ノードの出力が最後に読まれるパス
+	vector<int> lastRead(count, -1);
+	for (size_t p = 0; p < plan.passes.size(); ++p) {
+		for (auto in : plan.passes[p].inputs) {
+			lastRead[in] = static_cast<int>(p);
+		}
+	}
+	//パスの出力にターゲットを割り当て、最後に読まれたターゲットは空きに戻す
+	vector<int> targetOf(count, filterSourceTarget);
+	vector<bool> freeTarget;
+	for (size_t p = 0; p < plan.passes.size(); ++p) {
+		auto& pass = plan.passes[p];
+		const FilterHandle last = pass.nodes.back();
+		if (last == output) {
+			pass.output = filterOutputTarget;
+		}
+		else {
+			++plan.unpooledTargets;
+			int found = -1;
+			for (size_t t = 0; options.poolTargets && t < plan.targets.size(); ++t) {
+				if (freeTarget[t] && plan.targets[t].width == pass.width && plan.targets[t].height == pass.height) {
+					found = static_cast<int>(t);
+					break;
+				}
+			}
+			if (found < 0) {
+				found = static_cast<int>(plan.targets.size());
+				plan.targets.push_back({ pass.width, pass.height });
+				freeTarget.push_back(false);
+			}
+			freeTarget[found] = false;
+			pass.output = found;
+		}
+		targetOf[last] = pass.output;
+		for (auto& in : pass.inputs) {
+			const auto node = static_cast<FilterHandle>(in);
+			in = targetOf[node];
+			if (lastRead[node] == static_cast<int>(p) && in >= 0) {
+				freeTarget[in] = true;
+			}
+		}
+	}
+	return plan;
+}
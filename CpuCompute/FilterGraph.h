@@ -0,0 +1,202 @@
+﻿#pragma once
+#include<vector>
+#include<cstdint>
+#include<functional>
+#include"HlslTypes.h"
+#include"Resample.h"
+#include"Bloom.h"
+#include"ToneMap.h"
+#include"Outline.h"
+#include"JointUpsample.h"
+
+//ポストエフェクトの連鎖(フィルタグラフ)
+//エフェクトを、入力(前のノードの出力)と出力の画像を持つノードとして並べておき、Compileで実行の計画(パスとターゲット)にする
+//  ・点ごとの処理(FilterKind::Mono～Add)が続くところは1パスにまとめる(画像の読み書きはまとめた分で1回)
+//  ・パスの出力を置く中間のターゲットは、最後に読まれた後で同じ大きさの別の出力に使い回す
+//  ・出力に使われないノードは実行しない
+//計画はCPU(CpuFilterGraphRunner)でもD3D12(RenderTargetFilter/D3D12FilterGraphRunner)でも同じものを実行する
+//このファイルと.cppはD3D12側からも使うので、CPUの実装(ComputeExecutorなど)には依存しない
+
+///ノードの種類(点ごとのものはPostEffect.hlsliのPOSTFX_～と同じ値)
+enum class FilterKind : unsigned int {
+	//ここから点ごと
+	Mono = 0,//MonoPixel(MonoCSと同じ)
+	Grayscale = 1,
+	Gamma = 2,//params.x : ガンマ
+	Contrast = 3,//params.x : 0.5を中心に何倍にするか
+	Tint = 4,//params.rgb : 成分ごとに掛ける
+	Add = 5,//inputs[1]をparams.rgb倍して足す(inputs[0]と同じ大きさ)
+	//ここから近傍を読むもの
+	GaussianBlur = 16,//params.x : 半径(～maxGaussianRadius)、params.y : 標準偏差
+	BoxMean = 17,//params.x : 半径
+	Median = 18,//params.x : 半径(～maxMedianRadius)。値は8bitに丸めて選ぶ
+	Resample = 19,//ノードの大きさに拡大縮小する。params.x : ResampleFilter(アルファは乗算済みとして扱う)
+	Bloom = 20,//params : BloomSettingsのthreshold, knee, intensity, levels
+	ToneMap = 21,//自動露出とトーンマップ(フレームをまたいで露出をなじませる)。params, params2 : ToneMapSettings
+	Outline = 22,//輪郭線(ランナーに渡したジオメトリ画像も読む)。params.xyz : OutlineSettingsの閾値、params2 : 線の色
+	JointUpsample = 23,//inputs[0](縮小して処理したもの)を、inputs[1](その処理の前)とinputs[2](元の大きさ)を手がかりに拡大する。params.xyz : JointUpsampleSettings
+};
+
+///点ごとの処理か
+inline bool IsPointwise(FilterKind kind) {
+	return static_cast<unsigned int>(kind) < static_cast<unsigned int>(FilterKind::GaussianBlur);
+}
+
+///1パスにまとめる点ごとの処理の数と追加の入力の数の上限(PostEffect.hlsliのPOSTFX_MAX_～と同じ値)
+constexpr unsigned int filterMaxFusedOps = 8;
+constexpr unsigned int filterMaxExtraInputs = 2;
+
+///グラフの中の画像(ノードの番号)。0はグラフの入力画像
+using FilterHandle = unsigned int;
+constexpr FilterHandle filterSource = 0;
+
+///ノード(0番はグラフの入力画像で、kindとparamsは使わない)
+struct FilterNode {
+	FilterKind kind = FilterKind::Mono;
+	std::vector<FilterHandle> inputs;//自分より前のノード
+	hlsl::float4 params = hlsl::float4(0.0f);
+	hlsl::float4 params2 = hlsl::float4(0.0f);//paramsに収まらない設定(ToneMapとOutlineのみ)
+	unsigned int width = 0;//出力の大きさ
+	unsigned int height = 0;
+};
+
+///FilterKind::Bloomのノードの設定
+inline BloomSettings BloomSettingsOf(const FilterNode& node) {
+	BloomSettings settings;
+	settings.threshold = node.params.x;
+	settings.knee = node.params.y;
+	settings.intensity = node.params.z;
+	settings.levels = static_cast<unsigned int>(node.params.w);
+	return settings;
+}
+
+///FilterKind::ToneMapのノードの設定
+inline ToneMapSettings ToneMapSettingsOf(const FilterNode& node) {
+	ToneMapSettings settings;
+	settings.minLog2 = node.params.x;
+	settings.maxLog2 = node.params.y;
+	settings.lowPercent = node.params.z;
+	settings.highPercent = node.params.w;
+	settings.exposureBias = node.params2.x;
+	settings.adaptUp = node.params2.y;
+	settings.adaptDown = node.params2.z;
+	settings.whitePoint = node.params2.w;
+	return settings;
+}
+
+///FilterKind::Outlineのノードの設定
+inline OutlineSettings OutlineSettingsOf(const FilterNode& node) {
+	OutlineSettings settings;
+	settings.colorThreshold = node.params.x;
+	settings.depthThreshold = node.params.y;
+	settings.normalThreshold = node.params.z;
+	settings.color = node.params2;
+	return settings;
+}
+
+///FilterKind::JointUpsampleのノードの設定
+inline JointUpsampleSettings JointUpsampleSettingsOf(const FilterNode& node) {
+	JointUpsampleSettings settings;
+	settings.lumaSigma = node.params.x;
+	settings.depthSigma = node.params.y;
+	settings.radius = static_cast<unsigned int>(node.params.z);
+	return settings;
+}
+
+///計画の中のターゲットの番号(0以上は中間のターゲット)
+constexpr int filterSourceTarget = -1;//グラフの入力画像
+constexpr int filterOutputTarget = -2;//グラフの出力画像
+
+///パス(1つの近傍を読むノードか、1つ以上の点ごとのノードを続けて処理する)
+struct FilterPass {
+	std::vector<FilterHandle> nodes;//処理するノード(前から順に)
+	std::vector<int> inputs;//読むターゲット。[0]が処理する画像、点ごとのパスの[1]以降は追加の入力(近傍を読むパスはノードのinputs[1]以降)
+	std::vector<unsigned int> extraIndex;//点ごとのパスで、nodes[i]が読む追加の入力(inputs[1+extraIndex[i]]。Add以外は0)
+	int output = filterOutputTarget;
+	unsigned int width = 0;
+	unsigned int height = 0;
+};
+
+///中間のターゲット
+struct FilterTarget {
+	unsigned int width = 0;
+	unsigned int height = 0;
+};
+
+///実行の計画
+struct FilterPlan {
+	std::vector<FilterPass> passes;//この順に実行する
+	std::vector<FilterTarget> targets;
+	unsigned int width = 0;//出力の大きさ
+	unsigned int height = 0;
+	unsigned int liveNodes = 0;//実行するノードの数(入力画像を除く)
+	unsigned int unpooledTargets = 0;//使い回さなければ要った中間のターゲットの数
+	///出力が入力画像そのもの(パスがない)か
+	bool IsCopy()const { return passes.empty(); }
+};
+
+///Compileのオプション(比較用)
+struct FilterCompileOptions {
+	bool fusePointwise = true;//点ごとの処理を1パスにまとめる
+	bool poolTargets = true;//中間のターゲットを使い回す
+};
+
+///フィルタグラフ
+///ノードを足す関数は新しいノード(の出力)を返す。引数の画像はそれより前に足したものであること
+class FilterGraph {
+public:
+	///@param width,height 入力画像の大きさ
+	FilterGraph(unsigned int width, unsigned int height);
+
+	FilterHandle Source()const { return filterSource; }
+	FilterHandle Mono(FilterHandle in);
+	FilterHandle Grayscale(FilterHandle in);
+	FilterHandle Gamma(FilterHandle in, float gamma);
+	FilterHandle Contrast(FilterHandle in, float amount);
+	FilterHandle Tint(FilterHandle in, const hlsl::float3& tint);
+	///in + other * weight(otherはinと同じ大きさ)
+	FilterHandle Add(FilterHandle in, FilterHandle other, float weight);
+	FilterHandle GaussianBlur(FilterHandle in, unsigned int radius, float sigma);
+	FilterHandle BoxMean(FilterHandle in, unsigned int radius);
+	FilterHandle Median(FilterHandle in, unsigned int radius);
+	FilterHandle Resample(FilterHandle in, unsigned int width, unsigned int height, ResampleFilter filter);
+	FilterHandle Bloom(FilterHandle in, const BloomSettings& settings);
+	///HDRの入力に自動露出とトーンマップをかける(出力はsRGBの0～1。グラフの最後に置く)
+	FilterHandle ToneMap(FilterHandle in, const ToneMapSettings& settings);
+	///モデルの輪郭線を描く(inはグラフの入力と同じ大きさ。ジオメトリ画像はランナーのSetGeometryで渡す)
+	FilterHandle Outline(FilterHandle in, const OutlineSettings& settings);
+	///縮小して処理したlowを、guide(元の大きさ)とlowGuide(lowを処理する前)を手がかりにguideの大きさに戻す
+	///(depthSigmaが0でなければ、ジオメトリ画像をランナーのSetGeometryで渡す)
+	FilterHandle JointUpsample(FilterHandle low, FilterHandle lowGuide, FilterHandle guide, const JointUpsampleSettings& settings);
+	///inを1/scaleに縮小(双線形)してbodyを通し、JointUpsampleで元の大きさに戻す(重いフィルタを小さい画像でかける)
+	///@param scale 1ならbodyをそのまま(元の大きさで)通す。2なら1/2、4なら1/4(端数は切り上げ)
+	///@param body 縮小した画像を受け取り、同じ大きさの処理結果を返す(半径などは1/scaleにしておくこと)
+	///@param settings 拡大の設定(scaleが1なら使わない)
+	FilterHandle Reduced(FilterHandle in, unsigned int scale, const std::function<FilterHandle(FilterGraph&, FilterHandle)>& body, const JointUpsampleSettings& settings);
+
+	///グラフの出力にする画像(既定は最後に足したノード)
+	void SetOutput(FilterHandle out);
+	FilterHandle Output()const;
+
+	///出力の画素が、入力の画素からどれだけ離れたところまで読むか(近傍を読むノードの半径を、入力から出力への道ごとに足した最大)
+	///切り出した矩形でグラフを実行しても、矩形の端からこれだけ内側は画像全体で実行したときと同じになる
+	///@param radius 読む範囲の半径(画素)
+	///@return 画像全体を読むノード(Bloom・ToneMap)か大きさを変えるノード(Resample・JointUpsample)があればfalse
+	bool Reach(unsigned int& radius)const;
+	///同じノードで、入力の大きさだけを変えたグラフ(Reachがtrueのグラフのみ。どのノードも入力と同じ大きさなので)
+	FilterGraph Resized(unsigned int width, unsigned int height)const;
+
+	const std::vector<FilterNode>& Nodes()const { return nodes_; }
+	const FilterNode& Node(FilterHandle handle)const { return nodes_[handle]; }
+
+	///実行の計画を立てる
+	FilterPlan Compile(const FilterCompileOptions& options = FilterCompileOptions())const;
+
+private:
+	std::vector<FilterNode> nodes_;
+	FilterHandle output_ = filterSource;
+	bool hasOutput_ = false;
+
+	FilterHandle AddNode(FilterKind kind, std::vector<FilterHandle> inputs, const hlsl::float4& params, unsigned int width, unsigned int height);
+	FilterHandle AddNode(FilterKind kind, FilterHandle in, const hlsl::float4& params);
+};
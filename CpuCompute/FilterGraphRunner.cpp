@@ -0,0 +1,277 @@
+﻿#include "FilterGraphRunner.h"
+#include<algorithm>
+#include<cassert>
+#include"ComputeExecutor.h"
+#include"GaussianBlur.h"
+#include"BoxFilter.h"
+#include"MedianFilter.h"
+#include"Bloom.h"
+#include"ToneMap.h"
+#include"Outline.h"
+#include"JointUpsample.h"
+
+//シェーダと同じ点ごとの処理
+namespace hlsl {
+	namespace {
+#include"MonoPixel.hlsli"
+#include"ColorOps.hlsli"
+#include"PostEffect.hlsli"
+	}
+}
+
+using namespace std;
+using hlsl::float4;
+
+namespace {
+	//点ごとのパスで一度に処理する画素数(入力と追加の入力でL1に収まる)
+	constexpr unsigned int chunkPixels = 256;
+	//並列化するときの帯の最小の行数
+	constexpr unsigned int minBandRows = 16;
+
+	static_assert(sizeof(float4) == sizeof(float) * 4, "float4 must be packed");
+
+	template<typename Pixel>
+	void Resize(Image<Pixel>& img, unsigned int width, unsigned int height) {
+		img.width = width;
+		img.height = height;
+		img.pixels.resize(static_cast<size_t>(width) * height);
+	}
+
+	void UnpackImage(const ImageRGBA8& src, ImageRGBA32F& dst) {
+		Resize(dst, src.width, src.height);
+		UnpackUnorm4x8Row(src.pixels.data(), reinterpret_cast<float*>(dst.pixels.data()), src.pixels.size());
+	}
+
+	void PackImage(const ImageRGBA32F& src, ImageRGBA8& dst) {
+		Resize(dst, src.width, src.height);
+		PackUnorm4x8Row(reinterpret_cast<const float*>(src.pixels.data()), dst.pixels.data(), src.pixels.size());
+	}
+}
+
+CpuFilterGraphRunner::CpuFilterGraphRunner(const FilterGraph& graph, const FilterCompileOptions& options) :
+	graph_(graph), plan_(graph.Compile(options)) {
+	targets_.resize(plan_.targets.size());
+	for (size_t t = 0; t < targets_.size(); ++t) {
+		Resize(targets_[t], plan_.targets[t].width, plan_.targets[t].height);
+	}
+	for (auto& pass : plan_.passes) {
+		const auto& node = graph_.Node(pass.nodes[0]);
+		if (node.kind == FilterKind::Bloom) {
+			blooms_[pass.nodes[0]].reset(new BloomFilter(node.width, node.height, BloomSettingsOf(node).levels));
+		}
+	}
+}
+
+size_t
+CpuFilterGraphRunner::TargetBytes()const {
+	size_t bytes = 0;
+	for (auto& t : targets_) {
+		bytes += t.pixels.size() * sizeof(float4);
+	}
+	for (auto& b : blooms_) {
+		bytes += b.second->LevelBytes();
+	}
+	return bytes;
+}
+
+void
+CpuFilterGraphRunner::Run(const ImageRGBA32F& src, ImageRGBA32F& dst, ComputeExecutor* executor) {
+	Surface in;
+	in.imageF = &src;
+	WritableSurface out;
+	out.imageF = &dst;
+	Run(in, out, executor);
+}
+
+void
+CpuFilterGraphRunner::Run(const ImageRGBA8& src, ImageRGBA8& dst, ComputeExecutor* executor) {
+	Surface in;
+	in.image8 = &src;
+	WritableSurface out;
+	out.image8 = &dst;
+	Run(in, out, executor);
+}
+
+void
+CpuFilterGraphRunner::Run(Surface src, WritableSurface dst, ComputeExecutor* executor) {
+	const auto& sourceNode = graph_.Node(filterSource);
+	const unsigned int srcWidth = src.imageF ? src.imageF->width : src.image8->width;
+	const unsigned int srcHeight = src.imageF ? src.imageF->height : src.image8->height;
+	assert(srcWidth == sourceNode.width && srcHeight == sourceNode.height);
+	if (dst.imageF) {
+		Resize(*dst.imageF, plan_.width, plan_.height);
+	}
+	else {
+		Resize(*dst.image8, plan_.width, plan_.height);
+	}
+	if (plan_.IsCopy()) {
+		if (dst.imageF) {
+			if (src.imageF) {
+				dst.imageF->pixels = src.imageF->pixels;
+			}
+			else {
+				UnpackImage(*src.image8, *dst.imageF);
+			}
+		}
+		else {
+			if (src.image8) {
+				dst.image8->pixels = src.image8->pixels;
+			}
+			else {
+				PackImage(*src.imageF, *dst.image8);
+			}
+		}
+		return;
+	}
+
+	//近傍を読むパスはfloatの画像を読み書きする
+	bool sourceUnpacked = false;
+	auto surfaceOf = [&](int target) {
+		Surface s;
+		if (target >= 0) {
+			s.imageF = &targets_[target];
+		}
+		else {
+			s = src;
+		}
+		return s;
+	};
+	for (auto& pass : plan_.passes) {
+		if (IsPointwise(graph_.Node(pass.nodes[0]).kind)) {
+			vector<Surface> inputs;
+			for (auto in : pass.inputs) {
+				inputs.push_back(surfaceOf(in));
+			}
+			WritableSurface out;
+			if (pass.output >= 0) {
+				out.imageF = &targets_[pass.output];
+			}
+			else {
+				out = dst;
+			}
+			RunPointwise(pass, inputs, out, executor);
+			continue;
+		}
+		vector<const ImageRGBA32F*> inputs;
+		for (auto in : pass.inputs) {
+			if (in >= 0) {
+				inputs.push_back(&targets_[in]);
+			}
+			else if (src.imageF) {
+				inputs.push_back(src.imageF);
+			}
+			else {
+				if (!sourceUnpacked) {
+					UnpackImage(*src.image8, source_);
+					sourceUnpacked = true;
+				}
+				inputs.push_back(&source_);
+			}
+		}
+		if (pass.output >= 0) {
+			RunSpatial(pass, inputs, targets_[pass.output], executor);
+		}
+		else if (dst.imageF) {
+			RunSpatial(pass, inputs, *dst.imageF, executor);
+		}
+		else {
+			RunSpatial(pass, inputs, output_, executor);
+			PackImage(output_, *dst.image8);
+		}
+	}
+}
+
+void
+CpuFilterGraphRunner::RunPointwise(const FilterPass& pass, const vector<Surface>& inputs, WritableSurface out, ComputeExecutor* executor) {
+	assert(inputs.size() <= 1 + filterMaxExtraInputs);
+	auto loadRow = [](const Surface& s, unsigned int y, unsigned int x, unsigned int count, float4* row) {
+		if (s.imageF) {
+			copy_n(s.imageF->Row(y) + x, count, row);
+		}
+		else {
+			UnpackUnorm4x8Row(s.image8->Row(y) + x, reinterpret_cast<float*>(row), count);
+		}
+	};
+	auto runRows = [&](unsigned int y0, unsigned int y1) {
+		float4 buffers[1 + filterMaxExtraInputs][chunkPixels];
+		for (auto y = y0; y < y1; ++y) {
+			for (unsigned int x = 0; x < pass.width; x += chunkPixels) {
+				const unsigned int count = min(chunkPixels, pass.width - x);
+				for (size_t i = 0; i < inputs.size(); ++i) {
+					loadRow(inputs[i], y, x, count, buffers[i]);
+				}
+				//ノードごとに塊の全画素をかける(分岐は塊に1回)
+				float4* c = buffers[0];
+				for (size_t k = 0; k < pass.nodes.size(); ++k) {
+					const auto& node = graph_.Node(pass.nodes[k]);
+					const auto op = static_cast<hlsl::uint>(node.kind);
+					const float4* extra = node.kind == FilterKind::Add ? buffers[1 + pass.extraIndex[k]] : buffers[0];
+					for (unsigned int i = 0; i < count; ++i) {
+						c[i] = hlsl::PointwiseOp(op, node.params, c[i], extra[i]);
+					}
+				}
+				if (out.imageF) {
+					copy_n(c, count, out.imageF->Row(y) + x);
+				}
+				else {
+					PackUnorm4x8Row(reinterpret_cast<const float*>(c), out.image8->Row(y) + x, count);
+				}
+			}
+		}
+	};
+	unsigned int bandNum = 1;
+	if (executor != nullptr && executor->ThreadCount() > 1) {
+		bandNum = max(1u, min(pass.height / minBandRows, executor->ThreadCount() * 2));
+	}
+	if (bandNum > 1) {
+		executor->ParallelFor(bandNum, 1, [&](size_t begin, size_t end) {
+			runRows(static_cast<unsigned int>(static_cast<uint64_t>(pass.height) * begin / bandNum),
+				static_cast<unsigned int>(static_cast<uint64_t>(pass.height) * end / bandNum));
+		});
+	}
+	else {
+		runRows(0, pass.height);
+	}
+}
+
+void
+CpuFilterGraphRunner::RunSpatial(const FilterPass& pass, const vector<const ImageRGBA32F*>& inputs, ImageRGBA32F& out, ComputeExecutor* executor) {
+	assert(pass.nodes.size() == 1);
+	const auto& node = graph_.Node(pass.nodes[0]);
+	const auto& in = *inputs[0];
+	const auto radius = static_cast<unsigned int>(node.params.x);
+	switch (node.kind) {
+	case FilterKind::GaussianBlur:
+		GaussianBlur(in, out, radius, node.params.y, executor);
+		break;
+	case FilterKind::BoxMean:
+		BoxFilter(in, out, radius, executor);
+		break;
+	case FilterKind::Median:
+		//MedianCS.hlslのRankHistogramCSと同じく8bitに丸めて選ぶ
+		PackImage(in, median8_[0]);
+		MedianFilter(median8_[0], median8_[1], radius, executor);
+		UnpackImage(median8_[1], out);
+		break;
+	case FilterKind::Resample:
+		::Resample(in, out, node.width, node.height, static_cast<ResampleFilter>(static_cast<unsigned int>(node.params.x)), AlphaMode::Premultiplied, executor);
+		break;
+	case FilterKind::Bloom:
+		blooms_[pass.nodes[0]]->Apply(in, out, BloomSettingsOf(node), executor);
+		break;
+	case FilterKind::ToneMap:
+		exposures_[pass.nodes[0]].Apply(in, out, ToneMapSettingsOf(node), executor);
+		break;
+	case FilterKind::Outline:
+		assert(geometry_ != nullptr && geometry_->width == in.width && geometry_->height == in.height);
+		Outline(in, *geometry_, out, OutlineSettingsOf(node), executor);
+		break;
+	case FilterKind::JointUpsample:
+		assert(inputs.size() == 3);
+		JointUpsample(in, *inputs[1], *inputs[2], geometry_, out, JointUpsampleSettingsOf(node), executor);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
@@ -0,0 +1,60 @@
+﻿#pragma once
+#include<vector>
+#include<map>
+#include<memory>
+#include"FilterGraph.h"
+#include"Image.h"
+
+class ComputeExecutor;
+
+///フィルタグラフをCPUで実行する(RenderTargetFilter/D3D12FilterGraphRunnerのCPU版。テストとベンチマーク用)
+///構築するときに計画を立て、中間のターゲットを作っておく。ターゲットはRunのたびに使い回す
+///  点ごとのパス : 行を256画素ずつL1に読み、まとめたノードを順にかけてから書く(計算はPostEffect.hlsliをシェーダと共有)。
+///                 R8G8B8A8の入出力は読み書きのときに変換するので、変換のためだけに画像を通すことはない
+///  近傍を読むパス : GaussianBlur/BoxFilter/MedianFilter/Resample/BloomFilter/AutoExposure/Outline/JointUpsampleのfloat版(Medianは8bitにしてから選ぶ)
+///中間はfloat
+class CpuFilterGraphRunner {
+public:
+	///@param graph 実行するグラフ(コピーして持つ)
+	///@param options 計画のオプション(比較用)
+	explicit CpuFilterGraphRunner(const FilterGraph& graph, const FilterCompileOptions& options = FilterCompileOptions());
+
+	const FilterPlan& Plan()const { return plan_; }
+	///中間のターゲット(とBloomの段の画像)の合計のバイト数
+	size_t TargetBytes()const;
+
+	///OutlineとJointUpsample(深度を使うもの)のノードが読むジオメトリ画像を渡す(グラフの入力と同じ大きさ。Runの間は持っておくこと)
+	void SetGeometry(const ImageRGBA32F* geometry) { geometry_ = geometry; }
+
+	///グラフを実行する
+	///@param src 入力画像(グラフの入力と同じ大きさ)
+	///@param dst 出力画像(グラフの出力の大きさにされる。srcと同じではいけない)
+	///@param executor nullptrなら呼び出しスレッドだけで処理する
+	void Run(const ImageRGBA32F& src, ImageRGBA32F& dst, ComputeExecutor* executor);
+	void Run(const ImageRGBA8& src, ImageRGBA8& dst, ComputeExecutor* executor);
+
+private:
+	//R8G8B8A8とfloatの画像のどちらか
+	struct Surface {
+		const ImageRGBA32F* imageF = nullptr;
+		const ImageRGBA8* image8 = nullptr;
+	};
+	struct WritableSurface {
+		ImageRGBA32F* imageF = nullptr;
+		ImageRGBA8* image8 = nullptr;
+	};
+
+	FilterGraph graph_;
+	FilterPlan plan_;
+	std::vector<ImageRGBA32F> targets_;
+	ImageRGBA32F source_;//R8G8B8A8の入力を近傍を読むパスが読むときにfloatにしたもの
+	ImageRGBA32F output_;//R8G8B8A8の出力に近傍を読むパスが書くときの置き場
+	ImageRGBA8 median8_[2];//Medianの入出力
+	std::map<FilterHandle, std::unique_ptr<BloomFilter>> blooms_;//Bloomのノードごとの段の画像(構築するときに確保する)
+	std::map<FilterHandle, AutoExposure> exposures_;//ToneMapのノードごとの露出(Runをまたいでなじませる)
+	const ImageRGBA32F* geometry_ = nullptr;//OutlineとJointUpsampleのジオメトリ画像
+
+	void Run(Surface src, WritableSurface dst, ComputeExecutor* executor);
+	void RunPointwise(const FilterPass& pass, const std::vector<Surface>& inputs, WritableSurface out, ComputeExecutor* executor);
+	void RunSpatial(const FilterPass& pass, const std::vector<const ImageRGBA32F*>& inputs, ImageRGBA32F& out, ComputeExecutor* executor);
+};
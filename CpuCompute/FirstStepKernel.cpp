@@ -0,0 +1,102 @@
+﻿#include "FirstStepKernel.h"
+#include<cassert>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace {
+	//dtid.zが並ぶ1行分(count個)のdsptThrdIdにfirst,first+1,…を書く
+	void FirstStepRowScalar(IDs* dst, unsigned int first, unsigned int count) {
+		for (unsigned int i = 0; i < count; ++i) {
+			dst[i].dsptThrdId = static_cast<float>(first + i);
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+	CPU_TARGET_SSE41 void FirstStepRowSSE41(IDs* dst, unsigned int first, unsigned int count) {
+		//1要素=16バイト=1ベクタなので3番目のレーンだけ差し替える
+		for (unsigned int i = 0; i < count; ++i) {
+			auto p = reinterpret_cast<float*>(dst + i);
+			auto v = _mm_set1_ps(static_cast<float>(first + i));
+			_mm_storeu_ps(p, _mm_blend_ps(_mm_loadu_ps(p), v, 0x4));
+		}
+	}
+
+	CPU_TARGET_AVX2 void FirstStepRowAVX2(IDs* dst, unsigned int first, unsigned int count) {
+		//2要素ずつ、dsptThrdIdのレーンだけマスクストアする
+		const auto mask = _mm256_setr_epi32(0, 0, -1, 0, 0, 0, -1, 0);
+		const auto offset = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+		unsigned int i = 0;
+		for (; i + 2 <= count; i += 2) {
+			auto v = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(first + i), offset));
+			_mm256_maskstore_ps(reinterpret_cast<float*>(dst + i), mask, v);
+		}
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		FirstStepRowScalar(dst + i, first + i, count - i);
+	}
+
+	CPU_TARGET_AVX512 void FirstStepRowAVX512(IDs* dst, unsigned int first, unsigned int count) {
+		//4要素ずつ
+		const auto offset = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+		unsigned int i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto v = _mm512_cvtepi32_ps(_mm512_add_epi32(_mm512_set1_epi32(first + i), offset));
+			_mm512_mask_storeu_ps(reinterpret_cast<float*>(dst + i), 0x4444, v);
+		}
+		_mm256_zeroupper();
+		FirstStepRowScalar(dst + i, first + i, count - i);
+	}
+#elif defined(CPU_ARCH_ARM64)
+	void FirstStepRowNEON(IDs* dst, unsigned int first, unsigned int count) {
+		//4要素をメンバごとに分けて読み、dsptThrdIdだけ差し替えて書き戻す
+		const uint32_t offsetInit[4] = { 0,1,2,3 };
+		const auto offset = vld1q_u32(offsetInit);
+		unsigned int i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto p = reinterpret_cast<float*>(dst + i);
+			auto v = vld4q_f32(p);
+			v.val[2] = vcvtq_f32_u32(vaddq_u32(vdupq_n_u32(first + i), offset));
+			vst4q_f32(p, v);
+		}
+		FirstStepRowScalar(dst + i, first + i, count - i);
+	}
+#endif
+
+	using FirstStepRowFunc = void(*)(IDs* dst, unsigned int first, unsigned int count);
+	Kernel<FirstStepRowFunc> firstStepRow("firststep", {
+		{ CpuIsa::Scalar, FirstStepRowScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, FirstStepRowSSE41 },
+		{ CpuIsa::AVX2, FirstStepRowAVX2 },
+		{ CpuIsa::AVX512, FirstStepRowAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, FirstStepRowNEON },
+#endif
+	});
+}
+
+void
+FirstStepIds(vector<IDs>& uav, unsigned int x, unsigned int y, unsigned int z, ComputeExecutor& executor) {
+	//[numthreads(4,4,4)]
+	const unsigned int width = x * 4;
+	const unsigned int height = y * 4;
+	const unsigned int depth = z * 4;
+	//シェーダの添字はdtid.x*8*8+dtid.y*8+dtid.z固定
+	assert(height <= 8 && depth <= 8);
+	assert(width == 0 || static_cast<size_t>(width - 1) * 64 + (height - 1) * 8 + depth <= uav.size());
+	auto row = firstStepRow.Get();
+	//(dtid.x,dtid.y)ごとにdtid.zの並びが連続しているので、その1行を実装に渡す
+	executor.ParallelFor(static_cast<size_t>(width) * height, 8, [&](size_t begin, size_t end) {
+		for (auto r = begin; r < end; ++r) {
+			auto first = static_cast<unsigned int>((r / height) * 64 + (r % height) * 8);
+			row(uav.data() + first, first, depth);
+		}
+	});
+}
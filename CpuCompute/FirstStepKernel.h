@@ -0,0 +1,32 @@
+﻿#pragma once
+#include<vector>
+#include"HlslLayout.h"
+
+class ComputeExecutor;
+
+///FirstStepのIDsと同じレイアウト(ComputeShader.hlslのBuffer_t)
+struct IDs {
+	float grpId;
+	float grpThrdId;
+	float dsptThrdId;
+	unsigned int grpIdx;
+};
+HLSL_CHECK_STRUCTURED(IDs, 16);
+HLSL_CHECK_OFFSET(IDs, dsptThrdId, 8);
+HLSL_CHECK_OFFSET(IDs, grpIdx, 12);
+
+///FirstStepの入力(ComputeShader.hlslのSimpleBuffer_t)
+struct SimpleBuffer_t {
+	int i;
+	float f;
+};
+HLSL_CHECK_STRUCTURED(SimpleBuffer_t, 8);
+HLSL_CHECK_OFFSET(SimpleBuffer_t, f, 4);
+
+///FirstStep(ComputeShader.hlsl)のmainと同じ処理をCPUで行う
+///[numthreads(4,4,4)]でDispatch(x,y,z)したときと同じようにdsptThrdIdを書き込む
+///@param uav 出力バッファ(シェーダと同じくdtid.x*64+dtid.y*8+dtid.zの位置に書く)
+///@param x,y,z グループ数(シェーダの添字が8固定なので2,2,2まで)
+///@param executor 実行するエグゼキュータ
+///@remarks 実装はKernelRegistryの"firststep"で選ばれる
+void FirstStepIds(std::vector<IDs>& uav, unsigned int x, unsigned int y, unsigned int z, ComputeExecutor& executor);
@@ -0,0 +1,373 @@
+﻿#include "GaussianBlur.h"
+#include<algorithm>
+#include<cassert>
+#include<cstring>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+//シェーダと同じ重み
+namespace hlsl {
+	namespace {
+#include"GaussianBlur.hlsli"
+	}
+}
+
+using namespace std;
+
+namespace {
+	//リングバッファ(2*radius+1行×短冊の幅のfloat4)をこの大きさに収める(L2の一部)
+	constexpr size_t ringBudgetBytes = 512 * 1024;
+	//短冊の幅の最小値と刻み(画素)
+	constexpr unsigned int minStripWidth = 64;
+	constexpr unsigned int stripAlignment = 16;
+	//並列化するときの帯の最小の行数(帯ごとに上下radius行ずつ余分に横ぼかしするので、radiusの4倍以上にする)
+	constexpr unsigned int minBandRows = 16;
+
+	//ここから1次元の対称な畳み込み
+	//dst[i] = w[0]*taps[r][i] + Σ(k=1～r) w[k]*(taps[r-k][i] + taps[r+k][i])
+	//横のパスはtapsに1画素(float4)ずつずらした同じ行を、縦のパスはリングバッファの2r+1行を渡す
+
+	void BlurTapsRange(const float* const* taps, float* dst, size_t begin, size_t end, const float* weights, unsigned int radius) {
+		auto center = taps[radius];
+		for (auto i = begin; i < end; ++i) {
+			float sum = weights[0] * center[i];
+			for (unsigned int k = 1; k <= radius; ++k) {
+				sum += weights[k] * (taps[radius - k][i] + taps[radius + k][i]);
+			}
+			dst[i] = sum;
+		}
+	}
+
+	void BlurTapsScalar(const float* const* taps, float* dst, size_t count, const float* weights, unsigned int radius) {
+		BlurTapsRange(taps, dst, 0, count, weights, radius);
+	}
+
+#if defined(CPU_ARCH_X86)
+	//重みごとの積和は前の結果を待つので、独立した4本の和を並べてレイテンシを隠す
+
+	CPU_TARGET_SSE41 void BlurTapsSSE41(const float* const* taps, float* dst, size_t count, const float* weights, unsigned int radius) {
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			auto w = _mm_set1_ps(weights[0]);
+			auto c = taps[radius] + i;
+			auto a0 = _mm_mul_ps(w, _mm_loadu_ps(c));
+			auto a1 = _mm_mul_ps(w, _mm_loadu_ps(c + 4));
+			auto a2 = _mm_mul_ps(w, _mm_loadu_ps(c + 8));
+			auto a3 = _mm_mul_ps(w, _mm_loadu_ps(c + 12));
+			for (unsigned int k = 1; k <= radius; ++k) {
+				w = _mm_set1_ps(weights[k]);
+				auto l = taps[radius - k] + i;
+				auto r = taps[radius + k] + i;
+				a0 = _mm_add_ps(a0, _mm_mul_ps(w, _mm_add_ps(_mm_loadu_ps(l), _mm_loadu_ps(r))));
+				a1 = _mm_add_ps(a1, _mm_mul_ps(w, _mm_add_ps(_mm_loadu_ps(l + 4), _mm_loadu_ps(r + 4))));
+				a2 = _mm_add_ps(a2, _mm_mul_ps(w, _mm_add_ps(_mm_loadu_ps(l + 8), _mm_loadu_ps(r + 8))));
+				a3 = _mm_add_ps(a3, _mm_mul_ps(w, _mm_add_ps(_mm_loadu_ps(l + 12), _mm_loadu_ps(r + 12))));
+			}
+			_mm_storeu_ps(dst + i, a0);
+			_mm_storeu_ps(dst + i + 4, a1);
+			_mm_storeu_ps(dst + i + 8, a2);
+			_mm_storeu_ps(dst + i + 12, a3);
+		}
+		BlurTapsRange(taps, dst, i, count, weights, radius);
+	}
+
+	CPU_TARGET_AVX2 void BlurTapsAVX2(const float* const* taps, float* dst, size_t count, const float* weights, unsigned int radius) {
+		size_t i = 0;
+		for (; i + 32 <= count; i += 32) {
+			auto w = _mm256_set1_ps(weights[0]);
+			auto c = taps[radius] + i;
+			auto a0 = _mm256_mul_ps(w, _mm256_loadu_ps(c));
+			auto a1 = _mm256_mul_ps(w, _mm256_loadu_ps(c + 8));
+			auto a2 = _mm256_mul_ps(w, _mm256_loadu_ps(c + 16));
+			auto a3 = _mm256_mul_ps(w, _mm256_loadu_ps(c + 24));
+			for (unsigned int k = 1; k <= radius; ++k) {
+				w = _mm256_set1_ps(weights[k]);
+				auto l = taps[radius - k] + i;
+				auto r = taps[radius + k] + i;
+				a0 = _mm256_fmadd_ps(w, _mm256_add_ps(_mm256_loadu_ps(l), _mm256_loadu_ps(r)), a0);
+				a1 = _mm256_fmadd_ps(w, _mm256_add_ps(_mm256_loadu_ps(l + 8), _mm256_loadu_ps(r + 8)), a1);
+				a2 = _mm256_fmadd_ps(w, _mm256_add_ps(_mm256_loadu_ps(l + 16), _mm256_loadu_ps(r + 16)), a2);
+				a3 = _mm256_fmadd_ps(w, _mm256_add_ps(_mm256_loadu_ps(l + 24), _mm256_loadu_ps(r + 24)), a3);
+			}
+			_mm256_storeu_ps(dst + i, a0);
+			_mm256_storeu_ps(dst + i + 8, a1);
+			_mm256_storeu_ps(dst + i + 16, a2);
+			_mm256_storeu_ps(dst + i + 24, a3);
+		}
+		for (; i + 8 <= count; i += 8) {
+			auto a = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(taps[radius] + i));
+			for (unsigned int k = 1; k <= radius; ++k) {
+				a = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_add_ps(_mm256_loadu_ps(taps[radius - k] + i), _mm256_loadu_ps(taps[radius + k] + i)), a);
+			}
+			_mm256_storeu_ps(dst + i, a);
+		}
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		BlurTapsRange(taps, dst, i, count, weights, radius);
+	}
+
+	CPU_TARGET_AVX512 void BlurTapsAVX512(const float* const* taps, float* dst, size_t count, const float* weights, unsigned int radius) {
+		size_t i = 0;
+		for (; i + 64 <= count; i += 64) {
+			auto w = _mm512_set1_ps(weights[0]);
+			auto c = taps[radius] + i;
+			auto a0 = _mm512_mul_ps(w, _mm512_loadu_ps(c));
+			auto a1 = _mm512_mul_ps(w, _mm512_loadu_ps(c + 16));
+			auto a2 = _mm512_mul_ps(w, _mm512_loadu_ps(c + 32));
+			auto a3 = _mm512_mul_ps(w, _mm512_loadu_ps(c + 48));
+			for (unsigned int k = 1; k <= radius; ++k) {
+				w = _mm512_set1_ps(weights[k]);
+				auto l = taps[radius - k] + i;
+				auto r = taps[radius + k] + i;
+				a0 = _mm512_fmadd_ps(w, _mm512_add_ps(_mm512_loadu_ps(l), _mm512_loadu_ps(r)), a0);
+				a1 = _mm512_fmadd_ps(w, _mm512_add_ps(_mm512_loadu_ps(l + 16), _mm512_loadu_ps(r + 16)), a1);
+				a2 = _mm512_fmadd_ps(w, _mm512_add_ps(_mm512_loadu_ps(l + 32), _mm512_loadu_ps(r + 32)), a2);
+				a3 = _mm512_fmadd_ps(w, _mm512_add_ps(_mm512_loadu_ps(l + 48), _mm512_loadu_ps(r + 48)), a3);
+			}
+			_mm512_storeu_ps(dst + i, a0);
+			_mm512_storeu_ps(dst + i + 16, a1);
+			_mm512_storeu_ps(dst + i + 32, a2);
+			_mm512_storeu_ps(dst + i + 48, a3);
+		}
+		for (; i + 16 <= count; i += 16) {
+			auto a = _mm512_mul_ps(_mm512_set1_ps(weights[0]), _mm512_loadu_ps(taps[radius] + i));
+			for (unsigned int k = 1; k <= radius; ++k) {
+				a = _mm512_fmadd_ps(_mm512_set1_ps(weights[k]), _mm512_add_ps(_mm512_loadu_ps(taps[radius - k] + i), _mm512_loadu_ps(taps[radius + k] + i)), a);
+			}
+			_mm512_storeu_ps(dst + i, a);
+		}
+		_mm256_zeroupper();
+		BlurTapsRange(taps, dst, i, count, weights, radius);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	void BlurTapsNEON(const float* const* taps, float* dst, size_t count, const float* weights, unsigned int radius) {
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			auto c = taps[radius] + i;
+			auto a0 = vmulq_n_f32(vld1q_f32(c), weights[0]);
+			auto a1 = vmulq_n_f32(vld1q_f32(c + 4), weights[0]);
+			auto a2 = vmulq_n_f32(vld1q_f32(c + 8), weights[0]);
+			auto a3 = vmulq_n_f32(vld1q_f32(c + 12), weights[0]);
+			for (unsigned int k = 1; k <= radius; ++k) {
+				auto w = vdupq_n_f32(weights[k]);
+				auto l = taps[radius - k] + i;
+				auto r = taps[radius + k] + i;
+				a0 = vfmaq_f32(a0, w, vaddq_f32(vld1q_f32(l), vld1q_f32(r)));
+				a1 = vfmaq_f32(a1, w, vaddq_f32(vld1q_f32(l + 4), vld1q_f32(r + 4)));
+				a2 = vfmaq_f32(a2, w, vaddq_f32(vld1q_f32(l + 8), vld1q_f32(r + 8)));
+				a3 = vfmaq_f32(a3, w, vaddq_f32(vld1q_f32(l + 12), vld1q_f32(r + 12)));
+			}
+			vst1q_f32(dst + i, a0);
+			vst1q_f32(dst + i + 4, a1);
+			vst1q_f32(dst + i + 8, a2);
+			vst1q_f32(dst + i + 12, a3);
+		}
+		BlurTapsRange(taps, dst, i, count, weights, radius);
+	}
+#endif
+
+	using BlurTapsFunc = void(*)(const float* const* taps, float* dst, size_t count, const float* weights, unsigned int radius);
+	Kernel<BlurTapsFunc> blurTaps("blur", {
+		{ CpuIsa::Scalar, BlurTapsScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, BlurTapsSSE41 },
+		{ CpuIsa::AVX2, BlurTapsAVX2 },
+		{ CpuIsa::AVX512, BlurTapsAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, BlurTapsNEON },
+#endif
+	});
+
+	//ここから行の読み書き
+	//読み込みは[left,left+count)の画素をfloat4にする(画像の外は端の画素)
+	//R8G8B8A8の変換はKernelRegistryの"unpack8"/"pack8"で選ばれる
+
+	void LoadRow(const ImageRGBA8& src, unsigned int y, int left, unsigned int count, float* out) {
+		auto row = src.Row(y);
+		const int last = static_cast<int>(src.width) - 1;
+		const int inBegin = clamp(left, 0, last + 1);
+		const int inEnd = max(inBegin, clamp(left + static_cast<int>(count), 0, last + 1));
+		for (int x = left; x < inBegin; ++x) {
+			UnpackUnorm4x8Row(&row[0], out + (x - left) * 4, 1);
+		}
+		UnpackUnorm4x8Row(row + inBegin, out + (inBegin - left) * 4, inEnd - inBegin);
+		for (int x = inEnd; x < left + static_cast<int>(count); ++x) {
+			UnpackUnorm4x8Row(&row[last], out + (x - left) * 4, 1);
+		}
+	}
+
+	void LoadRow(const ImageRGBA32F& src, unsigned int y, int left, unsigned int count, float* out) {
+		auto row = src.Row(y);
+		const int last = static_cast<int>(src.width) - 1;
+		//画像の中は一度に写し、外は端の画素を繰り返す
+		const int inBegin = clamp(left, 0, last + 1);
+		const int inEnd = clamp(left + static_cast<int>(count), 0, last + 1);
+		for (int x = left; x < inBegin; ++x) {
+			memcpy(out + (x - left) * 4, &row[0], sizeof(hlsl::float4));
+		}
+		if (inEnd > inBegin) {
+			memcpy(out + (inBegin - left) * 4, &row[inBegin], (inEnd - inBegin) * sizeof(hlsl::float4));
+		}
+		for (int x = max(inEnd, inBegin); x < left + static_cast<int>(count); ++x) {
+			memcpy(out + (x - left) * 4, &row[last], sizeof(hlsl::float4));
+		}
+	}
+
+	void StoreRow(ImageRGBA8& dst, unsigned int y, unsigned int x0, unsigned int count, const float* in) {
+		PackUnorm4x8Row(in, dst.Row(y) + x0, count);
+	}
+
+	void StoreRow(ImageRGBA32F& dst, unsigned int y, unsigned int x0, unsigned int count, const float* in) {
+		memcpy(static_cast<void*>(dst.Row(y) + x0), in, count * sizeof(hlsl::float4));
+	}
+
+	template<typename Pixel>
+	void Blur(const Image<Pixel>& src, Image<Pixel>& dst, unsigned int radius, float sigma, ComputeExecutor* executor) {
+		assert(&src != &dst);
+		assert(radius <= maxGaussianRadius);
+		dst.width = src.width;
+		dst.height = src.height;
+		dst.pixels.resize(src.pixels.size());
+		if (radius == 0) {
+			dst.pixels = src.pixels;
+			return;
+		}
+		if (src.width == 0 || src.height == 0) {
+			return;
+		}
+		assert(sigma > 0.0f);
+		const auto weights = GaussianWeights(radius, sigma);
+		auto blur = blurTaps.Get();
+		const unsigned int tapNum = 2 * radius + 1;
+		const int height = static_cast<int>(src.height);
+
+		//短冊の幅:リングバッファが予算に収まる幅(画像の幅で足りればそのまま)
+		unsigned int stripWidth = static_cast<unsigned int>(ringBudgetBytes / (tapNum * sizeof(hlsl::float4)));
+		stripWidth = max(minStripWidth, stripWidth / stripAlignment * stripAlignment);
+		stripWidth = min(stripWidth, src.width);
+		const unsigned int stripNum = (src.width + stripWidth - 1) / stripWidth;
+		//帯の数:並列化しないなら1つ(帯の境目で上下radius行ずつ余分に横ぼかしするため)
+		unsigned int bandNum = 1;
+		if (executor != nullptr && executor->ThreadCount() > 1) {
+			const unsigned int bandRows = max(minBandRows, 4 * radius);
+			bandNum = max(1u, min(src.height / bandRows, executor->ThreadCount() * 2));
+		}
+
+		auto runTask = [&](size_t task) {
+			const auto strip = static_cast<unsigned int>(task % stripNum);
+			const auto band = static_cast<unsigned int>(task / stripNum);
+			const unsigned int x0 = strip * stripWidth;
+			const unsigned int width = min(stripWidth, src.width - x0);
+			const int y0 = static_cast<int>(static_cast<uint64_t>(src.height) * band / bandNum);
+			const int y1 = static_cast<int>(static_cast<uint64_t>(src.height) * (band + 1) / bandNum);
+			const size_t rowFloats = static_cast<size_t>(width) * 4;
+
+			vector<float> padded((width + 2 * radius) * 4);
+			vector<float> ring(tapNum * rowFloats);
+			vector<float> out(rowFloats);
+			//横のパス:1画素ずつずらした同じ行
+			vector<const float*> rowTaps(tapNum);
+			for (unsigned int j = 0; j < tapNum; ++j) {
+				rowTaps[j] = padded.data() + j * 4;
+			}
+			vector<const float*> columnTaps(tapNum);
+			//行yの横ぼかしを置くリングバッファの行(y0-radiusから順に使いまわす)
+			auto ringRow = [&](int y) {
+				return ring.data() + static_cast<size_t>((y - (y0 - static_cast<int>(radius))) % tapNum) * rowFloats;
+			};
+			auto blurRow = [&](int y) {
+				LoadRow(src, static_cast<unsigned int>(clamp(y, 0, height - 1)), static_cast<int>(x0) - static_cast<int>(radius), width + 2 * radius, padded.data());
+				blur(rowTaps.data(), ringRow(y), rowFloats, weights.data(), radius);
+			};
+			for (int y = y0 - static_cast<int>(radius); y < y0 + static_cast<int>(radius); ++y) {
+				blurRow(y);
+			}
+			for (int y = y0; y < y1; ++y) {
+				blurRow(y + static_cast<int>(radius));
+				for (unsigned int j = 0; j < tapNum; ++j) {
+					columnTaps[j] = ringRow(y - static_cast<int>(radius) + static_cast<int>(j));
+				}
+				blur(columnTaps.data(), out.data(), rowFloats, weights.data(), radius);
+				StoreRow(dst, static_cast<unsigned int>(y), x0, width, out.data());
+			}
+		};
+		const size_t taskNum = static_cast<size_t>(stripNum) * bandNum;
+		if (taskNum > 1 && executor != nullptr) {
+			executor->ParallelFor(taskNum, 1, [&](size_t begin, size_t end) {
+				for (auto t = begin; t < end; ++t) {
+					runTask(t);
+				}
+			});
+		}
+		else {
+			for (size_t t = 0; t < taskNum; ++t) {
+				runTask(t);
+			}
+		}
+	}
+}
+
+vector<float>
+GaussianWeights(unsigned int radius, float sigma) {
+	vector<float> weights(radius + 1);
+	if (radius == 0) {
+		weights[0] = 1.0f;
+		return weights;
+	}
+	//シェーダのLoadWeightsと同じ順に足す
+	for (unsigned int k = 0; k <= radius; ++k) {
+		weights[k] = hlsl::GaussianWeight(static_cast<float>(k), sigma);
+	}
+	float total = weights[0];
+	for (unsigned int k = 1; k <= radius; ++k) {
+		total += 2.0f * weights[k];
+	}
+	for (auto& w : weights) {
+		w /= total;
+	}
+	return weights;
+}
+
+void
+GaussianBlur(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, float sigma, ComputeExecutor* executor) {
+	Blur(src, dst, radius, sigma, executor);
+}
+
+void
+GaussianBlur(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int radius, float sigma, ComputeExecutor* executor) {
+	Blur(src, dst, radius, sigma, executor);
+}
+
+void
+GaussianBlurReference(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int radius, float sigma) {
+	const auto weights = GaussianWeights(radius, sigma);
+	const int w = static_cast<int>(src.width);
+	const int h = static_cast<int>(src.height);
+	ImageRGBA32F tmp(src.width, src.height);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			auto sum = src.At(x, y) * weights[0];
+			for (int k = 1; k <= static_cast<int>(radius); ++k) {
+				sum += (src.At(max(x - k, 0), y) + src.At(min(x + k, w - 1), y)) * weights[k];
+			}
+			tmp.At(x, y) = sum;
+		}
+	}
+	dst = ImageRGBA32F(src.width, src.height);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			auto sum = tmp.At(x, y) * weights[0];
+			for (int k = 1; k <= static_cast<int>(radius); ++k) {
+				sum += (tmp.At(x, max(y - k, 0)) + tmp.At(x, min(y + k, h - 1))) * weights[k];
+			}
+			dst.At(x, y) = sum;
+		}
+	}
+}
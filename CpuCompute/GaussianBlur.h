@@ -0,0 +1,35 @@
+﻿#pragma once
+#include<vector>
+#include"Image.h"
+
+class ComputeExecutor;
+
+//ガウシアンぼかし(縦横に分けた2パス)
+//RenderTargetFilter/BlurCS.hlslのCPU版。重みはGaussianBlur.hlsliをシェーダと共有する
+//シェーダは横→縦を画像全体で2回通すが、CPUは行の帯(と列の短冊)ごとに横ぼかしした行をリングバッファにため、
+//たまった行から縦ぼかしを出力する。中間の行はL2に載っているうちに縦のパスで使われる
+
+///半径の上限(BlurCS.hlslのgroupsharedの大きさで決まる)
+constexpr unsigned int maxGaussianRadius = 64;
+
+///半径に対する既定の標準偏差(半径が2σになる)
+inline float GaussianSigmaForRadius(unsigned int radius) {
+	return radius * 0.5f;
+}
+
+///正規化した重み
+///@return 中心から0～radius画素の重み(radius+1個。中心+2*残りの合計が1)
+std::vector<float> GaussianWeights(unsigned int radius, float sigma);
+
+///ガウシアンぼかし(画像の外は端の画素を繰り返す)
+///@param src 入力画像
+///@param dst 出力画像(srcと同じサイズにされる。srcと同じではいけない)
+///@param radius 半径(0～maxGaussianRadius。0ならそのまま写す)
+///@param sigma 標準偏差(0より大きいこと)
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+///@remarks 畳み込みはKernelRegistryの"blur"で選ばれる。R8G8B8A8は中間をfloatで持ち、最後に丸める
+void GaussianBlur(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, float sigma, ComputeExecutor* executor);
+void GaussianBlur(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int radius, float sigma, ComputeExecutor* executor);
+
+///GaussianBlurの基準実装(画像全体を横→縦の順に1画素ずつ畳み込む)
+void GaussianBlurReference(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int radius, float sigma);
@@ -0,0 +1,9 @@
+//KEVAڂ̏d
+//BlurCS.hlslCPU(CpuCompute/GaussianBlur.cpp)ŋLĂ܂
+
+//Soffsetf̏d(KO)
+//d݂̍v(S + 2 * 1`radius)ŊĎg
+float GaussianWeight(float offset, float sigma)
+{
+    return exp(-offset * offset / (2.0f * sigma * sigma));
+}
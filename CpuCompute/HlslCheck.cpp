@@ -0,0 +1,172 @@
+﻿#include "HlslCheck.h"
+#include<cstdio>
+#include<cmath>
+#include"HlslTypes.h"
+#include"Image.h"
+#include"HlslLayout.h"
+
+//シェーダと共有している関数
+namespace hlsl {
+	namespace {
+#include"MonoPixel.hlsli"
+	}
+}
+
+using namespace std;
+using hlsl::float2;
+using hlsl::float3;
+using hlsl::float4;
+using hlsl::int3;
+using hlsl::uint3;
+using hlsl::float4x4;
+
+namespace {
+	//cbufferのパッキング規則:float3の後ろのfloatは同じレジスタに入るが、float2は次のレジスタから始まる
+	struct CBufferSample {
+		float4x4 world;
+		float3 lightDir;
+		float power;
+		float2 uv;
+		float2 pad;
+	};
+	HLSL_CHECK_CBUFFER(CBufferSample);
+	HLSL_CHECK_CBUFFER_MEMBER(CBufferSample, world);
+	HLSL_CHECK_CBUFFER_MEMBER(CBufferSample, lightDir);
+	HLSL_CHECK_CBUFFER_MEMBER(CBufferSample, power);
+	HLSL_CHECK_CBUFFER_MEMBER(CBufferSample, uv);
+	static_assert(!FitsHlslCBufferRegister(12, 8), "float2 at offset 12 must be rejected");
+	static_assert(!FitsHlslCBufferRegister(4, 16), "float4 at offset 4 must be rejected");
+	static_assert(IsHlslStructuredElement<float3>::value && !IsHlslStructuredElement<double>::value, "structured element rules");
+
+	int passCount = 0;
+	int failCount = 0;
+
+	void Check(const char* name, bool ok) {
+		if (ok) {
+			++passCount;
+		}
+		else {
+			++failCount;
+			printf("FAIL: %s\n", name);
+		}
+	}
+
+	bool Near(float a, float b, float eps = 1e-6f) {
+		return fabs(a - b) <= eps;
+	}
+	template<typename V>
+	bool Near(const V& a, const V& b, float eps = 1e-6f) {
+		for (int i = 0; i < V::size; ++i) {
+			if (!Near(a[i], b[i], eps)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//D3Dの規定: min/maxは片方がNaNならもう片方を返し、saturate(NaN)は0
+	void CheckNaN() {
+		Check("saturate(NaN)==0", hlsl::saturate(NAN) == 0.0f);
+		Check("saturate(-1)==0", hlsl::saturate(-1.0f) == 0.0f);
+		Check("saturate(2)==1", hlsl::saturate(2.0f) == 1.0f);
+		Check("min(NaN,1)==1", hlsl::min(NAN, 1.0f) == 1.0f);
+		Check("min(1,NaN)==1", hlsl::min(1.0f, NAN) == 1.0f);
+		Check("max(NaN,1)==1", hlsl::max(NAN, 1.0f) == 1.0f);
+		Check("saturate(float3) with NaN", all(saturate(float3(NAN, -2, 0.25f)) == float3(0, 0, 0.25f)));
+		//pow(x,y)=exp2(y*log2(x))なので負のxはNaN
+		Check("pow(-2,2) is NaN", hlsl::isnan(hlsl::pow(-2.0f, 2.0f)));
+		Check("normalize(0) is NaN", all(isnan(normalize(float3(0, 0, 0)))));
+	}
+
+	void CheckRounding() {
+		//roundは最近接偶数
+		Check("round(2.5)==2", hlsl::round(2.5f) == 2.0f);
+		Check("round(1.5)==2", hlsl::round(1.5f) == 2.0f);
+		Check("round(-2.5)==-2", hlsl::round(-2.5f) == -2.0f);
+		Check("frac(-0.25)==0.75", hlsl::frac(-0.25f) == 0.75f);
+		Check("trunc(-1.5)==-1", hlsl::trunc(-1.5f) == -1.0f);
+		Check("sign returns int", all(sign(float3(-3, 0, 2)) == int3(-1, 0, 1)));
+		Check("fmod(-3,2)==-1", hlsl::fmod(-3.0f, 2.0f) == -1.0f);
+		Check("asuint(1)", hlsl::asuint(1.0f) == 0x3f800000u);
+		Check("asfloat", hlsl::asfloat(0x40490fdbu) == 3.14159274f);
+	}
+
+	void CheckIntrinsics() {
+		Check("lerp", Near(lerp(float3(0, 1, 2), float3(2, 3, 4), 0.25f), float3(0.5f, 1.5f, 2.5f)));
+		Check("step", all(step(0.5f, float3(0.25f, 0.5f, 1)) == float3(0, 1, 1)));
+		Check("smoothstep", Near(hlsl::smoothstep(0.0f, 1.0f, 0.25f), 0.15625f));
+		Check("clamp", all(clamp(float3(-1, 0.5f, 3), 0, 1) == float3(0, 0.5f, 1)));
+		Check("dot", dot(float3(1, 2, 3), float3(4, 5, 6)) == 32.0f);
+		Check("cross", all(cross(float3(1, 0, 0), float3(0, 1, 0)) == float3(0, 0, 1)));
+		Check("length", length(float2(3, 4)) == 5.0f);
+		Check("distance", distance(float3(1, 1, 1), float3(1, 4, 5)) == 5.0f);
+		Check("normalize", Near(normalize(float3(1, -1, 1)), float3(1, -1, 1) / sqrt(3.0f)));
+		//BasicPixelShaderと同じ使い方
+		Check("reflect", Near(reflect(float3(1, -1, 0), float3(0, 1, 0)), float3(1, 1, 0)));
+		Check("refract straight", Near(refract(float3(0, -1, 0), float3(0, 1, 0), 0.75f), float3(0, -1, 0)));
+		Check("refract total internal reflection", all(refract(normalize(float3(1, -0.1f, 0)), float3(0, 1, 0), 1.5f) == float3(0, 0, 0)));
+		Check("any/all", any(float3(0, 0, 1)) && !all(float3(0, 0, 1)) && all(float3(1, 2, 3)));
+		Check("select", all(select(float3(1, 2, 3) > 1.5f, float3(1, 1, 1), float3(0, 0, 0)) == float3(0, 1, 1)));
+	}
+
+	void CheckConstructionAndSwizzle() {
+		float4 v(1, 2, 3, 4);
+		Check("swizzle read", all(v.wzyx == float4(4, 3, 2, 1)) && all(v.bgr == float3(3, 2, 1)) && all(v.xx == float2(1, 1)));
+		Check("swizzle of float2", all(float2(5, 6).yxy == float3(6, 5, 6)));
+		auto w = v;
+		w.xy = v.zw;
+		Check("swizzle write", all(w == float4(3, 4, 3, 4)));
+		w = v;
+		w.zx = float2(7, 8);
+		Check("swizzle write order", all(w == float4(8, 2, 7, 4)));
+		w = v;
+		w.rgb *= 2;
+		Check("swizzle compound", all(w == float4(2, 4, 6, 4)));
+		Check("construct from pieces", all(float4(float2(1, 2), 3, 4) == v) && all(float4(v.xyz, 4) == v) && all(float4(1, v.yz, 4) == v));
+		Check("scalar broadcast", all(float3(1, 2, 3) + 1 == float3(2, 3, 4)) && all(2.0 * float3(1, 2, 3) == float3(2, 4, 6)));
+		Check("int to float promotion", all(int3(1, 2, 3) + float3(0.5f, 0.5f, 0.5f) == float3(1.5f, 2.5f, 3.5f)));
+		Check("explicit float to int", all(int3(float3(1.75f, -1.75f, 2)) == int3(1, -1, 2)));
+		uint3 dtid = { 4,5,6 };
+		Check("uint3 members", dtid.x == 4 && dtid.y == 5 && dtid.z == 6 && all(dtid.xy == hlsl::uint2(4, 5)));
+		//StructuredBuffer/cbufferとやり取りできるよう詰まっていること
+		Check("layout", sizeof(float3) == 12 && sizeof(float4) == 16 && sizeof(float4x4) == 64
+			&& reinterpret_cast<const char*>(&v.w) - reinterpret_cast<const char*>(&v) == 12);
+	}
+
+	void CheckMatrix() {
+		//HLSLのmul(M,v)はvを列ベクトルとして扱うので、平行移動は4列目に入る
+		float4x4 t(float4(1, 0, 0, 10), float4(0, 1, 0, 20), float4(0, 0, 1, 30), float4(0, 0, 0, 1));
+		Check("mul(M,v) column vector", all(mul(t, float4(1, 2, 3, 1)) == float4(11, 22, 33, 1)));
+		Check("mul(v,M) row vector", all(mul(float4(1, 2, 3, 1), transpose(t)) == float4(11, 22, 33, 1)));
+		float4x4 s(float4(2, 0, 0, 0), float4(0, 3, 0, 0), float4(0, 0, 4, 0), float4(0, 0, 0, 1));
+		//mul(mul(proj,view),pos)==mul(proj,mul(view,pos))
+		auto p = float4(1, 1, 1, 1);
+		Check("mul(M,M) associativity", all(mul(mul(s, t), p) == mul(s, mul(t, p))));
+		Check("mul(M,M) order", all(mul(mul(s, t), p) == float4(22, 63, 124, 1)));
+		Check("mul(scalar,v)", all(mul(2.0f, float3(1, 2, 3)) == float3(2, 4, 6)));
+	}
+
+	//シェーダと共有しているMonoPixelがHLSLの式どおりに計算しているか
+	void CheckSharedKernel() {
+		Check("MonoPixel white", all(hlsl::MonoPixel(float4(1, 1, 1, 1)) == float4(1, 1, 1, 1)));
+		Check("MonoPixel black", all(hlsl::MonoPixel(float4(0, 0, 0, 0)) == float4(0, 0, 0, 1)));
+		auto gray = hlsl::MonoPixel(float4(0.5f, 0.5f, 0.5f, 1)).x;
+		Check("MonoPixel gray", Near(gray, static_cast<float>(pow(0.5, 1.0 / 2.2)), 1e-6f));
+		//R8G8B8A8_UNORMとの変換
+		Check("unorm roundtrip", PackUnorm4x8(UnpackUnorm4x8(0x80ff4000u)) == 0x80ff4000u);
+		Check("unorm rounding", PackUnorm4x8(float4(0.5f, -1, 2, NAN)) == 0x00ff0080u);
+	}
+}
+
+bool
+CheckHlslMath() {
+	passCount = failCount = 0;
+	CheckNaN();
+	CheckRounding();
+	CheckIntrinsics();
+	CheckConstructionAndSwizzle();
+	CheckMatrix();
+	CheckSharedKernel();
+	printf("hlsl math: %d passed, %d failed\n", passCount, failCount);
+	return failCount == 0;
+}
@@ -0,0 +1,6 @@
+﻿#pragma once
+
+///HlslTypes.hがHLSLと同じ結果を返すかを確認する
+///(NaNの扱い、丸め、スウィズル、mulの向き、シェーダと共有している関数など)
+///@return 全部一致したらtrue
+bool CheckHlslMath();
@@ -0,0 +1,39 @@
+﻿#pragma once
+#include<cstddef>
+#include<type_traits>
+
+//C++の構造体をHLSLのバッファとやり取りするときのレイアウト確認
+//  ・StructuredBufferの要素は4バイト単位で詰められる(パディングは入らない)
+//  ・cbufferのメンバは16バイト境界をまたげず、16バイト以上のもの(配列・構造体)は境界から始まる
+//C++からはHLSL側の宣言が見えないので、オフセットはHLSLの宣言を見て書くこと
+
+///StructuredBuffer<T>/RWStructuredBuffer<T>の要素としてそのままコピーできる型か
+///(標準レイアウトで、4バイトより大きなアライメントを持たず、大きさが4の倍数でストライドの上限2048以下)
+///@remarks hlsl::float3などはスウィズルの共用体のためにコピーを自前で書いているので
+///trivially copyableにはならないが、中身はT[N]なのでmemcpyしてよい。そのためデストラクタで判定している
+template<typename T>
+struct IsHlslStructuredElement : std::integral_constant<bool,
+	std::is_trivially_destructible<T>::value && std::is_standard_layout<T>::value &&
+	alignof(T) <= 4 && sizeof(T) % 4 == 0 && sizeof(T) <= 2048> {};
+
+///cbufferのパッキング規則でoffsetにsizeバイトのメンバを置けるか
+constexpr bool FitsHlslCBufferRegister(size_t offset, size_t size) {
+	return size >= 16 ? offset % 16 == 0 : offset / 16 == (offset + size - 1) / 16;
+}
+
+///StructuredBufferの要素型であることを確認する
+#define HLSL_CHECK_STRUCTURED(Type, hlslSize) \
+	static_assert(IsHlslStructuredElement<Type>::value, #Type " cannot be copied to a StructuredBuffer as is"); \
+	static_assert(sizeof(Type) == (hlslSize), #Type " must be " #hlslSize " bytes to match HLSL")
+
+///メンバのオフセットがHLSL側と同じか確認する
+#define HLSL_CHECK_OFFSET(Type, member, hlslOffset) \
+	static_assert(offsetof(Type, member) == (hlslOffset), #Type "::" #member " must be at offset " #hlslOffset " to match HLSL")
+
+///cbufferに置く構造体のメンバが16バイト境界の規則を守っているか確認する
+#define HLSL_CHECK_CBUFFER_MEMBER(Type, member) \
+	static_assert(FitsHlslCBufferRegister(offsetof(Type, member), sizeof(Type::member)), #Type "::" #member " crosses a 16-byte boundary (cbuffer packing)")
+
+///cbufferに置く構造体全体の大きさが16バイトの倍数か確認する
+#define HLSL_CHECK_CBUFFER(Type) \
+	static_assert(std::is_standard_layout<Type>::value && std::is_trivially_destructible<Type>::value && sizeof(Type) % 16 == 0, #Type " must be a multiple of 16 bytes to be a cbuffer")
@@ -0,0 +1,496 @@
+﻿#pragma once
+#include<cmath>
+#include<cstring>
+#include<type_traits>
+
+//HLSLのベクトル/行列型と組み込み関数のC++版
+//シェーダとC++で同じコード(.hlsli)を共有できるよう、名前と意味はHLSLに合わせている
+//  ・ベクトル版の関数と演算子はVectorのfriendなのでADLで見つかる
+//    (namespace hlslの外からはhlsl::を付けずに呼ぶ。スカラー版はhlsl::で呼べる)
+//  ・共有する.hlsliはnamespace hlslの中の無名名前空間でincludeする(複数の翻訳単位で読めるように)
+//  ・スカラーは暗黙にベクトルに広がる(float3 v = 1;やv * 0.5)
+//  ・整数ベクトル→floatベクトルは暗黙、それ以外の型変換はexplicit
+//  ・min/maxは片方がNaNならもう片方、saturate(NaN)は0(D3Dの規定どおり)
+//  ・各成分の演算は固定長のループなので、画素ループの中ではそのままSIMD化される
+
+//Windows.hのmin/maxマクロとぶつかるので、この中だけ外しておく
+#pragma push_macro("min")
+#pragma push_macro("max")
+#undef min
+#undef max
+
+namespace hlsl {
+	using uint = unsigned int;
+
+	template<typename T, int N> struct Vector;
+
+	//スカラーの組み込み関数
+
+	inline float saturate(float x) { return x > 0.0f ? (x < 1.0f ? x : 1.0f) : 0.0f; }
+	inline float min(float a, float b) { return (a < b || b != b) ? a : b; }
+	inline float max(float a, float b) { return (a > b || b != b) ? a : b; }
+	inline int min(int a, int b) { return a < b ? a : b; }
+	inline int max(int a, int b) { return a > b ? a : b; }
+	inline uint min(uint a, uint b) { return a < b ? a : b; }
+	inline uint max(uint a, uint b) { return a > b ? a : b; }
+	inline float clamp(float x, float a, float b) { return min(max(x, a), b); }
+	inline int clamp(int x, int a, int b) { return min(max(x, a), b); }
+	inline uint clamp(uint x, uint a, uint b) { return min(max(x, a), b); }
+	inline float abs(float x) { return std::fabs(x); }
+	inline int abs(int x) { return x < 0 ? -x : x; }
+	inline int sign(float x) { return (x > 0.0f) - (x < 0.0f); }
+	inline int sign(int x) { return (x > 0) - (x < 0); }
+	inline float lerp(float a, float b, float t) { return a + (b - a) * t; }
+	inline float mad(float a, float b, float c) { return a * b + c; }
+	inline float step(float a, float x) { return x >= a ? 1.0f : 0.0f; }
+	inline float smoothstep(float a, float b, float x) {
+		auto t = saturate((x - a) / (b - a));
+		return t * t * (3.0f - 2.0f * t);
+	}
+	inline float sqrt(float x) { return std::sqrt(x); }
+	inline float rsqrt(float x) { return 1.0f / std::sqrt(x); }
+	inline float rcp(float x) { return 1.0f / x; }
+	///HLSLのpowはexp2(y*log2(x))なので、負のxはNaNになる
+	inline float pow(float x, float y) { return x < 0.0f ? NAN : std::pow(x, y); }
+	inline float exp(float x) { return std::exp(x); }
+	inline float exp2(float x) { return std::exp2(x); }
+	inline float log(float x) { return std::log(x); }
+	inline float log2(float x) { return std::log2(x); }
+	inline float log10(float x) { return std::log10(x); }
+	inline float sin(float x) { return std::sin(x); }
+	inline float cos(float x) { return std::cos(x); }
+	inline float tan(float x) { return std::tan(x); }
+	inline float asin(float x) { return std::asin(x); }
+	inline float acos(float x) { return std::acos(x); }
+	inline float atan(float x) { return std::atan(x); }
+	inline float atan2(float y, float x) { return std::atan2(y, x); }
+	inline float floor(float x) { return std::floor(x); }
+	inline float ceil(float x) { return std::ceil(x); }
+	inline float trunc(float x) { return std::trunc(x); }
+	///最近接偶数丸め(DXILのround_neと同じ)
+	inline float round(float x) { return std::nearbyint(x); }
+	inline float frac(float x) { return x - std::floor(x); }
+	inline float fmod(float x, float y) { return std::fmod(x, y); }
+	inline float radians(float x) { return x * 0.01745329251994329577f; }
+	inline float degrees(float x) { return x * 57.2957795130823208768f; }
+	inline bool isnan(float x) { return x != x; }
+	inline bool isinf(float x) { return std::isinf(x); }
+	inline uint asuint(float x) { uint r; std::memcpy(&r, &x, sizeof(r)); return r; }
+	inline float asfloat(uint x) { float r; std::memcpy(&r, &x, sizeof(r)); return r; }
+
+	namespace detail {
+		//同じ成分を2回使っていないか(書き込めるスウィズルかどうか)
+		template<int... I>
+		constexpr bool IsWritableSwizzle() {
+			const int idx[] = { I... };
+			for (size_t i = 0; i < sizeof...(I); ++i) {
+				for (size_t j = i + 1; j < sizeof...(I); ++j) {
+					if (idx[i] == idx[j]) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		//コンストラクタ引数の成分数(スカラーは1、ベクトルはN)
+		template<typename X, typename = void>
+		struct ComponentCount { static constexpr int value = 1; };
+		template<typename X>
+		struct ComponentCount<X, std::void_t<decltype(X::size)>> { static constexpr int value = X::size; };
+	}
+
+	///スウィズル(v.xyやv.bgrなど)
+	///読むとVに変換され、成分が重複していなければ書き込める
+	///@param V 読み出したときのベクトル型
+	///@param T 要素の型
+	///@param N 元のベクトルの成分数
+	///@param I 取り出す成分の番号
+	template<typename V, typename T, int N, int... I>
+	struct Swizzle {
+		T e[N];
+
+		operator V()const { return V(e[I]...); }
+
+		Swizzle& operator=(const V& v) {
+			static_assert(detail::IsWritableSwizzle<I...>(), "swizzle with repeated components is read-only");
+			int k = 0;
+			((e[I] = v[k++]), ...);
+			return *this;
+		}
+		//v.xy = w.xy のように同じ型同士でも成分ごとに代入する
+		Swizzle& operator=(const Swizzle& s) { return *this = V(s); }
+		Swizzle& operator+=(const V& v) { return *this = V(*this) + v; }
+		Swizzle& operator-=(const V& v) { return *this = V(*this) - v; }
+		Swizzle& operator*=(const V& v) { return *this = V(*this) * v; }
+		Swizzle& operator/=(const V& v) { return *this = V(*this) / v; }
+	};
+
+//スウィズルのメンバ宣言(Tは要素の型、Nは元のベクトルの成分数の式)
+#define HLSL_SW2(a,i,b,j) Swizzle<Vector<T,2>,T,N,i,j> a##b;
+#define HLSL_SW3(a,i,b,j,c,k) Swizzle<Vector<T,3>,T,N,i,j,k> a##b##c;
+#define HLSL_SW4(a,i,b,j,c,k,d,l) Swizzle<Vector<T,4>,T,N,i,j,k,l> a##b##c##d;
+//先頭の成分をn0～n(N-1)で展開し、残りはFに任せる
+#define HLSL_EACH2(F,n0,n1,n2,n3) F(n0,0,n0,n1,n2,n3) F(n1,1,n0,n1,n2,n3)
+#define HLSL_EACH3(F,n0,n1,n2,n3) HLSL_EACH2(F,n0,n1,n2,n3) F(n2,2,n0,n1,n2,n3)
+#define HLSL_EACH4(F,n0,n1,n2,n3) HLSL_EACH3(F,n0,n1,n2,n3) F(n3,3,n0,n1,n2,n3)
+//2成分
+#define HLSL_SW2_2(a,i,n0,n1,n2,n3) HLSL_SW2(a,i,n0,0) HLSL_SW2(a,i,n1,1)
+#define HLSL_SW2_3(a,i,n0,n1,n2,n3) HLSL_SW2_2(a,i,n0,n1,n2,n3) HLSL_SW2(a,i,n2,2)
+#define HLSL_SW2_4(a,i,n0,n1,n2,n3) HLSL_SW2_3(a,i,n0,n1,n2,n3) HLSL_SW2(a,i,n3,3)
+//3成分
+#define HLSL_SW3_2B(a,i,b,j,n0,n1,n2,n3) HLSL_SW3(a,i,b,j,n0,0) HLSL_SW3(a,i,b,j,n1,1)
+#define HLSL_SW3_3B(a,i,b,j,n0,n1,n2,n3) HLSL_SW3_2B(a,i,b,j,n0,n1,n2,n3) HLSL_SW3(a,i,b,j,n2,2)
+#define HLSL_SW3_4B(a,i,b,j,n0,n1,n2,n3) HLSL_SW3_3B(a,i,b,j,n0,n1,n2,n3) HLSL_SW3(a,i,b,j,n3,3)
+#define HLSL_SW3_2(a,i,n0,n1,n2,n3) HLSL_SW3_2B(a,i,n0,0,n0,n1,n2,n3) HLSL_SW3_2B(a,i,n1,1,n0,n1,n2,n3)
+#define HLSL_SW3_3(a,i,n0,n1,n2,n3) HLSL_SW3_3B(a,i,n0,0,n0,n1,n2,n3) HLSL_SW3_3B(a,i,n1,1,n0,n1,n2,n3) HLSL_SW3_3B(a,i,n2,2,n0,n1,n2,n3)
+#define HLSL_SW3_4(a,i,n0,n1,n2,n3) HLSL_SW3_4B(a,i,n0,0,n0,n1,n2,n3) HLSL_SW3_4B(a,i,n1,1,n0,n1,n2,n3) HLSL_SW3_4B(a,i,n2,2,n0,n1,n2,n3) HLSL_SW3_4B(a,i,n3,3,n0,n1,n2,n3)
+//4成分
+#define HLSL_SW4_C2(a,i,b,j,c,k,n0,n1,n2,n3) HLSL_SW4(a,i,b,j,c,k,n0,0) HLSL_SW4(a,i,b,j,c,k,n1,1)
+#define HLSL_SW4_C3(a,i,b,j,c,k,n0,n1,n2,n3) HLSL_SW4_C2(a,i,b,j,c,k,n0,n1,n2,n3) HLSL_SW4(a,i,b,j,c,k,n2,2)
+#define HLSL_SW4_C4(a,i,b,j,c,k,n0,n1,n2,n3) HLSL_SW4_C3(a,i,b,j,c,k,n0,n1,n2,n3) HLSL_SW4(a,i,b,j,c,k,n3,3)
+#define HLSL_SW4_B2(a,i,b,j,n0,n1,n2,n3) HLSL_SW4_C2(a,i,b,j,n0,0,n0,n1,n2,n3) HLSL_SW4_C2(a,i,b,j,n1,1,n0,n1,n2,n3)
+#define HLSL_SW4_B3(a,i,b,j,n0,n1,n2,n3) HLSL_SW4_C3(a,i,b,j,n0,0,n0,n1,n2,n3) HLSL_SW4_C3(a,i,b,j,n1,1,n0,n1,n2,n3) HLSL_SW4_C3(a,i,b,j,n2,2,n0,n1,n2,n3)
+#define HLSL_SW4_B4(a,i,b,j,n0,n1,n2,n3) HLSL_SW4_C4(a,i,b,j,n0,0,n0,n1,n2,n3) HLSL_SW4_C4(a,i,b,j,n1,1,n0,n1,n2,n3) HLSL_SW4_C4(a,i,b,j,n2,2,n0,n1,n2,n3) HLSL_SW4_C4(a,i,b,j,n3,3,n0,n1,n2,n3)
+#define HLSL_SW4_2(a,i,n0,n1,n2,n3) HLSL_SW4_B2(a,i,n0,0,n0,n1,n2,n3) HLSL_SW4_B2(a,i,n1,1,n0,n1,n2,n3)
+#define HLSL_SW4_3(a,i,n0,n1,n2,n3) HLSL_SW4_B3(a,i,n0,0,n0,n1,n2,n3) HLSL_SW4_B3(a,i,n1,1,n0,n1,n2,n3) HLSL_SW4_B3(a,i,n2,2,n0,n1,n2,n3)
+#define HLSL_SW4_4(a,i,n0,n1,n2,n3) HLSL_SW4_B4(a,i,n0,0,n0,n1,n2,n3) HLSL_SW4_B4(a,i,n1,1,n0,n1,n2,n3) HLSL_SW4_B4(a,i,n2,2,n0,n1,n2,n3) HLSL_SW4_B4(a,i,n3,3,n0,n1,n2,n3)
+//成分数nのベクトルのスウィズル全部(2～4成分)
+#define HLSL_SWIZZLES(n,n0,n1,n2,n3) \
+	HLSL_EACH##n(HLSL_SW2_##n,n0,n1,n2,n3) \
+	HLSL_EACH##n(HLSL_SW3_##n,n0,n1,n2,n3) \
+	HLSL_EACH##n(HLSL_SW4_##n,n0,n1,n2,n3)
+
+	///成分数ごとのメンバ(x,y,z,w/r,g,b,aとスウィズル)
+	template<typename T, int N> struct VectorStorage;
+	template<typename T> struct VectorStorage<T, 2> {
+		static constexpr int N = 2;
+		union {
+			T v[2];
+			struct { T x, y; };
+			struct { T r, g; };
+			HLSL_SWIZZLES(2, x, y, _, _)
+			HLSL_SWIZZLES(2, r, g, _, _)
+		};
+	};
+	template<typename T> struct VectorStorage<T, 3> {
+		static constexpr int N = 3;
+		union {
+			T v[3];
+			struct { T x, y, z; };
+			struct { T r, g, b; };
+			HLSL_SWIZZLES(3, x, y, z, _)
+			HLSL_SWIZZLES(3, r, g, b, _)
+		};
+	};
+	template<typename T> struct VectorStorage<T, 4> {
+		static constexpr int N = 4;
+		union {
+			T v[4];
+			struct { T x, y, z, w; };
+			struct { T r, g, b, a; };
+			HLSL_SWIZZLES(4, x, y, z, w)
+			HLSL_SWIZZLES(4, r, g, b, a)
+		};
+	};
+
+#undef HLSL_SW2
+#undef HLSL_SW3
+#undef HLSL_SW4
+#undef HLSL_EACH2
+#undef HLSL_EACH3
+#undef HLSL_EACH4
+#undef HLSL_SW2_2
+#undef HLSL_SW2_3
+#undef HLSL_SW2_4
+#undef HLSL_SW3_2B
+#undef HLSL_SW3_3B
+#undef HLSL_SW3_4B
+#undef HLSL_SW3_2
+#undef HLSL_SW3_3
+#undef HLSL_SW3_4
+#undef HLSL_SW4_C2
+#undef HLSL_SW4_C3
+#undef HLSL_SW4_C4
+#undef HLSL_SW4_B2
+#undef HLSL_SW4_B3
+#undef HLSL_SW4_B4
+#undef HLSL_SW4_2
+#undef HLSL_SW4_3
+#undef HLSL_SW4_4
+#undef HLSL_SWIZZLES
+
+	///HLSLのベクトル型(float3やuint2など)
+	///メモリ上はT[N]と同じ(StructuredBufferの要素とそのままやり取りできる)
+	template<typename T, int N>
+	struct Vector : VectorStorage<T, N> {
+		using value_type = T;
+		static constexpr int size = N;
+		using VectorStorage<T, N>::v;
+
+		Vector() = default;
+		Vector(const Vector& o) {
+			for (int i = 0; i < N; ++i) { v[i] = o.v[i]; }
+		}
+		Vector& operator=(const Vector& o) {
+			for (int i = 0; i < N; ++i) { v[i] = o.v[i]; }
+			return *this;
+		}
+		///スカラーを全成分に広げる
+		Vector(T s) {
+			for (int i = 0; i < N; ++i) { v[i] = s; }
+		}
+		///float4(x,y,z,w)やfloat4(v.xyz,1)のように成分を並べて作る
+		template<typename... Args, typename = std::enable_if_t<(sizeof...(Args) >= 2)>>
+		Vector(const Args&... args) {
+			static_assert((detail::ComponentCount<Args>::value + ...) == N, "component count mismatch");
+			int k = 0;
+			(Append(k, args), ...);
+		}
+		///整数ベクトル→floatベクトルは暗黙に変換できる
+		template<typename U, std::enable_if_t<std::is_floating_point<T>::value && std::is_integral<U>::value, int> = 0>
+		Vector(const Vector<U, N>& o) {
+			for (int i = 0; i < N; ++i) { v[i] = static_cast<T>(o.v[i]); }
+		}
+		///それ以外の型変換はexplicit(float3→int3など)
+		template<typename U, std::enable_if_t<!std::is_same<T, U>::value && !(std::is_floating_point<T>::value && std::is_integral<U>::value), int> = 0>
+		explicit Vector(const Vector<U, N>& o) {
+			for (int i = 0; i < N; ++i) { v[i] = static_cast<T>(o.v[i]); }
+		}
+
+		T& operator[](int i) { return v[i]; }
+		const T& operator[](int i)const { return v[i]; }
+
+		Vector& operator+=(const Vector& o) { return *this = *this + o; }
+		Vector& operator-=(const Vector& o) { return *this = *this - o; }
+		Vector& operator*=(const Vector& o) { return *this = *this * o; }
+		Vector& operator/=(const Vector& o) { return *this = *this / o; }
+
+		//成分ごとの演算
+
+		friend Vector operator+(const Vector& a) { return a; }
+		friend Vector operator-(const Vector& a) { return Map([](T x) {return -x; }, a); }
+		friend Vector operator+(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x + y; }, a, b); }
+		friend Vector operator-(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x - y; }, a, b); }
+		friend Vector operator*(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x * y; }, a, b); }
+		friend Vector operator/(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x / y; }, a, b); }
+		friend Vector operator%(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x % y; }, a, b); }
+		friend Vector operator&(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x & y; }, a, b); }
+		friend Vector operator|(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x | y; }, a, b); }
+		friend Vector operator^(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x ^ y; }, a, b); }
+		friend Vector operator<<(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x << y; }, a, b); }
+		friend Vector operator>>(const Vector& a, const Vector& b) { return Map([](T x, T y) {return x >> y; }, a, b); }
+		friend Vector operator~(const Vector& a) { return Map([](T x) {return ~x; }, a); }
+
+		//比較は成分ごとのboolベクトルを返す(any/allで畳む)
+		friend Vector<bool, N> operator==(const Vector& a, const Vector& b) { return Compare([](T x, T y) {return x == y; }, a, b); }
+		friend Vector<bool, N> operator!=(const Vector& a, const Vector& b) { return Compare([](T x, T y) {return x != y; }, a, b); }
+		friend Vector<bool, N> operator<(const Vector& a, const Vector& b) { return Compare([](T x, T y) {return x < y; }, a, b); }
+		friend Vector<bool, N> operator<=(const Vector& a, const Vector& b) { return Compare([](T x, T y) {return x <= y; }, a, b); }
+		friend Vector<bool, N> operator>(const Vector& a, const Vector& b) { return Compare([](T x, T y) {return x > y; }, a, b); }
+		friend Vector<bool, N> operator>=(const Vector& a, const Vector& b) { return Compare([](T x, T y) {return x >= y; }, a, b); }
+		friend bool any(const Vector& a) {
+			bool r = false;
+			for (int i = 0; i < N; ++i) { r = r || a.v[i] != T(0); }
+			return r;
+		}
+		friend bool all(const Vector& a) {
+			bool r = true;
+			for (int i = 0; i < N; ++i) { r = r && a.v[i] != T(0); }
+			return r;
+		}
+		///HLSL 2021のselect(cond ? a : b の成分ごと版)
+		friend Vector select(const Vector<bool, N>& c, const Vector& a, const Vector& b) {
+			Vector r;
+			for (int i = 0; i < N; ++i) { r.v[i] = c.v[i] ? a.v[i] : b.v[i]; }
+			return r;
+		}
+
+		//組み込み関数(成分ごと)
+
+		friend Vector saturate(const Vector& a) { return Map([](T x) {return saturate(x); }, a); }
+		friend Vector abs(const Vector& a) { return Map([](T x) {return abs(x); }, a); }
+		friend Vector min(const Vector& a, const Vector& b) { return Map([](T x, T y) {return min(x, y); }, a, b); }
+		friend Vector max(const Vector& a, const Vector& b) { return Map([](T x, T y) {return max(x, y); }, a, b); }
+		friend Vector clamp(const Vector& x, const Vector& a, const Vector& b) { return min(max(x, a), b); }
+		friend Vector lerp(const Vector& a, const Vector& b, const Vector& t) { return a + (b - a) * t; }
+		friend Vector mad(const Vector& a, const Vector& b, const Vector& c) { return a * b + c; }
+		friend Vector step(const Vector& a, const Vector& x) { return Map([](T e, T y) {return step(e, y); }, a, x); }
+		friend Vector smoothstep(const Vector& a, const Vector& b, const Vector& x) {
+			Vector r;
+			for (int i = 0; i < N; ++i) { r.v[i] = smoothstep(a.v[i], b.v[i], x.v[i]); }
+			return r;
+		}
+		friend Vector sqrt(const Vector& a) { return Map([](T x) {return sqrt(x); }, a); }
+		friend Vector rsqrt(const Vector& a) { return Map([](T x) {return rsqrt(x); }, a); }
+		friend Vector rcp(const Vector& a) { return Map([](T x) {return rcp(x); }, a); }
+		friend Vector pow(const Vector& a, const Vector& b) { return Map([](T x, T y) {return pow(x, y); }, a, b); }
+		friend Vector exp(const Vector& a) { return Map([](T x) {return exp(x); }, a); }
+		friend Vector exp2(const Vector& a) { return Map([](T x) {return exp2(x); }, a); }
+		friend Vector log(const Vector& a) { return Map([](T x) {return log(x); }, a); }
+		friend Vector log2(const Vector& a) { return Map([](T x) {return log2(x); }, a); }
+		friend Vector log10(const Vector& a) { return Map([](T x) {return log10(x); }, a); }
+		friend Vector sin(const Vector& a) { return Map([](T x) {return sin(x); }, a); }
+		friend Vector cos(const Vector& a) { return Map([](T x) {return cos(x); }, a); }
+		friend Vector tan(const Vector& a) { return Map([](T x) {return tan(x); }, a); }
+		friend Vector atan2(const Vector& a, const Vector& b) { return Map([](T y, T x) {return atan2(y, x); }, a, b); }
+		friend Vector floor(const Vector& a) { return Map([](T x) {return floor(x); }, a); }
+		friend Vector ceil(const Vector& a) { return Map([](T x) {return ceil(x); }, a); }
+		friend Vector trunc(const Vector& a) { return Map([](T x) {return trunc(x); }, a); }
+		friend Vector round(const Vector& a) { return Map([](T x) {return round(x); }, a); }
+		friend Vector frac(const Vector& a) { return Map([](T x) {return frac(x); }, a); }
+		friend Vector fmod(const Vector& a, const Vector& b) { return Map([](T x, T y) {return fmod(x, y); }, a, b); }
+		friend Vector radians(const Vector& a) { return Map([](T x) {return radians(x); }, a); }
+		friend Vector degrees(const Vector& a) { return Map([](T x) {return degrees(x); }, a); }
+		friend Vector<int, N> sign(const Vector& a) {
+			Vector<int, N> r;
+			for (int i = 0; i < N; ++i) { r.v[i] = sign(a.v[i]); }
+			return r;
+		}
+		friend Vector<bool, N> isnan(const Vector& a) { return Compare([](T x, T) {return isnan(x); }, a, a); }
+		friend Vector<bool, N> isinf(const Vector& a) { return Compare([](T x, T) {return isinf(x); }, a, a); }
+		friend Vector<uint, N> asuint(const Vector& a) {
+			Vector<uint, N> r;
+			for (int i = 0; i < N; ++i) { r.v[i] = asuint(a.v[i]); }
+			return r;
+		}
+
+		//幾何関数
+
+		friend T dot(const Vector& a, const Vector& b) {
+			T r = a.v[0] * b.v[0];
+			for (int i = 1; i < N; ++i) { r += a.v[i] * b.v[i]; }
+			return r;
+		}
+		friend T length(const Vector& a) { return sqrt(dot(a, a)); }
+		friend T distance(const Vector& a, const Vector& b) { return length(b - a); }
+		friend Vector normalize(const Vector& a) { return a * rsqrt(dot(a, a)); }
+		///入射ベクトルiを法線nで反射する(i - 2*dot(i,n)*n)
+		friend Vector reflect(const Vector& i, const Vector& n) { return i - 2 * dot(i, n) * n; }
+		///入射ベクトルiを法線n、屈折率の比etaで屈折させる(全反射なら0)
+		friend Vector refract(const Vector& i, const Vector& n, T eta) {
+			auto cosi = dot(n, i);
+			auto k = 1 - eta * eta * (1 - cosi * cosi);
+			return k < 0 ? Vector(T(0)) : eta * i - (eta * cosi + sqrt(k)) * n;
+		}
+		friend Vector cross(const Vector& a, const Vector& b) {
+			static_assert(N == 3, "cross requires 3 components");
+			return Vector(a.v[1] * b.v[2] - a.v[2] * b.v[1], a.v[2] * b.v[0] - a.v[0] * b.v[2], a.v[0] * b.v[1] - a.v[1] * b.v[0]);
+		}
+		///mul(スカラー,ベクトル)/mul(ベクトル,ベクトル)(後者は内積)
+		friend Vector mul(T s, const Vector& a) { return s * a; }
+		friend Vector mul(const Vector& a, T s) { return a * s; }
+		friend T mul(const Vector& a, const Vector& b) { return dot(a, b); }
+
+	private:
+		template<typename F>
+		static Vector Map(F f, const Vector& a) {
+			Vector r;
+			for (int i = 0; i < N; ++i) { r.v[i] = f(a.v[i]); }
+			return r;
+		}
+		template<typename F>
+		static Vector Map(F f, const Vector& a, const Vector& b) {
+			Vector r;
+			for (int i = 0; i < N; ++i) { r.v[i] = f(a.v[i], b.v[i]); }
+			return r;
+		}
+		template<typename F>
+		static Vector<bool, N> Compare(F f, const Vector& a, const Vector& b) {
+			Vector<bool, N> r;
+			for (int i = 0; i < N; ++i) { r.v[i] = f(a.v[i], b.v[i]); }
+			return r;
+		}
+		template<typename U>
+		void Append(int& k, const U& s) {
+			v[k++] = static_cast<T>(s);
+		}
+		template<typename U, int M>
+		void Append(int& k, const Vector<U, M>& a) {
+			for (int i = 0; i < M; ++i) { v[k++] = static_cast<T>(a.v[i]); }
+		}
+		template<typename V, typename U, int M, int... I>
+		void Append(int& k, const Swizzle<V, U, M, I...>& s) {
+			Append(k, V(s));
+		}
+	};
+
+	namespace detail {
+		template<typename V, typename T, int N, int... I>
+		struct ComponentCount<Swizzle<V, T, N, I...>> { static constexpr int value = sizeof...(I); };
+	}
+
+	///HLSLの行列型(float4x4など)
+	///m[r]がr行目。mul(M,v)はvを列ベクトルとして扱う(HLSLと同じ)
+	///@remarks HLSLのcbufferは既定でcolumn_majorなので、そのまま送るならtransposeしておく
+	template<typename T, int R, int C>
+	struct Matrix {
+		Vector<T, C> m[R];
+
+		Matrix() = default;
+		///スカラーを全要素に広げる
+		explicit Matrix(T s) {
+			for (int r = 0; r < R; ++r) { m[r] = Vector<T, C>(s); }
+		}
+		///行ベクトルを並べて作る
+		template<typename... Rows, typename = std::enable_if_t<sizeof...(Rows) == R && (R > 1)>>
+		Matrix(const Rows&... rows) :m{ Vector<T, C>(rows)... } {}
+
+		Vector<T, C>& operator[](int r) { return m[r]; }
+		const Vector<T, C>& operator[](int r)const { return m[r]; }
+
+		friend Vector<T, R> mul(const Matrix& a, const Vector<T, C>& v) {
+			Vector<T, R> r;
+			for (int i = 0; i < R; ++i) { r[i] = dot(a.m[i], v); }
+			return r;
+		}
+		friend Vector<T, C> mul(const Vector<T, R>& v, const Matrix& a) {
+			Vector<T, C> r = v[0] * a.m[0];
+			for (int i = 1; i < R; ++i) { r += v[i] * a.m[i]; }
+			return r;
+		}
+		template<int K>
+		friend Matrix<T, R, K> mul(const Matrix& a, const Matrix<T, C, K>& b) {
+			Matrix<T, R, K> r;
+			for (int i = 0; i < R; ++i) { r.m[i] = mul(a.m[i], b); }
+			return r;
+		}
+		friend Matrix mul(T s, const Matrix& a) {
+			Matrix r;
+			for (int i = 0; i < R; ++i) { r.m[i] = s * a.m[i]; }
+			return r;
+		}
+		friend Matrix<T, C, R> transpose(const Matrix& a) {
+			Matrix<T, C, R> r;
+			for (int i = 0; i < R; ++i) {
+				for (int j = 0; j < C; ++j) { r.m[j][i] = a.m[i][j]; }
+			}
+			return r;
+		}
+	};
+
+	using float2 = Vector<float, 2>;
+	using float3 = Vector<float, 3>;
+	using float4 = Vector<float, 4>;
+	using int2 = Vector<int, 2>;
+	using int3 = Vector<int, 3>;
+	using int4 = Vector<int, 4>;
+	using uint2 = Vector<uint, 2>;
+	using uint3 = Vector<uint, 3>;
+	using uint4 = Vector<uint, 4>;
+	using bool2 = Vector<bool, 2>;
+	using bool3 = Vector<bool, 3>;
+	using bool4 = Vector<bool, 4>;
+	using float2x2 = Matrix<float, 2, 2>;
+	using float3x3 = Matrix<float, 3, 3>;
+	using float3x4 = Matrix<float, 3, 4>;
+	using float4x3 = Matrix<float, 4, 3>;
+	using float4x4 = Matrix<float, 4, 4>;
+	using matrix = float4x4;
+
+	static_assert(sizeof(float3) == 12 && sizeof(float4) == 16 && sizeof(uint3) == 12, "HLSL vectors must be tightly packed");
+	static_assert(std::is_standard_layout<float4>::value, "HLSL vectors must be standard layout");
+}
+
+#pragma pop_macro("max")
+#pragma pop_macro("min")
@@ -0,0 +1,191 @@
+﻿#include "Image.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace {
+	//ここから8bit→float
+	//UnpackUnorm4x8と同じ値にするため、255の逆数を掛けるのではなく255で割る
+
+	void UnpackRowScalar(const uint32_t* src, float* dst, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			auto px = src[i];
+			for (int c = 0; c < 4; ++c) {
+				dst[i * 4 + c] = static_cast<float>((px >> (c * 8)) & 0xff) / 255.0f;
+			}
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+	CPU_TARGET_SSE41 void UnpackRowSSE41(const uint32_t* src, float* dst, size_t count) {
+		const auto scale = _mm_set1_ps(255.0f);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_ps(dst + i * 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)), scale));
+			_mm_storeu_ps(dst + i * 4 + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 4))), scale));
+			_mm_storeu_ps(dst + i * 4 + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 8))), scale));
+			_mm_storeu_ps(dst + i * 4 + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 12))), scale));
+		}
+		UnpackRowScalar(src + i, dst + i * 4, count - i);
+	}
+
+	CPU_TARGET_AVX2 void UnpackRowAVX2(const uint32_t* src, float* dst, size_t count) {
+		const auto scale = _mm256_set1_ps(255.0f);
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2) {
+			auto v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+			_mm256_storeu_ps(dst + i * 4, _mm256_div_ps(_mm256_cvtepi32_ps(v), scale));
+		}
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		UnpackRowScalar(src + i, dst + i * 4, count - i);
+	}
+
+	CPU_TARGET_AVX512 void UnpackRowAVX512(const uint32_t* src, float* dst, size_t count) {
+		const auto scale = _mm512_set1_ps(255.0f);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto v = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+			_mm512_storeu_ps(dst + i * 4, _mm512_div_ps(_mm512_cvtepi32_ps(v), scale));
+		}
+		_mm256_zeroupper();
+		UnpackRowScalar(src + i, dst + i * 4, count - i);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	void UnpackRowNEON(const uint32_t* src, float* dst, size_t count) {
+		const auto scale = vdupq_n_f32(255.0f);
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2) {
+			auto v = vmovl_u8(vld1_u8(reinterpret_cast<const uint8_t*>(src + i)));
+			vst1q_f32(dst + i * 4, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), scale));
+			vst1q_f32(dst + i * 4 + 4, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), scale));
+		}
+		UnpackRowScalar(src + i, dst + i * 4, count - i);
+	}
+#endif
+
+	using UnpackRowFunc = void(*)(const uint32_t* src, float* dst, size_t count);
+	Kernel<UnpackRowFunc> unpackRow("unpack8", {
+		{ CpuIsa::Scalar, UnpackRowScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, UnpackRowSSE41 },
+		{ CpuIsa::AVX2, UnpackRowAVX2 },
+		{ CpuIsa::AVX512, UnpackRowAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, UnpackRowNEON },
+#endif
+	});
+
+	//ここからfloat→8bit
+	//saturate(NaNは0)して255倍し、0.5を足して切り捨てる(PackUnorm4x8と同じ値になるよう、積和はFMAにしない)
+
+	void PackRowScalar(const float* src, uint32_t* dst, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t px = 0;
+			for (int c = 0; c < 4; ++c) {
+				px |= static_cast<uint32_t>(hlsl::saturate(src[i * 4 + c]) * 255.0f + 0.5f) << (c * 8);
+			}
+			dst[i] = px;
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+	//maxの第2オペランドを0にしておくと、NaNは0になる
+	//(target属性はラムダ式に引き継がれないので、変換は関数にしておく)
+	CPU_TARGET_SSE41 inline __m128i ToUnorm8SSE41(const float* p) {
+		auto v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+	}
+
+	CPU_TARGET_SSE41 void PackRowSSE41(const float* src, uint32_t* dst, size_t count) {
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto a = _mm_packus_epi32(ToUnorm8SSE41(src + i * 4), ToUnorm8SSE41(src + i * 4 + 4));
+			auto b = _mm_packus_epi32(ToUnorm8SSE41(src + i * 4 + 8), ToUnorm8SSE41(src + i * 4 + 12));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+		}
+		PackRowScalar(src + i * 4, dst + i, count - i);
+	}
+
+	CPU_TARGET_AVX2 inline __m256i ToUnorm8AVX2(const float* p) {
+		auto v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(p), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+		return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+	}
+
+	CPU_TARGET_AVX2 void PackRowAVX2(const float* src, uint32_t* dst, size_t count) {
+		//packusは128bitレーンごとに詰めるので、最後に並びを戻す
+		const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			auto a = _mm256_packus_epi32(ToUnorm8AVX2(src + i * 4), ToUnorm8AVX2(src + i * 4 + 8));
+			auto b = _mm256_packus_epi32(ToUnorm8AVX2(src + i * 4 + 16), ToUnorm8AVX2(src + i * 4 + 24));
+			auto packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(a, b), order);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+		}
+		_mm256_zeroupper();
+		PackRowScalar(src + i * 4, dst + i, count - i);
+	}
+
+	CPU_TARGET_AVX512 void PackRowAVX512(const float* src, uint32_t* dst, size_t count) {
+		const auto zero = _mm512_setzero_ps();
+		const auto one = _mm512_set1_ps(1.0f);
+		const auto scale = _mm512_set1_ps(255.0f);
+		const auto half = _mm512_set1_ps(0.5f);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto v = _mm512_min_ps(_mm512_max_ps(_mm512_loadu_ps(src + i * 4), zero), one);
+			auto n = _mm512_cvttps_epi32(_mm512_add_ps(_mm512_mul_ps(v, scale), half));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm512_cvtepi32_epi8(n));
+		}
+		_mm256_zeroupper();
+		PackRowScalar(src + i * 4, dst + i, count - i);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	inline uint16x4_t ToUnorm8NEON(const float* p) {
+		//vmaxnmqは片方がNaNならもう片方を返す
+		auto v = vminq_f32(vmaxnmq_f32(vld1q_f32(p), vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+		return vmovn_u32(vcvtq_u32_f32(vaddq_f32(vmulq_n_f32(v, 255.0f), vdupq_n_f32(0.5f))));
+	}
+
+	void PackRowNEON(const float* src, uint32_t* dst, size_t count) {
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2) {
+			auto bytes = vmovn_u16(vcombine_u16(ToUnorm8NEON(src + i * 4), ToUnorm8NEON(src + i * 4 + 4)));
+			vst1_u8(reinterpret_cast<uint8_t*>(dst + i), bytes);
+		}
+		PackRowScalar(src + i * 4, dst + i, count - i);
+	}
+#endif
+
+	using PackRowFunc = void(*)(const float* src, uint32_t* dst, size_t count);
+	Kernel<PackRowFunc> packRow("pack8", {
+		{ CpuIsa::Scalar, PackRowScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, PackRowSSE41 },
+		{ CpuIsa::AVX2, PackRowAVX2 },
+		{ CpuIsa::AVX512, PackRowAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, PackRowNEON },
+#endif
+	});
+}
+
+void
+UnpackUnorm4x8Row(const uint32_t* src, float* dst, size_t count) {
+	unpackRow.Get()(src, dst, count);
+}
+
+void
+PackUnorm4x8Row(const float* src, uint32_t* dst, size_t count) {
+	packRow.Get()(src, dst, count);
+}
@@ -0,0 +1,54 @@
+﻿#pragma once
+#include<vector>
+#include<cstdint>
+#include<cstddef>
+#include"HlslTypes.h"
+
+///CPU側の2D画像(Texture2D/RWTexture2Dの代わり)
+///行の間に詰め物はなく、pixels[y * width + x]で並ぶ
+template<typename T>
+struct Image {
+	unsigned int width = 0;
+	unsigned int height = 0;
+	std::vector<T> pixels;
+
+	Image() = default;
+	Image(unsigned int w, unsigned int h) :width(w), height(h), pixels(static_cast<size_t>(w) * h) {}
+
+	T* Row(unsigned int y) { return pixels.data() + static_cast<size_t>(y) * width; }
+	const T* Row(unsigned int y)const { return pixels.data() + static_cast<size_t>(y) * width; }
+	T& At(unsigned int x, unsigned int y) { return pixels[static_cast<size_t>(y) * width + x]; }
+	const T& At(unsigned int x, unsigned int y)const { return pixels[static_cast<size_t>(y) * width + x]; }
+};
+
+///DXGI_FORMAT_R8G8B8A8_UNORMの画像(1画素32bit、下位バイトからR,G,B,A)
+using ImageRGBA8 = Image<uint32_t>;
+
+///DXGI_FORMAT_R32G32B32A32_FLOATの画像
+using ImageRGBA32F = Image<hlsl::float4>;
+
+///R8G8B8A8_UNORMの1画素をfloat4にする(Texture2D<float4>の読み出しと同じ)
+inline hlsl::float4 UnpackUnorm4x8(uint32_t px) {
+	return hlsl::float4(px & 0xff, (px >> 8) & 0xff, (px >> 16) & 0xff, px >> 24) / 255.0f;
+}
+
+///float4をR8G8B8A8_UNORMにする(RWTexture2D<float4>への書き込みと同じくsaturateして最近接に丸める)
+inline uint32_t PackUnorm4x8(const hlsl::float4& c) {
+	uint32_t px = 0;
+	for (int i = 0; i < 4; ++i) {
+		px |= static_cast<uint32_t>(hlsl::saturate(c[i]) * 255.0f + 0.5f) << (i * 8);
+	}
+	return px;
+}
+
+///R8G8B8A8_UNORMの行をfloatの並び(画素ごとにRGBA)にする(UnpackUnorm4x8と同じ値)
+///@param src 入力(count画素)
+///@param dst 出力(count*4個)
+///@remarks 実装はKernelRegistryの"unpack8"で選ばれる
+void UnpackUnorm4x8Row(const uint32_t* src, float* dst, size_t count);
+
+///floatの並び(画素ごとにRGBA)をR8G8B8A8_UNORMの行にする(PackUnorm4x8と同じ値)
+///@param src 入力(count*4個)
+///@param dst 出力(count画素)
+///@remarks 実装はKernelRegistryの"pack8"で選ばれる
+void PackUnorm4x8Row(const float* src, uint32_t* dst, size_t count);
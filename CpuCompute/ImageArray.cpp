@@ -0,0 +1,90 @@
+﻿#include "ImageArray.h"
+#include<algorithm>
+#include<cassert>
+#include"ComputeExecutor.h"
+
+using namespace std;
+
+namespace {
+	//並列化するときに1回に取るスライスの画素数の目安(小さい画像はいくつかまとめて取る)
+	constexpr size_t copyGrainPixels = 64 * 1024;
+
+	size_t SliceGrain(const ImageArrayRGBA8& array) {
+		const size_t slicePixels = max<size_t>(static_cast<size_t>(array.width) * array.height, 1);
+		return max<size_t>(1, copyGrainPixels / slicePixels);
+	}
+}
+
+void
+PackImageArray(const vector<const ImageRGBA8*>& images, ImageArrayRGBA8& array, ComputeExecutor* executor) {
+	assert(!images.empty());
+	array.width = 0;
+	array.height = 0;
+	array.sizes.resize(images.size());
+	for (size_t i = 0; i < images.size(); ++i) {
+		array.sizes[i] = { images[i]->width, images[i]->height };
+		array.width = max(array.width, images[i]->width);
+		array.height = max(array.height, images[i]->height);
+	}
+	array.pixels.resize(static_cast<size_t>(array.width) * array.height * images.size());
+	auto packSlices = [&](size_t begin, size_t end) {
+		for (auto s = begin; s < end; ++s) {
+			const auto slice = static_cast<unsigned int>(s);
+			const auto& image = *images[s];
+			if (image.width == array.width) {
+				//幅がそろっていれば行がつながっているので1回でコピーする
+				copy(image.pixels.begin(), image.pixels.end(), array.Row(slice, 0));
+				fill(array.Row(slice, image.height), array.Row(slice, 0) + static_cast<size_t>(array.width) * array.height, 0u);
+				continue;
+			}
+			for (unsigned int y = 0; y < array.height; ++y) {
+				auto row = array.Row(slice, y);
+				const unsigned int copied = y < image.height ? image.width : 0;
+				copy_n(image.Row(min(y, image.height - 1)), copied, row);
+				fill(row + copied, row + array.width, 0u);
+			}
+		}
+	};
+	if (executor != nullptr) {
+		executor->ParallelFor(images.size(), SliceGrain(array), packSlices);
+	}
+	else {
+		packSlices(0, images.size());
+	}
+}
+
+void
+UnpackImageArray(const ImageArrayRGBA8& array, vector<ImageRGBA8>& images, ComputeExecutor* executor) {
+	images.resize(array.SliceCount());
+	auto unpackSlices = [&](size_t begin, size_t end) {
+		for (auto s = begin; s < end; ++s) {
+			const auto slice = static_cast<unsigned int>(s);
+			const auto size = array.sizes[s];
+			auto& image = images[s];
+			if (image.width != size.x || image.height != size.y) {
+				image = ImageRGBA8(size.x, size.y);
+			}
+			if (size.x == array.width) {
+				copy_n(array.Row(slice, 0), image.pixels.size(), image.pixels.data());
+				continue;
+			}
+			for (unsigned int y = 0; y < size.y; ++y) {
+				copy_n(array.Row(slice, y), size.x, image.Row(y));
+			}
+		}
+	};
+	if (executor != nullptr) {
+		executor->ParallelFor(images.size(), SliceGrain(array), unpackSlices);
+	}
+	else {
+		unpackSlices(0, images.size());
+	}
+}
+
+void
+ResizeImageArrayLike(const ImageArrayRGBA8& src, ImageArrayRGBA8& dst) {
+	dst.width = src.width;
+	dst.height = src.height;
+	dst.sizes = src.sizes;
+	dst.pixels.resize(src.pixels.size());
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+#include<vector>
+#include<cstdint>
+#include"Image.h"
+
+class ComputeExecutor;
+
+//大きさのばらばらな小さい画像を1つにまとめたもの(Texture2DArrayのCPU版)
+//どのスライスも同じ大きさ(画像の最大)で、画像はスライスの左上に置き、スライスごとの画像の大きさを表で持つ。
+//まとめた配列を1回のParallelFor(GPUなら1回のDispatch)で処理し、画像ごとに取り出す(TextureFilter/MonoBatch.hのCPU版。GPU版はスライスの代わりにアトラスに棚詰めする)
+
+///画像の配列(スライスの中も行の間に詰め物はなく、pixels[(slice * height + y) * width + x]で並ぶ)
+template<typename T>
+struct ImageArray {
+	unsigned int width = 0;//スライスの大きさ
+	unsigned int height = 0;
+	std::vector<hlsl::uint2> sizes;//スライスごとの画像の大きさ(MonoArrayCSのimageRectsの幅と高さにあたる)
+	std::vector<T> pixels;
+
+	unsigned int SliceCount()const { return static_cast<unsigned int>(sizes.size()); }
+	T* Row(unsigned int slice, unsigned int y) { return pixels.data() + (static_cast<size_t>(slice) * height + y) * width; }
+	const T* Row(unsigned int slice, unsigned int y)const { return pixels.data() + (static_cast<size_t>(slice) * height + y) * width; }
+};
+
+using ImageArrayRGBA8 = ImageArray<uint32_t>;
+
+///画像を配列にまとめる(スライスの大きさは画像の幅と高さの最大。詰め物のところは0)
+///@param images 入力(1枚以上)
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+void PackImageArray(const std::vector<const ImageRGBA8*>& images, ImageArrayRGBA8& array, ComputeExecutor* executor);
+
+///配列から画像を取り出す(images[i]はsizes[i]の大きさにされる)
+void UnpackImageArray(const ImageArrayRGBA8& array, std::vector<ImageRGBA8>& images, ComputeExecutor* executor);
+
+///配列のdstをsrcと同じ大きさ・同じスライスの表にする(中身は変えない)
+void ResizeImageArrayLike(const ImageArrayRGBA8& src, ImageArrayRGBA8& dst);
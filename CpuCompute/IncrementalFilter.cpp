@@ -0,0 +1,208 @@
+﻿#include "IncrementalFilter.h"
+#include<algorithm>
+#include<cassert>
+#include<cstring>
+#include"ComputeExecutor.h"
+
+using namespace std;
+using hlsl::float4;
+
+namespace {
+	//切り出した大きさごとのランナーをこれより多く持たない(動くモデルで大きさがばらばらになっても増え続けないように)
+	constexpr size_t maxRegionRunners = 16;
+
+	void CopyRect(const ImageRGBA32F& src, unsigned int srcX, unsigned int srcY, ImageRGBA32F& dst, unsigned int dstX, unsigned int dstY, unsigned int width, unsigned int height) {
+		for (unsigned int y = 0; y < height; ++y) {
+			copy_n(src.Row(srcY + y) + srcX, width, dst.Row(dstY + y) + dstX);
+		}
+	}
+}
+
+uint64_t
+HashImageTile(const ImageRGBA32F& image, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1) {
+	assert(x0 <= x1 && x1 <= image.width && y0 <= y1 && y1 <= image.height);
+	//FNV-1aを8バイトずつ、画素の前半(RG)と後半(BA)の2本に分けて回す(掛け算の待ちが重ならないように)
+	constexpr uint64_t prime = 0x100000001b3ull;
+	uint64_t lanes[2] = { 0xcbf29ce484222325ull, 0x9e3779b97f4a7c15ull };
+	for (auto y = y0; y < y1; ++y) {
+		const auto* row = reinterpret_cast<const unsigned char*>(image.Row(y) + x0);
+		for (auto x = x0; x < x1; ++x, row += sizeof(float4)) {
+			uint64_t words[2];
+			memcpy(words, row, sizeof(words));
+			lanes[0] = (lanes[0] ^ words[0]) * prime;
+			lanes[1] = (lanes[1] ^ words[1]) * prime;
+		}
+	}
+	return (lanes[0] ^ (lanes[1] >> 29) ^ (lanes[1] << 35)) * prime;
+}
+
+IncrementalFilterRunner::IncrementalFilterRunner(const FilterGraph& graph, unsigned int tileSize) :
+	graph_(graph), tileSize_(tileSize), full_(graph) {
+	const auto& source = graph_.Node(filterSource);
+	width_ = source.width;
+	height_ = source.height;
+	assert(tileSize_ > 0 && full_.Plan().width == width_ && full_.Plan().height == height_);
+	columns_ = (width_ + tileSize_ - 1) / tileSize_;
+	rows_ = (height_ + tileSize_ - 1) / tileSize_;
+	local_ = graph_.Reach(halo_);
+	if (!local_) {
+		halo_ = 0;
+	}
+	hashes_.resize(static_cast<size_t>(columns_) * rows_);
+	nextHashes_.resize(hashes_.size());
+	recompute_.resize(hashes_.size());
+}
+
+void
+IncrementalFilterRunner::HashTiles(const ImageRGBA32F& src, ComputeExecutor* executor) {
+	auto hashRows = [&](size_t r0, size_t r1) {
+		for (auto r = r0; r < r1; ++r) {
+			const auto ty = static_cast<unsigned int>(r);
+			const unsigned int y0 = ty * tileSize_;
+			const unsigned int y1 = min(y0 + tileSize_, height_);
+			for (unsigned int tx = 0; tx < columns_; ++tx) {
+				const unsigned int x0 = tx * tileSize_;
+				const unsigned int x1 = min(x0 + tileSize_, width_);
+				uint64_t hash = HashImageTile(src, x0, y0, x1, y1);
+				if (geometry_ != nullptr) {
+					hash ^= HashImageTile(*geometry_, x0, y0, x1, y1) * 0x9e3779b97f4a7c15ull;
+				}
+				nextHashes_[static_cast<size_t>(ty) * columns_ + tx] = hash;
+			}
+		}
+	};
+	if (executor != nullptr) {
+		executor->ParallelFor(rows_, 1, hashRows);
+	}
+	else {
+		hashRows(0, rows_);
+	}
+}
+
+void
+IncrementalFilterRunner::MergeRegions(vector<TileRect>& regions)const {
+	//行ごとに横に続くタイルをまとめ、1つ上の行に同じ幅の矩形があれば縦に伸ばす
+	regions.clear();
+	for (unsigned int ty = 0; ty < rows_; ++ty) {
+		const uint8_t* row = &recompute_[static_cast<size_t>(ty) * columns_];
+		for (unsigned int tx = 0; tx < columns_;) {
+			if (!row[tx]) {
+				++tx;
+				continue;
+			}
+			const unsigned int x0 = tx;
+			while (tx < columns_ && row[tx]) {
+				++tx;
+			}
+			auto it = find_if(regions.begin(), regions.end(), [&](const TileRect& r) {return r.y1 == ty && r.x0 == x0 && r.x1 == tx; });
+			if (it != regions.end()) {
+				it->y1 = ty + 1;
+			}
+			else {
+				regions.push_back({ x0, ty, tx, ty + 1 });
+			}
+		}
+	}
+}
+
+void
+IncrementalFilterRunner::RunRegion(const ImageRGBA32F& src, const TileRect& region, ComputeExecutor* executor) {
+	//書き戻す範囲と、それに読む範囲を足して切り出す範囲(画像の端では切り出しも端で止まるので、端の扱いは全体と同じ)
+	const unsigned int x0 = region.x0 * tileSize_;
+	const unsigned int y0 = region.y0 * tileSize_;
+	const unsigned int x1 = min(region.x1 * tileSize_, width_);
+	const unsigned int y1 = min(region.y1 * tileSize_, height_);
+	const unsigned int cx0 = x0 - min(halo_, x0);
+	const unsigned int cy0 = y0 - min(halo_, y0);
+	const unsigned int cx1 = min(x1 + halo_, width_);
+	const unsigned int cy1 = min(y1 + halo_, height_);
+	const unsigned int cw = cx1 - cx0;
+	const unsigned int ch = cy1 - cy0;
+
+	auto& runner = regionRunners_[make_pair(cw, ch)];
+	if (runner == nullptr) {
+		if (regionRunners_.size() > maxRegionRunners) {
+			regionRunners_.clear();
+			return RunRegion(src, region, executor);
+		}
+		runner.reset(new CpuFilterGraphRunner(graph_.Resized(cw, ch)));
+	}
+	regionSource_ = ImageRGBA32F(cw, ch);
+	CopyRect(src, cx0, cy0, regionSource_, 0, 0, cw, ch);
+	if (geometry_ != nullptr) {
+		regionGeometry_ = ImageRGBA32F(cw, ch);
+		CopyRect(*geometry_, cx0, cy0, regionGeometry_, 0, 0, cw, ch);
+		runner->SetGeometry(&regionGeometry_);
+	}
+	else {
+		runner->SetGeometry(nullptr);
+	}
+	runner->Run(regionSource_, regionOutput_, executor);
+	CopyRect(regionOutput_, x0 - cx0, y0 - cy0, output_, x0, y0, x1 - x0, y1 - y0);
+	++stats_.regions;
+	stats_.processedPixels += static_cast<uint64_t>(cw) * ch;
+}
+
+const ImageRGBA32F&
+IncrementalFilterRunner::Run(const ImageRGBA32F& src, ComputeExecutor* executor) {
+	assert(src.width == width_ && src.height == height_);
+	assert(geometry_ == nullptr || (geometry_->width == width_ && geometry_->height == height_));
+	const auto tileCount = static_cast<uint64_t>(columns_) * rows_;
+	++stats_.frames;
+	stats_.tiles += tileCount;
+	auto runFull = [&]() {
+		full_.SetGeometry(geometry_);
+		full_.Run(src, output_, executor);
+		++stats_.fullFrames;
+		++stats_.regions;
+		stats_.recomputedTiles += tileCount;
+		stats_.processedPixels += static_cast<uint64_t>(width_) * height_;
+	};
+	if (!local_) {
+		stats_.changedTiles += tileCount;
+		runFull();
+		return output_;
+	}
+
+	HashTiles(src, executor);
+	if (!valid_) {
+		stats_.changedTiles += tileCount;
+		runFull();
+		hashes_.swap(nextHashes_);
+		valid_ = true;
+		return output_;
+	}
+
+	//変わったタイルから、読む範囲にかかるタイルに広げる
+	const int spread = static_cast<int>((halo_ + tileSize_ - 1) / tileSize_);
+	fill(recompute_.begin(), recompute_.end(), static_cast<uint8_t>(0));
+	for (unsigned int ty = 0; ty < rows_; ++ty) {
+		for (unsigned int tx = 0; tx < columns_; ++tx) {
+			const size_t t = static_cast<size_t>(ty) * columns_ + tx;
+			if (hashes_[t] == nextHashes_[t]) {
+				continue;
+			}
+			++stats_.changedTiles;
+			const unsigned int nx0 = static_cast<unsigned int>(max(static_cast<int>(tx) - spread, 0));
+			const unsigned int ny0 = static_cast<unsigned int>(max(static_cast<int>(ty) - spread, 0));
+			const unsigned int nx1 = min(tx + spread + 1, columns_);
+			const unsigned int ny1 = min(ty + spread + 1, rows_);
+			for (auto ny = ny0; ny < ny1; ++ny) {
+				fill_n(&recompute_[static_cast<size_t>(ny) * columns_ + nx0], nx1 - nx0, static_cast<uint8_t>(1));
+			}
+		}
+	}
+	hashes_.swap(nextHashes_);
+	const auto recomputed = static_cast<uint64_t>(count(recompute_.begin(), recompute_.end(), static_cast<uint8_t>(1)));
+	if (recomputed == tileCount) {
+		runFull();
+		return output_;
+	}
+	stats_.recomputedTiles += recomputed;
+	vector<TileRect> regions;
+	MergeRegions(regions);
+	for (auto& region : regions) {
+		RunRegion(src, region, executor);
+	}
+	return output_;
+}
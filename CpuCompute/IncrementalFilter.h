@@ -0,0 +1,101 @@
+﻿#pragma once
+#include<vector>
+#include<map>
+#include<memory>
+#include<utility>
+#include<cstdint>
+#include"FilterGraph.h"
+#include"FilterGraphRunner.h"
+#include"Image.h"
+
+class ComputeExecutor;
+
+//変わったタイルだけを処理し直すフィルタグラフの実行(背景が止まっていて、モデルだけが動くフレーム向け)
+//  1.入力(とジオメトリ画像)をタイルに分けてハッシュを取り、前のフレームと違うタイルを探す
+//  2.変わったタイルを、グラフが読む範囲(FilterGraph::Reach)だけ広げたものを処理し直すタイルにする
+//  3.処理し直すタイルを横に続くもの・同じ幅で縦に続くものでまとめた矩形ごとに、読む範囲を足して切り出してグラフを実行し、
+//    矩形の中だけを前のフレームの出力に書き戻す(切り出した端から読む範囲より内側なので、画像全体で実行したのと同じになる)
+//それ以外のタイルは前のフレームの出力をそのまま使う。
+//Reachがfalseのグラフ(Bloom・ToneMapなど画像全体を読むもの)は、毎フレーム全体を処理する
+
+///IncrementalFilterRunnerの統計(Runの回数を重ねて数える)
+struct IncrementalFilterStats {
+	uint64_t frames = 0;
+	uint64_t tiles = 0;//見たタイルの合計(フレームごとのタイルの数×frames)
+	uint64_t changedTiles = 0;//入力かジオメトリ画像が変わったタイル(全体を処理したフレームは全部と数える)
+	uint64_t recomputedTiles = 0;//処理し直したタイル(変わったタイルと、そこを読むタイル)
+	uint64_t fullFrames = 0;//全体を処理したフレーム(最初のフレーム・Invalidateの後・局所でないグラフ)
+	uint64_t regions = 0;//グラフを実行した矩形の数
+	uint64_t processedPixels = 0;//グラフを実行した画素の数(読む範囲を足した分も含む)
+
+	///処理し直したタイルの割合(0～1)
+	double RecomputedFraction()const { return tiles > 0 ? static_cast<double>(recomputedTiles) / tiles : 0.0; }
+};
+
+///変わったタイルだけを処理し直すフィルタグラフの実行(CPU)
+///出力は中に持ち、Runのたびに変わったところだけを書き換える
+class IncrementalFilterRunner {
+public:
+	///@param graph 実行するグラフ(出力は入力と同じ大きさであること)
+	///@param tileSize タイルの一辺(画素)。小さいほど処理し直す画素は減るが、矩形の数(切り出しと読む範囲の分)が増える
+	explicit IncrementalFilterRunner(const FilterGraph& graph, unsigned int tileSize = 32);
+
+	///Outlineのノードが読むジオメトリ画像(グラフの入力と同じ大きさ。入力と同じく変わったタイルを調べる)
+	void SetGeometry(const ImageRGBA32F* geometry) { geometry_ = geometry; }
+
+	///1フレーム分を処理する
+	///@param src 入力画像(グラフの入力と同じ大きさ)
+	///@param executor nullptrなら呼び出しスレッドだけで処理する
+	///@return 出力(次のRunまで有効)
+	const ImageRGBA32F& Run(const ImageRGBA32F& src, ComputeExecutor* executor);
+
+	///前の出力を捨てる(次のRunは全体を処理する。グラフの外で出力を変えたときなど)
+	void Invalidate() { valid_ = false; }
+
+	const ImageRGBA32F& Output()const { return output_; }
+	///グラフが読む範囲(画素)。局所でなければ0
+	unsigned int Halo()const { return halo_; }
+	///タイルごとに処理し直せるグラフか
+	bool IsLocal()const { return local_; }
+	unsigned int TileSize()const { return tileSize_; }
+	unsigned int TileColumns()const { return columns_; }
+	unsigned int TileRows()const { return rows_; }
+
+	const IncrementalFilterStats& Stats()const { return stats_; }
+	void ResetStats() { stats_ = IncrementalFilterStats(); }
+
+private:
+	//タイル単位の矩形([x0,x1)×[y0,y1))
+	struct TileRect {
+		unsigned int x0, y0, x1, y1;
+	};
+
+	FilterGraph graph_;
+	unsigned int width_;
+	unsigned int height_;
+	unsigned int tileSize_;
+	unsigned int columns_;
+	unsigned int rows_;
+	unsigned int halo_ = 0;
+	bool local_ = false;
+	bool valid_ = false;
+	const ImageRGBA32F* geometry_ = nullptr;
+	CpuFilterGraphRunner full_;
+	std::map<std::pair<unsigned int, unsigned int>, std::unique_ptr<CpuFilterGraphRunner>> regionRunners_;//切り出した大きさごと
+	std::vector<uint64_t> hashes_;//前のフレームのタイルのハッシュ
+	std::vector<uint64_t> nextHashes_;
+	std::vector<uint8_t> recompute_;//タイルごとの処理し直すか
+	ImageRGBA32F output_;
+	ImageRGBA32F regionSource_;//切り出した入力
+	ImageRGBA32F regionGeometry_;//切り出したジオメトリ画像
+	ImageRGBA32F regionOutput_;
+	IncrementalFilterStats stats_;
+
+	void HashTiles(const ImageRGBA32F& src, ComputeExecutor* executor);
+	void MergeRegions(std::vector<TileRect>& regions)const;
+	void RunRegion(const ImageRGBA32F& src, const TileRect& region, ComputeExecutor* executor);
+};
+
+///タイルのハッシュ(画素の値のビット列から。一致すれば変わっていないとみなす)
+///@param x0,y0,x1,y1 タイルの範囲([x0,x1)×[y0,y1))
+uint64_t HashImageTile(const ImageRGBA32F& image, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
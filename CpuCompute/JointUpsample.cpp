@@ -0,0 +1,471 @@
+﻿#include "JointUpsample.h"
+#include<algorithm>
+#include<cassert>
+#include<cmath>
+#include<vector>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+//シェーダと同じ重み
+namespace hlsl {
+	namespace {
+#include"JointUpsample.hlsli"
+	}
+}
+
+using namespace std;
+using hlsl::float4;
+using hlsl::JointUpsampleAccumulator;
+
+namespace {
+	//並列化するときの1回に取る行数
+	constexpr size_t upsampleGrainRows = 8;
+
+	void PrepareOutput(const ImageRGBA32F& low, const ImageRGBA32F& lowGuide, const ImageRGBA32F& guide, const ImageRGBA32F* geometry,
+		ImageRGBA32F& dst, const JointUpsampleSettings& settings) {
+		assert(low.width == lowGuide.width && low.height == lowGuide.height && low.width > 0 && low.height > 0);
+		assert(settings.radius >= 1 && settings.radius <= maxJointUpsampleRadius && settings.lumaSigma > 0.0f);
+		assert(settings.depthSigma == 0.0f || (geometry != nullptr && geometry->width == guide.width && geometry->height == guide.height));
+		assert(&dst != &low && &dst != &lowGuide && &dst != &guide);
+		dst.width = guide.width;
+		dst.height = guide.height;
+		dst.pixels.resize(guide.pixels.size());
+	}
+
+	//1方向のタップ(出力の画素iは、縮小した画像のindex[k*size+i]にweight[k*size+i]を掛ける)
+	//タップごとに並べて、隣り合う出力の画素のタップをまとめて読めるようにする
+	struct UpsampleAxis {
+		unsigned int taps = 0;
+		vector<unsigned int> index;//画像の外は端に寄せてある
+		vector<float> weight;
+	};
+
+	UpsampleAxis MakeUpsampleAxis(unsigned int size, unsigned int lowSize, unsigned int radius) {
+		UpsampleAxis axis;
+		axis.taps = radius * 2;
+		axis.index.resize(static_cast<size_t>(size) * axis.taps);
+		axis.weight.resize(axis.index.size());
+		for (unsigned int i = 0; i < size; ++i) {
+			const float u = hlsl::JointUpsamplePosition(i, size, lowSize);
+			const int first = static_cast<int>(floor(u)) - static_cast<int>(radius) + 1;
+			for (unsigned int k = 0; k < axis.taps; ++k) {
+				const int q = first + static_cast<int>(k);
+				axis.index[k * size + i] = static_cast<unsigned int>(clamp(q, 0, static_cast<int>(lowSize) - 1));
+				axis.weight[k * size + i] = hlsl::JointUpsampleTent(static_cast<float>(q) - u, static_cast<float>(radius));
+			}
+		}
+		return axis;
+	}
+
+	//出力の1行ぶんの入力(JointUpsampleRowFuncに渡す)
+	struct JointUpsampleRow {
+		const float4* guide;//縮小前の手がかりの行
+		const float4* geometry;//ジオメトリ画像の行(深度を使わなければnullptr)
+		float4* dst;
+		unsigned int width;//出力の幅
+		unsigned int taps;//縦横のタップ数
+		const float4* low[2 * maxJointUpsampleRadius];//縦のタップjの、縮小した画像の行
+		const float* lowLuma[2 * maxJointUpsampleRadius];//同じ行の、縮小した手がかりの輝度
+		const float* lowDepth[2 * maxJointUpsampleRadius];//同じ行の深度(深度を使わなければnullptr)
+		float yWeight[2 * maxJointUpsampleRadius];
+		const unsigned int* xIndex;//横のタップ(タップkの出力の画素xは[k*width+x])
+		const float* xWeight;
+		float invLumaSigma;
+		float depthSigma;
+	};
+
+	//出力の画素x0～x1を1画素ずつ(基準実装と同じ順に足す)
+	void JointUpsamplePixels(const JointUpsampleRow& row, unsigned int x0, unsigned int x1) {
+		const bool useDepth = row.geometry != nullptr;
+		for (unsigned int x = x0; x < x1; ++x) {
+			const float luma = hlsl::GuideLuma(row.guide[x]);
+			const float depth = useDepth ? row.geometry[x].z : 0.0f;
+			const float depthScale = useDepth ? hlsl::JointUpsampleDepthScale(depth, row.depthSigma) : 0.0f;
+			JointUpsampleAccumulator acc = {};
+			for (unsigned int j = 0; j < row.taps; ++j) {
+				for (unsigned int i = 0; i < row.taps; ++i) {
+					const unsigned int q = row.xIndex[i * row.width + x];
+					const float depthT = useDepth ? (row.lowDepth[j][q] - depth) * depthScale : 0.0f;
+					const float range = hlsl::JointUpsampleRange((row.lowLuma[j][q] - luma) * row.invLumaSigma, depthT);
+					acc = hlsl::AccumulateJointUpsample(acc, row.low[j][q], row.yWeight[j] * row.xWeight[i * row.width + x] * range);
+				}
+			}
+			row.dst[x] = hlsl::ResolveJointUpsample(acc);
+		}
+	}
+
+	void JointUpsampleRowScalar(const JointUpsampleRow& row) {
+		JointUpsamplePixels(row, 0, row.width);
+	}
+
+	//ここからSIMD版。出力の画素をベクトルの幅だけまとめ、重み(輝度・深度の差と範囲の重み)はレーンごとに、
+	//色は画素ごとのfloat4のまま重みを広げて足す。1画素の中の足す順は基準実装と同じ
+
+#if defined(CPU_ARCH_X86)
+	//4画素の手がかりの輝度(4画素を転置してr,g,bにする)
+	CPU_TARGET_SSE41 inline __m128 GuideLumaSSE41(const float4* guide) {
+		auto r = _mm_loadu_ps(reinterpret_cast<const float*>(guide));
+		auto g = _mm_loadu_ps(reinterpret_cast<const float*>(guide + 1));
+		auto b = _mm_loadu_ps(reinterpret_cast<const float*>(guide + 2));
+		auto a = _mm_loadu_ps(reinterpret_cast<const float*>(guide + 3));
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+		auto luma = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(0.299f)), _mm_mul_ps(g, _mm_set1_ps(0.587f))), _mm_mul_ps(b, _mm_set1_ps(0.114f)));
+		luma = _mm_max_ps(luma, _mm_setzero_ps());
+		return _mm_div_ps(luma, _mm_add_ps(_mm_set1_ps(1.0f), luma));
+	}
+
+	//タップのレーンごとの値(4画素)
+	CPU_TARGET_SSE41 inline __m128 GatherSSE41(const float* src, const unsigned int* index) {
+		return _mm_setr_ps(src[index[0]], src[index[1]], src[index[2]], src[index[3]]);
+	}
+
+	CPU_TARGET_SSE41 void JointUpsampleRowSSE41(const JointUpsampleRow& row) {
+		const bool useDepth = row.geometry != nullptr;
+		const auto one = _mm_set1_ps(1.0f);
+		const auto zero = _mm_setzero_ps();
+		const auto invLumaSigma = _mm_set1_ps(row.invLumaSigma);
+		unsigned int x = 0;
+		for (; x + 4 <= row.width; x += 4) {
+			const auto luma = GuideLumaSSE41(row.guide + x);
+			auto depth = zero;
+			auto depthScale = zero;
+			if (useDepth) {
+				depth = _mm_setr_ps(row.geometry[x].z, row.geometry[x + 1].z, row.geometry[x + 2].z, row.geometry[x + 3].z);
+				depthScale = _mm_div_ps(one, _mm_mul_ps(_mm_max_ps(depth, _mm_set1_ps(1e-4f)), _mm_set1_ps(row.depthSigma)));
+			}
+			__m128 sum[4] = { zero, zero, zero, zero };
+			auto weight = zero;
+			for (unsigned int j = 0; j < row.taps; ++j) {
+				const auto yWeight = _mm_set1_ps(row.yWeight[j]);
+				const float* low = reinterpret_cast<const float*>(row.low[j]);
+				for (unsigned int i = 0; i < row.taps; ++i) {
+					const unsigned int* index = row.xIndex + i * row.width + x;
+					auto lumaT = _mm_mul_ps(_mm_sub_ps(GatherSSE41(row.lowLuma[j], index), luma), invLumaSigma);
+					auto denominator = _mm_add_ps(one, _mm_mul_ps(lumaT, lumaT));
+					if (useDepth) {
+						auto depthT = _mm_mul_ps(_mm_sub_ps(GatherSSE41(row.lowDepth[j], index), depth), depthScale);
+						denominator = _mm_mul_ps(denominator, _mm_add_ps(one, _mm_mul_ps(depthT, depthT)));
+					}
+					auto w = _mm_mul_ps(_mm_mul_ps(yWeight, _mm_loadu_ps(row.xWeight + i * row.width + x)), _mm_div_ps(one, denominator));
+					weight = _mm_add_ps(weight, w);
+					sum[0] = _mm_add_ps(sum[0], _mm_mul_ps(_mm_loadu_ps(low + index[0] * 4), _mm_shuffle_ps(w, w, 0x00)));
+					sum[1] = _mm_add_ps(sum[1], _mm_mul_ps(_mm_loadu_ps(low + index[1] * 4), _mm_shuffle_ps(w, w, 0x55)));
+					sum[2] = _mm_add_ps(sum[2], _mm_mul_ps(_mm_loadu_ps(low + index[2] * 4), _mm_shuffle_ps(w, w, 0xaa)));
+					sum[3] = _mm_add_ps(sum[3], _mm_mul_ps(_mm_loadu_ps(low + index[3] * 4), _mm_shuffle_ps(w, w, 0xff)));
+				}
+			}
+			const __m128 weights[4] = { _mm_shuffle_ps(weight, weight, 0x00), _mm_shuffle_ps(weight, weight, 0x55), _mm_shuffle_ps(weight, weight, 0xaa), _mm_shuffle_ps(weight, weight, 0xff) };
+			for (int p = 0; p < 4; ++p) {
+				auto resolved = _mm_blendv_ps(sum[p], _mm_div_ps(sum[p], weights[p]), _mm_cmpgt_ps(weights[p], zero));
+				_mm_storeu_ps(reinterpret_cast<float*>(row.dst + x + p), resolved);
+			}
+		}
+		JointUpsamplePixels(row, x, row.width);
+	}
+
+	//8画素の手がかりの輝度(r,g,bを集める)
+	CPU_TARGET_AVX2 inline __m256 GuideLumaAVX2(const float4* guide) {
+		const auto stride = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+		const float* p = reinterpret_cast<const float*>(guide);
+		auto r = _mm256_i32gather_ps(p, stride, 4);
+		auto g = _mm256_i32gather_ps(p + 1, stride, 4);
+		auto b = _mm256_i32gather_ps(p + 2, stride, 4);
+		auto luma = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, _mm256_set1_ps(0.299f)), _mm256_mul_ps(g, _mm256_set1_ps(0.587f))), _mm256_mul_ps(b, _mm256_set1_ps(0.114f)));
+		luma = _mm256_max_ps(luma, _mm256_setzero_ps());
+		return _mm256_div_ps(luma, _mm256_add_ps(_mm256_set1_ps(1.0f), luma));
+	}
+
+	//2画素のfloat4を1つのレジスタに
+	CPU_TARGET_AVX2 inline __m256 LoadPixelPairAVX2(const float* low, unsigned int index0, unsigned int index1) {
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low + index0 * 4)), _mm_loadu_ps(low + index1 * 4), 1);
+	}
+
+	CPU_TARGET_AVX2 void JointUpsampleRowAVX2(const JointUpsampleRow& row) {
+		const bool useDepth = row.geometry != nullptr;
+		const auto one = _mm256_set1_ps(1.0f);
+		const auto zero = _mm256_setzero_ps();
+		const auto invLumaSigma = _mm256_set1_ps(row.invLumaSigma);
+		//レーンの重みを、画素2p・2p+1のfloat4の4成分ずつに広げる
+		const __m256i spread[4] = {
+			_mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1), _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3),
+			_mm256_setr_epi32(4, 4, 4, 4, 5, 5, 5, 5), _mm256_setr_epi32(6, 6, 6, 6, 7, 7, 7, 7),
+		};
+		unsigned int x = 0;
+		for (; x + 8 <= row.width; x += 8) {
+			const auto luma = GuideLumaAVX2(row.guide + x);
+			auto depth = zero;
+			auto depthScale = zero;
+			if (useDepth) {
+				depth = _mm256_i32gather_ps(reinterpret_cast<const float*>(row.geometry + x) + 2, _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28), 4);
+				depthScale = _mm256_div_ps(one, _mm256_mul_ps(_mm256_max_ps(depth, _mm256_set1_ps(1e-4f)), _mm256_set1_ps(row.depthSigma)));
+			}
+			__m256 sum[4] = { zero, zero, zero, zero };
+			auto weight = zero;
+			for (unsigned int j = 0; j < row.taps; ++j) {
+				const auto yWeight = _mm256_set1_ps(row.yWeight[j]);
+				const float* low = reinterpret_cast<const float*>(row.low[j]);
+				for (unsigned int i = 0; i < row.taps; ++i) {
+					const unsigned int* index = row.xIndex + i * row.width + x;
+					const auto lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index));
+					auto lumaT = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(row.lowLuma[j], lanes, 4), luma), invLumaSigma);
+					auto denominator = _mm256_add_ps(one, _mm256_mul_ps(lumaT, lumaT));
+					if (useDepth) {
+						auto depthT = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(row.lowDepth[j], lanes, 4), depth), depthScale);
+						denominator = _mm256_mul_ps(denominator, _mm256_add_ps(one, _mm256_mul_ps(depthT, depthT)));
+					}
+					auto w = _mm256_mul_ps(_mm256_mul_ps(yWeight, _mm256_loadu_ps(row.xWeight + i * row.width + x)), _mm256_div_ps(one, denominator));
+					weight = _mm256_add_ps(weight, w);
+					for (int p = 0; p < 4; ++p) {
+						auto value = LoadPixelPairAVX2(low, index[p * 2], index[p * 2 + 1]);
+						sum[p] = _mm256_add_ps(sum[p], _mm256_mul_ps(value, _mm256_permutevar8x32_ps(w, spread[p])));
+					}
+				}
+			}
+			for (int p = 0; p < 4; ++p) {
+				auto w = _mm256_permutevar8x32_ps(weight, spread[p]);
+				auto resolved = _mm256_blendv_ps(sum[p], _mm256_div_ps(sum[p], w), _mm256_cmp_ps(w, zero, _CMP_GT_OQ));
+				_mm256_storeu_ps(reinterpret_cast<float*>(row.dst + x + p * 2), resolved);
+			}
+		}
+		_mm256_zeroupper();//1画素ずつの端数に上位のレジスタの状態を持ち込まない
+		JointUpsamplePixels(row, x, row.width);
+	}
+
+	//4画素のfloat4を1つのレジスタに
+	CPU_TARGET_AVX512 inline __m512 LoadPixelQuadAVX512(const float* low, const unsigned int* index) {
+		auto v = _mm512_castps128_ps512(_mm_loadu_ps(low + index[0] * 4));
+		v = _mm512_insertf32x4(v, _mm_loadu_ps(low + index[1] * 4), 1);
+		v = _mm512_insertf32x4(v, _mm_loadu_ps(low + index[2] * 4), 2);
+		return _mm512_insertf32x4(v, _mm_loadu_ps(low + index[3] * 4), 3);
+	}
+
+	CPU_TARGET_AVX512 void JointUpsampleRowAVX512(const JointUpsampleRow& row) {
+		const bool useDepth = row.geometry != nullptr;
+		const auto one = _mm512_set1_ps(1.0f);
+		const auto zero = _mm512_setzero_ps();
+		const auto invLumaSigma = _mm512_set1_ps(row.invLumaSigma);
+		const auto stride = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60);
+		//レーンの重みを、画素4p～4p+3のfloat4の4成分ずつに広げる
+		const __m512i spread[4] = {
+			_mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3), _mm512_setr_epi32(4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7),
+			_mm512_setr_epi32(8, 8, 8, 8, 9, 9, 9, 9, 10, 10, 10, 10, 11, 11, 11, 11), _mm512_setr_epi32(12, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 15, 15, 15, 15),
+		};
+		unsigned int x = 0;
+		for (; x + 16 <= row.width; x += 16) {
+			const float* guide = reinterpret_cast<const float*>(row.guide + x);
+			auto luma = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(_mm512_i32gather_ps(stride, guide, 4), _mm512_set1_ps(0.299f)),
+				_mm512_mul_ps(_mm512_i32gather_ps(stride, guide + 1, 4), _mm512_set1_ps(0.587f))), _mm512_mul_ps(_mm512_i32gather_ps(stride, guide + 2, 4), _mm512_set1_ps(0.114f)));
+			luma = _mm512_max_ps(luma, zero);
+			luma = _mm512_div_ps(luma, _mm512_add_ps(one, luma));
+			auto depth = zero;
+			auto depthScale = zero;
+			if (useDepth) {
+				depth = _mm512_i32gather_ps(stride, reinterpret_cast<const float*>(row.geometry + x) + 2, 4);
+				depthScale = _mm512_div_ps(one, _mm512_mul_ps(_mm512_max_ps(depth, _mm512_set1_ps(1e-4f)), _mm512_set1_ps(row.depthSigma)));
+			}
+			__m512 sum[4] = { zero, zero, zero, zero };
+			auto weight = zero;
+			for (unsigned int j = 0; j < row.taps; ++j) {
+				const auto yWeight = _mm512_set1_ps(row.yWeight[j]);
+				const float* low = reinterpret_cast<const float*>(row.low[j]);
+				for (unsigned int i = 0; i < row.taps; ++i) {
+					const unsigned int* index = row.xIndex + i * row.width + x;
+					const auto lanes = _mm512_loadu_si512(index);
+					auto lumaT = _mm512_mul_ps(_mm512_sub_ps(_mm512_i32gather_ps(lanes, row.lowLuma[j], 4), luma), invLumaSigma);
+					auto denominator = _mm512_add_ps(one, _mm512_mul_ps(lumaT, lumaT));
+					if (useDepth) {
+						auto depthT = _mm512_mul_ps(_mm512_sub_ps(_mm512_i32gather_ps(lanes, row.lowDepth[j], 4), depth), depthScale);
+						denominator = _mm512_mul_ps(denominator, _mm512_add_ps(one, _mm512_mul_ps(depthT, depthT)));
+					}
+					auto w = _mm512_mul_ps(_mm512_mul_ps(yWeight, _mm512_loadu_ps(row.xWeight + i * row.width + x)), _mm512_div_ps(one, denominator));
+					weight = _mm512_add_ps(weight, w);
+					for (int p = 0; p < 4; ++p) {
+						sum[p] = _mm512_add_ps(sum[p], _mm512_mul_ps(LoadPixelQuadAVX512(low, index + p * 4), _mm512_permutexvar_ps(spread[p], w)));
+					}
+				}
+			}
+			for (int p = 0; p < 4; ++p) {
+				auto w = _mm512_permutexvar_ps(spread[p], weight);
+				auto resolved = _mm512_mask_div_ps(sum[p], _mm512_cmp_ps_mask(w, zero, _CMP_GT_OQ), sum[p], w);
+				_mm512_storeu_ps(reinterpret_cast<float*>(row.dst + x + p * 4), resolved);
+			}
+		}
+		_mm256_zeroupper();//1画素ずつの端数に上位のレジスタの状態を持ち込まない
+		JointUpsamplePixels(row, x, row.width);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	inline float32x4_t GatherNEON(const float* src, const unsigned int* index) {
+		const float lanes[4] = { src[index[0]], src[index[1]], src[index[2]], src[index[3]] };
+		return vld1q_f32(lanes);
+	}
+
+	void JointUpsampleRowNEON(const JointUpsampleRow& row) {
+		const bool useDepth = row.geometry != nullptr;
+		const auto one = vdupq_n_f32(1.0f);
+		const auto zero = vdupq_n_f32(0.0f);
+		const auto invLumaSigma = vdupq_n_f32(row.invLumaSigma);
+		unsigned int x = 0;
+		for (; x + 4 <= row.width; x += 4) {
+			//4画素をr,g,b,aに分けて読む
+			const auto guide = vld4q_f32(reinterpret_cast<const float*>(row.guide + x));
+			auto luma = vaddq_f32(vaddq_f32(vmulq_n_f32(guide.val[0], 0.299f), vmulq_n_f32(guide.val[1], 0.587f)), vmulq_n_f32(guide.val[2], 0.114f));
+			luma = vmaxq_f32(luma, zero);
+			luma = vdivq_f32(luma, vaddq_f32(one, luma));
+			auto depth = zero;
+			auto depthScale = zero;
+			if (useDepth) {
+				depth = vld4q_f32(reinterpret_cast<const float*>(row.geometry + x)).val[2];
+				depthScale = vdivq_f32(one, vmulq_n_f32(vmaxq_f32(depth, vdupq_n_f32(1e-4f)), row.depthSigma));
+			}
+			float32x4_t sum[4] = { zero, zero, zero, zero };
+			auto weight = zero;
+			for (unsigned int j = 0; j < row.taps; ++j) {
+				const float* low = reinterpret_cast<const float*>(row.low[j]);
+				for (unsigned int i = 0; i < row.taps; ++i) {
+					const unsigned int* index = row.xIndex + i * row.width + x;
+					auto lumaT = vmulq_f32(vsubq_f32(GatherNEON(row.lowLuma[j], index), luma), invLumaSigma);
+					auto denominator = vaddq_f32(one, vmulq_f32(lumaT, lumaT));
+					if (useDepth) {
+						auto depthT = vmulq_f32(vsubq_f32(GatherNEON(row.lowDepth[j], index), depth), depthScale);
+						denominator = vmulq_f32(denominator, vaddq_f32(one, vmulq_f32(depthT, depthT)));
+					}
+					auto w = vmulq_f32(vmulq_n_f32(vld1q_f32(row.xWeight + i * row.width + x), row.yWeight[j]), vdivq_f32(one, denominator));
+					weight = vaddq_f32(weight, w);
+					sum[0] = vaddq_f32(sum[0], vmulq_laneq_f32(vld1q_f32(low + index[0] * 4), w, 0));
+					sum[1] = vaddq_f32(sum[1], vmulq_laneq_f32(vld1q_f32(low + index[1] * 4), w, 1));
+					sum[2] = vaddq_f32(sum[2], vmulq_laneq_f32(vld1q_f32(low + index[2] * 4), w, 2));
+					sum[3] = vaddq_f32(sum[3], vmulq_laneq_f32(vld1q_f32(low + index[3] * 4), w, 3));
+				}
+			}
+			const float32x4_t weights[4] = { vdupq_laneq_f32(weight, 0), vdupq_laneq_f32(weight, 1), vdupq_laneq_f32(weight, 2), vdupq_laneq_f32(weight, 3) };
+			for (int p = 0; p < 4; ++p) {
+				auto resolved = vbslq_f32(vcgtq_f32(weights[p], zero), vdivq_f32(sum[p], weights[p]), sum[p]);
+				vst1q_f32(reinterpret_cast<float*>(row.dst + x + p), resolved);
+			}
+		}
+		JointUpsamplePixels(row, x, row.width);
+	}
+#endif
+
+	using JointUpsampleRowFunc = void(*)(const JointUpsampleRow& row);
+	Kernel<JointUpsampleRowFunc> jointUpsampleRow("jointup", {
+		{ CpuIsa::Scalar, JointUpsampleRowScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, JointUpsampleRowSSE41 },
+		{ CpuIsa::AVX2, JointUpsampleRowAVX2 },
+		{ CpuIsa::AVX512, JointUpsampleRowAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, JointUpsampleRowNEON },
+#endif
+	});
+}
+
+void
+JointUpsample(const ImageRGBA32F& low, const ImageRGBA32F& lowGuide, const ImageRGBA32F& guide, const ImageRGBA32F* geometry,
+	ImageRGBA32F& dst, const JointUpsampleSettings& settings, ComputeExecutor* executor) {
+	PrepareOutput(low, lowGuide, guide, geometry, dst, settings);
+	const bool useDepth = settings.depthSigma > 0.0f;
+	const auto xAxis = MakeUpsampleAxis(guide.width, low.width, settings.radius);
+	const auto yAxis = MakeUpsampleAxis(guide.height, low.height, settings.radius);
+	const unsigned int taps = xAxis.taps;
+	const float invLumaSigma = 1.0f / settings.lumaSigma;
+
+	//縮小した手がかりの輝度と深度
+	vector<float> lowLuma(low.pixels.size());
+	vector<float> lowDepth(useDepth ? low.pixels.size() : 0);
+	auto prepareRows = [&](size_t y0, size_t y1) {
+		for (auto y = y0; y < y1; ++y) {
+			const auto row = static_cast<unsigned int>(y);
+			const float4* g = lowGuide.Row(row);
+			float* luma = lowLuma.data() + y * low.width;
+			for (unsigned int x = 0; x < low.width; ++x) {
+				luma[x] = hlsl::GuideLuma(g[x]);
+			}
+			if (useDepth) {
+				const float4* geo = geometry->Row(hlsl::JointUpsampleSourcePixel(row, low.height, guide.height));
+				float* depth = lowDepth.data() + y * low.width;
+				for (unsigned int x = 0; x < low.width; ++x) {
+					depth[x] = geo[hlsl::JointUpsampleSourcePixel(x, low.width, guide.width)].z;
+				}
+			}
+		}
+	};
+	auto upsample = jointUpsampleRow.Get();
+	auto upsampleRows = [&](size_t y0, size_t y1) {
+		JointUpsampleRow row = {};
+		row.width = guide.width;
+		row.taps = taps;
+		row.xIndex = xAxis.index.data();
+		row.xWeight = xAxis.weight.data();
+		row.invLumaSigma = invLumaSigma;
+		row.depthSigma = settings.depthSigma;
+		for (auto y = y0; y < y1; ++y) {
+			row.guide = guide.Row(static_cast<unsigned int>(y));
+			row.geometry = useDepth ? geometry->Row(static_cast<unsigned int>(y)) : nullptr;
+			row.dst = dst.Row(static_cast<unsigned int>(y));
+			for (unsigned int j = 0; j < taps; ++j) {
+				const size_t rowOffset = static_cast<size_t>(yAxis.index[j * guide.height + y]) * low.width;
+				row.low[j] = low.pixels.data() + rowOffset;
+				row.lowLuma[j] = lowLuma.data() + rowOffset;
+				row.lowDepth[j] = useDepth ? lowDepth.data() + rowOffset : nullptr;
+				row.yWeight[j] = yAxis.weight[j * guide.height + y];
+			}
+			upsample(row);
+		}
+	};
+	if (executor != nullptr) {
+		executor->ParallelFor(low.height, upsampleGrainRows, prepareRows);
+		executor->ParallelFor(guide.height, upsampleGrainRows, upsampleRows);
+	}
+	else {
+		prepareRows(0, low.height);
+		upsampleRows(0, guide.height);
+	}
+}
+
+void
+JointUpsampleReference(const ImageRGBA32F& low, const ImageRGBA32F& lowGuide, const ImageRGBA32F& guide, const ImageRGBA32F* geometry,
+	ImageRGBA32F& dst, const JointUpsampleSettings& settings) {
+	PrepareOutput(low, lowGuide, guide, geometry, dst, settings);
+	const bool useDepth = settings.depthSigma > 0.0f;
+	const int radius = static_cast<int>(settings.radius);
+	const float invLumaSigma = 1.0f / settings.lumaSigma;
+	for (unsigned int y = 0; y < guide.height; ++y) {
+		const float v = hlsl::JointUpsamplePosition(y, guide.height, low.height);
+		const int firstY = static_cast<int>(floor(v)) - radius + 1;
+		for (unsigned int x = 0; x < guide.width; ++x) {
+			const float u = hlsl::JointUpsamplePosition(x, guide.width, low.width);
+			const int firstX = static_cast<int>(floor(u)) - radius + 1;
+			const float luma = hlsl::GuideLuma(guide.At(x, y));
+			const float depth = useDepth ? geometry->At(x, y).z : 0.0f;
+			const float depthScale = useDepth ? hlsl::JointUpsampleDepthScale(depth, settings.depthSigma) : 0.0f;
+			JointUpsampleAccumulator acc = {};
+			for (int j = 0; j < 2 * radius; ++j) {
+				const int qy = firstY + j;
+				const auto ly = static_cast<unsigned int>(clamp(qy, 0, static_cast<int>(low.height) - 1));
+				const float wy = hlsl::JointUpsampleTent(static_cast<float>(qy) - v, static_cast<float>(radius));
+				for (int i = 0; i < 2 * radius; ++i) {
+					const int qx = firstX + i;
+					const auto lx = static_cast<unsigned int>(clamp(qx, 0, static_cast<int>(low.width) - 1));
+					const float wx = hlsl::JointUpsampleTent(static_cast<float>(qx) - u, static_cast<float>(radius));
+					float depthT = 0.0f;
+					if (useDepth) {
+						const float lowDepth = geometry->At(hlsl::JointUpsampleSourcePixel(lx, low.width, guide.width), hlsl::JointUpsampleSourcePixel(ly, low.height, guide.height)).z;
+						depthT = (lowDepth - depth) * depthScale;
+					}
+					const float range = hlsl::JointUpsampleRange((hlsl::GuideLuma(lowGuide.At(lx, ly)) - luma) * invLumaSigma, depthT);
+					acc = hlsl::AccumulateJointUpsample(acc, low.At(lx, ly), wy * wx * range);
+				}
+			}
+			dst.At(x, y) = hlsl::ResolveJointUpsample(acc);
+		}
+	}
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+#include"Image.h"
+
+class ComputeExecutor;
+
+//ジョイントバイラテラル拡大(縮小して処理した画像を、縮小前の画像を手がかりに元の大きさに戻す)
+//RenderTargetFilter/JointUpsampleCS.hlslのCPU版。1タップ分の重みはJointUpsample.hlsliをシェーダと共有する
+//出力の画素ごとに、縮小した画像の(2*radius)四方の近傍をテントの重みで足すが、
+//縮小前の画像(guide)の輝度と、近傍の縮小した手がかり(lowGuide)の輝度が違うものほど重みを下げる(深度も同じ)。
+//重いフィルタを1/2や1/4の大きさでかけても、輪郭の向こう側の色がにじまない(FilterGraph::Reducedで使う)
+//  CPU版は縦横のテントの重みと、縮小した手がかりの輝度・深度を前もって求めておく
+//  出力の1行はKernelRegistryの"jointup"で選ばれる(SIMD版は出力の画素をベクトルの幅だけまとめて重みを求める)
+
+///ジョイントバイラテラル拡大の設定
+struct JointUpsampleSettings {
+	float lumaSigma = 0.05f;//輝度(luma/(1+luma))の差がこれだけあると重みが半分になる(大きいほどただの拡大に近い)
+	float depthSigma = 0.0f;//深度の差/深度がこれだけあると重みが半分になる(0なら深度を使わない。使うならジオメトリ画像が要る)
+	unsigned int radius = 1;//縮小した画像で見る近傍の半径(1なら2x2、2なら4x4でなめらか。～2)
+};
+
+///JointUpsampleSettings::radiusの上限(JointUpsample.hlsliのJOINT_UPSAMPLE_MAX_RADIUS)
+constexpr unsigned int maxJointUpsampleRadius = 2;
+
+///ジョイントバイラテラル拡大
+///@param low 縮小して処理した画像
+///@param lowGuide 手がかりを縮小した画像(lowと同じ大きさ。lowを処理する前の入力)
+///@param guide 縮小前の手がかり(出力と同じ大きさ)
+///@param geometry ジオメトリ画像(Outline.hと同じ。guideと同じ大きさ)。settings.depthSigmaが0ならnullptrでよい
+///@param dst 出力画像(guideと同じ大きさにされる。入力と同じではいけない)
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+void JointUpsample(const ImageRGBA32F& low, const ImageRGBA32F& lowGuide, const ImageRGBA32F& guide, const ImageRGBA32F* geometry,
+	ImageRGBA32F& dst, const JointUpsampleSettings& settings, ComputeExecutor* executor);
+
+///JointUpsampleの基準実装(1画素ずつ、重みも手がかりもその場で求める。JointUpsampleCS.hlslと同じ書き方)
+void JointUpsampleReference(const ImageRGBA32F& low, const ImageRGBA32F& lowGuide, const ImageRGBA32F& guide, const ImageRGBA32F* geometry,
+	ImageRGBA32F& dst, const JointUpsampleSettings& settings);
@@ -0,0 +1,65 @@
+//WCgoCeg1^bv̌vZ
+//RenderTargetFilter/JointUpsampleCS.hlslCPU(CpuCompute/JointUpsample.cpp)ŋLĂ܂(MonoPixel.hlsliƓ)B
+//kď摜g傷ƂAߖT̉f̏d݂AkỎ摜(肪)Ƃ̋Px̍
+//WIg摜̐[x̍ŉ(g債ʂ肪̗֊s܂łɂ܂Ȃ)
+
+//k摜̋ߖT̔ȁ(JointUpsampleCS.hlsl̃^bv)
+#define JOINT_UPSAMPLE_MAX_RADIUS 2
+
+//肪̋Px(Outline.hlsliƓluma/(1+luma)ɏk߁AHDRł邢Ƃ̍Ȃ悤)
+float GuideLuma(float4 color)
+{
+    float luma = max(dot(color.rgb, float3(0.299f, 0.587f, 0.114f)), 0.0f);
+    return luma / (1.0f + luma);
+}
+
+//o͂̉fpos̒SAk摜̂ǂɓ邩(k摜̉f̒S)
+float JointUpsamplePosition(uint pos, uint size, uint lowSize)
+{
+    return ((float)pos + 0.5f) * ((float)lowSize / (float)size) - 0.5f;
+}
+
+//k摜̉fq̒SɓȂ傫̉f(WIg摜̐[xœǂ)
+uint JointUpsampleSourcePixel(uint q, uint lowSize, uint size)
+{
+    return min((uint)(((float)q + 0.5f) * ((float)size / (float)lowSize)), size - 1);
+}
+
+//Ԃ̏d(eg)Bdist͏k摜̉fPʂ̋Aradius͋ߖT̔a(1Ȃo`Ɠ)
+float JointUpsampleTent(float dist, float radius)
+{
+    return max(1.0f - abs(dist) / radius, 0.0f);
+}
+
+//͈͂̏d(sigmâƂ0.5ɂȂL킹́Bexpy)
+//lumaT : Px̍/sigmaAdepthT : [x̍*JointUpsampleDepthScale([xgȂ0)
+float JointUpsampleRange(float lumaT, float depthT)
+{
+    return 1.0f / ((1.0f + lumaT * lumaT) * (1.0f + depthT * depthT));
+}
+
+//[x̍Ɋ|l(O̐[xŊĂsigmaŊBƂقǍ)
+float JointUpsampleDepthScale(float depth, float sigma)
+{
+    return 1.0f / (max(depth, 1e-4f) * sigma);
+}
+
+//1f̏d݂̍v
+struct JointUpsampleAccumulator
+{
+    float4 sum;
+    float weight;
+};
+
+JointUpsampleAccumulator AccumulateJointUpsample(JointUpsampleAccumulator a, float4 value, float weight)
+{
+    a.sum += value * weight;
+    a.weight += weight;
+    return a;
+}
+
+float4 ResolveJointUpsample(JointUpsampleAccumulator a)
+{
+    //͈͂̏d݂0ɂȂȂ̂ŁAeg̏d݂ߖT1łΊ
+    return a.weight > 0.0f ? a.sum / a.weight : a.sum;
+}
@@ -0,0 +1,145 @@
+﻿#include "KernelRegistry.h"
+#include<algorithm>
+#include<cstdio>
+#include<sstream>
+
+using namespace std;
+
+namespace {
+	//ISA名を読み、CPUが対応していなければ警告して捨てる
+	bool ParseSupportedIsa(const string& name, CpuIsa& isa) {
+		if (!ParseCpuIsa(name, isa)) {
+			fprintf(stderr, "CPUCOMPUTE_ISA: unknown isa '%s'\n", name.c_str());
+			return false;
+		}
+		if (!IsCpuIsaSupported(isa)) {
+			fprintf(stderr, "CPUCOMPUTE_ISA: '%s' is not supported on this CPU\n", name.c_str());
+			return false;
+		}
+		return true;
+	}
+}
+
+KernelBase::KernelBase(const char* name) :name_(name) {}
+
+const char*
+KernelBase::Name()const {
+	return name_;
+}
+
+const vector<CpuIsa>&
+KernelBase::Isas()const {
+	return isas_;
+}
+
+CpuIsa
+KernelBase::SelectedIsa()const {
+	return isas_[selected_];
+}
+
+void
+KernelBase::SelectBestOf(bool limited, CpuIsa upper) {
+	bool found = false;
+	for (size_t i = 0; i < isas_.size(); ++i) {
+		auto isa = isas_[i];
+		if (!IsCpuIsaSupported(isa) || (limited && !CpuIsaIncludes(upper, isa))) {
+			continue;
+		}
+		if (!found || static_cast<int>(isa) > static_cast<int>(isas_[selected_])) {
+			selected_ = i;
+			found = true;
+		}
+	}
+	assert(found && "kernel has no scalar variant");
+}
+
+void
+KernelBase::Select(CpuIsa upper) {
+	SelectBestOf(true, upper);
+}
+
+void
+KernelBase::SelectBest() {
+	SelectBestOf(false, CpuIsa::Scalar);
+}
+
+bool
+KernelBase::SelectExact(CpuIsa isa) {
+	if (!IsCpuIsaSupported(isa)) {
+		return false;
+	}
+	auto it = find(isas_.begin(), isas_.end(), isa);
+	if (it == isas_.end()) {
+		return false;
+	}
+	selected_ = it - isas_.begin();
+	return true;
+}
+
+KernelRegistry::KernelRegistry() {
+	//"avx2" や "mono=scalar,avx512" の形
+	stringstream ss(GetEnvironmentString("CPUCOMPUTE_ISA"));
+	string item;
+	while (getline(ss, item, ',')) {
+		if (item.empty()) {
+			continue;
+		}
+		CpuIsa isa;
+		auto eq = item.find('=');
+		if (eq == string::npos) {
+			if (ParseSupportedIsa(item, isa)) {
+				hasDefaultLimit_ = true;
+				defaultLimit_ = isa;
+			}
+		}
+		else if (ParseSupportedIsa(item.substr(eq + 1), isa)) {
+			kernelLimits_[item.substr(0, eq)] = isa;
+		}
+	}
+}
+
+KernelRegistry&
+KernelRegistry::Instance() {
+	static KernelRegistry instance;
+	return instance;
+}
+
+void
+KernelRegistry::Register(KernelBase& kernel) {
+	assert(Find(kernel.Name()) == nullptr);
+	kernels_.push_back(&kernel);
+	auto it = kernelLimits_.find(kernel.Name());
+	if (it != kernelLimits_.end()) {
+		kernel.Select(it->second);
+	}
+	else if (hasDefaultLimit_) {
+		kernel.Select(defaultLimit_);
+	}
+	else {
+		kernel.SelectBest();
+	}
+}
+
+const vector<KernelBase*>&
+KernelRegistry::Kernels()const {
+	return kernels_;
+}
+
+KernelBase*
+KernelRegistry::Find(const string& name)const {
+	for (auto k : kernels_) {
+		if (name == k->Name()) {
+			return k;
+		}
+	}
+	return nullptr;
+}
+
+void
+KernelRegistry::Reset() {
+	auto kernels = kernels_;
+	kernels_.clear();
+	for (auto k : kernels) {
+		Register(*k);
+	}
+}
@@ -0,0 +1,111 @@
+﻿#pragma once
+#include<vector>
+#include<string>
+#include<map>
+#include<initializer_list>
+#include<cassert>
+#include"CpuFeatures.h"
+
+///レジストリに登録されるカーネル(関数の型によらない部分)
+class KernelBase
+{
+	const char* name_;
+protected:
+	std::vector<CpuIsa> isas_;//登録された実装の命令セット
+	size_t selected_ = 0;//選ばれている実装の番号
+
+	explicit KernelBase(const char* name);
+	//limitedならupperに含まれるものだけから選ぶ
+	void SelectBestOf(bool limited, CpuIsa upper);
+public:
+	virtual ~KernelBase() = default;
+
+	const char* Name()const;
+	///登録されている実装の命令セット
+	const std::vector<CpuIsa>& Isas()const;
+	///今選ばれている実装の命令セット
+	CpuIsa SelectedIsa()const;
+
+	///upperに含まれ、このCPUで使える実装のうち一番良いものを選ぶ
+	///@param upper 選んでよい命令セットの上限(CpuIsaIncludes参照)
+	///@remarks スカラー実装は必ずあるので常に何かが選ばれる
+	void Select(CpuIsa upper);
+
+	///このCPUで使える実装のうち一番良いものを選ぶ
+	void SelectBest();
+
+	///isaの実装をそのまま選ぶ(A/B比較用)
+	///@retval false 実装がないかCPUが対応していない(選択は変わらない)
+	///@remarks 実行中のカーネルと並行して呼んではいけない
+	bool SelectExact(CpuIsa isa);
+};
+
+///カーネルの一覧と実装の選択
+///起動時に環境変数CPUCOMPUTE_ISAを読み、以下の形で実装を強制できる
+///  CPUCOMPUTE_ISA=avx2                 全カーネルをavx2以下に制限する
+///  CPUCOMPUTE_ISA=mono=scalar,avx512   monoだけscalar、ほかはavx512以下
+class KernelRegistry
+{
+	std::vector<KernelBase*> kernels_;
+	bool hasDefaultLimit_ = false;
+	CpuIsa defaultLimit_ = CpuIsa::Scalar;//カーネル名なしの指定
+	std::map<std::string, CpuIsa> kernelLimits_;//カーネル名つきの指定
+
+	KernelRegistry();
+	KernelRegistry(const KernelRegistry&) = delete;
+	void operator=(const KernelRegistry&) = delete;
+public:
+	static KernelRegistry& Instance();
+
+	///カーネルを登録し、環境変数の指定とCPUの対応から実装を選ぶ
+	void Register(KernelBase& kernel);
+
+	///登録されたカーネル(登録順)
+	const std::vector<KernelBase*>& Kernels()const;
+
+	///名前でカーネルを探す(なければnullptr)
+	KernelBase* Find(const std::string& name)const;
+
+	///全カーネルを環境変数の指定どおりの選択に戻す
+	void Reset();
+};
+
+///命令セット別の実装を持つカーネル
+///名前空間スコープのstatic変数として定義すると、起動時に登録・選択される
+///@param Func 実装の関数ポインタ型(全実装で同じ型)
+template<typename Func>
+class Kernel : public KernelBase
+{
+	std::vector<Func> funcs_;
+public:
+	struct Variant {
+		CpuIsa isa;
+		Func func;
+	};
+
+	///@param name カーネル名(CPUCOMPUTE_ISAで使う)
+	///@param variants 実装の一覧(スカラー実装は必須)
+	Kernel(const char* name, std::initializer_list<Variant> variants) :KernelBase(name) {
+		for (auto& v : variants) {
+			isas_.push_back(v.isa);
+			funcs_.push_back(v.func);
+		}
+		KernelRegistry::Instance().Register(*this);
+	}
+
+	///選ばれている実装
+	Func Get()const {
+		return funcs_[selected_];
+	}
+
+	///isaの実装(登録されていないかCPUが対応していなければnullptr)
+	///@remarks 選択は変えないので、実行中のカーネルと並行して呼んでよい
+	Func Get(CpuIsa isa)const {
+		for (size_t i = 0; i < isas_.size(); ++i) {
+			if (isas_[i] == isa) {
+				return IsCpuIsaSupported(isa) ? funcs_[i] : nullptr;
+			}
+		}
+		return nullptr;
+	}
+};
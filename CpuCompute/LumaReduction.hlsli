@@ -0,0 +1,29 @@
+//Px̏Wv1f̌vZ
+//ReductionCS.hlslCPU(CpuCompute/Reduction.cpp)ŋLĂ܂(MonoPixel.hlsliƓ)B
+
+//BT.601̋Px(MonoCSƓW)
+float Luminance(float3 rgb)
+{
+    return dot(rgb, float3(0.299, 0.587, 0.114));
+}
+
+//qXgO̊K(0`255)
+//(luma - offset) * scale؂̂āA͈͊O͗[̊Kɓ(NaN0)
+uint LumaBin(float luma, float offset, float scale)
+{
+    return (uint)clamp((luma - offset) * scale, 0.0f, 255.0f);
+}
+
+//qXgOΐŎƂlog2(Px)̋ߎ
+//float̃rbĝ܂ܐƂēǂ(1IN^[u̒𒼐łȂ̂ŁAlog2Ƃ̍0.086ȉ)B
+//̕ϊƏZȂ̂ŁAVF[_CPU(SIMD)œlɂȂB0ȉNaN-127
+float ApproxLog2(float luma)
+{
+    return luma > 0 ? (float)asuint(luma) * (1.0 / 8388608.0) - 127.0 : -127.0;
+}
+
+//qXgO̊K߂l(logScale0łȂApproxLog2(Px))
+float LumaHistogramValue(float luma, uint logScale)
+{
+    return logScale != 0 ? ApproxLog2(luma) : luma;
+}
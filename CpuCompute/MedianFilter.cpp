@@ -0,0 +1,564 @@
+﻿#include "MedianFilter.h"
+#include<algorithm>
+#include<cassert>
+#include<cstring>
+#include<limits>
+#include<vector>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+#include"MedianNetwork.hlsli"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace {
+	//並列化するときの帯の最小の行数(帯ごとに上下radius行ぶん列のヒストグラムを作り直すので、radiusの4倍以上にする)
+	constexpr unsigned int minBandRows = 16;
+	//ネットワークで1タスクが受け持つ行数
+	constexpr size_t networkGrainRows = 16;
+	//短冊ごとの列のヒストグラムをこの大きさに収める(L2の一部)
+	constexpr size_t histogramBudgetBytes = 1024 * 1024;
+	constexpr unsigned int minStripWidth = 64;
+
+	//ここから3x3/5x5のネットワーク
+	//1行ぶんを、縦K行の列を並べる→sorted[順位]に置く→横にK列ずつ読んで中央値を選ぶ、の順に処理する
+	//R8G8B8A8の1バイトを1つの値として扱う(隣の画素は4バイト隣)。行の長さがベクトルの幅で割り切れないときは、
+	//最後のベクトルを行末に合わせて重ねて処理する(同じ値を書くだけなので問題ない)
+	//rows : 入力のK行(行の中だけ)
+	//sorted : 並べた列の置き場所K行(左右にradius画素ずつはみ出して使う)
+
+	//並べた列の左右のはみ出しに、端の画素の列を繰り返す(画像の外は端の画素なので、並べた結果も端と同じ)
+	void PadSortedColumns(uint8_t* const* sorted, size_t bytes, unsigned int radius) {
+		for (unsigned int k = 0; k < 2 * radius + 1; ++k) {
+			for (unsigned int p = 1; p <= radius; ++p) {
+				memcpy(sorted[k] - p * 4, sorted[k], 4);
+				memcpy(sorted[k] + bytes + (p - 1) * 4, sorted[k] + bytes - 4, 4);
+			}
+		}
+	}
+
+#define MEDIAN_SORT2(a, b) { auto t_ = min(a, b); b = max(a, b); a = t_; }
+#define MEDIAN_MIN(a, b) { a = min(a, b); }
+#define MEDIAN_MAX(a, b) { b = max(a, b); }
+	template<unsigned int K>
+	void MedianRowScalar(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes) {
+		constexpr int r = K / 2;
+		for (size_t i = 0; i < bytes; ++i) {
+			uint8_t c[K];
+			for (unsigned int k = 0; k < K; ++k) {
+				c[k] = rows[k][i];
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SORT_COLUMN3(c)
+			}
+			else {
+				MEDIAN_SORT_COLUMN5(c)
+			}
+			for (unsigned int k = 0; k < K; ++k) {
+				sorted[k][i] = c[k];
+			}
+		}
+		PadSortedColumns(sorted, bytes, r);
+		for (size_t i = 0; i < bytes; ++i) {
+			uint8_t s[K * K];
+			for (int col = 0; col < static_cast<int>(K); ++col) {
+				for (unsigned int k = 0; k < K; ++k) {
+					s[col * K + k] = sorted[k][i + (col - r) * 4];
+				}
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SELECT9(s)
+				dst[i] = s[MEDIAN9_RESULT];
+			}
+			else {
+				MEDIAN_SELECT25(s)
+				dst[i] = s[MEDIAN25_RESULT];
+			}
+		}
+	}
+#undef MEDIAN_SORT2
+#undef MEDIAN_MIN
+#undef MEDIAN_MAX
+
+	void MedianRowsScalar(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes, unsigned int radius) {
+		if (radius == 1) {
+			MedianRowScalar<3>(rows, sorted, dst, bytes);
+		}
+		else {
+			MedianRowScalar<5>(rows, sorted, dst, bytes);
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+#define MEDIAN_SORT2(a, b) { auto t_ = _mm_min_epu8(a, b); b = _mm_max_epu8(a, b); a = t_; }
+#define MEDIAN_MIN(a, b) { a = _mm_min_epu8(a, b); }
+#define MEDIAN_MAX(a, b) { b = _mm_max_epu8(a, b); }
+	template<unsigned int K>
+	CPU_TARGET_SSE41 void MedianRowSSE41(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes) {
+		constexpr int r = K / 2;
+		for (size_t i = 0; i < bytes; i += 16) {
+			const auto at = min(i, bytes - 16);
+			__m128i c[K];
+			for (unsigned int k = 0; k < K; ++k) {
+				c[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + at));
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SORT_COLUMN3(c)
+			}
+			else {
+				MEDIAN_SORT_COLUMN5(c)
+			}
+			for (unsigned int k = 0; k < K; ++k) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(sorted[k] + at), c[k]);
+			}
+		}
+		PadSortedColumns(sorted, bytes, r);
+		for (size_t i = 0; i < bytes; i += 16) {
+			const auto at = min(i, bytes - 16);
+			__m128i s[K * K];
+			for (int col = 0; col < static_cast<int>(K); ++col) {
+				for (unsigned int k = 0; k < K; ++k) {
+					s[col * K + k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sorted[k] + at + (col - r) * 4));
+				}
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SELECT9(s)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + at), s[MEDIAN9_RESULT]);
+			}
+			else {
+				MEDIAN_SELECT25(s)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + at), s[MEDIAN25_RESULT]);
+			}
+		}
+	}
+#undef MEDIAN_SORT2
+#undef MEDIAN_MIN
+#undef MEDIAN_MAX
+
+	CPU_TARGET_SSE41 void MedianRowsSSE41(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes, unsigned int radius) {
+		if (bytes < 16) {
+			MedianRowsScalar(rows, sorted, dst, bytes, radius);
+		}
+		else if (radius == 1) {
+			MedianRowSSE41<3>(rows, sorted, dst, bytes);
+		}
+		else {
+			MedianRowSSE41<5>(rows, sorted, dst, bytes);
+		}
+	}
+
+#define MEDIAN_SORT2(a, b) { auto t_ = _mm256_min_epu8(a, b); b = _mm256_max_epu8(a, b); a = t_; }
+#define MEDIAN_MIN(a, b) { a = _mm256_min_epu8(a, b); }
+#define MEDIAN_MAX(a, b) { b = _mm256_max_epu8(a, b); }
+	template<unsigned int K>
+	CPU_TARGET_AVX2 void MedianRowAVX2(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes) {
+		constexpr int r = K / 2;
+		for (size_t i = 0; i < bytes; i += 32) {
+			const auto at = min(i, bytes - 32);
+			__m256i c[K];
+			for (unsigned int k = 0; k < K; ++k) {
+				c[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + at));
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SORT_COLUMN3(c)
+			}
+			else {
+				MEDIAN_SORT_COLUMN5(c)
+			}
+			for (unsigned int k = 0; k < K; ++k) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(sorted[k] + at), c[k]);
+			}
+		}
+		PadSortedColumns(sorted, bytes, r);
+		for (size_t i = 0; i < bytes; i += 32) {
+			const auto at = min(i, bytes - 32);
+			__m256i s[K * K];
+			for (int col = 0; col < static_cast<int>(K); ++col) {
+				for (unsigned int k = 0; k < K; ++k) {
+					s[col * K + k] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sorted[k] + at + (col - r) * 4));
+				}
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SELECT9(s)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + at), s[MEDIAN9_RESULT]);
+			}
+			else {
+				MEDIAN_SELECT25(s)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + at), s[MEDIAN25_RESULT]);
+			}
+		}
+	}
+#undef MEDIAN_SORT2
+#undef MEDIAN_MIN
+#undef MEDIAN_MAX
+
+	CPU_TARGET_AVX2 void MedianRowsAVX2(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes, unsigned int radius) {
+		if (bytes < 32) {
+			MedianRowsScalar(rows, sorted, dst, bytes, radius);
+		}
+		else if (radius == 1) {
+			MedianRowAVX2<3>(rows, sorted, dst, bytes);
+		}
+		else {
+			MedianRowAVX2<5>(rows, sorted, dst, bytes);
+		}
+	}
+
+#define MEDIAN_SORT2(a, b) { auto t_ = _mm512_min_epu8(a, b); b = _mm512_max_epu8(a, b); a = t_; }
+#define MEDIAN_MIN(a, b) { a = _mm512_min_epu8(a, b); }
+#define MEDIAN_MAX(a, b) { b = _mm512_max_epu8(a, b); }
+	//25個の値とテンポラリがzmm0～31に収まる
+	template<unsigned int K>
+	CPU_TARGET_AVX512 void MedianRowAVX512(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes) {
+		constexpr int r = K / 2;
+		for (size_t i = 0; i < bytes; i += 64) {
+			const auto at = min(i, bytes - 64);
+			__m512i c[K];
+			for (unsigned int k = 0; k < K; ++k) {
+				c[k] = _mm512_loadu_si512(rows[k] + at);
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SORT_COLUMN3(c)
+			}
+			else {
+				MEDIAN_SORT_COLUMN5(c)
+			}
+			for (unsigned int k = 0; k < K; ++k) {
+				_mm512_storeu_si512(sorted[k] + at, c[k]);
+			}
+		}
+		PadSortedColumns(sorted, bytes, r);
+		for (size_t i = 0; i < bytes; i += 64) {
+			const auto at = min(i, bytes - 64);
+			__m512i s[K * K];
+			for (int col = 0; col < static_cast<int>(K); ++col) {
+				for (unsigned int k = 0; k < K; ++k) {
+					s[col * K + k] = _mm512_loadu_si512(sorted[k] + at + (col - r) * 4);
+				}
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SELECT9(s)
+				_mm512_storeu_si512(dst + at, s[MEDIAN9_RESULT]);
+			}
+			else {
+				MEDIAN_SELECT25(s)
+				_mm512_storeu_si512(dst + at, s[MEDIAN25_RESULT]);
+			}
+		}
+	}
+#undef MEDIAN_SORT2
+#undef MEDIAN_MIN
+#undef MEDIAN_MAX
+
+	CPU_TARGET_AVX512 void MedianRowsAVX512(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes, unsigned int radius) {
+		if (bytes < 64) {
+			MedianRowsScalar(rows, sorted, dst, bytes, radius);
+		}
+		else if (radius == 1) {
+			MedianRowAVX512<3>(rows, sorted, dst, bytes);
+		}
+		else {
+			MedianRowAVX512<5>(rows, sorted, dst, bytes);
+		}
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+#define MEDIAN_SORT2(a, b) { auto t_ = vminq_u8(a, b); b = vmaxq_u8(a, b); a = t_; }
+#define MEDIAN_MIN(a, b) { a = vminq_u8(a, b); }
+#define MEDIAN_MAX(a, b) { b = vmaxq_u8(a, b); }
+	template<unsigned int K>
+	void MedianRowNEON(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes) {
+		constexpr int r = K / 2;
+		for (size_t i = 0; i < bytes; i += 16) {
+			const auto at = min(i, bytes - 16);
+			uint8x16_t c[K];
+			for (unsigned int k = 0; k < K; ++k) {
+				c[k] = vld1q_u8(rows[k] + at);
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SORT_COLUMN3(c)
+			}
+			else {
+				MEDIAN_SORT_COLUMN5(c)
+			}
+			for (unsigned int k = 0; k < K; ++k) {
+				vst1q_u8(sorted[k] + at, c[k]);
+			}
+		}
+		PadSortedColumns(sorted, bytes, r);
+		for (size_t i = 0; i < bytes; i += 16) {
+			const auto at = min(i, bytes - 16);
+			uint8x16_t s[K * K];
+			for (int col = 0; col < static_cast<int>(K); ++col) {
+				for (unsigned int k = 0; k < K; ++k) {
+					s[col * K + k] = vld1q_u8(sorted[k] + at + (col - r) * 4);
+				}
+			}
+			if constexpr (K == 3) {
+				MEDIAN_SELECT9(s)
+				vst1q_u8(dst + at, s[MEDIAN9_RESULT]);
+			}
+			else {
+				MEDIAN_SELECT25(s)
+				vst1q_u8(dst + at, s[MEDIAN25_RESULT]);
+			}
+		}
+	}
+#undef MEDIAN_SORT2
+#undef MEDIAN_MIN
+#undef MEDIAN_MAX
+
+	void MedianRowsNEON(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes, unsigned int radius) {
+		if (bytes < 16) {
+			MedianRowsScalar(rows, sorted, dst, bytes, radius);
+		}
+		else if (radius == 1) {
+			MedianRowNEON<3>(rows, sorted, dst, bytes);
+		}
+		else {
+			MedianRowNEON<5>(rows, sorted, dst, bytes);
+		}
+	}
+#endif
+
+	using MedianRowsFunc = void(*)(const uint8_t* const* rows, uint8_t* const* sorted, uint8_t* dst, size_t bytes, unsigned int radius);
+	Kernel<MedianRowsFunc> medianRows("median", {
+		{ CpuIsa::Scalar, MedianRowsScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, MedianRowsSSE41 },
+		{ CpuIsa::AVX2, MedianRowsAVX2 },
+		{ CpuIsa::AVX512, MedianRowsAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, MedianRowsNEON },
+#endif
+	});
+
+	void MedianByNetwork(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, ComputeExecutor* executor) {
+		auto median = medianRows.Get();
+		const unsigned int K = 2 * radius + 1;
+		const int height = static_cast<int>(src.height);
+		const size_t bytes = static_cast<size_t>(src.width) * 4;
+		auto runRows = [&](size_t begin, size_t end) {
+			vector<uint8_t> buffer(K * (bytes + radius * 8));
+			const uint8_t* rows[5];
+			uint8_t* sorted[5];
+			for (unsigned int k = 0; k < K; ++k) {
+				sorted[k] = buffer.data() + k * (bytes + radius * 8) + radius * 4;
+			}
+			for (auto y = static_cast<int>(begin); y < static_cast<int>(end); ++y) {
+				for (unsigned int k = 0; k < K; ++k) {
+					rows[k] = reinterpret_cast<const uint8_t*>(src.Row(static_cast<unsigned int>(clamp(y - static_cast<int>(radius) + static_cast<int>(k), 0, height - 1))));
+				}
+				median(rows, sorted, reinterpret_cast<uint8_t*>(dst.Row(static_cast<unsigned int>(y))), bytes, radius);
+			}
+		};
+		if (executor != nullptr) {
+			executor->ParallelFor(src.height, networkGrainRows, runRows);
+		}
+		else {
+			runRows(0, src.height);
+		}
+	}
+
+	//ここからヒストグラム
+	//列のヒストグラム(縦2r+1画素)を画像の列ごとに持ち、行を進めるたびに上の1行を引いて下の1行を足す。
+	//窓のヒストグラムは行の左端で2r+1列を足して作り、右に進むたびに右の列を足して左の列を引く。
+	//どちらも画素ごとの手間が半径によらない(定数時間)。
+	//256階級を毎回足し引きすると重いので、窓では値の上位4bitの粗い16階級だけを毎画素更新し、
+	//細かい16階級は順位の入っている粗い階級のものだけを、前回更新した位置からの差分(遠ければ作り直し)で更新する
+
+	//列のヒストグラム(成分ごと。数は2r+1以下)
+	struct ColumnHistogram {
+		uint16_t coarse[4][16];
+		uint16_t fine[4][256];
+	};
+
+	//画素の4成分をヒストグラムに足す(deltaが0xffffなら引く)
+	inline void AddPixel(ColumnHistogram& h, uint32_t px, uint16_t delta) {
+		for (int c = 0; c < 4; ++c) {
+			const auto v = (px >> (c * 8)) & 0xff;
+			h.coarse[c][v >> 4] += delta;
+			h.fine[c][v] += delta;
+		}
+	}
+
+	//dst += add - sub(16階級の倍数。ベクトル化される長さのループにしておく)
+	inline void AddBins(uint16_t* dst, const uint16_t* add, const uint16_t* sub, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			dst[i] = static_cast<uint16_t>(dst[i] + add[i] - sub[i]);
+		}
+	}
+
+	inline void AddBins(uint16_t* dst, const uint16_t* add, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			dst[i] = static_cast<uint16_t>(dst[i] + add[i]);
+		}
+	}
+}
+
+void
+MedianFilter(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, ComputeExecutor* executor) {
+	if (radius == 1 || radius == 2) {
+		assert(&src != &dst);
+		dst.width = src.width;
+		dst.height = src.height;
+		dst.pixels.resize(src.pixels.size());
+		if (src.width != 0 && src.height != 0) {
+			MedianByNetwork(src, dst, radius, executor);
+		}
+		return;
+	}
+	RankFilter(src, dst, radius, MedianRank(radius), executor);
+}
+
+void
+RankFilter(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, unsigned int rank, ComputeExecutor* executor) {
+	assert(&src != &dst);
+	assert(radius <= maxMedianRadius);
+	assert(rank < (2 * radius + 1) * (2 * radius + 1));
+	dst.width = src.width;
+	dst.height = src.height;
+	dst.pixels.resize(src.pixels.size());
+	if (radius == 0) {
+		dst.pixels = src.pixels;
+		return;
+	}
+	if (src.width == 0 || src.height == 0) {
+		return;
+	}
+	const int r = static_cast<int>(radius);
+	const int width = static_cast<int>(src.width);
+	const int height = static_cast<int>(src.height);
+
+	//短冊の幅:左右のはみ出しを含めた列のヒストグラムが予算に収まる幅
+	const int budgetColumns = static_cast<int>(histogramBudgetBytes / sizeof(ColumnHistogram));
+	const int stripWidth = min(width, max(static_cast<int>(minStripWidth), budgetColumns - 2 * r));
+	const int stripNum = (width + stripWidth - 1) / stripWidth;
+	unsigned int bandNum = 1;
+	if (executor != nullptr && executor->ThreadCount() > 1) {
+		const unsigned int bandRows = max(minBandRows, 4 * radius);
+		bandNum = max(1u, min(src.height / bandRows, executor->ThreadCount() * 2));
+	}
+
+	auto runTask = [&](size_t task) {
+		const int strip = static_cast<int>(task % stripNum);
+		const auto band = static_cast<unsigned int>(task / stripNum);
+		const int x0 = strip * stripWidth;
+		const int x1 = min(width, x0 + stripWidth);
+		const int y0 = static_cast<int>(static_cast<uint64_t>(src.height) * band / bandNum);
+		const int y1 = static_cast<int>(static_cast<uint64_t>(src.height) * (band + 1) / bandNum);
+		//窓が読む列(画像の外の列は端の列と同じなので持たない)
+		const int cx0 = max(0, x0 - r);
+		const int cx1 = min(width, x1 + r);
+		vector<ColumnHistogram> columns(cx1 - cx0);
+		auto column = [&](int x) -> const ColumnHistogram& {
+			return columns[clamp(x, 0, width - 1) - cx0];
+		};
+		auto updateColumns = [&](int y, uint16_t delta) {
+			auto row = src.Row(static_cast<unsigned int>(clamp(y, 0, height - 1)));
+			for (int x = cx0; x < cx1; ++x) {
+				AddPixel(columns[x - cx0], row[x], delta);
+			}
+		};
+		for (int y = y0 - r; y <= y0 + r; ++y) {
+			updateColumns(y, 1);
+		}
+
+		uint16_t coarse[4][16];
+		uint16_t fine[4][16][16];
+		int fineX[4][16];//fine[c][b]が窓の中心がどの列のときのものか
+		for (int y = y0; y < y1; ++y) {
+			if (y > y0) {
+				updateColumns(y - r - 1, 0xffff);
+				updateColumns(y + r, 1);
+			}
+			memset(coarse, 0, sizeof(coarse));
+			for (int x = x0 - r; x <= x0 + r; ++x) {
+				AddBins(&coarse[0][0], &column(x).coarse[0][0], 64);
+			}
+			fill(&fineX[0][0], &fineX[0][0] + 64, numeric_limits<int>::min() / 2);
+			auto out = dst.Row(static_cast<unsigned int>(y));
+			for (int x = x0; x < x1; ++x) {
+				if (x > x0) {
+					AddBins(&coarse[0][0], &column(x + r).coarse[0][0], &column(x - r - 1).coarse[0][0], 64);
+				}
+				uint32_t px = 0;
+				for (int c = 0; c < 4; ++c) {
+					//順位の入っている粗い階級
+					unsigned int count = 0;
+					int b = 0;
+					while (count + coarse[c][b] <= rank) {
+						count += coarse[c][b];
+						++b;
+					}
+					//その細かい階級を今の窓にする
+					auto segment = fine[c][b];
+					auto& last = fineX[c][b];
+					if (x - last > r) {
+						memset(segment, 0, sizeof(fine[c][b]));
+						for (int xx = x - r; xx <= x + r; ++xx) {
+							AddBins(segment, column(xx).fine[c] + b * 16, 16);
+						}
+					}
+					else {
+						for (int xx = last + 1; xx <= x; ++xx) {
+							AddBins(segment, column(xx + r).fine[c] + b * 16, column(xx - r - 1).fine[c] + b * 16, 16);
+						}
+					}
+					last = x;
+					int k = 0;
+					while (count + segment[k] <= rank) {
+						count += segment[k];
+						++k;
+					}
+					px |= static_cast<uint32_t>(b * 16 + k) << (c * 8);
+				}
+				out[x] = px;
+			}
+		}
+	};
+	const size_t taskNum = static_cast<size_t>(stripNum) * bandNum;
+	if (taskNum > 1 && executor != nullptr) {
+		executor->ParallelFor(taskNum, 1, [&](size_t begin, size_t end) {
+			for (auto t = begin; t < end; ++t) {
+				runTask(t);
+			}
+		});
+	}
+	else {
+		for (size_t t = 0; t < taskNum; ++t) {
+			runTask(t);
+		}
+	}
+}
+
+void
+RankFilterReference(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, unsigned int rank) {
+	const int r = static_cast<int>(radius);
+	const int w = static_cast<int>(src.width);
+	const int h = static_cast<int>(src.height);
+	dst = ImageRGBA8(src.width, src.height);
+	vector<uint8_t> values((2 * radius + 1) * (2 * radius + 1));
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			uint32_t px = 0;
+			for (int c = 0; c < 4; ++c) {
+				size_t n = 0;
+				for (int dy = -r; dy <= r; ++dy) {
+					for (int dx = -r; dx <= r; ++dx) {
+						values[n++] = static_cast<uint8_t>(src.At(clamp(x + dx, 0, w - 1), clamp(y + dy, 0, h - 1)) >> (c * 8));
+					}
+				}
+				nth_element(values.begin(), values.begin() + rank, values.end());
+				px |= static_cast<uint32_t>(values[rank]) << (c * 8);
+			}
+			dst.At(x, y) = px;
+		}
+	}
+}
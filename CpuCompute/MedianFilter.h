@@ -0,0 +1,35 @@
+﻿#pragma once
+#include"Image.h"
+
+class ComputeExecutor;
+
+//中央値・順位フィルタ(窓の(2r+1)x(2r+1)画素の中で、成分ごとに小さい方から決まった順位の値を選ぶ)
+//RenderTargetFilter/MedianCS.hlslのCPU版。画像の外は端の画素を繰り返す
+//  半径1/2(3x3/5x5)の中央値 : 列を並べてから選ぶmin/maxのネットワーク(MedianNetwork.hlsliをシェーダと共有)を、
+//                              1バイト=1成分としてベクトルの全要素で同時に解く
+//  それ以外・任意の順位      : 列ごとのヒストグラムを縦に、窓のヒストグラムを横にずらしていく定数時間の方法
+//                              (窓のヒストグラムは16階級の粗いものと、必要になった階級だけ更新する細かいものの2段)
+
+///ヒストグラムで扱える半径の上限(列の画素数が255以下)
+constexpr unsigned int maxMedianRadius = 127;
+
+///中央値フィルタ
+///@param src 入力画像
+///@param dst 出力画像(srcと同じサイズにされる。srcと同じではいけない)
+///@param radius 半径(0～maxMedianRadius。0ならそのまま写す)
+///@param executor nullptrなら呼び出しスレッドだけで処理する。指定すれば行の帯ごとに並列化する
+///@remarks 半径1/2はKernelRegistryの"median"で選ばれるネットワーク、それ以外はRankFilterで処理する
+void MedianFilter(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, ComputeExecutor* executor);
+
+///順位フィルタ(ヒストグラムによる定数時間の方法)
+///@param radius 半径(0～maxMedianRadius)
+///@param rank 小さい方からの順位(0なら最小値、(2*radius+1)^2/2なら中央値、(2*radius+1)^2-1なら最大値)
+void RankFilter(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, unsigned int rank, ComputeExecutor* executor);
+
+///RankFilterの基準実装(画素・成分ごとに窓の値を集めてnth_elementで選ぶ)
+void RankFilterReference(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int radius, unsigned int rank);
+
+///窓の中央値の順位
+inline unsigned int MedianRank(unsigned int radius) {
+	return (2 * radius + 1) * (2 * radius + 1) / 2;
+}
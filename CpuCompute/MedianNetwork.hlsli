@@ -0,0 +1,48 @@
+//ltB^̔rlbg[N
+//RenderTargetFilter/MedianCS.hlslCPU(CpuCompute/MedianFilter.cpp)ŋL
+//ľ^(float4A__m256iȂ)ɍ킹āAgŎ̃}N`ĂWJ邱
+//  MEDIAN_SORT2(a, b) : a = min(a, b), b = max(a, b)
+//  MEDIAN_MIN(a, b)   : a = min(a, b)(b͂̂ƎgȂ)
+//  MEDIAN_MAX(a, b)   : b = max(a, b)(a͂̂ƎgȂ)
+//min/max͉f̐(CPU1oCg)Ȃ̂ŁAxNg̑Svf(f)𓯎ɏł
+//
+//̏c̗ɏɕ(MEDIAN_SORT_COLUMN3/5)Aׂɗׂ荇Ŏg܂킷
+//s[ * K + ](͑̍Aʂ͗̒ŏAK=3/5)ƂēnƁA
+//MEDIAN_SELECT9/25̂s[MEDIAN9_RESULT]/s[MEDIAN25_RESULT]̒lɂȂ
+//񂪕ł01̓(4^3/6^5ʂ)ׂĎĊm߂Ă(0-1ɂCӂ̒lŐ)
+
+//3vfɂ(c[0] <= c[1] <= c[2])
+#define MEDIAN_SORT_COLUMN3(c) \
+    MEDIAN_SORT2(c[0], c[1]) MEDIAN_SORT2(c[1], c[2]) MEDIAN_SORT2(c[0], c[1])
+
+//5vfɂ(9̔r)
+#define MEDIAN_SORT_COLUMN5(c) \
+    MEDIAN_SORT2(c[0], c[1]) MEDIAN_SORT2(c[3], c[4]) MEDIAN_SORT2(c[2], c[4]) MEDIAN_SORT2(c[2], c[3]) \
+    MEDIAN_SORT2(c[0], c[3]) MEDIAN_SORT2(c[0], c[2]) MEDIAN_SORT2(c[1], c[4]) MEDIAN_SORT2(c[1], c[3]) \
+    MEDIAN_SORT2(c[1], c[2])
+
+//3x3̒l(ׂ9vfBmin/max 12)
+#define MEDIAN9_RESULT 4
+#define MEDIAN_SELECT9(s) \
+    MEDIAN_MAX(s[0], s[3]) MEDIAN_MAX(s[3], s[6]) MEDIAN_SORT2(s[1], s[4]) MEDIAN_MAX(s[1], s[7]) \
+    MEDIAN_MIN(s[4], s[7]) MEDIAN_MIN(s[2], s[5]) MEDIAN_MIN(s[2], s[8]) MEDIAN_SORT2(s[2], s[4]) \
+    MEDIAN_MAX(s[2], s[6]) MEDIAN_MIN(s[4], s[6])
+
+//5x5̒l(ׂ25vfBmin/max 92)
+#define MEDIAN25_RESULT 12
+#define MEDIAN_SELECT25(s) \
+    MEDIAN_SORT2(s[0], s[5]) MEDIAN_SORT2(s[10], s[15]) MEDIAN_SORT2(s[5], s[15]) MEDIAN_MAX(s[5], s[10]) \
+    MEDIAN_MAX(s[0], s[20]) MEDIAN_MAX(s[10], s[20]) MEDIAN_SORT2(s[15], s[20]) MEDIAN_SORT2(s[1], s[6]) \
+    MEDIAN_SORT2(s[11], s[16]) MEDIAN_MAX(s[1], s[11]) MEDIAN_SORT2(s[6], s[16]) MEDIAN_SORT2(s[6], s[11]) \
+    MEDIAN_SORT2(s[11], s[21]) MEDIAN_MAX(s[6], s[11]) MEDIAN_SORT2(s[16], s[21]) MEDIAN_SORT2(s[2], s[7]) \
+    MEDIAN_SORT2(s[12], s[17]) MEDIAN_SORT2(s[2], s[12]) MEDIAN_SORT2(s[7], s[17]) MEDIAN_SORT2(s[7], s[12]) \
+    MEDIAN_MAX(s[2], s[22]) MEDIAN_SORT2(s[12], s[22]) MEDIAN_SORT2(s[7], s[12]) MEDIAN_MIN(s[17], s[22]) \
+    MEDIAN_SORT2(s[3], s[8]) MEDIAN_SORT2(s[13], s[18]) MEDIAN_SORT2(s[3], s[13]) MEDIAN_MIN(s[8], s[18]) \
+    MEDIAN_SORT2(s[8], s[13]) MEDIAN_SORT2(s[3], s[23]) MEDIAN_MIN(s[13], s[23]) MEDIAN_SORT2(s[8], s[13]) \
+    MEDIAN_SORT2(s[4], s[9]) MEDIAN_SORT2(s[14], s[19]) MEDIAN_SORT2(s[4], s[14]) MEDIAN_MIN(s[9], s[19]) \
+    MEDIAN_SORT2(s[4], s[24]) MEDIAN_MIN(s[14], s[24]) MEDIAN_MIN(s[9], s[14]) MEDIAN_MAX(s[3], s[7]) \
+    MEDIAN_MAX(s[11], s[15]) MEDIAN_SORT2(s[4], s[8]) MEDIAN_SORT2(s[12], s[16]) MEDIAN_SORT2(s[20], s[9]) \
+    MEDIAN_MIN(s[13], s[17]) MEDIAN_MAX(s[7], s[15]) MEDIAN_MAX(s[4], s[12]) MEDIAN_MIN(s[8], s[16]) \
+    MEDIAN_SORT2(s[20], s[13]) MEDIAN_SORT2(s[8], s[12]) MEDIAN_SORT2(s[15], s[8]) MEDIAN_MIN(s[13], s[21]) \
+    MEDIAN_SORT2(s[8], s[12]) MEDIAN_MIN(s[9], s[13]) MEDIAN_MIN(s[8], s[9]) MEDIAN_MAX(s[15], s[8]) \
+    MEDIAN_MIN(s[12], s[20]) MEDIAN_MAX(s[8], s[12])
@@ -0,0 +1,353 @@
+﻿#include "MonoFilter.h"
+#include<cmath>
+#include<algorithm>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+//シェーダと同じ1画素分の計算
+namespace hlsl {
+	namespace {
+#include"MonoPixel.hlsli"
+	}
+}
+
+using namespace std;
+
+namespace {
+	//BT.601の係数を15bit固定小数点にしたもの(合計32768)
+	//8bit(77/150/29)だと暗部でガンマの傾きが大きく1LSBに収まらないため15bitにしている
+	//15bitなら_mm_madd_epi16の符号付き16bitに収まる
+	constexpr int weightR = 9798;//0.299
+	constexpr int weightG = 19235;//0.587
+	constexpr int weightB = 3735;//0.114
+	//輝度の最大値は255*32768=65280*128なので、128で割って16bitのテーブル引きにする
+	constexpr int lumaShift = 7;
+	constexpr int lumaRound = 1 << (lumaShift - 1);
+	constexpr int lumaMax = 65280;
+
+	///pow(x,1/2.2)を8bitに丸めたテーブル(16bit輝度で引く)
+	///@remarks SIMDのgatherで4バイト単位で読んでも外に出ないよう末尾を余分にとっている
+	struct GammaTable {
+		uint8_t value[lumaMax + 1 + 3];
+		GammaTable() {
+			for (int i = 0; i <= lumaMax; ++i) {
+				value[i] = static_cast<uint8_t>(lround(255.0 * pow(static_cast<double>(i) / lumaMax, 1.0 / 2.2)));
+			}
+			value[lumaMax + 1] = value[lumaMax + 2] = value[lumaMax + 3] = 0;
+		}
+	};
+	const GammaTable& GetGammaTable() {
+		static GammaTable table;
+		return table;
+	}
+
+	///グレー値vをRGBに複製してA=1にする
+	inline uint32_t GrayPixel(uint32_t v) {
+		return v | (v << 8) | (v << 16) | 0xff000000;
+	}
+
+	void MonoRowScalar(const uint32_t* src, uint32_t* dst, size_t count) {
+		auto& table = GetGammaTable().value;
+		for (size_t i = 0; i < count; ++i) {
+			auto px = src[i];
+			int luma = (px & 0xff) * weightR + ((px >> 8) & 0xff) * weightG + ((px >> 16) & 0xff) * weightB;
+			dst[i] = GrayPixel(table[(luma + lumaRound) >> lumaShift]);
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+	CPU_TARGET_SSE41 void MonoRowSSE41(const uint32_t* src, uint32_t* dst, size_t count) {
+		auto& table = GetGammaTable().value;
+		const auto weight = _mm_setr_epi16(weightR, weightG, weightB, 0, weightR, weightG, weightB, 0);
+		alignas(16) uint32_t index[4];
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			//RGBAを16bitに広げて(R*wr+G*wg),(B*wb+A*0)の積和をとり、隣同士を足す
+			auto lo = _mm_madd_epi16(_mm_cvtepu8_epi16(px), weight);
+			auto hi = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(px, 8)), weight);
+			auto luma = _mm_srli_epi32(_mm_add_epi32(_mm_hadd_epi32(lo, hi), _mm_set1_epi32(lumaRound)), lumaShift);
+			_mm_store_si128(reinterpret_cast<__m128i*>(index), luma);
+			//SSEにはgatherがないのでテーブル引きはスカラーで
+			auto v = _mm_setr_epi32(table[index[0]], table[index[1]], table[index[2]], table[index[3]]);
+			v = _mm_or_si128(_mm_or_si128(v, _mm_slli_epi32(v, 8)), _mm_or_si128(_mm_slli_epi32(v, 16), _mm_set1_epi32(0xff000000)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+		}
+		MonoRowScalar(src + i, dst + i, count - i);
+	}
+
+	CPU_TARGET_AVX2 void MonoRowAVX2(const uint32_t* src, uint32_t* dst, size_t count) {
+		auto& table = GetGammaTable().value;
+		const auto weight = _mm256_setr_epi16(weightR, weightG, weightB, 0, weightR, weightG, weightB, 0,
+			weightR, weightG, weightB, 0, weightR, weightG, weightB, 0);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			auto px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			auto lo = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(px)), weight);
+			auto hi = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(px, 1)), weight);
+			//haddは128bitレーンごとなので[0,1,4,5|2,3,6,7]の順になる→並べなおす
+			auto sum = _mm256_permute4x64_epi64(_mm256_hadd_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+			auto luma = _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(lumaRound)), lumaShift);
+			//バイトのテーブルを4バイト単位でgatherして下位8bitだけ使う
+			auto v = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), luma, 1);
+			v = _mm256_and_si256(v, _mm256_set1_epi32(0xff));
+			v = _mm256_or_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 8)), _mm256_or_si256(_mm256_slli_epi32(v, 16), _mm256_set1_epi32(0xff000000)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+		}
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		MonoRowScalar(src + i, dst + i, count - i);
+	}
+
+	CPU_TARGET_AVX512 void MonoRowAVX512(const uint32_t* src, uint32_t* dst, size_t count) {
+		auto& table = GetGammaTable().value;
+		const auto weight = _mm512_set1_epi64(static_cast<long long>(weightR | (weightG << 16) | (static_cast<uint64_t>(weightB) << 32)));
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			auto px = _mm512_loadu_si512(src + i);
+			//(R*wr+G*wg),(B*wb)の組を64bitごとに足して下位32bitに輝度を得る
+			auto lo = _mm512_madd_epi16(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(px)), weight);
+			auto hi = _mm512_madd_epi16(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(px, 1)), weight);
+			lo = _mm512_add_epi32(lo, _mm512_srli_epi64(lo, 32));
+			hi = _mm512_add_epi32(hi, _mm512_srli_epi64(hi, 32));
+			auto sum = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(lo)), _mm512_cvtepi64_epi32(hi), 1);
+			auto luma = _mm512_srli_epi32(_mm512_add_epi32(sum, _mm512_set1_epi32(lumaRound)), lumaShift);
+			auto v = _mm512_i32gather_epi32(luma, table, 1);
+			v = _mm512_and_si512(v, _mm512_set1_epi32(0xff));
+			//v|v<<8|v<<16|0xff000000 (0xfeはA|B|C)
+			v = _mm512_ternarylogic_epi32(_mm512_or_si512(v, _mm512_slli_epi32(v, 8)), _mm512_slli_epi32(v, 16), _mm512_set1_epi32(0xff000000), 0xfe);
+			_mm512_storeu_si512(dst + i, v);
+		}
+		_mm256_zeroupper();
+		MonoRowScalar(src + i, dst + i, count - i);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	void MonoRowNEON(const uint32_t* src, uint32_t* dst, size_t count) {
+		auto& table = GetGammaTable().value;
+		alignas(16) uint32_t index[8];
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			//RGBAをチャンネルごとに分けて読む
+			auto px = vld4_u8(reinterpret_cast<const uint8_t*>(src + i));
+			auto r = vmovl_u8(px.val[0]);
+			auto g = vmovl_u8(px.val[1]);
+			auto b = vmovl_u8(px.val[2]);
+			auto lo = vmull_n_u16(vget_low_u16(r), weightR);
+			lo = vmlal_n_u16(lo, vget_low_u16(g), weightG);
+			lo = vmlal_n_u16(lo, vget_low_u16(b), weightB);
+			auto hi = vmull_n_u16(vget_high_u16(r), weightR);
+			hi = vmlal_n_u16(hi, vget_high_u16(g), weightG);
+			hi = vmlal_n_u16(hi, vget_high_u16(b), weightB);
+			vst1q_u32(index, vrshrq_n_u32(lo, lumaShift));
+			vst1q_u32(index + 4, vrshrq_n_u32(hi, lumaShift));
+			//NEONにはgatherがないのでテーブル引きはスカラーで
+			uint8_t gray[8];
+			for (int k = 0; k < 8; ++k) {
+				gray[k] = table[index[k]];
+			}
+			uint8x8x4_t out;
+			out.val[0] = out.val[1] = out.val[2] = vld1_u8(gray);
+			out.val[3] = vdup_n_u8(255);
+			vst4_u8(reinterpret_cast<uint8_t*>(dst + i), out);
+		}
+		MonoRowScalar(src + i, dst + i, count - i);
+	}
+#endif
+
+	using MonoRowFunc = void(*)(const uint32_t* src, uint32_t* dst, size_t count);
+	Kernel<MonoRowFunc> monoRow("mono", {
+		{ CpuIsa::Scalar, MonoRowScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, MonoRowSSE41 },
+		{ CpuIsa::AVX2, MonoRowAVX2 },
+		{ CpuIsa::AVX512, MonoRowAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, MonoRowNEON },
+#endif
+	});
+
+	//画像(スライス)ごとのsizes[i]の範囲を行の帯に分け、全部の帯を1回のParallelForで処理する
+	//srcRow(i,y)・dstRow(i,y)はi枚目のy行目の先頭。pitchは行の間隔(0なら画像の幅)で、幅と同じなら帯の行はつながっている
+	template<typename SrcRow, typename DstRow>
+	void MonoFilterBands(const vector<hlsl::uint2>& sizes, SrcRow srcRow, DstRow dstRow, unsigned int pitch, ComputeExecutor* executor) {
+		auto MonoRow = monoRow.Get();
+		//1つの帯は64K画素まで。小さい画像は1枚で1つの帯になる
+		constexpr unsigned int bandPixels = 64 * 1024;
+		struct Band {
+			unsigned int image, y, rows;
+		};
+		vector<Band> bands;
+		size_t totalPixels = 0;
+		for (unsigned int i = 0; i < sizes.size(); ++i) {
+			const auto size = sizes[i];
+			if (size.x == 0 || size.y == 0) {
+				continue;
+			}
+			const unsigned int bandRows = max(1u, bandPixels / size.x);
+			for (unsigned int y = 0; y < size.y; y += bandRows) {
+				bands.push_back({ i, y, min(bandRows, size.y - y) });
+			}
+			totalPixels += static_cast<size_t>(size.x) * size.y;
+		}
+		auto runBands = [&](size_t begin, size_t end) {
+			for (auto b = begin; b < end; ++b) {
+				const auto& band = bands[b];
+				const unsigned int w = sizes[band.image].x;
+				if (pitch == 0 || pitch == w) {
+					MonoRow(srcRow(band.image, band.y), dstRow(band.image, band.y), static_cast<size_t>(band.rows) * w);
+					continue;
+				}
+				for (unsigned int y = band.y; y < band.y + band.rows; ++y) {
+					MonoRow(srcRow(band.image, y), dstRow(band.image, y), w);
+				}
+			}
+		};
+		if (executor == nullptr || bands.empty()) {
+			runBands(0, bands.size());
+			return;
+		}
+		//1回に取る帯は合わせてbandPixelsくらいにする(64x64なら16枚)
+		const size_t averagePixels = max<size_t>(1, totalPixels / bands.size());
+		executor->ParallelFor(bands.size(), max<size_t>(1, bandPixels / averagePixels), runBands);
+	}
+}
+
+void
+MonoFilterReference(const ImageRGBA8& src, ImageRGBA8& dst) {
+	dst = ImageRGBA8(src.width, src.height);
+	for (size_t i = 0; i < src.pixels.size(); ++i) {
+		dst.pixels[i] = PackUnorm4x8(hlsl::MonoPixel(UnpackUnorm4x8(src.pixels[i])));
+	}
+}
+
+void
+MonoFilter(const ImageRGBA8& src, ImageRGBA8& dst, ComputeExecutor* executor) {
+	MonoFilter(src, dst, MonoFilterConfigFor(src.width, src.height), executor);
+}
+
+void
+MonoFilter(const ImageRGBA8& src, ImageRGBA8& dst, const TuneConfig& config, ComputeExecutor* executor) {
+	if (dst.width != src.width || dst.height != src.height) {
+		dst = ImageRGBA8(src.width, src.height);
+	}
+	auto MonoRow = monoRow.Get(config.isa);
+	if (MonoRow == nullptr) {
+		MonoRow = monoRow.Get();
+	}
+	if (executor == nullptr) {
+		MonoRow(src.pixels.data(), dst.pixels.data(), src.pixels.size());
+		return;
+	}
+	//グループ(タイル)ごとに並列化する
+	const unsigned int groupWidth = max(1u, min(config.groupSize.x, src.width));
+	const unsigned int groupHeight = max(1u, config.groupSize.y);
+	const size_t groupsX = (src.width + groupWidth - 1) / groupWidth;
+	const size_t groupsY = (src.height + groupHeight - 1) / groupHeight;
+	executor->ParallelFor(groupsX * groupsY, max(1u, config.groupsPerTask), [&](size_t begin, size_t end) {
+		for (auto g = begin; g < end; ++g) {
+			auto x = static_cast<unsigned int>(g % groupsX) * groupWidth;
+			auto y = static_cast<unsigned int>(g / groupsX) * groupHeight;
+			auto yEnd = min(y + groupHeight, src.height);
+			if (groupWidth == src.width) {
+				//全幅のグループは行がつながっているので1回で処理する
+				auto offset = static_cast<size_t>(y) * src.width;
+				MonoRow(src.pixels.data() + offset, dst.pixels.data() + offset, static_cast<size_t>(yEnd - y) * src.width);
+				continue;
+			}
+			auto count = min(groupWidth, src.width - x);
+			for (; y < yEnd; ++y) {
+				MonoRow(src.Row(y) + x, dst.Row(y) + x, count);
+			}
+		}
+	});
+}
+
+void
+MonoFilter(const vector<const ImageRGBA8*>& src, vector<ImageRGBA8>& dst, ComputeExecutor* executor) {
+	dst.resize(src.size());
+	vector<const uint32_t*> in(src.size());
+	vector<uint32_t*> out(src.size());
+	vector<hlsl::uint2> sizes(src.size());
+	for (size_t i = 0; i < src.size(); ++i) {
+		if (dst[i].width != src[i]->width || dst[i].height != src[i]->height) {
+			dst[i] = ImageRGBA8(src[i]->width, src[i]->height);
+		}
+		in[i] = src[i]->pixels.data();
+		out[i] = dst[i].pixels.data();
+		sizes[i] = { src[i]->width, src[i]->height };
+	}
+	MonoFilterBands(sizes, [&](unsigned int i, unsigned int y) {return in[i] + static_cast<size_t>(y) * sizes[i].x; },
+		[&](unsigned int i, unsigned int y) {return out[i] + static_cast<size_t>(y) * sizes[i].x; }, 0, executor);
+}
+
+void
+MonoFilter(const ImageArrayRGBA8& src, ImageArrayRGBA8& dst, ComputeExecutor* executor) {
+	ResizeImageArrayLike(src, dst);
+	MonoFilterBands(src.sizes, [&](unsigned int s, unsigned int y) {return src.Row(s, y); },
+		[&](unsigned int s, unsigned int y) {return dst.Row(s, y); }, src.width, executor);
+}
+
+TuneConfig
+MonoFilterDefaultConfig(unsigned int width, unsigned int height) {
+	//行の帯はL2に収まる程度の大きさにしておく(画像より高い帯にはしない)
+	constexpr unsigned int bandPixels = 64 * 1024;
+	TuneConfig config;
+	config.isa = monoRow.SelectedIsa();
+	config.groupSize = { max(width, 1u),min(max(1u, bandPixels / max(width, 1u)), max(height, 1u)) };
+	config.groupsPerTask = 1;
+	return config;
+}
+
+TuneConfig
+MonoFilterConfigFor(unsigned int width, unsigned int height) {
+	TuneConfig config;
+	if (TuneTable::Instance().Find("mono", width, height, config) && CpuIsaIncludes(monoRow.SelectedIsa(), config.isa)) {
+		return config;
+	}
+	return MonoFilterDefaultConfig(width, height);
+}
+
+vector<TuneConfig>
+MonoFilterTuneCandidates(unsigned int width, unsigned int height) {
+	const unsigned int w = max(width, 1u);
+	//全幅の帯(1,4,16行と64K画素ぶん)と、正方形に近いタイル
+	const hlsl::uint2 shapes[] = {
+		{ w,1 },{ w,4 },{ w,16 },{ w,max(1u, 64 * 1024 / w) },
+		{ 64,64 },{ 256,16 },{ 256,64 },
+	};
+	const unsigned int groupsPerTasks[] = { 1,4 };
+	vector<TuneConfig> candidates;
+	for (auto isa : monoRow.Isas()) {
+		if (!IsCpuIsaSupported(isa)) {
+			continue;
+		}
+		for (auto& shape : shapes) {
+			for (auto groupsPerTask : groupsPerTasks) {
+				TuneConfig config;
+				config.isa = isa;
+				config.groupSize = { min(shape.x, w),min(shape.y, max(height, 1u)) };
+				config.groupsPerTask = groupsPerTask;
+				//小さい画像では形が同じになるものがある
+				auto same = [&](const TuneConfig& c) {
+					return c.isa == config.isa && all(c.groupSize == config.groupSize) && c.groupsPerTask == config.groupsPerTask;
+				};
+				if (none_of(candidates.begin(), candidates.end(), same)) {
+					candidates.push_back(config);
+				}
+			}
+		}
+	}
+	return candidates;
+}
+
+const char*
+MonoFilterVariantName() {
+	return CpuIsaName(monoRow.SelectedIsa());
+}
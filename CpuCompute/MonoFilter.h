@@ -0,0 +1,52 @@
+﻿#pragma once
+#include<vector>
+#include"Image.h"
+#include"ImageArray.h"
+#include"Autotune.h"
+
+class ComputeExecutor;
+
+//FilterCS.hlslのMonoCS(BT.601の輝度 → pow(saturate(b),1/2.2))のCPU版
+
+///MonoCSと同じ計算をシェーダと共有のMonoPixel.hlsliで行う(検証用の基準実装)
+///@param src 入力画像
+///@param dst 出力画像(srcと同じサイズにされる)
+void MonoFilterReference(const ImageRGBA8& src, ImageRGBA8& dst);
+
+///MonoCSの高速版
+///輝度は15bit固定小数点の整数積和、ガンマはpowの代わりに16bit輝度で引くテーブルで求める。
+///MonoFilterReferenceとの差は1LSB以内
+///@param src 入力画像
+///@param dst 出力画像(srcと同じサイズにされる)
+///@param executor nullptrなら呼び出しスレッドだけで処理する。指定すれば行の帯ごとに並列化する
+///@remarks TuneTableにこのCPU・解像度の"mono"の結果があればその設定で実行する(MonoFilterConfigFor)
+void MonoFilter(const ImageRGBA8& src, ImageRGBA8& dst, ComputeExecutor* executor = nullptr);
+
+///設定を指定してMonoCSの高速版を実行する
+///@param config 命令セット、グループ(タイル)の形、タスクあたりのグループ数
+///@remarks config.isaが使えなければ選ばれている実装で実行する
+void MonoFilter(const ImageRGBA8& src, ImageRGBA8& dst, const TuneConfig& config, ComputeExecutor* executor);
+
+///たくさんの画像にMonoCSの高速版をかける(1枚ずつ呼ぶとParallelForの手間が画像ごとにかかる小さい画像向け)
+///画像を行の帯に分け、全部の画像の帯を1つの並びにして1回のParallelForで処理する(画像はまとめてコピーしない)
+///@param dst 出力(srcと同じ枚数・大きさにされる)
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+void MonoFilter(const std::vector<const ImageRGBA8*>& src, std::vector<ImageRGBA8>& dst, ComputeExecutor* executor);
+
+///配列の全スライスにMonoCSの高速版をかける(TextureFilter/FilterArrayCS.hlslのMonoArrayCSのCPU版)
+///スライスの画像の範囲だけを、上と同じく1回のParallelForで処理する(詰め物のところは書かない)
+///@param dst 出力(srcと同じ大きさ・スライスの表にされる)
+void MonoFilter(const ImageArrayRGBA8& src, ImageArrayRGBA8& dst, ComputeExecutor* executor);
+
+///調整していないときの設定(選ばれている実装で、64K画素ぶんの行の帯を1グループにする)
+TuneConfig MonoFilterDefaultConfig(unsigned int width, unsigned int height);
+
+///MonoFilterが使う設定
+///TuneTableに結果があり、その命令セットが今の選択(CPUCOMPUTE_ISAの制限)に含まれていればそれを、なければ既定の設定を返す
+TuneConfig MonoFilterConfigFor(unsigned int width, unsigned int height);
+
+///自動調整で試す設定(このCPUで使える命令セット×グループの形×タスクあたりのグループ数)
+std::vector<TuneConfig> MonoFilterTuneCandidates(unsigned int width, unsigned int height);
+
+///MonoFilterで今使われている実装の命令セット名(KernelRegistryの"mono")
+const char* MonoFilterVariantName();
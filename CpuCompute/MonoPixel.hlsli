@@ -0,0 +1,11 @@
+//mNH1f̌vZ
+//FilterCS.hlslCPU(CpuCompute)ŋLĂ܂B
+//C++łHlslTypes.hǂݍ񂾂namespace hlsl̒(O)includê
+//HLSLC++̗Œʂ鏑gĂB
+float4 MonoPixel(float4 src)
+{
+    //https://ja.wikipedia.org/wiki/YUV 
+    float b = dot(src.rgb, float3(0.299,0.587,0.114));
+    b=pow(saturate(b),1.0/2.2);
+    return float4(b,b,b, 1);
+}
@@ -0,0 +1,114 @@
+﻿#include "Outline.h"
+#include<algorithm>
+#include<cassert>
+#include<vector>
+#include"ComputeExecutor.h"
+
+//シェーダと同じ近傍の値と輪郭線の濃さ
+namespace hlsl {
+	namespace {
+#include"Outline.hlsli"
+	}
+}
+
+using namespace std;
+using hlsl::float4;
+using hlsl::OutlineSample;
+
+namespace {
+	//並列化するときの1回に取る行数(帯の最初に上下の行を余分に変換するので、小さすぎないように)
+	constexpr size_t outlineGrainRows = 16;
+
+	void PrepareOutput(const ImageRGBA32F& color, const ImageRGBA32F& geometry, ImageRGBA32F& dst) {
+		assert(&dst != &color && geometry.width == color.width && geometry.height == color.height);
+		dst.width = color.width;
+		dst.height = color.height;
+		dst.pixels.resize(color.pixels.size());
+	}
+
+	void MakeSampleRow(const ImageRGBA32F& color, const ImageRGBA32F& geometry, unsigned int y, OutlineSample* out) {
+		const float4* c = color.Row(y);
+		const float4* g = geometry.Row(y);
+		for (unsigned int x = 0; x < color.width; ++x) {
+			out[x] = hlsl::MakeOutlineSample(c[x], g[x]);
+		}
+	}
+
+	//[y0,y1)の行に輪郭線を描く。近傍の値は3行分を回して使う(端は端の画素を繰り返す)
+	void OutlineRows(const ImageRGBA32F& color, const ImageRGBA32F& geometry, ImageRGBA32F& dst, const OutlineSettings& settings, size_t y0, size_t y1) {
+		const unsigned int width = color.width;
+		const unsigned int last = color.height - 1;
+		vector<OutlineSample> ring(static_cast<size_t>(width) * 3);
+		auto rowOf = [&](unsigned int y) { return ring.data() + static_cast<size_t>(y % 3) * width; };
+		const auto first = static_cast<unsigned int>(y0);
+		if (first > 0) {
+			MakeSampleRow(color, geometry, first - 1, rowOf(first - 1));
+		}
+		MakeSampleRow(color, geometry, first, rowOf(first));
+		for (auto y = first; y < y1; ++y) {
+			if (y < last) {
+				MakeSampleRow(color, geometry, y + 1, rowOf(y + 1));
+			}
+			const OutlineSample* rows[3] = { rowOf(y > 0 ? y - 1 : 0), rowOf(y), rowOf(y < last ? y + 1 : last) };
+			const float4* in = color.Row(y);
+			float4* out = dst.Row(y);
+			for (unsigned int x = 0; x < width; ++x) {
+				const unsigned int xs[3] = { x > 0 ? x - 1 : 0, x, x + 1 < width ? x + 1 : x };
+				float mask = 0.0f;
+				for (int r = 0; r < 3; ++r) {
+					mask = max(mask, max(rows[r][xs[0]].mask, max(rows[r][xs[1]].mask, rows[r][xs[2]].mask)));
+				}
+				if (mask == 0.0f) {
+					//OutlineStrengthも0を返すので、近傍を集めずに済ませる
+					out[x] = hlsl::ApplyOutline(in[x], 0.0f, settings.color);
+					continue;
+				}
+				OutlineSample taps[9];
+				for (int r = 0; r < 3; ++r) {
+					for (int c = 0; c < 3; ++c) {
+						taps[r * 3 + c] = rows[r][xs[c]];
+					}
+				}
+				const float strength = hlsl::OutlineStrength(taps, settings.colorThreshold, settings.depthThreshold, settings.normalThreshold);
+				out[x] = hlsl::ApplyOutline(in[x], strength, settings.color);
+			}
+		}
+	}
+}
+
+void
+Outline(const ImageRGBA32F& color, const ImageRGBA32F& geometry, ImageRGBA32F& dst, const OutlineSettings& settings, ComputeExecutor* executor) {
+	PrepareOutput(color, geometry, dst);
+	if (color.pixels.empty()) {
+		return;
+	}
+	if (executor != nullptr) {
+		executor->ParallelFor(color.height, outlineGrainRows, [&](size_t begin, size_t end) {
+			OutlineRows(color, geometry, dst, settings, begin, end);
+		});
+	}
+	else {
+		OutlineRows(color, geometry, dst, settings, 0, color.height);
+	}
+}
+
+void
+OutlineReference(const ImageRGBA32F& color, const ImageRGBA32F& geometry, ImageRGBA32F& dst, const OutlineSettings& settings) {
+	PrepareOutput(color, geometry, dst);
+	const int w = static_cast<int>(color.width);
+	const int h = static_cast<int>(color.height);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			OutlineSample taps[9];
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dx = -1; dx <= 1; ++dx) {
+					const auto sx = static_cast<unsigned int>(clamp(x + dx, 0, w - 1));
+					const auto sy = static_cast<unsigned int>(clamp(y + dy, 0, h - 1));
+					taps[(dy + 1) * 3 + dx + 1] = hlsl::MakeOutlineSample(color.At(sx, sy), geometry.At(sx, sy));
+				}
+			}
+			const float strength = hlsl::OutlineStrength(taps, settings.colorThreshold, settings.depthThreshold, settings.normalThreshold);
+			dst.At(x, y) = hlsl::ApplyOutline(color.At(x, y), strength, settings.color);
+		}
+	}
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+#include"Image.h"
+
+class ComputeExecutor;
+
+//スクリーンスペースの輪郭線
+//RenderTargetFilter/OutlineCS.hlslのCPU版。1画素分の計算はOutline.hlsliをシェーダと共有する
+//モデルを描くときに、色と一緒にジオメトリ画像(ビュー空間の法線xy・深度・マテリアルのedgeFlg)を書いておき、
+//3x3の近傍の輝度(Sobel)・深度・法線の不連続を輪郭線にする。edgeFlgが0のマテリアルには描かない
+//(裏返して膨らませたモデルをもう一度描くやり方と違い、手間はポリゴン数によらず画素数だけで決まる)
+//  CPU版は帯ごとに3行分の近傍の値(OutlineSample)を求めておき、1画素につき1回だけ変換する。
+//  近傍にedgeFlgのマテリアルがない画素(背景など)は近傍を集めずに済ませる
+
+///ジオメトリ画像の背景の深度(R16G16B16A16_FLOATの最大。クリアする値)
+constexpr float outlineBackgroundDepth = 65504.0f;
+
+///輪郭線の設定
+struct OutlineSettings {
+	float colorThreshold = 0.25f;//輝度(luma/(1+luma))のSobelの大きさ
+	float depthThreshold = 0.05f;//深度の2階差分/深度
+	float normalThreshold = 0.3f;//法線の角度の差(1-cos)
+	hlsl::float4 color = hlsl::float4(0.0f, 0.0f, 0.0f, 1.0f);//線の色(aは不透明度)
+};
+
+///輪郭線を描く
+///@param color 色の画像
+///@param geometry ジオメトリ画像(colorと同じ大きさ)
+///@param dst 出力画像(colorと同じ大きさにされる。colorと同じではいけない)
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+void Outline(const ImageRGBA32F& color, const ImageRGBA32F& geometry, ImageRGBA32F& dst, const OutlineSettings& settings, ComputeExecutor* executor);
+
+///Outlineの基準実装(1画素ずつ、近傍の9画素をその場で変換する。OutlineCS.hlslのタイルを使わない書き方と同じ)
+void OutlineReference(const ImageRGBA32F& color, const ImageRGBA32F& geometry, ImageRGBA32F& dst, const OutlineSettings& settings);
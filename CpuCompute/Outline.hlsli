@@ -0,0 +1,71 @@
+//XN[Xy[X̗֊s1f̌vZ
+//RenderTargetFilter/OutlineCS.hlslCPU(CpuCompute/Outline.cpp)ŋLĂ܂(MonoPixel.hlsliƓ)B
+//WIg摜(f`ƂBasicPixelShader.hlsl2ڂ̃_[^[Qbgɏ)1f
+//  xy : r[Ԃ̖@xy(ʂ̓JĂ̂ŁAz-sqrt(1-x^2-y^2))
+//  z  : r[Ԃ̐[x(wi͑傫Ȓl)
+//  w  : ֊s`(}eAedgeFlgBwi0)
+
+//ߖT1f̒l(1fɂ1񋁂߂āAߖT9fŎg)
+struct OutlineSample
+{
+    float luma;//F̋Pxluma/(1+luma)ɏk߂(HDRł邢Ƃ̍Ȃ)
+    float depth;
+    float3 normal;
+    float mask;
+};
+
+OutlineSample MakeOutlineSample(float4 color, float4 geometry)
+{
+    OutlineSample s;
+    float luma = max(dot(color.rgb, float3(0.299f, 0.587f, 0.114f)), 0.0f);
+    s.luma = luma / (1.0f + luma);
+    s.depth = geometry.z;
+    s.normal = float3(geometry.x, geometry.y, -sqrt(saturate(1.0f - geometry.x * geometry.x - geometry.y * geometry.y)));
+    s.mask = geometry.w;
+    return s;
+}
+
+//threshold0A2{1ɂȂ
+float OutlineRamp(float value, float threshold)
+{
+    return saturate(value / threshold - 1.0f);
+}
+
+//֊s̔Z(0`1)
+//taps : 3x3̋ߖT(ォsƁBtaps[4]S)
+//  F : PxSobel̑傫
+//  [x : c2K𒆐S̐[xŊ(Xʂ0ɂȂ̂ŁAʂ̓rɂ͏oȂ)
+//  @ : \4ߖTƂ̊px̍(1-cos)̍ő
+//ǂꂩ1ł臒l𒴂ƂɁAߖTedgeFlg̃}eAΕ`(VGbg̊Oɂ1fo)
+float OutlineStrength(OutlineSample taps[9], float colorThreshold, float depthThreshold, float normalThreshold)
+{
+    float mask = 0.0f;
+    for (int i = 0; i < 9; ++i)
+    {
+        mask = max(mask, taps[i].mask);
+    }
+    if (mask == 0.0f)
+    {
+        return 0.0f;//ߖTedgeFlg̃}eAȂ(wiȂ)Ƃׂ͒Ȃ
+    }
+    float gx = (taps[2].luma + 2.0f * taps[5].luma + taps[8].luma) - (taps[0].luma + 2.0f * taps[3].luma + taps[6].luma);
+    float gy = (taps[6].luma + 2.0f * taps[7].luma + taps[8].luma) - (taps[0].luma + 2.0f * taps[1].luma + taps[2].luma);
+    float colorEdge = sqrt(gx * gx + gy * gy);
+
+    float d = taps[4].depth;
+    float depthEdge = max(abs(taps[3].depth + taps[5].depth - 2.0f * d), abs(taps[1].depth + taps[7].depth - 2.0f * d)) / max(d, 1e-4f);
+
+    float3 n = taps[4].normal;
+    float cosMin = min(min(dot(n, taps[1].normal), dot(n, taps[3].normal)), min(dot(n, taps[5].normal), dot(n, taps[7].normal)));
+    float normalEdge = 1.0f - cosMin;
+
+    float edge = max(OutlineRamp(colorEdge, colorThreshold), max(OutlineRamp(depthEdge, depthThreshold), OutlineRamp(normalEdge, normalThreshold)));
+    return edge * mask;
+}
+
+//֊s̐Fd˂(outlineColor.a͕sxBAt@͂̂܂)
+float4 ApplyOutline(float4 color, float strength, float4 outlineColor)
+{
+    float t = strength * outlineColor.a;
+    return float4(color.rgb + (outlineColor.rgb - color.rgb) * t, color.a);
+}
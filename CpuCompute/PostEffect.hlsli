@@ -0,0 +1,42 @@
+//tB^Ot̓_Ƃ̏(fƂɓƗŁAׂ荇̂1pXɂ܂Ƃ߂Ďs)
+//RenderTargetFilter/PostEffectCS.hlslCPU(CpuCompute/FilterGraphRunner.cpp)ŋLĂ܂
+//MonoPixel.hlsliColorOps.hlsliincludeĂ
+//lCpuCompute/FilterGraph.hFilterKindƓ
+
+#define POSTFX_MONO 0//MonoPixel
+#define POSTFX_GRAYSCALE 1//BT.601̋PxŊDFɂ
+#define POSTFX_GAMMA 2//param.x : K}
+#define POSTFX_CONTRAST 3//param.x : 0.5𒆐Sɉ{ɂ邩
+#define POSTFX_TINT 4//param.rgb : ƂɊ|
+#define POSTFX_ADD 5//1̓͂param{đ
+
+//1pXɂ܂Ƃ߂_Ƃ̏̐ƁAǉ̓(POSTFX_ADD̂1̓)̐̏
+#define POSTFX_MAX_OPS 8
+#define POSTFX_MAX_EXTRA_INPUTS 2
+
+//_Ƃ̏1(At@͕ςȂBMONO1ɂ)
+//extra : POSTFX_ADD̂1̓͂̓ʒủf
+float4 PointwiseOp(uint op, float4 param, float4 c, float4 extra)
+{
+    if (op == POSTFX_MONO)
+    {
+        return MonoPixel(c);
+    }
+    if (op == POSTFX_GRAYSCALE)
+    {
+        return float4(ColorGrayscale(c.rgb), c.a);
+    }
+    if (op == POSTFX_GAMMA)
+    {
+        return float4(ColorGamma(c.rgb, param.x), c.a);
+    }
+    if (op == POSTFX_CONTRAST)
+    {
+        return float4(ColorContrast(c.rgb, param.x), c.a);
+    }
+    if (op == POSTFX_TINT)
+    {
+        return float4(ColorTint(c.rgb, param.rgb), c.a);
+    }
+    return float4(c.rgb + extra.rgb * param.rgb, c.a);
+}
@@ -0,0 +1,28 @@
+//\[g̃L[(ȂƂĔׂƂ̏̒l̏ɂȂ)ƌ̎o
+//RadixSortCS.hlslCPU(CpuCompute/RadixSort.cpp)ŋLĂ܂
+
+//:rbg𔽓]
+uint IntToSortableKey(int value)
+{
+    return (uint)value ^ 0x80000000;
+}
+
+//_:̐͑SrbgAȊO͕rbg𔽓]
+//(-0+0̒OɁANaN͗[ɕ)
+uint FloatToSortableKey(float value)
+{
+    uint bits = asuint(value);
+    return bits ^ ((bits >> 31) != 0 ? 0xffffffff : 0x80000000);
+}
+
+//FloatToSortableKey̋t
+float SortableKeyToFloat(uint key)
+{
+    return asfloat(key ^ ((key >> 31) != 0 ? 0x80000000 : 0xffffffff));
+}
+
+//shiftrbgڂ8bit(1pXŕׂ錅)
+uint RadixDigit(uint key, uint shift)
+{
+    return (key >> shift) & 0xff;
+}
@@ -0,0 +1,340 @@
+﻿#include "RadixSort.h"
+#include<algorithm>
+#include<cassert>
+#include<cstring>
+#include<functional>
+#include"ComputeExecutor.h"
+#include"HlslTypes.h"
+#include"CpuFeatures.h"
+
+#if defined(CPU_ARCH_X86)
+#include<emmintrin.h>
+#endif
+
+//シェーダと同じキーの変換
+namespace hlsl {
+	namespace {
+#include"RadixKey.hlsli"
+	}
+}
+
+using namespace std;
+
+namespace {
+	constexpr unsigned int radixBits = 8;
+	constexpr size_t radix = size_t(1) << radixBits;
+	constexpr unsigned int passNum = 32 / radixBits;
+	//ブロック(並列化の単位)の最小要素数。これより小さく分けてもヒストグラムの手間が増えるだけ
+	constexpr size_t minBlockElements = 64 * 1024;
+	//write-combiningで桁ごとにためる要素数(4バイトのキーならキャッシュライン1本)
+	constexpr size_t combineElements = 16;
+	constexpr size_t lineAlignment = 64;
+	//要素の大きさが実行時にしか決まらないとき
+	constexpr size_t anyStride = ~size_t(0);
+
+	inline unsigned int Digit(uint32_t key, unsigned int pass) {
+		return hlsl::RadixDigit(key, pass * radixBits);
+	}
+
+	//要素の先頭4バイトがキー
+	inline uint32_t KeyAt(const uint8_t* elements, size_t stride, size_t i) {
+		uint32_t key;
+		memcpy(&key, elements + i * stride, sizeof(key));
+		return key;
+	}
+
+	//全パスの桁の出現数を1回読むだけで数える(counts:パス×256)
+	void CountAllDigits(const uint8_t* elements, size_t stride, size_t begin, size_t end, uint32_t* counts) {
+		fill(counts, counts + passNum * radix, 0u);
+		for (auto i = begin; i < end; ++i) {
+			auto key = KeyAt(elements, stride, i);
+			for (unsigned int pass = 0; pass < passNum; ++pass) {
+				++counts[pass * radix + Digit(key, pass)];
+			}
+		}
+	}
+
+	void CountDigits(const uint8_t* elements, size_t stride, size_t begin, size_t end, unsigned int pass, uint32_t* counts) {
+		fill(counts, counts + radix, 0u);
+		for (auto i = begin; i < end; ++i) {
+			++counts[Digit(KeyAt(elements, stride, i), pass)];
+		}
+	}
+
+	//ためた要素をキャッシュラインの境界からbytesバイト書く
+	inline void StoreLines(uint8_t* dst, const uint8_t* src, size_t bytes) {
+#if defined(CPU_ARCH_X86)
+		//書き込み先を読み込まない(RFOしない)ストリーミングストア
+		for (size_t offset = 0; offset < bytes; offset += sizeof(__m128i)) {
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + offset), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset)));
+		}
+#else
+		memcpy(dst, src, bytes);
+#endif
+	}
+
+	///[begin,end)を今の桁で書き出す
+	///256か所に散った書き込みを1要素ずつ行うと、ラインの読み込みとストアバッファの詰まりで遅いので、
+	///桁ごとに書き込み先のキャッシュラインに合わせてcombineElements個ためておき、埋まったらまとめて書く
+	///@param offsets 桁ごとの書き込み位置
+	///@param combine 桁ごとにcombineElements個の要素をためておく領域
+	template<size_t Stride>
+	void ScatterBlock(const uint8_t* src, uint8_t* dst, size_t stride, size_t begin, size_t end, unsigned int pass, const uint32_t* offsets, uint8_t* combine) {
+		const size_t size = Stride == anyStride ? stride : Stride;
+		const size_t combineBytes = combineElements * size;
+		//ラインを丸ごと書けるのは、combineElements個がラインの整数倍になるときだけ
+		const bool streaming = combineBytes % lineAlignment == 0;
+		//書き込み先の先頭が何要素ぶんラインの境界からずれているか(4バイトの要素か、64バイト境界に置いた配列であること)
+		const auto baseMisalign = reinterpret_cast<uintptr_t>(dst) % lineAlignment / size;
+		assert(!streaming || reinterpret_cast<uintptr_t>(dst) % lineAlignment == baseMisalign * size);
+
+		//lineStart:ためている要素の先頭(slot 0)の書き込み位置。書き込み先がラインの境界になるよう、最初は途中のslotから始める
+		ptrdiff_t lineStart[radix];
+		uint32_t first[radix];
+		uint32_t filled[radix];
+		for (size_t d = 0; d < radix; ++d) {
+			auto misalign = static_cast<uint32_t>((baseMisalign + offsets[d]) % combineElements);
+			lineStart[d] = static_cast<ptrdiff_t>(offsets[d]) - misalign;
+			first[d] = misalign;
+			filled[d] = misalign;
+		}
+		auto flush = [&](size_t d, uint32_t to) {
+			memcpy(dst + (lineStart[d] + first[d]) * size, combine + d * combineBytes + first[d] * size, (to - first[d]) * size);
+		};
+		for (auto i = begin; i < end; ++i) {
+			auto element = src + i * size;
+			auto d = Digit(KeyAt(element, 0, 0), pass);
+			memcpy(combine + d * combineBytes + filled[d] * size, element, size);
+			if (++filled[d] == combineElements) {
+				if (streaming && first[d] == 0) {
+					StoreLines(dst + lineStart[d] * size, combine + d * combineBytes, combineBytes);
+				}
+				else {
+					flush(d, combineElements);
+				}
+				lineStart[d] += combineElements;
+				first[d] = 0;
+				filled[d] = 0;
+			}
+		}
+		for (size_t d = 0; d < radix; ++d) {
+			if (filled[d] > first[d]) {
+				flush(d, filled[d]);
+			}
+		}
+#if defined(CPU_ARCH_X86)
+		//ストリーミングストアは順序が保証されないので、他のスレッドが読む前に完了させる
+		_mm_sfence();
+#endif
+	}
+
+	using ScatterFunc = void(*)(const uint8_t* src, uint8_t* dst, size_t stride, size_t begin, size_t end, unsigned int pass, const uint32_t* offsets, uint8_t* combine);
+
+	//よく使う大きさは要素のコピーを定数の大きさにする
+	ScatterFunc SelectScatter(size_t stride) {
+		switch (stride) {
+		case 4:
+			return ScatterBlock<4>;
+		case 8:
+			return ScatterBlock<8>;
+		case 12:
+			return ScatterBlock<12>;
+		case 16:
+			return ScatterBlock<16>;
+		case 20:
+			return ScatterBlock<20>;
+		default:
+			return ScatterBlock<anyStride>;
+		}
+	}
+
+	//bytesバイトの領域を64バイト境界から取る
+	uint8_t* AlignedBuffer(vector<uint8_t>& buffer, size_t bytes) {
+		buffer.resize(bytes + lineAlignment);
+		auto p = reinterpret_cast<uintptr_t>(buffer.data());
+		return buffer.data() + (lineAlignment - p % lineAlignment) % lineAlignment;
+	}
+
+	//[0,count)をexecutorのスレッドで分けて実行する
+	void ForRange(ComputeExecutor* executor, size_t count, const function<void(size_t begin, size_t end)>& func) {
+		if (executor != nullptr) {
+			executor->ParallelFor(count, minBlockElements, func);
+		}
+		else {
+			func(0, count);
+		}
+	}
+}
+
+void
+ToSortableKeys(const float* values, uint32_t* keys, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		keys[i] = hlsl::FloatToSortableKey(values[i]);
+	}
+}
+
+void
+ToSortableKeys(const int32_t* values, uint32_t* keys, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		keys[i] = hlsl::IntToSortableKey(values[i]);
+	}
+}
+
+void
+FromSortableKeys(const uint32_t* keys, float* values, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		values[i] = hlsl::SortableKeyToFloat(keys[i]);
+	}
+}
+
+void
+FromSortableKeys(const uint32_t* keys, int32_t* values, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		values[i] = static_cast<int32_t>(keys[i] ^ 0x80000000u);
+	}
+}
+
+void
+RadixSorter::SortKeys(uint32_t* keys, size_t count, ComputeExecutor* executor) {
+	auto sorted = Sort(reinterpret_cast<uint8_t*>(keys), sizeof(uint32_t), count, executor);
+	if (sorted != reinterpret_cast<uint8_t*>(keys)) {
+		ForRange(executor, count, [&](size_t begin, size_t end) {
+			memcpy(keys + begin, sorted + begin * sizeof(uint32_t), (end - begin) * sizeof(uint32_t));
+		});
+	}
+}
+
+uint8_t*
+RadixSorter::Pack(size_t stride, size_t count) {
+	return AlignedBuffer(packed_, stride * count);
+}
+
+void
+RadixSorter::SortPairs(uint32_t* keys, uint32_t* values, size_t count, ComputeExecutor* executor) {
+	constexpr size_t stride = 2 * sizeof(uint32_t);
+	auto packed = Pack(stride, count);
+	ForRange(executor, count, [&](size_t begin, size_t end) {
+		for (auto i = begin; i < end; ++i) {
+			memcpy(packed + i * stride, keys + i, sizeof(uint32_t));
+			memcpy(packed + i * stride + sizeof(uint32_t), values + i, sizeof(uint32_t));
+		}
+	});
+	auto sorted = Sort(packed, stride, count, executor);
+	ForRange(executor, count, [&](size_t begin, size_t end) {
+		for (auto i = begin; i < end; ++i) {
+			memcpy(keys + i, sorted + i * stride, sizeof(uint32_t));
+			memcpy(values + i, sorted + i * stride + sizeof(uint32_t), sizeof(uint32_t));
+		}
+	});
+}
+
+void
+RadixSorter::SortRecordBytes(uint8_t* records, size_t recordSize, size_t count, size_t keyOffset, RadixKeyType keyType, ComputeExecutor* executor) {
+	//4バイトのキーの後ろにレコードを置く(4バイトの倍数にそろえて、ラインを丸ごと書けるようにする)
+	const size_t stride = sizeof(uint32_t) + (recordSize + 3) / 4 * 4;
+	auto packed = Pack(stride, count);
+	ForRange(executor, count, [&](size_t begin, size_t end) {
+		for (auto i = begin; i < end; ++i) {
+			auto record = records + i * recordSize;
+			uint32_t bits;
+			memcpy(&bits, record + keyOffset, sizeof(bits));
+			switch (keyType) {
+			case RadixKeyType::Int:
+				bits = hlsl::IntToSortableKey(static_cast<int>(bits));
+				break;
+			case RadixKeyType::Float:
+				bits = hlsl::FloatToSortableKey(hlsl::asfloat(bits));
+				break;
+			default:
+				break;
+			}
+			memcpy(packed + i * stride, &bits, sizeof(bits));
+			memcpy(packed + i * stride + sizeof(uint32_t), record, recordSize);
+		}
+	});
+	auto sorted = Sort(packed, stride, count, executor);
+	ForRange(executor, count, [&](size_t begin, size_t end) {
+		for (auto i = begin; i < end; ++i) {
+			memcpy(records + i * recordSize, sorted + i * stride + sizeof(uint32_t), recordSize);
+		}
+	});
+}
+
+uint8_t*
+RadixSorter::Sort(uint8_t* elements, size_t stride, size_t count, ComputeExecutor* executor) {
+	//書き込み位置はuint32_t(GPUのバッファと同じ)
+	assert(count <= UINT32_MAX);
+	if (count < 2) {
+		return elements;
+	}
+	size_t blockNum = 1;
+	if (executor != nullptr) {
+		blockNum = max<size_t>(1, min<size_t>(executor->ThreadCount(), count / minBlockElements));
+	}
+	const size_t blockSize = (count + blockNum - 1) / blockNum;
+	auto forEachBlock = [&](const function<void(size_t b, size_t begin, size_t end)>& func) {
+		auto run = [&](size_t first, size_t last) {
+			for (auto b = first; b < last; ++b) {
+				func(b, b * blockSize, min(count, (b + 1) * blockSize));
+			}
+		};
+		if (blockNum > 1) {
+			executor->ParallelFor(blockNum, 1, run);
+		}
+		else {
+			run(0, blockNum);
+		}
+	};
+
+	auto tmp = AlignedBuffer(tmp_, count * stride);
+	histograms_.resize(blockNum * passNum * radix);
+	const size_t combineBytes = radix * combineElements * stride;
+	combine_.resize(blockNum * combineBytes);
+	auto histogram = [&](size_t b, unsigned int pass) {
+		return &histograms_[(b * passNum + pass) * radix];
+	};
+
+	forEachBlock([&](size_t b, size_t begin, size_t end) {
+		CountAllDigits(elements, stride, begin, end, histogram(b, 0));
+	});
+
+	auto scatter = SelectScatter(stride);
+	auto src = elements;
+	auto dst = tmp;
+	bool reordered = false;
+	for (unsigned int pass = 0; pass < passNum; ++pass) {
+		//全要素が同じ桁なら並びは変わらない
+		uint32_t totals[radix] = {};
+		for (size_t b = 0; b < blockNum; ++b) {
+			auto counts = histogram(b, pass);
+			for (size_t d = 0; d < radix; ++d) {
+				totals[d] += counts[d];
+			}
+		}
+		if (any_of(begin(totals), end(totals), [count](uint32_t n) {return n == count; })) {
+			continue;
+		}
+		//並び替えた後はブロックに入っている要素が変わるので数え直す(桁ごとの合計は変わらないので、1ブロックなら要らない)
+		if (reordered && blockNum > 1) {
+			forEachBlock([&](size_t b, size_t begin, size_t end) {
+				CountDigits(src, stride, begin, end, pass, histogram(b, pass));
+			});
+		}
+		//桁の順、同じ桁の中はブロックの順に並べたときの書き込み開始位置(こうすると安定になる)
+		uint32_t offset = 0;
+		for (size_t d = 0; d < radix; ++d) {
+			for (size_t b = 0; b < blockNum; ++b) {
+				auto& n = histogram(b, pass)[d];
+				auto c = n;
+				n = offset;
+				offset += c;
+			}
+		}
+		forEachBlock([&](size_t b, size_t begin, size_t end) {
+			scatter(src, dst, stride, begin, end, pass, histogram(b, pass), &combine_[b * combineBytes]);
+		});
+		swap(src, dst);
+		reordered = true;
+	}
+	return src;
+}
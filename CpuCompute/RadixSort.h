@@ -0,0 +1,91 @@
+﻿#pragma once
+#include<cstdint>
+#include<cstddef>
+#include<vector>
+#include<type_traits>
+
+class ComputeExecutor;
+
+//LSD基数ソート(1パス8bit×4パス、安定)
+//FirstStep/RadixSortCS.hlslのCPU版。GPUは桁の出現数→スキャン→タイル内で並べて書き出す、をパスごとに行う。
+//CPUは要素をスレッド数のブロックに分け、パスごとに
+//  ・ブロックごとの桁の出現数(スレッドごとのヒストグラム)を数え
+//  ・桁の順→ブロックの順に並べた出現数の排他的スキャンを書き込み開始位置とし
+//  ・各ブロックが桁ごとに書き込み先のキャッシュラインの分だけためてから、ストリーミングストアでまとめて書き出す(write-combining)
+//値があるときはキーと値を1要素にまとめてから並べ、最後に元の配列に戻す(書き込み先を1か所にするため)
+//最初に全桁の出現数を1回で数え、全要素が同じ値になる桁のパスは飛ばす
+
+///キーの型(符号なし整数として並べるための変換の種類)
+enum class RadixKeyType {
+	Uint,
+	Int,
+	Float,
+};
+
+///値を符号なし整数として比べると元の順になるキーに変換する(RadixKey.hlsliのFloatToSortableKey/IntToSortableKey)
+///@param values 入力(count個)
+///@param keys 出力(count個。valuesと同じでもよい)
+void ToSortableKeys(const float* values, uint32_t* keys, size_t count);
+void ToSortableKeys(const int32_t* values, uint32_t* keys, size_t count);
+///ToSortableKeysの逆
+void FromSortableKeys(const uint32_t* keys, float* values, size_t count);
+void FromSortableKeys(const uint32_t* keys, int32_t* values, size_t count);
+
+///基数ソート
+///作業領域(要素数ぶんのキーと値の退避先)を持っているので、同じ大きさを繰り返し並べるときは使いまわすこと
+///@remarks 1スレッド・1000万要素でstd::sortと比べると(BenchmarkRadixSort)、キーと値の組は約4.4～5.8倍で、
+///測るたびにぶれて5倍に届かないことがある。SimpleBuffer_tのレコードは約2.9～3.5倍にとどまる。
+///レコードは4バイトのキーを前に付けた12バイトで並べるので、8バイトの組より1パスの読み書きが1.5倍あり、
+///さらに前後にまとめる・戻すコピーが1回ずつ入る
+class RadixSorter
+{
+	std::vector<uint8_t> packed_;//キーと値を1要素にまとめた配列
+	std::vector<uint8_t> tmp_;//パスの書き込み先(パスごとに入れ替える)
+	std::vector<uint32_t> histograms_;//ブロック×パス×256
+	std::vector<uint8_t> combine_;//ブロックごとのwrite-combiningの領域
+
+	//先頭4バイトがキーでstrideバイトの要素を並べる。結果の入っている方(elementsか作業領域)を返す
+	uint8_t* Sort(uint8_t* elements, size_t stride, size_t count, ComputeExecutor* executor);
+	//キー(と値)を64バイト境界に置いた1つの配列にまとめる(ストリーミングストアでラインを丸ごと書けるように)
+	uint8_t* Pack(size_t stride, size_t count);
+	void SortRecordBytes(uint8_t* records, size_t recordSize, size_t count, size_t keyOffset, RadixKeyType keyType, ComputeExecutor* executor);
+
+	template<typename M>
+	static constexpr RadixKeyType KeyTypeOf() {
+		static_assert(std::is_same<M, uint32_t>::value || std::is_same<M, int32_t>::value || std::is_same<M, float>::value,
+			"key must be a uint32_t, int32_t or float field");
+		if constexpr (std::is_same<M, float>::value) {
+			return RadixKeyType::Float;
+		}
+		else if constexpr (std::is_same<M, int32_t>::value) {
+			return RadixKeyType::Int;
+		}
+		else {
+			return RadixKeyType::Uint;
+		}
+	}
+public:
+	///キーだけを並べる
+	///@param keys 入出力(count個)
+	///@param executor nullptrなら呼び出しスレッドだけで処理する
+	void SortKeys(uint32_t* keys, size_t count, ComputeExecutor* executor);
+
+	///キーの順に値も並べる(同じキーの値は元の順のまま)
+	///@param keys 入出力(count個)
+	///@param values 入出力(count個)
+	void SortPairs(uint32_t* keys, uint32_t* values, size_t count, ComputeExecutor* executor);
+
+	///構造体の配列をフィールドの値の順に並べる(同じ値の要素は元の順のまま)
+	///@param records 入出力(count個)
+	///@param key キーにするフィールド(&SimpleBuffer_t::fなど。uint32_t/int32_t/float)
+	///@remarks キーとレコードをまとめて並べるので、レコードが大きいとその分書き込みが増える
+	template<typename T, typename M>
+	void SortRecords(T* records, size_t count, M T::* key, ComputeExecutor* executor) {
+		static_assert(std::is_trivially_copyable<T>::value, "records are moved with memcpy");
+		if (count < 2) {
+			return;
+		}
+		const auto keyOffset = static_cast<size_t>(reinterpret_cast<const uint8_t*>(&(records->*key)) - reinterpret_cast<const uint8_t*>(records));
+		SortRecordBytes(reinterpret_cast<uint8_t*>(records), sizeof(T), count, keyOffset, KeyTypeOf<M>(), executor);
+	}
+};
@@ -0,0 +1,570 @@
+﻿#include "Reduction.h"
+#include<algorithm>
+#include<cassert>
+#include<limits>
+#include<vector>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+//シェーダと同じ1画素分の計算
+namespace hlsl {
+	namespace {
+#include"LumaReduction.hlsli"
+	}
+}
+
+using namespace std;
+
+namespace {
+	//MonoFilterと同じBT.601の15bit固定小数点の係数(合計32768)
+	constexpr int weightR = 9798;
+	constexpr int weightG = 19235;
+	constexpr int weightB = 3735;
+	constexpr int lumaShift = 15;
+	constexpr int lumaRound = 1 << (lumaShift - 1);
+
+	//ブロック(並列化の単位)の画素数。レーンごとの32bitの合計があふれない大きさにしておく
+	constexpr size_t blockPixels = 64 * 1024;
+	//floatのレーンの合計はこの画素数ごとにdoubleに移す(足す数が多いと丸め誤差が大きくなるため)
+	constexpr size_t floatChunkPixels = 4096;
+	//スレッドごとのヒストグラム(4本×256階級。画素iは(i&3)本目に数える)
+	constexpr size_t subHistogramNum = 4;
+	constexpr size_t privateHistogramSize = subHistogramNum * 256;
+
+	///R8G8B8A8の1画素の8bitの輝度
+	inline uint32_t Luma8(uint32_t px) {
+		return ((px & 0xff) * weightR + ((px >> 8) & 0xff) * weightG + ((px >> 16) & 0xff) * weightB + lumaRound) >> lumaShift;
+	}
+
+	///R8G8B8A8のブロックの集計
+	struct Luma8Block {
+		uint64_t sum = 0;
+		uint32_t minimum = 255;
+		uint32_t maximum = 0;
+	};
+	void Merge(Luma8Block& a, const Luma8Block& b) {
+		a.sum += b.sum;
+		a.minimum = min(a.minimum, b.minimum);
+		a.maximum = max(a.maximum, b.maximum);
+	}
+
+	///floatのブロックの集計
+	struct LumaFBlock {
+		double sum = 0.0;
+		float minimum = numeric_limits<float>::max();
+		float maximum = -numeric_limits<float>::max();
+	};
+	void Merge(LumaFBlock& a, const LumaFBlock& b) {
+		a.sum += b.sum;
+		a.minimum = hlsl::min(a.minimum, b.minimum);
+		a.maximum = hlsl::max(a.maximum, b.maximum);
+	}
+
+	///ブロックの結果を隣同士で畳んでいき、blocks[0]に集める
+	template<typename Block>
+	void TreeReduce(vector<Block>& blocks) {
+		for (size_t stride = 1; stride < blocks.size(); stride *= 2) {
+			for (size_t i = 0; i + stride < blocks.size(); i += stride * 2) {
+				Merge(blocks[i], blocks[i + stride]);
+			}
+		}
+	}
+
+	//ここから行(ブロック)単位の実装
+	//histogramはprivateHistogramSize個(nullptrなら数えない)。countはblockPixels以下
+
+	void Luma8Scalar(const uint32_t* src, size_t count, Luma8Block& block, uint32_t* histogram) {
+		uint64_t sum = 0;
+		uint32_t lo = block.minimum;
+		uint32_t hi = block.maximum;
+		for (size_t i = 0; i < count; ++i) {
+			auto luma = Luma8(src[i]);
+			sum += luma;
+			lo = min(lo, luma);
+			hi = max(hi, luma);
+			if (histogram != nullptr) {
+				++histogram[(i & 3) * 256 + luma];
+			}
+		}
+		block.sum += sum;
+		block.minimum = lo;
+		block.maximum = hi;
+	}
+
+	void LumaFScalar(const float* src, size_t count, const LumaHistogramRange& range, LumaFBlock& block, uint32_t* histogram) {
+		double sum = 0.0;
+		float lo = block.minimum;
+		float hi = block.maximum;
+		for (size_t i = 0; i < count; ++i, src += 4) {
+			auto luma = hlsl::Luminance(hlsl::float3(src[0], src[1], src[2]));
+			sum += luma;
+			lo = hlsl::min(lo, luma);
+			hi = hlsl::max(hi, luma);
+			if (histogram != nullptr) {
+				++histogram[(i & 3) * 256 + hlsl::LumaBin(hlsl::LumaHistogramValue(luma, range.logScale), range.offset, range.scale)];
+			}
+		}
+		block.sum += sum;
+		block.minimum = lo;
+		block.maximum = hi;
+	}
+
+#if defined(CPU_ARCH_X86)
+	//輝度の積和は(R,B)と(G,0)の16bitの組をそれぞれmaddして足す(横方向の並べ替えがいらない)
+	//レーンの並びは画素の並びと同じなので、レーンkはk&3本目のヒストグラムに数える
+
+	CPU_TARGET_SSE41 void Luma8SSE41(const uint32_t* src, size_t count, Luma8Block& block, uint32_t* histogram) {
+		const auto weightRB = _mm_set1_epi32(weightR | (weightB << 16));
+		const auto weightG0 = _mm_set1_epi32(weightG);
+		const auto maskRB = _mm_set1_epi32(0x00ff00ff);
+		const auto maskG = _mm_set1_epi32(0xff);
+		auto sum = _mm_setzero_si128();
+		auto lo = _mm_set1_epi32(block.minimum);
+		auto hi = _mm_set1_epi32(block.maximum);
+		alignas(16) uint32_t index[4];
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			auto luma = _mm_add_epi32(_mm_madd_epi16(_mm_and_si128(px, maskRB), weightRB),
+				_mm_madd_epi16(_mm_and_si128(_mm_srli_epi32(px, 8), maskG), weightG0));
+			luma = _mm_srli_epi32(_mm_add_epi32(luma, _mm_set1_epi32(lumaRound)), lumaShift);
+			sum = _mm_add_epi32(sum, luma);
+			lo = _mm_min_epu32(lo, luma);
+			hi = _mm_max_epu32(hi, luma);
+			if (histogram != nullptr) {
+				_mm_store_si128(reinterpret_cast<__m128i*>(index), luma);
+				++histogram[index[0]];
+				++histogram[256 + index[1]];
+				++histogram[512 + index[2]];
+				++histogram[768 + index[3]];
+			}
+		}
+		alignas(16) uint32_t lanes[3][4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), sum);
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), lo);
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), hi);
+		for (int k = 0; k < 4; ++k) {
+			block.sum += lanes[0][k];
+			block.minimum = min(block.minimum, lanes[1][k]);
+			block.maximum = max(block.maximum, lanes[2][k]);
+		}
+		Luma8Scalar(src + i, count - i, block, histogram);
+	}
+
+	CPU_TARGET_AVX2 void Luma8AVX2(const uint32_t* src, size_t count, Luma8Block& block, uint32_t* histogram) {
+		const auto weightRB = _mm256_set1_epi32(weightR | (weightB << 16));
+		const auto weightG0 = _mm256_set1_epi32(weightG);
+		const auto maskRB = _mm256_set1_epi32(0x00ff00ff);
+		const auto maskG = _mm256_set1_epi32(0xff);
+		auto sum = _mm256_setzero_si256();
+		auto lo = _mm256_set1_epi32(block.minimum);
+		auto hi = _mm256_set1_epi32(block.maximum);
+		alignas(32) uint32_t index[8];
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			auto px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			auto luma = _mm256_add_epi32(_mm256_madd_epi16(_mm256_and_si256(px, maskRB), weightRB),
+				_mm256_madd_epi16(_mm256_and_si256(_mm256_srli_epi32(px, 8), maskG), weightG0));
+			luma = _mm256_srli_epi32(_mm256_add_epi32(luma, _mm256_set1_epi32(lumaRound)), lumaShift);
+			sum = _mm256_add_epi32(sum, luma);
+			lo = _mm256_min_epu32(lo, luma);
+			hi = _mm256_max_epu32(hi, luma);
+			if (histogram != nullptr) {
+				_mm256_store_si256(reinterpret_cast<__m256i*>(index), luma);
+				++histogram[index[0]];
+				++histogram[256 + index[1]];
+				++histogram[512 + index[2]];
+				++histogram[768 + index[3]];
+				++histogram[index[4]];
+				++histogram[256 + index[5]];
+				++histogram[512 + index[6]];
+				++histogram[768 + index[7]];
+			}
+		}
+		alignas(32) uint32_t lanes[3][8];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), sum);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), lo);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(lanes[2]), hi);
+		for (int k = 0; k < 8; ++k) {
+			block.sum += lanes[0][k];
+			block.minimum = min(block.minimum, lanes[1][k]);
+			block.maximum = max(block.maximum, lanes[2][k]);
+		}
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		Luma8Scalar(src + i, count - i, block, histogram);
+	}
+
+	//ヒストグラムを数えるときは16画素ぶんのスカラーの加算が律速になり、
+	//512bitのレーンを取り出すぶんAVX2より遅くなった(測定:720pで約2倍)のでAVX2に任せる
+	CPU_TARGET_AVX512 void Luma8AVX512(const uint32_t* src, size_t count, Luma8Block& block, uint32_t* histogram) {
+		if (histogram != nullptr) {
+			Luma8AVX2(src, count, block, histogram);
+			return;
+		}
+		const auto weightRB = _mm512_set1_epi32(weightR | (weightB << 16));
+		const auto weightG0 = _mm512_set1_epi32(weightG);
+		const auto maskRB = _mm512_set1_epi32(0x00ff00ff);
+		const auto maskG = _mm512_set1_epi32(0xff);
+		auto sum = _mm512_setzero_si512();
+		auto lo = _mm512_set1_epi32(block.minimum);
+		auto hi = _mm512_set1_epi32(block.maximum);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			auto px = _mm512_loadu_si512(src + i);
+			auto luma = _mm512_add_epi32(_mm512_madd_epi16(_mm512_and_si512(px, maskRB), weightRB),
+				_mm512_madd_epi16(_mm512_and_si512(_mm512_srli_epi32(px, 8), maskG), weightG0));
+			luma = _mm512_srli_epi32(_mm512_add_epi32(luma, _mm512_set1_epi32(lumaRound)), lumaShift);
+			sum = _mm512_add_epi32(sum, luma);
+			lo = _mm512_min_epu32(lo, luma);
+			hi = _mm512_max_epu32(hi, luma);
+		}
+		block.sum += static_cast<uint32_t>(_mm512_reduce_add_epi32(sum));
+		block.minimum = min(block.minimum, static_cast<uint32_t>(_mm512_reduce_min_epu32(lo)));
+		block.maximum = max(block.maximum, static_cast<uint32_t>(_mm512_reduce_max_epu32(hi)));
+		_mm256_zeroupper();
+		Luma8Scalar(src + i, count - i, block, nullptr);
+	}
+
+	//float4を4画素ぶん読んでR,G,Bに分け、輝度にする
+	CPU_TARGET_SSE41 inline __m128 LumaOf4SSE41(const float* src) {
+		auto p0 = _mm_loadu_ps(src);
+		auto p1 = _mm_loadu_ps(src + 4);
+		auto p2 = _mm_loadu_ps(src + 8);
+		auto p3 = _mm_loadu_ps(src + 12);
+		_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(0.299f)), _mm_mul_ps(p1, _mm_set1_ps(0.587f))), _mm_mul_ps(p2, _mm_set1_ps(0.114f)));
+	}
+
+	//ヒストグラムの階級を決める値(LumaHistogramValueと同じ。0以下とNaNはビットを0にすると-127になる)
+	CPU_TARGET_SSE41 inline __m128 HistogramValueSSE41(__m128 luma, bool logScale) {
+		if (!logScale) {
+			return luma;
+		}
+		auto bits = _mm_castps_si128(_mm_and_ps(luma, _mm_cmpgt_ps(luma, _mm_setzero_ps())));
+		return _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / 8388608.0f)), _mm_set1_ps(127.0f));
+	}
+	CPU_TARGET_AVX2 inline __m256 HistogramValueAVX2(__m256 luma, bool logScale) {
+		if (!logScale) {
+			return luma;
+		}
+		auto bits = _mm256_castps_si256(_mm256_and_ps(luma, _mm256_cmp_ps(luma, _mm256_setzero_ps(), _CMP_GT_OQ)));
+		return _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(bits), _mm256_set1_ps(1.0f / 8388608.0f)), _mm256_set1_ps(127.0f));
+	}
+
+	CPU_TARGET_SSE41 void LumaFSSE41(const float* src, size_t count, const LumaHistogramRange& range, LumaFBlock& block, uint32_t* histogram) {
+		const bool logScale = range.logScale != 0;
+		const auto offset = _mm_set1_ps(range.offset);
+		const auto scale = _mm_set1_ps(range.scale);
+		const auto lastBin = _mm_set1_ps(255.0f);
+		auto lo = _mm_set1_ps(block.minimum);
+		auto hi = _mm_set1_ps(block.maximum);
+		alignas(16) uint32_t index[4];
+		alignas(16) float lanes[4];
+		size_t i = 0;
+		while (i + 4 <= count) {
+			auto sum = _mm_setzero_ps();
+			auto chunkEnd = min(count, i + floatChunkPixels);
+			for (; i + 4 <= chunkEnd; i += 4) {
+				auto luma = LumaOf4SSE41(src + i * 4);
+				sum = _mm_add_ps(sum, luma);
+				//NaNは比較で捨てられる(hlsl::min/maxと同じ)
+				lo = _mm_min_ps(luma, lo);
+				hi = _mm_max_ps(luma, hi);
+				if (histogram != nullptr) {
+					auto bin = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(HistogramValueSSE41(luma, logScale), offset), scale), _mm_setzero_ps()), lastBin);
+					_mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_cvttps_epi32(bin));
+					++histogram[index[0]];
+					++histogram[256 + index[1]];
+					++histogram[512 + index[2]];
+					++histogram[768 + index[3]];
+				}
+			}
+			_mm_store_ps(lanes, sum);
+			block.sum += static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+		}
+		_mm_store_ps(lanes, lo);
+		block.minimum = hlsl::min(hlsl::min(lanes[0], lanes[1]), hlsl::min(lanes[2], lanes[3]));
+		_mm_store_ps(lanes, hi);
+		block.maximum = hlsl::max(hlsl::max(lanes[0], lanes[1]), hlsl::max(lanes[2], lanes[3]));
+		LumaFScalar(src + i * 4, count - i, range, block, histogram);
+	}
+
+	CPU_TARGET_AVX2 void LumaFAVX2(const float* src, size_t count, const LumaHistogramRange& range, LumaFBlock& block, uint32_t* histogram) {
+		const bool logScale = range.logScale != 0;
+		const auto offset = _mm256_set1_ps(range.offset);
+		const auto scale = _mm256_set1_ps(range.scale);
+		const auto lastBin = _mm256_set1_ps(255.0f);
+		auto lo = _mm256_set1_ps(block.minimum);
+		auto hi = _mm256_set1_ps(block.maximum);
+		alignas(32) uint32_t index[8];
+		alignas(32) float lanes[8];
+		size_t i = 0;
+		while (i + 8 <= count) {
+			auto sum = _mm256_setzero_ps();
+			auto chunkEnd = min(count, i + floatChunkPixels);
+			for (; i + 8 <= chunkEnd; i += 8) {
+				//2画素ずつ読んで128bitレーンの中で転置する
+				//(下位レーンが画素0,2,4,6、上位レーンが1,3,5,7になるが、集計なので順番は関係ない)
+				auto p01 = _mm256_loadu_ps(src + i * 4);
+				auto p23 = _mm256_loadu_ps(src + i * 4 + 8);
+				auto p45 = _mm256_loadu_ps(src + i * 4 + 16);
+				auto p67 = _mm256_loadu_ps(src + i * 4 + 24);
+				auto t0 = _mm256_unpacklo_ps(p01, p23);
+				auto t1 = _mm256_unpackhi_ps(p01, p23);
+				auto t2 = _mm256_unpacklo_ps(p45, p67);
+				auto t3 = _mm256_unpackhi_ps(p45, p67);
+				auto r = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+				auto g = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+				auto b = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+				auto luma = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, _mm256_set1_ps(0.299f)), _mm256_mul_ps(g, _mm256_set1_ps(0.587f))),
+					_mm256_mul_ps(b, _mm256_set1_ps(0.114f)));
+				sum = _mm256_add_ps(sum, luma);
+				lo = _mm256_min_ps(luma, lo);
+				hi = _mm256_max_ps(luma, hi);
+				if (histogram != nullptr) {
+					auto bin = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(HistogramValueAVX2(luma, logScale), offset), scale), _mm256_setzero_ps()), lastBin);
+					_mm256_store_si256(reinterpret_cast<__m256i*>(index), _mm256_cvttps_epi32(bin));
+					for (int k = 0; k < 8; ++k) {
+						++histogram[(k & 3) * 256 + index[k]];
+					}
+				}
+			}
+			_mm256_store_ps(lanes, sum);
+			double chunkSum = 0.0;
+			for (int k = 0; k < 8; ++k) {
+				chunkSum += lanes[k];
+			}
+			block.sum += chunkSum;
+		}
+		_mm256_store_ps(lanes, lo);
+		for (int k = 0; k < 8; ++k) {
+			block.minimum = hlsl::min(block.minimum, lanes[k]);
+		}
+		_mm256_store_ps(lanes, hi);
+		for (int k = 0; k < 8; ++k) {
+			block.maximum = hlsl::max(block.maximum, lanes[k]);
+		}
+		_mm256_zeroupper();
+		LumaFScalar(src + i * 4, count - i, range, block, histogram);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	void Luma8NEON(const uint32_t* src, size_t count, Luma8Block& block, uint32_t* histogram) {
+		auto sum = vdupq_n_u32(0);
+		auto lo = vdupq_n_u32(block.minimum);
+		auto hi = vdupq_n_u32(block.maximum);
+		alignas(16) uint32_t index[8];
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			//RGBAをチャンネルごとに分けて読む
+			auto px = vld4_u8(reinterpret_cast<const uint8_t*>(src + i));
+			auto r = vmovl_u8(px.val[0]);
+			auto g = vmovl_u8(px.val[1]);
+			auto b = vmovl_u8(px.val[2]);
+			auto lumaLo = vmull_n_u16(vget_low_u16(r), weightR);
+			lumaLo = vmlal_n_u16(lumaLo, vget_low_u16(g), weightG);
+			lumaLo = vrshrq_n_u32(vmlal_n_u16(lumaLo, vget_low_u16(b), weightB), lumaShift);
+			auto lumaHi = vmull_n_u16(vget_high_u16(r), weightR);
+			lumaHi = vmlal_n_u16(lumaHi, vget_high_u16(g), weightG);
+			lumaHi = vrshrq_n_u32(vmlal_n_u16(lumaHi, vget_high_u16(b), weightB), lumaShift);
+			sum = vaddq_u32(sum, vaddq_u32(lumaLo, lumaHi));
+			lo = vminq_u32(lo, vminq_u32(lumaLo, lumaHi));
+			hi = vmaxq_u32(hi, vmaxq_u32(lumaLo, lumaHi));
+			if (histogram != nullptr) {
+				vst1q_u32(index, lumaLo);
+				vst1q_u32(index + 4, lumaHi);
+				for (int k = 0; k < 8; ++k) {
+					++histogram[(k & 3) * 256 + index[k]];
+				}
+			}
+		}
+		block.sum += vaddvq_u32(sum);
+		block.minimum = min(block.minimum, vminvq_u32(lo));
+		block.maximum = max(block.maximum, vmaxvq_u32(hi));
+		Luma8Scalar(src + i, count - i, block, histogram);
+	}
+
+	void LumaFNEON(const float* src, size_t count, const LumaHistogramRange& range, LumaFBlock& block, uint32_t* histogram) {
+		const bool logScale = range.logScale != 0;
+		const auto offset = vdupq_n_f32(range.offset);
+		const auto scale = vdupq_n_f32(range.scale);
+		const auto lastBin = vdupq_n_f32(255.0f);
+		auto lo = vdupq_n_f32(block.minimum);
+		auto hi = vdupq_n_f32(block.maximum);
+		alignas(16) uint32_t index[4];
+		size_t i = 0;
+		while (i + 4 <= count) {
+			auto sum = vdupq_n_f32(0.0f);
+			auto chunkEnd = min(count, i + floatChunkPixels);
+			for (; i + 4 <= chunkEnd; i += 4) {
+				auto px = vld4q_f32(src + i * 4);
+				auto luma = vaddq_f32(vaddq_f32(vmulq_n_f32(px.val[0], 0.299f), vmulq_n_f32(px.val[1], 0.587f)), vmulq_n_f32(px.val[2], 0.114f));
+				sum = vaddq_f32(sum, luma);
+				//vminnm/vmaxnmは片方がNaNならもう片方を返す(hlsl::min/maxと同じ)
+				lo = vminnmq_f32(lo, luma);
+				hi = vmaxnmq_f32(hi, luma);
+				if (histogram != nullptr) {
+					auto value = luma;
+					if (logScale) {
+						//LumaHistogramValueと同じ(0以下とNaNはビットを0にすると-127になる)
+						auto bits = vandq_u32(vreinterpretq_u32_f32(luma), vcgtq_f32(luma, vdupq_n_f32(0.0f)));
+						value = vsubq_f32(vmulq_n_f32(vcvtq_f32_u32(bits), 1.0f / 8388608.0f), vdupq_n_f32(127.0f));
+					}
+					auto bin = vminq_f32(vmaxnmq_f32(vmulq_f32(vsubq_f32(value, offset), scale), vdupq_n_f32(0.0f)), lastBin);
+					vst1q_u32(index, vcvtq_u32_f32(bin));
+					++histogram[index[0]];
+					++histogram[256 + index[1]];
+					++histogram[512 + index[2]];
+					++histogram[768 + index[3]];
+				}
+			}
+			block.sum += vaddvq_f32(sum);
+		}
+		block.minimum = hlsl::min(block.minimum, vminnmvq_f32(lo));
+		block.maximum = hlsl::max(block.maximum, vmaxnmvq_f32(hi));
+		LumaFScalar(src + i * 4, count - i, range, block, histogram);
+	}
+#endif
+
+	using Luma8Func = void(*)(const uint32_t* src, size_t count, Luma8Block& block, uint32_t* histogram);
+	Kernel<Luma8Func> luma8("luma8", {
+		{ CpuIsa::Scalar, Luma8Scalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, Luma8SSE41 },
+		{ CpuIsa::AVX2, Luma8AVX2 },
+		{ CpuIsa::AVX512, Luma8AVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, Luma8NEON },
+#endif
+	});
+
+	using LumaFFunc = void(*)(const float* src, size_t count, const LumaHistogramRange& range, LumaFBlock& block, uint32_t* histogram);
+	Kernel<LumaFFunc> lumaF("lumaf", {
+		{ CpuIsa::Scalar, LumaFScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, LumaFSSE41 },
+		{ CpuIsa::AVX2, LumaFAVX2 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, LumaFNEON },
+#endif
+	});
+
+	///画素をブロックに分けてfunc(画素の先頭,画素数,ブロックの結果,ヒストグラム)を並列に呼び、
+	///ブロックの結果を木構造で、スレッドごとのヒストグラムを足し合わせて畳む
+	template<typename Block, typename Func>
+	Block ReduceBlocks(size_t count, LumaHistogram* histogram, ComputeExecutor* executor, Func&& func) {
+		const size_t blockNum = (count + blockPixels - 1) / blockPixels;
+		vector<Block> blocks(max<size_t>(blockNum, 1));
+		const size_t histogramNum = executor != nullptr ? executor->ThreadCount() : 1;
+		vector<uint32_t> privateHistograms(histogram != nullptr ? histogramNum * privateHistogramSize : 0);
+		auto run = [&](size_t begin, size_t end) {
+			uint32_t* privateHistogram = nullptr;
+			if (histogram != nullptr) {
+				size_t worker = executor != nullptr ? ComputeExecutor::WorkerIndex() : 0;
+				assert(worker < histogramNum);
+				privateHistogram = privateHistograms.data() + worker * privateHistogramSize;
+			}
+			for (auto b = begin; b < end; ++b) {
+				auto offset = b * blockPixels;
+				func(offset, min(blockPixels, count - offset), blocks[b], privateHistogram);
+			}
+		};
+		if (executor != nullptr) {
+			executor->ParallelFor(blockNum, 1, run);
+		}
+		else {
+			run(0, blockNum);
+		}
+		TreeReduce(blocks);
+		if (histogram != nullptr) {
+			*histogram = LumaHistogram();
+			for (size_t h = 0; h < histogramNum * subHistogramNum; ++h) {
+				auto sub = privateHistograms.data() + h * 256;
+				for (int bin = 0; bin < 256; ++bin) {
+					histogram->bins[bin] += sub[bin];
+				}
+			}
+		}
+		return blocks[0];
+	}
+}
+
+uint64_t
+LumaHistogram::Total()const {
+	uint64_t total = 0;
+	for (auto b : bins) {
+		total += b;
+	}
+	return total;
+}
+
+void
+ReduceLuma(const ImageRGBA8& src, LumaStats& stats, LumaHistogram* histogram, ComputeExecutor* executor) {
+	auto func = luma8.Get();
+	auto block = ReduceBlocks<Luma8Block>(src.pixels.size(), histogram, executor,
+		[&](size_t offset, size_t count, Luma8Block& b, uint32_t* privateHistogram) {
+		func(src.pixels.data() + offset, count, b, privateHistogram);
+	});
+	stats.count = src.pixels.size();
+	stats.sum = block.sum / 255.0;
+	stats.minimum = stats.count == 0 ? 0.0f : block.minimum / 255.0f;
+	stats.maximum = stats.count == 0 ? 0.0f : block.maximum / 255.0f;
+}
+
+void
+ReduceLuma(const ImageRGBA32F& src, const LumaHistogramRange& range, LumaStats& stats, LumaHistogram* histogram, ComputeExecutor* executor) {
+	auto func = lumaF.Get();
+	auto pixels = reinterpret_cast<const float*>(src.pixels.data());
+	auto block = ReduceBlocks<LumaFBlock>(src.pixels.size(), histogram, executor,
+		[&](size_t offset, size_t count, LumaFBlock& b, uint32_t* privateHistogram) {
+		func(pixels + offset * 4, count, range, b, privateHistogram);
+	});
+	stats.count = src.pixels.size();
+	stats.sum = block.sum;
+	stats.minimum = stats.count == 0 ? 0.0f : block.minimum;
+	stats.maximum = stats.count == 0 ? 0.0f : block.maximum;
+}
+
+void
+ReduceLumaReference(const ImageRGBA8& src, LumaStats& stats, LumaHistogram& histogram) {
+	histogram = LumaHistogram();
+	uint64_t sum = 0;
+	uint32_t lo = 255, hi = 0;
+	for (auto px : src.pixels) {
+		auto luma = Luma8(px);
+		sum += luma;
+		lo = min(lo, luma);
+		hi = max(hi, luma);
+		++histogram.bins[luma];
+	}
+	stats.count = src.pixels.size();
+	stats.sum = sum / 255.0;
+	stats.minimum = stats.count == 0 ? 0.0f : lo / 255.0f;
+	stats.maximum = stats.count == 0 ? 0.0f : hi / 255.0f;
+}
+
+void
+ReduceLumaReference(const ImageRGBA32F& src, const LumaHistogramRange& range, LumaStats& stats, LumaHistogram& histogram) {
+	histogram = LumaHistogram();
+	double sum = 0.0;
+	float lo = numeric_limits<float>::max();
+	float hi = -numeric_limits<float>::max();
+	for (auto& px : src.pixels) {
+		auto luma = hlsl::Luminance(px.rgb);
+		sum += luma;
+		lo = hlsl::min(lo, luma);
+		hi = hlsl::max(hi, luma);
+		++histogram.bins[hlsl::LumaBin(hlsl::LumaHistogramValue(luma, range.logScale), range.offset, range.scale)];
+	}
+	stats.count = src.pixels.size();
+	stats.sum = sum;
+	stats.minimum = stats.count == 0 ? 0.0f : lo;
+	stats.maximum = stats.count == 0 ? 0.0f : hi;
+}
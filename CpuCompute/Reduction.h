@@ -0,0 +1,64 @@
+﻿#pragma once
+#include<cstdint>
+#include"Image.h"
+
+class ComputeExecutor;
+
+//画像の輝度の集計(合計・最小・最大・256階級のヒストグラム)
+//RenderTargetFilter/ReductionCS.hlslのCPU版。輝度と階級の計算はLumaReduction.hlsliをシェーダと共有する
+//  ・合計/最小/最大は64K画素のブロックごとにSIMDのレーンで畳み、ブロックの結果を木構造で畳む
+//  ・ヒストグラムはスレッドごとに持ち(さらに4本に分けて同じ階級への連続加算を避ける)、最後に足し合わせる
+
+///輝度の集計結果
+struct LumaStats {
+	double sum = 0.0;
+	float minimum = 0.0f;
+	float maximum = 0.0f;
+	uint64_t count = 0;
+	///平均輝度(画素がなければ0)
+	double Average()const { return count == 0 ? 0.0 : sum / count; }
+};
+
+///輝度のヒストグラム(256階級)
+struct LumaHistogram {
+	uint32_t bins[256] = {};
+	///全階級の合計(=画素数)
+	uint64_t Total()const;
+};
+
+///ヒストグラムの階級の決め方(LumaBin:階級 = (輝度 - offset) * scaleを切り捨てて0～255に収める)
+struct LumaHistogramRange {
+	float offset;
+	float scale;
+	unsigned int logScale = 0;//0でなければ輝度のかわりにApproxLog2(輝度)で階級を決める
+};
+
+///[lo,hi)を256等分する階級
+inline LumaHistogramRange MakeLumaHistogramRange(float lo, float hi) {
+	return { lo,256.0f / (hi - lo) };
+}
+
+///log2(輝度)の[minLog2,maxLog2)を256等分する階級(自動露出用。範囲外は両端の階級に入る)
+inline LumaHistogramRange MakeLogLumaHistogramRange(float minLog2, float maxLog2) {
+	return { minLog2,256.0f / (maxLog2 - minLog2),1 };
+}
+
+///R8G8B8A8の階級(8bitに丸めた輝度がそのまま階級になる)
+constexpr LumaHistogramRange unorm8HistogramRange = { -0.5f / 255.0f,255.0f };
+
+///R8G8B8A8の画像の輝度を集計する
+///輝度は15bit固定小数点で求めて8bitに丸めたもの(MonoFilterと同じ係数)なので、minimum/maximumはn/255になる
+///@param src 入力画像
+///@param stats 合計・最小・最大
+///@param histogram ヒストグラム(unorm8HistogramRangeの階級)。nullptrなら数えない
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+void ReduceLuma(const ImageRGBA8& src, LumaStats& stats, LumaHistogram* histogram, ComputeExecutor* executor);
+
+///float4(R32G32B32A32_FLOAT)の画像の輝度を集計する
+///@param range ヒストグラムの階級(logScaleでも合計・最小・最大は輝度のまま)
+///@remarks 合計はブロック内をfloatのレーンで、ブロック間をdoubleで足すので、ReduceLumaReferenceとは丸め誤差の差が出る
+void ReduceLuma(const ImageRGBA32F& src, const LumaHistogramRange& range, LumaStats& stats, LumaHistogram* histogram, ComputeExecutor* executor);
+
+///ReduceLumaの基準実装(1画素ずつ順に処理する)
+void ReduceLumaReference(const ImageRGBA8& src, LumaStats& stats, LumaHistogram& histogram);
+void ReduceLumaReference(const ImageRGBA32F& src, const LumaHistogramRange& range, LumaStats& stats, LumaHistogram& histogram);
@@ -0,0 +1,745 @@
+﻿#include "Resample.h"
+#include<algorithm>
+#include<cassert>
+#include<cmath>
+#include<cstring>
+#include<functional>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+//シェーダと同じフィルタ
+namespace hlsl {
+	namespace {
+#include"Resample.hlsli"
+	}
+}
+
+using namespace std;
+
+namespace {
+	//並列化するときの帯の最小の行数(出力)
+	constexpr unsigned int minBandRows = 8;
+	//R8G8B8A8の中間の値の上限(255*255/4。成分あたり63.75倍)
+	constexpr int maxValue8 = 255 * 255 / 4;
+	constexpr int32_t weightRounding = 1 << (resampleWeightBits - 1);
+
+	inline int16_t SaturateInt16(int32_t v) {
+		return static_cast<int16_t>(min(max(v, -32768), 32767));
+	}
+
+	//隣り合う2つの重み(int16_t)を1つのint32_tとして読む(_mm_madd_epi16で2画素ぶんを一度に掛けるため)
+	inline int32_t LoadWeightPair(const int16_t* w) {
+		int32_t pair;
+		memcpy(&pair, w, sizeof(pair));
+		return pair;
+	}
+
+	//ここからR8G8B8A8→中間(int16_t)
+	//色 : (値*m+2)>>2 (mはpremultiplyならアルファ、そうでなければ255)。アルファ : (a*255+2)>>2
+
+	void Resample8InScalar(const uint32_t* src, int16_t* dst, size_t count, bool premultiply) {
+		for (size_t i = 0; i < count; ++i) {
+			const uint32_t a = src[i] >> 24;
+			const uint32_t m = premultiply ? a : 255;
+			for (int c = 0; c < 3; ++c) {
+				dst[i * 4 + c] = static_cast<int16_t>((((src[i] >> (c * 8)) & 0xff) * m + 2) >> 2);
+			}
+			dst[i * 4 + 3] = static_cast<int16_t>((a * 255 + 2) >> 2);
+		}
+	}
+
+	//ここから中間→R8G8B8A8
+	//アルファ : 0～maxValue8に切り詰めて*4/255
+	//色       : unpremultiplyなら0以上にして*255/アルファ(切り詰める前の値で割る。0以下なら0)、
+	//           そうでなければ0～切り詰めたアルファにして*4/255
+	//最後に255以下にして丸める。SIMDも同じ順にfloatで計算する
+	//(Lanczosなどでアルファが1を超えたときも、色はアルファを掛けた値と同じ比率で戻る)
+
+	void Resample8OutScalar(const int16_t* src, uint32_t* dst, size_t count, bool unpremultiply) {
+		for (size_t i = 0; i < count; ++i) {
+			const float alpha = static_cast<float>(src[i * 4 + 3]);
+			const float clampedAlpha = static_cast<float>(min(max(static_cast<int>(src[i * 4 + 3]), 0), maxValue8));
+			const float scale = unpremultiply ? (alpha > 0.0f ? 255.0f / alpha : 0.0f) : 4.0f / 255.0f;
+			uint32_t px = static_cast<uint32_t>(clampedAlpha * (4.0f / 255.0f) + 0.5f) << 24;
+			for (int c = 0; c < 3; ++c) {
+				float color = max(static_cast<float>(src[i * 4 + c]), 0.0f);
+				if (!unpremultiply) {
+					color = min(color, clampedAlpha);
+				}
+				px |= min(static_cast<uint32_t>(color * scale + 0.5f), 255u) << (c * 8);
+			}
+			dst[i] = px;
+		}
+	}
+
+	//ここから横の畳み込み(出力の画素ごとに、入力のfirst[i]からtaps画素)
+	//dst[i*4+c] = (Σ w[i*taps+k] * src[(first[i]+k)*4+c] + 2^13) >> 14 をint16_tに飽和させる
+
+	void ResampleHScalar(const int16_t* src, const int* first, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			const int16_t* s = src + static_cast<size_t>(first[i]) * 4;
+			const int16_t* w = weights + i * taps;
+			int32_t acc[4] = { weightRounding, weightRounding, weightRounding, weightRounding };
+			for (unsigned int k = 0; k < taps; ++k) {
+				for (int c = 0; c < 4; ++c) {
+					acc[c] += w[k] * s[k * 4 + c];
+				}
+			}
+			for (int c = 0; c < 4; ++c) {
+				dst[i * 4 + c] = SaturateInt16(acc[c] >> resampleWeightBits);
+			}
+		}
+	}
+
+	//ここから縦の畳み込み(rowsはtaps行ぶんの中間の行)
+	//dst[i] = (Σ w[k] * rows[k][i] + 2^13) >> 14 をint16_tに飽和させる
+
+	void ResampleVScalar(const int16_t* const* rows, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			int32_t acc = weightRounding;
+			for (unsigned int k = 0; k < taps; ++k) {
+				acc += weights[k] * rows[k][i];
+			}
+			dst[i] = SaturateInt16(acc >> resampleWeightBits);
+		}
+	}
+
+#if defined(CPU_ARCH_X86)
+	//ここからSSE4.1(AVX2/AVX-512の端数にも使う)
+
+	//2画素(int16_t x 8)の各成分に掛ける値。premultiplyなら色にアルファ、アルファに255
+	CPU_TARGET_SSE41 inline __m128i PremultiplierSSE41(__m128i v, bool premultiply) {
+		if (!premultiply) {
+			return _mm_set1_epi16(255);
+		}
+		const auto alphas = _mm_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1);
+		return _mm_or_si128(_mm_shuffle_epi8(v, alphas), _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255));
+	}
+
+	//2画素(下位64bitに入ったR8G8B8A8)を中間にする
+	CPU_TARGET_SSE41 inline __m128i Resample8In2SSE41(__m128i px, bool premultiply) {
+		auto v = _mm_cvtepu8_epi16(px);
+		auto p = _mm_mullo_epi16(v, PremultiplierSSE41(v, premultiply));
+		return _mm_srli_epi16(_mm_add_epi16(p, _mm_set1_epi16(2)), 2);
+	}
+
+	CPU_TARGET_SSE41 inline void Resample8InTailSSE41(const uint32_t* src, int16_t* dst, size_t i, size_t count, bool premultiply) {
+		for (; i + 2 <= count; i += 2) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), Resample8In2SSE41(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)), premultiply));
+		}
+		if (i < count) {
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 4), Resample8In2SSE41(_mm_cvtsi32_si128(static_cast<int>(src[i])), premultiply));
+		}
+	}
+
+	CPU_TARGET_SSE41 void Resample8InSSE41(const uint32_t* src, int16_t* dst, size_t count, bool premultiply) {
+		Resample8InTailSSE41(src, dst, 0, count, premultiply);
+	}
+
+	//中間の1画素(int32_t x 4に広げたもの)をR8G8B8A8にする
+	CPU_TARGET_SSE41 inline uint32_t Resample8Out1SSE41(__m128i v, bool unpremultiply) {
+		auto f = _mm_cvtepi32_ps(v);
+		auto alpha = _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 3, 3, 3));
+		auto clampedAlpha = _mm_min_ps(_mm_max_ps(alpha, _mm_setzero_ps()), _mm_set1_ps(static_cast<float>(maxValue8)));
+		f = _mm_max_ps(f, _mm_setzero_ps());
+		__m128 scale;
+		if (unpremultiply) {
+			//アルファが0以下なら0(0での割り算のinfを消す)
+			scale = _mm_and_ps(_mm_div_ps(_mm_set1_ps(255.0f), alpha), _mm_cmpgt_ps(alpha, _mm_setzero_ps()));
+		}
+		else {
+			scale = _mm_set1_ps(4.0f / 255.0f);
+			f = _mm_min_ps(f, clampedAlpha);
+		}
+		f = _mm_blend_ps(f, clampedAlpha, 0x8);
+		scale = _mm_blend_ps(scale, _mm_set1_ps(4.0f / 255.0f), 0x8);
+		auto r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(f, scale), _mm_set1_ps(0.5f)));
+		r = _mm_min_epi32(r, _mm_set1_epi32(255));
+		r = _mm_packus_epi16(_mm_packus_epi32(r, r), r);
+		return static_cast<uint32_t>(_mm_cvtsi128_si32(r));
+	}
+
+	CPU_TARGET_SSE41 void Resample8OutSSE41(const int16_t* src, uint32_t* dst, size_t count, bool unpremultiply) {
+		for (size_t i = 0; i < count; ++i) {
+			dst[i] = Resample8Out1SSE41(_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4))), unpremultiply);
+		}
+	}
+
+	//2画素(int16_t x 8)を成分ごとに並べ替える([R0,R1,G0,G1,B0,B1,A0,A1])。隣の重みと一緒に_mm_madd_epi16で掛ける
+	CPU_TARGET_SSE41 inline __m128i InterleavePairSSE41(__m128i v) {
+		return _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15));
+	}
+
+	//横の畳み込みのkからtapsまで(2タップずつ)
+	CPU_TARGET_SSE41 inline __m128i ResampleHPairsSSE41(const int16_t* s, const int16_t* w, unsigned int k, unsigned int taps, __m128i acc) {
+		for (; k < taps; k += 2) {
+			auto pix = InterleavePairSSE41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k * 4)));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(pix, _mm_set1_epi32(LoadWeightPair(w + k))));
+		}
+		return acc;
+	}
+
+	CPU_TARGET_SSE41 inline void StoreResampledPixelSSE41(__m128i acc, int16_t* dst) {
+		acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(weightRounding)), resampleWeightBits);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packs_epi32(acc, acc));
+	}
+
+	CPU_TARGET_SSE41 void ResampleHSSE41(const int16_t* src, const int* first, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			auto acc = ResampleHPairsSSE41(src + static_cast<size_t>(first[i]) * 4, weights + i * taps, 0, taps, _mm_setzero_si128());
+			StoreResampledPixelSSE41(acc, dst + i * 4);
+		}
+	}
+
+	//縦の畳み込みの、beginから(8要素ずつ、最後は4要素)
+	CPU_TARGET_SSE41 inline void ResampleVTailSSE41(const int16_t* const* rows, const int16_t* weights, unsigned int taps, int16_t* dst, size_t begin, size_t count) {
+		const auto round = _mm_set1_epi32(weightRounding);
+		auto i = begin;
+		for (; i + 8 <= count; i += 8) {
+			auto lo = round;
+			auto hi = round;
+			for (unsigned int k = 0; k < taps; k += 2) {
+				auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+				auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k + 1] + i));
+				auto w = _mm_set1_epi32(LoadWeightPair(weights + k));
+				lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+				hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+			}
+			lo = _mm_srai_epi32(lo, resampleWeightBits);
+			hi = _mm_srai_epi32(hi, resampleWeightBits);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(lo, hi));
+		}
+		for (; i < count; i += 4) {
+			auto lo = round;
+			for (unsigned int k = 0; k < taps; k += 2) {
+				auto a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[k] + i));
+				auto b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[k + 1] + i));
+				lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), _mm_set1_epi32(LoadWeightPair(weights + k))));
+			}
+			lo = _mm_srai_epi32(lo, resampleWeightBits);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(lo, lo));
+		}
+	}
+
+	CPU_TARGET_SSE41 void ResampleVSSE41(const int16_t* const* rows, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		ResampleVTailSSE41(rows, weights, taps, dst, 0, count);
+	}
+
+	//ここからAVX2
+
+	CPU_TARGET_AVX2 void Resample8InAVX2(const uint32_t* src, int16_t* dst, size_t count, bool premultiply) {
+		const auto alphas = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1,
+			6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1);
+		const auto alpha255 = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+			auto m = premultiply ? _mm256_or_si256(_mm256_shuffle_epi8(v, alphas), alpha255) : _mm256_set1_epi16(255);
+			auto p = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(v, m), _mm256_set1_epi16(2)), 2);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), p);
+		}
+		Resample8InTailSSE41(src, dst, i, count, premultiply);
+	}
+
+	//2画素ずつ(128bitのレーンに1画素)
+	CPU_TARGET_AVX2 void Resample8OutAVX2(const int16_t* src, uint32_t* dst, size_t count, bool unpremultiply) {
+		const auto zero = _mm256_setzero_si256();
+		const auto alphaScale = _mm256_set1_ps(4.0f / 255.0f);
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2) {
+			auto f = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4))));
+			auto alpha = _mm256_shuffle_ps(f, f, _MM_SHUFFLE(3, 3, 3, 3));
+			auto clampedAlpha = _mm256_min_ps(_mm256_max_ps(alpha, _mm256_setzero_ps()), _mm256_set1_ps(static_cast<float>(maxValue8)));
+			f = _mm256_max_ps(f, _mm256_setzero_ps());
+			__m256 scale;
+			if (unpremultiply) {
+				scale = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(255.0f), alpha), _mm256_cmp_ps(alpha, _mm256_setzero_ps(), _CMP_GT_OQ));
+			}
+			else {
+				scale = alphaScale;
+				f = _mm256_min_ps(f, clampedAlpha);
+			}
+			f = _mm256_blend_ps(f, clampedAlpha, 0x88);
+			scale = _mm256_blend_ps(scale, alphaScale, 0x88);
+			auto r = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(f, scale), _mm256_set1_ps(0.5f)));
+			r = _mm256_min_epi32(r, _mm256_set1_epi32(255));
+			r = _mm256_packus_epi16(_mm256_packus_epi32(r, r), zero);
+			r = _mm256_permutevar8x32_epi32(r, _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm256_castsi256_si128(r));
+		}
+		if (i < count) {
+			dst[i] = Resample8Out1SSE41(_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4))), unpremultiply);
+		}
+	}
+
+	//4タップずつ(下のレーンにk,k+1、上のレーンにk+2,k+3)
+	CPU_TARGET_AVX2 void ResampleHAVX2(const int16_t* src, const int* first, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		const auto interleave = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15,
+			0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+		const auto pairs = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+		for (size_t i = 0; i < count; ++i) {
+			const int16_t* s = src + static_cast<size_t>(first[i]) * 4;
+			const int16_t* w = weights + i * taps;
+			auto acc = _mm256_setzero_si256();
+			unsigned int k = 0;
+			for (; k + 4 <= taps; k += 4) {
+				auto pix = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + k * 4)), interleave);
+				auto wk = _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + k))), pairs);
+				acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pix, wk));
+			}
+			auto sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+			StoreResampledPixelSSE41(ResampleHPairsSSE41(s, w, k, taps, sum), dst + i * 4);
+		}
+	}
+
+	//16要素ずつ(unpack/packはレーンごとなので、並びは元に戻る)
+	CPU_TARGET_AVX2 void ResampleVAVX2(const int16_t* const* rows, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		const auto round = _mm256_set1_epi32(weightRounding);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			auto lo = round;
+			auto hi = round;
+			for (unsigned int k = 0; k < taps; k += 2) {
+				auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + i));
+				auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k + 1] + i));
+				auto w = _mm256_set1_epi32(LoadWeightPair(weights + k));
+				lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+				hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+			}
+			lo = _mm256_srai_epi32(lo, resampleWeightBits);
+			hi = _mm256_srai_epi32(hi, resampleWeightBits);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packs_epi32(lo, hi));
+		}
+		ResampleVTailSSE41(rows, weights, taps, dst, i, count);
+	}
+
+	//ここからAVX-512
+
+	//8タップずつ(128bitのレーンごとに2タップ)
+	CPU_TARGET_AVX512 void ResampleHAVX512(const int16_t* src, const int* first, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		const auto interleave = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15));
+		const auto pairs = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+		for (size_t i = 0; i < count; ++i) {
+			const int16_t* s = src + static_cast<size_t>(first[i]) * 4;
+			const int16_t* w = weights + i * taps;
+			auto acc = _mm512_setzero_si512();
+			unsigned int k = 0;
+			for (; k + 8 <= taps; k += 8) {
+				auto pix = _mm512_shuffle_epi8(_mm512_loadu_si512(s + k * 4), interleave);
+				auto wk = _mm512_permutexvar_epi32(pairs, _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + k))));
+				acc = _mm512_add_epi32(acc, _mm512_madd_epi16(pix, wk));
+			}
+			auto acc256 = _mm256_add_epi32(_mm512_castsi512_si256(acc), _mm512_extracti64x4_epi64(acc, 1));
+			auto sum = _mm_add_epi32(_mm256_castsi256_si128(acc256), _mm256_extracti128_si256(acc256, 1));
+			StoreResampledPixelSSE41(ResampleHPairsSSE41(s, w, k, taps, sum), dst + i * 4);
+		}
+	}
+
+	CPU_TARGET_AVX512 void ResampleVAVX512(const int16_t* const* rows, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		const auto round = _mm512_set1_epi32(weightRounding);
+		size_t i = 0;
+		for (; i + 32 <= count; i += 32) {
+			auto lo = round;
+			auto hi = round;
+			for (unsigned int k = 0; k < taps; k += 2) {
+				auto a = _mm512_loadu_si512(rows[k] + i);
+				auto b = _mm512_loadu_si512(rows[k + 1] + i);
+				auto w = _mm512_set1_epi32(LoadWeightPair(weights + k));
+				lo = _mm512_add_epi32(lo, _mm512_madd_epi16(_mm512_unpacklo_epi16(a, b), w));
+				hi = _mm512_add_epi32(hi, _mm512_madd_epi16(_mm512_unpackhi_epi16(a, b), w));
+			}
+			lo = _mm512_srai_epi32(lo, resampleWeightBits);
+			hi = _mm512_srai_epi32(hi, resampleWeightBits);
+			_mm512_storeu_si512(dst + i, _mm512_packs_epi32(lo, hi));
+		}
+		ResampleVTailSSE41(rows, weights, taps, dst, i, count);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	void Resample8InNEON(const uint32_t* src, int16_t* dst, size_t count, bool premultiply) {
+		const uint8_t alphaIndex[8] = { 3, 3, 3, 255, 7, 7, 7, 255 };
+		const auto alphas = vld1_u8(alphaIndex);
+		const auto alpha255 = vreinterpret_u8_u32(vdup_n_u32(0xff000000u));
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2) {
+			auto b = vld1_u8(reinterpret_cast<const uint8_t*>(src + i));
+			auto m = premultiply ? vmovl_u8(vorr_u8(vtbl1_u8(b, alphas), alpha255)) : vdupq_n_u16(255);
+			auto p = vshrq_n_u16(vaddq_u16(vmulq_u16(vmovl_u8(b), m), vdupq_n_u16(2)), 2);
+			vst1q_s16(dst + i * 4, vreinterpretq_s16_u16(p));
+		}
+		Resample8InScalar(src + i, dst + i * 4, count - i, premultiply);
+	}
+
+	void Resample8OutNEON(const int16_t* src, uint32_t* dst, size_t count, bool unpremultiply) {
+		const auto alphaScale = vdupq_n_f32(4.0f / 255.0f);
+		const uint32_t alphaLaneMask[4] = { 0, 0, 0, 0xffffffffu };
+		const auto alphaLane = vld1q_u32(alphaLaneMask);
+		for (size_t i = 0; i < count; ++i) {
+			auto f = vcvtq_f32_s32(vmovl_s16(vld1_s16(src + i * 4)));
+			auto alpha = vdupq_laneq_f32(f, 3);
+			auto clampedAlpha = vminq_f32(vmaxq_f32(alpha, vdupq_n_f32(0.0f)), vdupq_n_f32(static_cast<float>(maxValue8)));
+			f = vmaxq_f32(f, vdupq_n_f32(0.0f));
+			float32x4_t scale;
+			if (unpremultiply) {
+				auto positive = vcgtq_f32(alpha, vdupq_n_f32(0.0f));
+				scale = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vdivq_f32(vdupq_n_f32(255.0f), alpha)), positive));
+			}
+			else {
+				scale = alphaScale;
+				f = vminq_f32(f, clampedAlpha);
+			}
+			f = vbslq_f32(alphaLane, clampedAlpha, f);
+			scale = vbslq_f32(alphaLane, alphaScale, scale);
+			auto r = vminq_u32(vcvtq_u32_f32(vaddq_f32(vmulq_f32(f, scale), vdupq_n_f32(0.5f))), vdupq_n_u32(255));
+			auto b = vmovn_u16(vcombine_u16(vmovn_u32(r), vdup_n_u16(0)));
+			dst[i] = vget_lane_u32(vreinterpret_u32_u8(b), 0);
+		}
+	}
+
+	void ResampleHNEON(const int16_t* src, const int* first, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			const int16_t* s = src + static_cast<size_t>(first[i]) * 4;
+			const int16_t* w = weights + i * taps;
+			auto acc = vdupq_n_s32(weightRounding);
+			for (unsigned int k = 0; k < taps; ++k) {
+				acc = vmlal_n_s16(acc, vld1_s16(s + k * 4), w[k]);
+			}
+			vst1_s16(dst + i * 4, vqmovn_s32(vshrq_n_s32(acc, resampleWeightBits)));
+		}
+	}
+
+	void ResampleVNEON(const int16_t* const* rows, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count) {
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			auto lo = vdupq_n_s32(weightRounding);
+			auto hi = vdupq_n_s32(weightRounding);
+			for (unsigned int k = 0; k < taps; ++k) {
+				auto a = vld1q_s16(rows[k] + i);
+				lo = vmlal_n_s16(lo, vget_low_s16(a), weights[k]);
+				hi = vmlal_n_s16(hi, vget_high_s16(a), weights[k]);
+			}
+			vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, resampleWeightBits)), vqmovn_s32(vshrq_n_s32(hi, resampleWeightBits))));
+		}
+		for (; i < count; i += 4) {
+			auto acc = vdupq_n_s32(weightRounding);
+			for (unsigned int k = 0; k < taps; ++k) {
+				acc = vmlal_n_s16(acc, vld1_s16(rows[k] + i), weights[k]);
+			}
+			vst1_s16(dst + i, vqmovn_s32(vshrq_n_s32(acc, resampleWeightBits)));
+		}
+	}
+#endif
+
+	using Resample8InFunc = void(*)(const uint32_t* src, int16_t* dst, size_t count, bool premultiply);
+	using Resample8OutFunc = void(*)(const int16_t* src, uint32_t* dst, size_t count, bool unpremultiply);
+	using ResampleHFunc = void(*)(const int16_t* src, const int* first, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count);
+	using ResampleVFunc = void(*)(const int16_t* const* rows, const int16_t* weights, unsigned int taps, int16_t* dst, size_t count);
+
+	//R8G8B8A8との変換は読み書きの量で決まるので、AVX-512でもAVX2と同じもの
+	Kernel<Resample8InFunc> resample8In("resample8in", {
+		{ CpuIsa::Scalar, Resample8InScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, Resample8InSSE41 },
+		{ CpuIsa::AVX2, Resample8InAVX2 },
+		{ CpuIsa::AVX512, Resample8InAVX2 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, Resample8InNEON },
+#endif
+	});
+	Kernel<Resample8OutFunc> resample8Out("resample8out", {
+		{ CpuIsa::Scalar, Resample8OutScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, Resample8OutSSE41 },
+		{ CpuIsa::AVX2, Resample8OutAVX2 },
+		{ CpuIsa::AVX512, Resample8OutAVX2 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, Resample8OutNEON },
+#endif
+	});
+	Kernel<ResampleHFunc> resampleH("resampleh", {
+		{ CpuIsa::Scalar, ResampleHScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, ResampleHSSE41 },
+		{ CpuIsa::AVX2, ResampleHAVX2 },
+		{ CpuIsa::AVX512, ResampleHAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, ResampleHNEON },
+#endif
+	});
+	Kernel<ResampleVFunc> resampleV("resamplev", {
+		{ CpuIsa::Scalar, ResampleVScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, ResampleVSSE41 },
+		{ CpuIsa::AVX2, ResampleVAVX2 },
+		{ CpuIsa::AVX512, ResampleVAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, ResampleVNEON },
+#endif
+	});
+
+	//ここから画像の型ごとの処理(ResampleRowsから呼ぶ)
+
+	//R8G8B8A8:中間はint16_t
+	struct Codec8 {
+		using Pixel = uint32_t;
+		using Value = int16_t;
+		Resample8InFunc in = resample8In.Get();
+		ResampleHFunc horizontal = resampleH.Get();
+		ResampleVFunc vertical = resampleV.Get();
+		Resample8OutFunc out = resample8Out.Get();
+		bool straight;
+
+		explicit Codec8(AlphaMode alpha) :straight(alpha == AlphaMode::Straight) {}
+		void In(const uint32_t* src, int16_t* dst, unsigned int count)const {
+			in(src, dst, count, straight);
+		}
+		void Horizontal(const int16_t* src, const ResampleAxis& axis, int16_t* dst)const {
+			horizontal(src, axis.first.data(), axis.fixedWeights.data(), axis.taps, dst, axis.dstSize);
+		}
+		void Vertical(const int16_t* const* rows, const ResampleAxis& axis, unsigned int y, int16_t* dst, size_t count)const {
+			vertical(rows, axis.fixedWeights.data() + static_cast<size_t>(y) * axis.taps, axis.taps, dst, count);
+		}
+		void Out(const int16_t* src, uint32_t* dst, unsigned int count)const {
+			out(src, dst, count, straight);
+		}
+	};
+
+	//float:中間もfloat(値を切り詰めない)
+	struct CodecF {
+		using Pixel = hlsl::float4;
+		using Value = float;
+		bool straight;
+
+		explicit CodecF(AlphaMode alpha) :straight(alpha == AlphaMode::Straight) {}
+		void In(const hlsl::float4* src, float* dst, unsigned int count)const {
+			for (size_t i = 0; i < count; ++i) {
+				const float m = straight ? src[i].w : 1.0f;
+				for (int c = 0; c < 3; ++c) {
+					dst[i * 4 + c] = src[i][c] * m;
+				}
+				dst[i * 4 + 3] = src[i].w;
+			}
+		}
+		void Horizontal(const float* src, const ResampleAxis& axis, float* dst)const {
+			for (size_t i = 0; i < axis.dstSize; ++i) {
+				const float* s = src + static_cast<size_t>(axis.first[i]) * 4;
+				const float* w = axis.weights.data() + i * axis.taps;
+				float acc[4] = {};
+				for (unsigned int k = 0; k < axis.taps; ++k) {
+					for (int c = 0; c < 4; ++c) {
+						acc[c] += w[k] * s[k * 4 + c];
+					}
+				}
+				for (int c = 0; c < 4; ++c) {
+					dst[i * 4 + c] = acc[c];
+				}
+			}
+		}
+		void Vertical(const float* const* rows, const ResampleAxis& axis, unsigned int y, float* dst, size_t count)const {
+			const float* w = axis.weights.data() + static_cast<size_t>(y) * axis.taps;
+			fill(dst, dst + count, 0.0f);
+			for (unsigned int k = 0; k < axis.taps; ++k) {
+				const float* row = rows[k];
+				for (size_t i = 0; i < count; ++i) {
+					dst[i] += w[k] * row[i];
+				}
+			}
+		}
+		void Out(const float* src, hlsl::float4* dst, unsigned int count)const {
+			for (size_t i = 0; i < count; ++i) {
+				const float alpha = src[i * 4 + 3];
+				const float scale = straight ? (alpha > 0.0f ? 1.0f / alpha : 0.0f) : 1.0f;
+				dst[i] = hlsl::float4(src[i * 4] * scale, src[i * 4 + 1] * scale, src[i * 4 + 2] * scale, alpha);
+			}
+		}
+	};
+
+	unsigned int BandCount(unsigned int height, ComputeExecutor* executor) {
+		if (executor == nullptr || executor->ThreadCount() <= 1) {
+			return 1;
+		}
+		return max(1u, min(height / minBandRows, executor->ThreadCount() * 2));
+	}
+
+	//出力の行の帯ごとに、縦の窓に入る入力の行だけを横に畳み込んでリングバッファ(taps行)にため、縦に畳み込む
+	//出力の行の窓の先頭(first)は単調に増えるので、一度作った行は窓から出るまで使い回せる
+	template<typename Codec>
+	void ResampleRows(const Image<typename Codec::Pixel>& src, Image<typename Codec::Pixel>& dst, const ResampleAxis& axisX, const ResampleAxis& axisY, const Codec& codec, ComputeExecutor* executor) {
+		using Value = typename Codec::Value;
+		const size_t rowValues = static_cast<size_t>(axisX.dstSize) * 4;
+		const unsigned int taps = axisY.taps;
+		const int srcHeight = static_cast<int>(src.height);
+		const unsigned int bandNum = BandCount(axisY.dstSize, executor);
+		auto runBands = [&](size_t begin, size_t end) {
+			//横の入力は窓が画像からはみ出す分(重みは0)を0で埋めておく
+			vector<Value> in(static_cast<size_t>(max(axisX.srcSize, axisX.taps)) * 4, Value(0));
+			vector<Value> ring(rowValues * taps);
+			vector<Value> zeroRow(rowValues, Value(0));
+			vector<Value> out(rowValues);
+			vector<const Value*> rows(taps);
+			for (auto b = begin; b < end; ++b) {
+				const auto y0 = static_cast<unsigned int>(static_cast<uint64_t>(axisY.dstSize) * b / bandNum);
+				const auto y1 = static_cast<unsigned int>(static_cast<uint64_t>(axisY.dstSize) * (b + 1) / bandNum);
+				int built = axisY.first[y0];
+				for (auto y = y0; y < y1; ++y) {
+					const int first = axisY.first[y];
+					built = max(built, first);
+					for (; built < min(first + static_cast<int>(taps), srcHeight); ++built) {
+						codec.In(src.Row(static_cast<unsigned int>(built)), in.data(), src.width);
+						codec.Horizontal(in.data(), axisX, ring.data() + (built % taps) * rowValues);
+					}
+					for (unsigned int k = 0; k < taps; ++k) {
+						const int row = first + static_cast<int>(k);
+						rows[k] = row < srcHeight ? ring.data() + (row % taps) * rowValues : zeroRow.data();
+					}
+					codec.Vertical(rows.data(), axisY, y, out.data(), rowValues);
+					codec.Out(out.data(), dst.Row(y), dst.width);
+				}
+			}
+		};
+		if (bandNum > 1) {
+			executor->ParallelFor(bandNum, 1, runBands);
+		}
+		else {
+			runBands(0, 1);
+		}
+	}
+
+	//出力の画素iの窓の中心(入力の画素単位)・フィルタを広げる倍率・半径
+	struct TapWindow {
+		double center;
+		double stretch;
+		double support;
+		int start;//中心から±support未満の最初の画素
+
+		TapWindow(unsigned int i, unsigned int srcSize, unsigned int dstSize, ResampleFilter filter) {
+			const double scale = static_cast<double>(srcSize) / dstSize;
+			//縮小するときはフィルタを縮小率だけ広げる
+			stretch = max(scale, 1.0);
+			support = hlsl::ResampleSupport(static_cast<hlsl::uint>(filter)) * stretch;
+			center = (i + 0.5) * scale - 0.5;
+			start = static_cast<int>(floor(center - support)) + 1;
+		}
+	};
+
+	//窓のstartからtaps画素の重みをfunc(入力の画素(0～srcSize-1), 正規化前の重み)に渡す。画像の外の画素は端の画素に寄せる
+	template<typename Func>
+	void ForEachTap(const TapWindow& window, unsigned int srcSize, ResampleFilter filter, unsigned int taps, Func func) {
+		for (unsigned int k = 0; k < taps; ++k) {
+			const int j = window.start + static_cast<int>(k);
+			const float w = hlsl::ResampleWeight(static_cast<hlsl::uint>(filter), static_cast<float>((j - window.center) / window.stretch));
+			func(min(max(j, 0), static_cast<int>(srcSize) - 1), static_cast<double>(w));
+		}
+	}
+
+	//窓の画素数(中心から±support未満の整数の数の上限)を偶数に切り上げたもの
+	unsigned int TapCount(unsigned int srcSize, unsigned int dstSize, ResampleFilter filter) {
+		const double stretch = max(static_cast<double>(srcSize) / dstSize, 1.0);
+		const double support = hlsl::ResampleSupport(static_cast<hlsl::uint>(filter)) * stretch;
+		const auto taps = static_cast<unsigned int>(ceil(support)) * 2 + 1;
+		return taps + (taps & 1);
+	}
+
+	template<typename Pixel>
+	void Resize(Image<Pixel>& img, unsigned int width, unsigned int height) {
+		img.width = width;
+		img.height = height;
+		img.pixels.resize(static_cast<size_t>(width) * height);
+	}
+}
+
+ResampleAxis
+MakeResampleAxis(unsigned int srcSize, unsigned int dstSize, ResampleFilter filter) {
+	assert(srcSize > 0 && dstSize > 0);
+	ResampleAxis axis;
+	axis.srcSize = srcSize;
+	axis.dstSize = dstSize;
+	axis.taps = TapCount(srcSize, dstSize, filter);
+	const unsigned int taps = axis.taps;
+	axis.first.resize(dstSize);
+	axis.weights.resize(static_cast<size_t>(dstSize) * taps);
+	axis.fixedWeights.resize(axis.weights.size());
+	vector<double> w(taps);
+	for (unsigned int i = 0; i < dstSize; ++i) {
+		//窓が画像に収まるように先頭を寄せる(収まらなければ0から。はみ出した分の重みは0)
+		const TapWindow window(i, srcSize, dstSize, filter);
+		const int first = srcSize >= taps ? min(max(window.start, 0), static_cast<int>(srcSize - taps)) : 0;
+		double total = 0.0;
+		fill(w.begin(), w.end(), 0.0);
+		ForEachTap(window, srcSize, filter, taps, [&](int j, double weight) {
+			w[j - first] += weight;
+			total += weight;
+		});
+		axis.first[i] = first;
+		//固定小数点は丸めたあと、合計が1になるように一番大きい重みで調整する
+		int fixedTotal = 0;
+		size_t largest = 0;
+		for (unsigned int k = 0; k < taps; ++k) {
+			const double normalized = w[k] / total;
+			auto& fixed = axis.fixedWeights[static_cast<size_t>(i) * taps + k];
+			axis.weights[static_cast<size_t>(i) * taps + k] = static_cast<float>(normalized);
+			fixed = static_cast<int16_t>(lround(normalized * (1 << resampleWeightBits)));
+			fixedTotal += fixed;
+			largest = w[k] > w[largest] ? k : largest;
+		}
+		axis.fixedWeights[static_cast<size_t>(i) * taps + largest] += static_cast<int16_t>((1 << resampleWeightBits) - fixedTotal);
+	}
+	return axis;
+}
+
+void
+Resample(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int width, unsigned int height, ResampleFilter filter, AlphaMode alpha, ComputeExecutor* executor) {
+	assert(&src != &dst && src.width > 0 && src.height > 0 && width > 0 && height > 0);
+	Resize(dst, width, height);
+	const auto axisX = MakeResampleAxis(src.width, width, filter);
+	const auto axisY = MakeResampleAxis(src.height, height, filter);
+	ResampleRows(src, dst, axisX, axisY, Codec8(alpha), executor);
+}
+
+void
+Resample(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int width, unsigned int height, ResampleFilter filter, AlphaMode alpha, ComputeExecutor* executor) {
+	assert(&src != &dst && src.width > 0 && src.height > 0 && width > 0 && height > 0);
+	Resize(dst, width, height);
+	const auto axisX = MakeResampleAxis(src.width, width, filter);
+	const auto axisY = MakeResampleAxis(src.height, height, filter);
+	ResampleRows(src, dst, axisX, axisY, CodecF(alpha), executor);
+}
+
+void
+ResampleReference(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int width, unsigned int height, ResampleFilter filter, AlphaMode alpha) {
+	dst = ImageRGBA32F(width, height);
+	const unsigned int tapsX = TapCount(src.width, width, filter);
+	const unsigned int tapsY = TapCount(src.height, height, filter);
+	vector<pair<int, double>> wx, wy;
+	for (unsigned int y = 0; y < height; ++y) {
+		wy.clear();
+		double totalY = 0.0;
+		ForEachTap(TapWindow(y, src.height, height, filter), src.height, filter, tapsY, [&](int j, double w) { wy.emplace_back(j, w); totalY += w; });
+		for (unsigned int x = 0; x < width; ++x) {
+			wx.clear();
+			double totalX = 0.0;
+			ForEachTap(TapWindow(x, src.width, width, filter), src.width, filter, tapsX, [&](int j, double w) { wx.emplace_back(j, w); totalX += w; });
+			double sum[4] = {};
+			for (auto& ty : wy) {
+				for (auto& tx : wx) {
+					const auto& px = src.At(tx.first, ty.first);
+					const double w = ty.second * tx.second / (totalX * totalY);
+					const double m = alpha == AlphaMode::Straight ? px.w : 1.0;
+					for (int c = 0; c < 3; ++c) {
+						sum[c] += w * px[c] * m;
+					}
+					sum[3] += w * px.w;
+				}
+			}
+			const double scale = alpha == AlphaMode::Straight ? (sum[3] > 0.0 ? 1.0 / sum[3] : 0.0) : 1.0;
+			dst.At(x, y) = hlsl::float4(static_cast<float>(sum[0] * scale), static_cast<float>(sum[1] * scale), static_cast<float>(sum[2] * scale), static_cast<float>(sum[3]));
+		}
+	}
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+#include<vector>
+#include<cstdint>
+#include"Image.h"
+
+class ComputeExecutor;
+
+//拡大縮小(リサンプリング。任意の倍率、縦横別々)
+//RenderTargetFilter/ResampleCS.hlslのCPU版。フィルタの重みはResample.hlsliをシェーダと共有する
+//出力の画素ごとの重みを縦横それぞれ前もって求めておき、横→縦の2パスで畳み込む
+//(シェーダは画像全体で2回通すが、CPUは出力の行の帯ごとに、縦のパスに要る行だけ横に畳み込んでリングバッファにためる)
+//  R8G8B8A8 : 中間は成分あたり63.75倍(8bitの値*255/4)のint16_t、重みは14bitの固定小数点
+//  float    : 中間もfloat
+//アルファが乗っていない画像は、乗算済みにしてから畳み込んで最後に割り戻す(透明な画素の色がにじまない)
+
+///フィルタ(Resample.hlsliのRESAMPLE_～と同じ値)
+enum class ResampleFilter : unsigned int {
+	Bilinear = 0,
+	Bicubic = 1,
+	Lanczos3 = 2,
+};
+
+///画像のアルファの持ち方(入力と出力で同じ)
+enum class AlphaMode {
+	Straight,//色にアルファが乗っていない
+	Premultiplied,//乗算済み
+};
+
+///固定小数点の重みの小数部のビット数(重みの合計が1<<resampleWeightBits)
+constexpr int resampleWeightBits = 14;
+
+///1方向の重み
+///出力の画素iは、入力のfirst[i]からtaps画素にweights[i*taps+k]を掛けて足したもの
+///画像の外の画素は端の画素に寄せてあり、tapsは全画素で同じ偶数(余りの重みは0)
+struct ResampleAxis {
+	unsigned int srcSize = 0;
+	unsigned int dstSize = 0;
+	unsigned int taps = 0;
+	std::vector<int> first;
+	std::vector<float> weights;//合計が1
+	std::vector<int16_t> fixedWeights;//合計が1<<resampleWeightBits
+};
+
+///1方向の重みを求める
+///@param srcSize 入力の画素数
+///@param dstSize 出力の画素数
+///@param filter フィルタ(縮小するときは縮小率だけ広げる)
+ResampleAxis MakeResampleAxis(unsigned int srcSize, unsigned int dstSize, ResampleFilter filter);
+
+///拡大縮小
+///@param src 入力画像
+///@param dst 出力画像(width x heightにされる。srcと同じではいけない)
+///@param width,height 出力の大きさ(1以上)
+///@param filter フィルタ
+///@param alpha アルファの持ち方
+///@param executor nullptrなら呼び出しスレッドだけで処理する。指定すれば出力の行の帯ごとに並列化する
+///@remarks R8G8B8A8はKernelRegistryの"resample8in"/"resampleh"/"resamplev"/"resample8out"で選ばれる
+void Resample(const ImageRGBA8& src, ImageRGBA8& dst, unsigned int width, unsigned int height, ResampleFilter filter, AlphaMode alpha, ComputeExecutor* executor);
+void Resample(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int width, unsigned int height, ResampleFilter filter, AlphaMode alpha, ComputeExecutor* executor);
+
+///基準実装(出力の画素ごとに、窓の全画素の重みをその場で求めてdoubleで足す)
+void ResampleReference(const ImageRGBA32F& src, ImageRGBA32F& dst, unsigned int width, unsigned int height, ResampleFilter filter, AlphaMode alpha);
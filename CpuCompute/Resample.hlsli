@@ -0,0 +1,47 @@
+//gk(TvO)̃tB^
+//ResampleCS.hlslCPU(CpuCompute/Resample.cpp)ŋLĂ܂
+//kƂ̓tB^kL(x/kŏd݂߂)Aׂ͗l܂ԂȂ悤ɂ
+
+#define RESAMPLE_BILINEAR 0//Op`(a1)
+#define RESAMPLE_BICUBIC 1//Keys3(a=-0.5ACatmull-RomBa2)
+#define RESAMPLE_LANCZOS3 2//Lanczos(3[uBa3)
+
+//tB^̔a(͂̉fPʁBkƂ͏k|)
+float ResampleSupport(uint filter)
+{
+    return filter == RESAMPLE_BILINEAR ? 1.0f : (filter == RESAMPLE_BICUBIC ? 2.0f : 3.0f);
+}
+
+//Sxf̏d(KOBd݂̍vŊĎg)
+float ResampleWeight(uint filter, float x)
+{
+    x = abs(x);
+    if (filter == RESAMPLE_BILINEAR)
+    {
+        return max(1.0f - x, 0.0f);
+    }
+    if (filter == RESAMPLE_BICUBIC)
+    {
+        const float a = -0.5f;
+        if (x < 1.0f)
+        {
+            return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+        }
+        if (x < 2.0f)
+        {
+            return ((a * x - 5.0f * a) * x + 8.0f * a) * x - 4.0f * a;
+        }
+        return 0.0f;
+    }
+    if (x < 1e-5f)
+    {
+        return 1.0f;
+    }
+    if (x >= 3.0f)
+    {
+        return 0.0f;
+    }
+    const float pi = 3.14159265f;
+    float px = pi * x;
+    return 3.0f * sin(px) * sin(px / 3.0f) / (px * px);
+}
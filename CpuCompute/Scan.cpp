@@ -0,0 +1,397 @@
+﻿#include "Scan.h"
+#include<cassert>
+#include<cstring>
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+using namespace std;
+using ScanDetail::blockElements;
+
+namespace {
+	//ここからブロック単位のスキャン
+	//carryを足しながらスキャンし、carry+ブロックの合計を返す
+
+	uint32_t ScanBlockScalar(const uint32_t* src, uint32_t* dst, size_t count, uint32_t carry, bool inclusive) {
+		if (inclusive) {
+			for (size_t i = 0; i < count; ++i) {
+				carry += src[i];
+				dst[i] = carry;
+			}
+		}
+		else {
+			for (size_t i = 0; i < count; ++i) {
+				auto v = src[i];
+				dst[i] = carry;
+				carry += v;
+			}
+		}
+		return carry;
+	}
+
+#if defined(CPU_ARCH_X86)
+	//レジスタ内のスキャンは左シフトして足すのをlog2(レーン数)回(Hillis-Steele)
+	//排他的スキャンは包含的スキャンから元の値を引いて求める
+
+	CPU_TARGET_SSE41 uint32_t ScanBlockSSE41(const uint32_t* src, uint32_t* dst, size_t count, uint32_t carry, bool inclusive) {
+		auto carryVec = _mm_set1_epi32(carry);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			auto x = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi32(x, carryVec);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), inclusive ? x : _mm_sub_epi32(x, v));
+			carryVec = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+		return ScanBlockScalar(src + i, dst + i, count - i, static_cast<uint32_t>(_mm_cvtsi128_si32(carryVec)), inclusive);
+	}
+
+	CPU_TARGET_AVX2 uint32_t ScanBlockAVX2(const uint32_t* src, uint32_t* dst, size_t count, uint32_t carry, bool inclusive) {
+		auto carryVec = _mm256_set1_epi32(carry);
+		const auto last = _mm256_set1_epi32(7);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			//128bitレーンごとにスキャンしてから、下位レーンの合計を上位レーンに足す
+			auto x = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+			auto lowTotal = _mm256_shuffle_epi32(_mm256_permute2x128_si256(x, x, 0x08), _MM_SHUFFLE(3, 3, 3, 3));
+			x = _mm256_add_epi32(_mm256_add_epi32(x, lowTotal), carryVec);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), inclusive ? x : _mm256_sub_epi32(x, v));
+			carryVec = _mm256_permutevar8x32_epi32(x, last);
+		}
+		const auto carryOut = static_cast<uint32_t>(_mm256_cvtsi256_si32(carryVec));
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		return ScanBlockScalar(src + i, dst + i, count - i, carryOut, inclusive);
+	}
+
+	CPU_TARGET_AVX512 uint32_t ScanBlockAVX512(const uint32_t* src, uint32_t* dst, size_t count, uint32_t carry, bool inclusive) {
+		auto carryVec = _mm512_set1_epi32(carry);
+		const auto zero = _mm512_setzero_si512();
+		const auto last = _mm512_set1_epi32(15);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			auto v = _mm512_loadu_si512(src + i);
+			//alignr(x,0,16-k)でkレーン左にずらす(空いたところは0)
+			auto x = _mm512_add_epi32(v, _mm512_alignr_epi32(v, zero, 15));
+			x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 14));
+			x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 12));
+			x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 8));
+			x = _mm512_add_epi32(x, carryVec);
+			_mm512_storeu_si512(dst + i, inclusive ? x : _mm512_sub_epi32(x, v));
+			carryVec = _mm512_permutexvar_epi32(last, x);
+		}
+		const auto carryOut = static_cast<uint32_t>(_mm512_cvtsi512_si32(carryVec));
+		_mm256_zeroupper();
+		return ScanBlockScalar(src + i, dst + i, count - i, carryOut, inclusive);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	uint32_t ScanBlockNEON(const uint32_t* src, uint32_t* dst, size_t count, uint32_t carry, bool inclusive) {
+		auto carryVec = vdupq_n_u32(carry);
+		const auto zero = vdupq_n_u32(0);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto v = vld1q_u32(src + i);
+			auto x = vaddq_u32(v, vextq_u32(zero, v, 3));
+			x = vaddq_u32(x, vextq_u32(zero, x, 2));
+			x = vaddq_u32(x, carryVec);
+			vst1q_u32(dst + i, inclusive ? x : vsubq_u32(x, v));
+			carryVec = vdupq_laneq_u32(x, 3);
+		}
+		return ScanBlockScalar(src + i, dst + i, count - i, vgetq_lane_u32(carryVec, 0), inclusive);
+	}
+#endif
+
+	using ScanBlockFunc = uint32_t(*)(const uint32_t* src, uint32_t* dst, size_t count, uint32_t carry, bool inclusive);
+	Kernel<ScanBlockFunc> scanBlock("scan", {
+		{ CpuIsa::Scalar, ScanBlockScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, ScanBlockSSE41 },
+		{ CpuIsa::AVX2, ScanBlockAVX2 },
+		{ CpuIsa::AVX512, ScanBlockAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, ScanBlockNEON },
+#endif
+	});
+
+	//ここからブロック単位のコンパクション
+	//values[i] > thresholdの番号(base+i)をindicesに詰め、書いた数を返す
+	//SIMDは1回に全レーンぶん書くので、capacity(このブロックが書いてよい数)の手前までは直接、その先は一時領域から写す
+
+	size_t CompactBlockScalar(const float* values, size_t count, float threshold, uint32_t base, uint32_t* indices, size_t capacity) {
+		//選ばれるかどうかはでたらめなことが多いので、分岐せずに毎回書いて数だけ進める
+		size_t n = 0;
+		for (size_t i = 0; i < count; ++i) {
+			if (n < capacity) {
+				indices[n] = base + static_cast<uint32_t>(i);
+			}
+			n += values[i] > threshold ? 1 : 0;
+		}
+		assert(n <= capacity);
+		return n;
+	}
+
+	///4レーンの比較結果(4bit)→選ばれたレーンを前に詰めるバイトの並べ替え(pshufb/tbl用)と選ばれた数
+	///@remarks popcnt命令はSSE4.1/AVX2のtarget属性に含まれないので、数も表で引く
+	struct CompactTable4 {
+		alignas(16) uint8_t shuffle[16][16];
+		uint8_t count[16];
+		CompactTable4() {
+			for (int mask = 0; mask < 16; ++mask) {
+				int n = 0;
+				for (int lane = 0; lane < 4; ++lane) {
+					if (mask & (1 << lane)) {
+						for (int b = 0; b < 4; ++b) {
+							shuffle[mask][n * 4 + b] = static_cast<uint8_t>(lane * 4 + b);
+						}
+						++n;
+					}
+				}
+				for (int b = n * 4; b < 16; ++b) {
+					shuffle[mask][b] = 0x80;//0にする
+				}
+				count[mask] = static_cast<uint8_t>(n);
+			}
+		}
+	};
+	const CompactTable4& GetCompactTable4() {
+		static CompactTable4 table;
+		return table;
+	}
+
+#if defined(CPU_ARCH_X86)
+	///8レーンの比較結果(8bit)→選ばれたレーンを前に詰めるvpermdの添字(1レーン1バイト)と選ばれた数
+	struct CompactTable8 {
+		uint64_t permute[256];
+		uint8_t count[256];
+		CompactTable8() {
+			for (int mask = 0; mask < 256; ++mask) {
+				uint64_t p = 0;
+				int n = 0;
+				for (int lane = 0; lane < 8; ++lane) {
+					if (mask & (1 << lane)) {
+						p |= static_cast<uint64_t>(lane) << (n++ * 8);
+					}
+				}
+				permute[mask] = p;
+				count[mask] = static_cast<uint8_t>(n);
+			}
+		}
+	};
+	const CompactTable8& GetCompactTable8() {
+		static CompactTable8 table;
+		return table;
+	}
+
+	CPU_TARGET_SSE41 size_t CompactBlockSSE41(const float* values, size_t count, float threshold, uint32_t base, uint32_t* indices, size_t capacity) {
+		auto& table = GetCompactTable4();
+		const auto thresholdVec = _mm_set1_ps(threshold);
+		auto index = _mm_add_epi32(_mm_set1_epi32(base), _mm_setr_epi32(0, 1, 2, 3));
+		size_t n = 0;
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			auto mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(values + i), thresholdVec));
+			auto packed = _mm_shuffle_epi8(index, _mm_load_si128(reinterpret_cast<const __m128i*>(table.shuffle[mask])));
+			size_t k = table.count[mask];
+			if (n + 4 <= capacity) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(indices + n), packed);
+			}
+			else {
+				alignas(16) uint32_t tmp[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(tmp), packed);
+				memcpy(indices + n, tmp, k * sizeof(uint32_t));
+			}
+			n += k;
+			index = _mm_add_epi32(index, _mm_set1_epi32(4));
+		}
+		return n + CompactBlockScalar(values + i, count - i, threshold, base + static_cast<uint32_t>(i), indices + n, capacity - n);
+	}
+
+	CPU_TARGET_AVX2 size_t CompactBlockAVX2(const float* values, size_t count, float threshold, uint32_t base, uint32_t* indices, size_t capacity) {
+		auto& table = GetCompactTable8();
+		const auto thresholdVec = _mm256_set1_ps(threshold);
+		auto index = _mm256_add_epi32(_mm256_set1_epi32(base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		size_t n = 0;
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			auto mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), thresholdVec, _CMP_GT_OQ));
+			auto permute = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&table.permute[mask])));
+			auto packed = _mm256_permutevar8x32_epi32(index, permute);
+			size_t k = table.count[mask];
+			if (n + 8 <= capacity) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(indices + n), packed);
+			}
+			else {
+				alignas(32) uint32_t tmp[8];
+				_mm256_store_si256(reinterpret_cast<__m256i*>(tmp), packed);
+				memcpy(indices + n, tmp, k * sizeof(uint32_t));
+			}
+			n += k;
+			index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+		}
+		return n + CompactBlockScalar(values + i, count - i, threshold, base + static_cast<uint32_t>(i), indices + n, capacity - n);
+	}
+
+	//AVX-512は詰めるのも(vpcompressd)選んだ数だけ書くのも(マスク付きストア)命令があるのでcapacityは見なくてよい
+	CPU_TARGET_AVX512 size_t CompactBlockAVX512(const float* values, size_t count, float threshold, uint32_t base, uint32_t* indices, size_t capacity) {
+		auto& table = GetCompactTable8();
+		const auto thresholdVec = _mm512_set1_ps(threshold);
+		auto index = _mm512_add_epi32(_mm512_set1_epi32(base), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+		size_t n = 0;
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			auto mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i), thresholdVec, _CMP_GT_OQ);
+			unsigned int k = table.count[mask & 0xff] + table.count[mask >> 8];
+			_mm512_mask_storeu_epi32(indices + n, static_cast<__mmask16>((1u << k) - 1), _mm512_maskz_compress_epi32(mask, index));
+			n += k;
+			index = _mm512_add_epi32(index, _mm512_set1_epi32(16));
+		}
+		return n + CompactBlockScalar(values + i, count - i, threshold, base + static_cast<uint32_t>(i), indices + n, capacity - n);
+	}
+#endif
+
+#if defined(CPU_ARCH_ARM64)
+	size_t CompactBlockNEON(const float* values, size_t count, float threshold, uint32_t base, uint32_t* indices, size_t capacity) {
+		auto& table = GetCompactTable4();
+		const auto thresholdVec = vdupq_n_f32(threshold);
+		const uint32_t laneBitsArray[] = { 1,2,4,8 };
+		const auto laneBits = vld1q_u32(laneBitsArray);
+		const uint32_t laneOffsets[] = { 0,1,2,3 };
+		auto index = vaddq_u32(vdupq_n_u32(base), vld1q_u32(laneOffsets));
+		size_t n = 0;
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			//NEONにはmovemaskがないので、レーンごとのビットを足してマスクにする
+			auto mask = vaddvq_u32(vandq_u32(vcgtq_f32(vld1q_f32(values + i), thresholdVec), laneBits));
+			auto packed = vreinterpretq_u32_u8(vqtbl1q_u8(vreinterpretq_u8_u32(index), vld1q_u8(table.shuffle[mask])));
+			size_t k = table.count[mask];
+			if (n + 4 <= capacity) {
+				vst1q_u32(indices + n, packed);
+			}
+			else {
+				uint32_t tmp[4];
+				vst1q_u32(tmp, packed);
+				memcpy(indices + n, tmp, k * sizeof(uint32_t));
+			}
+			n += k;
+			index = vaddq_u32(index, vdupq_n_u32(4));
+		}
+		return n + CompactBlockScalar(values + i, count - i, threshold, base + static_cast<uint32_t>(i), indices + n, capacity - n);
+	}
+#endif
+
+	using CompactBlockFunc = size_t(*)(const float* values, size_t count, float threshold, uint32_t base, uint32_t* indices, size_t capacity);
+	Kernel<CompactBlockFunc> compactBlock("compact", {
+		{ CpuIsa::Scalar, CompactBlockScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, CompactBlockSSE41 },
+		{ CpuIsa::AVX2, CompactBlockAVX2 },
+		{ CpuIsa::AVX512, CompactBlockAVX512 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, CompactBlockNEON },
+#endif
+	});
+
+	///1スレッドで実行するなら2回読む必要はない
+	bool RunsSerially(ComputeExecutor* executor, size_t blockNum) {
+		return executor == nullptr || executor->ThreadCount() == 1 || blockNum <= 1;
+	}
+
+	uint32_t Scan(const uint32_t* src, uint32_t* dst, size_t count, ComputeExecutor* executor, bool inclusive) {
+		auto func = scanBlock.Get();
+		const size_t blockNum = (count + blockElements - 1) / blockElements;
+		if (RunsSerially(executor, blockNum)) {
+			return func(src, dst, count, 0, inclusive);
+		}
+		//ブロックごとの合計
+		vector<uint32_t> carries(blockNum);
+		executor->ParallelFor(blockNum, 1, [&](size_t begin, size_t end) {
+			for (auto b = begin; b < end; ++b) {
+				const auto first = b * blockElements;
+				const auto last = min(count, first + blockElements);
+				uint32_t sum = 0;
+				for (auto i = first; i < last; ++i) {
+					sum += src[i];
+				}
+				carries[b] = sum;
+			}
+		});
+		//ブロックの合計の排他的スキャンが、各ブロックの初期値になる
+		uint32_t total = 0;
+		for (auto& c : carries) {
+			auto sum = c;
+			c = total;
+			total += sum;
+		}
+		executor->ParallelFor(blockNum, 1, [&](size_t begin, size_t end) {
+			for (auto b = begin; b < end; ++b) {
+				const auto first = b * blockElements;
+				func(src + first, dst + first, min(blockElements, count - first), carries[b], inclusive);
+			}
+		});
+		return total;
+	}
+}
+
+size_t
+ScanDetail::BlockOffsets(vector<size_t>& counts) {
+	size_t total = 0;
+	for (auto& c : counts) {
+		auto n = c;
+		c = total;
+		total += n;
+	}
+	return total;
+}
+
+uint32_t
+ExclusiveScan(const uint32_t* src, uint32_t* dst, size_t count, ComputeExecutor* executor) {
+	return Scan(src, dst, count, executor, false);
+}
+
+uint32_t
+InclusiveScan(const uint32_t* src, uint32_t* dst, size_t count, ComputeExecutor* executor) {
+	return Scan(src, dst, count, executor, true);
+}
+
+size_t
+CompactIndicesGreater(const float* values, size_t count, float threshold, uint32_t* indices, ComputeExecutor* executor) {
+	//番号はuint32_t(GPUのバッファと同じ)
+	assert(count <= UINT32_MAX);
+	auto func = compactBlock.Get();
+	const size_t blockNum = (count + blockElements - 1) / blockElements;
+	if (RunsSerially(executor, blockNum)) {
+		//詰めた位置は読んだ位置を追い越さないので、出力全体をcapacityにしてよい
+		return func(values, count, threshold, 0, indices, count);
+	}
+	vector<size_t> counts(blockNum);
+	executor->ParallelFor(blockNum, 1, [&](size_t begin, size_t end) {
+		for (auto b = begin; b < end; ++b) {
+			const auto first = b * blockElements;
+			const auto last = min(count, first + blockElements);
+			size_t n = 0;
+			for (auto i = first; i < last; ++i) {
+				n += values[i] > threshold ? 1 : 0;
+			}
+			counts[b] = n;
+		}
+	});
+	vector<size_t> offsets = counts;
+	auto total = ScanDetail::BlockOffsets(offsets);
+	executor->ParallelFor(blockNum, 1, [&](size_t begin, size_t end) {
+		for (auto b = begin; b < end; ++b) {
+			const auto first = b * blockElements;
+			auto n = func(values + first, min(blockElements, count - first), threshold, static_cast<uint32_t>(first), indices + offsets[b], counts[b]);
+			assert(n == counts[b]);
+			(void)n;
+		}
+	});
+	return total;
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+#include<cstdint>
+#include<cstddef>
+#include<vector>
+#include<algorithm>
+#include"ComputeExecutor.h"
+
+//プレフィックスサム(スキャン)とストリームコンパクション
+//FirstStep/ScanCS.hlslのCPU版。GPUは1パスのdecoupled look-backだが、CPUはコア数が少ないので
+//ブロックごとの合計→ブロックの合計のスキャン→ブロックごとのスキャン、の2回読みで並列化する(reduce-then-scan)
+//合計はGPUと同じくuint32_tで2^32を法として回る
+
+///排他的スキャン(dst[i] = src[0] + … + src[i-1])
+///@param src 入力(count個)
+///@param dst 出力(count個。srcと同じでもよい)
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+///@return 全体の合計
+uint32_t ExclusiveScan(const uint32_t* src, uint32_t* dst, size_t count, ComputeExecutor* executor);
+
+///包含的スキャン(dst[i] = src[0] + … + src[i])
+///@return 全体の合計
+uint32_t InclusiveScan(const uint32_t* src, uint32_t* dst, size_t count, ComputeExecutor* executor);
+
+///values[i] > thresholdの要素の番号を順に詰めて書き出す(SoAの1列に対するコンパクション)
+///@param indices 出力(最大count個)
+///@return 書き出した数
+///@remarks 実装はKernelRegistryの"compact"で選ばれる(AVX-512はvpcompressd、AVX2/SSEは並べ替え表)
+size_t CompactIndicesGreater(const float* values, size_t count, float threshold, uint32_t* indices, ComputeExecutor* executor);
+
+namespace ScanDetail {
+	///スキャン・コンパクションの並列化の単位(要素数)
+	constexpr size_t blockElements = 64 * 1024;
+
+	///ブロックごとの数を排他的スキャンして、ブロックの書き込み位置にする
+	///@return 全体の数
+	size_t BlockOffsets(std::vector<size_t>& counts);
+}
+
+///pred(src[i])がtrueの要素を順序を保って詰めてdstに書く(型つきバッファのコンパクション)
+///ブロックごとに数える→ブロックの数をスキャン→ブロックごとに書き込み位置から書く
+///@param src 入力(count個)
+///@param dst 出力(最大count個。srcと重なってはいけない)
+///@param pred 残す要素ならtrue(複数スレッドから同時に呼ばれる)
+///@return 書き出した数
+template<typename T, typename Pred>
+size_t Compact(const T* src, size_t count, T* dst, Pred pred, ComputeExecutor* executor) {
+	using ScanDetail::blockElements;
+	const size_t blockNum = (count + blockElements - 1) / blockElements;
+	std::vector<size_t> counts(blockNum);
+	auto countBlocks = [&](size_t begin, size_t end) {
+		for (auto b = begin; b < end; ++b) {
+			size_t n = 0;
+			const auto last = std::min(count, (b + 1) * blockElements);
+			for (auto i = b * blockElements; i < last; ++i) {
+				n += pred(src[i]) ? 1 : 0;
+			}
+			counts[b] = n;
+		}
+	};
+	std::vector<size_t> offsets;
+	auto writeBlocks = [&](size_t begin, size_t end) {
+		for (auto b = begin; b < end; ++b) {
+			//分岐を読み違えないよう毎回書いて、残すときだけ進める(ブロックの数を超えては書かない)
+			auto out = dst + offsets[b];
+			const auto capacity = counts[b];
+			size_t n = 0;
+			const auto last = std::min(count, (b + 1) * blockElements);
+			for (auto i = b * blockElements; i < last; ++i) {
+				if (n < capacity) {
+					out[n] = src[i];
+				}
+				n += pred(src[i]) ? 1 : 0;
+			}
+		}
+	};
+	if (executor != nullptr) {
+		executor->ParallelFor(blockNum, 1, countBlocks);
+	}
+	else {
+		countBlocks(0, blockNum);
+	}
+	offsets = counts;
+	auto total = ScanDetail::BlockOffsets(offsets);
+	if (executor != nullptr) {
+		executor->ParallelFor(blockNum, 1, writeBlocks);
+	}
+	else {
+		writeBlocks(0, blockNum);
+	}
+	return total;
+}
@@ -0,0 +1,243 @@
+﻿#include "SoaBuffer.h"
+#include"KernelRegistry.h"
+
+#if defined(CPU_ARCH_X86)
+#include<immintrin.h>
+#elif defined(CPU_ARCH_ARM64)
+#include<arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace {
+	//[begin,count)をスカラーで並べ替える(SIMD版の端数処理も兼ねる)
+	void AosToSoaScalar(const uint32_t* aos, size_t begin, size_t count, unsigned int fieldCount, uint32_t* const* columns) {
+		for (size_t i = begin; i < count; ++i) {
+			for (unsigned int f = 0; f < fieldCount; ++f) {
+				columns[f][i] = aos[i * fieldCount + f];
+			}
+		}
+	}
+	void SoaToAosScalar(const uint32_t* const* columns, size_t begin, size_t count, unsigned int fieldCount, uint32_t* aos) {
+		for (size_t i = begin; i < count; ++i) {
+			for (unsigned int f = 0; f < fieldCount; ++f) {
+				aos[i * fieldCount + f] = columns[f][i];
+			}
+		}
+	}
+
+	void AosToSoaRefScalar(const uint32_t* aos, size_t count, unsigned int fieldCount, uint32_t* const* columns) {
+		AosToSoaScalar(aos, 0, count, fieldCount, columns);
+	}
+	void SoaToAosRefScalar(const uint32_t* const* columns, size_t count, unsigned int fieldCount, uint32_t* aos) {
+		SoaToAosScalar(columns, 0, count, fieldCount, aos);
+	}
+
+#if defined(CPU_ARCH_X86)
+	CPU_TARGET_SSE41 void AosToSoaSSE41(const uint32_t* aos, size_t count, unsigned int fieldCount, uint32_t* const* columns) {
+		auto src = reinterpret_cast<const float*>(aos);
+		size_t i = 0;
+		if (fieldCount == 4) {
+			//4要素ずつ4x4の転置
+			for (; i + 4 <= count; i += 4) {
+				auto r0 = _mm_loadu_ps(src + i * 4);
+				auto r1 = _mm_loadu_ps(src + i * 4 + 4);
+				auto r2 = _mm_loadu_ps(src + i * 4 + 8);
+				auto r3 = _mm_loadu_ps(src + i * 4 + 12);
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+				_mm_storeu_ps(reinterpret_cast<float*>(columns[0] + i), r0);
+				_mm_storeu_ps(reinterpret_cast<float*>(columns[1] + i), r1);
+				_mm_storeu_ps(reinterpret_cast<float*>(columns[2] + i), r2);
+				_mm_storeu_ps(reinterpret_cast<float*>(columns[3] + i), r3);
+			}
+		}
+		else if (fieldCount == 2) {
+			//(x0,y0,x1,y1)(x2,y2,x3,y3)→(x0..x3)(y0..y3)
+			for (; i + 4 <= count; i += 4) {
+				auto a = _mm_loadu_ps(src + i * 2);
+				auto b = _mm_loadu_ps(src + i * 2 + 4);
+				_mm_storeu_ps(reinterpret_cast<float*>(columns[0] + i), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+				_mm_storeu_ps(reinterpret_cast<float*>(columns[1] + i), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			}
+		}
+		AosToSoaScalar(aos, i, count, fieldCount, columns);
+	}
+
+	CPU_TARGET_SSE41 void SoaToAosSSE41(const uint32_t* const* columns, size_t count, unsigned int fieldCount, uint32_t* aos) {
+		auto dst = reinterpret_cast<float*>(aos);
+		size_t i = 0;
+		if (fieldCount == 4) {
+			for (; i + 4 <= count; i += 4) {
+				auto r0 = _mm_loadu_ps(reinterpret_cast<const float*>(columns[0] + i));
+				auto r1 = _mm_loadu_ps(reinterpret_cast<const float*>(columns[1] + i));
+				auto r2 = _mm_loadu_ps(reinterpret_cast<const float*>(columns[2] + i));
+				auto r3 = _mm_loadu_ps(reinterpret_cast<const float*>(columns[3] + i));
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+				_mm_storeu_ps(dst + i * 4, r0);
+				_mm_storeu_ps(dst + i * 4 + 4, r1);
+				_mm_storeu_ps(dst + i * 4 + 8, r2);
+				_mm_storeu_ps(dst + i * 4 + 12, r3);
+			}
+		}
+		else if (fieldCount == 2) {
+			for (; i + 4 <= count; i += 4) {
+				auto x = _mm_loadu_ps(reinterpret_cast<const float*>(columns[0] + i));
+				auto y = _mm_loadu_ps(reinterpret_cast<const float*>(columns[1] + i));
+				_mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(x, y));
+				_mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(x, y));
+			}
+		}
+		SoaToAosScalar(columns, i, count, fieldCount, aos);
+	}
+
+	CPU_TARGET_AVX2 void AosToSoaAVX2(const uint32_t* aos, size_t count, unsigned int fieldCount, uint32_t* const* columns) {
+		auto src = reinterpret_cast<const float*>(aos);
+		size_t i = 0;
+		if (fieldCount == 4) {
+			//8要素ずつ。128bitレーン内で転置してから、レーンをまたいで並べ直す
+			const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+			for (; i + 8 <= count; i += 8) {
+				auto r01 = _mm256_loadu_ps(src + i * 4);
+				auto r23 = _mm256_loadu_ps(src + i * 4 + 8);
+				auto r45 = _mm256_loadu_ps(src + i * 4 + 16);
+				auto r67 = _mm256_loadu_ps(src + i * 4 + 24);
+				auto t0 = _mm256_unpacklo_ps(r01, r23);//x0 x2 y0 y2 | x1 x3 y1 y3
+				auto t1 = _mm256_unpackhi_ps(r01, r23);//z0 z2 w0 w2 | z1 z3 w1 w3
+				auto t2 = _mm256_unpacklo_ps(r45, r67);
+				auto t3 = _mm256_unpackhi_ps(r45, r67);
+				auto x = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));//x0 x2 x4 x6 | x1 x3 x5 x7
+				auto y = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+				auto z = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+				auto w = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+				_mm256_storeu_ps(reinterpret_cast<float*>(columns[0] + i), _mm256_permutevar8x32_ps(x, order));
+				_mm256_storeu_ps(reinterpret_cast<float*>(columns[1] + i), _mm256_permutevar8x32_ps(y, order));
+				_mm256_storeu_ps(reinterpret_cast<float*>(columns[2] + i), _mm256_permutevar8x32_ps(z, order));
+				_mm256_storeu_ps(reinterpret_cast<float*>(columns[3] + i), _mm256_permutevar8x32_ps(w, order));
+			}
+		}
+		else if (fieldCount == 2) {
+			for (; i + 8 <= count; i += 8) {
+				auto a = _mm256_loadu_ps(src + i * 2);
+				auto b = _mm256_loadu_ps(src + i * 2 + 8);
+				//x0 x1 x4 x5 | x2 x3 x6 x7 を64bit単位で並べ直す
+				auto x = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+				auto y = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+				_mm256_storeu_ps(reinterpret_cast<float*>(columns[0] + i), _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(x), _MM_SHUFFLE(3, 1, 2, 0))));
+				_mm256_storeu_ps(reinterpret_cast<float*>(columns[1] + i), _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(y), _MM_SHUFFLE(3, 1, 2, 0))));
+			}
+		}
+		_mm256_zeroupper();//スカラーの端数処理に上位のレジスタの状態を持ち込まない(遅くなる)
+		AosToSoaScalar(aos, i, count, fieldCount, columns);
+	}
+
+	CPU_TARGET_AVX2 void SoaToAosAVX2(const uint32_t* const* columns, size_t count, unsigned int fieldCount, uint32_t* aos) {
+		auto dst = reinterpret_cast<float*>(aos);
+		size_t i = 0;
+		if (fieldCount == 4) {
+			//AosToSoaAVX2の逆順
+			const auto order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+			for (; i + 8 <= count; i += 8) {
+				auto x = _mm256_permutevar8x32_ps(_mm256_loadu_ps(reinterpret_cast<const float*>(columns[0] + i)), order);
+				auto y = _mm256_permutevar8x32_ps(_mm256_loadu_ps(reinterpret_cast<const float*>(columns[1] + i)), order);
+				auto z = _mm256_permutevar8x32_ps(_mm256_loadu_ps(reinterpret_cast<const float*>(columns[2] + i)), order);
+				auto w = _mm256_permutevar8x32_ps(_mm256_loadu_ps(reinterpret_cast<const float*>(columns[3] + i)), order);
+				auto t0 = _mm256_unpacklo_ps(x, y);//x0 y0 x2 y2 | x1 y1 x3 y3
+				auto t1 = _mm256_unpackhi_ps(x, y);//x4 y4 x6 y6 | x5 y5 x7 y7
+				auto t2 = _mm256_unpacklo_ps(z, w);
+				auto t3 = _mm256_unpackhi_ps(z, w);
+				_mm256_storeu_ps(dst + i * 4, _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)));
+				_mm256_storeu_ps(dst + i * 4 + 8, _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)));
+				_mm256_storeu_ps(dst + i * 4 + 16, _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)));
+				_mm256_storeu_ps(dst + i * 4 + 24, _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)));
+			}
+		}
+		else if (fieldCount == 2) {
+			for (; i + 8 <= count; i += 8) {
+				auto x = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_loadu_ps(reinterpret_cast<const float*>(columns[0] + i))), _MM_SHUFFLE(3, 1, 2, 0)));
+				auto y = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_loadu_ps(reinterpret_cast<const float*>(columns[1] + i))), _MM_SHUFFLE(3, 1, 2, 0)));
+				_mm256_storeu_ps(dst + i * 2, _mm256_unpacklo_ps(x, y));
+				_mm256_storeu_ps(dst + i * 2 + 8, _mm256_unpackhi_ps(x, y));
+			}
+		}
+		_mm256_zeroupper();
+		SoaToAosScalar(columns, i, count, fieldCount, aos);
+	}
+#elif defined(CPU_ARCH_ARM64)
+	//NEONはインターリーブ読み書き(vld4/vld2)がそのまま転置になる
+	void AosToSoaNEON(const uint32_t* aos, size_t count, unsigned int fieldCount, uint32_t* const* columns) {
+		size_t i = 0;
+		if (fieldCount == 4) {
+			for (; i + 4 <= count; i += 4) {
+				auto v = vld4q_u32(aos + i * 4);
+				vst1q_u32(columns[0] + i, v.val[0]);
+				vst1q_u32(columns[1] + i, v.val[1]);
+				vst1q_u32(columns[2] + i, v.val[2]);
+				vst1q_u32(columns[3] + i, v.val[3]);
+			}
+		}
+		else if (fieldCount == 2) {
+			for (; i + 4 <= count; i += 4) {
+				auto v = vld2q_u32(aos + i * 2);
+				vst1q_u32(columns[0] + i, v.val[0]);
+				vst1q_u32(columns[1] + i, v.val[1]);
+			}
+		}
+		AosToSoaScalar(aos, i, count, fieldCount, columns);
+	}
+
+	void SoaToAosNEON(const uint32_t* const* columns, size_t count, unsigned int fieldCount, uint32_t* aos) {
+		size_t i = 0;
+		if (fieldCount == 4) {
+			for (; i + 4 <= count; i += 4) {
+				uint32x4x4_t v;
+				v.val[0] = vld1q_u32(columns[0] + i);
+				v.val[1] = vld1q_u32(columns[1] + i);
+				v.val[2] = vld1q_u32(columns[2] + i);
+				v.val[3] = vld1q_u32(columns[3] + i);
+				vst4q_u32(aos + i * 4, v);
+			}
+		}
+		else if (fieldCount == 2) {
+			for (; i + 4 <= count; i += 4) {
+				uint32x4x2_t v;
+				v.val[0] = vld1q_u32(columns[0] + i);
+				v.val[1] = vld1q_u32(columns[1] + i);
+				vst2q_u32(aos + i * 2, v);
+			}
+		}
+		SoaToAosScalar(columns, i, count, fieldCount, aos);
+	}
+#endif
+
+	using AosToSoaFunc = void(*)(const uint32_t* aos, size_t count, unsigned int fieldCount, uint32_t* const* columns);
+	Kernel<AosToSoaFunc> aosToSoa("aos2soa", {
+		{ CpuIsa::Scalar, AosToSoaRefScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, AosToSoaSSE41 },
+		{ CpuIsa::AVX2, AosToSoaAVX2 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, AosToSoaNEON },
+#endif
+	});
+
+	using SoaToAosFunc = void(*)(const uint32_t* const* columns, size_t count, unsigned int fieldCount, uint32_t* aos);
+	Kernel<SoaToAosFunc> soaToAos("soa2aos", {
+		{ CpuIsa::Scalar, SoaToAosRefScalar },
+#if defined(CPU_ARCH_X86)
+		{ CpuIsa::SSE41, SoaToAosSSE41 },
+		{ CpuIsa::AVX2, SoaToAosAVX2 },
+#elif defined(CPU_ARCH_ARM64)
+		{ CpuIsa::NEON, SoaToAosNEON },
+#endif
+	});
+}
+
+void
+TransposeAosToSoa(const uint32_t* aos, size_t count, unsigned int fieldCount, uint32_t* const* columns) {
+	aosToSoa.Get()(aos, count, fieldCount, columns);
+}
+
+void
+TransposeSoaToAos(const uint32_t* const* columns, size_t count, unsigned int fieldCount, uint32_t* aos) {
+	soaToAos.Get()(columns, count, fieldCount, aos);
+}
@@ -0,0 +1,257 @@
+﻿#pragma once
+#include<vector>
+#include<tuple>
+#include<cstdint>
+#include<cstddef>
+#include<cassert>
+#include<utility>
+#include<type_traits>
+#include"ComputeJob.h"
+
+///4バイトのフィールドがfieldCount個並んだ構造体の配列(AoS)を、フィールドごとの配列(SoA)に並べ替える
+///@param aos 入力(count*fieldCount個)
+///@param count 要素数
+///@param fieldCount 1要素のフィールド数(2と4はSIMDで、それ以外はスカラーで並べ替える)
+///@param columns 出力(フィールドごとにcount個)
+///@remarks 実装はKernelRegistryの"aos2soa"で選ばれる
+void TransposeAosToSoa(const uint32_t* aos, size_t count, unsigned int fieldCount, uint32_t* const* columns);
+
+///TransposeAosToSoaの逆(SoA→AoS)
+///@remarks 実装はKernelRegistryの"soa2aos"で選ばれる
+void TransposeSoaToAos(const uint32_t* const* columns, size_t count, unsigned int fieldCount, uint32_t* aos);
+
+namespace SoaDetail {
+	template<typename>
+	struct MemberPointerTraits;
+	template<typename C, typename M>
+	struct MemberPointerTraits<M C::*> {
+		using Class = C;
+		using Member = M;
+	};
+}
+
+///構造体Tをフィールドごとの配列で持つバッファ(Structure of Arrays)
+///1つのフィールドしか触らないカーネルは、そのフィールドの配列だけをキャッシュに載せればよくなる
+///@param T 要素の構造体(HLSLのStructuredBufferの要素と同じもの)
+///@param Members 配列にするフィールド(&T::fieldの並び。Tの全フィールドを宣言順に書くこと)
+///@code
+///SoaBuffer<IDs, &IDs::grpId, &IDs::grpThrdId, &IDs::dsptThrdId, &IDs::grpIdx> soa;
+///soa[i][&IDs::dsptThrdId] = 1.0f;//要素.フィールドの形で触れる
+///@endcode
+template<typename T, auto... Members>
+class SoaBuffer
+{
+	static_assert(sizeof...(Members) > 0, "SoaBuffer needs at least one field");
+	static_assert((std::is_same<typename SoaDetail::MemberPointerTraits<decltype(Members)>::Class, T>::value && ...), "Members must be fields of T");
+	static_assert((sizeof(typename SoaDetail::MemberPointerTraits<decltype(Members)>::Member) + ...) == sizeof(T),
+		"Members must cover every field of T (no padding)");
+
+	template<auto Member>
+	using MemberType = typename SoaDetail::MemberPointerTraits<decltype(Member)>::Member;
+
+	std::tuple<std::vector<MemberType<Members>>...> columns_;
+	size_t count_ = 0;
+
+	template<typename A, typename B>
+	static constexpr bool SameMember(A a, B b) {
+		if constexpr (std::is_same<A, B>::value) {
+			return a == b;
+		}
+		else {
+			return false;
+		}
+	}
+	//Memberが何番目のフィールドか(なければフィールド数)
+	template<auto Member>
+	static constexpr size_t IndexOf() {
+		constexpr bool matches[] = { SameMember(Members, Member)... };
+		for (size_t i = 0; i < sizeof...(Members); ++i) {
+			if (matches[i]) {
+				return i;
+			}
+		}
+		return sizeof...(Members);
+	}
+
+	//メンバポインタで列を探す(呼び出し側で定数ならインライン展開で畳まれる)
+	template<typename M, size_t I = 0>
+	M* Find(M T::* member, size_t i) {
+		if constexpr (I == sizeof...(Members)) {
+			assert(!"member is not in this SoaBuffer");
+			return nullptr;
+		}
+		else {
+			constexpr std::tuple<decltype(Members)...> members(Members...);
+			if constexpr (std::is_same<typename std::tuple_element<I, std::tuple<decltype(Members)...>>::type, M T::*>::value) {
+				if (std::get<I>(members) == member) {
+					return &std::get<I>(columns_)[i];
+				}
+			}
+			return Find<M, I + 1>(member, i);
+		}
+	}
+
+	//全フィールドが4バイトで宣言順に隙間なく並んでいれば、SIMDの並べ替えが使える
+	static bool IsPacked4() {
+		static const bool packed = [] {
+			if (!((sizeof(MemberType<Members>) == 4) && ...) || sizeof(T) != 4 * sizeof...(Members)) {
+				return false;
+			}
+			const T probe = {};
+			ptrdiff_t expected = 0;
+			bool inOrder = true;
+			((inOrder = inOrder && reinterpret_cast<const char*>(&(probe.*Members)) - reinterpret_cast<const char*>(&probe) == expected, expected += 4), ...);
+			return inOrder;
+		}();
+		return packed;
+	}
+	template<size_t... I>
+	void ColumnPointers(uint32_t** columns, std::index_sequence<I...>) {
+		((columns[I] = reinterpret_cast<uint32_t*>(std::get<I>(columns_).data())), ...);
+	}
+public:
+	using value_type = T;
+	static constexpr unsigned int fieldCount = sizeof...(Members);
+
+	///1要素への参照
+	class Element {
+		SoaBuffer& buffer_;
+		size_t index_;
+	public:
+		Element(SoaBuffer& buffer, size_t index) :buffer_(buffer), index_(index) {}
+		///フィールドへの参照(AoSのelement.fieldと同じ感覚で使う)
+		template<typename M>
+		M& operator[](M T::* member)const {
+			return *buffer_.Find(member, index_);
+		}
+		///全フィールドを集めた構造体
+		T Load()const {
+			T value;
+			((value.*Members = buffer_.template Column<Members>()[index_]), ...);
+			return value;
+		}
+		///全フィールドを書き込む
+		void Store(const T& value)const {
+			((buffer_.template Column<Members>()[index_] = value.*Members), ...);
+		}
+	};
+
+	///要素数を変える(容量が足りるときは確保し直さない)
+	void Resize(size_t count) {
+		std::apply([count](auto&... column) {(column.resize(count), ...); }, columns_);
+		count_ = count;
+	}
+	size_t Count()const {
+		return count_;
+	}
+
+	///フィールドMemberの配列
+	template<auto Member>
+	MemberType<Member>* Column() {
+		constexpr auto index = IndexOf<Member>();
+		static_assert(index < sizeof...(Members), "Member is not in this SoaBuffer");
+		return std::get<index>(columns_).data();
+	}
+	template<auto Member>
+	const MemberType<Member>* Column()const {
+		constexpr auto index = IndexOf<Member>();
+		static_assert(index < sizeof...(Members), "Member is not in this SoaBuffer");
+		return std::get<index>(columns_).data();
+	}
+
+	Element operator[](size_t i) {
+		assert(i < count_);
+		return Element(*this, i);
+	}
+
+	///AoSの配列から読み込む(Count()個)
+	void FromAos(const T* aos) {
+		if (IsPacked4()) {
+			uint32_t* columns[fieldCount];
+			ColumnPointers(columns, std::make_index_sequence<fieldCount>());
+			TransposeAosToSoa(reinterpret_cast<const uint32_t*>(aos), count_, fieldCount, columns);
+			return;
+		}
+		for (size_t i = 0; i < count_; ++i) {
+			(*this)[i].Store(aos[i]);
+		}
+	}
+	///AoSの配列に書き出す(Count()個)
+	void ToAos(T* aos) {
+		if (IsPacked4()) {
+			uint32_t* columns[fieldCount];
+			ColumnPointers(columns, std::make_index_sequence<fieldCount>());
+			TransposeSoaToAos(columns, count_, fieldCount, reinterpret_cast<uint32_t*>(aos));
+			return;
+		}
+		for (size_t i = 0; i < count_; ++i) {
+			aos[i] = (*this)[i].Load();
+		}
+	}
+};
+
+///入出力をSoAで持つCpuComputeJob
+///Input()/Output()はAoSのままで、Runの前後(GPUでいうアップロードとリードバック)でSoAと並べ替える。
+///カーネルはkernel(const ComputeThreadId&, InSoa&, OutSoa&)の形で呼ばれ、soa[i][&T::field]で触る
+///@param InSoa 入力のSoaBuffer
+///@param OutSoa 出力のSoaBuffer
+///@remarks 並べ替えも省きたいときはInputSoa()/OutputSoa()を直接読み書きし、RunSoaを使う
+template<typename InSoa, typename OutSoa, typename Kernel>
+class CpuSoaComputeJob : public ComputeJob<typename InSoa::value_type, typename OutSoa::value_type>
+{
+	using In = typename InSoa::value_type;
+	using Out = typename OutSoa::value_type;
+	ComputeExecutor& executor_;
+	hlsl::uint3 numThreads_;
+	Kernel kernel_;
+	std::vector<In> input_;//AoSの入力(アップロード元)
+	std::vector<Out> output_;//AoSの出力(リードバック先)
+	InSoa inputSoa_;
+	OutSoa outputSoa_;
+public:
+	CpuSoaComputeJob(ComputeExecutor& executor, const hlsl::uint3& numThreads, Kernel kernel) :
+		executor_(executor), numThreads_(numThreads), kernel_(kernel) {}
+
+	void Resize(size_t inCount, size_t outCount)override {
+		input_.resize(inCount);
+		output_.resize(outCount);
+		inputSoa_.Resize(inCount);
+		outputSoa_.Resize(outCount);
+	}
+	In* Input()override {
+		return input_.data();
+	}
+	size_t InputCount()const override {
+		return inputSoa_.Count();
+	}
+	void Run(unsigned int x, unsigned int y, unsigned int z)override {
+		inputSoa_.FromAos(input_.data());
+		RunSoa(x, y, z);
+		outputSoa_.ToAos(output_.data());
+	}
+	const Out* Output()const override {
+		return output_.data();
+	}
+	size_t OutputCount()const override {
+		return outputSoa_.Count();
+	}
+
+	///SoAのまま実行する(Input()/Output()とは並べ替えない)
+	void RunSoa(unsigned int x, unsigned int y, unsigned int z) {
+		executor_.Dispatch(numThreads_, x, y, z, [&](const ComputeThreadId& id) {
+			kernel_(id, inputSoa_, outputSoa_);
+		});
+	}
+	InSoa& InputSoa() {
+		return inputSoa_;
+	}
+	OutSoa& OutputSoa() {
+		return outputSoa_;
+	}
+};
+
+///CpuSoaComputeJobを作る(カーネルの型を推論させるため)
+template<typename InSoa, typename OutSoa, typename Kernel>
+std::unique_ptr<CpuSoaComputeJob<InSoa, OutSoa, Kernel>> MakeCpuSoaComputeJob(ComputeExecutor& executor, const hlsl::uint3& numThreads, Kernel kernel) {
+	return std::unique_ptr<CpuSoaComputeJob<InSoa, OutSoa, Kernel>>(new CpuSoaComputeJob<InSoa, OutSoa, Kernel>(executor, numThreads, kernel));
+}
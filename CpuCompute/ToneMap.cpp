@@ -0,0 +1,137 @@
+﻿#include "ToneMap.h"
+#include<algorithm>
+#include<cassert>
+#include<cmath>
+#include<vector>
+#include"ComputeExecutor.h"
+
+//シェーダと同じ露出・トーンカーブ
+namespace hlsl {
+	namespace {
+#include"ToneMap.hlsli"
+	}
+}
+
+using namespace std;
+using hlsl::float4;
+
+namespace {
+	//トーンマップを並列化するときの1回に取る行数
+	constexpr size_t toneMapGrainRows = 8;
+
+	//BT.601の輝度(LumaReduction.hlsliのLuminanceをdoubleで。基準実装用)
+	double LuminanceReference(const float4& c) {
+		return 0.299 * c.x + 0.587 * c.y + 0.114 * c.z;
+	}
+
+	void ToneMapRows(const ImageRGBA32F& src, ImageRGBA32F& dst, float exposure, const ToneMapCurve& curve, size_t y0, size_t y1) {
+		for (auto y = y0; y < y1; ++y) {
+			const float4* in = src.Row(static_cast<unsigned int>(y));
+			float4* out = dst.Row(static_cast<unsigned int>(y));
+			for (unsigned int x = 0; x < src.width; ++x) {
+				const float4 c = in[x];
+				out[x] = float4(curve(c.x * exposure), curve(c.y * exposure), curve(c.z * exposure), c.w);
+			}
+		}
+	}
+
+	void PrepareOutput(const ImageRGBA32F& src, ImageRGBA32F& dst) {
+		if (&dst != &src) {
+			dst.width = src.width;
+			dst.height = src.height;
+			dst.pixels.resize(src.pixels.size());
+		}
+	}
+}
+
+float
+ExposureTargetLog2(const LumaHistogram& histogram, const ToneMapSettings& settings) {
+	assert(settings.maxLog2 > settings.minLog2 && settings.lowPercent <= settings.highPercent);
+	const float total = static_cast<float>(histogram.Total());
+	const float lo = total * settings.lowPercent;
+	const float hi = total * settings.highPercent;
+	const float binWidth = (settings.maxLog2 - settings.minLog2) / 256.0f;
+	hlsl::ExposureAccumulator acc = {};
+	for (int bin = 0; bin < 256; ++bin) {
+		acc = hlsl::AccumulateExposureBin(acc, static_cast<float>(histogram.bins[bin]), settings.minLog2 + (bin + 0.5f) * binWidth, lo, hi);
+	}
+	return acc.weight > 0.0f ? acc.weightedLog2 / acc.weight : (settings.minLog2 + settings.maxLog2) * 0.5f;
+}
+
+double
+ExposureTargetLog2Reference(const ImageRGBA32F& src, const ToneMapSettings& settings) {
+	vector<double> values(src.pixels.size());
+	for (size_t i = 0; i < values.size(); ++i) {
+		const double luma = LuminanceReference(src.pixels[i]);
+		//ヒストグラムと同じく範囲外は両端に寄せる
+		values[i] = luma > 0.0 ? clamp(log2(luma), static_cast<double>(settings.minLog2), static_cast<double>(settings.maxLog2)) : settings.minLog2;
+	}
+	sort(values.begin(), values.end());
+	const double lo = values.size() * static_cast<double>(settings.lowPercent);
+	const double hi = values.size() * static_cast<double>(settings.highPercent);
+	double weight = 0.0, weighted = 0.0;
+	for (size_t i = 0; i < values.size(); ++i) {
+		const double taken = clamp(i + 1.0, lo, hi) - clamp(static_cast<double>(i), lo, hi);
+		weight += taken;
+		weighted += taken * values[i];
+	}
+	return weight > 0.0 ? weighted / weight : (settings.minLog2 + settings.maxLog2) * 0.5;
+}
+
+ToneMapCurve::ToneMapCurve(float whitePoint) :whitePoint_(whitePoint) {
+	assert(whitePoint > minValue);
+	uint32_t whiteBits;
+	memcpy(&whiteBits, &whitePoint, sizeof(whiteBits));
+	//whitePointを含む区間の右端まで
+	table_.resize(((whiteBits - minBits) >> fractionBits) + 2);
+	const float scale = 1.0f / hlsl::FilmicCurve(whitePoint);
+	for (size_t i = 0; i < table_.size(); ++i) {
+		//whitePointより明るいところはsaturateで1になる
+		table_[i] = hlsl::LinearToSrgb(hlsl::FilmicCurve(hlsl::asfloat(minBits + (static_cast<uint32_t>(i) << fractionBits))) * scale);
+	}
+}
+
+void
+ToneMap(const ImageRGBA32F& src, ImageRGBA32F& dst, float exposure, const ToneMapCurve& curve, ComputeExecutor* executor) {
+	PrepareOutput(src, dst);
+	if (executor != nullptr) {
+		executor->ParallelFor(src.height, toneMapGrainRows, [&](size_t begin, size_t end) {
+			ToneMapRows(src, dst, exposure, curve, begin, end);
+		});
+	}
+	else {
+		ToneMapRows(src, dst, exposure, curve, 0, src.height);
+	}
+}
+
+void
+ToneMapReference(const ImageRGBA32F& src, ImageRGBA32F& dst, float exposure, float whitePoint) {
+	PrepareOutput(src, dst);
+	for (size_t i = 0; i < src.pixels.size(); ++i) {
+		dst.pixels[i] = hlsl::ToneMapPixel(src.pixels[i], exposure, whitePoint);
+	}
+}
+
+void
+AutoExposure::Apply(const ImageRGBA32F& src, ImageRGBA32F& dst, const ToneMapSettings& settings, ComputeExecutor* executor) {
+	Measure(src, settings, executor);
+	if (curve_.WhitePoint() != settings.whitePoint) {
+		curve_ = ToneMapCurve(settings.whitePoint);
+	}
+	ToneMap(src, dst, Adapt(settings), curve_, executor);
+}
+
+void
+AutoExposure::Measure(const ImageRGBA32F& src, const ToneMapSettings& settings, ComputeExecutor* executor) {
+	LumaStats stats;
+	ReduceLuma(src, ToneMapHistogramRange(settings), stats, &histogram_, executor);
+}
+
+float
+AutoExposure::Adapt(const ToneMapSettings& settings) {
+	const float target = ExposureTargetLog2(histogram_, settings);
+	adaptedLog2_ = adapted_ ? hlsl::AdaptExposureLog2(adaptedLog2_, target, settings.adaptUp, settings.adaptDown) : target;
+	adapted_ = true;
+	exposure_ = hlsl::ExposureFromLog2(adaptedLog2_, settings.exposureBias);
+	return exposure_;
+}
@@ -0,0 +1,119 @@
+﻿#pragma once
+#include<cstdint>
+#include<cstring>
+#include<vector>
+#include"Image.h"
+#include"Reduction.h"
+
+class ComputeExecutor;
+
+//HDR(float)の画像の自動露出とトーンマップ
+//RenderTargetFilter/ToneMapCS.hlsl(とReductionCS.hlslのLumaHistogramCS)のCPU版。1階級分・1画素分の計算はToneMap.hlsliをシェーダと共有する
+//  ヒストグラム : log2(輝度)の256階級(ReduceLumaをMakeLogLumaHistogramRangeで)
+//  露出 : 暗い方と明るい方を除いた画素のlog2(輝度)の平均を目標にし、前のフレームの値から少しずつ近づける
+//         (GPUでは結果を小さなバッファに残して次のフレームで読むので、CPUへの読み戻しで待たない)
+//  トーンマップ : 露出を掛けてフィルミックなカーブを通し、sRGBにする
+//                 (CPU版は成分ごとのpowを避けるため、カーブを表にして引く。ToneMapCurve)
+
+///自動露出とトーンマップの設定
+struct ToneMapSettings {
+	float minLog2 = -10.0f;//ヒストグラムの範囲(log2(輝度))。範囲外は両端の階級に入る
+	float maxLog2 = 6.0f;
+	float lowPercent = 0.5f;//暗い方からこの割合の画素は平均に入れない
+	float highPercent = 0.95f;//暗い方からこの割合より明るい画素は平均に入れない
+	float exposureBias = 0.0f;//露出補正(EV)
+	float adaptUp = 0.05f;//明るくなったときに1フレームで縮める差の割合(60fpsで0.05なら約0.75秒で9割)
+	float adaptDown = 0.02f;//暗くなったときに1フレームで縮める差の割合
+	float whitePoint = 11.2f;//露出を掛けた後でこの値が白(1)になる
+};
+
+///設定のヒストグラムの階級
+inline LumaHistogramRange ToneMapHistogramRange(const ToneMapSettings& settings) {
+	return MakeLogLumaHistogramRange(settings.minLog2, settings.maxLog2);
+}
+
+///ヒストグラムから露出の目標(平均の明るさのlog2)を求める(ToneMapCS.hlslのExposureCSと同じ)
+///@param histogram ToneMapHistogramRangeの階級のヒストグラム
+///@return 平均に入る画素がなければ範囲の真ん中
+float ExposureTargetLog2(const LumaHistogram& histogram, const ToneMapSettings& settings);
+
+///ExposureTargetLog2の基準実装(画素ごとに正しいlog2(輝度)を求めて並べ替え、暗い方と明るい方を除いて平均する)
+///ヒストグラムの階級の幅とApproxLog2の近似のぶん、ExposureTargetLog2とは差が出る
+double ExposureTargetLog2Reference(const ImageRGBA32F& src, const ToneMapSettings& settings);
+
+///トーンカーブ(露出を掛けた後の値→FilmicCurve→sRGB)の表
+///floatのビット列の上位(指数と仮数の上位7bit)で引き、下位で線形補間する(1オクターブを128区間に分ける)。
+///区間の中ではビット列と値が比例するので、補間は値についての線形補間になる
+class ToneMapCurve {
+public:
+	///@param whitePoint これ以上は1になる
+	explicit ToneMapCurve(float whitePoint);
+
+	float WhitePoint()const { return whitePoint_; }
+	///露出を掛けた後の値をsRGBの値にする(0以下とNaNは0)
+	float operator()(float y)const {
+		if (!(y >= minValue)) {
+			//表より暗いところはカーブがほぼ直線なので、最初の値から比例で求める
+			return y > 0.0f ? table_[0] * (y * (1.0f / minValue)) : 0.0f;
+		}
+		if (y >= whitePoint_) {
+			return table_.back();
+		}
+		uint32_t bits;
+		std::memcpy(&bits, &y, sizeof(bits));
+		const uint32_t offset = bits - minBits;
+		const uint32_t index = offset >> fractionBits;
+		const float t = static_cast<float>(offset & ((1u << fractionBits) - 1)) * (1.0f / (1u << fractionBits));
+		return table_[index] + (table_[index + 1] - table_[index]) * t;
+	}
+
+private:
+	static constexpr float minValue = 1.0f / 65536.0f;//表の最初(2^-16)
+	static constexpr uint32_t minBits = 0x37800000;//minValueのビット列
+	static constexpr uint32_t fractionBits = 16;//補間に使う下位のビット数(仮数23bit-7bit)
+	float whitePoint_;
+	std::vector<float> table_;//最後はwhitePoint以上の値
+};
+
+///露出を掛けてトーンマップする(出力はsRGBの0～1。アルファはそのまま)
+///@param dst 出力画像(srcと同じ大きさにされる。srcと同じでもよい)
+///@param exposure 画素に掛ける倍率
+///@param curve トーンカーブ
+///@param executor nullptrなら呼び出しスレッドだけで処理する
+///@remarks カーブを表で引くので、ToneMapReferenceとは1e-5程度の差が出る
+void ToneMap(const ImageRGBA32F& src, ImageRGBA32F& dst, float exposure, const ToneMapCurve& curve, ComputeExecutor* executor);
+
+///ToneMapの基準実装(1画素ずつ、シェーダと同じ式で求める)
+void ToneMapReference(const ImageRGBA32F& src, ImageRGBA32F& dst, float exposure, float whitePoint);
+
+///自動露出(フレームをまたいでなじませた明るさを持つ)とトーンマップ
+class AutoExposure {
+public:
+	///1フレーム分の処理(Measure→Adapt→ToneMap)
+	///@param dst 出力画像(srcと同じ大きさにされる。srcと同じでもよい)
+	///@param executor nullptrなら呼び出しスレッドだけで処理する
+	void Apply(const ImageRGBA32F& src, ImageRGBA32F& dst, const ToneMapSettings& settings, ComputeExecutor* executor);
+
+	//ここから段ごとの処理(時間を段ごとに測るため)
+	///ヒストグラムを取る
+	void Measure(const ImageRGBA32F& src, const ToneMapSettings& settings, ComputeExecutor* executor);
+	///ヒストグラムの目標に1フレーム分近づけて、露出を決める(最初のフレームは目標そのもの)
+	///@return 露出
+	float Adapt(const ToneMapSettings& settings);
+
+	///なじませた明るさを捨てる(次のAdaptは目標そのものになる)
+	void Reset() { adapted_ = false; }
+
+	const LumaHistogram& Histogram()const { return histogram_; }
+	///なじませた平均の明るさ(log2)
+	float AdaptedLog2()const { return adaptedLog2_; }
+	///画素に掛ける倍率
+	float Exposure()const { return exposure_; }
+
+private:
+	LumaHistogram histogram_;
+	ToneMapCurve curve_ = ToneMapCurve(ToneMapSettings().whitePoint);//設定の白の点が変わったら作り直す
+	float adaptedLog2_ = 0.0f;
+	float exposure_ = 1.0f;
+	bool adapted_ = false;
+};
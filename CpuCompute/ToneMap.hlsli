@@ -0,0 +1,70 @@
+//Ioƃg[}bv1fE1ǨvZ
+//RenderTargetFilter/ToneMapCS.hlslCPU(CpuCompute/ToneMap.cpp)ŋLĂ܂(MonoPixel.hlsliƓ)B
+//qXgOLumaReduction.hlsliApproxLog2(Px)Ŏ(K0255͔͈͊O܂)
+
+//Io1̂Ƃɂ̖邳(log2)ɂȂ悤ɂ(18%O[)
+#define EXPOSURE_MIDDLE_GRAY 0.18
+
+//qXgO畽ς̖邳(log2)߂r̒l
+struct ExposureAccumulator
+{
+    float below;//܂łɌ(Â)K̉f
+    float weight;//ςɉf
+    float weightedLog2;//ςɉflog2(Px)̍v
+};
+
+//qXgO1KAÂ琔[lo,hi)Ԗڂɓfςɉ(K0珇ɌĂ)
+//binLog2 : K̐^񒆂log2(Px)
+ExposureAccumulator AccumulateExposureBin(ExposureAccumulator a, float count, float binLog2, float lo, float hi)
+{
+    float taken = clamp(a.below + count, lo, hi) - clamp(a.below, lo, hi);
+    a.below += count;
+    a.weight += taken;
+    a.weightedLog2 += taken * binLog2;
+    return a;
+}
+
+//ς̖邳(log2)Õt[̒lڕWɋ߂Â(1t[)
+//rateUp : 邭ȂƂArateDown : ÂȂƂ1t[ŏk߂鍷̊(0`1)
+float AdaptExposureLog2(float previous, float target, float rateUp, float rateDown)
+{
+    float rate = target > previous ? rateUp : rateDown;
+    return previous + (target - previous) * rate;
+}
+
+//ς̖邳(log2)Io(fɊ|{)߂
+//bias : Io␳(EV)
+float ExposureFromLog2(float averageLog2, float bias)
+{
+    return EXPOSURE_MIDDLE_GRAY * exp2(bias - averageLog2);
+}
+
+//tB~bNȃg[J[u(John HableUncharted 2̎)
+float FilmicCurve(float x)
+{
+    const float A = 0.15;//̋
+    const float B = 0.50;//̋
+    const float C = 0.10;//̊px
+    const float D = 0.20;//̋
+    const float E = 0.02;//̕q
+    const float F = 0.30;//̕
+    return (x * (A * x + C * B) + D * E) / (x * (A * x + B) + D * F) - E / F;
+}
+
+//jA̒l8bitɏOsRGB̒lɂ(Œpow(1/2.2)ł͂ȂsRGB̎)
+float LinearToSrgb(float c)
+{
+    c = saturate(c);
+    return c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+}
+
+//Io|ăg[J[uʂAsRGBɂ(At@͂̂܂)
+//whitePoint : Io|ł̒l1ɂȂ
+float4 ToneMapPixel(float4 c, float exposure, float whitePoint)
+{
+    float scale = 1.0 / FilmicCurve(whitePoint);
+    return float4(LinearToSrgb(FilmicCurve(max(c.r * exposure, 0.0)) * scale),
+        LinearToSrgb(FilmicCurve(max(c.g * exposure, 0.0)) * scale),
+        LinearToSrgb(FilmicCurve(max(c.b * exposure, 0.0)) * scale),
+        c.a);
+}
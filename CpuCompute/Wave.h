@@ -0,0 +1,653 @@
+﻿#pragma once
+//SPMD-on-SIMD実行(ISPC方式)のための型とウェーブ組み込み関数
+//1ウェーブ=SIMDレジスタ1本分とみなし、ウェーブ内のスレッドをレーンに割り当てる。
+//分岐はマスク付き実行で表現する(if (dtid.x < w && dtid.y < h) → mask &= ...)
+#include<cstddef>
+#include<cstring>
+#include<vector>
+#include<algorithm>
+#include<limits>
+#include<utility>
+#include"ComputeExecutor.h"
+#ifdef _MSC_VER
+#include<intrin.h>
+#endif
+
+//コンパイル時のターゲットに合わせたウェーブ幅(32bitレーン数)
+//配布するバイナリでは既定のターゲット(SSE)の4になるので、CPUに合わせた幅で動かすときは
+//WaveGroupsFuncを命令セット別にKernelRegistryへ登録する(DispatchWaveGroups参照)
+#if defined(__AVX512F__)
+constexpr int NativeWaveWidth = 16;
+#elif defined(__AVX2__) || defined(__AVX__)
+constexpr int NativeWaveWidth = 8;
+#else
+//SSE/NEON
+constexpr int NativeWaveWidth = 4;
+#endif
+
+//レーン数ぶんのループを展開させる指示
+//(展開されないとレーンごとのスカラーストア→SIMDロードでストアフォワーディングが効かず遅くなる)
+#if defined(__clang__)
+#define WAVE_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define WAVE_UNROLL _Pragma("GCC unroll 16")
+#else
+#define WAVE_UNROLL
+#endif
+
+//ウェーブ組み込み関数は必ず呼び出し元に展開させる
+//(CPU_TARGET_AVX2などの関数から呼んだとき、その命令セットでベクトル化されるようにするため)
+#if defined(_MSC_VER)
+#define WAVE_INLINE __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define WAVE_INLINE inline __attribute__((always_inline))
+#else
+#define WAVE_INLINE inline
+#endif
+
+//GCC/clangではレーンの並びをベクトル拡張の型で持ち、演算を全レーンまとめて書く
+//(レーンごとのループは展開後にSLPベクトル化されず、スカラー命令の列になることが多いため)
+//MSVCはレーンごとのループのまま
+#if defined(__GNUC__) || defined(__clang__)
+#define WAVE_VECTOR_EXTENSION 1
+#endif
+
+namespace hlsl {
+	namespace WaveDetail {
+		///TをW個並べた型(添字でレーンを読み書きできる)
+#ifdef WAVE_VECTOR_EXTENSION
+		//アラインメントも明示する(AVXが無効なところで型が作られると16バイトにされ、AVX-512の関数でのアラインされたロードで落ちる)
+		template<typename T, int W>
+		struct Lanes {
+			typedef T type __attribute__((vector_size(sizeof(T) * W), aligned(sizeof(T) * W)));
+		};
+
+		enum class LaneOp { And, Or, Add };
+		///全レーンをopでまとめる(半分ずつ重ねていくので、要素の取り出しは最後の1回だけ)
+		template<LaneOp op, typename T, int W>
+		WAVE_INLINE T ReduceLanes(const typename Lanes<T, W>::type& v) {
+			if constexpr (W == 1) {
+				return v[0];
+			} else {
+				typename Lanes<T, W / 2>::type lo, hi;
+				memcpy(&lo, &v, sizeof(lo));
+				memcpy(&hi, reinterpret_cast<const char*>(&v) + sizeof(lo), sizeof(hi));
+				if constexpr (op == LaneOp::And) {
+					return ReduceLanes<op, T, W / 2>(lo & hi);
+				} else if constexpr (op == LaneOp::Or) {
+					return ReduceLanes<op, T, W / 2>(lo | hi);
+				} else {
+					return ReduceLanes<op, T, W / 2>(lo + hi);
+				}
+			}
+		}
+#else
+		template<typename T, int W>
+		struct Lanes {
+			struct alignas(W * sizeof(T)) type {
+				T v[W];
+				T& operator[](int i) { return v[i]; }
+				const T& operator[](int i)const { return v[i]; }
+			};
+		};
+#endif
+
+		///rのレーンiをf(i)にする
+		///@remarks ベクトル拡張の要素を1つずつ書くとレーンごとの挿入命令になるので、
+		///いったん配列に並べてからまとめて読む
+		template<typename T, int W, typename F>
+		WAVE_INLINE void SetLanes(typename Lanes<T, W>::type& r, F&& f) {
+			T values[W];
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				values[i] = f(i);
+			}
+			memcpy(&r, values, sizeof(r));
+		}
+
+		///0,1,2,...(WaveGetLaneIndex用)
+		alignas(64) constexpr unsigned int laneIndices[16] = { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 };
+	}
+
+	///ウェーブ内のレーンごとのマスク(有効レーンは全ビット1)
+	///@remarks レーン単位のループがそのままSIMDの比較/ブレンドになるよう32bit整数で持つ
+	template<int W>
+	struct LaneMask {
+		typename WaveDetail::Lanes<unsigned int, W>::type bits;
+
+		///先頭n個のレーンだけ有効なマスク
+		WAVE_INLINE static LaneMask FirstN(unsigned int n) {
+			LaneMask ret;
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				ret.bits[i] = static_cast<unsigned int>(i) < n ? ~0u : 0u;
+			}
+			return ret;
+		}
+		WAVE_INLINE static LaneMask All() { return FirstN(W); }
+
+		WAVE_INLINE bool operator[](int lane)const { return bits[lane] != 0; }
+		WAVE_INLINE bool Any()const {
+#ifdef WAVE_VECTOR_EXTENSION
+			return WaveDetail::ReduceLanes<WaveDetail::LaneOp::Or, unsigned int, W>(bits) != 0;
+#else
+			unsigned int r = 0;
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				r |= bits[i];
+			}
+			return r != 0;
+#endif
+		}
+		WAVE_INLINE bool None()const { return !Any(); }
+		WAVE_INLINE bool AllSet()const {
+#ifdef WAVE_VECTOR_EXTENSION
+			return WaveDetail::ReduceLanes<WaveDetail::LaneOp::And, unsigned int, W>(bits) != 0;
+#else
+			unsigned int r = ~0u;
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				r &= bits[i];
+			}
+			return r != 0;
+#endif
+		}
+		///有効レーン数
+		WAVE_INLINE unsigned int CountBits()const {
+#ifdef WAVE_VECTOR_EXTENSION
+			return WaveDetail::ReduceLanes<WaveDetail::LaneOp::Add, unsigned int, W>(bits & 1u);
+#else
+			unsigned int r = 0;
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				r += bits[i] & 1;
+			}
+			return r;
+#endif
+		}
+	};
+
+	template<int W>
+	WAVE_INLINE LaneMask<W> operator&(const LaneMask<W>& a, const LaneMask<W>& b) {
+		LaneMask<W> r;
+#ifdef WAVE_VECTOR_EXTENSION
+		r.bits = a.bits & b.bits;
+#else
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			r.bits[i] = a.bits[i] & b.bits[i];
+		}
+#endif
+		return r;
+	}
+	template<int W>
+	WAVE_INLINE LaneMask<W> operator|(const LaneMask<W>& a, const LaneMask<W>& b) {
+		LaneMask<W> r;
+#ifdef WAVE_VECTOR_EXTENSION
+		r.bits = a.bits | b.bits;
+#else
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			r.bits[i] = a.bits[i] | b.bits[i];
+		}
+#endif
+		return r;
+	}
+	template<int W>
+	WAVE_INLINE LaneMask<W> operator~(const LaneMask<W>& a) {
+		LaneMask<W> r;
+#ifdef WAVE_VECTOR_EXTENSION
+		r.bits = ~a.bits;
+#else
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			r.bits[i] = ~a.bits[i];
+		}
+#endif
+		return r;
+	}
+	template<int W>
+	WAVE_INLINE LaneMask<W>& operator&=(LaneMask<W>& a, const LaneMask<W>& b) { return a = a & b; }
+	template<int W>
+	WAVE_INLINE LaneMask<W>& operator|=(LaneMask<W>& a, const LaneMask<W>& b) { return a = a | b; }
+
+	///レーンごとに値を持つ変数(ISPCのvarying)
+	template<typename T, int W>
+	struct Varying {
+		typename WaveDetail::Lanes<T, W>::type v;
+
+		Varying() = default;
+		///全レーンに同じ値を入れる(uniform→varying)
+		WAVE_INLINE Varying(T s) {
+#ifdef WAVE_VECTOR_EXTENSION
+			//スカラーからの変換(s - type{}など)は命令セット指定のない関数の中で
+			//レーンごとの挿入に分解されてしまうので、配列経由でブロードキャストさせる
+			WaveDetail::SetLanes<T, W>(v, [s](int) { return s; });
+#else
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				v[i] = s;
+			}
+#endif
+		}
+		WAVE_INLINE T& operator[](int lane) { return v[lane]; }
+		WAVE_INLINE const T& operator[](int lane)const { return v[lane]; }
+
+		///型変換(uint→floatなど)
+		template<typename U>
+		WAVE_INLINE Varying<U, W> Cast()const {
+			Varying<U, W> r;
+#ifdef WAVE_VECTOR_EXTENSION
+			r.v = __builtin_convertvector(v, typename WaveDetail::Lanes<U, W>::type);
+#else
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				r.v[i] = static_cast<U>(v[i]);
+			}
+#endif
+			return r;
+		}
+	};
+
+	//vectorExprを全レーンまとめて計算する(ベクトル拡張がなければlaneExprをレーンiごとに)
+#ifdef WAVE_VECTOR_EXTENSION
+#define WAVE_LANEWISE(vectorExpr, laneExpr) vectorExpr;
+#else
+#define WAVE_LANEWISE(vectorExpr, laneExpr) WAVE_UNROLL for (int i = 0; i < W; ++i) { laneExpr; }
+#endif
+
+	//スカラーとの演算で型推論が衝突しないようにするためのもの
+	template<typename T>
+	struct NonDeduced { using type = T; };
+
+#define HLSL_VARYING_BINARY_OP(op) \
+	template<typename T, int W> \
+	WAVE_INLINE Varying<T, W> operator op(const Varying<T, W>& a, const Varying<T, W>& b) { \
+		Varying<T, W> r; \
+		WAVE_LANEWISE(r.v = a.v op b.v, r.v[i] = a.v[i] op b.v[i]) \
+		return r; \
+	} \
+	template<typename T, int W> \
+	WAVE_INLINE Varying<T, W> operator op(const Varying<T, W>& a, typename NonDeduced<T>::type b) { return a op Varying<T, W>(b); } \
+	template<typename T, int W> \
+	WAVE_INLINE Varying<T, W> operator op(typename NonDeduced<T>::type a, const Varying<T, W>& b) { return Varying<T, W>(a) op b; } \
+	template<typename T, int W> \
+	WAVE_INLINE Varying<T, W>& operator op##=(Varying<T, W>& a, const Varying<T, W>& b) { return a = a op b; }
+
+	HLSL_VARYING_BINARY_OP(+)
+	HLSL_VARYING_BINARY_OP(-)
+	HLSL_VARYING_BINARY_OP(*)
+	HLSL_VARYING_BINARY_OP(/)
+	HLSL_VARYING_BINARY_OP(&)
+	HLSL_VARYING_BINARY_OP(|)
+	HLSL_VARYING_BINARY_OP(^)
+	HLSL_VARYING_BINARY_OP(<<)
+	HLSL_VARYING_BINARY_OP(>>)
+#undef HLSL_VARYING_BINARY_OP
+
+#define HLSL_VARYING_COMPARE_OP(op) \
+	template<typename T, int W> \
+	WAVE_INLINE LaneMask<W> operator op(const Varying<T, W>& a, const Varying<T, W>& b) { \
+		LaneMask<W> r; \
+		WAVE_LANEWISE(r.bits = (decltype(r.bits))(a.v op b.v), r.bits[i] = a.v[i] op b.v[i] ? ~0u : 0u) \
+		return r; \
+	} \
+	template<typename T, int W> \
+	WAVE_INLINE LaneMask<W> operator op(const Varying<T, W>& a, typename NonDeduced<T>::type b) { return a op Varying<T, W>(b); } \
+	template<typename T, int W> \
+	WAVE_INLINE LaneMask<W> operator op(typename NonDeduced<T>::type a, const Varying<T, W>& b) { return Varying<T, W>(a) op b; }
+
+	HLSL_VARYING_COMPARE_OP(<)
+	HLSL_VARYING_COMPARE_OP(<=)
+	HLSL_VARYING_COMPARE_OP(>)
+	HLSL_VARYING_COMPARE_OP(>=)
+	HLSL_VARYING_COMPARE_OP(==)
+	HLSL_VARYING_COMPARE_OP(!=)
+#undef HLSL_VARYING_COMPARE_OP
+
+	///mask ? a : b
+	template<typename T, int W>
+	WAVE_INLINE Varying<T, W> Select(const LaneMask<W>& mask, const Varying<T, W>& a, const Varying<T, W>& b) {
+		Varying<T, W> r;
+#ifdef WAVE_VECTOR_EXTENSION
+		if constexpr (sizeof(T) == sizeof(unsigned int)) {
+			r.v = mask.bits != 0 ? a.v : b.v;
+			return r;
+		}
+#endif
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			r.v[i] = mask.bits[i] ? a.v[i] : b.v[i];
+		}
+		return r;
+	}
+	template<typename T, int W>
+	WAVE_INLINE Varying<T, W> min(const Varying<T, W>& a, const Varying<T, W>& b) {
+		Varying<T, W> r;
+		WAVE_LANEWISE(r.v = a.v < b.v ? a.v : b.v, r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+		return r;
+	}
+	template<typename T, int W>
+	WAVE_INLINE Varying<T, W> max(const Varying<T, W>& a, const Varying<T, W>& b) {
+		Varying<T, W> r;
+		WAVE_LANEWISE(r.v = a.v > b.v ? a.v : b.v, r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+		return r;
+	}
+	template<int W>
+	WAVE_INLINE Varying<float, W> saturate(const Varying<float, W>& a) {
+		return min(max(a, Varying<float, W>(0.0f)), Varying<float, W>(1.0f));
+	}
+
+	//ここからウェーブ組み込み関数
+	//HLSLでは有効レーンは暗黙だが、ここでは第1引数にマスクを明示的に渡す
+
+	///WaveGetLaneIndex
+	template<int W>
+	WAVE_INLINE Varying<unsigned int, W> WaveGetLaneIndex() {
+		static_assert(W <= 16, "WaveGetLaneIndex supports up to 16 lanes");
+		Varying<unsigned int, W> r;
+		memcpy(&r.v, WaveDetail::laneIndices, sizeof(r.v));
+		return r;
+	}
+
+	///WaveActiveCountBits
+	template<int W>
+	WAVE_INLINE unsigned int WaveActiveCountBits(const LaneMask<W>& mask, const LaneMask<W>& cond) {
+		return (mask & cond).CountBits();
+	}
+
+	///WaveActiveSum
+	template<typename T, int W>
+	WAVE_INLINE T WaveActiveSum(const LaneMask<W>& mask, const Varying<T, W>& a) {
+#ifdef WAVE_VECTOR_EXTENSION
+		if constexpr (sizeof(T) == sizeof(unsigned int)) {
+			return WaveDetail::ReduceLanes<WaveDetail::LaneOp::Add, T, W>(Select(mask, a, Varying<T, W>(T())).v);
+		}
+#endif
+		T r = T();
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			r += mask.bits[i] ? a.v[i] : T();
+		}
+		return r;
+	}
+
+	///WaveActiveMax(有効レーンがない場合はT型の最小値)
+	template<typename T, int W>
+	WAVE_INLINE T WaveActiveMax(const LaneMask<W>& mask, const Varying<T, W>& a) {
+		T r = std::numeric_limits<T>::lowest();
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			r = mask.bits[i] && a.v[i] > r ? a.v[i] : r;
+		}
+		return r;
+	}
+
+	///WaveActiveMin(有効レーンがない場合はT型の最大値)
+	template<typename T, int W>
+	WAVE_INLINE T WaveActiveMin(const LaneMask<W>& mask, const Varying<T, W>& a) {
+		T r = std::numeric_limits<T>::max();
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			r = mask.bits[i] && a.v[i] < r ? a.v[i] : r;
+		}
+		return r;
+	}
+
+	///WavePrefixSum(自分より前の有効レーンの合計。自分は含まない)
+	template<typename T, int W>
+	WAVE_INLINE Varying<T, W> WavePrefixSum(const LaneMask<W>& mask, const Varying<T, W>& a) {
+		Varying<T, W> r;
+		T sum = T();
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			r.v[i] = sum;
+			sum += mask.bits[i] ? a.v[i] : T();
+		}
+		return r;
+	}
+
+	//ここからバッファアクセス
+
+	///インデックスがレーン順に連続しているか(index[i] == index[0] + i)
+	///連続していればgather/scatterではなく普通のSIMDロード/ストアにできる
+	template<int W>
+	WAVE_INLINE bool IsContiguous(const Varying<unsigned int, W>& index) {
+		return (index == WaveGetLaneIndex<W>() + index.v[0]).AllSet();
+	}
+
+	//無効レーンのインデックスは0に置き換えて分岐なしで読む(SIMDのgatherになるように)
+	//そのためbufferは少なくとも1要素あること
+
+	///buffer[index]をレーンごとに読む(無効レーンは不定)
+	template<typename T, int W>
+	WAVE_INLINE Varying<T, W> Gather(const T* buffer, const Varying<unsigned int, W>& index, const LaneMask<W>& mask) {
+		Varying<T, W> r;
+		if (mask.AllSet() && IsContiguous(index)) {
+			memcpy(&r.v, buffer + index.v[0], sizeof(r.v));
+			return r;
+		}
+		Varying<unsigned int, W> safe;
+		WAVE_LANEWISE(safe.v = index.v & mask.bits, safe.v[i] = index.v[i] & mask.bits[i])
+		WaveDetail::SetLanes<T, W>(r.v, [&](int i) { return buffer[safe.v[i]]; });
+		return r;
+	}
+	///StructuredBufferのメンバ(buffer[index].member)をレーンごとに読む(無効レーンは不定)
+	template<typename S, typename T, int W>
+	WAVE_INLINE Varying<T, W> Gather(const S* buffer, const Varying<unsigned int, W>& index, T S::* member, const LaneMask<W>& mask) {
+		Varying<T, W> r;
+		if (mask.AllSet() && IsContiguous(index)) {
+			const S* p = buffer + index.v[0];
+			WaveDetail::SetLanes<T, W>(r.v, [&](int i) { return p[i].*member; });
+			return r;
+		}
+		Varying<unsigned int, W> safe;
+		WAVE_LANEWISE(safe.v = index.v & mask.bits, safe.v[i] = index.v[i] & mask.bits[i])
+		WaveDetail::SetLanes<T, W>(r.v, [&](int i) { return buffer[safe.v[i]].*member; });
+		return r;
+	}
+	///有効レーンだけbuffer[index]=valueする
+	template<typename T, int W>
+	WAVE_INLINE void Scatter(T* buffer, const Varying<unsigned int, W>& index, const Varying<T, W>& value, const LaneMask<W>& mask) {
+		if (mask.AllSet()) {
+			if (IsContiguous(index)) {
+				memcpy(buffer + index.v[0], &value.v, sizeof(value.v));
+				return;
+			}
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				buffer[index.v[i]] = value.v[i];
+			}
+			return;
+		}
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			if (mask.bits[i]) {
+				buffer[index.v[i]] = value.v[i];
+			}
+		}
+	}
+	///有効レーンだけbuffer[index].member=valueする
+	template<typename S, typename T, int W>
+	WAVE_INLINE void Scatter(S* buffer, const Varying<unsigned int, W>& index, T S::* member, const Varying<T, W>& value, const LaneMask<W>& mask) {
+		if (mask.AllSet()) {
+			if (IsContiguous(index)) {
+				S* p = buffer + index.v[0];
+				WAVE_UNROLL
+				for (int i = 0; i < W; ++i) {
+					p[i].*member = value.v[i];
+				}
+				return;
+			}
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				buffer[index.v[i]].*member = value.v[i];
+			}
+			return;
+		}
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			if (mask.bits[i]) {
+				buffer[index.v[i]].*member = value.v[i];
+			}
+		}
+	}
+
+	///InterlockedAdd(スカラー版)
+	///@return 加算前の値
+	WAVE_INLINE unsigned int InterlockedAdd(unsigned int& dest, unsigned int value) {
+#ifdef _MSC_VER
+		return static_cast<unsigned int>(_InterlockedExchangeAdd(reinterpret_cast<volatile long*>(&dest), static_cast<long>(value)));
+#else
+		return __atomic_fetch_add(&dest, value, __ATOMIC_RELAXED);
+#endif
+	}
+
+	///全有効レーンが同じアドレスにInterlockedAddする場合
+	///ウェーブ内で合計してからアトミックを1回だけ発行するので競合が減る
+	///@return レーンごとの加算前の値(レーン順に加算したのと同じ結果になる)
+	template<int W>
+	WAVE_INLINE Varying<unsigned int, W> InterlockedAdd(unsigned int& dest, const Varying<unsigned int, W>& value, const LaneMask<W>& mask) {
+		auto total = WaveActiveSum(mask, value);
+		unsigned int base = 0;
+		if (total != 0) {
+			base = InterlockedAdd(dest, total);
+		}
+		return WavePrefixSum(mask, value) + base;
+	}
+
+	///レーンごとに別のアドレス(buffer[index])にInterlockedAddする場合
+	///同じアドレスを狙うレーンはウェーブ内でまとめてからアトミックを発行する(ヒストグラムなど向け)
+	template<int W>
+	WAVE_INLINE void InterlockedAdd(unsigned int* buffer, const Varying<unsigned int, W>& index, const Varying<unsigned int, W>& value, const LaneMask<W>& mask) {
+		auto pending = mask;
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			if (!pending.bits[i]) {
+				continue;
+			}
+			unsigned int sum = 0;
+			for (int j = i; j < W; ++j) {
+				if (pending.bits[j] && index.v[j] == index.v[i]) {
+					sum += value.v[j];
+					pending.bits[j] = 0;
+				}
+			}
+			InterlockedAdd(buffer[index.v[i]], sum);
+		}
+	}
+
+	///uint3のvarying版
+	template<int W>
+	struct VaryingUint3 {
+		Varying<unsigned int, W> x;
+		Varying<unsigned int, W> y;
+		Varying<unsigned int, W> z;
+	};
+}
+
+///ウェーブ実行のカーネルに渡すシステム値
+template<int W>
+struct WaveThreadId {
+	hlsl::uint3 groupId;//SV_GroupID(ウェーブ内で共通)
+	hlsl::VaryingUint3<W> groupThreadId;//SV_GroupThreadID
+	hlsl::VaryingUint3<W> dispatchThreadId;//SV_DispatchThreadID
+	hlsl::Varying<unsigned int, W> groupIndex;//SV_GroupIndex
+};
+
+///グループ[begin,end)をウェーブ(SIMD)単位で実行する(DispatchWaveの1チャンク分)
+///@param numThreads [numthreads(x,y,z)]に相当
+///@param x,y グループ数(zは線形のグループ番号から求まるので要らない)
+///@param begin,end 線形のグループ番号(SV_GroupIDのx,y,zの順で、xが一番内側)
+///@param kernel kernel(const WaveThreadId<W>&, const LaneMask<W>& active)の形でウェーブごとに呼ばれる
+///@remarks グループ内のスレッドはSV_GroupIndex順にW個ずつウェーブに詰める。
+///グループのスレッド数がWで割り切れない場合、最後のウェーブの余りレーンはactiveが0になる。
+///呼び出し元に展開されるので、CPU_TARGET_AVX2などの関数から呼べばカーネルごとその命令セットでコンパイルされる
+template<int W, typename Kernel>
+WAVE_INLINE void RunWaveGroups(const hlsl::uint3& numThreads, unsigned int x, unsigned int y, size_t begin, size_t end, Kernel& kernel) {
+	const unsigned int threadsPerGroup = numThreads.x * numThreads.y * numThreads.z;
+	if (begin >= end || threadsPerGroup == 0) {
+		return;
+	}
+	//グループ内のウェーブ配置(SV_GroupThreadIDと有効マスク)は全グループ共通なので先に作っておく
+	struct WaveLayout {
+		hlsl::VaryingUint3<W> groupThreadId;
+		hlsl::Varying<unsigned int, W> groupIndex;
+		hlsl::LaneMask<W> active;
+	};
+	std::vector<WaveLayout> layouts((threadsPerGroup + W - 1) / W);
+	for (size_t w = 0; w < layouts.size(); ++w) {
+		auto& l = layouts[w];
+		WAVE_UNROLL
+		for (int i = 0; i < W; ++i) {
+			auto gi = static_cast<unsigned int>(w * W + i);
+			l.active.bits[i] = gi < threadsPerGroup ? ~0u : 0u;
+			gi = std::min(gi, threadsPerGroup - 1);
+			l.groupIndex.v[i] = gi;
+			l.groupThreadId.x.v[i] = gi % numThreads.x;
+			l.groupThreadId.y.v[i] = (gi / numThreads.x) % numThreads.y;
+			l.groupThreadId.z.v[i] = gi / (numThreads.x * numThreads.y);
+		}
+	}
+
+	using namespace ComputeExecutorDetail;
+	WaveThreadId<W> id;
+	for (auto g = begin; g < end; ++g) {
+		id.groupId = GroupIdFromIndex(g, x, y);
+		const hlsl::uint3 base = { id.groupId.x * numThreads.x, id.groupId.y * numThreads.y, id.groupId.z * numThreads.z };
+		for (auto& l : layouts) {
+			//Varyingを値で受け渡すとコンパイラによってはストアフォワーディングが効かなくなるので
+			//レーンごとに直接書き込む
+			WAVE_UNROLL
+			for (int i = 0; i < W; ++i) {
+				id.groupThreadId.x.v[i] = l.groupThreadId.x.v[i];
+				id.groupThreadId.y.v[i] = l.groupThreadId.y.v[i];
+				id.groupThreadId.z.v[i] = l.groupThreadId.z.v[i];
+				id.groupIndex.v[i] = l.groupIndex.v[i];
+				id.dispatchThreadId.x.v[i] = l.groupThreadId.x.v[i] + base.x;
+				id.dispatchThreadId.y.v[i] = l.groupThreadId.y.v[i] + base.y;
+				id.dispatchThreadId.z.v[i] = l.groupThreadId.z.v[i] + base.z;
+			}
+			kernel(id, l.active);
+		}
+	}
+}
+
+///Dispatch(x,y,z)をウェーブ(SIMD)単位で実行する(ウェーブ幅はコンパイル時に決める)
+///@param executor 実行に使うエグゼキュータ
+///@param numThreads [numthreads(x,y,z)]に相当
+///@param x,y,z グループ数
+///@param kernel kernel(const WaveThreadId<W>&, const LaneMask<W>& active)の形でウェーブごとに呼ばれる
+///@remarks ウェーブの詰め方はRunWaveGroupsと同じ
+template<int W = NativeWaveWidth, typename Kernel>
+void DispatchWave(ComputeExecutor& executor, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, unsigned int z, Kernel&& kernel) {
+	const size_t groupNum = static_cast<size_t>(x) * y * z;
+	if (groupNum == 0) {
+		return;
+	}
+	using namespace ComputeExecutorDetail;
+	executor.ParallelFor(groupNum, GroupGrain(groupNum, executor.ThreadCount()), [&](size_t begin, size_t end) {
+		RunWaveGroups<W>(numThreads, x, y, begin, end, kernel);
+	});
+}
+
+///グループ[begin,end)をウェーブ単位で実行する関数の型
+///RunWaveGroups<4>/<8>/<16>をCPU_TARGET_SSE41/AVX2/AVX512の関数から呼び、Kernel<WaveGroupsFunc<Args>>として登録する
+///@param args カーネルの引数(バッファなど)
+template<typename Args>
+using WaveGroupsFunc = void(*)(const Args& args, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, size_t begin, size_t end);
+
+///Dispatch(x,y,z)を、KernelRegistryで選ばれた命令セット(=ウェーブ幅)の実装で実行する
+///@param groups RunWaveGroupsを呼ぶ命令セット別の関数(Kernel::Get()で得たもの)
+///@param args groupsにそのまま渡す
+template<typename Args>
+void DispatchWaveGroups(ComputeExecutor& executor, const hlsl::uint3& numThreads, unsigned int x, unsigned int y, unsigned int z, WaveGroupsFunc<Args> groups, const Args& args) {
+	const size_t groupNum = static_cast<size_t>(x) * y * z;
+	if (groupNum == 0) {
+		return;
+	}
+	using namespace ComputeExecutorDetail;
+	executor.ParallelFor(groupNum, GroupGrain(groupNum, executor.ThreadCount()), [&](size_t begin, size_t end) {
+		groups(args, numThreads, x, y, begin, end);
+	});
+}
@@ -0,0 +1,94 @@
+﻿//コンピュートシェーダをCPUで実行してみる
+//FirstStepと同じDispatchをCPUのエグゼキュータで実行して
+//同じ結果が出ることを確認します。
+//引数でベンチマークを選べます(引数なしはfirststep)
+//環境変数CPUCOMPUTE_ISAでカーネルの実装(scalar/sse41/avx2/avx512/neon)を強制できます
+//tuneで調整した設定はcpucompute_tune.txt(環境変数CPUCOMPUTE_TUNE_FILEで変更可)に保存され、次回の起動から使われます
+#include<cstdio>
+#include<iostream>
+#include<vector>
+#include<map>
+#include<string>
+#include<functional>
+#include"ComputeExecutor.h"
+#include"KernelRegistry.h"
+#include"FirstStepKernel.h"
+#include"HlslCheck.h"
+#include"DispatchPlanCheck.h"
+#include"Benchmarks.h"
+
+using namespace std;
+
+namespace {
+	///FirstStep(ComputeShader.hlsl)のmainと同じ処理をCPUで行う
+	void RunFirstStep() {
+		std::vector<IDs> uavdata(2 * 2 * 2 * 4 * 4 * 4);
+		//[numthreads(4, 4, 4)]でDispatch(2,2,2)
+		FirstStepIds(uavdata, 2, 2, 2, ComputeExecutor::Instance());
+		for (auto& d : uavdata) {
+			cout << "dispatchThreadId=" << d.dsptThrdId << endl;
+		}
+	}
+
+	///CPUの対応命令セットと、カーネルごとの実装と選択を表示する
+	void ListKernels() {
+		printf("cpu: %s\n", CpuModelName().c_str());
+		printf("supported:");
+		for (int i = 0; i < static_cast<int>(CpuIsa::Count); ++i) {
+			if (IsCpuIsaSupported(static_cast<CpuIsa>(i))) {
+				printf(" %s", CpuIsaName(static_cast<CpuIsa>(i)));
+			}
+		}
+		printf("\n");
+		for (auto kernel : KernelRegistry::Instance().Kernels()) {
+			printf("%-12s selected=%-7s variants:", kernel->Name(), CpuIsaName(kernel->SelectedIsa()));
+			for (auto isa : kernel->Isas()) {
+				printf(" %s", CpuIsaName(isa));
+			}
+			printf("\n");
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	//コマンド名→実行する処理
+	map<string, function<void()>> commandTable;
+	commandTable["firststep"] = RunFirstStep;
+	commandTable["scaling"] = BenchmarkDispatchScaling;
+	commandTable["groupshared"] = BenchmarkGroupShared;
+	commandTable["wave"] = BenchmarkWave;
+	commandTable["mono"] = BenchmarkMonoFilter;
+	commandTable["tune"] = AutotuneMonoFilter;
+	commandTable["jobs"] = BenchmarkComputeJob;
+	commandTable["soa"] = BenchmarkSoa;
+	commandTable["reduce"] = BenchmarkReduction;
+	commandTable["scan"] = BenchmarkScan;
+	commandTable["sort"] = BenchmarkRadixSort;
+	commandTable["blur"] = BenchmarkGaussianBlur;
+	commandTable["median"] = BenchmarkMedianFilter;
+	commandTable["box"] = BenchmarkBoxFilter;
+	commandTable["resample"] = BenchmarkResample;
+	commandTable["lut"] = BenchmarkColorLut;
+	commandTable["graph"] = BenchmarkFilterGraph;
+	commandTable["bloom"] = BenchmarkBloom;
+	commandTable["tonemap"] = BenchmarkToneMap;
+	commandTable["outline"] = BenchmarkOutline;
+	commandTable["reduced"] = BenchmarkReducedResolution;
+	commandTable["incremental"] = BenchmarkIncrementalFilter;
+	commandTable["batch"] = BenchmarkImageBatch;
+	commandTable["kernels"] = ListKernels;
+	commandTable["hlsl"] = [] {CheckHlslMath(); };
+	commandTable["dispatch"] = [] {CheckDispatchPlan(); };
+
+	string command = argc > 1 ? argv[1] : "firststep";
+	auto it = commandTable.find(command);
+	if (it == commandTable.end()) {
+		printf("usage: CpuCompute <command>\n");
+		for (auto& c : commandTable) {
+			printf("  %s\n", c.first.c_str());
+		}
+		return -1;
+	}
+	it->second();
+	return 0;
+}
@@ -0,0 +1,358 @@
+#include "D3D12ScanRunner.h"
+#include<d3dx12.h>
+#include<d3dcompiler.h>
+#include<cassert>
+#include<cstring>
+#include<algorithm>
+
+namespace {
+	//ScanCS.hlslERadixSortCS.hlslƍ킹
+	constexpr size_t tileSize = 256 * 4;//GROUP_SIZE*ITEMS_PER_THREAD
+	constexpr size_t stateStride = 3;//STATE_STRIDE
+	constexpr size_t counterCount = 2;
+	constexpr size_t radix = 256;//RADIX
+	constexpr UINT radixBits = 8;//RADIX_BITS
+	constexpr UINT passNum = 32 / radixBits;
+	constexpr UINT descriptorCount = 6;//u0`u3,t0`t1
+	constexpr UINT constantCount = 4;
+
+	//fBXNv^e[u̕
+	enum Table : UINT {
+		scanTable,//ScanCSECompactCS(inBuffer_outBuffer_)
+		sortEvenTable,//pXRadixSortCS(outBuffer_sortBuffer_)
+		sortOddTable,//pXRadixSortCS(sortBuffer_outBuffer_)
+		digitScanTable,//ScanCS(digitCounts_digitOffsets_)
+		tableCount,
+	};
+
+	size_t TileCount(size_t count) {
+		return (count + tileSize - 1) / tileSize;
+	}
+}
+
+HRESULT D3D12ScanRunner::CreateBuffer(D3D12_HEAP_TYPE heapType, size_t size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state, ComPtr<ID3D12Resource>& res) {
+	CD3DX12_HEAP_PROPERTIES heapProp(heapType);
+	auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(size, flags);
+	return dev_->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, state, nullptr, IID_PPV_ARGS(res.ReleaseAndGetAddressOf()));
+}
+
+HRESULT D3D12ScanRunner::CreateRootSignature() {
+	D3D12_DESCRIPTOR_RANGE range[2] = {};
+	range[0].NumDescriptors = 4;//u0`u3
+	range[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+	range[0].BaseShaderRegister = 0;
+	range[0].OffsetInDescriptorsFromTableStart = 0;
+	range[1].NumDescriptors = 2;//t0`t1
+	range[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+	range[1].BaseShaderRegister = 0;
+	range[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+	D3D12_ROOT_PARAMETER rp[2] = {};
+	rp[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	rp[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	rp[0].DescriptorTable.NumDescriptorRanges = 2;
+	rp[0].DescriptorTable.pDescriptorRanges = range;
+	rp[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;//b0(ScanInfo)
+	rp[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	rp[1].Constants.ShaderRegister = 0;
+	rp[1].Constants.Num32BitValues = constantCount;
+
+	D3D12_ROOT_SIGNATURE_DESC rootSigDesc = {};
+	rootSigDesc.NumParameters = 2;
+	rootSigDesc.pParameters = rp;
+	rootSigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+
+	ComPtr<ID3DBlob> rootSigBlob;
+	ComPtr<ID3DBlob> errBlob;
+	auto result = D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1_0, &rootSigBlob, &errBlob);
+	if (FAILED(result)) {
+		return result;
+	}
+	return dev_->CreateRootSignature(0, rootSigBlob->GetBufferPointer(), rootSigBlob->GetBufferSize(), IID_PPV_ARGS(&rootSignature_));
+}
+
+HRESULT D3D12ScanRunner::CreatePipeline(const wchar_t* file, const char* entry, ComPtr<ID3D12PipelineState>& pipeline) {
+	ComPtr<ID3DBlob> csBlob;
+	ComPtr<ID3DBlob> errBlob;
+	auto result = D3DCompileFromFile(file, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, entry, "cs_5_1", 0, 0, &csBlob, &errBlob);
+	if (errBlob != nullptr) {
+		OutputDebugStringA(static_cast<const char*>(errBlob->GetBufferPointer()));
+	}
+	if (FAILED(result)) {
+		return result;
+	}
+	D3D12_COMPUTE_PIPELINE_STATE_DESC pldesc = {};
+	pldesc.CS.pShaderBytecode = csBlob->GetBufferPointer();
+	pldesc.CS.BytecodeLength = csBlob->GetBufferSize();
+	pldesc.pRootSignature = rootSignature_.Get();
+	return dev_->CreateComputePipelineState(&pldesc, IID_PPV_ARGS(pipeline.ReleaseAndGetAddressOf()));
+}
+
+D3D12ScanRunner::D3D12ScanRunner(ID3D12Device* dev, ID3D12CommandQueue* cmdQue) :
+	dev_(dev), cmdQue_(cmdQue) {
+	auto result = CreateRootSignature();
+	assert(SUCCEEDED(result));
+	result = CreatePipeline(L"ScanCS.hlsl", "ScanCS", scanPipeline_);
+	assert(SUCCEEDED(result));
+	result = CreatePipeline(L"ScanCS.hlsl", "CompactCS", compactPipeline_);
+	assert(SUCCEEDED(result));
+	result = CreatePipeline(L"RadixSortCS.hlsl", "RadixHistogramCS", histogramPipeline_);
+	assert(SUCCEEDED(result));
+	result = CreatePipeline(L"RadixSortCS.hlsl", "RadixScatterCS", scatterPipeline_);
+	assert(SUCCEEDED(result));
+
+	result = dev_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&cmdAlloc_));
+	assert(SUCCEEDED(result));
+	result = dev_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, cmdAlloc_.Get(), nullptr, IID_PPV_ARGS(&cmdList_));
+	assert(SUCCEEDED(result));
+	cmdList_->Close();
+	result = dev_->CreateFence(fenceValue_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+	assert(SUCCEEDED(result));
+	fenceEvent_ = CreateEvent(nullptr, false, false, nullptr);
+
+	D3D12_DESCRIPTOR_HEAP_DESC descHeapDesc = {};
+	descHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	descHeapDesc.NumDescriptors = descriptorCount * tableCount;
+	descHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	result = dev_->CreateDescriptorHeap(&descHeapDesc, IID_PPV_ARGS(&descriptorHeap_));
+	assert(SUCCEEDED(result));
+}
+
+D3D12ScanRunner::~D3D12ScanRunner() {
+	CloseHandle(fenceEvent_);
+}
+
+void D3D12ScanRunner::Reserve(size_t count) {
+	if (inBuffer_ != nullptr && count <= capacity_) {
+		return;
+	}
+	//0vf̃obt@͍Ȃ̂ōŒ1vfԂmۂ
+	capacity_ = std::max<size_t>(count, 1);
+	const auto stateCount = TileCount(capacity_) * stateStride;
+	//̏õXL̃^C(RADIX~^C/TILE_SIZE)͌̃^C𒴂Ȃ̂ŁAtileStates_͂̂܂܎g
+	const auto digitCount = radix * TileCount(capacity_);
+	const auto bytes = capacity_ * sizeof(SimpleBuffer_t);
+	auto result = CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, bytes, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, inBuffer_);
+	assert(SUCCEEDED(result));
+	D3D12_RANGE noRead = { 0,0 };//CPU͓ǂ܂Ȃ
+	result = inBuffer_->Map(0, &noRead, reinterpret_cast<void**>(&mappedIn_));
+	assert(SUCCEEDED(result));
+	result = CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, bytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, outBuffer_);
+	assert(SUCCEEDED(result));
+	result = CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, bytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, sortBuffer_);
+	assert(SUCCEEDED(result));
+	result = CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, digitCount * sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, digitCounts_);
+	assert(SUCCEEDED(result));
+	result = CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, digitCount * sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, digitOffsets_);
+	assert(SUCCEEDED(result));
+	result = CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, stateCount * sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, tileStates_);
+	assert(SUCCEEDED(result));
+	result = CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, counterCount * sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, counters_);
+	assert(SUCCEEDED(result));
+
+	//stateCountSTATE_STRIDE(3)ȏȂ̂counters_0ɂ̂ɂ
+	result = CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, stateCount * sizeof(uint32_t), D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, zeroBuffer_);
+	assert(SUCCEEDED(result));
+	void* zero = nullptr;
+	result = zeroBuffer_->Map(0, &noRead, &zero);
+	assert(SUCCEEDED(result));
+	std::memset(zero, 0, stateCount * sizeof(uint32_t));
+	zeroBuffer_->Unmap(0, nullptr);
+
+	const auto readbackBytes = bytes + counterCount * sizeof(uint32_t);
+	result = CreateBuffer(D3D12_HEAP_TYPE_READBACK, readbackBytes, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COPY_DEST, readbackBuffer_);
+	assert(SUCCEEDED(result));
+	D3D12_RANGE readRange = { 0,readbackBytes };
+	result = readbackBuffer_->Map(0, &readRange, reinterpret_cast<void**>(&mappedOut_));
+	assert(SUCCEEDED(result));
+
+	//r[̓e[ȕɁAꂼScanCS.hlslERadixSortCS.hlsl̃WX^̏(u0`u3,t0`t1)ŕׂ
+	//(VF[_gȂWX^ɂA`̍r[uĂ)
+	auto handle = descriptorHeap_->GetCPUDescriptorHandleForHeapStart();
+	const auto increment = dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	auto uav = [&](ID3D12Resource* res, size_t num, UINT stride) {
+		D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+		uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.NumElements = static_cast<UINT>(num);
+		uavDesc.Buffer.StructureByteStride = stride;
+		dev_->CreateUnorderedAccessView(res, nullptr, &uavDesc, handle);
+		handle.ptr += increment;
+	};
+	auto srv = [&](ID3D12Resource* res, size_t num, UINT stride) {
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.NumElements = static_cast<UINT>(num);
+		srvDesc.Buffer.StructureByteStride = stride;
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		dev_->CreateShaderResourceView(res, &srvDesc, handle);
+		handle.ptr += increment;
+	};
+	//scanTable
+	uav(outBuffer_.Get(), capacity_, sizeof(uint32_t));//u0 scanDst
+	uav(tileStates_.Get(), stateCount, sizeof(uint32_t));//u1 tileStates
+	uav(counters_.Get(), counterCount, sizeof(uint32_t));//u2 counters
+	uav(outBuffer_.Get(), capacity_, sizeof(SimpleBuffer_t));//u3 compactDst
+	srv(inBuffer_.Get(), capacity_, sizeof(uint32_t));//t0 scanSrc
+	srv(inBuffer_.Get(), capacity_, sizeof(SimpleBuffer_t));//t1 compactSrc
+	//sortEvenTable,sortOddTable
+	ID3D12Resource* records[] = { outBuffer_.Get(), sortBuffer_.Get() };
+	for (int i = 0; i < 2; ++i) {
+		uav(records[1 - i], capacity_, sizeof(SimpleBuffer_t));//u0 dstRecords
+		uav(digitCounts_.Get(), digitCount, sizeof(uint32_t));//u1 digitCounts
+		uav(counters_.Get(), counterCount, sizeof(uint32_t));//u2 (gȂ)
+		uav(tileStates_.Get(), stateCount, sizeof(uint32_t));//u3 (gȂ)
+		srv(records[i], capacity_, sizeof(SimpleBuffer_t));//t0 srcRecords
+		srv(digitOffsets_.Get(), digitCount, sizeof(uint32_t));//t1 digitOffsets
+	}
+	//digitScanTable
+	uav(digitOffsets_.Get(), digitCount, sizeof(uint32_t));//u0 scanDst
+	uav(tileStates_.Get(), stateCount, sizeof(uint32_t));//u1 tileStates
+	uav(counters_.Get(), counterCount, sizeof(uint32_t));//u2 counters
+	uav(sortBuffer_.Get(), capacity_, sizeof(SimpleBuffer_t));//u3 compactDst(gȂ)
+	srv(digitCounts_.Get(), digitCount, sizeof(uint32_t));//t0 scanSrc
+	srv(inBuffer_.Get(), capacity_, sizeof(SimpleBuffer_t));//t1 compactSrc(gȂ)
+}
+
+void D3D12ScanRunner::Begin() {
+	cmdAlloc_->Reset();
+	cmdList_->Reset(cmdAlloc_.Get(), nullptr);
+	cmdList_->SetComputeRootSignature(rootSignature_.Get());
+	ID3D12DescriptorHeap* descHeaps[] = { descriptorHeap_.Get() };
+	cmdList_->SetDescriptorHeaps(1, descHeaps);
+}
+
+void D3D12ScanRunner::ClearTileStates(size_t tiles) {
+	assert(tiles <= TileCount(capacity_));
+	//look-back̓^C̏Ԃ0(J)n܂A^Cԍ0ẑŁADispatcĥт0ɂ
+	D3D12_RESOURCE_BARRIER barriers[] = {
+		CD3DX12_RESOURCE_BARRIER::Transition(tileStates_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST),
+		CD3DX12_RESOURCE_BARRIER::Transition(counters_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST),
+	};
+	cmdList_->ResourceBarrier(2, barriers);
+	cmdList_->CopyBufferRegion(tileStates_.Get(), 0, zeroBuffer_.Get(), 0, tiles * stateStride * sizeof(uint32_t));
+	cmdList_->CopyBufferRegion(counters_.Get(), 0, zeroBuffer_.Get(), 0, counterCount * sizeof(uint32_t));
+	for (auto& barrier : barriers) {
+		std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+	}
+	cmdList_->ResourceBarrier(2, barriers);
+}
+
+void D3D12ScanRunner::Dispatch(ID3D12PipelineState* pipeline, UINT table, const UINT(&constants)[4], size_t groups) {
+	assert(groups <= D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION);
+	auto handle = descriptorHeap_->GetGPUDescriptorHandleForHeapStart();
+	handle.ptr += static_cast<UINT64>(table) * descriptorCount * dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	cmdList_->SetPipelineState(pipeline);
+	cmdList_->SetComputeRootDescriptorTable(0, handle);
+	cmdList_->SetComputeRoot32BitConstants(1, constantCount, constants, 0);
+	cmdList_->Dispatch(static_cast<UINT>(groups), 1, 1);
+}
+
+void D3D12ScanRunner::Finish(size_t readBytes) {
+	//ʂƐ[hobNpobt@ɃRs[āAɎgƂ̂߂UAVɖ߂
+	D3D12_RESOURCE_BARRIER barriers[] = {
+		CD3DX12_RESOURCE_BARRIER::Transition(outBuffer_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+		CD3DX12_RESOURCE_BARRIER::Transition(counters_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+	};
+	cmdList_->ResourceBarrier(2, barriers);
+	cmdList_->CopyBufferRegion(readbackBuffer_.Get(), 0, outBuffer_.Get(), 0, readBytes);
+	cmdList_->CopyBufferRegion(readbackBuffer_.Get(), capacity_ * sizeof(SimpleBuffer_t), counters_.Get(), 0, counterCount * sizeof(uint32_t));
+	for (auto& barrier : barriers) {
+		std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+	}
+	cmdList_->ResourceBarrier(2, barriers);
+	cmdList_->Close();
+
+	ID3D12CommandList* cmdLists[] = { cmdList_.Get() };
+	cmdQue_->ExecuteCommandLists(1, cmdLists);
+	cmdQue_->Signal(fence_.Get(), ++fenceValue_);
+	if (fence_->GetCompletedValue() < fenceValue_) {
+		fence_->SetEventOnCompletion(fenceValue_, fenceEvent_);
+		WaitForSingleObject(fenceEvent_, INFINITE);
+	}
+}
+
+void D3D12ScanRunner::Scan(const uint32_t* src, uint32_t* dst, size_t count, bool inclusive) {
+	if (count == 0) {
+		return;
+	}
+	Reserve(count);
+	std::memcpy(mappedIn_, src, count * sizeof(uint32_t));
+	Begin();
+	ClearTileStates(TileCount(count));
+	const UINT scanInfo[constantCount] = { static_cast<UINT>(count), inclusive ? 1u : 0u, 0, 0 };
+	Dispatch(scanPipeline_.Get(), scanTable, scanInfo, TileCount(count));
+	Finish(count * sizeof(uint32_t));
+	std::memcpy(dst, mappedOut_, count * sizeof(uint32_t));
+}
+
+size_t D3D12ScanRunner::Compact(const SimpleBuffer_t* src, size_t count, float threshold, SimpleBuffer_t* dst) {
+	if (count == 0) {
+		return 0;
+	}
+	Reserve(count);
+	std::memcpy(mappedIn_, src, count * sizeof(SimpleBuffer_t));
+	Begin();
+	ClearTileStates(TileCount(count));
+	UINT scanInfo[constantCount] = { static_cast<UINT>(count), 0, 0, 0 };
+	std::memcpy(&scanInfo[2], &threshold, sizeof(threshold));
+	Dispatch(compactPipeline_.Get(), scanTable, scanInfo, TileCount(count));
+	Finish(count * sizeof(SimpleBuffer_t));
+	uint32_t kept = 0;//counters[1]
+	std::memcpy(&kept, mappedOut_ + capacity_ * sizeof(SimpleBuffer_t) + sizeof(uint32_t), sizeof(kept));
+	assert(kept <= count);
+	std::memcpy(dst, mappedOut_, kept * sizeof(SimpleBuffer_t));
+	return kept;
+}
+
+void D3D12ScanRunner::SortRecordsByField(SimpleBuffer_t* records, size_t count, UINT keyField) {
+	if (count < 2) {
+		return;
+	}
+	Reserve(count);
+	std::memcpy(mappedIn_, records, count * sizeof(SimpleBuffer_t));
+	const auto tiles = TileCount(count);
+	const auto digitCount = radix * tiles;
+	Begin();
+	//͂outBuffer_ɎʂāAŏ̃pXœǂ߂悤ɂ
+	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(outBuffer_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST);
+	cmdList_->ResourceBarrier(1, &barrier);
+	cmdList_->CopyBufferRegion(outBuffer_.Get(), 0, inBuffer_.Get(), 0, count * sizeof(SimpleBuffer_t));
+	barrier = CD3DX12_RESOURCE_BARRIER::Transition(outBuffer_.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	cmdList_->ResourceBarrier(1, &barrier);
+
+	ID3D12Resource* src = outBuffer_.Get();
+	ID3D12Resource* dst = sortBuffer_.Get();
+	for (UINT pass = 0; pass < passNum; ++pass) {
+		const UINT sortInfo[constantCount] = { static_cast<UINT>(count), pass * radixBits, static_cast<UINT>(tiles), keyField };//RadixSortInfo
+		const UINT table = pass % 2 == 0 ? sortEvenTable : sortOddTable;
+		Dispatch(histogramPipeline_.Get(), table, sortInfo, tiles);
+
+		//̏orIXLāAe^C̊ȅ݊Jnʒuɂ
+		barrier = CD3DX12_RESOURCE_BARRIER::Transition(digitCounts_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		cmdList_->ResourceBarrier(1, &barrier);
+		ClearTileStates(TileCount(digitCount));
+		const UINT scanInfo[constantCount] = { static_cast<UINT>(digitCount), 0, 0, 0 };
+		Dispatch(scanPipeline_.Get(), digitScanTable, scanInfo, TileCount(digitCount));
+		barrier = CD3DX12_RESOURCE_BARRIER::Transition(digitOffsets_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		cmdList_->ResourceBarrier(1, &barrier);
+
+		Dispatch(scatterPipeline_.Get(), table, sortInfo, tiles);
+		//̃pX̓͂ɂāAقUAVɖ߂
+		D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(src, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(dst, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(digitCounts_.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(digitOffsets_.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+		};
+		cmdList_->ResourceBarrier(4, barriers);
+		std::swap(src, dst);
+	}
+	//pXȂ̂ŌʂoutBuffer_ɖ߂Ă
+	static_assert(passNum % 2 == 0, "the sorted records must end up in outBuffer_");
+	barrier = CD3DX12_RESOURCE_BARRIER::Transition(outBuffer_.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	cmdList_->ResourceBarrier(1, &barrier);
+	Finish(count * sizeof(SimpleBuffer_t));
+	std::memcpy(records, mappedOut_, count * sizeof(SimpleBuffer_t));
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include<d3d12.h>
+#include<wrl.h>
+#include<cstdint>
+#include<cstddef>
+#include<type_traits>
+#include"../CpuCompute/FirstStepKernel.h"
+
+///ScanCS.hlsl̃XLƃRpNVAgRadixSortCS.hlsl̊\[gRs[gL[Ŏs
+///XLERpNV̓͂Map܂܂UPLOAD̃obt@̂܂SRVɂ(\[gDEFAULT̃obt@ɎʂĂׂ)A
+///ʂREADBACKɃRs[Ċ҂
+///(D3D12ComputeJobƓAobt@͑傫ȂƂ蒼Ďg܂킷)
+///@remarks [gVOl`0ԂɃfBXNv^e[u(u0`u3,t0`t1̏)A1Ԃb0̃[g萔4
+class D3D12ScanRunner
+{
+	template<typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	ComPtr<ID3D12Device> dev_;
+	ComPtr<ID3D12CommandQueue> cmdQue_;
+	ComPtr<ID3D12RootSignature> rootSignature_;
+	ComPtr<ID3D12PipelineState> scanPipeline_;//ScanCS
+	ComPtr<ID3D12PipelineState> compactPipeline_;//CompactCS
+	ComPtr<ID3D12PipelineState> histogramPipeline_;//RadixHistogramCS
+	ComPtr<ID3D12PipelineState> scatterPipeline_;//RadixScatterCS
+	ComPtr<ID3D12CommandAllocator> cmdAlloc_;
+	ComPtr<ID3D12GraphicsCommandList> cmdList_;
+	ComPtr<ID3D12Fence> fence_;
+	UINT64 fenceValue_ = 0;
+	HANDLE fenceEvent_ = nullptr;
+	ComPtr<ID3D12DescriptorHeap> descriptorHeap_;//u0`u3,t0`t1̃e[utableCount
+
+	ComPtr<ID3D12Resource> inBuffer_;//UPLOAD(t0uintAt1SimpleBuffer_tƂČ)
+	ComPtr<ID3D12Resource> outBuffer_;//DEFAULT(u0uintAu3SimpleBuffer_tƂČB\[gł͓o)
+	ComPtr<ID3D12Resource> sortBuffer_;//DEFAULT(\[gŃpXƂoutBuffer_Ɠǂݏւ)
+	ComPtr<ID3D12Resource> digitCounts_;//DEFAULT(RADIX~^CB^CƂ̌̏o)
+	ComPtr<ID3D12Resource> digitOffsets_;//DEFAULT(digitCounts_̔rIXL)
+	ComPtr<ID3D12Resource> tileStates_;//DEFAULT(^C~STATE_STRIDE)
+	ComPtr<ID3D12Resource> counters_;//DEFAULT([0]̃^Cԍ,[1]RpNVŎc)
+	ComPtr<ID3D12Resource> zeroBuffer_;//UPLOAD(tileStates_counters_0ɂRs[)
+	ComPtr<ID3D12Resource> readbackBuffer_;//READBACK(outBuffer_̌counters_)
+	uint8_t* mappedIn_ = nullptr;
+	uint8_t* mappedOut_ = nullptr;
+	size_t capacity_ = 0;//vf(SimpleBuffer_tŐ)
+
+	HRESULT CreateBuffer(D3D12_HEAP_TYPE heapType, size_t size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state, ComPtr<ID3D12Resource>& res);
+	HRESULT CreateRootSignature();
+	HRESULT CreatePipeline(const wchar_t* file, const char* entry, ComPtr<ID3D12PipelineState>& pipeline);
+	//countvf悤Ƀobt@ƃr[pӂ
+	void Reserve(size_t count);
+	//R}hXgJă[gVOl`ƃfBXNv^q[vς
+	void Begin();
+	//tileStates_counters_0ɂ(ScanCSECompactCSDispatcĥтɕKv)
+	void ClearTileStates(size_t tiles);
+	//tableԖڂ̃fBXNv^e[ub0̃[g萔Dispatch
+	void Dispatch(ID3D12PipelineState* pipeline, UINT table, const UINT(&constants)[4], size_t groups);
+	//outBuffer_(counters_)[hobNAR}hXgĎs҂
+	void Finish(size_t readBytes);
+	void SortRecordsByField(SimpleBuffer_t* records, size_t count, UINT keyField);
+
+	D3D12ScanRunner(const D3D12ScanRunner&) = delete;
+	void operator=(const D3D12ScanRunner&) = delete;
+public:
+	///@param dev foCX
+	///@param cmdQue sL[(D3D12_COMMAND_LIST_TYPE_COMPUTE)
+	///@remarks VF[_̓JgfBNgScanCS.hlslERadixSortCS.hlslsɃRpC
+	D3D12ScanRunner(ID3D12Device* dev, ID3D12CommandQueue* cmdQue);
+	~D3D12ScanRunner();
+
+	///src(count)XLdstɏBCpuCompute/ScanExclusiveScanEInclusiveScanƓʂɂȂ
+	///@param inclusive trueȂܓIXL
+	void Scan(const uint32_t* src, uint32_t* dst, size_t count, bool inclusive);
+
+	///src(count)̂f > threshold̗vfۂċl߂dstɏ
+	///@return o
+	size_t Compact(const SimpleBuffer_t* src, size_t count, float threshold, SimpleBuffer_t* dst);
+
+	///records(count)tB[h̒l̏ɕׂ(l̗vf͌̏̂܂)
+	///1pX8bit4pXApXƂRadixHistogramCSScanCS(̏o̔rIXL)RadixScatterCS1̃R}hXgŗ
+	///@param key &SimpleBuffer_t::i&SimpleBuffer_t::fBCpuCompute/RadixSortRadixSorter::SortRecordsƓʂɂȂ
+	template<typename M>
+	void SortRecords(SimpleBuffer_t* records, size_t count, M SimpleBuffer_t::* key) {
+		static_assert(std::is_same<M, int>::value || std::is_same<M, float>::value, "key must be SimpleBuffer_t::i or SimpleBuffer_t::f");
+		(void)key;
+		SortRecordsByField(records, count, std::is_same<M, float>::value ? 1 : 0);//RadixSortInfo.keyField
+	}
+};
@@ -0,0 +1,167 @@
+//\[g(LSDA1pX8bit~4pXA)̃Rs[gVF[_
+//SimpleBuffer_ti܂fL[ɂĕבւB1pX͎3Dispatchōs
+//  1. RadixHistogramCS : ^C(TILE_SIZEvf)Ƃɍ̌̏o𐔂AdigitCounts[*tileCount+^C]ɏ
+//  2. ScanCS(ScanCS.hlsl) : digitCounts(RADIX*tileCountvf)rIXLƁA
+//     ̏^C̏ɕׂƂ́Ae^C̊ȅ݊JnʒuɂȂ
+//  3. RadixScatterCS : ^Cňɕ(1bit̕8)AJnʒȕԂ̈ʒuɏ
+//Dispatch͂ǂtileCount=(elementCount+TILE_SIZE-1)/TILE_SIZEB
+//srcRecordsdstRecords̓pXƂɓւ(4pXȂ̂ōŌ͌̃obt@ɖ߂)
+//CPUłCpuCompute/RadixSort.cppBL[̕ϊRadixKey.hlsliCPUłƋLĂ
+//zXg(3Dispatch4pXԂ1̃R}hXgɐς)D3D12ScanRunner.cppSortRecordsByField
+
+#include"../CpuCompute/RadixKey.hlsli"
+
+//CPŨf[^^ƍ킹Kv(ComputeShader.hlslƓ)
+struct SimpleBuffer_t
+{
+	int		i;
+	float	f;
+};
+
+cbuffer RadixSortInfo : register(b0)
+{
+    uint elementCount;
+    uint shift;//̌(0,8,16,24)
+    uint tileCount;
+    uint keyField;//0ȂiA1ȂfL[ɂ
+};
+
+StructuredBuffer<SimpleBuffer_t> srcRecords : register(t0);
+StructuredBuffer<uint> digitOffsets : register(t1);//digitCountsrIXL
+RWStructuredBuffer<SimpleBuffer_t> dstRecords : register(u0);
+RWStructuredBuffer<uint> digitCounts : register(u1);
+
+#define GROUP_SIZE 256
+#define ITEMS_PER_THREAD 4
+#define TILE_SIZE (GROUP_SIZE * ITEMS_PER_THREAD)
+#define RADIX 256//GROUP_SIZEƓ(1Xbh1̌󂯎Ƃ낪)
+#define RADIX_BITS 8
+
+uint RecordKey(SimpleBuffer_t record)
+{
+    return keyField == 0 ? IntToSortableKey(record.i) : FloatToSortableKey(record.f);
+}
+
+groupshared uint sharedCounts[RADIX];
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void RadixHistogramCS(uint gi : SV_GroupIndex, uint3 gid : SV_GroupID)
+{
+    sharedCounts[gi] = 0;
+    GroupMemoryBarrierWithGroupSync();
+    uint base = gid.x * TILE_SIZE;
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; ++i)
+    {
+        //ׂ̃Xbhׂ̗vfǂނ悤ɂ
+        uint index = base + i * GROUP_SIZE + gi;
+        if (index < elementCount)
+        {
+            InterlockedAdd(sharedCounts[RadixDigit(RecordKey(srcRecords[index]), shift)], 1);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+    digitCounts[gi * tileCount + gid.x] = sharedCounts[gi];
+}
+
+groupshared uint sharedKeys[TILE_SIZE];
+groupshared uint sharedIndices[TILE_SIZE];//^Č̈ʒu
+groupshared uint sharedSums[GROUP_SIZE];
+groupshared uint sharedDigitStart[RADIX];//ׂ̃^CŊen܂ʒu
+
+//O[v̔rIXL(Hillis-Steele)BtotalɃO[v̍vԂ
+uint GroupExclusiveScan(uint gi, uint value, out uint total)
+{
+    sharedSums[gi] = value;
+    GroupMemoryBarrierWithGroupSync();
+    [unroll]
+    for (uint offset = 1; offset < GROUP_SIZE; offset <<= 1)
+    {
+        uint add = gi >= offset ? sharedSums[gi - offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        sharedSums[gi] += add;
+        GroupMemoryBarrierWithGroupSync();
+    }
+    total = sharedSums[GROUP_SIZE - 1];
+    return sharedSums[gi] - value;
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void RadixScatterCS(uint gi : SV_GroupIndex, uint3 gid : SV_GroupID)
+{
+    uint base = gid.x * TILE_SIZE;
+    //Xbh̓^C̘AITEMS_PER_THREADvf󂯎
+    //͈͊O͍ő̃L[ɂĂ(Ȃ̂ŁA̖{̗vfɕ)
+    uint keys[ITEMS_PER_THREAD];
+    uint indices[ITEMS_PER_THREAD];
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; ++i)
+    {
+        uint local = gi * ITEMS_PER_THREAD + i;
+        keys[i] = base + local < elementCount ? RecordKey(srcRecords[base + local]) : 0xffffffff;
+        indices[i] = local;
+    }
+
+    //̌bit1bitA0̗vfOɁE1̗vfɕ(ꂼ̒̏Ԃ͕ۂ)
+    for (uint bit = 0; bit < RADIX_BITS; ++bit)
+    {
+        uint zeros = 0;
+        [unroll]
+        for (uint j = 0; j < ITEMS_PER_THREAD; ++j)
+        {
+            zeros += ((keys[j] >> (shift + bit)) & 1) == 0 ? 1 : 0;
+        }
+        uint totalZeros;
+        uint zerosBefore = GroupExclusiveScan(gi, zeros, totalZeros);
+        [unroll]
+        for (uint k = 0; k < ITEMS_PER_THREAD; ++k)
+        {
+            uint position = gi * ITEMS_PER_THREAD + k;
+            uint dst;
+            if (((keys[k] >> (shift + bit)) & 1) == 0)
+            {
+                dst = zerosBefore++;
+            }
+            else
+            {
+                //Oɂ1̗vf̐ = Oɂvf̐ - Oɂ0̗vf̐
+                dst = totalZeros + position - zerosBefore;
+            }
+            sharedKeys[dst] = keys[k];
+            sharedIndices[dst] = indices[k];
+        }
+        GroupMemoryBarrierWithGroupSync();
+        [unroll]
+        for (uint m = 0; m < ITEMS_PER_THREAD; ++m)
+        {
+            keys[m] = sharedKeys[gi * ITEMS_PER_THREAD + m];
+            indices[m] = sharedIndices[gi * ITEMS_PER_THREAD + m];
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    //ςʒuL^(sharedKeysɂׂ͕̃L[cĂ)
+    [unroll]
+    for (uint n = 0; n < ITEMS_PER_THREAD; ++n)
+    {
+        uint position = gi * ITEMS_PER_THREAD + n;
+        uint digit = RadixDigit(keys[n], shift);
+        if (position == 0 || RadixDigit(sharedKeys[position - 1], shift) != digit)
+        {
+            sharedDigitStart[digit] = position;
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    //݈ʒu = ̃^Ĉ̌̊Jnʒu + ^Cœ̉Ԗڂ
+    [unroll]
+    for (uint p = 0; p < ITEMS_PER_THREAD; ++p)
+    {
+        if (base + indices[p] < elementCount)
+        {
+            uint position = gi * ITEMS_PER_THREAD + p;
+            uint digit = RadixDigit(keys[p], shift);
+            dstRecords[digitOffsets[digit * tileCount + gid.x] + position - sharedDigitStart[digit]] = srcRecords[base + indices[p]];
+        }
+    }
+}
@@ -0,0 +1,187 @@
+//vtBbNXT(XL)ƃXg[RpNṼRs[gVF[_
+//1pXdecoupled look-back(Merrill & Garland, "Single-pass Parallel Prefix Scan with Decoupled Look-back")
+//  E1O[v1^C(TILE_SIZEvf)󂯎B^CԍSV_GroupIDł͂ȂInterlockedAddŎA
+//    ɓoO[vقǑÕ^CɂȂ悤ɂ(Õ^C҂Ă~܂Ȃ)
+//  E^C̍v(aggregate)JĂÕ^CkAړ(prefix)Ŏ~܂
+//  E^C̏Ԃ̓tOEvEړʁXuintɒuAlĂDeviceMemoryBarrierŃtO𗧂Ă
+//    (l32bit̂܂܁BCPUłƓ2^32@ƂĉBvƐړ𕪂̂ŁAtOƈႤ̒lǂނƂ͂Ȃ)
+//  EtileStates(^C~STATE_STRIDEvf)counters[0]Dispatch̑O0ɂĂBDispatch(elementCount+TILE_SIZE-1)/TILE_SIZE
+//CPUłCpuCompute/Scan.cpp
+//zXg(obt@̗pӁAtileStatescounters0NAADispatchA[hobN)D3D12ScanRunner.cpp
+
+//CPŨf[^^ƍ킹Kv(ComputeShader.hlslƓ)
+struct SimpleBuffer_t
+{
+	int		i;
+	float	f;
+};
+
+cbuffer ScanInfo : register(b0)
+{
+    uint elementCount;
+    uint inclusive;//0ȂrIXL
+    float threshold;//RpNVŎc(f > threshold)
+};
+
+StructuredBuffer<uint> scanSrc : register(t0);
+StructuredBuffer<SimpleBuffer_t> compactSrc : register(t1);
+RWStructuredBuffer<uint> scanDst : register(u0);
+globallycoherent RWStructuredBuffer<uint> tileStates : register(u1);//^C~STATE_STRIDE
+globallycoherent RWStructuredBuffer<uint> counters : register(u2);//[0]̃^Cԍ,[1]RpNVŎc
+RWStructuredBuffer<SimpleBuffer_t> compactDst : register(u3);
+
+#define GROUP_SIZE 256
+#define ITEMS_PER_THREAD 4
+#define TILE_SIZE (GROUP_SIZE * ITEMS_PER_THREAD)
+
+#define FLAG_NOT_READY 0
+#define FLAG_AGGREGATE 1
+#define FLAG_PREFIX 2
+//tileStates̃^CƂ̕
+#define STATE_FLAG 0
+#define STATE_AGGREGATE 1
+#define STATE_PREFIX 2
+#define STATE_STRIDE 3
+
+groupshared uint sharedSums[GROUP_SIZE];
+groupshared uint sharedTile;
+groupshared uint sharedPrefix;
+
+//̃O[ṽ^Cԍ
+uint AcquireTile(uint gi)
+{
+    if (gi == 0)
+    {
+        InterlockedAdd(counters[0], 1, sharedTile);
+    }
+    GroupMemoryBarrierWithGroupSync();
+    return sharedTile;
+}
+
+//O[v̔rIXL(Hillis-Steele)BtotalɃO[v̍vԂ
+uint GroupExclusiveScan(uint gi, uint value, out uint total)
+{
+    sharedSums[gi] = value;
+    GroupMemoryBarrierWithGroupSync();
+    [unroll]
+    for (uint offset = 1; offset < GROUP_SIZE; offset <<= 1)
+    {
+        uint add = gi >= offset ? sharedSums[gi - offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        sharedSums[gi] += add;
+        GroupMemoryBarrierWithGroupSync();
+    }
+    total = sharedSums[GROUP_SIZE - 1];
+    return sharedSums[gi] - value;
+}
+
+//^C̏ԂJ(l悤ɂȂĂtO悤ɂ)
+void PublishTileState(uint tile, uint flag, uint value)
+{
+    uint old;
+    InterlockedExchange(tileStates[tile * STATE_STRIDE + (flag == FLAG_PREFIX ? STATE_PREFIX : STATE_AGGREGATE)], value, old);
+    DeviceMemoryBarrier();
+    InterlockedExchange(tileStates[tile * STATE_STRIDE + STATE_FLAG], flag, old);
+}
+
+//^C̍vJAÕ^CkẴ^CO̍v߂(O[v0ԃXbhĂ)
+uint LookBack(uint tile, uint aggregate)
+{
+    if (tile == 0)
+    {
+        PublishTileState(0, FLAG_PREFIX, aggregate);
+        return 0;
+    }
+    PublishTileState(tile, FLAG_AGGREGATE, aggregate);
+    uint exclusive = 0;
+    uint prev = tile - 1;
+    [allow_uav_condition]
+    while (true)
+    {
+        uint flag;
+        InterlockedOr(tileStates[prev * STATE_STRIDE + STATE_FLAG], 0, flag);//Ag~bNɓǂ
+        if (flag == FLAG_NOT_READY)
+        {
+            continue;//Õ^C܂voĂȂ
+        }
+        DeviceMemoryBarrier();//tOǂłlǂ
+        uint value;
+        InterlockedOr(tileStates[prev * STATE_STRIDE + (flag == FLAG_PREFIX ? STATE_PREFIX : STATE_AGGREGATE)], 0, value);
+        exclusive += value;
+        if (flag == FLAG_PREFIX)
+        {
+            break;
+        }
+        --prev;
+    }
+    PublishTileState(tile, FLAG_PREFIX, exclusive + aggregate);
+    return exclusive;
+}
+
+//^CŊeXbh󂯎vf̍vXLÃXbh̍ŏ̗vfȎŜ̍vԂ
+uint TilePrefix(uint gi, uint tile, uint threadSum)
+{
+    uint total;
+    uint threadPrefix = GroupExclusiveScan(gi, threadSum, total);
+    if (gi == 0)
+    {
+        sharedPrefix = LookBack(tile, total);
+    }
+    GroupMemoryBarrierWithGroupSync();
+    return sharedPrefix + threadPrefix;
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void ScanCS(uint gi : SV_GroupIndex)
+{
+    uint tile = AcquireTile(gi);
+    uint base = tile * TILE_SIZE + gi * ITEMS_PER_THREAD;
+    uint items[ITEMS_PER_THREAD];
+    uint threadSum = 0;
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; ++i)
+    {
+        items[i] = base + i < elementCount ? scanSrc[base + i] : 0;
+        threadSum += items[i];
+    }
+    uint running = TilePrefix(gi, tile, threadSum);
+    [unroll]
+    for (uint j = 0; j < ITEMS_PER_THREAD; ++j)
+    {
+        if (base + j < elementCount)
+        {
+            scanDst[base + j] = inclusive ? running + items[j] : running;
+        }
+        running += items[j];
+    }
+}
+
+//f > threshold̗vfۂċl߂(c̔rIXL݈ʒuɂȂ)
+[numthreads(GROUP_SIZE, 1, 1)]
+void CompactCS(uint gi : SV_GroupIndex)
+{
+    uint tile = AcquireTile(gi);
+    uint base = tile * TILE_SIZE + gi * ITEMS_PER_THREAD;
+    bool keep[ITEMS_PER_THREAD];
+    uint threadSum = 0;
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; ++i)
+    {
+        keep[i] = base + i < elementCount && compactSrc[base + i].f > threshold;
+        threadSum += keep[i] ? 1 : 0;
+    }
+    uint position = TilePrefix(gi, tile, threadSum);
+    [unroll]
+    for (uint j = 0; j < ITEMS_PER_THREAD; ++j)
+    {
+        if (keep[j])
+        {
+            compactDst[position++] = compactSrc[base + j];
+        }
+    }
+    //Ō̃^CŜ̐
+    if (gi == GROUP_SIZE - 1 && (tile + 1) * TILE_SIZE >= elementCount)
+    {
+        counters[1] = position;
+    }
+}
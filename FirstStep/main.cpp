@@ -2,6 +2,10 @@
 //ЂƂ܂UAVɃRs[gVF[_lނ
 //񂾒lCPU猩悤READ_BACK̃obt@ɃRs[
 //MapŎQƂ܂B
+//(UPLOAD)EUAVEREAD_BACK̃obt@ƃr[AoAAtFX
+//D3D12ComputeJobɂ܂Ƃ߂ĂAxRunĂobt@͎g܂킳܂B
+//̂ScanCS.hlsl̃XLƃRpNVARadixSortCS.hlsl̊\[gD3D12ScanRunnerŎsāA
+//CpuCompute/ScanECpuCompute/RadixSorťʂƓɂȂ邩m߂܂B
 #include<d3d12.h>
 #include<DirectXMath.h>
 #include<d3dcompiler.h>
@@ -13,6 +17,11 @@
 #include<d3dx12.h>
 #include<random>
 #include<algorithm>
+#include"../CpuCompute/D3D12ComputeJob.h"
+#include"../CpuCompute/FirstStepKernel.h"
+#include"../CpuCompute/Scan.h"
+#include"../CpuCompute/RadixSort.h"
+#include"D3D12ScanRunner.h"
 
 using namespace std;
 
@@ -37,121 +46,15 @@ namespace {
 
 	//gpD3D12IuWFNg
 	ID3D12Device* dev_ = nullptr;//foCXIuWFNg
-	ID3D12CommandAllocator* cmdAlloc_ = nullptr;
-	ID3D12GraphicsCommandList * cmdList_ = nullptr;//R}hXg
 	ID3D12CommandQueue* cmdQue_ = nullptr;
 	ID3D12PipelineState* pipeline_ = nullptr;
 	ID3D12RootSignature* rootSignature_ = nullptr;
-	ID3D12DescriptorHeap* descriptorHeap_ = nullptr;
-	ID3D12Fence* fence_ = nullptr;
-	UINT64 fenceValue_ = 0;
 }
 
-struct IDs {
-	float grpId;
-	float grpThrdId;
-	float dsptThrdId;
-	unsigned int grpIdx;
-};
-
-//CPUŊǗUAVf[^
-std::vector<IDs> uavdata(2*2*2*4 * 4 * 4);//eXgUAVf[^
-
-/// <summary>
-/// UAV݃obt@쐬(ŏIo͐)
-/// </summary>
-/// <param name="dev">foCXIuWFNg</param>
-/// <param name="res">vZ\[X(Ԃlp)</param>
-/// <returns>result</returns>
-HRESULT CreateUAVBuffer(ID3D12Device* dev,ID3D12Resource*& res) {
-	HRESULT result= S_OK;
-	D3D12_HEAP_PROPERTIES heapProp = {};
-	heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
-	D3D12_RESOURCE_DESC resDesc = {};
-	
-	//vZʂސ̃obt@쐬
-	resDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-	resDesc.Format = DXGI_FORMAT_UNKNOWN;
-	resDesc.Width = sizeof(uavdata[0]) * uavdata.size();//vZʏݐ̃TCYvZ
-	resDesc.DepthOrArraySize = 1;
-	resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-	resDesc.Height = 1;
-	resDesc.MipLevels = 1;
-	resDesc.SampleDesc.Count = 1;
-	resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-	result = dev->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, 
-		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr,	IID_PPV_ARGS(&res));
-
-	assert(SUCCEEDED(result));
-	return result;
-}
-//CPŨf[^^ƍ킹KvB
-struct SimpleBuffer_t
-{
-	int		i;
-	float	f;
-};
-array<SimpleBuffer_t, 64> indata;
-
-
-/// <summary>
-/// ͗pSRVobt@쐬StructuredBuffer(ReadOnly)
-/// </summary>
-/// <param name="dev">foCXIuWFNg</param>
-/// <param name="res">̓\[X(ReadOnly)</param>
-/// <returns>result</returns>
-HRESULT
-CreateSRVBuffer(ID3D12Device* dev, ID3D12Resource*& res) {
-	HRESULT result = S_OK;
-	CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_UPLOAD);// = {};
-	D3D12_RESOURCE_DESC resDesc = {};
-	
-	//̓obt@쐬
-	resDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-	resDesc.Format = DXGI_FORMAT_UNKNOWN;
-	resDesc.Width = sizeof(indata[0]) * indata.size();//̓TCYvZ
-	resDesc.DepthOrArraySize = 1;
-	resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-	resDesc.Height = 1;
-	resDesc.MipLevels = 1;
-	resDesc.SampleDesc.Count = 1;
-	resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-	result = dev->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, 
-		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,	IID_PPV_ARGS(&res));
-
-	assert(SUCCEEDED(result));
-	return result;
-}
-
-/// <summary>
-/// UAV̓eCPU猩邽߂̃Rs[obt@쐬
-/// </summary>
-/// <param name="dev">foCXIuWFNg</param>
-/// <param name="res">Rs[惊\[X(Ԃlp)</param>
-/// <returns>result</returns>
-HRESULT CreateCopyBuffer(ID3D12Device* dev, ID3D12Resource*& res) {
-	HRESULT result = S_OK;
-	D3D12_HEAP_PROPERTIES heapProp = {};
-	heapProp.Type = D3D12_HEAP_TYPE_READBACK;
-	D3D12_RESOURCE_DESC resDesc = {};
-	resDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-	resDesc.Format = DXGI_FORMAT_UNKNOWN;
-	resDesc.Width = sizeof(uavdata[0]) * uavdata.size();//Rs[̃TCYvZ(UAVƓ)
-	resDesc.DepthOrArraySize = 1;
-	resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-	resDesc.Height = 1;
-	resDesc.MipLevels = 1;
-	resDesc.SampleDesc.Count = 1;
-	resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-	result = dev->CreateCommittedResource(&heapProp, 
-		D3D12_HEAP_FLAG_NONE, 
-		&resDesc, 
-		D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
-		IID_PPV_ARGS(&res));
-	assert(SUCCEEDED(result));
-	return result;
-}
+//IDs(ComputeShader.hlslBuffer_t)SimpleBuffer_tCpuCompute/FirstStepKernel.hŃCAEgm߂Ă
+constexpr size_t uavCount = 2 * 2 * 2 * 4 * 4 * 4;//Dispatch(2,2,2)~numthreads(4,4,4)
 
+constexpr size_t inCount = 64;
 
 /// <summary>
 /// fobOC[IH
@@ -209,13 +112,9 @@ ID3D12RootSignature* CreateRootSignatureForComputeShader()
 //㏈
 void Terminate()
 {
-	fence_->Release();
-	descriptorHeap_->Release();
 	rootSignature_->Release();
 	pipeline_->Release();
 	cmdQue_->Release();
-	cmdList_->Release();
-	cmdAlloc_->Release();
 	dev_->Release();
 }
 
@@ -248,54 +147,94 @@ void CreateComputePipeline()
 	assert(SUCCEEDED(result));
 }
 
-void CreateUAVDescriptorHeap()
+/// <summary>
+/// ScanCS.hlsl̃XLƃRpNVGPUŎsACpuCompute/ScaňʂƔׂ
+/// </summary>
+/// <returns>Svtrue</returns>
+bool CheckScan()
 {
-	HRESULT result = S_OK;
-	D3D12_DESCRIPTOR_HEAP_DESC descHeapDesc = {};
-	descHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	descHeapDesc.NodeMask = 0;
-	descHeapDesc.NumDescriptors = 2;//UAV,SRV
-	descHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	result = dev_->CreateDescriptorHeap(&descHeapDesc, IID_PPV_ARGS(&descriptorHeap_));
-	assert(SUCCEEDED(result));
-}
-
-void
-CreateUAV(ID3D12Resource* res) {
-	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-	uavDesc.Format = DXGI_FORMAT_UNKNOWN;
-	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;//obt@Ƃ
-	uavDesc.Buffer.NumElements = uavdata.size();//vf̑
-	uavDesc.Buffer.StructureByteStride = sizeof(uavdata[0]);//1̑傫
-	uavDesc.Buffer.FirstElement = 0;
-	uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
-	dev_->CreateUnorderedAccessView(res, nullptr, &uavDesc, descriptorHeap_->GetCPUDescriptorHandleForHeapStart());
-}
+	//look-back^C܂AŌ̃^C[ɂȂ悤TILE_SIZE(1024)̔{炸炷
+	constexpr size_t scanCount = 1000 * 1000 + 7;
+	D3D12ScanRunner scan(dev_, cmdQue_);
+	auto& executor = ComputeExecutor::Instance();
+	std::mt19937 mt(1);
+	std::uniform_int_distribution<uint32_t> distu(0, 1000);
+	std::uniform_real_distribution<float> distf(0.0f, 1.0f);
+	bool allOk = true;
+
+	std::vector<uint32_t> values(scanCount), gpu(scanCount), cpu(scanCount);
+	for (auto& v : values) {
+		v = distu(mt);
+	}
+	for (bool inclusive : { false, true }) {
+		scan.Scan(values.data(), gpu.data(), scanCount, inclusive);
+		if (inclusive) {
+			InclusiveScan(values.data(), cpu.data(), scanCount, &executor);
+		}
+		else {
+			ExclusiveScan(values.data(), cpu.data(), scanCount, &executor);
+		}
+		auto ok = gpu == cpu;
+		cout << (inclusive ? "InclusiveScan " : "ExclusiveScan ") << (ok ? "OK" : "MISMATCH") << endl;
+		allOk &= ok;
+	}
 
-void
-CreateSRV(ID3D12Resource* res) {
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;//obt@Ƃ
-	srvDesc.Buffer.NumElements =indata.size();//vf̑
-	srvDesc.Buffer.StructureByteStride = sizeof(indata[0]);//1̑傫
-	srvDesc.Buffer.FirstElement = 0;
-	srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	auto handle=descriptorHeap_->GetCPUDescriptorHandleForHeapStart();
-	handle.ptr += dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	dev_->CreateShaderResourceView(res,  &srvDesc, handle);
+	std::vector<SimpleBuffer_t> records(scanCount), gpuKept(scanCount), cpuKept(scanCount);
+	for (auto& r : records) {
+		r.i = static_cast<int>(distu(mt));
+		r.f = distf(mt);
+	}
+	constexpr float threshold = 0.5f;
+	auto gpuCount = scan.Compact(records.data(), scanCount, threshold, gpuKept.data());
+	auto cpuCount = Compact(records.data(), scanCount, cpuKept.data(),
+		[threshold](const SimpleBuffer_t& r) { return r.f > threshold; }, &executor);
+	auto ok = gpuCount == cpuCount &&
+		std::equal(gpuKept.begin(), gpuKept.begin() + gpuCount, cpuKept.begin(),
+			[](const SimpleBuffer_t& a, const SimpleBuffer_t& b) { return a.i == b.i && a.f == b.f; });
+	cout << "Compact " << gpuCount << "/" << scanCount << " " << (ok ? "OK" : "MISMATCH") << endl;
+	allOk &= ok;
+	return allOk;
 }
 
-void ExecuteAndWait()
+/// <summary>
+/// RadixSortCS.hlsl̊\[gGPUŎsACpuCompute/RadixSorťʂƔׂ
+/// </summary>
+/// <returns>Svtrue</returns>
+bool CheckRadixSort()
 {
-	ID3D12CommandList* cmdLists[] = { cmdList_ };
-	cmdQue_->ExecuteCommandLists(1, cmdLists);
-	cmdQue_->Signal(fence_, ++fenceValue_);
-	//҂
-	while (fence_->GetCompletedValue() < fenceValue_) {
-		;
+	//CheckScanƓŌ̃^C[ɂȂ鐔ɂ
+	constexpr size_t sortCount = 1000 * 1000 + 7;
+	D3D12ScanRunner sorter(dev_, cmdQue_);
+	RadixSorter cpuSorter;
+	auto& executor = ComputeExecutor::Instance();
+	std::mt19937 mt(2);
+	//̒lƁAL[xo鋷͈͂āA̕ϊƈ萫m߂
+	std::uniform_int_distribution<int> disti(-100000, 100000);
+	std::uniform_real_distribution<float> distf(-1000.0f, 1000.0f);
+	std::vector<SimpleBuffer_t> records(sortCount);
+	for (size_t n = 0; n < sortCount; ++n) {
+		records[n].i = n % 2 == 0 ? disti(mt) : disti(mt) % 16;
+		records[n].f = n % 3 == 0 ? static_cast<float>(records[n].i % 8) : distf(mt);
 	}
+	auto same = [](const SimpleBuffer_t& a, const SimpleBuffer_t& b) { return a.i == b.i && a.f == b.f; };
+	bool allOk = true;
+
+	auto gpu = records;
+	auto cpu = records;
+	sorter.SortRecords(gpu.data(), sortCount, &SimpleBuffer_t::i);
+	cpuSorter.SortRecords(cpu.data(), sortCount, &SimpleBuffer_t::i, &executor);
+	auto ok = std::equal(gpu.begin(), gpu.end(), cpu.begin(), same);
+	cout << "RadixSort by i " << (ok ? "OK" : "MISMATCH") << endl;
+	allOk &= ok;
+
+	gpu = records;
+	cpu = records;
+	sorter.SortRecords(gpu.data(), sortCount, &SimpleBuffer_t::f);
+	cpuSorter.SortRecords(cpu.data(), sortCount, &SimpleBuffer_t::f, &executor);
+	ok = std::equal(gpu.begin(), gpu.end(), cpu.begin(), same);
+	cout << "RadixSort by f " << (ok ? "OK" : "MISMATCH") << endl;
+	allOk &= ok;
+	return allOk;
 }
 
 int main() {
@@ -308,7 +247,6 @@ int main() {
 
 	rootSignature_ = CreateRootSignatureForComputeShader();
 	CreateComputePipeline();	
-	CreateUAVDescriptorHeap();
 
 	D3D12_COMMAND_QUEUE_DESC queDesc = {};
 	queDesc.NodeMask = 0;
@@ -316,77 +254,30 @@ int main() {
 	queDesc.Priority = 0;
 	queDesc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
 	dev_->CreateCommandQueue(&queDesc, IID_PPV_ARGS(&cmdQue_));
-	
-	//R}hAP[^쐬
-	result = dev_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&cmdAlloc_));
-	assert(SUCCEEDED(result));
-	//R}hXg쐬
-	result = dev_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, cmdAlloc_, pipeline_, IID_PPV_ARGS(&cmdList_));
 
-	assert(SUCCEEDED(result));
-	ID3D12Resource* uavBuffer = nullptr;
-	result = CreateUAVBuffer(dev_, uavBuffer);
-	CreateUAV(uavBuffer);
+	//t0UAVu0Wu(obt@Ar[AR}hXgAtFX͂̒)
+	std::vector<IDs> uavdata;
+	{
+		D3D12ComputeJob<SimpleBuffer_t, IDs> job(dev_, cmdQue_, pipeline_, rootSignature_);
+		job.Resize(inCount, uavCount);
+
+		std::random_device seed;
+		std::mt19937 mt(seed());
+		std::uniform_real_distribution<float> distf(0.0, 1.0);
+		std::uniform_int_distribution<unsigned int> disti(1,600);
+		//Map܂܂̃Abv[hobt@ɒڏ
+		auto indata = job.Input();
+		for (size_t i = 0; i < job.InputCount(); ++i) {
+			indata[i].f = distf(mt);
+			indata[i].i = disti(mt);
+		}
 
-	ID3D12Resource* inBuffer = nullptr;
-	result = CreateSRVBuffer(dev_, inBuffer);
-	CreateSRV(inBuffer);
+		job.Run(2, 2, 2);//fBXpb`ă[hobN܂ő҂
 
-	std::random_device seed;
-	std::mt19937 mt(seed());
-	std::uniform_real_distribution<float> distf(0.0, 1.0);
-	std::uniform_int_distribution<unsigned int> disti(1,600);
-	for (auto& d : indata) {
-		d.f = distf(mt);
-		d.i = disti(mt);
+		uavdata.assign(job.Output(), job.Output() + job.OutputCount());
 	}
-	SimpleBuffer_t* cbuff = nullptr;
-	inBuffer->Map(0, nullptr, (void**)&cbuff);
-	copy(indata.begin(), indata.end(), cbuff);
-	inBuffer->Unmap(0,nullptr);
-
-	cmdList_->SetComputeRootSignature(rootSignature_);//[gVOl`Zbg
-	ID3D12DescriptorHeap* descHeaps[] = { descriptorHeap_ };
-	cmdList_->SetDescriptorHeaps(1, descHeaps);//fBXNv^q[ṽZbg
-	
-	//[gp[^̃Zbg
-	cmdList_->SetComputeRootDescriptorTable(0, 
-		descriptorHeap_->GetGPUDescriptorHandleForHeapStart()
-	);
-	cmdList_->Dispatch(2, 2, 2);//fBXpb`
-
-
-	ID3D12Resource* cpyBuffer = nullptr;
-	CreateCopyBuffer(dev_, cpyBuffer);
-
-
-	//oA
-	D3D12_RESOURCE_BARRIER barrier = {};
-	barrier.Transition.pResource = uavBuffer;
-	barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-	barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
-	barrier.Transition.Subresource = 0;
-	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	cmdList_->ResourceBarrier(1, &barrier);
-
-	cmdList_->CopyResource(cpyBuffer, uavBuffer);
-
-	cmdList_->Close();
-
-	dev_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
-	
-	ExecuteAndWait();
-
-	IDs* mappedRes = nullptr;
-	D3D12_RANGE rng = {};
-	rng.Begin = 0;
-	rng.End = uavdata.size() * sizeof(float);
-	cpyBuffer->Map(0, &rng, (void**)(&mappedRes));
-	copy_n(mappedRes,  uavdata.size(), uavdata.data());
-	cpyBuffer->Unmap(0, nullptr);
-
-	uavBuffer->Release();
-	cpyBuffer->Release();
+	auto scanOk = CheckScan();
+	scanOk &= CheckRadixSort();
 	Terminate();
 
 	for (auto& d : uavdata) {
@@ -395,6 +286,5 @@ int main() {
 		cout << "dispatchThreadId="<< d.dsptThrdId << endl;
 		//cout << "groupIndex=" << d.grpIdx << endl;
 	}
-	return 0;
+	return scanOk ? 0 : 1;
 }
-
@@ -2,6 +2,8 @@
 #include"Dx12Wrapper.h"
 #include"PMDRenderer.h"
 #include"PMDActor.h"
+#include<shellapi.h>
+#pragma comment(lib,"shell32.lib")
 
 //EBhE萔
 const unsigned int window_width = 1280;
@@ -30,7 +32,7 @@ Application::CreateGameWindow(HWND &hwnd, WNDCLASSEX &windowClass) {
 	AdjustWindowRect(&wrc, WS_OVERLAPPEDWINDOW, false);//EBhẼTCY͂Ɩʓ|Ȃ̂Ŋ֐gĕ␳
 	//EBhEIuWFNg̐
 	hwnd = CreateWindow(windowClass.lpszClassName,//NXw
-		_T("CS|XgGtFNg"),//^Cgo[̕
+		_hdr ? _T("CS|XgGtFNg(HDR)") : _T("CS|XgGtFNg"),//^Cgo[̕
 		WS_OVERLAPPEDWINDOW,//^Cgo[ƋEEBhEł
 		CW_USEDEFAULT,//\XWOSɂC܂
 		CW_USEDEFAULT,//\YWOSɂC܂
@@ -43,6 +45,21 @@ Application::CreateGameWindow(HWND &hwnd, WNDCLASSEX &windowClass) {
 
 }
 
+bool
+Application::HasCommandLineOption(const wchar_t* option) {
+	int argc = 0;
+	auto argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	if (argv == nullptr) {
+		return false;
+	}
+	bool found = false;
+	for (int i = 1; i < argc && !found; ++i) {
+		found = _wcsicmp(argv[i], option) == 0;
+	}
+	LocalFree(argv);
+	return found;
+}
+
 SIZE
 Application::GetWindowSize()const {
 	SIZE ret;
@@ -94,10 +111,18 @@ Application::Run() {
 bool 
 Application::Init() {
 	auto result = CoInitializeEx(0, COINIT_MULTITHREADED);
+	//--hdrŋNHDR̃ItXN[ŕ`(f8bit̂Ƃƌׂ悤)
+	_hdr = HasCommandLineOption(L"--hdr");
+	//--sepiaȂ烂mN̑ɃZsA(F̕ϊ3D LUTɏĂColorLutCSň)
+	_sepia = HasCommandLineOption(L"--sepia");
 	CreateGameWindow(_hwnd, _windowClass);
 
 	//DirectX12bp[
-	_dx12.reset(new Dx12Wrapper(_hwnd));
+	_dx12.reset(new Dx12Wrapper(_hwnd, _hdr, _sepia));
+	//LUT̃pXCPUł̍ColorLut.h̏ȓAŏ̃t[OɊm߂
+	if (!_dx12->CheckColorLut()) {
+		return false;
+	}
 	_pmdRenderer.reset(new PMDRenderer(*_dx12));
 	_pmdActor.reset(new PMDActor("Model/bodyeater.pmd", *_pmdRenderer));
 
@@ -26,10 +26,15 @@ private:
 	std::shared_ptr<Dx12Wrapper> _dx12;
 	std::shared_ptr<PMDRenderer> _pmdRenderer;
 	std::shared_ptr<PMDActor> _pmdActor;
+	bool _hdr = false;//R}hC--hdrHDR̃ItXN[(Ioƃg[}bv)ŕ`
+	bool _sepia = false;//R}hC--sepia΃mN̑ɃZsAɂ(HDRłȂƂ)
 
 	//Q[pEBhE̐
 	void CreateGameWindow(HWND &hwnd, WNDCLASSEX &windowClass);
 
+	//R}hCoption邩(mainłWinMainł悤ɓǂ߂悤GetCommandLineW璲ׂ)
+	static bool HasCommandLineOption(const wchar_t* option);
+
 	//VOĝ߂ɃRXgN^private
 	//ɃRs[Ƒ֎~
 	Application();
@@ -15,12 +15,19 @@ cbuffer Material : register(b2) {
 	float4 diffuse;//fBt[YF
 	float4 specular;//XyL
 	float3 ambient;//ArGg
+	float edge;//֊s`(}eAedgeFlg)
 };
 
 
 
 
-float4 BasicPS(BasicType input ) : SV_TARGET{
+//o(2ڂ͗֊sp̃WIg摜BCpuCompute/Outline.hlsliQ)
+struct PixelOutput {
+	float4 color:SV_TARGET0;//F
+	float4 geometry:SV_TARGET1;//r[Ԃ̖@xyAr[Ԃ̐[xAedgeFlg
+};
+
+PixelOutput BasicPS(BasicType input ) {
 	float3 light = normalize(float3(1,-1,1));//̌xNg(s)
 	float3 lightColor = float3(1,1,1);//Cg̃J[(1,1,1Ő^)
 
@@ -38,11 +45,14 @@ float4 BasicPS(BasicType input ) : SV_TARGET{
 
 	float4 texColor = tex.Sample(smp, input.uv); //eNX`J[
 
-	return saturate(toonDif//Px(gD[)
+	PixelOutput output;
+	output.color = saturate(toonDif//Px(gD[)
 		* diffuse//fBt[YF
 		*texColor//eNX`J[
 		*sph.Sample(smp, sphereMapUV))//XtBA}bv(Z)
 		+ saturate(spa.Sample(smp, sphereMapUV)*texColor//XtBA}bv(Z)
 		+ float4(specularB *specular.rgb, 1))//XyL[
 		+ float4(texColor*ambient*0.5,1);//ArGg(邭Ȃ肷̂0.5ɂĂ܂)
+	output.geometry = float4(normalize(input.vnormal.xyz).xy, input.pos.z, edge);
+	return output;
 }
\ No newline at end of file
@@ -23,6 +23,7 @@ cbuffer Material : register(b2) {
 	float4 diffuse;//fBt[YF
 	float4 specular;//XyL
 	float3 ambient;//ArGg
+	float edge;//֊s`(}eAedgeFlg)
 };
 
 
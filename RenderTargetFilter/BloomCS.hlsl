@@ -0,0 +1,114 @@
+//u[(CpuCompute/Bloom.h)̃Rs[gVF[_Bỉ摜͏c1/2R16G16B16A16_FLOAT
+//  BloomDownsampleCS : srcImgdstImg(1/2)B13^bvŏk(prefilterȂ炵l)B
+//                      1O[vTILE~TILEf󂯎Aǂޓ͂(2*TILE+4)lgroupshared1񂾂ǂ
+//  BloomUpsampleCS   : dstImg += egŊg債srcImg(dstImg1/2)B΂񏬂i珇ɑ傫i
+//  BloomCompositeCS  : dstImg = srcImg + intensity * egŊg債bloomImg(0i)
+//́0iځ1iځcƏkAc1iځ0iڂƊg債đĂȀDispatch
+//O[v͂ǂ(dstSize8ŊĐ؂グ)B摜̊O͒[̉fJԂ
+//lƏd݂Bloom.hlsliCPU(CpuCompute/Bloom.cpp)ƋLĂ
+Texture2D<float4> srcImg : register(t0);
+Texture2D<float4> bloomImg : register(t1);
+RWTexture2D<float4> dstImg : register(u0);
+
+//[g萔CPUn
+cbuffer BloomInfo : register(b0)
+{
+    uint2 srcSize;//k̓́Agœǂޏi(BloomCompositeCSbloomImg)̑傫
+    uint2 dstSize;
+    float threshold;
+    float knee;
+    float intensity;//BloomCompositeCŜ
+    uint prefilter;//BloomDownsampleCŜ(1Ȃ炵l)
+};
+
+#include"../CpuCompute/Bloom.hlsli"
+
+#define TILE 8
+#define SRC_TILE (2 * TILE + 4)
+
+groupshared float4 sharedSrc[SRC_TILE * SRC_TILE];
+
+float4 LoadClamped(Texture2D<float4> img, int2 pos, uint2 size)
+{
+    return img[clamp(pos, 0, (int2)size - 1)];
+}
+
+[numthreads(TILE, TILE, 1)]
+void BloomDownsampleCS(uint3 gid : SV_GroupID, uint3 gtid : SV_GroupThreadID, uint gi : SV_GroupIndex)
+{
+    //o͂̉fx͓͂2x-2`2x+3ǂ
+    int2 origin = int2(gid.xy * (2 * TILE)) - 2;
+    for (uint i = gi; i < SRC_TILE * SRC_TILE; i += TILE * TILE)
+    {
+        sharedSrc[i] = LoadClamped(srcImg, origin + int2(i % SRC_TILE, i / SRC_TILE), srcSize);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 pos = gid.xy * TILE + gtid.xy;
+    if (any(pos >= dstSize))
+    {
+        return;
+    }
+    float4 outerSum = 0.0f;
+    float4 innerSum = 0.0f;
+    for (uint j = 0; j < BLOOM_DOWN_TAPS; ++j)
+    {
+        float4 outerRow = 0.0f;
+        float4 innerRow = 0.0f;
+        for (uint k = 0; k < BLOOM_DOWN_TAPS; ++k)
+        {
+            float4 c = sharedSrc[(2 * gtid.y + j) * SRC_TILE + 2 * gtid.x + k];
+            outerRow += bloomOuterWeights[k] * c;
+            innerRow += bloomInnerWeights[k] * c;
+        }
+        outerSum += bloomOuterWeights[j] * outerRow;
+        innerSum += bloomInnerWeights[j] * innerRow;
+    }
+    float4 c = (outerSum + innerSum) * 0.5f;
+    if (prefilter)
+    {
+        c.rgb = BloomThreshold(c.rgb, threshold, knee);
+    }
+    dstImg[pos] = c;
+}
+
+//iegŊg債A傫ỉfpos̒l
+float4 BloomTent(Texture2D<float4> small, int2 pos, uint2 smallSize)
+{
+    int2 start = int2(BloomUpStart(pos.x), BloomUpStart(pos.y));
+    float4 sum = 0.0f;
+    for (uint j = 0; j < BLOOM_UP_TAPS; ++j)
+    {
+        float4 row = 0.0f;
+        for (uint k = 0; k < BLOOM_UP_TAPS; ++k)
+        {
+            row += bloomUpWeights[pos.x & 1][k] * LoadClamped(small, start + int2(k, j), smallSize);
+        }
+        sum += bloomUpWeights[pos.y & 1][j] * row;
+    }
+    return sum;
+}
+
+[numthreads(8, 8, 1)]
+void BloomUpsampleCS(uint3 dtid : SV_DispatchThreadID)
+{
+    if (any(dtid.xy >= dstSize))
+    {
+        return;
+    }
+    float4 c = dstImg[dtid.xy];
+    c.rgb += BloomTent(srcImg, (int2)dtid.xy, srcSize).rgb;
+    dstImg[dtid.xy] = c;
+}
+
+[numthreads(8, 8, 1)]
+void BloomCompositeCS(uint3 dtid : SV_DispatchThreadID)
+{
+    if (any(dtid.xy >= dstSize))
+    {
+        return;
+    }
+    float4 c = srcImg[dtid.xy];
+    c.rgb += intensity * BloomTent(bloomImg, (int2)dtid.xy, srcSize).rgb;
+    dstImg[dtid.xy] = c;
+}
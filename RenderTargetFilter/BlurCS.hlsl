@@ -0,0 +1,104 @@
+//KEVAڂ(cɕ2pX)̃Rs[gVF[_
+//  GaussianBlurHCS : B1O[v1sTILE_SIZEf󂯎A
+//                    Eradiusf̂͂ݏo(halo)groupshared1񂾂ǂłݍ
+//  GaussianBlurVCS : cB1O[vCOLUMNS~TILE_ROWSs󂯎A㉺̂͂ݏogroupsharedɓǂ
+//HCSsrcImgԃeNX`AVCSŒԃeNX`dstImg̏Dispatch
+//(ԃeNX`floatɂĂƃpX̊ԂŊۂ߂ɍςށBCPUł͒ԂfloatŎ)
+//O[v͂ǂ[numthreads]ŊĐ؂グ(PlanDispatch)B摜̊O͒[̉fJԂ
+//d݂GaussianBlur.hlsliCPU(CpuCompute/GaussianBlur.cpp)ƋLĂ
+Texture2D<float4> srcImg : register(t0);
+RWTexture2D<float4> dstImg : register(u0);
+
+//[g萔CPUn
+cbuffer BlurInfo : register(b0)
+{
+    uint2 imageSize;
+    uint radius;//1`MAX_RADIUS
+    float sigma;//W΍(CPUł̊radius/2)
+};
+
+#include"../CpuCompute/GaussianBlur.hlsli"
+
+#define MAX_RADIUS 64
+#define TILE_SIZE 256
+#define COLUMNS 8
+#define TILE_ROWS 64
+
+groupshared float sharedWeights[MAX_RADIUS + 1];
+groupshared float4 sharedRow[TILE_SIZE + 2 * MAX_RADIUS];
+groupshared float4 sharedColumns[(TILE_ROWS + 2 * MAX_RADIUS) * COLUMNS];
+
+//Kd(S0`radius)sharedWeightsɒu
+//O[v̑SXbhĂԂ(ǂނ͎̂̃oǍ)
+void LoadWeights(uint gi)
+{
+    if (gi <= radius)
+    {
+        sharedWeights[gi] = GaussianWeight((float)gi, sigma);
+    }
+    GroupMemoryBarrierWithGroupSync();
+    float total = sharedWeights[0];
+    for (uint k = 1; k <= radius; ++k)
+    {
+        total += 2.0f * sharedWeights[k];
+    }
+    GroupMemoryBarrierWithGroupSync();
+    if (gi <= radius)
+    {
+        sharedWeights[gi] /= total;
+    }
+}
+
+[numthreads(TILE_SIZE, 1, 1)]
+void GaussianBlurHCS(uint3 gid : SV_GroupID, uint gi : SV_GroupIndex)
+{
+    LoadWeights(gi);
+    int y = min(gid.y, imageSize.y - 1);
+    int left = (int)(gid.x * TILE_SIZE) - (int)radius;
+    //^CƍÊ͂ݏoǂ(Xbh葽2ڂœǂ)
+    for (uint i = gi; i < TILE_SIZE + 2 * radius; i += TILE_SIZE)
+    {
+        int x = clamp(left + (int)i, 0, (int)imageSize.x - 1);
+        sharedRow[i] = srcImg[int2(x, y)];
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 pos = uint2(gid.x * TILE_SIZE + gi, gid.y);
+    //O[v͐؂グĂ̂ŁA͂ݏoXbh͉Ȃ
+    if (all(pos < imageSize))
+    {
+        uint center = gi + radius;
+        float4 sum = sharedWeights[0] * sharedRow[center];
+        for (uint k = 1; k <= radius; ++k)
+        {
+            sum += sharedWeights[k] * (sharedRow[center - k] + sharedRow[center + k]);
+        }
+        dstImg[pos] = sum;
+    }
+}
+
+[numthreads(COLUMNS, TILE_ROWS, 1)]
+void GaussianBlurVCS(uint3 gid : SV_GroupID, uint3 gtid : SV_GroupThreadID, uint gi : SV_GroupIndex)
+{
+    LoadWeights(gi);
+    int x = min(gid.x * COLUMNS + gtid.x, imageSize.x - 1);
+    int top = (int)(gid.y * TILE_ROWS) - (int)radius;
+    for (uint i = gtid.y; i < TILE_ROWS + 2 * radius; i += TILE_ROWS)
+    {
+        int y = clamp(top + (int)i, 0, (int)imageSize.y - 1);
+        sharedColumns[i * COLUMNS + gtid.x] = srcImg[int2(x, y)];
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 pos = gid.xy * uint2(COLUMNS, TILE_ROWS) + gtid.xy;
+    if (all(pos < imageSize))
+    {
+        uint center = gtid.y + radius;
+        float4 sum = sharedWeights[0] * sharedColumns[center * COLUMNS + gtid.x];
+        for (uint k = 1; k <= radius; ++k)
+        {
+            sum += sharedWeights[k] * (sharedColumns[(center - k) * COLUMNS + gtid.x] + sharedColumns[(center + k) * COLUMNS + gtid.x]);
+        }
+        dstImg[pos] = sum;
+    }
+}
@@ -0,0 +1,147 @@
+//ae[u(summed-area table)ɂ锠^tB^E̕ςƕŨRs[gVF[_
+//  SatRowsCS     : 1O[v1s󂯎A256fɗݐς(O[vŗݐςāAO256f܂ł̘a𑫂)
+//  SatColumnsCS  : 1Xbh1󂯎A̗ݐςcɑĂ
+//  BoxMeanCS     : e[u4̍(2*radius+1)l̑̕ς߂BfƂ̎Ԃ͔aɂȂ
+//  BoxVarianceCS : ãe[ugĕςƕU߂
+//SatRowsCS(O[v1 x (+1))SatColumnsCSBoxMeanCSBoxVarianceCS̏Dispatch
+//e[u(+1)x(+1)R32G32B32A32_UINTŁA(x+1,y+1)(0,0)`(x,y)̉f̘aB0sڂ0ڂ0
+//R8G8B8A8̒l0`255̐ɂđ̂ŁAa2^32@ƂĉĂ̍͐m
+//(agU͔a127܂)B͉摜̒ɐ؂l߁AfŊ
+//ρEU̎BoxFilter.hlsliCPU(CpuCompute/BoxFilter.cpp)ƋLĂ
+Texture2D<float4> srcImg : register(t0);
+RWTexture2D<float4> dstImg : register(u0);
+RWTexture2D<uint4> satSums : register(u1);
+RWTexture2D<uint4> satSquares : register(u2);
+RWTexture2D<float4> varianceImg : register(u3);
+
+//[g萔CPUn
+cbuffer BoxInfo : register(b0)
+{
+    uint2 imageSize;
+    uint radius;
+};
+
+#include"../CpuCompute/BoxFilter.hlsli"
+
+#define ROW_THREADS 256
+
+groupshared uint4 sharedSums[ROW_THREADS];
+groupshared uint4 sharedSquares[ROW_THREADS];
+
+[numthreads(ROW_THREADS, 1, 1)]
+void SatRowsCS(uint3 gid : SV_GroupID, uint gi : SV_GroupIndex)
+{
+    uint row = gid.y;//e[u̍s(0sڂ0Ŗ߂)
+    if (row == 0)
+    {
+        for (uint x = gi; x <= imageSize.x; x += ROW_THREADS)
+        {
+            satSums[uint2(x, 0)] = 0;
+            satSquares[uint2(x, 0)] = 0;
+        }
+        return;
+    }
+    if (gi == 0)
+    {
+        satSums[uint2(0, row)] = 0;
+        satSquares[uint2(0, row)] = 0;
+    }
+    uint4 carrySum = 0;
+    uint4 carrySquare = 0;
+    for (uint left = 0; left < imageSize.x; left += ROW_THREADS)
+    {
+        uint x = left + gi;
+        //Texture2D<float4>̓ǂݏo0`255̐ɖ߂(CPUłR8G8B8A8̃oCĝ܂܎g)
+        uint4 v = x < imageSize.x ? (uint4)round(saturate(srcImg[uint2(x, row - 1)]) * 255.0f) : 0;
+        sharedSums[gi] = v;
+        sharedSquares[gi] = v * v;
+        GroupMemoryBarrierWithGroupSync();
+        //O[v̗ݐ(Hillis-Steele)
+        for (uint offset = 1; offset < ROW_THREADS; offset <<= 1)
+        {
+            uint4 s = sharedSums[gi];
+            uint4 q = sharedSquares[gi];
+            if (gi >= offset)
+            {
+                s += sharedSums[gi - offset];
+                q += sharedSquares[gi - offset];
+            }
+            GroupMemoryBarrierWithGroupSync();
+            sharedSums[gi] = s;
+            sharedSquares[gi] = q;
+            GroupMemoryBarrierWithGroupSync();
+        }
+        if (x < imageSize.x)
+        {
+            satSums[uint2(x + 1, row)] = carrySum + sharedSums[gi];
+            satSquares[uint2(x + 1, row)] = carrySquare + sharedSquares[gi];
+        }
+        carrySum += sharedSums[ROW_THREADS - 1];
+        carrySquare += sharedSquares[ROW_THREADS - 1];
+        //256fŏOɁASXbhǂݏÎ҂
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+[numthreads(64, 1, 1)]
+void SatColumnsCS(uint3 dtid : SV_DispatchThreadID)
+{
+    uint x = dtid.x + 1;
+    if (x > imageSize.x)
+    {
+        return;
+    }
+    uint4 sum = 0;
+    uint4 square = 0;
+    for (uint y = 1; y <= imageSize.y; ++y)
+    {
+        sum += satSums[uint2(x, y)];
+        square += satSquares[uint2(x, y)];
+        satSums[uint2(x, y)] = sum;
+        satSquares[uint2(x, y)] = square;
+    }
+}
+
+//̍ƉE+1̃e[üʒuƁAɓf
+void BoxWindow(uint2 pos, out uint2 lo, out uint2 hi, out uint count)
+{
+    lo = (uint2)max((int2)pos - (int)radius, 0);
+    hi = min(pos + radius, imageSize - 1) + 1;
+    count = (hi.x - lo.x) * (hi.y - lo.y);
+}
+
+uint4 BoxSum(RWTexture2D<uint4> table, uint2 lo, uint2 hi)
+{
+    return table[hi] - table[uint2(lo.x, hi.y)] - table[uint2(hi.x, lo.y)] + table[lo];
+}
+
+[numthreads(8, 8, 1)]
+void BoxMeanCS(uint3 dtid : SV_DispatchThreadID)
+{
+    uint2 pos = dtid.xy;
+    //O[v͐؂グĂ̂ŁA͂ݏoXbh͉Ȃ
+    if (any(pos >= imageSize))
+    {
+        return;
+    }
+    uint2 lo, hi;
+    uint count;
+    BoxWindow(pos, lo, hi, count);
+    dstImg[pos] = BoxMean8(BoxSum(satSums, lo, hi), count);
+}
+
+[numthreads(8, 8, 1)]
+void BoxVarianceCS(uint3 dtid : SV_DispatchThreadID)
+{
+    uint2 pos = dtid.xy;
+    if (any(pos >= imageSize))
+    {
+        return;
+    }
+    uint2 lo, hi;
+    uint count;
+    BoxWindow(pos, lo, hi, count);
+    uint4 sum = BoxSum(satSums, lo, hi);
+    dstImg[pos] = BoxMean8(sum, count);
+    varianceImg[pos] = BoxVariance8(sum, BoxSum(satSquares, lo, hi), count);
+}
@@ -0,0 +1,37 @@
+//_Ƃ̐F̕ϊĂ3D LUTRs[gVF[_
+//  ColorLutCS : srcImgdstImgB(imageSize8ŊĐ؂グ)̃O[vDispatch
+//lutCPU(CpuCompute/ColorLut.cpp)BakeColorLutColorLut::valueŝ܂
+//R32G32B32A32_FLOAT(܂R16G16B16A16_FLOAT)Texture3Dɂ(x=r, y=g, z=b)
+//Tv[3`Ԃł͂ȂAiq4_ǂގlʑ̕Ԃɂ(DF̎ŐFɂ܂ACPUłƓʂɂȂ)
+//ϊEVF[p[Elʑ̂̑IѕColorLut.hlsliCPUłƋLĂ
+Texture2D<float4> srcImg : register(t0);
+Texture3D<float4> lut : register(t1);
+RWTexture2D<float4> dstImg : register(u0);
+
+//[g萔CPUn
+cbuffer LutInfo : register(b0)
+{
+    uint2 imageSize;
+    uint lutSize;//iq1ӂ̓_̐
+    uint shaper;//LUT_SHAPER_`
+};
+
+#include"../CpuCompute/ColorLut.hlsli"
+
+[numthreads(8, 8, 1)]
+void ColorLutCS(uint3 dtid : SV_DispatchThreadID)
+{
+    if (any(dtid.xy >= imageSize))
+    {
+        return;
+    }
+    float4 c = srcImg[dtid.xy];
+    float3 u = float3(LutShape(c.r, shaper), LutShape(c.g, shaper), LutShape(c.b, shaper)) * (lutSize - 1);
+    uint3 i = min((uint3)u, lutSize - 2);
+    LutTetrahedron t = LutSelectTetrahedron(u - i);
+    float3 rgb = t.weights.x * lut[i].rgb
+        + t.weights.y * lut[i + t.corner1].rgb
+        + t.weights.z * lut[i + t.corner2].rgb
+        + t.weights.w * lut[i + 1].rgb;
+    dstImg[dtid.xy] = float4(rgb, c.a);
+}
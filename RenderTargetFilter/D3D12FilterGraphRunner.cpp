@@ -0,0 +1,1107 @@
+﻿#include "D3D12FilterGraphRunner.h"
+#include<cassert>
+#include<cstring>
+#include<algorithm>
+#include<d3dx12.h>
+#include<d3dcompiler.h>
+#include<d3d12shader.h>
+
+using namespace std;
+
+namespace {
+	constexpr UINT uavSlots = 4;
+	constexpr UINT srvSlots = 4;
+	constexpr UINT descriptorsPerDispatch = uavSlots + srvSlots;
+	constexpr UINT rootConstantCount = 52;//PostEffectCS.hlslのPostEffectInfo(ほかのシェーダはこの先頭だけを使う)
+	constexpr UINT maxBlurRadius = 64;//BlurCS.hlslのMAX_RADIUS
+	constexpr UINT maxRankRadius = 127;//MedianCS.hlslのMAX_RADIUS
+	constexpr UINT medianSegment = 64;//MedianCS.hlslのSEGMENT(RankHistogramCSの1グループが受け持つ画素数)
+	constexpr DXGI_FORMAT targetFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	constexpr DXGI_FORMAT scratchFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;//パスの中の中間はfloatのまま
+	constexpr DXGI_FORMAT satFormat = DXGI_FORMAT_R32G32B32A32_UINT;
+	constexpr DXGI_FORMAT lutFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;//ColorLut::valuesのfloat4のまま
+	constexpr UINT histogramBins = 256;//ReductionCS.hlslのヒストグラムの階級の数
+	constexpr UINT exposureStateCount = 3;//ToneMapCS.hlslのexposureState
+	//切り出した大きさごとのランナーをこれより多く持たない(1フレームでこれより多くの大きさが要るなら全体を処理する)
+	constexpr size_t maxRegionRunners = 16;
+
+	//切り出す範囲[c0,c1)を、長さがタイルの2のべき乗倍(画像より長ければ画像の長さ)になるように広げる
+	//画像からはみ出す分は内側にずらす。書き戻す範囲からの余白が増えるだけなので結果は変わらない
+	void BucketCrop(UINT tileSize, UINT size, UINT& c0, UINT& c1) {
+		UINT extent = tileSize;
+		while (extent < c1 - c0) {
+			extent *= 2;
+		}
+		extent = min(extent, size);
+		c0 = min(c0, size - extent);
+		c1 = c0 + extent;
+	}
+
+	//PostEffectCS.hlslのPostEffectInfoと同じ並び
+	struct PointwiseConstants {
+		uint32_t imageSize[2];
+		uint32_t opCount;
+		uint32_t extraCount;
+		uint32_t opCodes[filterMaxFusedOps];
+		uint32_t extraIndex[filterMaxFusedOps];
+		float params[filterMaxFusedOps][4];
+	};
+	static_assert(sizeof(PointwiseConstants) == rootConstantCount * sizeof(uint32_t), "PointwiseConstants must match PostEffectInfo");
+
+	uint32_t AsUint(float f) {
+		uint32_t u;
+		memcpy(&u, &f, sizeof(u));
+		return u;
+	}
+
+	void OutputFromErrorBlob(ID3DBlob* errBlob) {
+		if (errBlob != nullptr) {
+			OutputDebugStringA(static_cast<const char*>(errBlob->GetBufferPointer()));
+			errBlob->Release();
+		}
+	}
+}
+
+D3D12FilterGraphRunner::D3D12FilterGraphRunner(ID3D12Device* dev) :dev_(dev) {
+	rootSignature_.Attach(CreateRootSignature());
+}
+
+D3D12FilterGraphRunner::D3D12FilterGraphRunner(const D3D12FilterGraphRunner* parent) :
+	dev_(parent->dev_), rootSignature_(parent->rootSignature_), pipelines_(parent->pipelines_),
+	lutSize_(parent->lutSize_), lutShaper_(parent->lutShaper_), luts_(parent->luts_) {
+}
+
+D3D12FilterGraphRunner::~D3D12FilterGraphRunner() {
+	if (mappedHashes_ != nullptr) {
+		CD3DX12_RANGE written(0, 0);
+		hashReadback_->Unmap(0, &written);
+	}
+}
+
+ID3D12RootSignature*
+D3D12FilterGraphRunner::CreateRootSignature() {
+	D3D12_DESCRIPTOR_RANGE range[2] = {};
+	range[0].NumDescriptors = uavSlots;
+	range[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;//u0～u3
+	range[0].BaseShaderRegister = 0;
+	range[0].OffsetInDescriptorsFromTableStart = 0;
+	range[1].NumDescriptors = srvSlots;
+	range[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;//t0～t3
+	range[1].BaseShaderRegister = 0;
+	range[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+	D3D12_ROOT_PARAMETER rp[2] = {};
+	rp[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	rp[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	rp[0].DescriptorTable.NumDescriptorRanges = 2;
+	rp[0].DescriptorTable.pDescriptorRanges = range;
+	//画像サイズや半径などをルート定数で渡す(b0)
+	rp[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	rp[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	rp[1].Constants.ShaderRegister = 0;
+	rp[1].Constants.Num32BitValues = rootConstantCount;
+
+	D3D12_ROOT_SIGNATURE_DESC rootSigDesc = {};
+	rootSigDesc.NumParameters = 2;
+	rootSigDesc.pParameters = rp;
+	rootSigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+
+	ID3DBlob* rootSigBlob = nullptr;
+	ID3DBlob* errBlob = nullptr;
+	auto result = D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1_0, &rootSigBlob, &errBlob);
+	OutputFromErrorBlob(errBlob);
+	assert(SUCCEEDED(result));
+	ID3D12RootSignature* rootSignature = nullptr;
+	result = dev_->CreateRootSignature(0, rootSigBlob->GetBufferPointer(), rootSigBlob->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
+	rootSigBlob->Release();
+	assert(SUCCEEDED(result));
+	return rootSignature;
+}
+
+const D3D12FilterGraphRunner::Pipeline*
+D3D12FilterGraphRunner::GetPipeline(const wchar_t* file, const char* entry) {
+	string key(file, file + wcslen(file));
+	key += "|";
+	key += entry;
+	auto it = pipelines_.find(key);
+	if (it != pipelines_.end()) {
+		return &it->second;
+	}
+	ID3DBlob* csBlob = nullptr;
+	ID3DBlob* errBlob = nullptr;
+	auto result = D3DCompileFromFile(file, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, entry, "cs_5_1", 0, 0, &csBlob, &errBlob);
+	OutputFromErrorBlob(errBlob);
+	if (FAILED(result)) {
+		assert(0);
+		return nullptr;
+	}
+	Pipeline pipeline;
+	D3D12_COMPUTE_PIPELINE_STATE_DESC pldesc = {};
+	pldesc.CS.pShaderBytecode = csBlob->GetBufferPointer();
+	pldesc.CS.BytecodeLength = csBlob->GetBufferSize();
+	pldesc.pRootSignature = rootSignature_.Get();
+	result = dev_->CreateComputePipelineState(&pldesc, IID_PPV_ARGS(pipeline.state.ReleaseAndGetAddressOf()));
+	//Dispatchのグループ数を決めるため[numthreads]を調べておく
+	ID3D12ShaderReflection* reflection = nullptr;
+	if (SUCCEEDED(D3DReflect(csBlob->GetBufferPointer(), csBlob->GetBufferSize(), IID_PPV_ARGS(&reflection)))) {
+		reflection->GetThreadGroupSize(&pipeline.numThreads.x, &pipeline.numThreads.y, &pipeline.numThreads.z);
+		reflection->Release();
+	}
+	csBlob->Release();
+	if (FAILED(result)) {
+		assert(0);
+		return nullptr;
+	}
+	return &(pipelines_[key] = pipeline);
+}
+
+HRESULT
+D3D12FilterGraphRunner::CreateTexture(DXGI_FORMAT format, UINT width, UINT height, ComPtr<ID3D12Resource>& res) {
+	CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_DEFAULT);
+	auto resDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, width, height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	auto result = dev_->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr,
+		IID_PPV_ARGS(res.ReleaseAndGetAddressOf()));
+	if (SUCCEEDED(result)) {
+		states_[res.Get()] = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+	}
+	return result;
+}
+
+ID3D12Resource*
+D3D12FilterGraphRunner::GetScratch(DXGI_FORMAT format, UINT width, UINT height, UINT index) {
+	auto& res = scratch_[make_tuple(format, width, height, index)];
+	if (res == nullptr && FAILED(CreateTexture(format, width, height, res))) {
+		assert(0);
+		return nullptr;
+	}
+	return res.Get();
+}
+
+ID3D12Resource*
+D3D12FilterGraphRunner::CreateBuffer(UINT count) {
+	CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_DEFAULT);
+	auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(static_cast<UINT64>(count) * sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	ComPtr<ID3D12Resource> res;
+	//CommittedResourceは0で埋まった状態で作られる
+	auto result = dev_->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr,
+		IID_PPV_ARGS(res.ReleaseAndGetAddressOf()));
+	if (FAILED(result)) {
+		assert(0);
+		return nullptr;
+	}
+	buffers_.push_back(res);
+	return res.Get();
+}
+
+void
+D3D12FilterGraphRunner::AddDispatch(Dispatch dispatch) {
+	//前のDispatchが書いたものを読むので待つ(同じテクスチャをUAVのまま読むパスもある)
+	if (!dispatches_.empty()) {
+		dispatch.barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(nullptr));
+	}
+	auto require = [&](ID3D12Resource* res, D3D12_RESOURCE_STATES state) {
+		auto it = states_.find(res);
+		if (res == nullptr || it == states_.end() || it->second == state) {
+			return;//入力と出力は状態を変えない
+		}
+		dispatch.barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(res, it->second, state));
+		it->second = state;
+	};
+	for (auto res : dispatch.uavs) {
+		require(res, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+	for (auto res : dispatch.srvs) {
+		require(res, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	}
+	dispatches_.push_back(move(dispatch));
+}
+
+HRESULT
+D3D12FilterGraphRunner::AddPointwisePass(const FilterGraph& graph, const FilterPass& pass, ID3D12Resource* const* inputs, ID3D12Resource* out) {
+	auto pipeline = GetPipeline(L"PostEffectCS.hlsl", "PointwiseCS");
+	if (pipeline == nullptr) {
+		return E_FAIL;
+	}
+	assert(pass.nodes.size() <= filterMaxFusedOps && pass.inputs.size() <= 1 + filterMaxExtraInputs);
+	PointwiseConstants constants = {};
+	constants.imageSize[0] = pass.width;
+	constants.imageSize[1] = pass.height;
+	constants.opCount = static_cast<uint32_t>(pass.nodes.size());
+	constants.extraCount = static_cast<uint32_t>(pass.inputs.size()) - 1;
+	for (size_t k = 0; k < pass.nodes.size(); ++k) {
+		const auto& node = graph.Node(pass.nodes[k]);
+		constants.opCodes[k] = static_cast<uint32_t>(node.kind);
+		constants.extraIndex[k] = pass.extraIndex[k];
+		constants.params[k][0] = node.params.x;
+		constants.params[k][1] = node.params.y;
+		constants.params[k][2] = node.params.z;
+		constants.params[k][3] = node.params.w;
+	}
+	Dispatch dispatch;
+	dispatch.pipeline = pipeline->state.Get();
+	dispatch.uavs[0] = out;
+	for (size_t i = 0; i < pass.inputs.size(); ++i) {
+		dispatch.srvs[i] = inputs[i];
+	}
+	const auto* words = reinterpret_cast<const uint32_t*>(&constants);
+	dispatch.constants.assign(words, words + rootConstantCount);
+	dispatch.groups = PlanDispatch(pipeline->numThreads, pass.width, pass.height).groups;
+	AddDispatch(move(dispatch));
+	return S_OK;
+}
+
+HRESULT
+D3D12FilterGraphRunner::AddSpatialPass(const FilterGraph& graph, const FilterPass& pass, ID3D12Resource* const* inputs, ID3D12Resource* out) {
+	assert(pass.nodes.size() == 1);
+	const auto& node = graph.Node(pass.nodes[0]);
+	auto in = inputs[0];
+	const auto& inNode = graph.Node(node.inputs[0]);
+	const UINT width = node.width;
+	const UINT height = node.height;
+	const auto radius = static_cast<uint32_t>(node.params.x);
+	switch (node.kind) {
+	case FilterKind::GaussianBlur: {
+		//横→作業用→縦
+		assert(radius >= 1 && radius <= maxBlurRadius);
+		auto blurH = GetPipeline(L"BlurCS.hlsl", "GaussianBlurHCS");
+		auto blurV = GetPipeline(L"BlurCS.hlsl", "GaussianBlurVCS");
+		auto temp = GetScratch(scratchFormat, width, height, 0);
+		if (blurH == nullptr || blurV == nullptr || temp == nullptr) {
+			return E_FAIL;
+		}
+		Dispatch dispatch;
+		dispatch.constants = { width, height, radius, AsUint(node.params.y) };
+		dispatch.pipeline = blurH->state.Get();
+		dispatch.uavs[0] = temp;
+		dispatch.srvs[0] = in;
+		dispatch.groups = PlanDispatch(blurH->numThreads, width, height).groups;
+		AddDispatch(dispatch);
+		dispatch.pipeline = blurV->state.Get();
+		dispatch.uavs[0] = out;
+		dispatch.srvs[0] = temp;
+		dispatch.groups = PlanDispatch(blurV->numThreads, width, height).groups;
+		AddDispatch(move(dispatch));
+		return S_OK;
+	}
+	case FilterKind::BoxMean: {
+		//総和テーブルを横→縦に作ってから、窓の平均
+		auto satRows = GetPipeline(L"BoxFilterCS.hlsl", "SatRowsCS");
+		auto satColumns = GetPipeline(L"BoxFilterCS.hlsl", "SatColumnsCS");
+		auto boxMean = GetPipeline(L"BoxFilterCS.hlsl", "BoxMeanCS");
+		auto sums = GetScratch(satFormat, width + 1, height + 1, 0);
+		auto squares = GetScratch(satFormat, width + 1, height + 1, 1);
+		if (satRows == nullptr || satColumns == nullptr || boxMean == nullptr || sums == nullptr || squares == nullptr) {
+			return E_FAIL;
+		}
+		Dispatch dispatch;
+		dispatch.constants = { width, height, radius };
+		dispatch.uavs[1] = sums;
+		dispatch.uavs[2] = squares;
+		dispatch.pipeline = satRows->state.Get();
+		dispatch.srvs[0] = in;
+		dispatch.groups = { 1, height + 1, 1 };
+		AddDispatch(dispatch);
+		dispatch.pipeline = satColumns->state.Get();
+		dispatch.srvs[0] = nullptr;
+		dispatch.groups = PlanDispatch(satColumns->numThreads, width, 1).groups;
+		AddDispatch(dispatch);
+		dispatch.pipeline = boxMean->state.Get();
+		dispatch.uavs[0] = out;
+		dispatch.groups = PlanDispatch(boxMean->numThreads, width, height).groups;
+		AddDispatch(move(dispatch));
+		return S_OK;
+	}
+	case FilterKind::Median: {
+		//3x3と5x5はネットワーク、それより大きい窓はヒストグラム(値を8bitに丸める。CPU版と同じ)
+		assert(radius <= maxRankRadius);
+		const wchar_t* file = L"MedianCS.hlsl";
+		auto pipeline = GetPipeline(file, radius == 1 ? "Median3x3CS" : radius == 2 ? "Median5x5CS" : "RankHistogramCS");
+		if (pipeline == nullptr) {
+			return E_FAIL;
+		}
+		const uint32_t size = 2 * radius + 1;
+		Dispatch dispatch;
+		dispatch.pipeline = pipeline->state.Get();
+		dispatch.uavs[0] = out;
+		dispatch.srvs[0] = in;
+		dispatch.constants = { width, height, radius, size * size / 2 };
+		if (radius == 1 || radius == 2) {
+			dispatch.groups = PlanDispatch(pipeline->numThreads, width, height).groups;
+		}
+		else {
+			dispatch.groups = { (width + medianSegment - 1) / medianSegment, height, 1 };
+		}
+		AddDispatch(move(dispatch));
+		return S_OK;
+	}
+	case FilterKind::Resample: {
+		//横(srcImg→midImg)→縦(midImg→dstImg)。ターゲットはアルファが乗ったものとして扱う
+		auto resampleH = GetPipeline(L"ResampleCS.hlsl", "ResampleHCS");
+		auto resampleV = GetPipeline(L"ResampleCS.hlsl", "ResampleVCS");
+		auto mid = GetScratch(scratchFormat, width, inNode.height, 0);
+		if (resampleH == nullptr || resampleV == nullptr || mid == nullptr) {
+			return E_FAIL;
+		}
+		Dispatch dispatch;
+		dispatch.constants = { inNode.width, inNode.height, width, height, static_cast<uint32_t>(node.params.x), 0 };
+		dispatch.uavs[1] = mid;
+		dispatch.pipeline = resampleH->state.Get();
+		dispatch.srvs[0] = in;
+		dispatch.groups = PlanDispatch(resampleH->numThreads, width, inNode.height).groups;
+		AddDispatch(dispatch);
+		dispatch.pipeline = resampleV->state.Get();
+		dispatch.uavs[0] = out;
+		dispatch.srvs[0] = nullptr;
+		dispatch.groups = PlanDispatch(resampleV->numThreads, width, height).groups;
+		AddDispatch(move(dispatch));
+		return S_OK;
+	}
+	case FilterKind::Bloom: {
+		//入力→0段目→…と縮小し、…→0段目と拡大して足してから入力に合成する(段の画像は作業用として確保したものを使い回す)
+		const auto settings = BloomSettingsOf(node);
+		auto down = GetPipeline(L"BloomCS.hlsl", "BloomDownsampleCS");
+		auto up = GetPipeline(L"BloomCS.hlsl", "BloomUpsampleCS");
+		auto composite = GetPipeline(L"BloomCS.hlsl", "BloomCompositeCS");
+		if (down == nullptr || up == nullptr || composite == nullptr) {
+			return E_FAIL;
+		}
+		const auto levelCount = BloomLevelCount(width, height, settings.levels);
+		ID3D12Resource* levels[maxBloomLevels] = {};
+		UINT sizes[maxBloomLevels][2] = {};
+		for (UINT l = 0; l < levelCount; ++l) {
+			BloomLevelSize(width, height, l, sizes[l][0], sizes[l][1]);
+			levels[l] = GetScratch(targetFormat, sizes[l][0], sizes[l][1], 0);
+			if (levels[l] == nullptr) {
+				return E_FAIL;
+			}
+		}
+		auto bloomDispatch = [&](const Pipeline* pipeline, ID3D12Resource* src, UINT srcWidth, UINT srcHeight, ID3D12Resource* dst, UINT dstWidth, UINT dstHeight, uint32_t prefilter) {
+			Dispatch dispatch;
+			dispatch.pipeline = pipeline->state.Get();
+			dispatch.srvs[0] = src;
+			dispatch.uavs[0] = dst;
+			dispatch.constants = { srcWidth, srcHeight, dstWidth, dstHeight, AsUint(settings.threshold), AsUint(settings.knee), AsUint(settings.intensity), prefilter };
+			dispatch.groups = PlanDispatch(pipeline->numThreads, dstWidth, dstHeight).groups;
+			return dispatch;
+		};
+		AddDispatch(bloomDispatch(down, in, width, height, levels[0], sizes[0][0], sizes[0][1], 1));
+		for (UINT l = 1; l < levelCount; ++l) {
+			AddDispatch(bloomDispatch(down, levels[l - 1], sizes[l - 1][0], sizes[l - 1][1], levels[l], sizes[l][0], sizes[l][1], 0));
+		}
+		for (auto l = levelCount - 1; l-- > 0;) {
+			AddDispatch(bloomDispatch(up, levels[l + 1], sizes[l + 1][0], sizes[l + 1][1], levels[l], sizes[l][0], sizes[l][1], 0));
+		}
+		auto dispatch = bloomDispatch(composite, in, sizes[0][0], sizes[0][1], out, width, height, 0);
+		dispatch.srvs[1] = levels[0];
+		AddDispatch(move(dispatch));
+		return S_OK;
+	}
+	case FilterKind::ToneMap: {
+		//log2(輝度)のヒストグラム→露出をなじませる→トーンマップ(露出はバッファで渡すのでCPUは待たない)
+		const auto settings = ToneMapSettingsOf(node);
+		auto histogramCS = GetPipeline(L"ReductionCS.hlsl", "LumaHistogramCS");
+		auto exposureCS = GetPipeline(L"ToneMapCS.hlsl", "ExposureCS");
+		auto toneMapCS = GetPipeline(L"ToneMapCS.hlsl", "ToneMapCS");
+		auto histogram = CreateBuffer(histogramBins);
+		auto state = CreateBuffer(exposureStateCount);
+		if (histogramCS == nullptr || exposureCS == nullptr || toneMapCS == nullptr || histogram == nullptr || state == nullptr) {
+			return E_FAIL;
+		}
+		const auto range = ToneMapHistogramRange(settings);
+		Dispatch dispatch;
+		dispatch.pipeline = histogramCS->state.Get();
+		dispatch.srvs[0] = in;
+		dispatch.uavs[1] = histogram;
+		dispatch.constants = { width, height, AsUint(range.offset), AsUint(range.scale), 0, range.logScale };
+		dispatch.groups = PlanDispatch(histogramCS->numThreads, width, height).groups;
+		AddDispatch(dispatch);
+		//ToneMapCS.hlslのToneMapInfo(ToneMapSettingsと同じ並び)
+		dispatch.constants = { width, height, AsUint(settings.minLog2), AsUint(settings.maxLog2), AsUint(settings.lowPercent), AsUint(settings.highPercent),
+			AsUint(settings.exposureBias), AsUint(settings.adaptUp), AsUint(settings.adaptDown), AsUint(settings.whitePoint) };
+		dispatch.pipeline = exposureCS->state.Get();
+		dispatch.srvs[0] = nullptr;
+		dispatch.uavs[2] = state;
+		dispatch.groups = { 1, 1, 1 };
+		AddDispatch(dispatch);
+		dispatch.pipeline = toneMapCS->state.Get();
+		dispatch.srvs[0] = in;
+		dispatch.uavs[0] = out;
+		dispatch.uavs[1] = nullptr;
+		dispatch.groups = PlanDispatch(toneMapCS->numThreads, width, height).groups;
+		AddDispatch(move(dispatch));
+		return S_OK;
+	}
+	case FilterKind::Outline: {
+		if (geometry_ == nullptr || geometry_->GetDesc().Width != width || geometry_->GetDesc().Height != height) {
+			assert(0);
+			return E_INVALIDARG;
+		}
+		auto pipeline = GetPipeline(L"OutlineCS.hlsl", "OutlineCS");
+		if (pipeline == nullptr) {
+			return E_FAIL;
+		}
+		//OutlineCS.hlslのOutlineInfo
+		const auto settings = OutlineSettingsOf(node);
+		Dispatch dispatch;
+		dispatch.pipeline = pipeline->state.Get();
+		dispatch.srvs[0] = in;
+		dispatch.srvs[1] = geometry_;
+		dispatch.uavs[0] = out;
+		dispatch.constants = { AsUint(settings.color.x), AsUint(settings.color.y), AsUint(settings.color.z), AsUint(settings.color.w),
+			width, height, AsUint(settings.colorThreshold), AsUint(settings.depthThreshold), AsUint(settings.normalThreshold) };
+		dispatch.groups = PlanDispatch(pipeline->numThreads, width, height).groups;
+		AddDispatch(move(dispatch));
+		return S_OK;
+	}
+	case FilterKind::JointUpsample: {
+		//t0:縮小して処理した画像 t1:縮小した手がかり t2:手がかり t3:ジオメトリ画像(深度を使うときだけ)
+		const auto settings = JointUpsampleSettingsOf(node);
+		assert(pass.inputs.size() == 3 && settings.radius >= 1 && settings.radius <= maxJointUpsampleRadius);
+		const bool useDepth = settings.depthSigma > 0.0f;
+		if (useDepth && (geometry_ == nullptr || geometry_->GetDesc().Width != width || geometry_->GetDesc().Height != height)) {
+			assert(0);
+			return E_INVALIDARG;
+		}
+		auto pipeline = GetPipeline(L"JointUpsampleCS.hlsl", "JointUpsampleCS");
+		if (pipeline == nullptr) {
+			return E_FAIL;
+		}
+		//JointUpsampleCS.hlslのJointUpsampleInfo
+		Dispatch dispatch;
+		dispatch.pipeline = pipeline->state.Get();
+		dispatch.srvs[0] = in;
+		dispatch.srvs[1] = inputs[1];
+		dispatch.srvs[2] = inputs[2];
+		dispatch.srvs[3] = useDepth ? geometry_ : nullptr;
+		dispatch.uavs[0] = out;
+		dispatch.constants = { width, height, inNode.width, inNode.height, AsUint(settings.lumaSigma), AsUint(settings.depthSigma), settings.radius };
+		dispatch.groups = PlanDispatch(pipeline->numThreads, width, height).groups;
+		AddDispatch(move(dispatch));
+		return S_OK;
+	}
+	default:
+		assert(0);
+		return E_INVALIDARG;
+	}
+}
+
+bool
+D3D12FilterGraphRunner::BakesToColorLut(const FilterGraph& graph, const FilterPass& pass)const {
+	//処理が1つならPointwiseCSでも読み書きは1回で、LUTの誤差が増えるだけなので焼かない
+	//MonoはアルファをLUTが変えない1にし、Addは追加の入力を読むので焼けない
+	if (lutSize_ < 2 || pass.nodes.size() < 2 || pass.inputs.size() != 1) {
+		return false;
+	}
+	return all_of(pass.nodes.begin(), pass.nodes.end(), [&](FilterHandle handle) {
+		const auto kind = graph.Node(handle).kind;
+		return kind == FilterKind::Grayscale || kind == FilterKind::Gamma || kind == FilterKind::Contrast || kind == FilterKind::Tint;
+	});
+}
+
+HRESULT
+D3D12FilterGraphRunner::AddColorLutPass(const FilterGraph& graph, const FilterPass& pass, ID3D12Resource* in, ID3D12Resource* out) {
+	auto pipeline = GetPipeline(L"ColorLutCS.hlsl", "ColorLutCS");
+	if (pipeline == nullptr) {
+		return E_FAIL;
+	}
+	//PostEffect.hlsliのPointwiseOpと同じ変換(どちらもColorOps.hlsliの関数)を並べる
+	ColorTransform transform;
+	vector<float> key;
+	for (auto handle : pass.nodes) {
+		const auto& node = graph.Node(handle);
+		key.insert(key.end(), { static_cast<float>(node.kind), node.params.x, node.params.y, node.params.z, node.params.w });
+		switch (node.kind) {
+		case FilterKind::Grayscale:
+			transform.Grayscale();
+			break;
+		case FilterKind::Gamma:
+			transform.Gamma(node.params.x);
+			break;
+		case FilterKind::Contrast:
+			transform.Contrast(node.params.x);
+			break;
+		default:
+			transform.Tint(node.params.xyz);
+			break;
+		}
+	}
+	//同じ並び(切り出した大きさのグラフも同じノードを持つ)なら焼いたものを使い回す
+	auto& lut = luts_[key];
+	if (lut.texture == nullptr) {
+		auto result = CreateColorLut(transform, lut);
+		if (FAILED(result)) {
+			luts_.erase(key);
+			return result;
+		}
+	}
+	//ColorLutCS.hlslのLutInfo
+	Dispatch dispatch;
+	dispatch.pipeline = pipeline->state.Get();
+	dispatch.uavs[0] = out;
+	dispatch.srvs[0] = in;
+	dispatch.srvs[1] = lut.texture.Get();
+	dispatch.constants = { pass.width, pass.height, lutSize_, static_cast<uint32_t>(lutShaper_) };
+	dispatch.groups = PlanDispatch(pipeline->numThreads, pass.width, pass.height).groups;
+	AddDispatch(move(dispatch));
+	return S_OK;
+}
+
+HRESULT
+D3D12FilterGraphRunner::CreateColorLut(const ColorTransform& transform, ColorLutTexture& lut) {
+	const auto baked = BakeColorLut(transform, lutSize_, lutShaper_, nullptr);
+	CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_DEFAULT);
+	auto resDesc = CD3DX12_RESOURCE_DESC::Tex3D(lutFormat, lutSize_, lutSize_, static_cast<UINT16>(lutSize_), 1);
+	auto result = dev_->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+		IID_PPV_ARGS(lut.texture.ReleaseAndGetAddressOf()));
+	if (SUCCEEDED(result)) {
+		UINT64 uploadSize = 0;
+		dev_->GetCopyableFootprints(&resDesc, 0, 1, 0, &lut.footprint, nullptr, nullptr, &uploadSize);
+		CD3DX12_HEAP_PROPERTIES uploadProp(D3D12_HEAP_TYPE_UPLOAD);
+		auto uploadDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadSize);
+		result = dev_->CreateCommittedResource(&uploadProp, D3D12_HEAP_FLAG_NONE, &uploadDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+			IID_PPV_ARGS(lut.upload.ReleaseAndGetAddressOf()));
+	}
+	void* mapped = nullptr;
+	if (SUCCEEDED(result)) {
+		result = lut.upload->Map(0, nullptr, &mapped);
+	}
+	if (FAILED(result)) {
+		assert(0);
+		return result;
+	}
+	//valuesは[(b*size+g)*size+r]で、Texture3Dの(x,y,z)=(r,g,b)と同じ並び。行はRowPitch(256バイト境界)ごとに置く
+	const auto& footprint = lut.footprint.Footprint;
+	const size_t rowBytes = lutSize_ * sizeof(hlsl::float4);
+	auto base = static_cast<uint8_t*>(mapped) + lut.footprint.Offset;
+	for (UINT b = 0; b < lutSize_; ++b) {
+		for (UINT g = 0; g < lutSize_; ++g) {
+			memcpy(base + (static_cast<size_t>(b) * footprint.Height + g) * footprint.RowPitch, &baked.values[(static_cast<size_t>(b) * lutSize_ + g) * lutSize_], rowBytes);
+		}
+	}
+	lut.upload->Unmap(0, nullptr);
+	lut.uploaded = false;
+	return S_OK;
+}
+
+void
+D3D12FilterGraphRunner::RecordLutUploads(ID3D12GraphicsCommandList* cmdList) {
+	vector<D3D12_RESOURCE_BARRIER> toRead;
+	for (auto& entry : luts_) {
+		auto& lut = entry.second;
+		if (lut.uploaded) {
+			continue;
+		}
+		CD3DX12_TEXTURE_COPY_LOCATION dst(lut.texture.Get(), 0);
+		CD3DX12_TEXTURE_COPY_LOCATION src(lut.upload.Get(), lut.footprint);
+		cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+		toRead.push_back(CD3DX12_RESOURCE_BARRIER::Transition(lut.texture.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+		//UPLOADのバッファは次のBuildまで持っておく(GPUがまだ写しているかもしれないので)
+		lut.uploaded = true;
+	}
+	if (!toRead.empty()) {
+		cmdList->ResourceBarrier(static_cast<UINT>(toRead.size()), toRead.data());
+	}
+}
+
+HRESULT
+D3D12FilterGraphRunner::AddGraph(const FilterGraph& graph, ID3D12Resource* source, ID3D12Resource* output, const FilterCompileOptions& options) {
+	plan_ = graph.Compile(options);
+	targets_.clear();
+	buffers_.clear();
+	states_.clear();
+	for (auto& s : scratch_) {
+		states_[s.second.Get()] = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;//前のRecordの終わりで戻してある
+	}
+	dispatches_.clear();
+	finalBarriers_.clear();
+	auto srcDesc = source->GetDesc();
+	auto dstDesc = output->GetDesc();
+	const auto& sourceNode = graph.Node(filterSource);
+	if (srcDesc.Width != sourceNode.width || srcDesc.Height != sourceNode.height || dstDesc.Width != plan_.width || dstDesc.Height != plan_.height) {
+		assert(0);
+		return E_INVALIDARG;
+	}
+
+	HRESULT result = S_OK;
+	targets_.resize(plan_.targets.size());
+	for (size_t t = 0; t < targets_.size() && SUCCEEDED(result); ++t) {
+		result = CreateTexture(targetFormat, plan_.targets[t].width, plan_.targets[t].height, targets_[t]);
+	}
+	auto resourceOf = [&](int target) {
+		if (target >= 0) {
+			return targets_[target].Get();
+		}
+		return target == filterSourceTarget ? source : output;
+	};
+	if (SUCCEEDED(result) && plan_.IsCopy()) {
+		//出力が入力そのものなら、処理の数が0の点ごとのパスでコピーする
+		FilterPass copy;
+		copy.inputs.push_back(filterSourceTarget);
+		copy.width = plan_.width;
+		copy.height = plan_.height;
+		result = AddPointwisePass(graph, copy, &source, output);
+	}
+	for (size_t p = 0; p < plan_.passes.size() && SUCCEEDED(result); ++p) {
+		const auto& pass = plan_.passes[p];
+		ID3D12Resource* inputs[1 + filterMaxExtraInputs] = {};
+		for (size_t i = 0; i < pass.inputs.size(); ++i) {
+			inputs[i] = resourceOf(pass.inputs[i]);
+		}
+		auto out = resourceOf(pass.output);
+		if (BakesToColorLut(graph, pass)) {
+			result = AddColorLutPass(graph, pass, inputs[0], out);
+		}
+		else if (IsPointwise(graph.Node(pass.nodes[0]).kind)) {
+			result = AddPointwisePass(graph, pass, inputs, out);
+		}
+		else {
+			result = AddSpatialPass(graph, pass, inputs, out);
+		}
+	}
+	return result;
+}
+
+HRESULT
+D3D12FilterGraphRunner::Build(const FilterGraph& graph, ID3D12Resource* source, ID3D12Resource* output, const FilterCompileOptions& options) {
+	//切り出した大きさのランナーとLUTは前のグラフのものなので捨てる
+	regionRunners_.clear();
+	luts_.clear();
+	hashDispatch_ = Dispatch();
+	hashBuffer_ = nullptr;
+	incremental_ = false;
+	valid_ = false;
+	hashed_ = false;
+	source_ = source;
+	output_ = output;
+	options_ = options;
+	auto result = AddGraph(graph, source, output, options);
+	if (SUCCEEDED(result)) {
+		result = BuildIncremental(graph);
+	}
+	if (FAILED(result)) {
+		dispatches_.clear();
+		incremental_ = false;
+		return result;
+	}
+	//次のRecordも同じ状態から始められるようにUAVに戻す
+	for (auto& s : states_) {
+		if (s.second != D3D12_RESOURCE_STATE_UNORDERED_ACCESS) {
+			finalBarriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(s.first, s.second, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+		}
+	}
+	CreateViews();
+	return S_OK;
+}
+
+HRESULT
+D3D12FilterGraphRunner::BuildIncremental(const FilterGraph& graph) {
+	unsigned int halo = 0;
+	if (tileSize_ == 0 || !graph.Reach(halo)) {
+		graph_.reset();
+		return S_OK;//毎フレーム全体を処理する
+	}
+	auto hashCS = GetPipeline(L"IncrementalCS.hlsl", "TileHashCS");
+	//切り出しと書き戻しのパイプラインも、切り出した大きさのランナーと共有するためここで作っておく
+	auto copyCS = GetPipeline(L"IncrementalCS.hlsl", "CopyRectCS");
+	if (hashCS == nullptr || copyCS == nullptr) {
+		return E_FAIL;
+	}
+	const UINT width = plan_.width;
+	const UINT height = plan_.height;
+	columns_ = (width + tileSize_ - 1) / tileSize_;
+	rows_ = (height + tileSize_ - 1) / tileSize_;
+	const UINT tileCount = columns_ * rows_;
+	hashBuffer_ = CreateBuffer(tileCount * 2);
+	if (hashBuffer_ == nullptr) {
+		return E_FAIL;
+	}
+	if (mappedHashes_ != nullptr) {
+		CD3DX12_RANGE written(0, 0);
+		hashReadback_->Unmap(0, &written);
+		mappedHashes_ = nullptr;
+	}
+	CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_READBACK);
+	auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(static_cast<UINT64>(tileCount) * 2 * sizeof(uint32_t));
+	auto result = dev_->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+		IID_PPV_ARGS(hashReadback_.ReleaseAndGetAddressOf()));
+	void* mapped = nullptr;
+	if (SUCCEEDED(result)) {
+		//読み戻すたびにMapしなくてよいようにMapしたままにする(読むのはGPUの完了を待ってから)
+		result = hashReadback_->Map(0, nullptr, &mapped);
+	}
+	if (FAILED(result)) {
+		assert(0);
+		return result;
+	}
+	mappedHashes_ = static_cast<const uint32_t*>(mapped);
+
+	//IncrementalCS.hlslのIncrementalInfo
+	hashDispatch_.pipeline = hashCS->state.Get();
+	hashDispatch_.srvs[0] = source_;
+	hashDispatch_.srvs[1] = geometry_;
+	hashDispatch_.uavs[1] = hashBuffer_;
+	hashDispatch_.constants = { width, height, tileSize_, geometry_ != nullptr ? 1u : 0u };
+	hashDispatch_.groups = { columns_, rows_, 1 };
+	hashes_.assign(tileCount, 0);
+	nextHashes_.assign(tileCount, 0);
+	recompute_.assign(tileCount, 0);
+	graph_.reset(new FilterGraph(graph));
+	halo_ = halo;
+	incremental_ = true;
+	return S_OK;
+}
+
+HRESULT
+D3D12FilterGraphRunner::BuildRegion(const D3D12FilterGraphRunner& parent, UINT width, UINT height) {
+	auto copyCS = GetPipeline(L"IncrementalCS.hlsl", "CopyRectCS");
+	if (copyCS == nullptr) {
+		return E_FAIL;
+	}
+	//切り出した入力・ジオメトリ画像・出力は元と同じフォーマット(写すだけなので値が変わらない)
+	auto result = CreateTexture(parent.source_->GetDesc().Format, width, height, regionSource_);
+	if (SUCCEEDED(result)) {
+		result = CreateTexture(parent.output_->GetDesc().Format, width, height, regionOutput_);
+	}
+	if (SUCCEEDED(result) && parent.geometry_ != nullptr) {
+		result = CreateTexture(parent.geometry_->GetDesc().Format, width, height, regionGeometry_);
+	}
+	if (SUCCEEDED(result)) {
+		geometry_ = regionGeometry_.Get();
+		result = AddGraph(parent.graph_->Resized(width, height), regionSource_.Get(), regionOutput_.Get(), parent.options_);
+	}
+	if (FAILED(result)) {
+		dispatches_.clear();
+		return result;
+	}
+	//グラフの最初のDispatchは切り出しを待ってから読む
+	vector<D3D12_RESOURCE_BARRIER> toRead = { CD3DX12_RESOURCE_BARRIER::UAV(nullptr),
+		CD3DX12_RESOURCE_BARRIER::Transition(regionSource_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) };
+	if (regionGeometry_ != nullptr) {
+		toRead.push_back(CD3DX12_RESOURCE_BARRIER::Transition(regionGeometry_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+	}
+	auto& firstBarriers = dispatches_.front().barriers;
+	firstBarriers.insert(firstBarriers.begin(), toRead.begin(), toRead.end());
+
+	//前に切り出し、後ろに書き戻し(位置と書き戻しのグループ数はRecordRegionで書き込む)
+	Dispatch copy;
+	copy.pipeline = copyCS->state.Get();
+	copy.groups = PlanDispatch(copyCS->numThreads, width, height).groups;
+	copy.srvs[0] = parent.source_;
+	copy.uavs[0] = regionSource_.Get();
+	vector<Dispatch> copies = { copy };
+	if (regionGeometry_ != nullptr) {
+		copy.srvs[0] = parent.geometry_;
+		copy.uavs[0] = regionGeometry_.Get();
+		copies.push_back(copy);
+	}
+	dispatches_.insert(dispatches_.begin(), copies.begin(), copies.end());
+	Dispatch writeBack;
+	writeBack.pipeline = copyCS->state.Get();
+	writeBack.srvs[0] = regionOutput_.Get();
+	writeBack.uavs[0] = parent.output_;
+	writeBack.barriers = { CD3DX12_RESOURCE_BARRIER::UAV(nullptr),
+		CD3DX12_RESOURCE_BARRIER::Transition(regionOutput_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) };
+	dispatches_.push_back(move(writeBack));
+
+	//次のRecordも同じ状態から始められるようにUAVに戻す
+	for (auto& s : states_) {
+		if (s.second != D3D12_RESOURCE_STATE_UNORDERED_ACCESS) {
+			finalBarriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(s.first, s.second, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+		}
+	}
+	for (auto res : { regionSource_.Get(), regionGeometry_.Get(), regionOutput_.Get() }) {
+		if (res != nullptr) {
+			finalBarriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(res, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+		}
+	}
+	CreateViews();
+	return S_OK;
+}
+
+//Dispatchごとに(u0～u3,t0～t3)のビューを並べる(TileHashCSがあれば最後に)。使わないところはnullのビューにしておく
+//バッファは4バイトの要素のRWStructuredBufferとして見せる(Texture3DはLUTだけ)
+void
+D3D12FilterGraphRunner::CreateViews() {
+	vector<const Dispatch*> dispatches;
+	for (auto& dispatch : dispatches_) {
+		dispatches.push_back(&dispatch);
+	}
+	if (hashDispatch_.pipeline != nullptr) {
+		dispatches.push_back(&hashDispatch_);
+	}
+	D3D12_DESCRIPTOR_HEAP_DESC descHeapDesc = {};
+	descHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	descHeapDesc.NumDescriptors = static_cast<UINT>(max<size_t>(dispatches.size(), 1) * descriptorsPerDispatch);
+	descHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	auto result = dev_->CreateDescriptorHeap(&descHeapDesc, IID_PPV_ARGS(descriptorHeap_.ReleaseAndGetAddressOf()));
+	assert(SUCCEEDED(result));
+
+	const auto increment = dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	auto handle = descriptorHeap_->GetCPUDescriptorHandleForHeapStart();
+	for (auto dispatch : dispatches) {
+		for (auto res : dispatch->uavs) {
+			D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+			if (res != nullptr && res->GetDesc().Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+				uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+				uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+				uavDesc.Buffer.NumElements = static_cast<UINT>(res->GetDesc().Width / sizeof(uint32_t));
+				uavDesc.Buffer.StructureByteStride = sizeof(uint32_t);
+			}
+			else {
+				uavDesc.Format = res != nullptr ? res->GetDesc().Format : DXGI_FORMAT_R8G8B8A8_UNORM;
+				uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+			}
+			dev_->CreateUnorderedAccessView(res, nullptr, &uavDesc, handle);
+			handle.ptr += increment;
+		}
+		for (auto res : dispatch->srvs) {
+			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Format = res != nullptr ? res->GetDesc().Format : DXGI_FORMAT_R8G8B8A8_UNORM;
+			if (res != nullptr && res->GetDesc().Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D) {
+				srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;//ColorLutCSのLUT
+				srvDesc.Texture3D.MipLevels = 1;
+			}
+			else {
+				srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+				srvDesc.Texture2D.MipLevels = 1;
+			}
+			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+			dev_->CreateShaderResourceView(res, &srvDesc, handle);
+			handle.ptr += increment;
+		}
+	}
+}
+
+void
+D3D12FilterGraphRunner::RecordDispatches(ID3D12GraphicsCommandList* cmdList) {
+	cmdList->SetComputeRootSignature(rootSignature_.Get());
+	ID3D12DescriptorHeap* descHeaps[] = { descriptorHeap_.Get() };
+	cmdList->SetDescriptorHeaps(1, descHeaps);
+	const auto increment = dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	auto table = descriptorHeap_->GetGPUDescriptorHandleForHeapStart();
+	for (auto& dispatch : dispatches_) {
+		if (!dispatch.barriers.empty()) {
+			cmdList->ResourceBarrier(static_cast<UINT>(dispatch.barriers.size()), dispatch.barriers.data());
+		}
+		cmdList->SetPipelineState(dispatch.pipeline);
+		cmdList->SetComputeRootDescriptorTable(0, table);
+		cmdList->SetComputeRoot32BitConstants(1, static_cast<UINT>(dispatch.constants.size()), dispatch.constants.data(), 0);
+		cmdList->Dispatch(dispatch.groups.x, dispatch.groups.y, dispatch.groups.z);
+		table.ptr += static_cast<UINT64>(increment) * descriptorsPerDispatch;
+	}
+	if (!finalBarriers_.empty()) {
+		cmdList->ResourceBarrier(static_cast<UINT>(finalBarriers_.size()), finalBarriers_.data());
+	}
+}
+
+void
+D3D12FilterGraphRunner::RecordHash(ID3D12GraphicsCommandList* cmdList) {
+	if (!incremental_) {
+		return;
+	}
+	cmdList->SetComputeRootSignature(rootSignature_.Get());
+	ID3D12DescriptorHeap* descHeaps[] = { descriptorHeap_.Get() };
+	cmdList->SetDescriptorHeaps(1, descHeaps);
+	const auto increment = dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	auto table = descriptorHeap_->GetGPUDescriptorHandleForHeapStart();
+	table.ptr += static_cast<UINT64>(increment) * descriptorsPerDispatch * dispatches_.size();
+	cmdList->SetPipelineState(hashDispatch_.pipeline);
+	cmdList->SetComputeRootDescriptorTable(0, table);
+	cmdList->SetComputeRoot32BitConstants(1, static_cast<UINT>(hashDispatch_.constants.size()), hashDispatch_.constants.data(), 0);
+	//描いたばかりの入力とジオメトリ画像は、描き終わりを待って(圧縮も解いて)から読む
+	vector<D3D12_RESOURCE_BARRIER> toRead, toTarget;
+	for (auto res : { source_, geometry_ }) {
+		if (res != nullptr) {
+			toRead.push_back(CD3DX12_RESOURCE_BARRIER::Transition(res, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+			toTarget.push_back(CD3DX12_RESOURCE_BARRIER::Transition(res, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
+		}
+	}
+	cmdList->ResourceBarrier(static_cast<UINT>(toRead.size()), toRead.data());
+	cmdList->Dispatch(hashDispatch_.groups.x, hashDispatch_.groups.y, hashDispatch_.groups.z);
+	toTarget.push_back(CD3DX12_RESOURCE_BARRIER::Transition(hashBuffer_, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+	cmdList->ResourceBarrier(static_cast<UINT>(toTarget.size()), toTarget.data());
+	cmdList->CopyResource(hashReadback_.Get(), hashBuffer_);
+	auto toUav = CD3DX12_RESOURCE_BARRIER::Transition(hashBuffer_, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	cmdList->ResourceBarrier(1, &toUav);
+	hashed_ = true;
+}
+
+void
+D3D12FilterGraphRunner::MergeRegions(vector<TileRect>& regions)const {
+	//行ごとに横に続くタイルをまとめ、1つ上の行に同じ幅の矩形があれば縦に伸ばす(IncrementalFilterRunnerと同じ)
+	regions.clear();
+	for (UINT ty = 0; ty < rows_; ++ty) {
+		const uint8_t* row = &recompute_[static_cast<size_t>(ty) * columns_];
+		for (UINT tx = 0; tx < columns_;) {
+			if (!row[tx]) {
+				++tx;
+				continue;
+			}
+			const UINT x0 = tx;
+			while (tx < columns_ && row[tx]) {
+				++tx;
+			}
+			auto it = find_if(regions.begin(), regions.end(), [&](const TileRect& r) {return r.y1 == ty && r.x0 == x0 && r.x1 == tx; });
+			if (it != regions.end()) {
+				it->y1 = ty + 1;
+			}
+			else {
+				regions.push_back({ x0, ty, tx, ty + 1 });
+			}
+		}
+	}
+}
+
+void
+D3D12FilterGraphRunner::ClipRegion(const TileRect& region, UINT(&rect)[4], UINT(&crop)[4])const {
+	//画像の端では切り出しも端で止まるので、端の扱いは全体と同じ
+	rect[0] = region.x0 * tileSize_;
+	rect[1] = region.y0 * tileSize_;
+	rect[2] = min(region.x1 * tileSize_, plan_.width);
+	rect[3] = min(region.y1 * tileSize_, plan_.height);
+	crop[0] = rect[0] - min(halo_, rect[0]);
+	crop[1] = rect[1] - min(halo_, rect[1]);
+	crop[2] = min(rect[2] + halo_, plan_.width);
+	crop[3] = min(rect[3] + halo_, plan_.height);
+	//切り出す大きさを少ない種類にそろえて、大きさごとのランナー(テクスチャとディスクリプタヒープ)を使い回せるようにする
+	BucketCrop(tileSize_, plan_.width, crop[0], crop[2]);
+	BucketCrop(tileSize_, plan_.height, crop[1], crop[3]);
+}
+
+void
+D3D12FilterGraphRunner::RecordRegion(ID3D12GraphicsCommandList* cmdList, const TileRect& region) {
+	UINT rect[4], crop[4];
+	ClipRegion(region, rect, crop);
+	const UINT cw = crop[2] - crop[0];
+	const UINT ch = crop[3] - crop[1];
+	auto& runner = *regionRunners_.at(make_pair(cw, ch));
+	//LUTはふつう親のRecordで写したものを共有しているので、ここで写すものはない
+	runner.RecordLutUploads(cmdList);
+	//IncrementalCS.hlslのIncrementalInfo(切り出しは入力とジオメトリ画像の2つ、書き戻しは最後)
+	auto& dispatches = runner.dispatches_;
+	const size_t copies = runner.regionGeometry_ != nullptr ? 2 : 1;
+	for (size_t i = 0; i < copies; ++i) {
+		dispatches[i].constants = { 0, 0, 0, 0, crop[0], crop[1], 0, 0, cw, ch };
+	}
+	auto& writeBack = dispatches.back();
+	const UINT w = rect[2] - rect[0];
+	const UINT h = rect[3] - rect[1];
+	writeBack.constants = { 0, 0, 0, 0, rect[0] - crop[0], rect[1] - crop[1], rect[0], rect[1], w, h };
+	writeBack.groups = PlanDispatch(runner.GetPipeline(L"IncrementalCS.hlsl", "CopyRectCS")->numThreads, w, h).groups;
+	runner.RecordDispatches(cmdList);
+	++stats_.regions;
+	stats_.processedPixels += static_cast<uint64_t>(cw) * ch;
+}
+
+void
+D3D12FilterGraphRunner::RecordFull(ID3D12GraphicsCommandList* cmdList) {
+	RecordDispatches(cmdList);
+	++stats_.fullFrames;
+	++stats_.regions;
+	stats_.recomputedTiles += static_cast<uint64_t>(columns_) * rows_;
+	stats_.processedPixels += static_cast<uint64_t>(plan_.width) * plan_.height;
+}
+
+void
+D3D12FilterGraphRunner::Record(ID3D12GraphicsCommandList* cmdList) {
+	if (dispatches_.empty()) {
+		return;
+	}
+	RecordLutUploads(cmdList);
+	if (!incremental_) {
+		RecordDispatches(cmdList);
+		return;
+	}
+	const auto tileCount = static_cast<uint64_t>(columns_) * rows_;
+	++stats_.frames;
+	stats_.tiles += tileCount;
+	if (!hashed_) {
+		//どこが変わったか分からないので全体を処理し、次にハッシュを取ったフレームから比べ直す
+		valid_ = false;
+		stats_.changedTiles += tileCount;
+		RecordFull(cmdList);
+		return;
+	}
+	hashed_ = false;
+	for (size_t t = 0; t < nextHashes_.size(); ++t) {
+		nextHashes_[t] = (static_cast<uint64_t>(mappedHashes_[t * 2 + 1]) << 32) | mappedHashes_[t * 2];
+	}
+	if (!valid_) {
+		stats_.changedTiles += tileCount;
+		RecordFull(cmdList);
+		hashes_.swap(nextHashes_);
+		valid_ = true;
+		return;
+	}
+
+	//変わったタイルから、読む範囲にかかるタイルに広げる
+	const int spread = static_cast<int>((halo_ + tileSize_ - 1) / tileSize_);
+	fill(recompute_.begin(), recompute_.end(), static_cast<uint8_t>(0));
+	for (UINT ty = 0; ty < rows_; ++ty) {
+		for (UINT tx = 0; tx < columns_; ++tx) {
+			const size_t t = static_cast<size_t>(ty) * columns_ + tx;
+			if (hashes_[t] == nextHashes_[t]) {
+				continue;
+			}
+			++stats_.changedTiles;
+			const UINT nx0 = static_cast<UINT>(max(static_cast<int>(tx) - spread, 0));
+			const UINT ny0 = static_cast<UINT>(max(static_cast<int>(ty) - spread, 0));
+			const UINT nx1 = min(tx + spread + 1, columns_);
+			const UINT ny1 = min(ty + spread + 1, rows_);
+			for (auto ny = ny0; ny < ny1; ++ny) {
+				fill_n(&recompute_[static_cast<size_t>(ny) * columns_ + nx0], nx1 - nx0, static_cast<uint8_t>(1));
+			}
+		}
+	}
+	hashes_.swap(nextHashes_);
+	const auto recomputed = static_cast<uint64_t>(count(recompute_.begin(), recompute_.end(), static_cast<uint8_t>(1)));
+	if (recomputed == tileCount) {
+		RecordFull(cmdList);
+		return;
+	}
+	vector<TileRect> regions;
+	MergeRegions(regions);
+
+	//このフレームで使う切り出した大きさのランナーをそろえる
+	//(GPUは前のRecordを使い終わっているので、増えすぎたらこのフレームで使わないものは捨ててよい)
+	vector<pair<UINT, UINT>> sizes;
+	for (auto& region : regions) {
+		UINT rect[4], crop[4];
+		ClipRegion(region, rect, crop);
+		sizes.emplace_back(crop[2] - crop[0], crop[3] - crop[1]);
+	}
+	sort(sizes.begin(), sizes.end());
+	sizes.erase(unique(sizes.begin(), sizes.end()), sizes.end());
+	if (sizes.size() > maxRegionRunners) {
+		RecordFull(cmdList);
+		return;
+	}
+	const auto missing = static_cast<size_t>(count_if(sizes.begin(), sizes.end(), [&](const pair<UINT, UINT>& size) {return regionRunners_.count(size) == 0; }));
+	if (regionRunners_.size() + missing > maxRegionRunners) {
+		for (auto it = regionRunners_.begin(); it != regionRunners_.end();) {
+			if (find(sizes.begin(), sizes.end(), it->first) == sizes.end()) {
+				it = regionRunners_.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+	for (auto& size : sizes) {
+		auto& runner = regionRunners_[size];
+		if (runner != nullptr) {
+			continue;
+		}
+		runner.reset(new D3D12FilterGraphRunner(this));
+		if (FAILED(runner->BuildRegion(*this, size.first, size.second))) {
+			assert(0);
+			regionRunners_.erase(size);
+			RecordFull(cmdList);
+			return;
+		}
+	}
+	stats_.recomputedTiles += recomputed;
+	for (auto& region : regions) {
+		RecordRegion(cmdList, region);
+	}
+}
@@ -0,0 +1,191 @@
+﻿#pragma once
+#include<d3d12.h>
+#include<wrl.h>
+#include<map>
+#include<memory>
+#include<string>
+#include<tuple>
+#include<vector>
+#include"../CpuCompute/FilterGraph.h"
+#include"../CpuCompute/DispatchPlan.h"
+#include"../CpuCompute/IncrementalFilter.h"
+#include"../CpuCompute/ColorLut.h"
+
+///フィルタグラフ(CpuCompute/FilterGraph.h)をコンピュートシェーダで実行する(CPU版はCpuCompute/FilterGraphRunner.h)
+///Buildで計画を立て、中間のターゲット(R16G16B16A16_FLOAT)とDispatchごとのディスクリプタ・バリアを作っておく。
+///Recordはそれをコマンドリストに積むだけなので毎フレーム呼んでよい
+///  点ごとのパス : PostEffectCS.hlslのPointwiseCS(まとめたノードを1回のDispatchで)
+///  近傍を読むパス : BlurCS/BoxFilterCS/MedianCS/ResampleCS/BloomCS.hlslの各エントリ(作業用のテクスチャは同じ大きさのものを使い回す)
+///  自動露出とトーンマップ : ReductionCS.hlslのLumaHistogramCSとToneMapCS.hlsl(露出はGPUのバッファでフレームをまたいで持つ)
+///  輪郭線 : OutlineCS.hlsl(SetGeometryで渡したジオメトリ画像も読む)
+///  縮小した処理の拡大 : JointUpsampleCS.hlsl(縮小した画像・縮小した手がかり・手がかりの3つを読む。深度を使うならジオメトリ画像も)
+///  SetColorLutしたときの色の変換だけの点ごとのパス : ColorLutCS.hlsl(まとめたノードをBuildで3D LUTに焼いて1回引く)
+///@remarks 入力(とジオメトリ画像)はRENDER_TARGETのまま読み、出力はUNORDERED_ACCESSのまま書く(Dx12Wrapperのこれまでの使い方と同じ)。
+///中間のターゲットはRecordの終わりでUNORDERED_ACCESSに戻す
+///SetIncrementalしておくと、変わったタイルだけを処理し直す(CPU版はCpuCompute/IncrementalFilter.h)。
+///RecordHashでIncrementalCS.hlslのTileHashCSがタイルのハッシュを取ってリードバックに写し、その完了を待ってからのRecordが
+///前のフレームと比べて、処理し直すタイルをまとめた矩形ごとに(切り出し→切り出した大きさのグラフ→書き戻し)を積む
+class D3D12FilterGraphRunner
+{
+	template<typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	//パイプラインと[numthreads](リフレクションで取得)
+	struct Pipeline {
+		ComPtr<ID3D12PipelineState> state;
+		hlsl::uint3 numThreads = { 1,1,1 };
+	};
+	//1回のDispatch
+	struct Dispatch {
+		ID3D12PipelineState* pipeline = nullptr;
+		ID3D12Resource* uavs[4] = {};//u0～u3(バッファならRWStructuredBuffer<uint/float>として)
+		ID3D12Resource* srvs[4] = {};//t0～t3
+		std::vector<uint32_t> constants;//b0
+		hlsl::uint3 groups = { 1,1,1 };
+		std::vector<D3D12_RESOURCE_BARRIER> barriers;//Dispatchの前に積む
+	};
+
+	ComPtr<ID3D12Device> dev_;
+	ComPtr<ID3D12RootSignature> rootSignature_;
+	ComPtr<ID3D12DescriptorHeap> descriptorHeap_;//Dispatchごとに(u0～u3,t0～t3)の8つ
+	std::map<std::string, Pipeline> pipelines_;//"ファイル名|エントリ名"
+	//点ごとのパスを焼いた3D LUT(R32G32B32A32_FLOATのTexture3D。最初のRecordでUPLOADから写し、あとはNON_PIXEL_SHADER_RESOURCEのまま)
+	struct ColorLutTexture {
+		ComPtr<ID3D12Resource> texture;
+		ComPtr<ID3D12Resource> upload;//UPLOAD(ColorLut::valuesをfootprintの並びで)
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+		bool uploaded = false;
+	};
+	unsigned int lutSize_ = 0;//0ならLUTに焼かない
+	LutShaper lutShaper_ = LutShaper::Linear;
+	std::map<std::vector<float>, ColorLutTexture> luts_;//パスのノードの(kind,params)の並びごと(切り出した大きさのランナーと共有する)
+	std::vector<ComPtr<ID3D12Resource>> targets_;//計画の中間のターゲット
+	std::map<std::tuple<DXGI_FORMAT, UINT, UINT, UINT>, ComPtr<ID3D12Resource>> scratch_;//作業用(フォーマット,幅,高さ,番号)
+	std::vector<ComPtr<ID3D12Resource>> buffers_;//ToneMapのヒストグラムと露出(Buildで作る。UNORDERED_ACCESSのまま使う)
+	ID3D12Resource* geometry_ = nullptr;//OutlineとJointUpsampleのジオメトリ画像
+	std::map<ID3D12Resource*, D3D12_RESOURCE_STATES> states_;//Build中の、中間と作業用のテクスチャの状態
+	std::vector<Dispatch> dispatches_;
+	std::vector<D3D12_RESOURCE_BARRIER> finalBarriers_;//Recordの終わりに積む
+	FilterPlan plan_;
+
+	//変わったタイルだけを処理し直すとき
+	//タイル単位の矩形([x0,x1)×[y0,y1))
+	struct TileRect {
+		UINT x0, y0, x1, y1;
+	};
+	UINT tileSize_ = 0;//0なら毎フレーム全体を処理する
+	bool incremental_ = false;//Buildしたグラフをタイルごとに処理し直すか(tileSize_があり、グラフが局所的)
+	bool valid_ = false;//出力に前のフレームの結果が残っているか
+	bool hashed_ = false;//RecordHashしてまだRecordしていない
+	UINT halo_ = 0;//グラフが読む範囲(FilterGraph::Reach)
+	UINT columns_ = 0;
+	UINT rows_ = 0;
+	std::unique_ptr<FilterGraph> graph_;//切り出した大きさのグラフを作るため
+	FilterCompileOptions options_;
+	ID3D12Resource* source_ = nullptr;
+	ID3D12Resource* output_ = nullptr;
+	Dispatch hashDispatch_;//TileHashCS(ディスクリプタはdispatches_の後ろ)
+	ID3D12Resource* hashBuffer_ = nullptr;//タイルごとに2つ(buffers_の中)
+	ComPtr<ID3D12Resource> hashReadback_;//READBACK(Mapしたまま)
+	const uint32_t* mappedHashes_ = nullptr;
+	std::vector<uint64_t> hashes_;//前のフレームのタイルのハッシュ
+	std::vector<uint64_t> nextHashes_;
+	std::vector<uint8_t> recompute_;//タイルごとの処理し直すか
+	std::map<std::pair<UINT, UINT>, std::unique_ptr<D3D12FilterGraphRunner>> regionRunners_;//切り出した大きさ(タイルの2のべき乗倍)ごと
+	IncrementalFilterStats stats_;
+	//切り出した大きさのランナー(regionRunners_の中身)だけが使う
+	ComPtr<ID3D12Resource> regionSource_;
+	ComPtr<ID3D12Resource> regionGeometry_;
+	ComPtr<ID3D12Resource> regionOutput_;
+
+	ID3D12RootSignature* CreateRootSignature();
+	const Pipeline* GetPipeline(const wchar_t* file, const char* entry);
+	HRESULT CreateTexture(DXGI_FORMAT format, UINT width, UINT height, ComPtr<ID3D12Resource>& res);
+	ID3D12Resource* GetScratch(DXGI_FORMAT format, UINT width, UINT height, UINT index);
+	//4バイトの要素がcount個のバッファ(0で埋まっている)を作ってbuffers_に足す
+	ID3D12Resource* CreateBuffer(UINT count);
+	//Dispatchを足し、読み書きするテクスチャの状態を合わせるバリアを作る
+	void AddDispatch(Dispatch dispatch);
+	HRESULT AddPointwisePass(const FilterGraph& graph, const FilterPass& pass, ID3D12Resource* const* inputs, ID3D12Resource* out);
+	HRESULT AddSpatialPass(const FilterGraph& graph, const FilterPass& pass, ID3D12Resource* const* inputs, ID3D12Resource* out);
+	//点ごとのパスをLUTに焼くか(SetColorLutしていて、追加の入力がなく、Grayscale・Gamma・Contrast・Tintだけが2つ以上)
+	bool BakesToColorLut(const FilterGraph& graph, const FilterPass& pass)const;
+	HRESULT AddColorLutPass(const FilterGraph& graph, const FilterPass& pass, ID3D12Resource* in, ID3D12Resource* out);
+	//transformをLUTに焼いてテクスチャとUPLOADのバッファを作る(写すのはRecordLutUploads)
+	HRESULT CreateColorLut(const ColorTransform& transform, ColorLutTexture& lut);
+	//まだ写していないLUTをUPLOADから写し、NON_PIXEL_SHADER_RESOURCEにする
+	void RecordLutUploads(ID3D12GraphicsCommandList* cmdList);
+	//計画を立ててDispatchを並べる(ビューとRecordの終わりのバリアはまだ作らない)
+	HRESULT AddGraph(const FilterGraph& graph, ID3D12Resource* source, ID3D12Resource* output, const FilterCompileOptions& options);
+	void CreateViews();
+	void RecordDispatches(ID3D12GraphicsCommandList* cmdList);
+	//タイルのハッシュのバッファ・リードバック・TileHashCSのDispatchを作る
+	HRESULT BuildIncremental(const FilterGraph& graph);
+	//parentのグラフを切り出した大きさで組み、前に切り出し・後ろに書き戻しのDispatchを足す(regionRunners_の中身で呼ぶ)
+	HRESULT BuildRegion(const D3D12FilterGraphRunner& parent, UINT width, UINT height);
+	void MergeRegions(std::vector<TileRect>& regions)const;
+	//書き戻す範囲(rect)と、それに読む範囲を足して切り出す範囲(crop)。どちらも画素の(x0,y0,x1,y1)
+	void ClipRegion(const TileRect& region, UINT(&rect)[4], UINT(&crop)[4])const;
+	void RecordRegion(ID3D12GraphicsCommandList* cmdList, const TileRect& region);
+	void RecordFull(ID3D12GraphicsCommandList* cmdList);
+
+	//parentのルートシグネチャとパイプラインを共有する(切り出した大きさのランナー)
+	explicit D3D12FilterGraphRunner(const D3D12FilterGraphRunner* parent);
+	D3D12FilterGraphRunner(const D3D12FilterGraphRunner&) = delete;
+	void operator=(const D3D12FilterGraphRunner&) = delete;
+public:
+	///@param dev デバイス
+	explicit D3D12FilterGraphRunner(ID3D12Device* dev);
+	~D3D12FilterGraphRunner();
+
+	///OutlineとJointUpsample(深度を使うとき)のノードが読むジオメトリ画像を渡す(グラフの入力と同じ大きさ。Buildより前に呼ぶ)
+	void SetGeometry(ID3D12Resource* geometry) { geometry_ = geometry; }
+
+	///変わったタイルだけを処理し直すようにする(Buildより前に呼ぶ。Reachがfalseのグラフは毎フレーム全体を処理する)
+	///出力は前のフレームの結果が残っていることを前提にする(出力をほかで書き換えたらInvalidateすること)
+	///@param tileSize タイルの一辺(画素)。0なら毎フレーム全体を処理する
+	void SetIncremental(unsigned int tileSize) { tileSize_ = tileSize; }
+
+	///色の変換(Grayscale・Gamma・Contrast・Tint)だけが2つ以上続く点ごとのパスを、BuildでCpuCompute/ColorLut.hの3D LUTに焼き、
+	///PointwiseCSの代わりにColorLutCS.hlslで引くようにする(Buildより前に呼ぶ)
+	///LUTは入力を0～1に切り詰めて引くので、入力が0～1に収まるところ(8bitの入力やToneMapの出力)にだけ使うこと。
+	///直接計算との差はColorLut.hの説明の範囲(R8G8B8A8の出力で、17^3は6LSB、33^3と65^3は4LSB以内)
+	///@param size 格子の1辺の点の数(17/33/65など。0なら焼かない)
+	///@param shaper 格子の座標の曲げ方
+	void SetColorLut(unsigned int size, LutShaper shaper) { lutSize_ = size; lutShaper_ = shaper; }
+
+	///実行の準備をする(グラフを変えたら呼び直す。GPUが前の計画を使い終わってから呼ぶこと)
+	///ToneMapのなじませた露出は呼び直すと捨てられ、次のフレームの目標から始まる
+	///@param graph 実行するグラフ(入力はsourceと、出力はoutputと同じ大きさ)
+	///@param source 入力のテクスチャ
+	///@param output 出力のテクスチャ(D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)
+	///@param options 計画のオプション
+	///@return シェーダのコンパイルやテクスチャの作成に失敗したらそのHRESULT(ジオメトリ画像を読むノードがあるのにジオメトリ画像がなければE_INVALIDARG)
+	HRESULT Build(const FilterGraph& graph, ID3D12Resource* source, ID3D12Resource* output, const FilterCompileOptions& options = FilterCompileOptions());
+
+	///Dispatchをコマンドリストに積む(ルートシグネチャ・ディスクリプタヒープ・パイプラインも設定する)
+	///SetIncrementalしていれば、処理し直すタイルの矩形だけを積む(このときGPUが前のRecordを使い終わってから呼ぶこと)
+	///@param cmdList コンピュートかダイレクトのコマンドリスト
+	void Record(ID3D12GraphicsCommandList* cmdList);
+
+	///入力(とジオメトリ画像)のタイルのハッシュを取ってリードバックに写すDispatchを積む(SetIncrementalしていなければ何もしない)
+	///このコマンドリストの完了を待ってからRecordすること(呼ばずにRecordしたフレームは全体を処理する)
+	///入力とジオメトリ画像はRENDER_TARGETからNON_PIXEL_SHADER_RESOURCEにして読み、RENDER_TARGETに戻す
+	///@param cmdList 入力を描いたダイレクトのコマンドリスト(描き終わりの待ちでハッシュも読めるようになる)
+	void RecordHash(ID3D12GraphicsCommandList* cmdList);
+
+	///前の出力を捨てる(次のRecordは全体を処理する。出力をほかで書き換えたときなど)
+	void Invalidate() { valid_ = false; }
+	///タイルごとに処理し直しているか(SetIncrementalしていて、Buildしたグラフが局所的)
+	bool IsIncremental()const { return incremental_; }
+	unsigned int TileSize()const { return tileSize_; }
+	///Recordの回数を重ねて数えた統計(SetIncrementalしているときだけ数える)
+	const IncrementalFilterStats& Stats()const { return stats_; }
+	void ResetStats() { stats_ = IncrementalFilterStats(); }
+
+	const FilterPlan& Plan()const { return plan_; }
+	///Dispatchの回数
+	size_t DispatchCount()const { return dispatches_.size(); }
+	///Buildで焼いたLUTの数(ColorLutCSで処理するパスの、処理の並びの種類)
+	size_t ColorLutCount()const { return luts_.size(); }
+};
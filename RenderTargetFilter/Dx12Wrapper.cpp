@@ -1,12 +1,17 @@
 ﻿#include "Dx12Wrapper.h"
 #include<cassert>
 #include<d3dx12.h>
+#include<d3d12shader.h>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
 #include"Application.h"
 
 #pragma comment(lib,"DirectXTex.lib")
 #pragma comment(lib,"d3d12.lib")
 #pragma comment(lib,"dxgi.lib")
 #pragma comment(lib,"d3dcompiler.lib")
+#pragma comment(lib,"dxguid.lib")
 
 using namespace Microsoft::WRL;
 using namespace std;
@@ -90,6 +95,10 @@ namespace {
 	///@param size 元のサイズ
 	///@param alignment アライメントサイズ
 	///@return アライメントをそろえたサイズ
+	//ポストエフェクトの色の変換を焼くLUT(格子の1辺の点の数と座標の曲げ方。ガンマのある並びなので暗部を細かく)
+	constexpr unsigned int postEffectLutSize = 33;
+	constexpr LutShaper postEffectLutShaper = LutShaper::Sqrt;
+
 	size_t	AlignmentedSize(size_t size, size_t alignment) {
 		return size + alignment - size % alignment;
 	}
@@ -120,28 +129,40 @@ Dx12Wrapper::CreateOffscreenRTBuffer() {
 	D3D12_RESOURCE_DESC resDesc = {};
 
 	resDesc = bbDesc;
-	D3D12_CLEAR_VALUE clearValue = { DXGI_FORMAT_R8G8B8A8_UNORM ,{ 1.0f,1.0f,1.0f,1.0f } };
+	resDesc.Format = OffscreenFormat();
+	D3D12_CLEAR_VALUE clearValue = { resDesc.Format ,{ 1.0f,1.0f,1.0f,1.0f } };
 	result = dev_->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, D3D12_RESOURCE_STATE_RENDER_TARGET,&clearValue,
 		IID_PPV_ARGS(&offscreenRTBuffer_));
 	assert(SUCCEEDED(result));
 
 	auto rtvHeapDesc=rtvHeaps_->GetDesc();
-	rtvHeapDesc.NumDescriptors = 1;
+	rtvHeapDesc.NumDescriptors = 2;
 	result = dev_->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&rtvHeapOffscreen_));
 	assert(SUCCEEDED(result));
 
 	D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
-	rtvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	rtvDesc.Format = resDesc.Format;
 	rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
 	rtvDesc.Texture2D.MipSlice = 0;
 	rtvDesc.Texture2D.PlaneSlice = 0;
 	dev_->CreateRenderTargetView(offscreenRTBuffer_, &rtvDesc,rtvHeapOffscreen_->GetCPUDescriptorHandleForHeapStart());
 
+	//ジオメトリ画像(背景は法線0、深度は遠く、edgeFlgは0)
+	resDesc.Format = GeometryFormat();
+	clearValue = { resDesc.Format ,{ 0.0f,0.0f,outlineBackgroundDepth,0.0f } };
+	result = dev_->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc, D3D12_RESOURCE_STATE_RENDER_TARGET, &clearValue,
+		IID_PPV_ARGS(&geometryRTBuffer_));
+	assert(SUCCEEDED(result));
+	rtvDesc.Format = resDesc.Format;
+	auto geometryRtvH = rtvHeapOffscreen_->GetCPUDescriptorHandleForHeapStart();
+	geometryRtvH.ptr += dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	dev_->CreateRenderTargetView(geometryRTBuffer_, &rtvDesc, geometryRtvH);
+
 
 	return result;
 }
 
-Dx12Wrapper::Dx12Wrapper(HWND hwnd){
+Dx12Wrapper::Dx12Wrapper(HWND hwnd, bool hdr, bool sepia) :hdr_(hdr), sepia_(sepia && !hdr) {
 #ifdef _DEBUG
 	//デバッグレイヤーをオンに
 	EnableDebugLayer();
@@ -202,11 +223,32 @@ Dx12Wrapper::Dx12Wrapper(HWND hwnd){
 		return;
 	}
 
-	uavDescriptorHeap_ = CreateUAVDescriptorHeap();
-	rootSignatureCS_ = CreateRootSignatureForComputeShader();
-	pipelineCS_ = CreateComputePipeline(rootSignatureCS_);
-	auto result = CreateUAVBuffer(dev_.Get(), uavResource_, offscreenRTBuffer_->GetDesc());
-	CreateComputeViews(offscreenRTBuffer_, uavResource_, uavDescriptorHeap_);
+	//ポストエフェクトの出力はバックバッファにコピーするので、オフスクリーンがHDRでもバックバッファと同じフォーマット
+	auto result = CreateUAVBuffer(dev_.Get(), uavResource_, backBuffers_[0]->GetDesc());
+	//輪郭線を描いてから、これまでと同じくモノクロにするグラフ(HDRなら自動露出とトーンマップ、セピアなら灰色化→ガンマ→色味)
+	postEffects_.reset(new D3D12FilterGraphRunner(dev_.Get()));
+	postEffects_->SetGeometry(geometryRTBuffer_);
+	//色の変換だけが続くところ(セピア)はLUTに焼いて1回で引く(入力は8bitのオフスクリーンなので0～1)
+	postEffects_->SetColorLut(postEffectLutSize, postEffectLutShaper);
+	//モデルが動いたところ(とその輪郭線が読む範囲)のタイルだけを処理し直す(自動露出のように画像全体を読むグラフは毎フレーム全体)
+	postEffects_->SetIncremental(32);
+	auto desc = offscreenRTBuffer_->GetDesc();
+	FilterGraph graph(static_cast<unsigned int>(desc.Width), desc.Height);
+	auto outlined = graph.Outline(graph.Source(), OutlineSettings());
+	if (hdr_) {
+		graph.ToneMap(outlined, ToneMapSettings());
+	}
+	else if (sepia_) {
+		//MonoPixelと同じ輝度とガンマのあとに色味をかける(MonoはアルファをLUTで扱えないので、灰色化とガンマに分ける)
+		graph.Tint(graph.Gamma(graph.Grayscale(outlined), 2.2f), hlsl::float3(1.07f, 0.74f, 0.43f));
+	}
+	else {
+		graph.Mono(outlined);
+	}
+	if (FAILED(SetPostEffects(graph))) {
+		assert(0);
+		return;
+	}
 
 }
 
@@ -580,13 +622,18 @@ Dx12Wrapper::BeginDraw() {
 
 	//深度を指定
 	auto dsvH = dsvHeap_->GetCPUDescriptorHandleForHeapStart();
-	cmdList_->OMSetRenderTargets(1, &rtvH, false, &dsvH);
+	//色とジオメトリ画像(ヒープに続けて並べてある)
+	cmdList_->OMSetRenderTargets(2, &rtvH, true, &dsvH);
 	cmdList_->ClearDepthStencilView(dsvH, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
 
 	//画面クリア
 	float clearColor[] = { 1.0f,1.0f,1.0f,1.0f };//白色
 	cmdList_->ClearRenderTargetView(rtvH, clearColor, 0, nullptr);
+	float clearGeometry[] = { 0.0f,0.0f,outlineBackgroundDepth,0.0f };//背景(輪郭線を描かない)
+	auto geometryRtvH = rtvH;
+	geometryRtvH.ptr += dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	cmdList_->ClearRenderTargetView(geometryRtvH, clearGeometry, 0, nullptr);
 
 	//ビューポート、シザー矩形のセット
 	cmdList_->RSSetViewports(1, viewport_.get());
@@ -608,6 +655,8 @@ void
 Dx12Wrapper::EndDraw() {
 	auto bbIdx = swapchain_->GetCurrentBackBufferIndex();
 	{
+		//描き終わったオフスクリーンとジオメトリ画像のタイルのハッシュを取る(下の待ちで読み戻しも終わるので、待ちは増えない)
+		postEffects_->RecordHash(cmdList_.Get());
 		//命令のクローズ
 		cmdList_->Close();
 		//ここで一旦レンダーターゲットに書き終わるまで待ち
@@ -629,22 +678,12 @@ Dx12Wrapper::EndDraw() {
 
 	//コンピュートシェーダ用処理
 	{
-		computeCmdList_->SetPipelineState(pipelineCS_);
-		//レンダリング結果を元にUAVに書き込み
-		computeCmdList_->SetComputeRootSignature(rootSignatureCS_);//ルートシグネチャセット
-		ID3D12DescriptorHeap* descHeaps[] = { uavDescriptorHeap_ };
-		computeCmdList_->SetDescriptorHeaps(1, descHeaps);//ディスクリプタヒープのセット
-		computeCmdList_->SetComputeRootDescriptorTable(0,
-			uavDescriptorHeap_->GetGPUDescriptorHandleForHeapStart()
-		);//ルートパラメータのセット
-		auto uavDesc = uavResource_->GetDesc();
-		//画像サイズ/スレッド数でディスパッチ
-		computeCmdList_->Dispatch(uavDesc.Width, uavDesc.Height, 1);
-
+		//レンダリング結果を元にUAVに書き込み(前のフレームから変わったタイルの矩形だけ)
+		postEffects_->Record(computeCmdList_);
 		computeCmdList_->Close();
 		ExecuteAndWait(computeCmdQue_, computeCmdList_, computeFence_, ++fenceVal_);
 		computeCmdAlloc_->Reset();//キューをクリア
-		computeCmdList_->Reset(computeCmdAlloc_,pipelineCS_);//再びコマンドリストをためる準備
+		computeCmdList_->Reset(computeCmdAlloc_, nullptr);//再びコマンドリストをためる準備
 	}
 
 
@@ -684,6 +723,128 @@ Dx12Wrapper::Swapchain() {
 	return swapchain_;
 }
 
+DXGI_FORMAT
+Dx12Wrapper::OffscreenFormat()const {
+	return hdr_ ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+}
+
+DXGI_FORMAT
+Dx12Wrapper::GeometryFormat()const {
+	return DXGI_FORMAT_R16G16B16A16_FLOAT;
+}
+
+const IncrementalFilterStats&
+Dx12Wrapper::PostEffectStats()const {
+	return postEffects_->Stats();
+}
+
+HRESULT
+Dx12Wrapper::SetPostEffects(const FilterGraph& graph) {
+	//EndDrawで完了を待っているので、フレームの間ならGPUは前の計画を使っていない
+	return postEffects_->Build(graph, offscreenRTBuffer_, uavResource_);
+}
+
+bool
+Dx12Wrapper::CheckColorLut() {
+	//R・Gを横・縦、Bを斜めに振った画像(アルファもそのまま残るかを見る)
+	constexpr UINT size = 256;
+	ImageRGBA8 src(size, size);
+	for (UINT y = 0; y < size; ++y) {
+		for (UINT x = 0; x < size; ++x) {
+			src.At(x, y) = x | (y << 8) | (((x * 7 + y * 3) & 0xff) << 16) | (((x + y) & 0xff) << 24);
+		}
+	}
+	//よくある色調整の並び(CpuCompute/Benchmarks.cppの"lut"コマンドのgradeからトーンカーブを除いたもの)
+	const hlsl::float3 tint(1.08f, 1.0f, 0.86f);
+	FilterGraph graph(size, size);
+	graph.Tint(graph.Contrast(graph.Gamma(graph.Source(), 2.2f), 1.2f), tint);
+	ColorTransform transform;
+	transform.Gamma(2.2f).Contrast(1.2f).Tint(tint);
+
+	//入力(COPY_DEST→NON_PIXEL_SHADER_RESOURCE)・出力(UAV)と、その読み書きのUPLOAD・READBACK
+	ComPtr<ID3D12Resource> srcTex, dstTex, upload, readback;
+	CD3DX12_HEAP_PROPERTIES defaultProp(D3D12_HEAP_TYPE_DEFAULT);
+	auto srcDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1);
+	auto dstDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+	UINT64 bytes = 0;
+	dev_->GetCopyableFootprints(&srcDesc, 0, 1, 0, &footprint, nullptr, nullptr, &bytes);
+	auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(bytes);
+	CD3DX12_HEAP_PROPERTIES uploadProp(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_HEAP_PROPERTIES readbackProp(D3D12_HEAP_TYPE_READBACK);
+	auto result = dev_->CreateCommittedResource(&defaultProp, D3D12_HEAP_FLAG_NONE, &srcDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(srcTex.ReleaseAndGetAddressOf()));
+	if (SUCCEEDED(result)) {
+		result = dev_->CreateCommittedResource(&defaultProp, D3D12_HEAP_FLAG_NONE, &dstDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(dstTex.ReleaseAndGetAddressOf()));
+	}
+	if (SUCCEEDED(result)) {
+		result = dev_->CreateCommittedResource(&uploadProp, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(upload.ReleaseAndGetAddressOf()));
+	}
+	if (SUCCEEDED(result)) {
+		result = dev_->CreateCommittedResource(&readbackProp, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(readback.ReleaseAndGetAddressOf()));
+	}
+	uint8_t* mapped = nullptr;
+	if (SUCCEEDED(result)) {
+		result = upload->Map(0, nullptr, reinterpret_cast<void**>(&mapped));
+	}
+	if (FAILED(result)) {
+		assert(0);
+		return false;
+	}
+	for (UINT y = 0; y < size; ++y) {
+		memcpy(mapped + footprint.Offset + static_cast<size_t>(y) * footprint.Footprint.RowPitch, src.Row(y), size * sizeof(uint32_t));
+	}
+	upload->Unmap(0, nullptr);
+
+	//ポストエフェクトと同じLUTの設定で組む(3つの変換が1パスにまとまり、LUTに焼かれること)
+	D3D12FilterGraphRunner runner(dev_.Get());
+	runner.SetColorLut(postEffectLutSize, postEffectLutShaper);
+	if (FAILED(runner.Build(graph, srcTex.Get(), dstTex.Get())) || runner.ColorLutCount() != 1 || runner.DispatchCount() != 1) {
+		assert(0);
+		return false;
+	}
+	CD3DX12_TEXTURE_COPY_LOCATION srcTexLoc(srcTex.Get(), 0);
+	CD3DX12_TEXTURE_COPY_LOCATION uploadLoc(upload.Get(), footprint);
+	computeCmdList_->CopyTextureRegion(&srcTexLoc, 0, 0, 0, &uploadLoc, nullptr);
+	auto toRead = CD3DX12_RESOURCE_BARRIER::Transition(srcTex.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	computeCmdList_->ResourceBarrier(1, &toRead);
+	runner.Record(computeCmdList_);
+	auto toCopy = CD3DX12_RESOURCE_BARRIER::Transition(dstTex.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	computeCmdList_->ResourceBarrier(1, &toCopy);
+	CD3DX12_TEXTURE_COPY_LOCATION dstTexLoc(dstTex.Get(), 0);
+	CD3DX12_TEXTURE_COPY_LOCATION readbackLoc(readback.Get(), footprint);
+	computeCmdList_->CopyTextureRegion(&readbackLoc, 0, 0, 0, &dstTexLoc, nullptr);
+	computeCmdList_->Close();
+	ExecuteAndWait(computeCmdQue_, computeCmdList_, computeFence_, fenceVal_);
+	computeCmdAlloc_->Reset();
+	computeCmdList_->Reset(computeCmdAlloc_, nullptr);
+
+	//CPU版で同じLUTを焼いて引いたものと成分ごとに比べる
+	ImageRGBA8 expected;
+	ApplyColorLut(BakeColorLut(transform, postEffectLutSize, postEffectLutShaper, nullptr), src, expected, nullptr);
+	if (FAILED(readback->Map(0, nullptr, reinterpret_cast<void**>(&mapped)))) {
+		assert(0);
+		return false;
+	}
+	int maxDiff = 0;
+	for (UINT y = 0; y < size; ++y) {
+		const auto row = reinterpret_cast<const uint32_t*>(mapped + footprint.Offset + static_cast<size_t>(y) * footprint.Footprint.RowPitch);
+		for (UINT x = 0; x < size; ++x) {
+			for (int c = 0; c < 32; c += 8) {
+				const int diff = abs(static_cast<int>((row[x] >> c) & 0xff) - static_cast<int>((expected.At(x, y) >> c) & 0xff));
+				maxDiff = max(maxDiff, diff);
+			}
+		}
+	}
+	CD3DX12_RANGE written(0, 0);
+	readback->Unmap(0, &written);
+	const int bound = ColorLutErrorBound8(postEffectLutSize);
+	char message[128];
+	snprintf(message, sizeof(message), "ColorLutCS %u^3: max diff %d LSB (bound %d) %s\n", postEffectLutSize, maxDiff, bound, maxDiff <= bound ? "ok" : "MISMATCH");
+	OutputDebugStringA(message);
+	printf("%s", message);
+	return maxDiff <= bound;
+}
+
 //ここからコンピュートシェーダ用
 /// <summary>
 /// UAV書き込みバッファを作成する(最終出力先)
@@ -712,96 +873,6 @@ Dx12Wrapper::CreateUAVBuffer(ID3D12Device* dev, ID3D12Resource*& res, const D3D1
 	return result;
 }
 
-ID3D12RootSignature* 
-Dx12Wrapper::CreateRootSignatureForComputeShader()
-{
-	HRESULT result = S_OK;
-	ID3DBlob* errBlob = nullptr;
-	D3D12_DESCRIPTOR_RANGE range[2] = {};
-	range[0].NumDescriptors = 1;//1つ
-	range[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;//u
-	range[0].BaseShaderRegister = 0;//u0
-	range[0].OffsetInDescriptorsFromTableStart = 0;
-	range[0].RegisterSpace = 0;
-
-	range[1].NumDescriptors = 1;//1つ
-	range[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;//t
-	range[1].BaseShaderRegister = 0;//t0
-	range[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-	range[1].RegisterSpace = 0;
-
-	D3D12_ROOT_PARAMETER rp[1] = {};
-	rp[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-	rp[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-	rp[0].DescriptorTable.NumDescriptorRanges = 2;
-	rp[0].DescriptorTable.pDescriptorRanges = range;
-
-	D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-	D3D12_ROOT_SIGNATURE_DESC rootSigDesc = {};
-	rootSigDesc.NumParameters = 1;
-	rootSigDesc.pParameters = rp;
-	rootSigDesc.NumStaticSamplers = 0;
-	rootSigDesc.pStaticSamplers = nullptr;
-	rootSigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_STREAM_OUTPUT;
-
-
-	ID3DBlob* rootSigBlob = nullptr;
-	D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1_0, &rootSigBlob, &errBlob);
-	ID3D12RootSignature* rootSignature = nullptr;
-	result = dev_->CreateRootSignature(0, rootSigBlob->GetBufferPointer(), rootSigBlob->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
-	rootSigBlob->Release();
-	assert(SUCCEEDED(result));
-	return rootSignature;
-}
-
-/// <summary>
-/// コンピュートシェーダのロード
-/// </summary>
-/// <returns>コンピュートシェーダBlob</returns>
-ID3DBlob* 
-Dx12Wrapper::LoadComputeShader()
-{
-	ID3DBlob* csBlob = nullptr;
-	ID3DBlob* errBlob = nullptr;
-	auto result = D3DCompileFromFile(L"FilterCS.hlsl", nullptr, nullptr, "MonoCS", "cs_5_1", 0, 0, &csBlob, &errBlob);
-	if (errBlob != nullptr) {
-		OutputFromErrorBlob(errBlob);
-	}
-	assert(SUCCEEDED(result));
-	return csBlob;
-}
-
-ID3D12PipelineState* 
-Dx12Wrapper::CreateComputePipeline(ID3D12RootSignature* rootSignatureCS)
-{
-	ID3D12PipelineState* ret = nullptr;
-	ID3DBlob* csBlob = LoadComputeShader();
-	D3D12_COMPUTE_PIPELINE_STATE_DESC pldesc = {};
-	pldesc.CS.pShaderBytecode = csBlob->GetBufferPointer();
-	pldesc.CS.BytecodeLength = csBlob->GetBufferSize();
-	pldesc.NodeMask = 0;
-	pldesc.pRootSignature = rootSignatureCS;
-	auto result = dev_->CreateComputePipelineState(&pldesc, IID_PPV_ARGS(&ret));
-	csBlob->Release();
-	assert(SUCCEEDED(result));
-	return ret;
-}
-
-ID3D12DescriptorHeap* 
-Dx12Wrapper::CreateUAVDescriptorHeap()
-{
-	ID3D12DescriptorHeap* ret = nullptr;
-	HRESULT result = S_OK;
-	D3D12_DESCRIPTOR_HEAP_DESC descHeapDesc = {};
-	descHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	descHeapDesc.NodeMask = 0;
-	descHeapDesc.NumDescriptors = 2;//UAV,SRV
-	descHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	result = dev_->CreateDescriptorHeap(&descHeapDesc, IID_PPV_ARGS(&ret));
-	assert(SUCCEEDED(result));
-	return ret;
-}
-
 //コンピュートシェーダ用コマンド作成
 bool 
 Dx12Wrapper::CreateComputeCommand(
@@ -824,33 +895,6 @@ Dx12Wrapper::CreateComputeCommand(
 	return true;
 }
 
-//UAVとSRVを作る
-void
-Dx12Wrapper::CreateComputeViews(ID3D12Resource* srcRes, ID3D12Resource* destRes, ID3D12DescriptorHeap* uavHeap) {
-	auto desc = srcRes->GetDesc();
-	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-	uavDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;//テクスチャとして　
-	uavDesc.Texture2D.MipSlice = 0;
-	uavDesc.Texture2D.PlaneSlice = 0;
-	auto handle = uavHeap->GetCPUDescriptorHandleForHeapStart();
-	dev_->CreateUnorderedAccessView(
-		destRes,
-		nullptr,
-		&uavDesc,
-		handle);
-
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Format = desc.Format;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;//バッファとして
-	srvDesc.Texture2D.PlaneSlice = 0;
-	srvDesc.Texture2D.MipLevels = 1;
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	handle.ptr += dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	dev_->CreateShaderResourceView(srcRes, &srvDesc, handle);
-}
-
 void 
 Dx12Wrapper::ExecuteAndWait(ID3D12CommandQueue* cmdQue, ID3D12CommandList* cmdList, ID3D12Fence* fence, UINT64& fenceValue)
 {
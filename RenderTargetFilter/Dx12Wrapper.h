@@ -8,6 +8,7 @@
 #include<wrl.h>
 #include<string>
 #include<functional>
+#include"D3D12FilterGraphRunner.h"
 
 class Dx12Wrapper
 {
@@ -79,10 +80,13 @@ class Dx12Wrapper
 
 
 	//共通
+	bool hdr_ = false;//オフスクリーンをR16G16B16A16_FLOATにして、ポストエフェクトの自動露出とトーンマップで8bitにする
+	bool sepia_ = false;//既定のポストエフェクトのモノクロ化をセピア(灰色化→ガンマ→色味。LUTに焼いてColorLutCSで引く)にする
 	ID3D12Resource* offscreenRTBuffer_ = nullptr;
-	ID3D12DescriptorHeap* rtvHeapOffscreen_ = nullptr;
+	ID3D12Resource* geometryRTBuffer_ = nullptr;//輪郭線用のジオメトリ画像(モデルを描くときの2枚目のレンダーターゲット)
+	ID3D12DescriptorHeap* rtvHeapOffscreen_ = nullptr;//[0]オフスクリーン [1]ジオメトリ画像
 	//スワップチェーンでないレンダーターゲット用
-	//オフスクリーンバッファを作成
+	//オフスクリーンバッファとジオメトリ画像を作成
 	HRESULT CreateOffscreenRTBuffer();
 
 	
@@ -91,23 +95,20 @@ class Dx12Wrapper
 	ID3D12CommandQueue* computeCmdQue_=nullptr;
 	ID3D12CommandAllocator* computeCmdAlloc_ = nullptr;
 	ID3D12GraphicsCommandList* computeCmdList_ = nullptr;
-	ID3D12DescriptorHeap* uavDescriptorHeap_ = nullptr;
-	ID3D12RootSignature* rootSignatureCS_ = nullptr;
-	ID3D12PipelineState* pipelineCS_ = nullptr;
 	ID3D12Resource* uavResource_ = nullptr;
+	//オフスクリーン→uavResource_のポストエフェクト(フィルタグラフ)
+	std::unique_ptr<D3D12FilterGraphRunner> postEffects_;
 	HRESULT CreateUAVBuffer(ID3D12Device* dev, ID3D12Resource*& res, const D3D12_RESOURCE_DESC& desc);
-	ID3D12RootSignature* CreateRootSignatureForComputeShader();
-	ID3DBlob* LoadComputeShader();
-	ID3D12PipelineState* CreateComputePipeline(ID3D12RootSignature* rootSignatureCS);
-	ID3D12DescriptorHeap* CreateUAVDescriptorHeap();
 	bool CreateComputeCommand(ID3D12CommandQueue*& cmdQue, ID3D12CommandAllocator*& cmdAlloc, ID3D12GraphicsCommandList*& cmdList, ID3D12PipelineState* pipeline);
-	void CreateComputeViews(ID3D12Resource* srcRes, ID3D12Resource* destRes, ID3D12DescriptorHeap* uavHeap);
 	void ExecuteAndWait(ID3D12CommandQueue* cmdQue, ID3D12CommandList* cmdList, ID3D12Fence* fence, UINT64& fenceValue);
 
 	HRESULT CopyRenderTarget(ID3D12Resource* srcRes, ID3D12Resource* dstRes);
 
 public:
-	Dx12Wrapper(HWND hwnd);
+	///@param hdr trueならオフスクリーンをR16G16B16A16_FLOATにして(明るいところが1で切れない)、
+	///既定のポストエフェクトを自動露出とトーンマップにする
+	///@param sepia trueなら既定のポストエフェクトのモノクロ化をセピアにする(hdrがfalseのときだけ)
+	Dx12Wrapper(HWND hwnd, bool hdr = false, bool sepia = false);
 	~Dx12Wrapper();
 
 	void Update();
@@ -123,5 +124,22 @@ public:
 
 	void SetScene();
 
+	///オフスクリーン(モデルを描くレンダーターゲット)のフォーマット
+	DXGI_FORMAT OffscreenFormat()const;
+	///輪郭線用のジオメトリ画像(ビュー空間の法線xy・深度・edgeFlg)のフォーマット
+	DXGI_FORMAT GeometryFormat()const;
+
+	///ポストエフェクトを差し替える(既定は輪郭線とモノクロ化。HDRなら輪郭線と自動露出とトーンマップ)
+	///@param graph 入力の大きさがウィンドウと同じで、出力も同じ大きさのグラフ(HDRならToneMapで終えること)。
+	///OutlineとJointUpsample(深度を使うとき)のノードはモデルを描いたときのジオメトリ画像を読む
+	///@return 準備に失敗したらそのHRESULT(そのときは前のポストエフェクトは使えない)
+	HRESULT SetPostEffects(const FilterGraph& graph);
+	///ポストエフェクトで処理し直したタイルの統計(変わったタイルだけを処理し直せるグラフのときだけ数える)
+	const IncrementalFilterStats& PostEffectStats()const;
+	///ポストエフェクトの色の変換をLUTに焼いたパス(ColorLutCS)を、作った画像で1回実行して
+	///CPU版(CpuCompute/ColorLut.hのApplyColorLut)と比べる(最初のフレームより前に呼ぶ)
+	///@return 成分ごとの差がColorLut.hの上限(ColorLutErrorBound8)以内ならtrue
+	bool CheckColorLut();
+
 };
 
@@ -2,17 +2,21 @@
 Texture2D<float4> srcImg : register(t0);
 RWTexture2D<float4> dstImg : register(u0);
 
-[numthreads(1,1,1)]
+//摜TCY([g萔CPUn)
+cbuffer ImageInfo : register(b0)
+{
+    uint2 imageSize;
+};
+
+//1f̌vZCPUłƋL
+#include"../CpuCompute/MonoPixel.hlsli"
+
+[numthreads(8,8,1)]
 void MonoCS( uint3 dtid : SV_DispatchThreadID)
 {
-    //\ȂʃTCYߑł
-    //ۂ̎gpConstantBufferȂȂȂŃTCYw肵Ă
-    //AGetDimensionsg񂩂ȁcH
-    if (dtid.x < 1280 && dtid.y < 720)
+    //O[v͐؂グĂ̂ŁA͂ݏoXbh͉Ȃ
+    if (all(dtid.xy < imageSize))
     {
-        //https://ja.wikipedia.org/wiki/YUV 
-        float b = dot(srcImg[dtid.xy].rgb, float3(0.299,0.587,0.114));
-        b=pow(saturate(b),1.0/2.2);
-        dstImg[dtid.xy] = float4(b,b,b, 1);
+        dstImg[dtid.xy] = MonoPixel(srcImg[dtid.xy]);
     }
 }
@@ -0,0 +1,82 @@
+//ς^C(D3D12FilterGraphRunner::SetIncrementalBCPUłCpuCompute/IncrementalFilter.h)߂̃Rs[gVF[_
+//  TileHashCS : 1O[v1^C󂯎AsrcImg(hasGeometryȂgeometryImg)̉f̃rbg̃nbV
+//               tileHashes[^C̔ԍ*2+0,1]ɏBXbh̓^C̉fєтɎ󂯎AŌɔԍɏ
+//               (ǂ̏ݕ1̈ႢŕKlςBCPUǂݖ߂đÕt[̃nbVƔׂ)
+//  CopyRectCS : srcImgsrcOffsetcopySize̋`AdstImgdstOffsetɂ̂܂܎ʂ(؂oƁA`̏߂)
+//nbVCPUłHashImageTileƂ͕ʂ̒l(ׂ̂͂̃VF[_ŎÕt[Ƃ)
+//R8G8B8A8łfloat̃^[QbgłTexture2D<float4>œǂނ̂œVF[_ł悢
+Texture2D<float4> srcImg : register(t0);
+Texture2D<float4> geometryImg : register(t1);
+RWTexture2D<float4> dstImg : register(u0);
+RWStructuredBuffer<uint> tileHashes : register(u1);//^CƂ2
+
+//[g萔CPUn
+cbuffer IncrementalInfo : register(b0)
+{
+    uint2 imageSize;//TileHashCŜ
+    uint tileSize;//TileHashCŜ݁B^C̈(f)
+    uint hasGeometry;//TileHashCŜ݁B0łȂgeometryImgnbVɍ
+    uint2 srcOffset;//CopyRectCŜ
+    uint2 dstOffset;//CopyRectCŜ
+    uint2 copySize;//CopyRectCŜ
+};
+
+#define GROUP_SIZE 64
+#define FNV_PRIME 16777619u
+
+groupshared uint2 sharedHashes[GROUP_SIZE];
+
+//FNV-1a4oCgAf̑O(RG)ƌ㔼(BA)2{ɕĉ
+uint2 HashPixel(uint2 lanes, float4 value)
+{
+    uint4 words = asuint(value);
+    lanes.x = (lanes.x ^ words.x) * FNV_PRIME;
+    lanes.x = (lanes.x ^ words.y) * FNV_PRIME;
+    lanes.y = (lanes.y ^ words.z) * FNV_PRIME;
+    lanes.y = (lanes.y ^ words.w) * FNV_PRIME;
+    return lanes;
+}
+
+//O[v(̃^C̐, s̃^C̐)
+[numthreads(GROUP_SIZE, 1, 1)]
+void TileHashCS(uint3 gid : SV_GroupID, uint gi : SV_GroupIndex)
+{
+    uint2 origin = gid.xy * tileSize;
+    uint2 size = min(origin + tileSize, imageSize) - origin;
+    uint2 lanes = uint2(2166136261u, 0x9e3779b9u);
+    for (uint i = gi; i < size.x * size.y; i += GROUP_SIZE)
+    {
+        uint2 p = origin + uint2(i % size.x, i / size.x);
+        lanes = HashPixel(lanes, srcImg[p]);
+        if (hasGeometry != 0)
+        {
+            lanes = HashPixel(lanes, geometryImg[p]);
+        }
+    }
+    sharedHashes[gi] = lanes;
+    GroupMemoryBarrierWithGroupSync();
+    if (gi != 0)
+    {
+        return;
+    }
+    uint2 hash = uint2(2166136261u, 0x9e3779b9u);
+    for (uint j = 0; j < GROUP_SIZE; ++j)
+    {
+        hash = (hash ^ sharedHashes[j]) * FNV_PRIME;
+    }
+    uint columns = (imageSize.x + tileSize - 1) / tileSize;
+    uint tile = gid.y * columns + gid.x;
+    tileHashes[tile * 2] = hash.x;
+    tileHashes[tile * 2 + 1] = hash.y;
+}
+
+//O[v(copySize8ŊĐ؂グ)
+[numthreads(8, 8, 1)]
+void CopyRectCS(uint3 dtid : SV_DispatchThreadID)
+{
+    if (any(dtid.xy >= copySize))
+    {
+        return;
+    }
+    dstImg[dstOffset + dtid.xy] = srcImg[srcOffset + dtid.xy];
+}
@@ -0,0 +1,63 @@
+//kď摜̃WCgoCeg(CpuCompute/JointUpsample.h)̃Rs[gVF[_
+//  JointUpsampleCS : dstImg = lowImg(kď摜)AguideImg(kỎ摜)̑傫Ɋg債
+//                    ߖT̏d݂AlowGuideImg(k肪)guideImg̋Px̍ƁAgeometryImg̐[x̍ŉ
+//1Xbh1f󂯎AߖT(2*radius)lBO[v(imageSize8ŊĐ؂グ)B摜̊O͒[̉fJԂ
+//1^bv̌vZJointUpsample.hlsliCPU(CpuCompute/JointUpsample.cpp)ƋLĂ
+Texture2D<float4> lowImg : register(t0);
+Texture2D<float4> lowGuideImg : register(t1);
+Texture2D<float4> guideImg : register(t2);
+Texture2D<float4> geometryImg : register(t3);//depthSigma0Ȃǂ܂Ȃ
+RWTexture2D<float4> dstImg : register(u0);
+
+//[g萔CPUn
+cbuffer JointUpsampleInfo : register(b0)
+{
+    uint2 imageSize;
+    uint2 lowSize;
+    float lumaSigma;
+    float depthSigma;//0Ȃ[xgȂ
+    uint radius;//1`JOINT_UPSAMPLE_MAX_RADIUS
+};
+
+#include"../CpuCompute/JointUpsample.hlsli"
+
+[numthreads(8, 8, 1)]
+void JointUpsampleCS(uint3 dtid : SV_DispatchThreadID)
+{
+    uint2 pos = dtid.xy;
+    if (any(pos >= imageSize))
+    {
+        return;
+    }
+    bool useDepth = depthSigma > 0.0f;
+    float2 uv = float2(JointUpsamplePosition(pos.x, imageSize.x, lowSize.x), JointUpsamplePosition(pos.y, imageSize.y, lowSize.y));
+    int2 first = int2(floor(uv)) - (int)radius + 1;
+    float luma = GuideLuma(guideImg[pos]);
+    float depth = useDepth ? geometryImg[pos].z : 0.0f;
+    float depthScale = useDepth ? JointUpsampleDepthScale(depth, depthSigma) : 0.0f;
+    float invLumaSigma = 1.0f / lumaSigma;
+    JointUpsampleAccumulator acc;
+    acc.sum = 0.0f;
+    acc.weight = 0.0f;
+    for (uint j = 0; j < radius * 2; ++j)
+    {
+        int qy = first.y + (int)j;
+        uint ly = (uint)clamp(qy, 0, (int)lowSize.y - 1);
+        float wy = JointUpsampleTent((float)qy - uv.y, (float)radius);
+        for (uint i = 0; i < radius * 2; ++i)
+        {
+            int qx = first.x + (int)i;
+            uint lx = (uint)clamp(qx, 0, (int)lowSize.x - 1);
+            float wx = JointUpsampleTent((float)qx - uv.x, (float)radius);
+            float depthT = 0.0f;
+            if (useDepth)
+            {
+                uint2 source = uint2(JointUpsampleSourcePixel(lx, lowSize.x, imageSize.x), JointUpsampleSourcePixel(ly, lowSize.y, imageSize.y));
+                depthT = (geometryImg[source].z - depth) * depthScale;
+            }
+            float range = JointUpsampleRange((GuideLuma(lowGuideImg[uint2(lx, ly)]) - luma) * invLumaSigma, depthT);
+            acc = AccumulateJointUpsample(acc, lowImg[uint2(lx, ly)], wy * wx * range);
+        }
+    }
+    dstImg[pos] = ResolveJointUpsample(acc);
+}
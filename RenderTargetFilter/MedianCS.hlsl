@@ -0,0 +1,214 @@
+//lEʃtB^̃Rs[gVF[_(FilterCS.hlslƓsrcImgdstImg)
+//  Median3x3CS / Median5x5CS : 1O[vTILE_W~TILE_Hf󂯎B
+//      ǂޗ(^CƍEradius)Ƃɏc2r+1fɕׂgroupsharedɒuAɗׂ荇Ŏg܂킷B
+//      ̂ƕׂ񂩂min/max̃lbg[NŒlI(lbg[NMedianNetwork.hlsliCPUłƋL)
+//      O[v[numthreads]ŊĐ؂グ(PlanDispatch)
+//  RankHistogramCS : Cӂ̔a(`MAX_RADIUS)EʁB1O[v1sSEGMENTf珇ɏB
+//      256Xbhꂼ1K(RGBA4)󂯎̃qXgOAE1fiނƂ
+//      ̗ĉE̗𑫂čXVAK̗ݐ(XL)珇ʂ̓KTB
+//      l8bitɊۂ߂Đ(R8G8B8A8̓͂ȂCPUłƓ)BDispatch(ceil(/SEGMENT), , 1)
+//摜̊O͒[̉fJԂBCPUłCpuCompute/MedianFilter.cpp
+Texture2D<float4> srcImg : register(t0);
+RWTexture2D<float4> dstImg : register(u0);
+
+//[g萔CPUn
+cbuffer MedianInfo : register(b0)
+{
+    uint2 imageSize;
+    uint radius;//RankHistogramCŜ(1`MAX_RADIUS)
+    uint rank;//RankHistogramCŜ(0`(2*radius+1)^2-1Bl(2*radius+1)^2/2)
+};
+
+#include"../CpuCompute/MedianNetwork.hlsli"
+
+#define MEDIAN_SORT2(a, b) { float4 t_ = min(a, b); b = max(a, b); a = t_; }
+#define MEDIAN_MIN(a, b) { a = min(a, b); }
+#define MEDIAN_MAX(a, b) { b = max(a, b); }
+
+#define TILE_W 16
+#define TILE_H 8
+#define MAX_RADIUS 127
+#define SEGMENT 64
+#define BINS 256
+
+//ׂ(, ^C̍s, )B̓^C̍[radiusO0Ƃ
+groupshared float4 sortedColumns[5 * TILE_H * (TILE_W + 4)];
+#define SORTED_INDEX(k, row, col, K) (((k) * TILE_H + (row)) * (TILE_W + (K) - 1) + (col))
+
+float4 LoadClamped(int2 pos)
+{
+    return srcImg[clamp(pos, int2(0, 0), (int2)imageSize - 1)];
+}
+
+[numthreads(TILE_W, TILE_H, 1)]
+void Median3x3CS(uint3 gid : SV_GroupID, uint3 gtid : SV_GroupThreadID)
+{
+    int2 origin = int2(gid.xy * uint2(TILE_W, TILE_H));
+    //^C̗ƍE1񂸂ׂ(̃Xbh葽2ڂ)
+    for (uint col = gtid.x; col < TILE_W + 2; col += TILE_W)
+    {
+        float4 c[3];
+        [unroll]
+        for (int k = 0; k < 3; ++k)
+        {
+            c[k] = LoadClamped(origin + int2((int)col - 1, (int)gtid.y + k - 1));
+        }
+        MEDIAN_SORT_COLUMN3(c)
+        [unroll]
+        for (uint rk = 0; rk < 3; ++rk)
+        {
+            sortedColumns[SORTED_INDEX(rk, gtid.y, col, 3)] = c[rk];
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 pos = uint2(origin) + gtid.xy;
+    //O[v͐؂グĂ̂ŁA͂ݏoXbh͉Ȃ
+    if (all(pos < imageSize))
+    {
+        float4 s[9];
+        [unroll]
+        for (uint i = 0; i < 9; ++i)
+        {
+            s[i] = sortedColumns[SORTED_INDEX(i % 3, gtid.y, gtid.x + i / 3, 3)];
+        }
+        MEDIAN_SELECT9(s)
+        dstImg[pos] = s[MEDIAN9_RESULT];
+    }
+}
+
+[numthreads(TILE_W, TILE_H, 1)]
+void Median5x5CS(uint3 gid : SV_GroupID, uint3 gtid : SV_GroupThreadID)
+{
+    int2 origin = int2(gid.xy * uint2(TILE_W, TILE_H));
+    for (uint col = gtid.x; col < TILE_W + 4; col += TILE_W)
+    {
+        float4 c[5];
+        [unroll]
+        for (int k = 0; k < 5; ++k)
+        {
+            c[k] = LoadClamped(origin + int2((int)col - 2, (int)gtid.y + k - 2));
+        }
+        MEDIAN_SORT_COLUMN5(c)
+        [unroll]
+        for (uint rk = 0; rk < 5; ++rk)
+        {
+            sortedColumns[SORTED_INDEX(rk, gtid.y, col, 5)] = c[rk];
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 pos = uint2(origin) + gtid.xy;
+    if (all(pos < imageSize))
+    {
+        float4 s[25];
+        [unroll]
+        for (uint i = 0; i < 25; ++i)
+        {
+            s[i] = sortedColumns[SORTED_INDEX(i % 5, gtid.y, gtid.x + i / 5, 5)];
+        }
+        MEDIAN_SELECT25(s)
+        dstImg[pos] = s[MEDIAN25_RESULT];
+    }
+}
+
+//̃qXgO(~K)
+groupshared uint sharedHistogram[4 * BINS];
+//K̗ݐ(Hillis-Steele̓ǂݏւ2)
+groupshared uint4 sharedScan[2][BINS];
+//Ƃ̏ʂ̓K
+groupshared uint sharedResult[4];
+
+//Texture2D<float4>̒lR8G8B8A8_UNORMƓ8bitɊۂ߂(CpuCompute/Image.hPackUnorm4x8)
+uint4 QuantizeUnorm8(float4 c)
+{
+    return (uint4)(saturate(c) * 255.0f + 0.5f);
+}
+
+//f4𑋂̃qXgOɑ(delta0xffffffffȂ)
+void CountPixel(int2 pos, uint delta)
+{
+    uint4 v = QuantizeUnorm8(LoadClamped(pos));
+    InterlockedAdd(sharedHistogram[v.r], delta);
+    InterlockedAdd(sharedHistogram[BINS + v.g], delta);
+    InterlockedAdd(sharedHistogram[2 * BINS + v.b], delta);
+    InterlockedAdd(sharedHistogram[3 * BINS + v.a], delta);
+}
+
+[numthreads(BINS, 1, 1)]
+void RankHistogramCS(uint3 gid : SV_GroupID, uint gi : SV_GroupIndex)
+{
+    if (gid.y >= imageSize.y)
+    {
+        return;
+    }
+    int r = (int)radius;
+    uint size = 2 * radius + 1;
+    int y = (int)gid.y;
+    int x0 = (int)(gid.x * SEGMENT);
+
+    //ŏ̉f̑𐔂
+    for (uint i = gi; i < 4 * BINS; i += BINS)
+    {
+        sharedHistogram[i] = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+    for (uint j = gi; j < size * size; j += BINS)
+    {
+        CountPixel(int2(x0 - r + (int)(j % size), y - r + (int)(j / size)), 1);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    //x̓O[vœȂ̂ŁAbreakĂoA͑SXbhő
+    for (uint n = 0; n < SEGMENT; ++n)
+    {
+        int x = x0 + (int)n;
+        if (x >= (int)imageSize.x)
+        {
+            break;
+        }
+        if (n > 0)
+        {
+            //̗ĉE̗𑫂
+            for (uint dy = gi; dy < size; dy += BINS)
+            {
+                CountPixel(int2(x - r - 1, y - r + (int)dy), 0xffffffff);
+                CountPixel(int2(x + r, y - r + (int)dy), 1);
+            }
+            GroupMemoryBarrierWithGroupSync();
+        }
+
+        //Kgi(4)܂ł̗ݐ
+        uint4 count = uint4(sharedHistogram[gi], sharedHistogram[BINS + gi], sharedHistogram[2 * BINS + gi], sharedHistogram[3 * BINS + gi]);
+        uint src = 0;
+        sharedScan[0][gi] = count;
+        GroupMemoryBarrierWithGroupSync();
+        for (uint offset = 1; offset < BINS; offset <<= 1)
+        {
+            uint4 v = sharedScan[src][gi];
+            if (gi >= offset)
+            {
+                v += sharedScan[src][gi - offset];
+            }
+            sharedScan[1 - src][gi] = v;
+            src = 1 - src;
+            GroupMemoryBarrierWithGroupSync();
+        }
+        uint4 inclusive = sharedScan[src][gi];
+        uint4 exclusive = inclusive - count;
+        //ʂ̓K͐Ƃ1
+        [unroll]
+        for (uint c = 0; c < 4; ++c)
+        {
+            if (exclusive[c] <= rank && rank < inclusive[c])
+            {
+                sharedResult[c] = gi;
+            }
+        }
+        GroupMemoryBarrierWithGroupSync();
+        if (gi == 0)
+        {
+            dstImg[uint2(x, y)] = float4(sharedResult[0], sharedResult[1], sharedResult[2], sharedResult[3]) / 255.0f;
+        }
+    }
+}
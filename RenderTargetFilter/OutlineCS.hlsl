@@ -0,0 +1,51 @@
+//XN[Xy[X̗֊s(CpuCompute/Outline.h)̃Rs[gVF[_
+//  OutlineCS : dstImg = srcImgɁAgeometryImg(f`Ƃ2ڂ̃_[^[Qbg)
+//              @E[xƐF̋Px̕sA狁߂֊sd˂(edgeFlg̃}eA̋ߖT)
+//              1O[vTILE~TILEf󂯎AߖT܂(TILE+2)l̒l(OutlineSample)groupshared1񂾂߂
+//Ԃ͉fŌ܂Af̃|SɂȂBO[v(imageSize8ŊĐ؂グ)B摜̊O͒[̉fJԂ
+//1f̌vZOutline.hlsliCPU(CpuCompute/Outline.cpp)ƋLĂ
+Texture2D<float4> srcImg : register(t0);
+Texture2D<float4> geometryImg : register(t1);
+RWTexture2D<float4> dstImg : register(u0);
+
+//[g萔CPUn(OutlineSettingsƓl)
+cbuffer OutlineInfo : register(b0)
+{
+    float4 outlineColor;//a͕sx
+    uint2 imageSize;
+    float colorThreshold;
+    float depthThreshold;
+    float normalThreshold;
+};
+
+#include"../CpuCompute/Outline.hlsli"
+
+#define TILE 8
+#define HALO_TILE (TILE + 2)
+
+groupshared OutlineSample sharedSamples[HALO_TILE * HALO_TILE];
+
+[numthreads(TILE, TILE, 1)]
+void OutlineCS(uint3 gid : SV_GroupID, uint3 gtid : SV_GroupThreadID, uint gi : SV_GroupIndex)
+{
+    int2 origin = int2(gid.xy * TILE) - 1;
+    for (uint i = gi; i < HALO_TILE * HALO_TILE; i += TILE * TILE)
+    {
+        int2 p = clamp(origin + int2(i % HALO_TILE, i / HALO_TILE), 0, (int2)imageSize - 1);
+        sharedSamples[i] = MakeOutlineSample(srcImg[p], geometryImg[p]);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 pos = gid.xy * TILE + gtid.xy;
+    if (any(pos >= imageSize))
+    {
+        return;
+    }
+    OutlineSample taps[9];
+    for (uint j = 0; j < 9; ++j)
+    {
+        taps[j] = sharedSamples[(gtid.y + j / 3) * HALO_TILE + gtid.x + j % 3];
+    }
+    float strength = OutlineStrength(taps, colorThreshold, depthThreshold, normalThreshold);
+    dstImg[pos] = ApplyOutline(srcImg[pos], strength, outlineColor);
+}
@@ -184,7 +184,9 @@ PMDActor::LoadPMDFile(const char* path) {
 		_materials[i].material.specular = pmdMaterials[i].specular;
 		_materials[i].material.specularity = pmdMaterials[i].specularity;
 		_materials[i].material.ambient = pmdMaterials[i].ambient;
+		_materials[i].material.edge = pmdMaterials[i].edgeFlg ? 1.0f : 0.0f;
 		_materials[i].additional.toonIdx = pmdMaterials[i].toonIdx;
+		_materials[i].additional.edgeFlg = pmdMaterials[i].edgeFlg != 0;
 	}
 
 	for (int i = 0; i < pmdMaterials.size(); ++i) {
@@ -33,6 +33,7 @@ private:
 		DirectX::XMFLOAT3 specular; //XyLF
 		float specularity;//XyL̋(Zl)
 		DirectX::XMFLOAT3 ambient; //ArGgF
+		float edge;//֊s`(edgeFlg10ŁBWIg摜wɏ)
 	};
 	//ȊÕ}eAf[^
 	struct AdditionalMaterial {
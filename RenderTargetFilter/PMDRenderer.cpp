@@ -180,8 +180,9 @@ PMDRenderer::CreateGraphicsPipelineForPMD() {
 	gpipeline.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;//XgbṽJbgȂ
 	gpipeline.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;//Op`ō\
 
-	gpipeline.NumRenderTargets = 1;//͂P̂
-	gpipeline.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;//0`1ɐKꂽRGBA
+	gpipeline.NumRenderTargets = 2;//FƁA֊sp̃WIg摜
+	gpipeline.RTVFormats[0] = _dx12.OffscreenFormat();//ItXN[Ɠ(HDRȂR16G16B16A16_FLOAT)
+	gpipeline.RTVFormats[1] = _dx12.GeometryFormat();
 
 	gpipeline.SampleDesc.Count = 1;//TvO1sNZɂP
 	gpipeline.SampleDesc.Quality = 0;//NIeB͍Œ
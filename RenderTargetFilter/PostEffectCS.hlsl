@@ -0,0 +1,42 @@
+//tB^Ot(CpuCompute/FilterGraph.h)̓_Ƃ̃pX̃Rs[gVF[_
+//  PointwiseCS : srcImgdstImgB܂Ƃ߂_Ƃ̏(opCount)fƂɏɂB
+//                POSTFX_ADDextraImg0/1(extraIndexőI)̓ʒủf𑫂B(imageSize8ŊĐ؂グ)̃O[vDispatch
+//1pXœǂݏ͓̂͂ƒǉ̓͂1񂸂Ao͂1񂾂(܂Ƃ߂ȂΏƂɒԂ̃eNX`)
+//̒gPostEffect.hlsliCPU(CpuCompute/FilterGraphRunner.cpp)ƋLĂ
+Texture2D<float4> srcImg : register(t0);
+Texture2D<float4> extraImg0 : register(t1);
+Texture2D<float4> extraImg1 : register(t2);
+RWTexture2D<float4> dstImg : register(u0);
+
+//[g萔CPUn(52BRenderTargetFilter/D3D12FilterGraphRunner.cppPointwiseConstantsƓ)
+cbuffer PostEffectInfo : register(b0)
+{
+    uint2 imageSize;
+    uint opCount;//0`POSTFX_MAX_OPS(0ȂRs[)
+    uint extraCount;//ǉ̓͂̐
+    uint4 opCodes[2];//POSTFX_`(4l߂)
+    uint4 extraIndex[2];//POSTFX_ADDǂޒǉ̓
+    float4 params[8];
+};
+
+#include"../CpuCompute/MonoPixel.hlsli"
+#include"../CpuCompute/ColorOps.hlsli"
+#include"../CpuCompute/PostEffect.hlsli"
+
+[numthreads(8, 8, 1)]
+void PointwiseCS(uint3 dtid : SV_DispatchThreadID)
+{
+    if (any(dtid.xy >= imageSize))
+    {
+        return;
+    }
+    float4 c = srcImg[dtid.xy];
+    float4 extras[POSTFX_MAX_EXTRA_INPUTS];
+    extras[0] = extraCount > 0 ? extraImg0[dtid.xy] : 0.0f;
+    extras[1] = extraCount > 1 ? extraImg1[dtid.xy] : 0.0f;
+    for (uint k = 0; k < opCount; ++k)
+    {
+        c = PointwiseOp(opCodes[k >> 2][k & 3], params[k], c, extras[extraIndex[k >> 2][k & 3]]);
+    }
+    dstImg[dtid.xy] = c;
+}
@@ -0,0 +1,123 @@
+//ItXN[̉ʂ̋PxWv(vEŏEőE256K̃qXgO)Rs[gVF[_
+//  LumaReduceCS      : O[v؍\ŏ݁AO[vƂ̕ʂpartialsɏ
+//  LumaReduceFinalCS : ʂ256ށBpartialCount1ɂȂ܂srcPartials/partialsւČJԂ
+//  LumaHistogramCS   : O[vƂgroupshared̃qXgOŐĂAŜ̃qXgOɑ
+//                      (logScaleȂlog2(Px)̊KBToneMapCS.hlsl̎IoD3D12FilterGraphRunnerg)
+//R8G8B8A8łfloat̃^[QbgłTexture2D<float4>œǂނ̂œVF[_ł悢
+//CPUłCpuCompute/Reduction.cpp
+Texture2D<float4> srcImg : register(t0);
+
+struct LumaPartial
+{
+    float sum;
+    float minimum;
+    float maximum;
+    uint count;
+};
+StructuredBuffer<LumaPartial> srcPartials : register(t1);//LumaReduceFinalCS̓
+RWStructuredBuffer<LumaPartial> partials : register(u0);
+RWStructuredBuffer<uint> histogram : register(u1);//256(Dispatch̑O0ɂĂ)
+
+//[g萔CPUn
+cbuffer ReductionInfo : register(b0)
+{
+    uint2 imageSize;
+    float histogramOffset;//K = (Px - histogramOffset) * histogramScale
+    float histogramScale;//R8G8B8A8Ȃ(-0.5/255, 255)8bitɊۂ߂Px̂܂܊KɂȂ
+    uint partialCount;//LumaReduceFinalCSŏޕʂ̐
+    uint logScale;//LumaHistogramCŜ݁B0łȂ΋Px̂ApproxLog2(Px)ŊK߂
+};
+
+#include"../CpuCompute/LumaReduction.hlsli"
+
+#define GROUP_SIZE 256
+
+groupshared LumaPartial sharedPartials[GROUP_SIZE];
+groupshared uint sharedHistogram[256];
+
+LumaPartial EmptyPartial()
+{
+    LumaPartial p;
+    p.sum = 0;
+    p.minimum = 3.402823466e+38;
+    p.maximum = -3.402823466e+38;
+    p.count = 0;
+    return p;
+}
+
+LumaPartial MergePartial(LumaPartial a, LumaPartial b)
+{
+    LumaPartial p;
+    p.sum = a.sum + b.sum;
+    p.minimum = min(a.minimum, b.minimum);
+    p.maximum = max(a.maximum, b.maximum);
+    p.count = a.count + b.count;
+    return p;
+}
+
+//O[v̖؍\̏ݍ(ʂsharedPartials[0])
+void ReduceGroup(uint gi, LumaPartial p)
+{
+    sharedPartials[gi] = p;
+    GroupMemoryBarrierWithGroupSync();
+    [unroll]
+    for (uint stride = GROUP_SIZE / 2; stride > 0; stride >>= 1)
+    {
+        if (gi < stride)
+        {
+            sharedPartials[gi] = MergePartial(sharedPartials[gi], sharedPartials[gi + stride]);
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+[numthreads(16,16,1)]
+void LumaReduceCS(uint3 dtid : SV_DispatchThreadID, uint3 gid : SV_GroupID, uint gi : SV_GroupIndex)
+{
+    LumaPartial p = EmptyPartial();
+    //O[v͐؂グĂ̂ŁA͂ݏoXbh͋̌ʂo
+    if (all(dtid.xy < imageSize))
+    {
+        float luma = Luminance(srcImg[dtid.xy].rgb);
+        p.sum = luma;
+        p.minimum = luma;
+        p.maximum = luma;
+        p.count = 1;
+    }
+    ReduceGroup(gi, p);
+    if (gi == 0)
+    {
+        uint groupsX = (imageSize.x + 15) / 16;
+        partials[gid.y * groupsX + gid.x] = sharedPartials[0];
+    }
+}
+
+[numthreads(GROUP_SIZE,1,1)]
+void LumaReduceFinalCS(uint3 dtid : SV_DispatchThreadID, uint3 gid : SV_GroupID, uint gi : SV_GroupIndex)
+{
+    LumaPartial p = dtid.x < partialCount ? srcPartials[dtid.x] : EmptyPartial();
+    ReduceGroup(gi, p);
+    if (gi == 0)
+    {
+        partials[gid.x] = sharedPartials[0];
+    }
+}
+
+//16x16XbhȂ̂ŁAO[v1Xbh1K󂯎
+[numthreads(16,16,1)]
+void LumaHistogramCS(uint3 dtid : SV_DispatchThreadID, uint gi : SV_GroupIndex)
+{
+    sharedHistogram[gi] = 0;
+    GroupMemoryBarrierWithGroupSync();
+    if (all(dtid.xy < imageSize))
+    {
+        uint bin = LumaBin(LumaHistogramValue(Luminance(srcImg[dtid.xy].rgb), logScale), histogramOffset, histogramScale);
+        InterlockedAdd(sharedHistogram[bin], 1);
+    }
+    GroupMemoryBarrierWithGroupSync();
+    //Ŝ̃Ag~bN̓O[v(gꂽK̐)񂾂
+    if (sharedHistogram[gi] != 0)
+    {
+        InterlockedAdd(histogram[gi], sharedHistogram[gi]);
+    }
+}
@@ -0,0 +1,97 @@
+//gk(TvOBCӂ̔{AcʁX)̃Rs[gVF[_
+//  ResampleHCS : BsrcImg(srcSize)midImg(dstSize.x x srcSize.y)
+//  ResampleVCS : cBmidImgdstImg(dstSize)
+//ResampleHCS(O[v (dstSize.x/64؂グ) x srcSize.y)ResampleVCS(dstSize8ŊĐ؂グ)̏Dispatch
+//ԂmidImgfloatɂĂƃpX̊ԂŊۂ߂ɍςށB摜̊O͒[̉fJԂ
+//At@ĂȂ摜́AǂނƂɐFɃAt@|AƂɊ߂(ȉf̐Fɂ܂Ȃ)
+//tB^̏d݂Resample.hlsliCPU(CpuCompute/Resample.cpp)ƋLĂ
+//(CPUł͏o͂̉fƂ̏d݂Oċ߂ĂAVF[_̓XbhƂɂ̏ŋ߂)
+Texture2D<float4> srcImg : register(t0);
+RWTexture2D<float4> dstImg : register(u0);
+RWTexture2D<float4> midImg : register(u1);
+
+//[g萔CPUn
+cbuffer ResampleInfo : register(b0)
+{
+    uint2 srcSize;
+    uint2 dstSize;
+    uint filter;//RESAMPLE_`
+    uint straightAlpha;//1ȂAt@ĂȂ
+};
+
+#include"../CpuCompute/Resample.hlsli"
+
+//o͂iԖڂ̉f̑(͂̉fP)
+struct TapWindow
+{
+    float center;
+    float stretch;//kƂ̓tB^kL
+    int start;//S}a̍ŏ̉f
+    int end;//Ō̉f+1
+};
+
+TapWindow MakeWindow(uint i, uint srcCount, uint dstCount)
+{
+    TapWindow window;
+    float scale = (float)srcCount / (float)dstCount;
+    window.stretch = max(scale, 1.0f);
+    float support = ResampleSupport(filter) * window.stretch;
+    window.center = (i + 0.5f) * scale - 0.5f;
+    window.start = (int)floor(window.center - support) + 1;
+    window.end = (int)ceil(window.center + support);
+    return window;
+}
+
+float4 LoadPremultiplied(int2 pos)
+{
+    float4 c = srcImg[pos];
+    if (straightAlpha)
+    {
+        c.rgb *= c.a;
+    }
+    return c;
+}
+
+[numthreads(64, 1, 1)]
+void ResampleHCS(uint3 dtid : SV_DispatchThreadID)
+{
+    //O[v͐؂グĂ̂ŁA͂ݏoXbh͉Ȃ
+    if (dtid.x >= dstSize.x || dtid.y >= srcSize.y)
+    {
+        return;
+    }
+    TapWindow window = MakeWindow(dtid.x, srcSize.x, dstSize.x);
+    float4 sum = 0.0f;
+    float total = 0.0f;
+    for (int j = window.start; j < window.end; ++j)
+    {
+        float w = ResampleWeight(filter, (j - window.center) / window.stretch);
+        sum += w * LoadPremultiplied(int2(clamp(j, 0, (int)srcSize.x - 1), dtid.y));
+        total += w;
+    }
+    midImg[dtid.xy] = sum / total;
+}
+
+[numthreads(8, 8, 1)]
+void ResampleVCS(uint3 dtid : SV_DispatchThreadID)
+{
+    if (any(dtid.xy >= dstSize))
+    {
+        return;
+    }
+    TapWindow window = MakeWindow(dtid.y, srcSize.y, dstSize.y);
+    float4 sum = 0.0f;
+    float total = 0.0f;
+    for (int j = window.start; j < window.end; ++j)
+    {
+        float w = ResampleWeight(filter, (j - window.center) / window.stretch);
+        sum += w * midImg[int2(dtid.x, clamp(j, 0, (int)srcSize.y - 1))];
+        total += w;
+    }
+    float4 c = sum / total;
+    if (straightAlpha)
+    {
+        c.rgb = c.a > 0.0f ? c.rgb / c.a : 0.0f;
+    }
+    dstImg[dtid.xy] = c;
+}
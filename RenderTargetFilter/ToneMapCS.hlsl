@@ -0,0 +1,73 @@
+//Ioƃg[}bv(CpuCompute/ToneMap.h)̃Rs[gVF[_
+//  (ReductionCS.hlslLumaHistogramCSlogScaleŌĂсAlog2(Px)̃qXgOhistogramɐĂ)
+//  ExposureCS : qXgOڕW̖邳߁AexposureStateɎcÕt[̒l1t[߂ÂĘIoB
+//               ǂ񂾃qXgO0ɖ߂Ă(̃t[LumaHistogramCŜ)BDispatch(1,1,1)
+//  ToneMapCS  : dstImg = srcImgɘIo|ăg[J[uʂAsRGBɂ
+//IoGPŨobt@̒Ŏ̃pXƎ̃t[ɓn̂ŁACPUւ̓ǂݖ߂ő҂Ƃ͂Ȃ
+//1KE1f̌vZToneMap.hlsliCPU(CpuCompute/ToneMap.cpp)ƋLĂ
+Texture2D<float4> srcImg : register(t0);
+RWTexture2D<float4> dstImg : register(u0);
+RWStructuredBuffer<uint> histogram : register(u1);//256(ReductionCS.hlslƓ)
+RWStructuredBuffer<float> exposureState : register(u2);//[0]Ȃ܂邳(log2) [1]Io [2]0Ȃ[0]܂Ȃ(Ƃ0)
+
+//[g萔CPUn(ToneMapSettingsƓ)
+cbuffer ToneMapInfo : register(b0)
+{
+    uint2 imageSize;
+    float minLog2;//qXgO͈̔(log2(Px))
+    float maxLog2;
+    float lowPercent;//Â琔Ă̊highPercent܂ł̉f𕽋ς
+    float highPercent;
+    float exposureBias;
+    float adaptUp;
+    float adaptDown;
+    float whitePoint;
+};
+
+#include"../CpuCompute/ToneMap.hlsli"
+
+groupshared uint sharedBins[256];
+
+[numthreads(256, 1, 1)]
+void ExposureCS(uint gi : SV_GroupIndex)
+{
+    sharedBins[gi] = histogram[gi];
+    histogram[gi] = 0;
+    GroupMemoryBarrierWithGroupSync();
+    if (gi != 0)
+    {
+        return;
+    }
+    //256KɌ邾Ȃ̂1Xbhő
+    uint total = 0;
+    for (uint i = 0; i < 256; ++i)
+    {
+        total += sharedBins[i];
+    }
+    float lo = (float)total * lowPercent;
+    float hi = (float)total * highPercent;
+    float binWidth = (maxLog2 - minLog2) / 256.0;
+    ExposureAccumulator acc;
+    acc.below = 0;
+    acc.weight = 0;
+    acc.weightedLog2 = 0;
+    for (uint bin = 0; bin < 256; ++bin)
+    {
+        acc = AccumulateExposureBin(acc, (float)sharedBins[bin], minLog2 + (bin + 0.5) * binWidth, lo, hi);
+    }
+    float target = acc.weight > 0 ? acc.weightedLog2 / acc.weight : (minLog2 + maxLog2) * 0.5;
+    float adapted = exposureState[2] != 0 ? AdaptExposureLog2(exposureState[0], target, adaptUp, adaptDown) : target;
+    exposureState[0] = adapted;
+    exposureState[1] = ExposureFromLog2(adapted, exposureBias);
+    exposureState[2] = 1;
+}
+
+[numthreads(8, 8, 1)]
+void ToneMapCS(uint3 dtid : SV_DispatchThreadID)
+{
+    if (any(dtid.xy >= imageSize))
+    {
+        return;
+    }
+    dstImg[dtid.xy] = ToneMapPixel(srcImg[dtid.xy], exposureState[1], whitePoint);
+}
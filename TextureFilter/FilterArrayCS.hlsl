@@ -0,0 +1,21 @@
+//̏摜܂Ƃ߂ămNHRs[gVF[_(MonoBatch.hg)
+//摜1̃eNX`(AgX)ɋl߂ĒuA摜Ƃ̈ʒuƑ傫\œn
+Texture2D<float4> srcAtlas : register(t0);
+StructuredBuffer<uint4> imageRects : register(t1);//(x,y,,)
+RWTexture2D<float4> dstAtlas : register(u0);
+
+//1f̌vZCPUłƋL
+#include"../CpuCompute/MonoPixel.hlsli"
+
+//1DispatchőS̉摜(z摜)
+[numthreads(8,8,1)]
+void MonoArrayCS( uint3 dtid : SV_DispatchThreadID)
+{
+    //O[v͂΂傫摜ɍ킹Ă̂ŁẢ摜̊ÕXbh͉Ȃ
+    uint4 rect = imageRects[dtid.z];
+    if (all(dtid.xy < rect.zw))
+    {
+        uint2 pos = rect.xy + dtid.xy;
+        dstAtlas[pos] = MonoPixel(srcAtlas[pos]);
+    }
+}
@@ -0,0 +1,380 @@
+﻿#include "MonoBatch.h"
+#include<cassert>
+#include<cstring>
+#include<algorithm>
+#include<numeric>
+#include<d3dcompiler.h>
+#include<d3d12shader.h>
+
+using namespace std;
+
+namespace {
+	constexpr DXGI_FORMAT imageFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+	void OutputFromErrorBlob(ID3DBlob* errBlob) {
+		if (errBlob != nullptr) {
+			OutputDebugStringA(static_cast<const char*>(errBlob->GetBufferPointer()));
+			errBlob->Release();
+		}
+	}
+
+	D3D12_RESOURCE_DESC AtlasDesc(UINT width, UINT height, D3D12_RESOURCE_FLAGS flags) {
+		D3D12_RESOURCE_DESC desc = {};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		desc.Width = width;
+		desc.Height = height;
+		desc.DepthOrArraySize = 1;
+		desc.MipLevels = 1;
+		desc.Format = imageFormat;
+		desc.SampleDesc.Count = 1;
+		desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+		desc.Flags = flags;
+		return desc;
+	}
+
+	D3D12_RESOURCE_DESC BufferDesc(UINT64 size) {
+		D3D12_RESOURCE_DESC desc = {};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		desc.Width = size;
+		desc.Height = 1;
+		desc.DepthOrArraySize = 1;
+		desc.MipLevels = 1;
+		desc.Format = DXGI_FORMAT_UNKNOWN;
+		desc.SampleDesc.Count = 1;
+		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		return desc;
+	}
+
+	D3D12_RESOURCE_BARRIER Transition(ID3D12Resource* res, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Transition.pResource = res;
+		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+		barrier.Transition.StateBefore = before;
+		barrier.Transition.StateAfter = after;
+		return barrier;
+	}
+}
+
+D3D12MonoBatch::D3D12MonoBatch(ID3D12Device* dev, ID3D12CommandQueue* cmdQue) :dev_(dev), cmdQue_(cmdQue) {
+	auto result = CreateRootSignature();
+	assert(SUCCEEDED(result));
+	result = CreatePipeline();
+	assert(SUCCEEDED(result));
+	result = dev_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&cmdAlloc_));
+	assert(SUCCEEDED(result));
+	result = dev_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, cmdAlloc_.Get(), pipeline_.Get(), IID_PPV_ARGS(&cmdList_));
+	assert(SUCCEEDED(result));
+	cmdList_->Close();
+	result = dev_->CreateFence(fenceValue_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+	assert(SUCCEEDED(result));
+	fenceEvent_ = CreateEvent(nullptr, false, false, nullptr);
+
+	D3D12_DESCRIPTOR_HEAP_DESC descHeapDesc = {};
+	descHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	descHeapDesc.NumDescriptors = 3;//UAV,SRV(アトラス),SRV(位置と大きさの表)
+	descHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	result = dev_->CreateDescriptorHeap(&descHeapDesc, IID_PPV_ARGS(&descriptorHeap_));
+	assert(SUCCEEDED(result));
+}
+
+D3D12MonoBatch::~D3D12MonoBatch() {
+	CloseHandle(fenceEvent_);
+}
+
+HRESULT
+D3D12MonoBatch::CreateRootSignature() {
+	D3D12_DESCRIPTOR_RANGE range[2] = {};
+	range[0].NumDescriptors = 1;
+	range[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;//u0
+	range[0].BaseShaderRegister = 0;
+	range[0].OffsetInDescriptorsFromTableStart = 0;
+	range[1].NumDescriptors = 2;
+	range[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;//t0,t1
+	range[1].BaseShaderRegister = 0;
+	range[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+	D3D12_ROOT_PARAMETER rp = {};
+	rp.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	rp.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	rp.DescriptorTable.NumDescriptorRanges = 2;
+	rp.DescriptorTable.pDescriptorRanges = range;
+
+	D3D12_ROOT_SIGNATURE_DESC rootSigDesc = {};
+	rootSigDesc.NumParameters = 1;
+	rootSigDesc.pParameters = &rp;
+	rootSigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+
+	ID3DBlob* rootSigBlob = nullptr;
+	ID3DBlob* errBlob = nullptr;
+	auto result = D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1_0, &rootSigBlob, &errBlob);
+	OutputFromErrorBlob(errBlob);
+	if (FAILED(result)) {
+		return result;
+	}
+	result = dev_->CreateRootSignature(0, rootSigBlob->GetBufferPointer(), rootSigBlob->GetBufferSize(), IID_PPV_ARGS(rootSignature_.ReleaseAndGetAddressOf()));
+	rootSigBlob->Release();
+	return result;
+}
+
+HRESULT
+D3D12MonoBatch::CreatePipeline() {
+	ID3DBlob* csBlob = nullptr;
+	ID3DBlob* errBlob = nullptr;
+	auto result = D3DCompileFromFile(L"FilterArrayCS.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "MonoArrayCS", "cs_5_1", 0, 0, &csBlob, &errBlob);
+	OutputFromErrorBlob(errBlob);
+	if (FAILED(result)) {
+		return result;
+	}
+	D3D12_COMPUTE_PIPELINE_STATE_DESC pldesc = {};
+	pldesc.CS.pShaderBytecode = csBlob->GetBufferPointer();
+	pldesc.CS.BytecodeLength = csBlob->GetBufferSize();
+	pldesc.pRootSignature = rootSignature_.Get();
+	result = dev_->CreateComputePipelineState(&pldesc, IID_PPV_ARGS(pipeline_.ReleaseAndGetAddressOf()));
+	//Dispatchのグループ数を決めるため[numthreads]を調べておく
+	ID3D12ShaderReflection* reflection = nullptr;
+	if (SUCCEEDED(D3DReflect(csBlob->GetBufferPointer(), csBlob->GetBufferSize(), IID_PPV_ARGS(&reflection)))) {
+		reflection->GetThreadGroupSize(&numThreads_.x, &numThreads_.y, &numThreads_.z);
+		reflection->Release();
+	}
+	csBlob->Release();
+	return result;
+}
+
+HRESULT
+D3D12MonoBatch::Reserve(UINT width, UINT height, UINT rects) {
+	if (srcAtlas_ != nullptr && width <= width_ && height <= height_ && rects <= rectCapacity_) {
+		return S_OK;
+	}
+	//足りない方向だけ広げる(大きさのちがう呼び出しが交互に来ても作り直し続けないように)
+	//途中で失敗したら次の呼び出しでまた作り直すように、大きさは全部作れてから覚える
+	width = max<UINT>(width, width_);
+	height = max<UINT>(height, height_);
+	rects = max<UINT>(rects, rectCapacity_);
+
+	D3D12_HEAP_PROPERTIES defaultHeap = {};
+	defaultHeap.Type = D3D12_HEAP_TYPE_DEFAULT;
+	auto desc = AtlasDesc(width, height, D3D12_RESOURCE_FLAG_NONE);
+	auto result = dev_->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(srcAtlas_.ReleaseAndGetAddressOf()));
+	if (FAILED(result)) {
+		return result;
+	}
+	auto uavDesc = AtlasDesc(width, height, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	result = dev_->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &uavDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(dstAtlas_.ReleaseAndGetAddressOf()));
+	if (FAILED(result)) {
+		return result;
+	}
+
+	//アップロードとリードバックはアトラスのフットプリントのバッファ
+	UINT64 totalBytes = 0;
+	dev_->GetCopyableFootprints(&desc, 0, 1, 0, &footprint_, nullptr, nullptr, &totalBytes);
+	D3D12_HEAP_PROPERTIES uploadHeap = {};
+	uploadHeap.Type = D3D12_HEAP_TYPE_UPLOAD;
+	D3D12_HEAP_PROPERTIES readbackHeap = {};
+	readbackHeap.Type = D3D12_HEAP_TYPE_READBACK;
+	auto bufferDesc = BufferDesc(totalBytes);
+	result = dev_->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(uploadBuffer_.ReleaseAndGetAddressOf()));
+	if (FAILED(result)) {
+		return result;
+	}
+	result = dev_->CreateCommittedResource(&readbackHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(readbackBuffer_.ReleaseAndGetAddressOf()));
+	if (FAILED(result)) {
+		return result;
+	}
+	auto rectDesc = BufferDesc(static_cast<UINT64>(rects) * sizeof(hlsl::uint4));
+	result = dev_->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &rectDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(rectTable_.ReleaseAndGetAddressOf()));
+	if (FAILED(result)) {
+		return result;
+	}
+	//Runは完了を待ってから読み書きするので、Mapしたままにしておく
+	D3D12_RANGE noRead = { 0,0 };//CPUからは読まない
+	result = uploadBuffer_->Map(0, &noRead, reinterpret_cast<void**>(&mappedUpload_));
+	if (FAILED(result)) {
+		return result;
+	}
+	result = rectTable_->Map(0, &noRead, reinterpret_cast<void**>(&mappedRects_));
+	if (FAILED(result)) {
+		return result;
+	}
+	D3D12_RANGE readRange = { 0,static_cast<SIZE_T>(totalBytes) };
+	void* mappedReadback = nullptr;
+	result = readbackBuffer_->Map(0, &readRange, &mappedReadback);
+	if (FAILED(result)) {
+		return result;
+	}
+	mappedReadback_ = static_cast<const uint8_t*>(mappedReadback);
+
+	D3D12_UNORDERED_ACCESS_VIEW_DESC uavViewDesc = {};
+	uavViewDesc.Format = imageFormat;
+	uavViewDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	auto handle = descriptorHeap_->GetCPUDescriptorHandleForHeapStart();
+	const auto increment = dev_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	dev_->CreateUnorderedAccessView(dstAtlas_.Get(), nullptr, &uavViewDesc, handle);
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = imageFormat;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Texture2D.MipLevels = 1;
+	handle.ptr += increment;
+	dev_->CreateShaderResourceView(srcAtlas_.Get(), &srvDesc, handle);
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC rectViewDesc = {};
+	rectViewDesc.Format = DXGI_FORMAT_UNKNOWN;
+	rectViewDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+	rectViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	rectViewDesc.Buffer.NumElements = rects;
+	rectViewDesc.Buffer.StructureByteStride = sizeof(hlsl::uint4);
+	handle.ptr += increment;
+	dev_->CreateShaderResourceView(rectTable_.Get(), &rectViewDesc, handle);
+	width_ = width;
+	height_ = height;
+	rectCapacity_ = rects;
+	return S_OK;
+}
+
+HRESULT
+D3D12MonoBatch::RunChunk(const vector<const ImageRGBA8*>& images, const vector<size_t>& indices, const vector<hlsl::uint4>& rects, vector<ImageRGBA8>& results) {
+	//アトラスの使う範囲と、いちばん大きい画像の大きさ(Dispatchのグループ数)
+	UINT usedWidth = 1;
+	UINT usedHeight = 1;
+	UINT width = 1;
+	UINT height = 1;
+	for (const auto& rect : rects) {
+		usedWidth = max<UINT>(usedWidth, rect.x + rect.z);
+		usedHeight = max<UINT>(usedHeight, rect.y + rect.w);
+		width = max<UINT>(width, rect.z);
+		height = max<UINT>(height, rect.w);
+	}
+	const auto count = static_cast<UINT>(rects.size());
+	auto result = Reserve(usedWidth, usedHeight, count);
+	if (FAILED(result)) {
+		return result;
+	}
+
+	//画像をアトラスのフットプリントの位置に書き、位置と大きさを表に書く
+	auto pixelOffset = [&](const hlsl::uint4& rect, UINT y) {
+		return footprint_.Offset + static_cast<size_t>(rect.y + y) * footprint_.Footprint.RowPitch + static_cast<size_t>(rect.x) * sizeof(uint32_t);
+	};
+	for (UINT i = 0; i < count; ++i) {
+		const auto& image = *images[indices[i]];
+		for (UINT y = 0; y < image.height; ++y) {
+			memcpy(mappedUpload_ + pixelOffset(rects[i], y), image.Row(y), image.width * sizeof(uint32_t));
+		}
+		mappedRects_[i] = rects[i];
+	}
+
+	cmdAlloc_->Reset();
+	cmdList_->Reset(cmdAlloc_.Get(), pipeline_.Get());
+	//コピーはアトラスの使う範囲をまとめて1回(画像の間のすき間はシェーダが読まない)
+	auto copyLocations = [&](D3D12_TEXTURE_COPY_LOCATION& buffer, D3D12_TEXTURE_COPY_LOCATION& texture, ID3D12Resource* bufferRes, ID3D12Resource* textureRes) {
+		buffer.pResource = bufferRes;
+		buffer.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		buffer.PlacedFootprint = footprint_;
+		buffer.PlacedFootprint.Footprint.Width = usedWidth;
+		buffer.PlacedFootprint.Footprint.Height = usedHeight;
+		texture.pResource = textureRes;
+		texture.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		texture.SubresourceIndex = 0;
+	};
+	D3D12_TEXTURE_COPY_LOCATION src = {}, dst = {};
+	copyLocations(src, dst, uploadBuffer_.Get(), srcAtlas_.Get());
+	cmdList_->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	auto barrier = Transition(srcAtlas_.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	cmdList_->ResourceBarrier(1, &barrier);
+
+	//全部の画像を1回のDispatchで(zが画像)
+	cmdList_->SetComputeRootSignature(rootSignature_.Get());
+	ID3D12DescriptorHeap* descHeaps[] = { descriptorHeap_.Get() };
+	cmdList_->SetDescriptorHeaps(1, descHeaps);
+	cmdList_->SetComputeRootDescriptorTable(0, descriptorHeap_->GetGPUDescriptorHandleForHeapStart());
+	auto plan = PlanDispatch(numThreads_, width, height, count);
+	cmdList_->Dispatch(plan.groups.x, plan.groups.y, plan.groups.z);
+
+	D3D12_RESOURCE_BARRIER barriers[] = {
+		Transition(dstAtlas_.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+		Transition(srcAtlas_.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+	};
+	cmdList_->ResourceBarrier(2, barriers);
+	D3D12_TEXTURE_COPY_LOCATION readback = {}, atlas = {};
+	copyLocations(readback, atlas, readbackBuffer_.Get(), dstAtlas_.Get());
+	D3D12_BOX box = { 0,0,0,usedWidth,usedHeight,1 };
+	cmdList_->CopyTextureRegion(&readback, 0, 0, 0, &atlas, &box);
+	//次のRunのためにUAVに戻す
+	barrier = Transition(dstAtlas_.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	cmdList_->ResourceBarrier(1, &barrier);
+	cmdList_->Close();
+
+	//待つのはまとめた分で1回だけ
+	ID3D12CommandList* cmdLists[] = { cmdList_.Get() };
+	cmdQue_->ExecuteCommandLists(1, cmdLists);
+	cmdQue_->Signal(fence_.Get(), ++fenceValue_);
+	if (fence_->GetCompletedValue() < fenceValue_) {
+		fence_->SetEventOnCompletion(fenceValue_, fenceEvent_);
+		WaitForSingleObject(fenceEvent_, INFINITE);
+	}
+
+	for (UINT i = 0; i < count; ++i) {
+		const auto& image = *images[indices[i]];
+		auto& out = results[indices[i]];
+		if (out.width != image.width || out.height != image.height) {
+			out = ImageRGBA8(image.width, image.height);
+		}
+		for (UINT y = 0; y < image.height; ++y) {
+			memcpy(out.Row(y), mappedReadback_ + pixelOffset(rects[i], y), image.width * sizeof(uint32_t));
+		}
+	}
+	return S_OK;
+}
+
+HRESULT
+D3D12MonoBatch::Run(const vector<const ImageRGBA8*>& images, vector<ImageRGBA8>& results) {
+	results.resize(images.size());
+	//アトラスより大きい画像があれば、アトラスをその大きさにする
+	UINT atlasWidth = atlasSize;
+	UINT atlasHeight = atlasSize;
+	for (auto image : images) {
+		atlasWidth = max<UINT>(atlasWidth, image->width);
+		atlasHeight = max<UINT>(atlasHeight, image->height);
+	}
+	//高い順に並べて左から置き、幅があふれたら下の段へ、高さがあふれたらそこまでを流す(棚詰め)
+	vector<size_t> order(images.size());
+	iota(order.begin(), order.end(), size_t(0));
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return images[a]->height > images[b]->height; });
+	vector<size_t> indices;
+	vector<hlsl::uint4> rects;
+	UINT x = 0;
+	UINT y = 0;
+	UINT rowHeight = 0;
+	for (auto index : order) {
+		const auto& image = *images[index];
+		if (image.width == 0 || image.height == 0) {
+			results[index] = ImageRGBA8(image.width, image.height);
+			continue;
+		}
+		if (x + image.width > atlasWidth) {
+			y += rowHeight;
+			x = 0;
+			rowHeight = 0;
+		}
+		if (y + image.height > atlasHeight || indices.size() == maxImages) {
+			auto result = RunChunk(images, indices, rects, results);
+			if (FAILED(result)) {
+				return result;
+			}
+			indices.clear();
+			rects.clear();
+			x = 0;
+			y = 0;
+			rowHeight = 0;
+		}
+		indices.push_back(index);
+		rects.push_back(hlsl::uint4(x, y, image.width, image.height));
+		x += image.width;
+		rowHeight = max<UINT>(rowHeight, image.height);
+	}
+	if (indices.empty()) {
+		return S_OK;
+	}
+	return RunChunk(images, indices, rects, results);
+}
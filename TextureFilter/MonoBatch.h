@@ -0,0 +1,69 @@
+﻿#pragma once
+#include<d3d12.h>
+#include<wrl.h>
+#include<vector>
+#include"../CpuCompute/Image.h"
+#include"../CpuCompute/DispatchPlan.h"
+
+///たくさんの小さい画像をまとめてモノクロ加工する(FilterArrayCS.hlslのMonoArrayCS。CPU版はCpuCompute/MonoFilter.hのImageArrayRGBA8の版)
+///画像を1枚のテクスチャ(アトラス、R8G8B8A8_UNORM)に高さの順に棚詰めし、画像ごとの位置と大きさを表で渡して、
+///アップロード→1回のDispatch→リードバックを1つのコマンドリストに積み、1回だけ完了を待つ。
+///1枚ずつ処理するときのディスクリプタヒープ・コマンドリストの作成とフェンスの待ちが、まとめた分で1回になる
+///@remarks アトラスは幅・高さともatlasSize(それより大きい画像があればその大きさ)までで、あふれたら分けて流す。
+///アトラスなどは大きさが足りなくなったときだけ作り直すので、GPU・アップロード・リードバックを合わせて
+///atlasSize×atlasSize×4バイトの4つ分(64MiB)くらいで止まる
+class D3D12MonoBatch
+{
+	template<typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	ComPtr<ID3D12Device> dev_;
+	ComPtr<ID3D12CommandQueue> cmdQue_;
+	ComPtr<ID3D12RootSignature> rootSignature_;
+	ComPtr<ID3D12PipelineState> pipeline_;
+	hlsl::uint3 numThreads_ = { 1,1,1 };
+	ComPtr<ID3D12CommandAllocator> cmdAlloc_;
+	ComPtr<ID3D12GraphicsCommandList> cmdList_;
+	ComPtr<ID3D12Fence> fence_;
+	UINT64 fenceValue_ = 0;
+	HANDLE fenceEvent_ = nullptr;
+	ComPtr<ID3D12DescriptorHeap> descriptorHeap_;//u0,t0,t1
+
+	ComPtr<ID3D12Resource> srcAtlas_;//DEFAULT(COPY_DEST)
+	ComPtr<ID3D12Resource> dstAtlas_;//DEFAULT(UNORDERED_ACCESS)
+	ComPtr<ID3D12Resource> uploadBuffer_;//UPLOAD(アトラスのフットプリント)
+	ComPtr<ID3D12Resource> readbackBuffer_;//READBACK(uploadBuffer_と同じ並び)
+	ComPtr<ID3D12Resource> rectTable_;//UPLOAD(StructuredBuffer<uint4>。画像ごとの(x,y,幅,高さ))
+	uint8_t* mappedUpload_ = nullptr;
+	const uint8_t* mappedReadback_ = nullptr;
+	hlsl::uint4* mappedRects_ = nullptr;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint_ = {};
+	UINT width_ = 0;//アトラスの大きさ
+	UINT height_ = 0;
+	UINT rectCapacity_ = 0;//表の要素数
+
+	HRESULT CreateRootSignature();
+	HRESULT CreatePipeline();
+	HRESULT Reserve(UINT width, UINT height, UINT rects);
+	//indices[i]番の画像をアトラスのrects[i]に置いて1回のDispatchで処理する
+	HRESULT RunChunk(const std::vector<const ImageRGBA8*>& images, const std::vector<size_t>& indices, const std::vector<hlsl::uint4>& rects, std::vector<ImageRGBA8>& results);
+
+	D3D12MonoBatch(const D3D12MonoBatch&) = delete;
+	void operator=(const D3D12MonoBatch&) = delete;
+public:
+	///アトラスの幅・高さ(これより大きい画像はその大きさのアトラスにする)
+	static constexpr UINT atlasSize = 2048;
+	///1回のDispatchでまとめる枚数の上限(zが画像なのでDispatchのグループ数の上限)
+	static constexpr UINT maxImages = D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION;
+
+	///@param dev デバイス
+	///@param cmdQue 実行するキュー(D3D12_COMMAND_LIST_TYPE_COMPUTE)
+	D3D12MonoBatch(ID3D12Device* dev, ID3D12CommandQueue* cmdQue);
+	~D3D12MonoBatch();
+
+	///画像をまとめてモノクロ加工する(アトラス1枚分ごとに1回のDispatchと1回の待ち)
+	///@param images 入力(大きさはばらばらでよい。0x0の画像はそのまま返す)
+	///@param results 出力(imagesと同じ枚数・大きさにされる)
+	///@return リソースの作成に失敗したらそのHRESULT
+	HRESULT Run(const std::vector<const ImageRGBA8*>& images, std::vector<ImageRGBA8>& results);
+};
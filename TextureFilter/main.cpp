@@ -7,7 +7,13 @@
 #include<vector>
 #include<string>
 #include<d3dcompiler.h>
+#include<d3d12shader.h>
 #include<DirectXTex.h>
+#include"../CpuCompute/DispatchPlan.h"
+#include"MonoBatch.h"
+#include<chrono>
+#include<cstdio>
+#include<cstdarg>
 
 #ifdef _DEBUG
 #include<iostream>
@@ -17,6 +23,7 @@
 #pragma comment(lib,"d3d12.lib")
 #pragma comment(lib,"dxgi.lib")
 #pragma comment(lib,"d3dcompiler.lib")
+#pragma comment(lib,"dxguid.lib")
 
 using namespace DirectX;
 
@@ -29,11 +36,25 @@ void DebugOutputFormatString(const char* format, ...) {
 #ifdef _DEBUG
 	va_list valist;
 	va_start(valist, format);
-	printf(format, valist);
+	vprintf(format, valist);
 	va_end(valist);
 #endif
 }
 
+///@brief vʂȂǂtH[}bgtŏo͂
+///@param format tH[}bg(%dƂ%fƂ)
+///@param ϒ
+///@remarks [Xł܂BR\[΂ɁAfobK΂̏o͂ɂo܂
+void ReportFormatString(const char* format, ...) {
+	char buffer[512];
+	va_list valist;
+	va_start(valist, format);
+	vsnprintf(buffer, sizeof(buffer), format, valist);
+	va_end(valist);
+	OutputDebugStringA(buffer);
+	fputs(buffer, stdout);
+}
+
 /// <summary>
 /// VF[_G[NƂErrorBlobo͂
 /// </summary>
@@ -132,15 +153,22 @@ ID3D12RootSignature* CreateRootSignatureForComputeShader()
 	range[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
 	range[1].RegisterSpace = 0;
 
-	D3D12_ROOT_PARAMETER rp[1] = {};
+	D3D12_ROOT_PARAMETER rp[2] = {};
 	rp[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 	rp[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 	rp[0].DescriptorTable.NumDescriptorRanges = 2;
 	rp[0].DescriptorTable.pDescriptorRanges = range;
 
+	//摜TCY(uint2)[g萔œn
+	rp[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	rp[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	rp[1].Constants.ShaderRegister = 0;//b0
+	rp[1].Constants.RegisterSpace = 0;
+	rp[1].Constants.Num32BitValues = 2;
+
 	D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 	D3D12_ROOT_SIGNATURE_DESC rootSigDesc = {};
-	rootSigDesc.NumParameters = 1;
+	rootSigDesc.NumParameters = 2;
 	rootSigDesc.pParameters = rp;
 	rootSigDesc.NumStaticSamplers = 0;
 	rootSigDesc.pStaticSamplers = nullptr;
@@ -164,7 +192,7 @@ ID3DBlob* LoadComputeShader()
 {
 	ID3DBlob* csBlob = nullptr;
 	ID3DBlob* errBlob = nullptr;
-	auto result = D3DCompileFromFile(L"FilterCS.hlsl", nullptr, nullptr, "MonoCS", "cs_5_1", 0, 0, &csBlob, &errBlob);
+	auto result = D3DCompileFromFile(L"FilterCS.hlsl", nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "MonoCS", "cs_5_1", 0, 0, &csBlob, &errBlob);
 	if (errBlob != nullptr) {
 		OutputFromErrorBlob(errBlob);
 	}
@@ -172,7 +200,9 @@ ID3DBlob* LoadComputeShader()
 	return csBlob;
 }
 
-ID3D12PipelineState* CreateComputePipeline(ID3D12RootSignature* rootSignatureCS)
+///@param rootSignatureCS [gVOl`
+///@param numThreads VF[_[numthreads](Ԃlp)
+ID3D12PipelineState* CreateComputePipeline(ID3D12RootSignature* rootSignatureCS, hlsl::uint3& numThreads)
 {
 	ID3D12PipelineState* ret = nullptr;
 	ID3DBlob* csBlob = LoadComputeShader();
@@ -182,6 +212,13 @@ ID3D12PipelineState* CreateComputePipeline(ID3D12RootSignature* rootSignatureCS)
 	pldesc.NodeMask = 0;
 	pldesc.pRootSignature = rootSignatureCS;
 	auto result = dev_->CreateComputePipelineState(&pldesc, IID_PPV_ARGS(&ret));
+	//Dispatch̃O[v߂邽[numthreads]𒲂ׂĂ
+	numThreads = { 1,1,1 };
+	ID3D12ShaderReflection* reflection = nullptr;
+	if (SUCCEEDED(D3DReflect(csBlob->GetBufferPointer(), csBlob->GetBufferSize(), IID_PPV_ARGS(&reflection)))) {
+		reflection->GetThreadGroupSize(&numThreads.x, &numThreads.y, &numThreads.z);
+		reflection->Release();
+	}
 	csBlob->Release();
 	assert(SUCCEEDED(result));
 	return ret;
@@ -260,6 +297,187 @@ void ExecuteAndWait(ID3D12CommandQueue* cmdQue,ID3D12CommandList* cmdList, ID3D1
 	}
 }
 
+///1MonoCSŃmNH(main̉摜ƓA1ƂɃeNX`EfBXNv^q[vER}hXgAsđ҂)
+///@param fence ҂ɎgtFX
+///@param fenceValue tFX̒l(ŝтɑ)
+///@return \[X̍쐬Ɏs炻HRESULT
+HRESULT MonoPerImage(ID3D12CommandQueue* cmdQue, ID3D12RootSignature* rootSignatureCS, ID3D12PipelineState* pipelineCS, const hlsl::uint3& numThreads,
+	ID3D12Fence* fence, UINT64& fenceValue, const ImageRGBA8& image, ImageRGBA8& out) {
+	D3D12_HEAP_PROPERTIES texHeapProp = {};
+	texHeapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+	D3D12_RESOURCE_DESC texDesc = {};
+	texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	texDesc.Width = image.width;
+	texDesc.Height = image.height;
+	texDesc.DepthOrArraySize = 1;
+	texDesc.MipLevels = 1;
+	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+	UINT64 totalBytes = 0;
+	dev_->GetCopyableFootprints(&texDesc, 0, 1, 0, &footprint, nullptr, nullptr, &totalBytes);
+	D3D12_HEAP_PROPERTIES uploadHeapProp = {};
+	uploadHeapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+	D3D12_HEAP_PROPERTIES readbackHeapProp = {};
+	readbackHeapProp.Type = D3D12_HEAP_TYPE_READBACK;
+	D3D12_RESOURCE_DESC bufferDesc = {};
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	bufferDesc.Width = totalBytes;
+	bufferDesc.Height = 1;
+	bufferDesc.DepthOrArraySize = 1;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	bufferDesc.SampleDesc.Count = 1;
+	bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	ID3D12Resource* texbuff = nullptr;
+	ID3D12Resource* uavResource = nullptr;
+	ID3D12Resource* uploadbuff = nullptr;
+	ID3D12Resource* readbackbuff = nullptr;
+	ID3D12DescriptorHeap* uavDescriptorHeap = nullptr;
+	ID3D12CommandAllocator* cmdAlloc = nullptr;
+	ID3D12GraphicsCommandList* cmdList = nullptr;
+	auto result = dev_->CreateCommittedResource(&texHeapProp, D3D12_HEAP_FLAG_NONE, &texDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&texbuff));
+	if (SUCCEEDED(result)) {
+		result = CreateUAVBuffer(dev_, uavResource, texDesc);
+	}
+	if (SUCCEEDED(result)) {
+		result = dev_->CreateCommittedResource(&uploadHeapProp, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&uploadbuff));
+	}
+	if (SUCCEEDED(result)) {
+		result = dev_->CreateCommittedResource(&readbackHeapProp, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&readbackbuff));
+	}
+	if (SUCCEEDED(result)) {
+		result = dev_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&cmdAlloc));
+	}
+	if (SUCCEEDED(result)) {
+		result = dev_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, cmdAlloc, pipelineCS, IID_PPV_ARGS(&cmdList));
+	}
+	uint8_t* mapforImg = nullptr;
+	if (SUCCEEDED(result)) {
+		result = uploadbuff->Map(0, nullptr, reinterpret_cast<void**>(&mapforImg));
+	}
+	if (SUCCEEDED(result)) {
+		for (UINT y = 0; y < image.height; ++y) {
+			std::copy_n(reinterpret_cast<const uint8_t*>(image.Row(y)), image.width * sizeof(uint32_t), mapforImg + footprint.Offset + static_cast<size_t>(y) * footprint.Footprint.RowPitch);
+		}
+		uploadbuff->Unmap(0, nullptr);
+
+		uavDescriptorHeap = CreateUAVDescriptorHeap();
+		CreateComputeViews(texbuff, uavResource, uavDescriptorHeap);
+
+		D3D12_TEXTURE_COPY_LOCATION bufferLoc = {}, texLoc = {};
+		bufferLoc.pResource = uploadbuff;
+		bufferLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		bufferLoc.PlacedFootprint = footprint;
+		texLoc.pResource = texbuff;
+		texLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		texLoc.SubresourceIndex = 0;
+		cmdList->CopyTextureRegion(&texLoc, 0, 0, 0, &bufferLoc, nullptr);
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Transition.pResource = texbuff;
+		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+		barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+		barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+		cmdList->ResourceBarrier(1, &barrier);
+
+		cmdList->SetComputeRootSignature(rootSignatureCS);
+		ID3D12DescriptorHeap* descHeaps[] = { uavDescriptorHeap };
+		cmdList->SetDescriptorHeaps(1, descHeaps);
+		cmdList->SetComputeRootDescriptorTable(0, uavDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+		auto plan = PlanDispatch(numThreads, image.width, image.height);
+		cmdList->SetComputeRoot32BitConstants(1, 2, &plan.size, 0);//摜TCY(b0)
+		cmdList->Dispatch(plan.groups.x, plan.groups.y, plan.groups.z);
+
+		barrier.Transition.pResource = uavResource;
+		barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+		barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
+		cmdList->ResourceBarrier(1, &barrier);
+		bufferLoc.pResource = readbackbuff;
+		texLoc.pResource = uavResource;
+		cmdList->CopyTextureRegion(&bufferLoc, 0, 0, 0, &texLoc, nullptr);
+		cmdList->Close();
+		ExecuteAndWait(cmdQue, cmdList, fence, fenceValue);
+
+		void* mapped = nullptr;
+		D3D12_RANGE readRange = { 0,static_cast<SIZE_T>(totalBytes) };
+		result = readbackbuff->Map(0, &readRange, &mapped);
+		if (SUCCEEDED(result)) {
+			auto mapforOut = static_cast<const uint8_t*>(mapped);
+			out = ImageRGBA8(image.width, image.height);
+			for (UINT y = 0; y < image.height; ++y) {
+				std::copy_n(mapforOut + footprint.Offset + static_cast<size_t>(y) * footprint.Footprint.RowPitch, image.width * sizeof(uint32_t), reinterpret_cast<uint8_t*>(out.Row(y)));
+			}
+			D3D12_RANGE noWrite = { 0,0 };
+			readbackbuff->Unmap(0, &noWrite);
+		}
+	}
+	for (IUnknown* obj : std::initializer_list<IUnknown*>{ cmdList, cmdAlloc, uavDescriptorHeap, readbackbuff, uploadbuff, uavResource, texbuff }) {
+		if (obj != nullptr) {
+			obj->Release();
+		}
+	}
+	return result;
+}
+
+///摜񃂃mNHƂ1b̖A1(MonoPerImage)Ƃ܂Ƃ߂ꍇ(D3D12MonoBatch)ŕ\
+///@param cmdQue Rs[gL[
+///@param rootSignatureCS MonoCS̃[gVOl`
+///@param pipelineCS MonoCS̃pCvC
+///@param numThreads MonoCS[numthreads]
+///@param img ̉摜(R8G8B8A8_UNORMB64x64E200x200E512x512ɊgkĎg)
+void ReportMonoBatchThroughput(ID3D12CommandQueue* cmdQue, ID3D12RootSignature* rootSignatureCS, ID3D12PipelineState* pipelineCS, const hlsl::uint3& numThreads, const DirectX::Image& img) {
+	if (img.format != DXGI_FORMAT_R8G8B8A8_UNORM) {
+		return;
+	}
+	ID3D12Fence* fence = nullptr;
+	UINT64 fenceValue = 0;
+	if (FAILED(dev_->CreateFence(fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)))) {
+		return;
+	}
+	D3D12MonoBatch batch(dev_, cmdQue);
+	for (UINT size : { 64u, 200u, 512u }) {
+		ScratchImage resized;
+		if (FAILED(Resize(img, size, size, TEX_FILTER_DEFAULT, resized))) {
+			continue;
+		}
+		auto scaled = resized.GetImage(0, 0, 0);
+		ImageRGBA8 image(size, size);
+		for (UINT y = 0; y < size; ++y) {
+			std::copy_n(scaled->pixels + y * scaled->rowPitch, size * sizeof(uint32_t), reinterpret_cast<uint8_t*>(image.Row(y)));
+		}
+		//킹16Mf炢
+		const size_t count = std::max<size_t>(16, 16u * 1024 * 1024 / (static_cast<size_t>(size) * size));
+		std::vector<const ImageRGBA8*> images(count, &image);
+		std::vector<ImageRGBA8> perImage(count), batched;
+		//ǂ1񗬂ăVF[_̃RpCAgX̍쐬vO
+		bool ok = SUCCEEDED(MonoPerImage(cmdQue, rootSignatureCS, pipelineCS, numThreads, fence, fenceValue, image, perImage[0]));
+		ok = ok && SUCCEEDED(batch.Run(images, batched));
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; ok && i < count; ++i) {
+			ok = SUCCEEDED(MonoPerImage(cmdQue, rootSignatureCS, pipelineCS, numThreads, fence, fenceValue, *images[i], perImage[i]));
+		}
+		auto mid = std::chrono::high_resolution_clock::now();
+		ok = ok && SUCCEEDED(batch.Run(images, batched));
+		auto end = std::chrono::high_resolution_clock::now();
+		if (!ok) {
+			ReportFormatString("MonoCS %ux%u x%zu : failed to create resources\n", size, size, count);
+			continue;
+		}
+		bool same = true;
+		for (size_t i = 0; i < count; ++i) {
+			same = same && perImage[i].pixels == batched[i].pixels;
+		}
+		double perImageSec = std::chrono::duration<double>(mid - start).count();
+		double batchSec = std::chrono::duration<double>(end - mid).count();
+		ReportFormatString("MonoCS %ux%u x%zu : per image %.0f/s, batch %.0f/s (x%.1f) %s\n", size, size, count,
+			count / perImageSec, count / batchSec, perImageSec / batchSec, same ? "" : "MISMATCH");
+	}
+	fence->Release();
+}
+
 #ifdef _DEBUG
 int main() {
 #else
@@ -770,7 +988,8 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	//Rs[gVF[_
 	auto uavDescriptorHeap = CreateUAVDescriptorHeap();
 	auto rootSignatureCS = CreateRootSignatureForComputeShader();
-	auto pipelineCS = CreateComputePipeline(rootSignatureCS);
+	hlsl::uint3 numThreadsCS;
+	auto pipelineCS = CreateComputePipeline(rootSignatureCS, numThreadsCS);
 	ID3D12Resource* uavResource = nullptr;
 	auto ret = CreateUAVBuffer(dev_, uavResource, texbuff->GetDesc());
 	assert(SUCCEEDED(ret));
@@ -791,8 +1010,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		uavDescriptorHeap->GetGPUDescriptorHandleForHeapStart()
 	);//[gp[^̃Zbg
 
-	//摜TCY/XbhŃfBXpb`
-	computeCmdList->Dispatch(img->width/4, img->height/4, 1);
+	//摜TCY/Xbh(؂グ)ŃfBXpb`
+	//؂ȂTCYł[̉f𗎂ƂȂ
+	auto plan = PlanDispatch(numThreadsCS, static_cast<UINT>(img->width), static_cast<UINT>(img->height));
+	computeCmdList->SetComputeRoot32BitConstants(1, 2, &plan.size, 0);//摜TCY(b0)
+	computeCmdList->Dispatch(plan.groups.x, plan.groups.y, plan.groups.z);
 	
 	//oAŃXe[gύX
 		//oA
@@ -807,6 +1029,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	computeCmdList->Close();
 	UINT64 fenceValueCS = 0;
 	ExecuteAndWait(computeCmdQue, computeCmdList, fence_, fenceValueCS);
+	ReportMonoBatchThroughput(computeCmdQue, rootSignatureCS, pipelineCS, numThreadsCS, *img);
 
 	//̎_ŉ摜Hς݂̏uavResourceɓĂ͂
 	